@@ -98,10 +98,30 @@ endif
 # 'y' to set the Alignment Check Enable bit in SCTLR/SCTLR_EL1, 'n' to clear it
 CFG_SCTLR_ALIGNMENT_CHECK ?= n
 
+# 'y' to use the AArch64 assembly versions of memcpy(), memmove(), memset()
+# and memcmp() in user mode (TAs and ldelf) instead of the generic C ones.
+# They use unaligned accesses, and DC ZVA to zero large ranges.
+CFG_TA_ARM64_STRING_ASM ?= n
+ifeq ($(CFG_SCTLR_ALIGNMENT_CHECK),y)
+$(call force,CFG_TA_ARM64_STRING_ASM,n,unaligned accesses fault)
+endif
+
 ifeq ($(CFG_CORE_LARGE_PHYS_ADDR),y)
 $(call force,CFG_WITH_LPAE,y)
 endif
 
+# CFG_CORE_MMU_CONTIG_HINT, when enabled, sets the contiguous bit in the
+# user mode translation table entries of each naturally aligned 64 KiB
+# block of physically contiguous memory mapped with identical attributes,
+# reducing the TLB pressure of TAs with large heaps or shared buffers.
+# Requires the LPAE translation table format.
+CFG_CORE_MMU_CONTIG_HINT ?= $(CFG_WITH_LPAE)
+ifeq ($(CFG_CORE_MMU_CONTIG_HINT),y)
+ifneq ($(CFG_WITH_LPAE),y)
+$(error CFG_CORE_MMU_CONTIG_HINT requires CFG_WITH_LPAE)
+endif
+endif
+
 # SPMC configuration "S-EL1 SPMC" where SPM Core is implemented at S-EL1,
 # that is, OP-TEE.
 ifeq ($(CFG_CORE_SEL1_SPMC),y)
@@ -137,6 +157,27 @@ $(error CFG_CORE_FFA depends on CFG_ARM64_core)
 endif
 endif
 
+# CFG_CORE_FFA_SHM_MAP_CACHE_ENTRIES, when non-zero, is the number of FF-A
+# shared memory objects which are kept mapped in the core virtual address
+# space once unused. Calls reusing the same shared memory handle then skip
+# mapping and unmapping it each time. An idle mapping is removed when the
+# memory is reclaimed or relinquished, or when the virtual address space
+# is needed for another object.
+CFG_CORE_FFA_SHM_MAP_CACHE_ENTRIES ?= 0
+
+# CFG_CORE_PERF_STATS, when enabled, counts cycles, instructions, L1 and L2
+# data cache refills and TLB refills with the Performance Monitors in
+# standard SMC calls, TA syscalls, core RNG reads and secure storage hash
+# tree I/O. The counts are reported by the stats PTA. The PMU is shared with
+# the normal world, which should leave it alone while measuring, and EL3
+# must permit counting in the secure state.
+CFG_CORE_PERF_STATS ?= n
+ifeq ($(CFG_CORE_PERF_STATS),y)
+ifneq ($(CFG_ARM64_core),y)
+$(error CFG_CORE_PERF_STATS depends on CFG_ARM64_core)
+endif
+endif
+
 ifeq ($(CFG_CORE_PHYS_RELOCATABLE)-$(CFG_WITH_PAGER),y-y)
 $(error CFG_CORE_PHYS_RELOCATABLE and CFG_WITH_PAGER are not compatible)
 endif
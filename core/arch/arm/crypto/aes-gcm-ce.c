@@ -3,6 +3,7 @@
  * Copyright (c) 2017-2020, Linaro Limited
  */
 
+#include <arm.h>
 #include <assert.h>
 #include <crypto/crypto_accel.h>
 #include <crypto/crypto.h>
@@ -16,6 +17,40 @@
 
 #include "aes_armv8a_ce.h"
 
+/*
+ * With CFG_CRYPTO_AES_GCM_CE_RUNTIME=y @ek->data holds the key schedule of
+ * the software AES implementation used by the generic GCM code and the
+ * AES instructions use a separate copy.
+ */
+static const uint64_t *ce_round_keys(const struct internal_aes_gcm_key *ek)
+{
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	return ek->ce_data;
+#else
+	return ek->data;
+#endif
+}
+
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+void internal_aes_gcm_expand_ce_key(struct internal_aes_gcm_key *ek,
+				    const void *key, size_t key_len)
+{
+	unsigned int rounds = 0;
+
+	ek->use_ce = false;
+
+	if (!feat_pmull_implemented())
+		return;
+
+	if (crypto_accel_aes_expand_keys(key, key_len, ek->ce_data, NULL,
+					 sizeof(ek->ce_data), &rounds))
+		return;
+
+	assert(rounds == ek->rounds);
+	ek->use_ce = true;
+}
+#endif
+
 static void get_be_block(void *dst, const void *src)
 {
 	uint64_t *d = dst;
@@ -49,6 +84,14 @@ void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
 	uint64_t k[2] = { 0 };
 	uint64_t h[2] = { 0 };
 
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	state->ghash_key.use_pmull = enc_key->use_ce;
+	if (!enc_key->use_ce) {
+		internal_aes_gcm_sw_set_key(state, enc_key);
+		return;
+	}
+#endif
+
 	crypto_aes_enc_block(enc_key->data, sizeof(enc_key->data),
 			     enc_key->rounds, state->ctr, k);
 
@@ -69,7 +112,7 @@ static void pmull_ghash_update(int num_blocks, uint64_t dg[2],
 			       const struct internal_ghash_key *ghash_key,
 			       const uint8_t *head)
 {
-#ifdef CFG_HWSUPP_PMULT_64
+#if defined(CFG_HWSUPP_PMULT_64) || defined(CFG_CRYPTO_AES_GCM_CE_RUNTIME)
 	pmull_ghash_update_p64(num_blocks, dg, src, ghash_key, head);
 #else
 	pmull_ghash_update_p8(num_blocks, dg, src, ghash_key, head);
@@ -83,6 +126,14 @@ void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
 	uint32_t vfp_state;
 	uint64_t dg[2];
 
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	if (!state->ghash_key.use_pmull) {
+		internal_aes_gcm_sw_ghash_update(state, head, data,
+						 num_blocks);
+		return;
+	}
+#endif
+
 	get_be_block(dg, state->hash_state);
 
 	vfp_state = thread_kernel_enable_vfp();
@@ -107,8 +158,8 @@ static void encrypt_pl(struct internal_aes_gcm_state *state,
 		memcpy(dst, buf_cryp, TEE_AES_BLOCK_SIZE);
 
 		ce_aes_ecb_encrypt(buf_cryp, (const uint8_t *)state->ctr,
-				   (const uint8_t *)ek->data, ek->rounds,
-				   1, 1);
+				   (const uint8_t *)ce_round_keys(ek),
+				   ek->rounds, 1, 1);
 		internal_aes_gcm_inc_ctr(state);
 
 		src += TEE_AES_BLOCK_SIZE;
@@ -122,7 +173,8 @@ static void decrypt_pl(struct internal_aes_gcm_state *state,
 		       const uint8_t *src, size_t num_blocks, uint8_t *dst)
 {
 	while (num_blocks) {
-		ce_aes_ctr_encrypt(dst, src, (const uint8_t *)ek->data,
+		ce_aes_ctr_encrypt(dst, src,
+				   (const uint8_t *)ce_round_keys(ek),
 				   ek->rounds, 1, (uint8_t *)state->ctr, 1);
 		pmull_ghash_update(1, dg, src, &state->ghash_key, NULL);
 
@@ -154,7 +206,7 @@ static void update_payload_2block(struct internal_aes_gcm_state *state,
 		 */
 		memcpy(ks, state->buf_cryp, sizeof(state->buf_cryp));
 
-		pmull_gcm_load_round_keys(ek->data, ek->rounds);
+		pmull_gcm_load_round_keys(ce_round_keys(ek), ek->rounds);
 		pmull_gcm_encrypt_block(ks + sizeof(state->buf_cryp),
 					(uint8_t *)state->ctr, ek->rounds);
 		internal_aes_gcm_inc_ctr(state);
@@ -164,7 +216,7 @@ static void update_payload_2block(struct internal_aes_gcm_state *state,
 		internal_aes_gcm_dec_ctr(state);
 	} else {
 		pmull_gcm_decrypt(num_blocks, dg, dst, src, &state->ghash_key,
-				  state->ctr, ek->data, ek->rounds);
+				  state->ctr, ce_round_keys(ek), ek->rounds);
 	}
 }
 
@@ -179,6 +231,14 @@ internal_aes_gcm_update_payload_blocks(struct internal_aes_gcm_state *state,
 	uint32_t vfp_state = 0;
 	uint64_t dg[2] = { 0 };
 
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	if (!ek->use_ce) {
+		internal_aes_gcm_sw_update_payload_blocks(state, ek, mode, src,
+							  num_blocks, dst);
+		return;
+	}
+#endif
+
 	get_be_block(dg, state->hash_state);
 	vfp_state = thread_kernel_enable_vfp();
 
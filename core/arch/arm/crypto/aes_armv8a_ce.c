@@ -247,3 +247,100 @@ void crypto_accel_aes_xts_dec(void *out, const void *in, const void *key1,
 			   tweak);
 	thread_kernel_disable_vfp(vfp_state);
 }
+
+#ifdef ARM32
+/* Increments the low 64 bits of the big endian counter in @ctr */
+static void ccm_inc_ctr(uint8_t ctr[TEE_AES_BLOCK_SIZE])
+{
+	int i = 0;
+
+	for (i = TEE_AES_BLOCK_SIZE - 1; i >= TEE_AES_BLOCK_SIZE / 2; i--)
+		if (++ctr[i])
+			break;
+}
+
+/*
+ * There's no dedicated CCM routine for AArch32, the 2-block ECB routine
+ * computes a keystream block and a CBC-MAC block with a single call
+ * instead.
+ */
+static void ccm_enc(uint8_t *out, const uint8_t *in, const void *key,
+		    unsigned int round_count, unsigned int block_count,
+		    uint8_t *ctr, uint8_t *mac)
+{
+	uint8_t buf[2][TEE_AES_BLOCK_SIZE] = { };
+	unsigned int n = 0;
+
+	for (n = 0; n < block_count; n++) {
+		ccm_inc_ctr(ctr);
+		ce_aes_xor_block(buf[0], mac, in);
+		memcpy(buf[1], ctr, TEE_AES_BLOCK_SIZE);
+		ce_aes_ecb_encrypt(buf[0], buf[0], key, round_count, 2, 1);
+		memcpy(mac, buf[0], TEE_AES_BLOCK_SIZE);
+		ce_aes_xor_block(out, in, buf[1]);
+		in += TEE_AES_BLOCK_SIZE;
+		out += TEE_AES_BLOCK_SIZE;
+	}
+}
+
+/* The CBC-MAC of a block is computed with the keystream of the next one */
+static void ccm_dec(uint8_t *out, const uint8_t *in, const void *key,
+		    unsigned int round_count, unsigned int block_count,
+		    uint8_t *ctr, uint8_t *mac)
+{
+	uint8_t buf[2][TEE_AES_BLOCK_SIZE] = { };
+	unsigned int n = 0;
+
+	ccm_inc_ctr(ctr);
+	ce_aes_ecb_encrypt(buf[1], ctr, key, round_count, 1, 1);
+	for (n = 0; n < block_count; n++) {
+		ce_aes_xor_block(out, in, buf[1]);
+		ce_aes_xor_block(buf[0], mac, out);
+		if (n + 1 == block_count) {
+			ce_aes_ecb_encrypt(mac, buf[0], key, round_count, 1,
+					   1);
+			break;
+		}
+		ccm_inc_ctr(ctr);
+		memcpy(buf[1], ctr, TEE_AES_BLOCK_SIZE);
+		ce_aes_ecb_encrypt(buf[0], buf[0], key, round_count, 2, 1);
+		memcpy(mac, buf[0], TEE_AES_BLOCK_SIZE);
+		in += TEE_AES_BLOCK_SIZE;
+		out += TEE_AES_BLOCK_SIZE;
+	}
+}
+#endif
+
+void crypto_accel_aes_ccm_enc(void *out, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count, void *ctr, void *mac)
+{
+	uint32_t vfp_state = 0;
+
+	assert(out && in && key && ctr && mac);
+
+	vfp_state = thread_kernel_enable_vfp();
+#ifdef ARM64
+	ce_aes_ccm_encrypt(out, in, key, round_count, block_count, ctr, mac);
+#else
+	ccm_enc(out, in, key, round_count, block_count, ctr, mac);
+#endif
+	thread_kernel_disable_vfp(vfp_state);
+}
+
+void crypto_accel_aes_ccm_dec(void *out, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count, void *ctr, void *mac)
+{
+	uint32_t vfp_state = 0;
+
+	assert(out && in && key && ctr && mac);
+
+	vfp_state = thread_kernel_enable_vfp();
+#ifdef ARM64
+	ce_aes_ccm_decrypt(out, in, key, round_count, block_count, ctr, mac);
+#else
+	ccm_dec(out, in, key, round_count, block_count, ctr, mac);
+#endif
+	thread_kernel_disable_vfp(vfp_state);
+}
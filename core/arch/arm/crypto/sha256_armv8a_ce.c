@@ -9,6 +9,9 @@
 /* Prototype for assembly function */
 void sha256_ce_transform(uint32_t state[8], const void *src,
 			 unsigned int block_count);
+void sha256_ce_transform_x2(uint32_t state0[8], const void *src0,
+			    uint32_t state1[8], const void *src1,
+			    unsigned int block_count);
 
 void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 				  unsigned int block_count)
@@ -19,3 +22,19 @@ void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 	sha256_ce_transform(state, src, block_count);
 	thread_kernel_disable_vfp(vfp_state);
 }
+
+void crypto_accel_sha256_compress_x2(uint32_t state0[8], const void *src0,
+				     uint32_t state1[8], const void *src1,
+				     unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	vfp_state = thread_kernel_enable_vfp();
+#ifdef ARM64
+	sha256_ce_transform_x2(state0, src0, state1, src1, block_count);
+#else
+	sha256_ce_transform(state0, src0, block_count);
+	sha256_ce_transform(state1, src1, block_count);
+#endif
+	thread_kernel_disable_vfp(vfp_state);
+}
@@ -5,10 +5,71 @@
  * SM4 optimization for ARMv8 by SM4 HW instruction, which is an optional
  * Cryptographic Extension for ARMv8.2-A.
  */
+#include <arm.h>
 #include <crypto/crypto_accel.h>
 #include <kernel/thread.h>
 
 #include "sm4_armv8a_ce.h"
+#if defined(CFG_CRYPTO_SM4_ARM_AESE)
+#include "sm4_armv8a_neon.h"
+#endif
+
+struct sm4_impl {
+	void (*setkey_enc)(uint32_t sk[32], uint8_t const key[16]);
+	void (*setkey_dec)(uint32_t sk[32], uint8_t const key[16]);
+	void (*ecb_encrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk[], size_t len);
+	void (*cbc_encrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk[], size_t len, uint8_t iv[]);
+	void (*cbc_decrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk[], size_t len, uint8_t iv[]);
+	void (*ctr_encrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk[], size_t len, uint8_t iv[]);
+	void (*xts_encrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk1[], uint8_t const rk2[],
+			    size_t len, uint8_t iv[]);
+	void (*xts_decrypt)(uint8_t out[], uint8_t const in[],
+			    uint8_t const rk1[], uint8_t const rk2[],
+			    size_t len, uint8_t iv[]);
+};
+
+static const struct sm4_impl sm4_ce = {
+	.setkey_enc = ce_sm4_setkey_enc,
+	.setkey_dec = ce_sm4_setkey_dec,
+	.ecb_encrypt = ce_sm4_ecb_encrypt,
+	.cbc_encrypt = ce_sm4_cbc_encrypt,
+	.cbc_decrypt = ce_sm4_cbc_decrypt,
+	.ctr_encrypt = ce_sm4_ctr_encrypt,
+	.xts_encrypt = ce_sm4_xts_encrypt,
+	.xts_decrypt = ce_sm4_xts_decrypt,
+};
+
+#if defined(CFG_CRYPTO_SM4_ARM_AESE)
+static const struct sm4_impl sm4_aese = {
+	.setkey_enc = neon_sm4_setkey_enc,
+	.setkey_dec = neon_sm4_setkey_dec,
+	.ecb_encrypt = neon_sm4_ecb_encrypt,
+	.cbc_encrypt = neon_sm4_cbc_encrypt,
+	.cbc_decrypt = neon_sm4_cbc_decrypt,
+	.ctr_encrypt = neon_sm4_ctr_encrypt,
+	.xts_encrypt = neon_sm4_xts_encrypt,
+	.xts_decrypt = neon_sm4_xts_decrypt,
+};
+#endif
+
+/*
+ * The SM4 instructions are optional, when the NEON/AESE implementation is
+ * built as well it is used on CPUs which lack them. Both have 8-block
+ * parallel CBC decryption, CTR and XTS paths.
+ */
+static const struct sm4_impl *sm4_impl(void)
+{
+#if defined(CFG_CRYPTO_SM4_ARM_AESE)
+	if (!feat_sm4_implemented())
+		return &sm4_aese;
+#endif
+	return &sm4_ce;
+}
 
 void crypto_accel_sm4_setkey_enc(uint32_t sk[32], const uint8_t key[16])
 {
@@ -17,7 +78,7 @@ void crypto_accel_sm4_setkey_enc(uint32_t sk[32], const uint8_t key[16])
 	assert(sk && key);
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_setkey_enc(sk, key);
+	sm4_impl()->setkey_enc(sk, key);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -28,7 +89,7 @@ void crypto_accel_sm4_setkey_dec(uint32_t sk[32], const uint8_t key[16])
 	assert(sk && key);
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_setkey_dec(sk, key);
+	sm4_impl()->setkey_dec(sk, key);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -40,7 +101,7 @@ void crypto_accel_sm4_ecb_enc(void *out, const void *in, const void *key,
 	assert(out && in && key && !(len % 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_ecb_encrypt(out, in, key, len);
+	sm4_impl()->ecb_encrypt(out, in, key, len);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -52,7 +113,7 @@ void crypto_accel_sm4_cbc_enc(void *out, const void *in, const void *key,
 	assert(out && in && key && !(len % 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_cbc_encrypt(out, in, key, len, iv);
+	sm4_impl()->cbc_encrypt(out, in, key, len, iv);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -64,7 +125,7 @@ void crypto_accel_sm4_cbc_dec(void *out, const void *in, const void *key,
 	assert(out && in && key && !(len % 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_cbc_decrypt(out, in, key, len, iv);
+	sm4_impl()->cbc_decrypt(out, in, key, len, iv);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -76,7 +137,7 @@ void crypto_accel_sm4_ctr_enc(void *out, const void *in, const void *key,
 	assert(out && in && key && !(len % 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_ctr_encrypt(out, in, key, len, iv);
+	sm4_impl()->ctr_encrypt(out, in, key, len, iv);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -88,7 +149,7 @@ void crypto_accel_sm4_xts_enc(void *out, const void *in, const void *key1,
 	assert(out && in && key1 && key2 && (len >= 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_xts_encrypt(out, in, key1, key2, len, iv);
+	sm4_impl()->xts_encrypt(out, in, key1, key2, len, iv);
 	thread_kernel_disable_vfp(vfp_state);
 }
 
@@ -100,6 +161,6 @@ void crypto_accel_sm4_xts_dec(void *out, const void *in, const void *key1,
 	assert(out && in && key1 && key2 && (len >= 16));
 
 	vfp_state = thread_kernel_enable_vfp();
-	ce_sm4_xts_decrypt(out, in, key1, key2, len, iv);
+	sm4_impl()->xts_decrypt(out, in, key1, key2, len, iv);
 	thread_kernel_disable_vfp(vfp_state);
 }
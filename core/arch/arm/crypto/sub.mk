@@ -4,6 +4,14 @@ srcs-$(CFG_ARM32_core) += ghash-ce-core_a32.S
 srcs-y += aes-gcm-ce.c
 endif
 
+ifeq ($(CFG_CRYPTO_AES_GCM_CE_RUNTIME),y)
+srcs-y += ghash-ce-core_a64.S
+srcs-y += aes-gcm-ce.c
+srcs-y += aes_armv8a_ce.c
+srcs-y += aes_modes_armv8a_ce_a64.S
+aflags-aes_modes_armv8a_ce_a64.S-y += -DINTERLEAVE=4
+endif
+
 ifeq ($(CFG_CRYPTO_AES_ARM_CE),y)
 srcs-y += aes_armv8a_ce.c
 srcs-$(CFG_ARM64_core) += aes_modes_armv8a_ce_a64.S
@@ -41,6 +49,10 @@ endif
 ifeq ($(CFG_CRYPTO_SM4_ARM_CE),y)
 srcs-$(CFG_ARM64_core) += sm4_armv8a_ce.c
 srcs-$(CFG_ARM64_core) += sm4_armv8a_ce_a64.S
+ifeq ($(CFG_CRYPTO_SM4_ARM_AESE),y)
+# Used instead of the SM4 instructions when the CPU doesn't have them
+srcs-$(CFG_ARM64_core) += sm4_armv8a_aese_a64.S
+endif
 else ifeq ($(CFG_CRYPTO_SM4_ARM_AESE),y)
 srcs-$(CFG_ARM64_core) += sm4_armv8a_neon.c
 srcs-$(CFG_ARM64_core) += sm4_armv8a_aese_a64.S
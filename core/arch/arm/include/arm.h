@@ -81,6 +81,8 @@
 
 /* ID_ISAR5 Cryptography Extension masks */
 #define ID_ISAR5_AES		GENMASK_32(7, 4)
+#define ID_ISAR5_AES_SHIFT	U(4)
+#define ID_ISAR5_AES_FEAT_PMULL	U(2)
 #define ID_ISAR5_SHA1		GENMASK_32(11, 8)
 #define ID_ISAR5_SHA2		GENMASK_32(15, 12)
 #define ID_ISAR5_CRC32		GENMASK_32(19, 16)
@@ -199,6 +201,18 @@ static inline bool feat_aes_implemented(void)
 #endif
 }
 
+/* AES instructions together with 64-bit polynomial multiply (PMULL) */
+static inline bool feat_pmull_implemented(void)
+{
+#ifdef ARM32
+	return ((read_id_isar5() & ID_ISAR5_AES) >> ID_ISAR5_AES_SHIFT) ==
+	       ID_ISAR5_AES_FEAT_PMULL;
+#else
+	return ((read_id_aa64isar0_el1() & ID_AA64ISAR0_AES) >>
+		ID_AA64ISAR0_AES_SHIFT) == ID_AA64ISAR0_AES_FEAT_PMULL;
+#endif
+}
+
 static inline bool feat_sha1_implemented(void)
 {
 #ifdef ARM32
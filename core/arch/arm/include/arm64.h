@@ -301,6 +301,9 @@
 #define ID_AA64ISAR0_SM3	GENMASK_64(39, 36)
 #define ID_AA64ISAR0_SM4	GENMASK_64(43, 40)
 
+#define ID_AA64ISAR0_AES_SHIFT		U(4)
+#define ID_AA64ISAR0_AES_FEAT_PMULL	U(2)
+
 #define ID_AA64ISAR0_SHA2_SHIFT		U(12)
 #define ID_AA64ISAR0_SHA2_FEAT_SHA256	U(1)
 #define ID_AA64ISAR0_SHA2_FEAT_SHA512	U(2)
@@ -8,12 +8,17 @@
 
 #include <inttypes.h>
 
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+/* Defined in <crypto/internal_aes-gcm.h> together with the software key */
+struct internal_ghash_key;
+#else
 struct internal_ghash_key {
 	uint64_t h[2];
 	uint64_t h2[2];
 	uint64_t h3[2];
 	uint64_t h4[2];
 };
+#endif
 
 void pmull_ghash_update_p64(int blocks, uint64_t dg[2], const uint8_t *src,
 			    const struct internal_ghash_key *ghash_key,
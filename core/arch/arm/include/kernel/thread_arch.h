@@ -364,10 +364,11 @@ unsigned long thread_system_reset_handler(unsigned long a0, unsigned long a1);
  * entered before thread_kernel_disable_vfp() has been called to disable VFP
  * and restore the foreign interrupt status.
  *
- * This function may only be called from an active thread context and may
- * not be called again before thread_kernel_disable_vfp() has been called.
- *
- * VFP state is saved as needed.
+ * This function may only be called from an active thread context. Calls
+ * may be nested, only the outermost call saves the VFP state as needed and
+ * only the matching thread_kernel_disable_vfp() disables VFP again. This
+ * lets a caller enable VFP once around a batch of operations, for instance
+ * all the blocks of a request, instead of once per block.
  *
  * Returns a state variable that should be passed to
  * thread_kernel_disable_vfp().
@@ -379,7 +380,7 @@ uint32_t thread_kernel_enable_vfp(void);
  * @state:	state variable returned by thread_kernel_enable_vfp()
  *
  * Disables usage of VFP and restores foreign interrupt status after a call to
- * thread_kernel_enable_vfp().
+ * thread_kernel_enable_vfp(). Nothing is done for a nested call.
  *
  * This function may only be called after a call to
  * thread_kernel_enable_vfp().
@@ -95,6 +95,10 @@
 #define OPTEE_FFA_SEC_CAP_ASYNC_NOTIF	BIT(1)
 /* OP-TEE supports probing for RPMB device if needed */
 #define OPTEE_FFA_SEC_CAP_RPMB_PROBE	BIT(2)
+/* OP-TEE supports OPTEE_MSG_CMD_INVOKE_BATCH */
+#define OPTEE_FFA_SEC_CAP_INVOKE_BATCH	BIT(3)
+/* OP-TEE supports OPTEE_MSG_CMD_INVOKE_ASYNC */
+#define OPTEE_FFA_SEC_CAP_INVOKE_ASYNC	BIT(4)
 
 #define OPTEE_FFA_EXCHANGE_CAPABILITIES OPTEE_FFA_BLOCKING_CALL(2)
 
@@ -318,6 +318,12 @@
 #define OPTEE_SMC_SEC_CAP_RPC_ARG		BIT(6)
 /* Secure world supports probing for RPMB device if needed */
 #define OPTEE_SMC_SEC_CAP_RPMB_PROBE		BIT(7)
+/* Secure world supports OPTEE_MSG_CMD_INVOKE_BATCH */
+#define OPTEE_SMC_SEC_CAP_INVOKE_BATCH		BIT(8)
+/* Secure world supports OPTEE_MSG_CMD_INVOKE_ASYNC */
+#define OPTEE_SMC_SEC_CAP_INVOKE_ASYNC		BIT(9)
+/* Secure world supports OPTEE_MSG_ATTR_EXTENTS */
+#define OPTEE_SMC_SEC_CAP_SHM_EXTENTS		BIT(10)
 
 #define OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES	U(9)
 #define OPTEE_SMC_EXCHANGE_CAPABILITIES \
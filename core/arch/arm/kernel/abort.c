@@ -11,6 +11,7 @@
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread_private.h>
 #include <kernel/user_mode_ctx.h>
+#include <kernel/user_ta.h>
 #include <memtag.h>
 #include <mm/core_mmu.h>
 #include <mm/tee_pager.h>
@@ -576,6 +577,8 @@ void abort_handler(uint32_t abort_type, struct thread_abort_regs *regs)
 		thread_kernel_save_vfp();
 		handled = tee_pager_handle_fault(&ai);
 		thread_kernel_restore_vfp();
+		if (handled && abort_is_user_exception(&ai))
+			user_ta_acct_page_fault();
 		if (!handled) {
 			if (!abort_is_user_exception(&ai)) {
 				abort_print_error(&ai);
@@ -236,8 +236,11 @@ static void check_crypto_extensions(void)
 			ce_supported = false;
 		}
 
+		/* CFG_CRYPTO_SM4_ARM_AESE is a runtime fallback */
 		if (!feat_sm4_implemented() &&
-		    IS_ENABLED(CFG_CRYPTO_SM4_ARM_CE)) {
+		    IS_ENABLED(CFG_CRYPTO_SM4_ARM_CE) &&
+		    (!IS_ENABLED(CFG_CRYPTO_SM4_ARM_AESE) ||
+		     !feat_aes_implemented())) {
 			EMSG("SM4 instructions are not supported");
 			ce_supported = false;
 		}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <kernel/misc.h>
+#include <kernel/perf_stats.h>
+#include <kernel/thread.h>
+#include <pta_stats.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * The Performance Monitors are programmed the first time a region is
+ * measured on a CPU, and again if the normal world has disabled them.
+ * Event counters 0 to 3 and the cycle counter are used, filtered to
+ * count only in secure EL1 and EL0. If the normal world uses the same
+ * counters the statistics are disturbed. If EL3 prohibits counting in
+ * the secure state (MDCR_EL3.SPME == 0) nothing is counted.
+ */
+#define PMCR_E			BIT(0)
+#define PMCR_LC			BIT(6)
+#define PMCNTEN_C		BIT(31)
+/* Exclude non-secure EL1 and EL0, EL2 and EL3 */
+#define PMEVTYPER_FILTER	(BIT(29) | BIT(28) | BIT(26))
+
+#define PMU_EVT_INST_RETIRED	0x08
+#define PMU_EVT_L1D_REFILL	0x03
+#define PMU_EVT_L2D_REFILL	0x17
+#define PMU_EVT_L1D_TLB_REFILL	0x05
+
+struct perf_stats_acc {
+	uint64_t count;
+	uint64_t migrated;
+	uint64_t ctr[PERF_STATS_CTR_COUNT];
+};
+
+/* Each CPU only updates its own accumulators, with interrupts masked */
+static struct perf_stats_acc
+	perf_acc[CFG_TEE_CORE_NB_CORE][PERF_STATS_POINT_COUNT] __nex_bss;
+
+#define PMEV_WRITE(n, evt) \
+	asm volatile ("msr pmevtyper" #n "_el0, %0" : : \
+		      "r" ((uint64_t)(evt) | PMEVTYPER_FILTER))
+#define PMEV_READ(n) ({ \
+		uint64_t __v = 0; \
+		asm volatile ("mrs %0, pmevcntr" #n "_el0" : "=r" (__v)); \
+		__v; \
+	})
+
+static void pmu_init(void)
+{
+	uint64_t pmcr = 0;
+
+	asm volatile ("mrs %0, pmcr_el0" : "=r" (pmcr));
+	if (pmcr & PMCR_E)
+		return;
+
+	PMEV_WRITE(0, PMU_EVT_INST_RETIRED);
+	PMEV_WRITE(1, PMU_EVT_L1D_REFILL);
+	PMEV_WRITE(2, PMU_EVT_L2D_REFILL);
+	PMEV_WRITE(3, PMU_EVT_L1D_TLB_REFILL);
+	asm volatile ("msr pmccfiltr_el0, %0" : :
+		      "r" ((uint64_t)PMEVTYPER_FILTER));
+	asm volatile ("msr pmcntenset_el0, %0" : :
+		      "r" ((uint64_t)(PMCNTEN_C | GENMASK_32(3, 0))));
+	asm volatile ("msr pmcr_el0, %0" : : "r" (pmcr | PMCR_E | PMCR_LC));
+	isb();
+}
+
+static void pmu_read(uint64_t ctr[PERF_STATS_CTR_COUNT])
+{
+	ctr[PERF_STATS_CYCLES] = read_pmccntr();
+	ctr[PERF_STATS_INSTRUCTIONS] = PMEV_READ(0);
+	ctr[PERF_STATS_L1D_REFILL] = PMEV_READ(1);
+	ctr[PERF_STATS_L2D_REFILL] = PMEV_READ(2);
+	ctr[PERF_STATS_TLB_REFILL] = PMEV_READ(3);
+}
+
+void perf_stats_begin(struct perf_stats_snap *snap)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+
+	pmu_init();
+	snap->core_pos = get_core_pos();
+	pmu_read(snap->ctr);
+
+	thread_unmask_exceptions(exceptions);
+}
+
+void perf_stats_end(enum perf_stats_point point,
+		    const struct perf_stats_snap *snap)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	uint64_t ctr[PERF_STATS_CTR_COUNT] = { };
+	size_t pos = get_core_pos();
+	struct perf_stats_acc *acc = &perf_acc[pos][point];
+	size_t n = 0;
+
+	if (pos != snap->core_pos) {
+		acc->migrated++;
+	} else {
+		pmu_read(ctr);
+		/* Event counters are 32 bits, the cycle counter 64 bits */
+		acc->ctr[0] += ctr[0] - snap->ctr[0];
+		for (n = 1; n < ARRAY_SIZE(ctr); n++)
+			acc->ctr[n] += (uint32_t)(ctr[n] - snap->ctr[n]);
+		acc->count++;
+	}
+
+	thread_unmask_exceptions(exceptions);
+}
+
+TEE_Result perf_stats_get(void *buf, size_t *buf_size)
+{
+	struct pta_stats_perf *stats = buf;
+	size_t sz = PERF_STATS_POINT_COUNT * sizeof(*stats);
+	struct perf_stats_acc *acc = NULL;
+	size_t core = 0;
+	size_t p = 0;
+	size_t n = 0;
+
+	static_assert(PERF_STATS_CTR_COUNT == ARRAY_SIZE(stats->ctr));
+
+	if (*buf_size < sz || !buf) {
+		*buf_size = sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	memset(buf, 0, sz);
+	for (p = 0; p < PERF_STATS_POINT_COUNT; p++) {
+		stats[p].point = p;
+		for (core = 0; core < CFG_TEE_CORE_NB_CORE; core++) {
+			acc = &perf_acc[core][p];
+			stats[p].count += acc->count;
+			stats[p].migrated += acc->migrated;
+			for (n = 0; n < PERF_STATS_CTR_COUNT; n++)
+				stats[p].ctr[n] += acc->ctr[n];
+		}
+	}
+	*buf_size = sz;
+
+	return TEE_SUCCESS;
+}
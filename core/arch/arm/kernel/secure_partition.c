@@ -590,7 +590,7 @@ err_free_mobj:
 	mobj_put(mobj);
 
 err_free_tee_mm:
-	tee_mm_free(mm);
+	phys_mem_free(mm);
 
 err:
 	store_ops->close(handle);
@@ -965,7 +965,7 @@ static TEE_Result handle_fdt_load_relative_mem_regions(struct sp_ctx *ctx,
 	return TEE_SUCCESS;
 
 err_mm_free:
-	tee_mm_free(mm);
+	phys_mem_free(mm);
 	return res;
 }
 
@@ -1309,7 +1309,7 @@ static TEE_Result handle_fdt_mem_regions(struct sp_ctx *ctx, void *fdt)
 	return TEE_SUCCESS;
 
 err_mm_free:
-	tee_mm_free(mm);
+	phys_mem_free(mm);
 	return res;
 }
 
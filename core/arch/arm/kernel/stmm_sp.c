@@ -372,7 +372,7 @@ TEE_Result stmm_complete_session(struct tee_ta_session *sess)
 
 	mutex_lock(&tee_ta_mutex);
 	spc->ta_ctx.is_initializing = false;
-	TAILQ_INSERT_TAIL(&tee_ctxes, &spc->ta_ctx, link);
+	tee_ta_link_ctx(&spc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	return TEE_SUCCESS;
@@ -6,6 +6,7 @@ ifeq ($(CFG_CALLOUT),y)
 srcs-$(CFG_ARM64_core) += generic_timer.c
 endif
 srcs-$(CFG_ARM64_core) += timer_a64.c
+srcs-$(CFG_CORE_PERF_STATS) += perf_stats.c
 
 srcs-$(CFG_ARM32_core) += spin_lock_a32.S
 srcs-$(CFG_ARM64_core) += spin_lock_a64.S
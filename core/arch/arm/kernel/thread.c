@@ -18,6 +18,7 @@
 #include <kernel/linker.h>
 #include <kernel/lockdep.h>
 #include <kernel/misc.h>
+#include <kernel/pc_sample.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/spmc_sp_handler.h>
@@ -26,6 +27,7 @@
 #include <kernel/thread_private.h>
 #include <kernel/user_access.h>
 #include <kernel/user_mode_ctx_struct.h>
+#include <kernel/user_ta.h>
 #include <kernel/virtualization.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
@@ -222,27 +224,16 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc, uint32_t flags)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
 	size_t n = 0;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
-	}
-
-	thread_unlock_global();
-
-	if (!found_thread)
+	if (!thread_claim_free(&n))
 		return;
 
 	l->curr_thread = n;
+	thread_time_stats_enter(n);
+	threads[n].tsd.yield_stamp = 0;
 
 	threads[n].flags = flags;
 	init_regs(threads + n, a0, a1, a2, a3, a4, a5, a6, a7, pc);
@@ -381,6 +372,8 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 		return;
 
 	l->curr_thread = n;
+	thread_time_stats_enter(n);
+	threads[n].tsd.yield_stamp = 0;
 
 	if (threads[n].have_user_map) {
 		core_mmu_set_user_map(&threads[n].user_map);
@@ -460,6 +453,7 @@ void thread_state_free(void)
 	thread_lock_global();
 
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
+	thread_time_stats_exit(ct, true /* freed */);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
 	l->curr_thread = THREAD_ID_INVALID;
@@ -503,8 +497,11 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 
 	assert(ct != THREAD_ID_INVALID);
 
-	if (core_mmu_user_mapping_is_active())
+	if (core_mmu_user_mapping_is_active()) {
 		ftrace_suspend();
+		if (flags & THREAD_FLAGS_COPY_ARGS_ON_RETURN)
+			user_ta_acct_rpc();
+	}
 
 	thread_check_canaries();
 
@@ -514,12 +511,15 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 		thread_user_save_vfp();
 		tee_ta_update_session_utime_suspend();
 		tee_ta_gprof_sample_pc(pc);
+	} else {
+		core_pc_sample(pc);
 	}
 	thread_lazy_restore_ns_vfp();
 
 	thread_lock_global();
 
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
+	thread_time_stats_exit(ct, false /* freed */);
 	threads[ct].flags |= flags;
 	threads[ct].regs.cpsr = cpsr;
 	threads[ct].regs.pc = pc;
@@ -792,13 +792,26 @@ void thread_init_per_cpu(void)
 }
 
 #ifdef CFG_WITH_VFP
+/*
+ * Returned by thread_kernel_enable_vfp() when VFP was already enabled,
+ * above the exception bits.
+ */
+#define THREAD_VFP_NESTED	BIT32(31)
+
 uint32_t thread_kernel_enable_vfp(void)
 {
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
-	struct thread_ctx *thr = threads + thread_get_id();
-	struct thread_user_vfp_state *tuv = thr->vfp_state.uvfp;
+	struct thread_ctx *thr = NULL;
+	struct thread_user_vfp_state *tuv = NULL;
 
-	assert(!vfp_is_enabled());
+	static_assert(!(THREAD_EXCP_ALL & THREAD_VFP_NESTED));
+
+	/* Already inside a kernel VFP section, the state is taken care of */
+	if (vfp_is_enabled())
+		return exceptions | THREAD_VFP_NESTED;
+
+	thr = threads + thread_get_id();
+	tuv = thr->vfp_state.uvfp;
 
 	if (!thr->vfp_state.ns_saved) {
 		vfp_lazy_save_state_final(&thr->vfp_state.ns,
@@ -832,6 +845,9 @@ void thread_kernel_disable_vfp(uint32_t state)
 
 	assert(vfp_is_enabled());
 
+	if (state & THREAD_VFP_NESTED)
+		return;
+
 	vfp_disable();
 	exceptions = thread_get_exceptions();
 	assert(exceptions & THREAD_EXCP_FOREIGN_INTR);
@@ -10,6 +10,7 @@
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
 #include <kernel/notif.h>
+#include <kernel/perf_stats.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
 #include <kernel/virtualization.h>
@@ -167,7 +168,15 @@ static uint32_t call_entry_std(struct optee_msg_arg *arg, size_t num_params,
 	else
 		rv = OPTEE_SMC_RETURN_OK;
 
-	thread_rpc_shm_cache_clear(&thr->shm_cache);
+	/*
+	 * With the prealloc RPC cache enabled, kernel private payload
+	 * buffers are kept for the next call on this thread, saving an
+	 * allocate/free RPC pair for each of them.
+	 */
+	if (IS_ENABLED(CFG_PREALLOC_RPC_CACHE) && thread_prealloc_rpc_cache)
+		thread_rpc_shm_cache_trim(&thr->shm_cache);
+	else
+		thread_rpc_shm_cache_clear(&thr->shm_cache);
 	if (rpc_arg)
 		thr->rpc_arg = NULL;
 
@@ -295,10 +304,17 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 				       uint32_t a3, uint32_t a4 __unused,
 				       uint32_t a5 __unused)
 {
+	struct perf_stats_snap snap = { };
+	uint32_t ret = 0;
+
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		virt_on_stdcall();
 
-	return std_smc_entry(a0, a1, a2, a3);
+	perf_stats_begin(&snap);
+	ret = std_smc_entry(a0, a1, a2, a3);
+	perf_stats_end(PERF_STATS_STD_SMC, &snap);
+
+	return ret;
 }
 
 bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
@@ -320,6 +336,9 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 
 	if (IS_ENABLED(CFG_PREALLOC_RPC_CACHE)) {
 		for (n = 0; n < CFG_NUM_THREADS; n++) {
+			struct thread_shm_cache *c = &threads[n].shm_cache;
+			struct mobj *mobj = NULL;
+
 			if (threads[n].rpc_arg) {
 				*cookie = mobj_get_cookie(threads[n].rpc_mobj);
 				mobj_put(threads[n].rpc_mobj);
@@ -327,6 +346,13 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 				threads[n].rpc_mobj = NULL;
 				goto out;
 			}
+
+			mobj = thread_rpc_shm_cache_pop_kernel(c);
+			if (mobj) {
+				*cookie = mobj_get_cookie(mobj);
+				mobj_put(mobj);
+				goto out;
+			}
 		}
 	}
 
@@ -558,6 +584,15 @@ static uint32_t get_rpc_arg_res(struct optee_msg_arg *arg, size_t num_params,
 	return arg->ret;
 }
 
+void thread_rpc_yield(void)
+{
+	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = {
+		OPTEE_SMC_RETURN_RPC_FOREIGN_INTR
+	};
+
+	thread_rpc(rpc_args);
+}
+
 uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 			struct thread_param *params)
 {
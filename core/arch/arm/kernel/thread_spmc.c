@@ -834,6 +834,10 @@ static void handle_blocking_call(struct thread_smc_1_2_regs *args,
 			sec_caps |= OPTEE_FFA_SEC_CAP_ASYNC_NOTIF;
 		if (IS_ENABLED(CFG_RPMB_ANNOUNCE_PROBE_CAP))
 			sec_caps |= OPTEE_FFA_SEC_CAP_RPMB_PROBE;
+		if (IS_ENABLED(CFG_CORE_INVOKE_BATCH))
+			sec_caps |= OPTEE_FFA_SEC_CAP_INVOKE_BATCH;
+		if (IS_ENABLED(CFG_CORE_ASYNC_INVOKE) && spmc_notif_is_ready)
+			sec_caps |= OPTEE_FFA_SEC_CAP_INVOKE_ASYNC;
 		spmc_set_args(args, direct_resp_fid,
 			      swap_src_dst(args->a1), 0, 0,
 			      THREAD_RPC_MAX_NUM_PARAMS, sec_caps);
@@ -2178,6 +2182,14 @@ static uint32_t get_rpc_arg_res(struct optee_msg_arg *arg, size_t num_params,
 	return arg->ret;
 }
 
+/*
+ * The SPMC preempts the thread on non-secure interrupts, there's no
+ * voluntary return to normal world in the FF-A ABI.
+ */
+void thread_rpc_yield(void)
+{
+}
+
 uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 			struct thread_param *params)
 {
@@ -104,6 +104,28 @@ err:
 	return NULL;
 }
 
+size_t unw_fill_kernel_stack(vaddr_t *addr, size_t count)
+{
+	struct unwind_state_arm32 state = { };
+	vaddr_t stack_start = 0;
+	vaddr_t stack_end = 0;
+	size_t n = 0;
+
+	state.registers[7] = read_r7();
+	state.registers[FP] = read_fp();
+	state.registers[SP] = read_sp();
+	state.registers[LR] = read_lr();
+	/* See unw_get_kernel_stack() above */
+	state.registers[PC] = (uint32_t)unw_fill_kernel_stack + 4;
+
+	get_stack_hard_limits(&stack_start, &stack_end);
+	while (n < count &&
+	       unwind_stack_arm32(&state, stack_start, stack_end - stack_start))
+		addr[n++] = state.registers[PC];
+
+	return n;
+}
+
 #if (TRACE_LEVEL > 0)
 void print_kernel_stack(void)
 {
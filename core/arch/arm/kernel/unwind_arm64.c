@@ -83,6 +83,24 @@ err:
 	return NULL;
 }
 
+size_t unw_fill_kernel_stack(vaddr_t *addr, size_t count)
+{
+	struct unwind_state_arm64 state = {
+		.pc = read_pc(),
+		.fp = read_fp()
+	};
+	vaddr_t stack_start = 0;
+	vaddr_t stack_end = 0;
+	size_t n = 0;
+
+	get_stack_hard_limits(&stack_start, &stack_end);
+	while (n < count &&
+	       unwind_stack_arm64(&state, stack_start, stack_end - stack_start))
+		addr[n++] = state.pc;
+
+	return n;
+}
+
 #if defined(CFG_UNWIND) && (TRACE_LEVEL > 0)
 void print_kernel_stack(void)
 {
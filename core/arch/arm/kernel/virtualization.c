@@ -6,6 +6,7 @@
 
 #include <bitstring.h>
 #include <compiler.h>
+#include <config.h>
 #include <kernel/boot.h>
 #include <kernel/linker.h>
 #include <kernel/misc.h>
@@ -28,12 +29,56 @@
 
 LIST_HEAD(prtn_list_head, guest_partition);
 
+/* Buckets of the guest partitions hashed by guest ID */
+#define PRTN_HASH_SIZE		CFG_VIRT_GUEST_COUNT
+
 static unsigned int prtn_list_lock __nex_data = SPINLOCK_UNLOCK;
 
 static struct prtn_list_head prtn_list __nex_data =
 	LIST_HEAD_INITIALIZER(prtn_list);
 static struct prtn_list_head prtn_destroy_list __nex_data =
 	LIST_HEAD_INITIALIZER(prtn_destroy_list);
+/* Partitions in prtn_list, protected by prtn_list_lock too */
+static struct prtn_list_head prtn_hash[PRTN_HASH_SIZE] __nex_bss;
+
+#ifdef CFG_CORE_SEL1_SPMC
+/* Buckets of the cookies of all partitions in prtn_list */
+#define COOKIE_HASH_SIZE	(CFG_VIRT_GUEST_COUNT * \
+				 SPMC_CORE_SEL1_MAX_SHM_COUNT)
+
+/*
+ * struct prtn_cookie - Shared memory cookie of a guest partition
+ * @cookie:	the cookie
+ * @prtn:	partition the cookie belongs to
+ * @link:	link in cookie_hash[]
+ */
+struct prtn_cookie {
+	uint64_t cookie;
+	struct guest_partition *prtn;
+	LIST_ENTRY(prtn_cookie) link;
+};
+
+LIST_HEAD(prtn_cookie_head, prtn_cookie);
+
+/* Protected by prtn_list_lock */
+static struct prtn_cookie_head cookie_hash[COOKIE_HASH_SIZE] __nex_bss;
+#endif
+
+/*
+ * struct prtn_ta_mem - TA memory a guest partition has drawn from the
+ * nexus pools with CFG_VIRT_GUEST_TA_RAM_ON_DEMAND
+ * @mm:		the allocated memory
+ * @link:	link in the ta_mem list of the partition
+ */
+struct prtn_ta_mem {
+	tee_mm_entry_t *mm;
+	LIST_ENTRY(prtn_ta_mem) link;
+};
+
+LIST_HEAD(prtn_ta_mem_head, prtn_ta_mem);
+
+/* Protects the ta_mem fields of all partitions */
+static unsigned int ta_mem_lock __nex_data = SPINLOCK_UNLOCK;
 
 /* Memory used by OP-TEE core */
 struct memory_map *kmem_map __nex_bss;
@@ -49,12 +94,16 @@ static struct guest_spec_data *gsd_array __nex_bss;
 
 struct guest_partition {
 	LIST_ENTRY(guest_partition) link;
+	LIST_ENTRY(guest_partition) hash_link;
 	struct mmu_partition *mmu_prtn;
 	struct memory_map mem_map;
 	struct mutex mutex;
 	void *tables_va;
 	tee_mm_entry_t *tee_ram;
 	tee_mm_entry_t *ta_ram;
+	struct prtn_ta_mem_head ta_mem;
+	size_t ta_mem_size;
+	size_t ta_mem_limit;
 	tee_mm_entry_t *tables;
 	bool runtime_initialized;
 	bool got_guest_destroyed;
@@ -62,7 +111,8 @@ struct guest_partition {
 	uint16_t id;
 	struct refcount refc;
 #ifdef CFG_CORE_SEL1_SPMC
-	uint64_t cookies[SPMC_CORE_SEL1_MAX_SHM_COUNT];
+	struct prtn_cookie cookies[SPMC_CORE_SEL1_MAX_SHM_COUNT];
+	bitstr_t bit_decl(cookie_bits, SPMC_CORE_SEL1_MAX_SHM_COUNT);
 	uint8_t cookie_count;
 	bitstr_t bit_decl(shm_bits, SPMC_CORE_SEL1_MAX_SHM_COUNT);
 #endif
@@ -203,13 +253,19 @@ static TEE_Result configure_guest_prtn_mem(struct guest_partition *prtn)
 	}
 	DMSG("TEE RAM: %08" PRIxPA, tee_mm_get_smem(prtn->tee_ram));
 
-	prtn->ta_ram = nex_phys_mem_ta_alloc(get_ta_ram_size());
-	if (!prtn->ta_ram) {
-		EMSG("Can't allocate memory for TA data");
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto err;
+	if (IS_ENABLED(CFG_VIRT_GUEST_TA_RAM_ON_DEMAND)) {
+		/* TA memory is drawn from the nexus pools when needed */
+		prtn->ta_mem_limit = plat_virt_guest_ta_ram_limit(prtn->id);
+		DMSG("TA RAM limit: %#zx", prtn->ta_mem_limit);
+	} else {
+		prtn->ta_ram = nex_phys_mem_ta_alloc(get_ta_ram_size());
+		if (!prtn->ta_ram) {
+			EMSG("Can't allocate memory for TA data");
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto err;
+		}
+		DMSG("TA RAM: %08" PRIxPA, tee_mm_get_smem(prtn->ta_ram));
 	}
-	DMSG("TA RAM: %08" PRIxPA, tee_mm_get_smem(prtn->ta_ram));
 
 	prtn->tables = nex_phys_mem_core_alloc(core_mmu_get_total_pages_size());
 	if (!prtn->tables) {
@@ -298,6 +354,95 @@ static TEE_Result alloc_gsd(struct guest_partition *prtn)
 
 	return TEE_SUCCESS;
 }
+__weak size_t plat_virt_guest_thread_quota(uint16_t guest_id __unused)
+{
+	return CFG_VIRT_GUEST_THREAD_QUOTA;
+}
+
+__weak size_t plat_virt_guest_ta_ram_limit(uint16_t guest_id __unused)
+{
+	return get_ta_ram_size();
+}
+
+tee_mm_entry_t *virt_ta_mem_alloc(size_t size)
+{
+	struct guest_partition *prtn = get_current_prtn();
+	struct prtn_ta_mem *tm = NULL;
+	uint32_t exceptions = 0;
+	size_t sz = 0;
+
+	if (!IS_ENABLED(CFG_VIRT_GUEST_TA_RAM_ON_DEMAND) || !prtn ||
+	    ROUNDUP_OVERFLOW(size, CORE_MMU_USER_CODE_SIZE, &sz))
+		return NULL;
+
+	/* Reserve the memory first, the allocation can't hold the lock */
+	exceptions = cpu_spin_lock_xsave(&ta_mem_lock);
+	if (prtn->ta_mem_limit - prtn->ta_mem_size < sz) {
+		cpu_spin_unlock_xrestore(&ta_mem_lock, exceptions);
+		return NULL;
+	}
+	prtn->ta_mem_size += sz;
+	cpu_spin_unlock_xrestore(&ta_mem_lock, exceptions);
+
+	tm = nex_calloc(1, sizeof(*tm));
+	if (tm)
+		tm->mm = nex_phys_mem_ta_alloc(size);
+
+	exceptions = cpu_spin_lock_xsave(&ta_mem_lock);
+	if (tm && tm->mm)
+		LIST_INSERT_HEAD(&prtn->ta_mem, tm, link);
+	else
+		prtn->ta_mem_size -= sz;
+	cpu_spin_unlock_xrestore(&ta_mem_lock, exceptions);
+
+	if (!tm || !tm->mm) {
+		nex_free(tm);
+		return NULL;
+	}
+
+	return tm->mm;
+}
+
+void virt_ta_mem_free(tee_mm_entry_t *mm)
+{
+	struct guest_partition *prtn = get_current_prtn();
+	struct prtn_ta_mem *tm = NULL;
+	uint32_t exceptions = 0;
+
+	if (!mm)
+		return;
+
+	assert(prtn);
+	exceptions = cpu_spin_lock_xsave(&ta_mem_lock);
+	LIST_FOREACH(tm, &prtn->ta_mem, link) {
+		if (tm->mm == mm) {
+			LIST_REMOVE(tm, link);
+			prtn->ta_mem_size -= tee_mm_get_bytes(mm);
+			break;
+		}
+	}
+	cpu_spin_unlock_xrestore(&ta_mem_lock, exceptions);
+
+	if (!tm)
+		panic("TA memory not drawn by this guest");
+
+	tee_mm_free(mm);
+	nex_free(tm);
+}
+
+static void free_ta_mem(struct guest_partition *prtn)
+{
+	struct prtn_ta_mem *tm = NULL;
+
+	/* Memory still held by TAs of the guest when it was destroyed */
+	while ((tm = LIST_FIRST(&prtn->ta_mem))) {
+		LIST_REMOVE(tm, link);
+		tee_mm_free(tm->mm);
+		nex_free(tm);
+	}
+	prtn->ta_mem_size = 0;
+}
+
 TEE_Result virt_guest_created(uint16_t guest_id)
 {
 	struct guest_partition *prtn = NULL;
@@ -325,15 +470,20 @@ TEE_Result virt_guest_created(uint16_t guest_id)
 	set_current_prtn(prtn);
 
 	malloc_add_pool(__heap1_start, __heap1_end - __heap1_start);
-	phys_mem_init(0, 0, tee_mm_get_smem(prtn->ta_ram),
-		      tee_mm_get_bytes(prtn->ta_ram));
+	if (prtn->ta_ram)
+		phys_mem_init(0, 0, tee_mm_get_smem(prtn->ta_ram),
+			      tee_mm_get_bytes(prtn->ta_ram));
 	/* Initialize threads */
 	thread_init_threads();
+	thread_set_quota(MIN(plat_virt_guest_thread_quota(guest_id),
+			     (size_t)CFG_NUM_THREADS));
 	/* Do the preinitcalls */
 	call_preinitcalls();
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
 	LIST_INSERT_HEAD(&prtn_list, prtn, link);
+	LIST_INSERT_HEAD(prtn_hash + guest_id % PRTN_HASH_SIZE, prtn,
+			 hash_link);
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
 	IMSG("Added guest %d", guest_id);
@@ -365,6 +515,19 @@ prtn_have_remaining_resources(struct guest_partition *prtn __maybe_unused)
 #endif
 }
 
+/* Called with prtn_list_lock held when @prtn leaves prtn_list */
+static void unhash_prtn(struct guest_partition *prtn)
+{
+#ifdef CFG_CORE_SEL1_SPMC
+	int n = 0;
+
+	for (n = 0; n < SPMC_CORE_SEL1_MAX_SHM_COUNT; n++)
+		if (bit_test(prtn->cookie_bits, n))
+			LIST_REMOVE(prtn->cookies + n, link);
+#endif
+	LIST_REMOVE(prtn, hash_link);
+}
+
 static void get_prtn(struct guest_partition *prtn)
 {
 	if (!refcount_inc(&prtn->refc))
@@ -382,7 +545,7 @@ static struct guest_partition *find_guest_by_id_unlocked(uint16_t guest_id)
 {
 	struct guest_partition *prtn = NULL;
 
-	LIST_FOREACH(prtn, &prtn_list, link)
+	LIST_FOREACH(prtn, prtn_hash + guest_id % PRTN_HASH_SIZE, hash_link)
 		if (!prtn->shutting_down && prtn->id == guest_id)
 			return prtn;
 
@@ -444,6 +607,7 @@ void virt_put_guest(struct guest_partition *prtn)
 
 		exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
 		LIST_REMOVE(prtn, link);
+		unhash_prtn(prtn);
 		if (prtn_have_remaining_resources(prtn)) {
 			LIST_INSERT_HEAD(&prtn_destroy_list, prtn, link);
 			/*
@@ -460,6 +624,7 @@ void virt_put_guest(struct guest_partition *prtn)
 		prtn->tee_ram = NULL;
 		tee_mm_free(prtn->ta_ram);
 		prtn->ta_ram = NULL;
+		free_ta_mem(prtn);
 		tee_mm_free(prtn->tables);
 		prtn->tables = NULL;
 		core_free_mmu_prtn(prtn->mmu_prtn);
@@ -565,46 +730,50 @@ struct memory_map *virt_get_memory_map(void)
 }
 
 #ifdef CFG_CORE_SEL1_SPMC
-static int find_cookie(struct guest_partition *prtn, uint64_t cookie)
+static struct prtn_cookie_head *cookie_bucket(uint64_t cookie)
 {
-	int i = 0;
-
-	for (i = 0; i < prtn->cookie_count; i++)
-		if (prtn->cookies[i] == cookie)
-			return i;
-	return -1;
+	return cookie_hash + (cookie ^ (cookie >> 32)) % COOKIE_HASH_SIZE;
 }
 
-static struct guest_partition *find_prtn_cookie(uint64_t cookie, int *idx)
+static struct prtn_cookie *find_prtn_cookie(uint64_t cookie)
 {
-	struct guest_partition *prtn = NULL;
-	int i = 0;
+	struct prtn_cookie *pc = NULL;
 
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		i = find_cookie(prtn, cookie);
-		if (i >= 0) {
-			if (idx)
-				*idx = i;
-			return prtn;
-		}
-	}
+	LIST_FOREACH(pc, cookie_bucket(cookie), link)
+		if (pc->cookie == cookie)
+			return pc;
 
 	return NULL;
 }
 
+static void free_prtn_cookie(struct prtn_cookie *pc)
+{
+	struct guest_partition *prtn = pc->prtn;
+
+	bit_clear(prtn->cookie_bits, pc - prtn->cookies);
+	prtn->cookie_count--;
+}
+
 TEE_Result virt_add_cookie_to_current_guest(uint64_t cookie)
 {
 	TEE_Result res = TEE_ERROR_ACCESS_DENIED;
 	struct guest_partition *prtn = NULL;
+	struct prtn_cookie *pc = NULL;
 	uint32_t exceptions = 0;
+	int i = 0;
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	if (find_prtn_cookie(cookie, NULL))
+	if (find_prtn_cookie(cookie))
 		goto out;
 
 	prtn = current_partition[get_core_pos()];
-	if (prtn->cookie_count < ARRAY_SIZE(prtn->cookies)) {
-		prtn->cookies[prtn->cookie_count] = cookie;
+	bit_ffc(prtn->cookie_bits, SPMC_CORE_SEL1_MAX_SHM_COUNT, &i);
+	if (i >= 0) {
+		bit_set(prtn->cookie_bits, i);
+		pc = prtn->cookies + i;
+		pc->cookie = cookie;
+		pc->prtn = prtn;
+		LIST_INSERT_HEAD(cookie_bucket(cookie), pc, link);
 		prtn->cookie_count++;
 		res = TEE_SUCCESS;
 	}
@@ -616,30 +785,28 @@ out:
 
 void virt_remove_cookie(uint64_t cookie)
 {
-	struct guest_partition *prtn = NULL;
+	struct prtn_cookie *pc = NULL;
 	uint32_t exceptions = 0;
-	int i = 0;
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	prtn = find_prtn_cookie(cookie, &i);
-	if (prtn) {
-		memmove(prtn->cookies + i, prtn->cookies + i + 1,
-			sizeof(uint64_t) * (prtn->cookie_count - i - 1));
-		prtn->cookie_count--;
+	pc = find_prtn_cookie(cookie);
+	if (pc) {
+		LIST_REMOVE(pc, link);
+		free_prtn_cookie(pc);
 	}
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 }
 
 uint16_t virt_find_guest_by_cookie(uint64_t cookie)
 {
-	struct guest_partition *prtn = NULL;
+	struct prtn_cookie *pc = NULL;
 	uint32_t exceptions = 0;
 	uint16_t ret = 0;
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	prtn = find_prtn_cookie(cookie, NULL);
-	if (prtn)
-		ret = prtn->id;
+	pc = find_prtn_cookie(cookie);
+	if (pc)
+		ret = pc->prtn->id;
 
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
@@ -656,13 +823,11 @@ static TEE_Result reclaim_cookie(struct guest_partition *prtn, uint64_t cookie)
 	if (cookie & FFA_MEMORY_HANDLE_HYPERVISOR_BIT) {
 		size_t n = 0;
 
-		for (n = 0; n < prtn->cookie_count; n++) {
-			if (prtn->cookies[n] == cookie) {
-				memmove(prtn->cookies + n,
-					prtn->cookies + n + 1,
-					sizeof(uint64_t) *
-						(prtn->cookie_count - n - 1));
-				prtn->cookie_count--;
+		/* The cookies of a destroyed partition aren't hashed */
+		for (n = 0; n < SPMC_CORE_SEL1_MAX_SHM_COUNT; n++) {
+			if (bit_test(prtn->cookie_bits, n) &&
+			    prtn->cookies[n].cookie == cookie) {
+				free_prtn_cookie(prtn->cookies + n);
 				return TEE_SUCCESS;
 			}
 		}
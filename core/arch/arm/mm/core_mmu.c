@@ -29,8 +29,22 @@
 #define MMU_NUM_ASID_PAIRS		64
 
 static bitstr_t bit_decl(g_asid, MMU_NUM_ASID_PAIRS) __nex_bss;
+/*
+ * ASIDs released with asid_free() may still be tagging entries in the
+ * TLBs. Instead of invalidating each ASID when it's released they're
+ * recorded here and remain unavailable until all ASIDs are used up, then
+ * the TLBs are invalidated once and the recorded ASIDs become available
+ * again.
+ */
+static bitstr_t bit_decl(g_asid_stale, MMU_NUM_ASID_PAIRS) __nex_bss;
 static unsigned int g_asid_spinlock __nex_bss = SPINLOCK_UNLOCK;
 
+/*
+ * Invalidating a range of more pages than this one page at a time is
+ * more expensive than invalidating all entries of the ASID.
+ */
+#define TLBI_VA_RANGE_MAX_PAGES		64
+
 void tlbi_va_range(vaddr_t va, size_t len, size_t granule)
 {
 	assert(granule == CORE_MMU_PGDIR_SIZE || granule == SMALL_PAGE_SIZE);
@@ -51,6 +65,11 @@ void tlbi_va_range_asid(vaddr_t va, size_t len, size_t granule, uint32_t asid)
 	assert(granule == CORE_MMU_PGDIR_SIZE || granule == SMALL_PAGE_SIZE);
 	assert(!(va & (granule - 1)) && !(len & (granule - 1)));
 
+	if (len / granule > TLBI_VA_RANGE_MAX_PAGES) {
+		tlbi_asid(asid);
+		return;
+	}
+
 	dsb_ishst();
 	while (len) {
 		tlbi_va_asid_nosync(va, asid);
@@ -154,6 +173,25 @@ TEE_Result cache_op_outer(enum cache_op op, paddr_t pa, size_t len)
 }
 #endif /*CFG_PL310*/
 
+static bool recycle_stale_asids(void)
+{
+	bool found = false;
+	int n = 0;
+
+	for (n = 0; n < MMU_NUM_ASID_PAIRS; n++) {
+		if (bit_test(g_asid_stale, n)) {
+			bit_clear(g_asid_stale, n);
+			bit_clear(g_asid, n);
+			found = true;
+		}
+	}
+
+	if (found)
+		tlbi_all();
+
+	return found;
+}
+
 unsigned int asid_alloc(void)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&g_asid_spinlock);
@@ -161,6 +199,8 @@ unsigned int asid_alloc(void)
 	int i;
 
 	bit_ffc(g_asid, MMU_NUM_ASID_PAIRS, &i);
+	if (i == -1 && recycle_stale_asids())
+		bit_ffc(g_asid, MMU_NUM_ASID_PAIRS, &i);
 	if (i == -1) {
 		r = 0;
 	} else {
@@ -183,7 +223,8 @@ void asid_free(unsigned int asid)
 		int i = (asid - 1) / 2;
 
 		assert(i < MMU_NUM_ASID_PAIRS && bit_test(g_asid, i));
-		bit_clear(g_asid, i);
+		assert(!bit_test(g_asid_stale, i));
+		bit_set(g_asid_stale, i);
 	}
 
 	cpu_spin_unlock_xrestore(&g_asid_spinlock, exceptions);
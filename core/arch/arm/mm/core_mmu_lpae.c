@@ -430,6 +430,9 @@ static uint32_t desc_to_mattr(unsigned level, uint64_t desc)
 	if (desc & GP)
 		a |= TEE_MATTR_GUARDED;
 
+	if (desc & UPPER_ATTRS(CONT_HINT))
+		a |= TEE_MATTR_CONTIG;
+
 	return a;
 }
 
@@ -475,6 +478,9 @@ static uint64_t mattr_to_desc(unsigned level, uint32_t attr)
 	if (feat_bti_is_implemented() && (a & TEE_MATTR_GUARDED))
 		desc |= GP;
 
+	if ((a & TEE_MATTR_CONTIG) && level == XLAT_TABLE_LEVEL_MAX)
+		desc |= UPPER_ATTRS(CONT_HINT);
+
 	/* Keep in sync with core_mmu.c:core_mmu_mattr_is_ok */
 	switch ((a >> TEE_MATTR_MEM_TYPE_SHIFT) & TEE_MATTR_MEM_TYPE_MASK) {
 	case TEE_MATTR_MEM_TYPE_STRONGLY_O:
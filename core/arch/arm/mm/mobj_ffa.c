@@ -82,6 +82,7 @@ struct mobj_ffa {
 	struct refcount mapcount;
 	unsigned int inactive_refs;
 	uint16_t page_offset;
+	bool idle_mapped;
 #ifdef CFG_CORE_SEL1_SPMC
 	bool registered_by_cookie;
 #endif
@@ -112,6 +113,12 @@ static struct mobj_ffa_head shm_inactive_head =
 
 static unsigned int shm_lock = SPINLOCK_UNLOCK;
 
+/*
+ * Number of mobjs kept mapped while unused, protected by shm_lock. Only
+ * used with CFG_CORE_FFA_SHM_MAP_CACHE_ENTRIES > 0.
+ */
+static unsigned int idle_map_count;
+
 static const struct mobj_ops mobj_ffa_ops;
 
 static struct mobj_ffa *to_mobj_ffa(struct mobj *mobj)
@@ -358,6 +365,41 @@ static void unmap_helper(struct mobj_ffa *mf)
 	}
 }
 
+/* Unmaps a mobj kept mapped while unused, called with shm_lock held */
+static void unmap_idle(struct mobj_ffa *mf)
+{
+	if (mf->idle_mapped) {
+		assert(idle_map_count);
+		idle_map_count--;
+		mf->idle_mapped = false;
+		unmap_helper(mf);
+	}
+}
+
+/*
+ * Unmaps one mobj among those kept mapped while unused, called with
+ * shm_lock held. Returns false if there was none.
+ */
+static bool evict_idle_mapping(void)
+{
+	struct mobj_ffa *mf = NULL;
+
+	SLIST_FOREACH(mf, &shm_inactive_head, link) {
+		if (mf->idle_mapped) {
+			unmap_idle(mf);
+			return true;
+		}
+	}
+	SLIST_FOREACH(mf, &shm_head, link) {
+		if (mf->idle_mapped) {
+			unmap_idle(mf);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 #ifdef CFG_CORE_SEL1_SPMC
 TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 {
@@ -396,6 +438,7 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 
 	if (!pop_from_list(&shm_inactive_head, cmp_ptr, (vaddr_t)mf))
 		panic();
+	unmap_idle(mf);
 	res = TEE_SUCCESS;
 out:
 	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
@@ -462,6 +505,7 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 		goto out;
 	}
 	mf = pop_from_list(&shm_inactive_head, cmp_cookie, cookie);
+	unmap_idle(mf);
 	mobj_ffa_spmc_delete(mf);
 	thread_spmc_relinquish(cookie);
 #endif
@@ -634,7 +678,9 @@ static void ffa_inactivate(struct mobj *mobj)
 	 * At this point the mobj is in the inactive list.
 	 */
 	if (pop_from_list(&shm_head, cmp_ptr, (vaddr_t)mf)) {
-		unmap_helper(mf);
+		/* An idle mapping is kept until evicted or reclaimed */
+		if (!mf->idle_mapped)
+			unmap_helper(mf);
 		SLIST_INSERT_HEAD(&shm_inactive_head, mf, link);
 	}
 out:
@@ -692,9 +738,16 @@ static TEE_Result ffa_inc_map(struct mobj *mobj)
 	 * If we have beated another thread calling ffa_dec_map()
 	 * to get the lock we need only to reinitialize mapcount to 1.
 	 */
-	if (!mf->mm) {
+	if (mf->idle_mapped) {
+		/* Kept mapped since last use */
+		assert(idle_map_count);
+		idle_map_count--;
+		mf->idle_mapped = false;
+	} else if (!mf->mm) {
 		sz = ROUNDUP(mobj->size + mf->page_offset, SMALL_PAGE_SIZE);
 		mf->mm = tee_mm_alloc(&core_virt_shm_pool, sz);
+		while (!mf->mm && evict_idle_mapping())
+			mf->mm = tee_mm_alloc(&core_virt_shm_pool, sz);
 		if (!mf->mm) {
 			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto out;
@@ -726,8 +779,21 @@ static TEE_Result ffa_dec_map(struct mobj *mobj)
 		return TEE_SUCCESS;
 
 	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	if (!refcount_val(&mf->mapcount))
-		unmap_helper(mf);
+	if (!refcount_val(&mf->mapcount) && mf->mm) {
+		if (CFG_CORE_FFA_SHM_MAP_CACHE_ENTRIES) {
+			/*
+			 * Keep the mapping for the next time the same
+			 * shared memory is used, unmapping another idle
+			 * mapping if there are too many.
+			 */
+			mf->idle_mapped = true;
+			idle_map_count++;
+			if (idle_map_count > CFG_CORE_FFA_SHM_MAP_CACHE_ENTRIES)
+				evict_idle_mapping();
+		} else {
+			unmap_helper(mf);
+		}
+	}
 	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
 
 	return TEE_SUCCESS;
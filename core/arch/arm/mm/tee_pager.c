@@ -38,11 +38,14 @@ static struct vm_paged_region_head core_vm_regions =
 #define INVALID_PGIDX		UINT_MAX
 #define PMEM_FLAG_DIRTY		BIT(0)
 #define PMEM_FLAG_HIDDEN	BIT(1)
+#define PMEM_FLAG_READ_AHEAD	BIT(2)
 
 /*
  * struct tee_pager_pmem - Represents a physical page used for paging.
  *
  * @flags	flags defined by PMEM_FLAG_* above
+ * @refs	saturating count of accesses seen through hidden page faults,
+ *		only used with CFG_PAGER_FREQ_REPLACEMENT=y
  * @fobj_pgidx	index of the page in the @fobj
  * @fobj	File object of which a page is made visible.
  * @va_alias	Virtual address where the physical page always is aliased.
@@ -51,6 +54,7 @@ static struct vm_paged_region_head core_vm_regions =
  */
 struct tee_pager_pmem {
 	unsigned int flags;
+	unsigned int refs;
 	unsigned int fobj_pgidx;
 	struct fobj *fobj;
 	void *va_alias;
@@ -77,6 +81,24 @@ static struct tee_pager_pmem_head tee_pager_lock_pmem_head =
 /* Number of registered physical pages, used hiding pages. */
 static size_t tee_pager_npages;
 
+/*
+ * Recently evicted pages, a page loaded again while still in this list is
+ * counted as a refault. With CFG_PAGER_FREQ_REPLACEMENT=y a refaulted page
+ * also starts with a reference to protect it from the next eviction.
+ */
+#define PAGER_GHOST_ENTRIES	32
+
+struct pager_ghost {
+	struct fobj *fobj;
+	unsigned int fobj_pgidx;
+};
+
+static struct pager_ghost pager_ghosts[PAGER_GHOST_ENTRIES];
+static size_t pager_ghost_next;
+
+/* Maximum of struct tee_pager_pmem::refs */
+#define PMEM_MAX_REFS		3
+
 /* This area covers the IVs for all fobjs with paged IVs */
 static struct vm_paged_region *pager_iv_region;
 /* Used by make_iv_available(), see make_iv_available() for details. */
@@ -115,6 +137,26 @@ static inline void set_npages(void)
 	pager_stats.npages = tee_pager_npages;
 }
 
+static inline void incr_read_ahead_pages(void)
+{
+	pager_stats.read_ahead_pages++;
+}
+
+static inline void incr_read_ahead_hits(void)
+{
+	pager_stats.read_ahead_hits++;
+}
+
+static inline void incr_evictions(void)
+{
+	pager_stats.evictions++;
+}
+
+static inline void incr_refaults(void)
+{
+	pager_stats.refaults++;
+}
+
 void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
 	*stats = pager_stats;
@@ -123,6 +165,10 @@ void tee_pager_get_stats(struct tee_pager_stats *stats)
 	pager_stats.ro_hits = 0;
 	pager_stats.rw_hits = 0;
 	pager_stats.zi_released = 0;
+	pager_stats.read_ahead_pages = 0;
+	pager_stats.read_ahead_hits = 0;
+	pager_stats.evictions = 0;
+	pager_stats.refaults = 0;
 }
 
 #else /* CFG_WITH_STATS */
@@ -132,6 +178,10 @@ static inline void incr_hidden_hits(void) { }
 static inline void incr_zi_released(void) { }
 static inline void incr_npages_all(void) { }
 static inline void set_npages(void) { }
+static inline void incr_read_ahead_pages(void) { }
+static inline void incr_read_ahead_hits(void) { }
+static inline void incr_evictions(void) { }
+static inline void incr_refaults(void) { }
 
 void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
@@ -500,6 +550,7 @@ static void pmem_clear(struct tee_pager_pmem *pmem)
 	pmem->fobj = NULL;
 	pmem->fobj_pgidx = INVALID_PGIDX;
 	pmem->flags = 0;
+	pmem->refs = 0;
 }
 
 static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
@@ -1054,7 +1105,8 @@ void tee_pager_rem_um_region(struct user_mode_ctx *uctx, vaddr_t base,
 			free_region(reg);
 		}
 	}
-	tlbi_asid(uctx->vm_info.asid);
+	tlbi_va_range_asid(ROUNDDOWN(base, SMALL_PAGE_SIZE), s,
+			   SMALL_PAGE_SIZE, uctx->vm_info.asid);
 }
 
 void tee_pager_rem_um_regions(struct user_mode_ctx *uctx)
@@ -1255,7 +1307,11 @@ static bool tee_pager_unhide_page(struct vm_paged_region *reg, vaddr_t page_va)
 		a &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
 
 	pa = get_pmem_pa(pmem);
-	pmem->flags &= ~PMEM_FLAG_HIDDEN;
+	if (pmem->flags & PMEM_FLAG_READ_AHEAD)
+		incr_read_ahead_hits();
+	if (pmem->refs < PMEM_MAX_REFS)
+		pmem->refs++;
+	pmem->flags &= ~(PMEM_FLAG_HIDDEN | PMEM_FLAG_READ_AHEAD);
 	if (reg->flags & TEE_MATTR_UX) {
 		void *va = (void *)tblidx2va(tblidx);
 
@@ -1545,10 +1601,69 @@ static void make_iv_available(struct fobj *fobj, unsigned int fobj_pgidx,
 	}
 }
 
-static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
-			   bool clean_user_cache)
+static void ghost_add(struct tee_pager_pmem *pmem)
+{
+	pager_ghosts[pager_ghost_next] = (struct pager_ghost){
+		.fobj = pmem->fobj,
+		.fobj_pgidx = pmem->fobj_pgidx,
+	};
+	pager_ghost_next = (pager_ghost_next + 1) % PAGER_GHOST_ENTRIES;
+	incr_evictions();
+}
+
+static bool ghost_remove(struct tee_pager_pmem *pmem)
+{
+	size_t n = 0;
+
+	for (n = 0; n < PAGER_GHOST_ENTRIES; n++) {
+		if (pager_ghosts[n].fobj == pmem->fobj &&
+		    pager_ghosts[n].fobj_pgidx == pmem->fobj_pgidx) {
+			pager_ghosts[n].fobj = NULL;
+			incr_refaults();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Returns the pmem to reuse for a new page. Without
+ * CFG_PAGER_FREQ_REPLACEMENT it's the least recently used one. With it
+ * the pages are scanned from the least recently used one, like a CLOCK,
+ * and those found referenced lose one reference and get another round.
+ * Since references are counted, pages used often survive several rounds
+ * while pages used once are evicted first.
+ */
+static struct tee_pager_pmem *pager_select_victim(void)
+{
+	struct tee_pager_pmem *pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	size_t n = 0;
+
+	if (!IS_ENABLED(CFG_PAGER_FREQ_REPLACEMENT))
+		return pmem;
+
+	for (n = 0; pmem && pmem->refs && n < tee_pager_npages; n++) {
+		pmem->refs--;
+		TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
+		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	}
+
+	return pmem;
+}
+
+/*
+ * Loads and maps the page at @page_va, a write fault is assumed if
+ * @write_fault. Returns the pmem holding the page or NULL if the page
+ * was made available as a side effect of making an IV available.
+ */
+static struct tee_pager_pmem *pager_get_page(struct vm_paged_region *reg,
+					     struct abort_info *ai,
+					     vaddr_t page_va,
+					     bool clean_user_cache,
+					     bool write_fault)
 {
-	vaddr_t page_va = ai->va & ~SMALL_PAGE_MASK;
 	struct tblidx tblidx = region_va2tblidx(reg, page_va);
 	struct tee_pager_pmem *pmem = NULL;
 	bool writable = false;
@@ -1559,7 +1674,7 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 	 * the corresponding IV page is available.
 	 */
 	while (true) {
-		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+		pmem = pager_select_victim();
 		if (!pmem) {
 			EMSG("No pmem entries");
 			abort_print(ai);
@@ -1567,6 +1682,7 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 		}
 
 		if (pmem->fobj) {
+			ghost_add(pmem);
 			pmem_unmap(pmem, NULL);
 			if (pmem_is_dirty(pmem)) {
 				uint8_t *va = pmem->va_alias;
@@ -1604,7 +1720,7 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 				 */
 				tblidx_get_entry(tblidx, NULL, &attr);
 				if (attr & TEE_MATTR_VALID_BLOCK)
-					return;
+					return NULL;
 
 				/*
 				 * The freed pmem was used to replace the
@@ -1620,6 +1736,9 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 		pmem_clear(pmem);
 
 		pmem_assign_fobj_page(pmem, reg, page_va);
+		if (ghost_remove(pmem) &&
+		    IS_ENABLED(CFG_PAGER_FREQ_REPLACEMENT))
+			pmem->refs = 1;
 		make_iv_available(pmem->fobj, pmem->fobj_pgidx,
 				  false /*!writable*/);
 		if (!IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV) || pager_spare_pmem)
@@ -1645,14 +1764,85 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 	 * as dirty.
 	 */
 	if (reg->type == PAGED_REGION_TYPE_LOCK ||
-	    (reg->type == PAGED_REGION_TYPE_RW && abort_is_write_fault(ai)))
+	    (reg->type == PAGED_REGION_TYPE_RW && write_fault))
 		writable = true;
 	else
 		writable = false;
 
 	pager_deploy_page(pmem, reg, page_va, clean_user_cache, writable);
+
+	return pmem;
 }
 
+#if CFG_PAGER_READ_AHEAD_PAGES
+/* Last faulting page, used to detect sequential faults */
+static vaddr_t pager_last_fault_va;
+
+/*
+ * Loads the CFG_PAGER_READ_AHEAD_PAGES pages following @page_va in @reg
+ * which aren't loaded yet. The pages are left hidden so the first access
+ * to one of them is resolved by tee_pager_unhide_page(), which also
+ * accounts it as a read-ahead hit.
+ */
+static void pager_read_ahead(struct vm_paged_region *reg,
+			     struct abort_info *ai, vaddr_t page_va,
+			     bool clean_user_cache)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	struct tblidx tblidx = { };
+	uint32_t attr = 0;
+	vaddr_t va = 0;
+	size_t n = 0;
+
+	/* Locked pages are never released, only load those really used */
+	if (reg->type == PAGED_REGION_TYPE_LOCK)
+		return;
+	/* Don't let read-ahead evict more than the hidden pages */
+	if (CFG_PAGER_READ_AHEAD_PAGES > TEE_PAGER_NHIDE)
+		return;
+
+	for (n = 1; n <= CFG_PAGER_READ_AHEAD_PAGES; n++) {
+		va = page_va + n * SMALL_PAGE_SIZE;
+		if (va >= reg->base + reg->size)
+			break;
+
+		tblidx = region_va2tblidx(reg, va);
+		if (!tblidx.pgt)
+			break;
+		tblidx_get_entry(tblidx, NULL, &attr);
+		if ((attr & TEE_MATTR_VALID_BLOCK) || pmem_find(reg, va))
+			continue;
+
+		pmem = pager_get_page(reg, ai, va, clean_user_cache,
+				      false /*!write_fault*/);
+		if (!pmem)
+			continue;
+
+		pmem_unmap(pmem, NULL);
+		pmem->flags |= PMEM_FLAG_HIDDEN | PMEM_FLAG_READ_AHEAD;
+		incr_read_ahead_pages();
+	}
+}
+
+static void pager_check_read_ahead(struct vm_paged_region *reg,
+				   struct abort_info *ai, vaddr_t page_va,
+				   bool clean_user_cache)
+{
+	bool sequential = page_va == pager_last_fault_va + SMALL_PAGE_SIZE;
+
+	pager_last_fault_va = page_va;
+	if (sequential)
+		pager_read_ahead(reg, ai, page_va, clean_user_cache);
+}
+#else
+static void pager_check_read_ahead(struct vm_paged_region *reg __unused,
+				   struct abort_info *ai __unused,
+				   vaddr_t page_va __unused,
+				   bool clean_user_cache __unused)
+{
+}
+#endif
+
 static bool pager_update_permissions(struct vm_paged_region *reg,
 				     struct abort_info *ai, bool *handled)
 {
@@ -1796,8 +1986,10 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 		goto out;
 	}
 
-	if (tee_pager_unhide_page(reg, page_va))
+	if (tee_pager_unhide_page(reg, page_va)) {
+		pager_check_read_ahead(reg, ai, page_va, clean_user_cache);
 		goto out_success;
+	}
 
 	/*
 	 * The page wasn't hidden, but some other core may have
@@ -1813,7 +2005,9 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 		goto out;
 	}
 
-	pager_get_page(reg, ai, clean_user_cache);
+	pager_get_page(reg, ai, page_va, clean_user_cache,
+		       abort_is_write_fault(ai));
+	pager_check_read_ahead(reg, ai, page_va, clean_user_cache);
 
 out_success:
 	tee_pager_hide_pages();
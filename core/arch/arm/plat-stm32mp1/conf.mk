@@ -255,6 +255,21 @@ ifneq ($(CFG_WITH_SOFTWARE_PRNG),y)
 $(call force,CFG_STM32_RNG,y,Required by HW RNG when CFG_WITH_SOFTWARE_PRNG=n)
 endif
 
+# Keep the RNG clocked until no request came for CFG_STM32_RNG_KEEP_WARM_MS
+# milliseconds and serve small requests from the FIFO data left over by the
+# previous one
+CFG_STM32_RNG_KEEP_WARM ?= n
+CFG_STM32_RNG_KEEP_WARM_MS ?= 10
+ifeq ($(CFG_STM32_RNG_KEEP_WARM),y)
+$(call force,CFG_CALLOUT,y,Required by CFG_STM32_RNG_KEEP_WARM)
+endif
+
+# Read CFG_STM32_RNG_RESUME_POOL_SIZE bytes from the RNG at suspend to serve
+# the first requests after resume while the RNG completes its conditioning
+# reset, instead of waiting for it in the resume sequence
+CFG_STM32_RNG_RESUME_POOL ?= n
+CFG_STM32_RNG_RESUME_POOL_SIZE ?= 64
+
 ifeq ($(CFG_STPMIC1),y)
 $(call force,CFG_STM32_I2C,y)
 $(call force,CFG_STM32_GPIO,y)
@@ -92,6 +92,28 @@ $(call force,CFG_WITH_SOFTWARE_PRNG,n,Required by CFG_HWRNG_PTA)
 CFG_HWRNG_QUALITY ?= 1024
 endif
 
+# Keep the RNG clocked until no request came for CFG_STM32_RNG_KEEP_WARM_MS
+# milliseconds and serve small requests from the FIFO data left over by the
+# previous one
+CFG_STM32_RNG_KEEP_WARM ?= n
+CFG_STM32_RNG_KEEP_WARM_MS ?= 10
+ifeq ($(CFG_STM32_RNG_KEEP_WARM),y)
+$(call force,CFG_CALLOUT,y,Required by CFG_STM32_RNG_KEEP_WARM)
+endif
+
+# Read CFG_STM32_RNG_RESUME_POOL_SIZE bytes from the RNG at suspend to serve
+# the first requests after resume while the RNG completes its conditioning
+# reset, instead of waiting for it in the resume sequence
+CFG_STM32_RNG_RESUME_POOL ?= n
+CFG_STM32_RNG_RESUME_POOL_SIZE ?= 64
+
+# Channel of the first probed HPDMA instance reserved to memory to memory
+# copies done by the core with dma_memcpy(), -1 to do them with the CPU
+CFG_STM32_HPDMA_MEMCPY_CHANNEL ?= -1
+ifneq ($(CFG_STM32_HPDMA_MEMCPY_CHANNEL),-1)
+$(call force,CFG_DRIVERS_DMA,y,Required by CFG_STM32_HPDMA_MEMCPY_CHANNEL)
+endif
+
 # Enable reset control
 ifeq ($(CFG_STM32MP25_RSTCTRL),y)
 $(call force,CFG_DRIVERS_RSTCTRL,y)
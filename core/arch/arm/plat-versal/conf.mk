@@ -81,6 +81,9 @@ $(call force, CFG_WITH_SOFTWARE_PRNG,n)
 
 ifeq ($(PLATFORM_FLAVOR),net)
 $(call force,CFG_VERSAL_RNG_PLM,y)
+# Maximum number of bytes requested from the PLM in a single IPI, raise it
+# for PLM firmware accepting larger TRNG generate requests
+CFG_VERSAL_RNG_PLM_MAX_REQ ?= 32
 endif
 
 # TRNG configuration
@@ -88,6 +91,70 @@ CFG_VERSAL_TRNG_SEED_LIFE ?= 3
 CFG_VERSAL_TRNG_DF_MUL ?= 2
 CFG_VERSAL_TRNGPSX := y
 
+# Reseed policy of the HRNG instance on top of the seed life above, which
+# counts 32 bytes generate blocks. CFG_VERSAL_TRNG_RESEED_PER_REQUEST=y
+# reseeds once before each request, giving prediction resistance per
+# request, and CFG_VERSAL_TRNG_RESEED_BYTES reseeds after that many bytes,
+# 0 disables it. The seed life still bounds the blocks per seed, raise
+# CFG_VERSAL_TRNG_SEED_LIFE when using them. With CFG_VERSAL_TRNG_RING=y
+# the reseed is done ahead of time from the callout.
+CFG_VERSAL_TRNG_RESEED_PER_REQUEST ?= n
+CFG_VERSAL_TRNG_RESEED_BYTES ?= 0
+
+# Run the TRNG derivation function through the crypto API, using the ARMv8
+# Crypto Extensions with CFG_CRYPTO_WITH_CE=y, instead of the byte-oriented
+# software AES of the driver
+CFG_VERSAL_TRNG_DF_CRYPTO ?= n
+
+# Estimate the min-entropy of the raw TRNG output online, NIST SP 800-90B
+# most common value estimate over 64 KiB windows, and set the DF multiplier
+# to the lowest value giving each DF output enough input entropy, never
+# below CFG_VERSAL_TRNG_ADAPTIVE_DF_MIN. Applies where the driver sees the
+# raw output: PTRNG mode requests and software DF reseeds. Only lower the
+# floor below CFG_VERSAL_TRNG_DF_MUL if the source is certified for it.
+CFG_VERSAL_TRNG_ADAPTIVE_DF ?= n
+CFG_VERSAL_TRNG_ADAPTIVE_DF_MIN ?= $(CFG_VERSAL_TRNG_DF_MUL)
+
+# Pre-generated TRNG output ring topped up from the callout service so that
+# reads don't wait for the hardware unless the ring runs empty. With
+# CFG_CORE_WORKQUEUE=y the callout only queues the refill to a bottom half
+# thread, otherwise it refills one 32 byte chunk per timer interrupt.
+CFG_VERSAL_TRNG_RING ?= n
+ifeq ($(CFG_VERSAL_TRNG_RING),y)
+$(call force,CFG_CALLOUT,y,required by CFG_VERSAL_TRNG_RING)
+CFG_VERSAL_TRNG_RING_SIZE ?= 1024
+endif
+
+# Serve the requests of a TRNG instance in PTRNG mode from a CTR_DRBG seeded
+# with the conditioned PTRNG output, reseeded every
+# CFG_VERSAL_TRNG_PTRNG_DRBG_RESEED_BYTES bytes, instead of running the DF
+# for every 32 bytes of output
+CFG_VERSAL_TRNG_PTRNG_DRBG ?= n
+ifeq ($(CFG_VERSAL_TRNG_PTRNG_DRBG),y)
+$(call force,CFG_CORE_CTR_DRBG,y,Required by CFG_VERSAL_TRNG_PTRNG_DRBG)
+CFG_VERSAL_TRNG_PTRNG_DRBG_RESEED_BYTES ?= 1048576
+endif
+
+# Pseudo TA giving each user TA session its own random stream, a CTR_DRBG
+# seeded from the TRNG with a per-stream personalization string and
+# reseeded every CFG_VERSAL_TRNG_PTA_RESEED_BYTES bytes unless the stream
+# asks for another interval
+CFG_VERSAL_TRNG_PTA ?= n
+ifeq ($(CFG_VERSAL_TRNG_PTA),y)
+$(call force,CFG_CORE_CTR_DRBG,y,Required by CFG_VERSAL_TRNG_PTA)
+CFG_VERSAL_TRNG_PTA_RESEED_BYTES ?= 1048576
+endif
+
+# Run synchronous TRNG requests with foreign interrupts unmasked so that the
+# normal world can preempt the thread while it waits for the TRNG to collect
+# entropy, instead of the core staying in the secure world for the request
+CFG_VERSAL_TRNG_PREEMPTIBLE ?= n
+
+# Only run the TRNG known answer test at boot and leave the health test,
+# instantiation and first reseed to the first request, which blocks until
+# they are done
+CFG_VERSAL_TRNG_LAZY_INIT ?= n
+
 # eFuse and BBRAM driver
 ifeq ($(PLATFORM_FLAVOR),net)
 $(call force, CFG_VERSAL_NET_NVM,y)
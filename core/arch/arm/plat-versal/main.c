@@ -11,8 +11,10 @@
 #include <drivers/versal_pm.h>
 #include <io.h>
 #include <kernel/boot.h>
+#include <kernel/interrupt.h>
 #include <kernel/misc.h>
 #include <kernel/tee_time.h>
+#include <kernel/timer.h>
 #include <mm/core_memprot.h>
 #include <platform_config.h>
 #include <stdint.h>
@@ -58,6 +60,17 @@ void plat_console_init(void)
 	register_serial_console(&console_data.chip);
 }
 
+#if defined(CFG_CALLOUT)
+static TEE_Result init_callout_service(void)
+{
+	timer_init_callout_service(interrupt_get_main_chip(), IT_SEC_PHY_TIMER);
+
+	return TEE_SUCCESS;
+}
+
+nex_early_init(init_callout_service);
+#endif
+
 static TEE_Result platform_banner(void)
 {
 	vaddr_t plm_rtca = (vaddr_t)phys_to_virt(PLM_RTCA, MEM_AREA_IO_SEC,
@@ -15,6 +15,8 @@
 #define PLM_RTCA		0xF2014000
 #define PLM_RTCA_LEN		0x1000
 
+#define IT_SEC_PHY_TIMER	29
+
 #if defined(PLATFORM_FLAVOR_generic)
 
 #define GIC_BASE		0xF9000000
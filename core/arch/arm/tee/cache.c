@@ -55,3 +55,94 @@ TEE_Result cache_operation(enum utee_cache_operation op, void *va, size_t len)
 		return TEE_ERROR_NOT_SUPPORTED;
 	}
 }
+
+void dma_buf_init(struct dma_buf *db, void *va, size_t len,
+		  enum dma_buf_dir dir)
+{
+	*db = (struct dma_buf){
+		.va = va,
+		.len = len,
+		.dir = dir,
+		.cpu_dirty = true,
+	};
+}
+
+/*
+ * Set/way operations only reach the caches of the calling CPU, they can
+ * replace the maintenance by address only when there is a single core.
+ * A threshold of 0 disables them.
+ */
+#if CFG_DMA_BUF_FULL_CACHE_THRESHOLD && CFG_TEE_CORE_NB_CORE == 1
+static bool use_full_cache_op(size_t len)
+{
+	return len >= CFG_DMA_BUF_FULL_CACHE_THRESHOLD;
+}
+#else
+static bool use_full_cache_op(size_t len __unused)
+{
+	return false;
+}
+#endif
+
+static TEE_Result dma_buf_clean(struct dma_buf *db, bool inv)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!use_full_cache_op(db->len))
+		return cache_operation(inv ? TEE_CACHEFLUSH : TEE_CACHECLEAN,
+				       db->va, db->len);
+
+	if (!inv) {
+		res = cache_op_inner(DCACHE_CLEAN, NULL, 0);
+		if (res)
+			return res;
+		return cache_op_outer(DCACHE_CLEAN, 0, 0);
+	}
+
+#ifdef CFG_PL310
+	res = cache_op_inner(DCACHE_CLEAN, NULL, 0);
+	if (res)
+		return res;
+	res = cache_op_outer(DCACHE_CLEAN_INV, 0, 0);
+	if (res)
+		return res;
+#endif
+	return cache_op_inner(DCACHE_CLEAN_INV, NULL, 0);
+}
+
+TEE_Result dma_buf_to_device(struct dma_buf *db)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (db->dev_owned)
+		return TEE_SUCCESS;
+
+	/* Lines only read by the CPU can't be written back over the DMA */
+	if (db->cpu_dirty) {
+		res = dma_buf_clean(db, db->dir != DMA_BUF_TO_DEVICE);
+		if (res)
+			return res;
+		db->cpu_dirty = false;
+	}
+	db->dev_owned = true;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result dma_buf_to_cpu(struct dma_buf *db)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!db->dev_owned)
+		return TEE_SUCCESS;
+
+	/* Lines may have been fetched speculatively while the device wrote */
+	if (db->dir != DMA_BUF_TO_DEVICE) {
+		res = cache_operation(TEE_CACHEINVALIDATE, db->va, db->len);
+		if (res)
+			return res;
+	}
+	db->dev_owned = false;
+
+	return TEE_SUCCESS;
+}
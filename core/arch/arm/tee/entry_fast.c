@@ -97,7 +97,8 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 #if defined(CFG_CORE_DYN_SHM)
 	dyn_shm_en = core_mmu_nsec_ddr_is_defined();
 	if (dyn_shm_en)
-		args->a1 |= OPTEE_SMC_SEC_CAP_DYNAMIC_SHM;
+		args->a1 |= OPTEE_SMC_SEC_CAP_DYNAMIC_SHM |
+			    OPTEE_SMC_SEC_CAP_SHM_EXTENTS;
 #endif
 	IMSG("Dynamic shared memory is %sabled", dyn_shm_en ? "en" : "dis");
 
@@ -120,6 +121,12 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 
 	if (IS_ENABLED(CFG_RPMB_ANNOUNCE_PROBE_CAP))
 		args->a1 |= OPTEE_SMC_SEC_CAP_RPMB_PROBE;
+
+	if (IS_ENABLED(CFG_CORE_INVOKE_BATCH))
+		args->a1 |= OPTEE_SMC_SEC_CAP_INVOKE_BATCH;
+
+	if (IS_ENABLED(CFG_CORE_ASYNC_INVOKE))
+		args->a1 |= OPTEE_SMC_SEC_CAP_INVOKE_ASYNC;
 }
 
 static void tee_entry_disable_shm_cache(struct thread_smc_args *args)
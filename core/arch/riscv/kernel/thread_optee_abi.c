@@ -168,7 +168,15 @@ static uint32_t call_entry_std(struct optee_msg_arg *arg, size_t num_params,
 	else
 		rv = OPTEE_ABI_RETURN_OK;
 
-	thread_rpc_shm_cache_clear(&thr->shm_cache);
+	/*
+	 * With the prealloc RPC cache enabled, kernel private payload
+	 * buffers are kept for the next call on this thread, saving an
+	 * allocate/free RPC pair for each of them.
+	 */
+	if (IS_ENABLED(CFG_PREALLOC_RPC_CACHE) && thread_prealloc_rpc_cache)
+		thread_rpc_shm_cache_trim(&thr->shm_cache);
+	else
+		thread_rpc_shm_cache_clear(&thr->shm_cache);
 	if (rpc_arg)
 		thr->rpc_arg = NULL;
 
@@ -321,6 +329,9 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 
 	if (IS_ENABLED(CFG_PREALLOC_RPC_CACHE)) {
 		for (n = 0; n < CFG_NUM_THREADS; n++) {
+			struct thread_shm_cache *c = &threads[n].shm_cache;
+			struct mobj *mobj = NULL;
+
 			if (threads[n].rpc_arg) {
 				*cookie = mobj_get_cookie(threads[n].rpc_mobj);
 				mobj_put(threads[n].rpc_mobj);
@@ -328,6 +339,13 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 				threads[n].rpc_mobj = NULL;
 				goto out;
 			}
+
+			mobj = thread_rpc_shm_cache_pop_kernel(c);
+			if (mobj) {
+				*cookie = mobj_get_cookie(mobj);
+				mobj_put(mobj);
+				goto out;
+			}
 		}
 	}
 
@@ -559,6 +577,15 @@ static uint32_t get_rpc_arg_res(struct optee_msg_arg *arg, size_t num_params,
 	return arg->ret;
 }
 
+void thread_rpc_yield(void)
+{
+	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = {
+		OPTEE_ABI_RETURN_RPC_FOREIGN_INTR
+	};
+
+	thread_rpc(rpc_args);
+}
+
 uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 			struct thread_param *params)
 {
@@ -451,6 +451,7 @@ void asid_free(unsigned int asid)
 		int i = asid - 1;
 
 		assert(i < RISCV_MMU_ASID_WIDTH && bit_test(g_asid, i));
+		tlbi_asid(asid);
 		bit_clear(g_asid, i);
 	}
 
@@ -70,6 +70,11 @@ ifeq ($(CFG_RISCV_WITH_M_MODE_SM),y)
 $(call force,CFG_RISCV_SBI,y)
 endif
 
+# 'y' to hash the Zkr seed CSR samples with SHA-256, two bytes of samples
+# per output byte, instead of returning them as is from hw_get_random_bytes().
+# Requests made before the crypto API is initialized get the raw samples.
+CFG_RISCV_ZKR_RNG_CONDITIONED ?= n
+
 # Disable unsupported and other arch-specific flags
 $(call force,CFG_CORE_FFA,n)
 $(call force,CFG_SECURE_PARTITION,n)
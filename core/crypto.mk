@@ -59,11 +59,22 @@ CFG_CRYPTO_RSA ?= y
 CFG_CRYPTO_DH ?= y
 # ECC includes ECDSA and ECDH
 CFG_CRYPTO_ECC ?= y
+# Precomputed tables for multiplications by the P-256 and P-384 generators,
+# speeds up ECC key generation and ECDSA signing
+CFG_CRYPTO_ECC_FIXED_BASE ?= y
 CFG_CRYPTO_SM2_PKE ?= y
 CFG_CRYPTO_SM2_DSA ?= y
 CFG_CRYPTO_SM2_KEP ?= y
 CFG_CRYPTO_ED25519 ?= y
 CFG_CRYPTO_X25519 ?= y
+# Field arithmetic of Ed25519 and X25519 in radix 2^51 instead of the
+# portable 16-bit limbs, requires a 64-bit core for the 128-bit products
+CFG_CRYPTO_CURVE25519_FE51 ?= $(CFG_ARM64_core)
+ifeq ($(CFG_CRYPTO_CURVE25519_FE51),y)
+ifneq ($(CFG_ARM64_core),y)
+$(error CFG_CRYPTO_CURVE25519_FE51=y requires CFG_ARM64_core=y)
+endif
+endif
 
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
@@ -79,6 +90,50 @@ endif
 # Otherwise, you need to implement hw_get_random_bytes() for your platform
 CFG_WITH_SOFTWARE_PRNG ?= y
 
+# CFG_CORE_RNG_PCPU_CACHE, when enabled, serves small crypto_rng_read()
+# requests from a per-core buffer refilled in bulk from the PRNG or the
+# hardware RNG, avoiding contention on the global RNG state.
+# CFG_CORE_RNG_PCPU_CACHE_SIZE is the size in bytes of each per-core buffer,
+# requests larger than a quarter of it bypass the cache.
+CFG_CORE_RNG_PCPU_CACHE ?= n
+CFG_CORE_RNG_PCPU_CACHE_SIZE ?= 256
+
+# CFG_CORE_RNG_STATS, when enabled, records statistics on crypto_rng_read()
+# calls and on the drivers behind it, reported by STATS_CMD_RNG_STATS of
+# the stats PTA.
+CFG_CORE_RNG_STATS ?= n
+
+# CFG_CORE_RNG_SOURCES, when enabled, provides hw_get_random_bytes() on top
+# of a registry of entropy sources, see <crypto/rng_source.h>, so that a
+# platform can combine e.g. a local TRNG with a firmware one and fail over
+# between them. Drivers then register instead of providing the function.
+CFG_CORE_RNG_SOURCES ?= n
+
+# CFG_CORE_CTR_DRBG, when enabled, provides the AES-256 CTR_DRBG of
+# <crypto/ctr_drbg.h> for drivers which stretch the output of an entropy
+# source. Drivers needing it force it.
+CFG_CORE_CTR_DRBG ?= n
+
+# CFG_CRYPTO_CTX_POOL, when enabled, caches the cipher, AE, MAC and digest
+# contexts released by TAs for reuse by the next TEE_AllocateOperation() of
+# the same algorithm instead of freeing them. Up to
+# CFG_CRYPTO_CTX_POOL_DEPTH contexts are kept for each of at most
+# CFG_CRYPTO_CTX_POOL_ALGOS algorithms. Hits and misses are reported by
+# STATS_CMD_CRYP_POOL_STATS of the stats PTA.
+CFG_CRYPTO_CTX_POOL ?= n
+CFG_CRYPTO_CTX_POOL_DEPTH ?= 4
+CFG_CRYPTO_CTX_POOL_ALGOS ?= 8
+
+# CFG_CRYPTO_DISPATCH, when enabled, pairs the hash and cipher contexts
+# provided by a drvcrypt device with a software context and sends each
+# operation to the software implementation when its first update is shorter
+# than a per-algorithm threshold. With CFG_CRYPTO_DISPATCH_CALIBRATE the
+# thresholds are measured at boot, otherwise CFG_CRYPTO_DISPATCH_THRESHOLD
+# bytes is used.
+CFG_CRYPTO_DISPATCH ?= n
+CFG_CRYPTO_DISPATCH_THRESHOLD ?= 256
+CFG_CRYPTO_DISPATCH_CALIBRATE ?= $(CFG_CORE_HAS_GENERIC_TIMER)
+
 # Define the maximum size, in bits, for big numbers in the TEE core (privileged
 # layer).
 # This value is an upper limit for the key size in any cryptographic algorithm
@@ -108,6 +163,8 @@ CFG_CRYPTO_SM3_ARM_CE ?= $(CFG_CRYPTO_SM3)
 CFG_CORE_CRYPTO_SM3_ACCEL ?= $(CFG_CRYPTO_SM3_ARM_CE)
 
 # CFG_CRYPTO_SM4_ARM_CE defines whether we use SM4E to optimize SM4
+# If CFG_CRYPTO_SM4_ARM_AESE is enabled too, the AESE implementation is
+# selected at runtime on CPUs without the SM4 instructions.
 CFG_CRYPTO_SM4_ARM_CE ?= $(CFG_CRYPTO_SM4)
 CFG_CORE_CRYPTO_SM4_ACCEL ?= $(CFG_CRYPTO_SM4_ARM_CE)
 endif
@@ -115,6 +172,8 @@ endif
 ifeq ($(CFG_CRYPTO_WITH_CE),y)
 
 $(call force,CFG_AES_GCM_TABLE_BASED,n,conflicts with CFG_CRYPTO_WITH_CE)
+# The Crypto Extensions are always used, no runtime detection needed
+$(call force,CFG_CRYPTO_AES_GCM_CE_RUNTIME,n,conflicts with CFG_CRYPTO_WITH_CE)
 
 # CFG_HWSUPP_PMULT_64 defines whether the CPU supports polynomial multiplies
 # of 64-bit values (Aarch64: PMULL/PMULL2 with the 1Q specifier; Aarch32:
@@ -136,6 +195,17 @@ else #CFG_CRYPTO_WITH_CE
 
 CFG_AES_GCM_TABLE_BASED ?= y
 
+# CFG_CRYPTO_AES_GCM_CE_RUNTIME builds the AES-GCM implementation using the
+# AES and PMULL instructions next to the software one, the former is used
+# when ID_AA64ISAR0_EL1 reports the instructions at runtime. This allows a
+# single AArch64 image for CPUs with and without the Crypto Extensions.
+CFG_CRYPTO_AES_GCM_CE_RUNTIME ?= n
+ifeq ($(CFG_CRYPTO_AES_GCM_CE_RUNTIME),y)
+ifneq ($(CFG_ARM64_core),y)
+$(error CFG_CRYPTO_AES_GCM_CE_RUNTIME=y requires CFG_ARM64_core=y)
+endif
+endif
+
 endif #!CFG_CRYPTO_WITH_CE
 
 
@@ -185,6 +255,7 @@ $(eval $(call cryp-dep-one, DES, ECB CBC))
 $(eval $(call cryp-dep-one, SM2_PKE, ECC))
 $(eval $(call cryp-dep-one, SM2_DSA, ECC))
 $(eval $(call cryp-dep-one, SM2_KEP, ECC))
+$(eval $(call cryp-dep-one, ECC_FIXED_BASE, ECC))
 
 ###############################################################
 # libtomcrypt (LTC) specifics, phase #1
@@ -211,12 +282,12 @@ core-ltc-vars += CCM
 ifeq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
 core-ltc-vars += GCM
 endif
-core-ltc-vars += RSA DSA DH ECC
+core-ltc-vars += RSA DSA DH ECC ECC_FIXED_BASE
 core-ltc-vars += SIZE_OPTIMIZATION
 core-ltc-vars += SM2_PKE
 core-ltc-vars += SM2_DSA
 core-ltc-vars += SM2_KEP
-core-ltc-vars += ED25519 X25519
+core-ltc-vars += ED25519 X25519 CURVE25519_FE51
 # Assigned selected CFG_CRYPTO_xxx as _CFG_CORE_LTC_xxx
 $(foreach v, $(core-ltc-vars), $(eval _CFG_CORE_LTC_$(v) := $(CFG_CRYPTO_$(v))))
 _CFG_CORE_LTC_MPI := $(CFG_CORE_MBEDTLS_MPI)
@@ -246,6 +317,7 @@ _CFG_CORE_LTC_AES := $(call cfg-one-enabled, CFG_CRYPTO_XTS CFG_CRYPTO_CCM \
 _CFG_CORE_LTC_AES_ACCEL := $(CFG_CORE_CRYPTO_AES_ACCEL)
 _CFG_CORE_LTC_X25519 := $(CFG_CRYPTO_X25519)
 _CFG_CORE_LTC_ED25519 := $(CFG_CRYPTO_ED25519)
+_CFG_CORE_LTC_CURVE25519_FE51 := $(CFG_CRYPTO_CURVE25519_FE51)
 _CFG_CORE_LTC_SHA3_224 := $(CFG_CRYPTO_SHA3_224)
 _CFG_CORE_LTC_SHA3_256 := $(CFG_CRYPTO_SHA3_256)
 _CFG_CORE_LTC_SHA3_384 := $(CFG_CRYPTO_SHA3_384)
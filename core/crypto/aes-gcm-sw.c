@@ -10,8 +10,19 @@
 #include <tee_api_types.h>
 #include <types_ext.h>
 
-void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
-			      const struct internal_aes_gcm_key *ek)
+/*
+ * With CFG_CRYPTO_AES_GCM_CE_RUNTIME=y the functions below are fallbacks
+ * called from core/arch/arm/crypto/aes-gcm-ce.c when the CPU lacks the
+ * AES and PMULL instructions.
+ */
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+#define GCM_SW_FUNC(name)	internal_aes_gcm_sw_##name
+#else
+#define GCM_SW_FUNC(name)	internal_aes_gcm_##name
+#endif
+
+void GCM_SW_FUNC(set_key)(struct internal_aes_gcm_state *state,
+			  const struct internal_aes_gcm_key *ek)
 {
 #ifdef CFG_AES_GCM_TABLE_BASED
 	internal_aes_gcm_ghash_gen_tbl(&state->ghash_key, ek);
@@ -34,9 +45,9 @@ static void ghash_update_block(struct internal_aes_gcm_state *state,
 #endif
 }
 
-void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
-				   const void *head, const void *data,
-				   size_t num_blocks)
+void GCM_SW_FUNC(ghash_update)(struct internal_aes_gcm_state *state,
+				const void *head, const void *data,
+				size_t num_blocks)
 {
 	size_t n = 0;
 
@@ -57,7 +68,7 @@ static void encrypt_block(struct internal_aes_gcm_state *state,
 	void *buf_cryp = state->buf_cryp;
 
 	internal_aes_gcm_xor_block(buf_cryp, src);
-	internal_aes_gcm_ghash_update(state, buf_cryp, NULL, 0);
+	ghash_update_block(state, buf_cryp);
 	memcpy(dst, buf_cryp, sizeof(state->buf_cryp));
 
 	crypto_aes_enc_block(enc_key->data, sizeof(enc_key->data),
@@ -100,7 +111,7 @@ static void decrypt_block(struct internal_aes_gcm_state *state,
 	internal_aes_gcm_inc_ctr(state);
 
 	internal_aes_gcm_xor_block(buf_cryp, src);
-	internal_aes_gcm_ghash_update(state, src, NULL, 0);
+	ghash_update_block(state, src);
 	memcpy(dst, buf_cryp, sizeof(state->buf_cryp));
 }
 
@@ -129,10 +140,10 @@ static void decrypt_pl(struct internal_aes_gcm_state *state,
 }
 
 void
-internal_aes_gcm_update_payload_blocks(struct internal_aes_gcm_state *state,
-				       const struct internal_aes_gcm_key *ek,
-				       TEE_OperationMode m, const void *src,
-				       size_t num_blocks, void *dst)
+GCM_SW_FUNC(update_payload_blocks)(struct internal_aes_gcm_state *state,
+				   const struct internal_aes_gcm_key *ek,
+				   TEE_OperationMode m, const void *src,
+				   size_t num_blocks, void *dst)
 {
 	assert(!state->buf_pos && num_blocks);
 
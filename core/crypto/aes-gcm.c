@@ -68,6 +68,7 @@ static void ghash_update_lengths(struct internal_aes_gcm_state *state,
 
 static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 			     const struct internal_aes_gcm_key *ek,
+			     const struct internal_ghash_key *ghash_key,
 			     TEE_OperationMode mode, const void *nonce,
 			     size_t nonce_len, size_t tag_len)
 {
@@ -79,7 +80,10 @@ static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 	memset(state, 0, sizeof(*state));
 
 	state->tag_len = tag_len;
-	internal_aes_gcm_set_key(state, ek);
+	if (ghash_key)
+		state->ghash_key = *ghash_key;
+	else
+		internal_aes_gcm_set_key(state, ek);
 
 	if (nonce_len == (96 / 8)) {
 		memcpy(state->ctr, nonce, nonce_len);
@@ -134,7 +138,12 @@ TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
 	if (res)
 		return res;
 
-	return __gcm_init(&ctx->state, ek, mode, nonce, nonce_len, tag_len);
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	internal_aes_gcm_expand_ce_key(ek, key, key_len);
+#endif
+
+	return __gcm_init(&ctx->state, ek, NULL, mode, nonce, nonce_len,
+			  tag_len);
 }
 
 static TEE_Result __gcm_update_aad(struct internal_aes_gcm_state *state,
@@ -365,17 +374,18 @@ void internal_aes_gcm_dec_ctr(struct internal_aes_gcm_state *state)
 	state->ctr[1] = TEE_U64_TO_BIG_ENDIAN(c);
 }
 
-TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
-				const void *nonce, size_t nonce_len,
-				const void *aad, size_t aad_len,
-				const void *src, size_t len, void *dst,
-				void *tag, size_t *tag_len)
+static TEE_Result gcm_enc(const struct internal_aes_gcm_key *enc_key,
+			  const struct internal_ghash_key *ghash_key,
+			  const void *nonce, size_t nonce_len,
+			  const void *aad, size_t aad_len,
+			  const void *src, size_t len, void *dst,
+			  void *tag, size_t *tag_len)
 {
 	TEE_Result res;
 	struct internal_aes_gcm_state state;
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_ENCRYPT, nonce, nonce_len,
-			 *tag_len);
+	res = __gcm_init(&state, enc_key, ghash_key, TEE_MODE_ENCRYPT, nonce,
+			 nonce_len, *tag_len);
 	if (res)
 		return res;
 
@@ -388,17 +398,18 @@ TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
 	return __gcm_enc_final(&state, enc_key, src, len, dst, tag, tag_len);
 }
 
-TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
-				const void *nonce, size_t nonce_len,
-				const void *aad, size_t aad_len,
-				const void *src, size_t len, void *dst,
-				const void *tag, size_t tag_len)
+static TEE_Result gcm_dec(const struct internal_aes_gcm_key *enc_key,
+			  const struct internal_ghash_key *ghash_key,
+			  const void *nonce, size_t nonce_len,
+			  const void *aad, size_t aad_len,
+			  const void *src, size_t len, void *dst,
+			  const void *tag, size_t tag_len)
 {
 	TEE_Result res;
 	struct internal_aes_gcm_state state;
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_DECRYPT, nonce, nonce_len,
-			 tag_len);
+	res = __gcm_init(&state, enc_key, ghash_key, TEE_MODE_DECRYPT, nonce,
+			 nonce_len, tag_len);
 	if (res)
 		return res;
 
@@ -411,6 +422,57 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 	return __gcm_dec_final(&state, enc_key, src, len, dst, tag, tag_len);
 }
 
+TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
+				const void *nonce, size_t nonce_len,
+				const void *aad, size_t aad_len,
+				const void *src, size_t len, void *dst,
+				void *tag, size_t *tag_len)
+{
+	return gcm_enc(enc_key, NULL, nonce, nonce_len, aad, aad_len, src, len,
+		       dst, tag, tag_len);
+}
+
+TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
+				const void *nonce, size_t nonce_len,
+				const void *aad, size_t aad_len,
+				const void *src, size_t len, void *dst,
+				const void *tag, size_t tag_len)
+{
+	return gcm_dec(enc_key, NULL, nonce, nonce_len, aad, aad_len, src, len,
+		       dst, tag, tag_len);
+}
+
+void internal_aes_gcm_prekey_init(struct internal_aes_gcm_prekey *pk)
+{
+	struct internal_aes_gcm_state state = { };
+
+	internal_aes_gcm_set_key(&state, &pk->key);
+	pk->ghash_key = state.ghash_key;
+	memzero_explicit(&state, sizeof(state));
+}
+
+TEE_Result
+internal_aes_gcm_prekey_enc(const struct internal_aes_gcm_prekey *pk,
+			    const void *nonce, size_t nonce_len,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    void *tag, size_t *tag_len)
+{
+	return gcm_enc(&pk->key, &pk->ghash_key, nonce, nonce_len, aad,
+		       aad_len, src, len, dst, tag, tag_len);
+}
+
+TEE_Result
+internal_aes_gcm_prekey_dec(const struct internal_aes_gcm_prekey *pk,
+			    const void *nonce, size_t nonce_len,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    const void *tag, size_t tag_len)
+{
+	return gcm_dec(&pk->key, &pk->ghash_key, nonce, nonce_len, aad,
+		       aad_len, src, len, dst, tag, tag_len);
+}
+
 
 #ifndef CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB
 #include <stdlib.h>
@@ -13,6 +13,58 @@
 #include <stdlib.h>
 #include <utee_defines.h>
 
+TEE_Result crypto_hash_sw_alloc_ctx(struct crypto_hash_ctx **ctx,
+				   uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_MD5:
+		res = crypto_md5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA1:
+		res = crypto_sha1_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA224:
+		res = crypto_sha224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA256:
+		res = crypto_sha256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA384:
+		res = crypto_sha384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA512:
+		res = crypto_sha512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_224:
+		res = crypto_sha3_224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_256:
+		res = crypto_sha3_256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_384:
+		res = crypto_sha3_384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_512:
+		res = crypto_sha3_512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHAKE128:
+		res = crypto_shake128_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHAKE256:
+		res = crypto_shake256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM3:
+		res = crypto_sm3_alloc_ctx(ctx);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
@@ -24,51 +76,10 @@ TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_hash_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_MD5:
-			res = crypto_md5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA1:
-			res = crypto_sha1_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA224:
-			res = crypto_sha224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA256:
-			res = crypto_sha256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA384:
-			res = crypto_sha384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA512:
-			res = crypto_sha512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_224:
-			res = crypto_sha3_224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_256:
-			res = crypto_sha3_256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_384:
-			res = crypto_sha3_384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_512:
-			res = crypto_sha3_512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHAKE128:
-			res = crypto_shake128_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHAKE256:
-			res = crypto_shake256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM3:
-			res = crypto_sm3_alloc_ctx(&c);
-			break;
-		default:
-			break;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = crypto_hash_sw_alloc_ctx(&c, algo);
+	else if (!res)
+		res = crypto_dispatch_hash_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -111,6 +122,58 @@ TEE_Result crypto_hash_final(void *ctx, uint8_t *digest, size_t len)
 	return hash_ops(ctx)->final(ctx, digest, len);
 }
 
+TEE_Result crypto_cipher_sw_alloc_ctx(struct crypto_cipher_ctx **ctx,
+				     uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_AES_ECB_NOPAD:
+		res = crypto_aes_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CBC_NOPAD:
+		res = crypto_aes_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CTR:
+		res = crypto_aes_ctr_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CTS:
+		res = crypto_aes_cts_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_XTS:
+		res = crypto_aes_xts_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_ECB_NOPAD:
+		res = crypto_des_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_ECB_NOPAD:
+		res = crypto_des3_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_CBC_NOPAD:
+		res = crypto_des_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_CBC_NOPAD:
+		res = crypto_des3_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_ECB_NOPAD:
+		res = crypto_sm4_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_CBC_NOPAD:
+		res = crypto_sm4_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_CTR:
+		res = crypto_sm4_ctr_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_XTS:
+		res = crypto_sm4_xts_alloc_ctx(ctx);
+		break;
+	default:
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
@@ -122,51 +185,10 @@ TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_cipher_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_AES_ECB_NOPAD:
-			res = crypto_aes_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CBC_NOPAD:
-			res = crypto_aes_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTR:
-			res = crypto_aes_ctr_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTS:
-			res = crypto_aes_cts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_XTS:
-			res = crypto_aes_xts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_ECB_NOPAD:
-			res = crypto_des_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_ECB_NOPAD:
-			res = crypto_des3_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_CBC_NOPAD:
-			res = crypto_des_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CBC_NOPAD:
-			res = crypto_des3_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_ECB_NOPAD:
-			res = crypto_sm4_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_CBC_NOPAD:
-			res = crypto_sm4_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_CTR:
-			res = crypto_sm4_ctr_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_XTS:
-			res = crypto_sm4_xts_alloc_ctx(&c);
-			break;
-		default:
-			return TEE_ERROR_NOT_IMPLEMENTED;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = crypto_cipher_sw_alloc_ctx(&c, algo);
+	else if (!res)
+		res = crypto_dispatch_cipher_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -569,6 +591,10 @@ void crypto_acipher_free_rsa_keypair(struct rsa_keypair *s __unused)
 {
 }
 
+void crypto_acipher_rsa_keypair_changed(struct rsa_keypair *s __unused)
+{
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key __unused,
 				      size_t key_size __unused)
 {
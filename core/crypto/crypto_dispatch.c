@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Routing of hash and cipher operations between a drvcrypt device and
+ * the software implementation.
+ *
+ * Submitting a job to a crypto accelerator has a fixed cost (descriptor
+ * build, cache maintenance, job ring round trip) which dominates for
+ * small payloads, where the CPU implementation is faster. A dispatched
+ * context holds both a drvcrypt and a software context, both initialized
+ * with the same parameters. The first update of an operation selects the
+ * backend depending on its length, the operation then stays on it until
+ * it is initialized again.
+ *
+ * The size thresholds are calibrated at boot by timing both backends on
+ * a set of payload sizes, or set to CFG_CRYPTO_DISPATCH_THRESHOLD.
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <initcall.h>
+#include <kernel/delay.h>
+#include <stdlib.h>
+#include <string.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+struct dispatch_algo {
+	uint32_t algo;
+	/* Smallest first update sent to the drvcrypt device */
+	size_t threshold;
+};
+
+#define DISPATCH_ALGO(_algo) \
+	{ .algo = (_algo), .threshold = CFG_CRYPTO_DISPATCH_THRESHOLD }
+
+static struct dispatch_algo dispatch_algos[] = {
+	DISPATCH_ALGO(TEE_ALG_SHA1),
+	DISPATCH_ALGO(TEE_ALG_SHA224),
+	DISPATCH_ALGO(TEE_ALG_SHA256),
+	DISPATCH_ALGO(TEE_ALG_SHA384),
+	DISPATCH_ALGO(TEE_ALG_SHA512),
+	DISPATCH_ALGO(TEE_ALG_AES_ECB_NOPAD),
+	DISPATCH_ALGO(TEE_ALG_AES_CBC_NOPAD),
+	DISPATCH_ALGO(TEE_ALG_AES_CTR),
+};
+
+static struct dispatch_algo *find_algo(uint32_t algo)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(dispatch_algos); n++)
+		if (dispatch_algos[n].algo == algo)
+			return dispatch_algos + n;
+
+	return NULL;
+}
+
+struct dispatch_hash_ctx {
+	struct crypto_hash_ctx hash_ctx;
+	struct crypto_hash_ctx *hw;
+	struct crypto_hash_ctx *sw;
+	struct crypto_hash_ctx *cur;	/* NULL until the first update */
+	const struct dispatch_algo *da;
+};
+
+static const struct crypto_hash_ops dispatch_hash_ops;
+
+static struct dispatch_hash_ctx *to_hash_ctx(struct crypto_hash_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &dispatch_hash_ops);
+
+	return container_of(ctx, struct dispatch_hash_ctx, hash_ctx);
+}
+
+static TEE_Result dispatch_hash_init(struct crypto_hash_ctx *ctx)
+{
+	struct dispatch_hash_ctx *c = to_hash_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	c->cur = NULL;
+	res = c->hw->ops->init(c->hw);
+	if (res)
+		return res;
+
+	return c->sw->ops->init(c->sw);
+}
+
+static TEE_Result dispatch_hash_update(struct crypto_hash_ctx *ctx,
+				       const uint8_t *data, size_t len)
+{
+	struct dispatch_hash_ctx *c = to_hash_ctx(ctx);
+
+	if (!c->cur)
+		c->cur = len >= c->da->threshold ? c->hw : c->sw;
+
+	return c->cur->ops->update(c->cur, data, len);
+}
+
+static TEE_Result dispatch_hash_final(struct crypto_hash_ctx *ctx,
+				      uint8_t *digest, size_t len)
+{
+	struct dispatch_hash_ctx *c = to_hash_ctx(ctx);
+
+	if (!c->cur)
+		c->cur = c->sw;
+
+	return c->cur->ops->final(c->cur, digest, len);
+}
+
+static void dispatch_hash_free_ctx(struct crypto_hash_ctx *ctx)
+{
+	struct dispatch_hash_ctx *c = to_hash_ctx(ctx);
+
+	c->hw->ops->free_ctx(c->hw);
+	c->sw->ops->free_ctx(c->sw);
+	free(c);
+}
+
+static void dispatch_hash_copy_state(struct crypto_hash_ctx *dst_ctx,
+				     struct crypto_hash_ctx *src_ctx)
+{
+	struct dispatch_hash_ctx *src = to_hash_ctx(src_ctx);
+	struct dispatch_hash_ctx *dst = to_hash_ctx(dst_ctx);
+
+	dst->hw->ops->copy_state(dst->hw, src->hw);
+	dst->sw->ops->copy_state(dst->sw, src->sw);
+	if (!src->cur)
+		dst->cur = NULL;
+	else if (src->cur == src->hw)
+		dst->cur = dst->hw;
+	else
+		dst->cur = dst->sw;
+}
+
+static const struct crypto_hash_ops dispatch_hash_ops = {
+	.init = dispatch_hash_init,
+	.update = dispatch_hash_update,
+	.final = dispatch_hash_final,
+	.free_ctx = dispatch_hash_free_ctx,
+	.copy_state = dispatch_hash_copy_state,
+};
+
+TEE_Result crypto_dispatch_hash_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo)
+{
+	const struct dispatch_algo *da = find_algo(algo);
+	struct dispatch_hash_ctx *c = NULL;
+	struct crypto_hash_ctx *sw = NULL;
+
+	if (!da)
+		return TEE_SUCCESS;
+
+	if (crypto_hash_sw_alloc_ctx(&sw, algo))
+		return TEE_SUCCESS;
+
+	c = calloc(1, sizeof(*c));
+	if (!c) {
+		sw->ops->free_ctx(sw);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	c->hash_ctx.ops = &dispatch_hash_ops;
+	c->hw = *ctx;
+	c->sw = sw;
+	c->da = da;
+	*ctx = &c->hash_ctx;
+
+	return TEE_SUCCESS;
+}
+
+struct dispatch_cipher_ctx {
+	struct crypto_cipher_ctx cipher_ctx;
+	struct crypto_cipher_ctx *hw;
+	struct crypto_cipher_ctx *sw;
+	struct crypto_cipher_ctx *cur;	/* NULL until the first update */
+	const struct dispatch_algo *da;
+};
+
+static const struct crypto_cipher_ops dispatch_cipher_ops;
+
+static struct dispatch_cipher_ctx *
+to_cipher_ctx(struct crypto_cipher_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &dispatch_cipher_ops);
+
+	return container_of(ctx, struct dispatch_cipher_ctx, cipher_ctx);
+}
+
+static TEE_Result dispatch_cipher_init(struct crypto_cipher_ctx *ctx,
+				       TEE_OperationMode mode,
+				       const uint8_t *key1, size_t key1_len,
+				       const uint8_t *key2, size_t key2_len,
+				       const uint8_t *iv, size_t iv_len)
+{
+	struct dispatch_cipher_ctx *c = to_cipher_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	c->cur = NULL;
+	res = c->hw->ops->init(c->hw, mode, key1, key1_len, key2, key2_len,
+			       iv, iv_len);
+	if (res)
+		return res;
+
+	return c->sw->ops->init(c->sw, mode, key1, key1_len, key2, key2_len,
+				iv, iv_len);
+}
+
+static TEE_Result dispatch_cipher_update(struct crypto_cipher_ctx *ctx,
+					 bool last_block, const uint8_t *data,
+					 size_t len, uint8_t *dst)
+{
+	struct dispatch_cipher_ctx *c = to_cipher_ctx(ctx);
+
+	if (!c->cur)
+		c->cur = len >= c->da->threshold ? c->hw : c->sw;
+
+	return c->cur->ops->update(c->cur, last_block, data, len, dst);
+}
+
+static void dispatch_cipher_final(struct crypto_cipher_ctx *ctx)
+{
+	struct dispatch_cipher_ctx *c = to_cipher_ctx(ctx);
+
+	/* Both contexts were initialized, release both */
+	c->hw->ops->final(c->hw);
+	c->sw->ops->final(c->sw);
+}
+
+static void dispatch_cipher_free_ctx(struct crypto_cipher_ctx *ctx)
+{
+	struct dispatch_cipher_ctx *c = to_cipher_ctx(ctx);
+
+	c->hw->ops->free_ctx(c->hw);
+	c->sw->ops->free_ctx(c->sw);
+	free(c);
+}
+
+static void dispatch_cipher_copy_state(struct crypto_cipher_ctx *dst_ctx,
+				       struct crypto_cipher_ctx *src_ctx)
+{
+	struct dispatch_cipher_ctx *src = to_cipher_ctx(src_ctx);
+	struct dispatch_cipher_ctx *dst = to_cipher_ctx(dst_ctx);
+
+	dst->hw->ops->copy_state(dst->hw, src->hw);
+	dst->sw->ops->copy_state(dst->sw, src->sw);
+	if (!src->cur)
+		dst->cur = NULL;
+	else if (src->cur == src->hw)
+		dst->cur = dst->hw;
+	else
+		dst->cur = dst->sw;
+}
+
+static const struct crypto_cipher_ops dispatch_cipher_ops = {
+	.init = dispatch_cipher_init,
+	.update = dispatch_cipher_update,
+	.final = dispatch_cipher_final,
+	.free_ctx = dispatch_cipher_free_ctx,
+	.copy_state = dispatch_cipher_copy_state,
+};
+
+TEE_Result crypto_dispatch_cipher_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo)
+{
+	const struct dispatch_algo *da = find_algo(algo);
+	struct dispatch_cipher_ctx *c = NULL;
+	struct crypto_cipher_ctx *sw = NULL;
+
+	if (!da)
+		return TEE_SUCCESS;
+
+	if (crypto_cipher_sw_alloc_ctx(&sw, algo))
+		return TEE_SUCCESS;
+
+	c = calloc(1, sizeof(*c));
+	if (!c) {
+		sw->ops->free_ctx(sw);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	c->cipher_ctx.ops = &dispatch_cipher_ops;
+	c->hw = *ctx;
+	c->sw = sw;
+	c->da = da;
+	*ctx = &c->cipher_ctx;
+
+	return TEE_SUCCESS;
+}
+
+#if defined(CFG_CRYPTO_DISPATCH_CALIBRATE)
+/* Payload sizes timed during calibration, in increasing order */
+static const size_t calib_sizes[] = { 16, 64, 256, 1024, 4096, 16384 };
+
+#define CALIB_ROUNDS		4
+#define CALIB_KEY_SIZE		16
+
+static TEE_Result time_hash(struct crypto_hash_ctx *ctx, const uint8_t *buf,
+			    size_t len, uint64_t *cnt)
+{
+	uint8_t digest[TEE_MAX_HASH_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t start = delay_cnt_read();
+	unsigned int n = 0;
+
+	for (n = 0; n < CALIB_ROUNDS && !res; n++) {
+		res = ctx->ops->init(ctx);
+		if (!res)
+			res = ctx->ops->update(ctx, buf, len);
+		if (!res)
+			res = ctx->ops->final(ctx, digest, sizeof(digest));
+	}
+
+	*cnt = delay_cnt_read() - start;
+
+	return res;
+}
+
+static TEE_Result time_cipher(struct crypto_cipher_ctx *ctx, uint8_t *buf,
+			      size_t len, uint64_t *cnt)
+{
+	static const uint8_t key[CALIB_KEY_SIZE];
+	static const uint8_t iv[TEE_AES_BLOCK_SIZE];
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t start = delay_cnt_read();
+	unsigned int n = 0;
+
+	for (n = 0; n < CALIB_ROUNDS && !res; n++) {
+		res = ctx->ops->init(ctx, TEE_MODE_ENCRYPT, key, sizeof(key),
+				     NULL, 0, iv, sizeof(iv));
+		if (!res)
+			res = ctx->ops->update(ctx, true, buf, len, buf);
+		ctx->ops->final(ctx);
+	}
+
+	*cnt = delay_cnt_read() - start;
+
+	return res;
+}
+
+/* Return the smallest calibrated size for which @hw is the fastest */
+static size_t calibrate_hash(uint32_t algo, uint8_t *buf)
+{
+	struct crypto_hash_ctx *hw = NULL;
+	struct crypto_hash_ctx *sw = NULL;
+	size_t threshold = SIZE_MAX;
+	uint64_t hw_cnt = 0;
+	uint64_t sw_cnt = 0;
+	size_t n = 0;
+
+	if (drvcrypt_hash_alloc_ctx(&hw, algo))
+		return CFG_CRYPTO_DISPATCH_THRESHOLD;
+	if (crypto_hash_sw_alloc_ctx(&sw, algo)) {
+		hw->ops->free_ctx(hw);
+		return 0;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(calib_sizes); n++) {
+		if (time_hash(hw, buf, calib_sizes[n], &hw_cnt) ||
+		    time_hash(sw, buf, calib_sizes[n], &sw_cnt)) {
+			threshold = CFG_CRYPTO_DISPATCH_THRESHOLD;
+			break;
+		}
+		if (hw_cnt <= sw_cnt) {
+			threshold = calib_sizes[n];
+			break;
+		}
+	}
+
+	hw->ops->free_ctx(hw);
+	sw->ops->free_ctx(sw);
+
+	return threshold;
+}
+
+static size_t calibrate_cipher(uint32_t algo, uint8_t *buf)
+{
+	struct crypto_cipher_ctx *hw = NULL;
+	struct crypto_cipher_ctx *sw = NULL;
+	size_t threshold = SIZE_MAX;
+	uint64_t hw_cnt = 0;
+	uint64_t sw_cnt = 0;
+	size_t n = 0;
+
+	if (drvcrypt_cipher_alloc_ctx(&hw, algo))
+		return CFG_CRYPTO_DISPATCH_THRESHOLD;
+	if (crypto_cipher_sw_alloc_ctx(&sw, algo)) {
+		hw->ops->free_ctx(hw);
+		return 0;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(calib_sizes); n++) {
+		if (time_cipher(hw, buf, calib_sizes[n], &hw_cnt) ||
+		    time_cipher(sw, buf, calib_sizes[n], &sw_cnt)) {
+			threshold = CFG_CRYPTO_DISPATCH_THRESHOLD;
+			break;
+		}
+		if (hw_cnt <= sw_cnt) {
+			threshold = calib_sizes[n];
+			break;
+		}
+	}
+
+	hw->ops->free_ctx(hw);
+	sw->ops->free_ctx(sw);
+
+	return threshold;
+}
+
+static TEE_Result crypto_dispatch_calibrate(void)
+{
+	struct dispatch_algo *da = NULL;
+	uint8_t *buf = NULL;
+	size_t n = 0;
+
+	buf = calloc(1, calib_sizes[ARRAY_SIZE(calib_sizes) - 1]);
+	if (!buf)
+		return TEE_SUCCESS;
+
+	for (n = 0; n < ARRAY_SIZE(dispatch_algos); n++) {
+		da = dispatch_algos + n;
+		if (TEE_ALG_GET_CLASS(da->algo) == TEE_OPERATION_DIGEST)
+			da->threshold = calibrate_hash(da->algo, buf);
+		else
+			da->threshold = calibrate_cipher(da->algo, buf);
+		DMSG("algo %#"PRIx32": threshold %zu", da->algo,
+		     da->threshold);
+	}
+
+	free(buf);
+
+	return TEE_SUCCESS;
+}
+boot_final(crypto_dispatch_calibrate);
+#endif /* CFG_CRYPTO_DISPATCH_CALIBRATE */
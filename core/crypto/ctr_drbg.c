@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <crypto/ctr_drbg.h>
+#include <string.h>
+#include <string_ext.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#define BLOCK_LEN	TEE_AES_BLOCK_SIZE
+#define KEY_LEN		32
+
+static void inc_v(uint8_t v[BLOCK_LEN])
+{
+	size_t n = BLOCK_LEN;
+
+	while (n--)
+		if (++v[n])
+			break;
+}
+
+/* Encrypt @nblocks successive counter values in place in @out */
+static TEE_Result ctr_blocks(struct ctr_drbg *drbg, uint8_t *out,
+			     size_t nblocks)
+{
+	size_t n = 0;
+
+	for (n = 0; n < nblocks; n++) {
+		inc_v(drbg->v);
+		memcpy(out + n * BLOCK_LEN, drbg->v, BLOCK_LEN);
+	}
+
+	return crypto_cipher_update(drbg->ctx, TEE_MODE_ENCRYPT, false, out,
+				    nblocks * BLOCK_LEN, out);
+}
+
+/* CTR_DRBG_Update() with @data of CTR_DRBG_SEED_LEN bytes or NULL */
+static TEE_Result update(struct ctr_drbg *drbg, const uint8_t *data)
+{
+	uint8_t temp[CTR_DRBG_SEED_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	COMPILE_TIME_ASSERT(CTR_DRBG_SEED_LEN == KEY_LEN + BLOCK_LEN);
+
+	res = ctr_blocks(drbg, temp, sizeof(temp) / BLOCK_LEN);
+	if (res)
+		goto out;
+
+	if (data)
+		for (n = 0; n < sizeof(temp); n++)
+			temp[n] ^= data[n];
+
+	res = crypto_cipher_init(drbg->ctx, TEE_MODE_ENCRYPT, temp, KEY_LEN,
+				 NULL, 0, NULL, 0);
+	memcpy(drbg->v, temp + KEY_LEN, BLOCK_LEN);
+out:
+	memzero_explicit(temp, sizeof(temp));
+
+	return res;
+}
+
+TEE_Result ctr_drbg_instantiate(struct ctr_drbg *drbg, const uint8_t *seed)
+{
+	uint8_t key[KEY_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_cipher_alloc_ctx(&drbg->ctx, TEE_ALG_AES_ECB_NOPAD);
+	if (res)
+		return res;
+
+	/* Key and V start as all zeroes */
+	memset(drbg->v, 0, sizeof(drbg->v));
+	res = crypto_cipher_init(drbg->ctx, TEE_MODE_ENCRYPT, key, sizeof(key),
+				 NULL, 0, NULL, 0);
+	if (!res)
+		res = update(drbg, seed);
+	if (res)
+		ctr_drbg_uninstantiate(drbg);
+
+	return res;
+}
+
+TEE_Result ctr_drbg_reseed(struct ctr_drbg *drbg, const uint8_t *seed)
+{
+	return update(drbg, seed);
+}
+
+TEE_Result ctr_drbg_generate(struct ctr_drbg *drbg, void *buf, size_t len)
+{
+	uint8_t block[BLOCK_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *p = buf;
+	size_t req = 0;
+	size_t bulk = 0;
+
+	while (len) {
+		req = MIN(len, (size_t)CTR_DRBG_MAX_REQUEST);
+		bulk = ROUNDDOWN(req, BLOCK_LEN);
+
+		/* Lay out the counter blocks in the output, one cipher call */
+		if (bulk) {
+			res = ctr_blocks(drbg, p, bulk / BLOCK_LEN);
+			if (res)
+				break;
+		}
+
+		if (req > bulk) {
+			res = ctr_blocks(drbg, block, 1);
+			if (res)
+				break;
+			memcpy(p + bulk, block, req - bulk);
+		}
+
+		/* Backtracking resistance after each request */
+		res = update(drbg, NULL);
+		if (res)
+			break;
+
+		p += req;
+		len -= req;
+	}
+
+	memzero_explicit(block, sizeof(block));
+
+	return res;
+}
+
+void ctr_drbg_uninstantiate(struct ctr_drbg *drbg)
+{
+	crypto_cipher_free_ctx(drbg->ctx);
+	memzero_explicit(drbg, sizeof(*drbg));
+}
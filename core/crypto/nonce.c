@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <kernel/misc.h>
+#include <kernel/thread.h>
+#include <string.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#define NONCE_PREFIX_SIZE	(CRYPTO_NONCE_MAX_SIZE - sizeof(uint64_t))
+
+/*
+ * struct nonce_state - per-core nonce generator
+ * @prefix:	Random prefix drawn on first use, distinct per core with
+ *		overwhelming probability
+ * @counter:	Number of nonces handed out by this core
+ * @valid:	True once @prefix has been drawn
+ *
+ * Only accessed by the owning core with foreign interrupts masked.
+ */
+struct nonce_state {
+	uint8_t prefix[NONCE_PREFIX_SIZE];
+	uint64_t counter;
+	bool valid;
+};
+
+static struct nonce_state nonce_state[CFG_TEE_CORE_NB_CORE];
+
+TEE_Result crypto_nonce_read(void *buf, size_t len)
+{
+	uint8_t prefix[NONCE_PREFIX_SIZE] = { };
+	struct nonce_state *s = NULL;
+	uint32_t exceptions = 0;
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t ctr = 0;
+
+	if (!buf || len < CRYPTO_NONCE_MIN_SIZE || len > CRYPTO_NONCE_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	s = nonce_state + get_core_pos();
+	if (!s->valid) {
+		thread_unmask_exceptions(exceptions);
+
+		/* The RNG may sleep, we may be on another core afterwards */
+		res = crypto_rng_read(prefix, sizeof(prefix));
+		if (res)
+			return res;
+
+		exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+		s = nonce_state + get_core_pos();
+		if (!s->valid) {
+			memcpy(s->prefix, prefix, sizeof(prefix));
+			s->valid = true;
+		}
+	}
+	ctr = TEE_U64_TO_BIG_ENDIAN(s->counter);
+	s->counter++;
+	memcpy(buf, s->prefix, len - sizeof(ctr));
+	thread_unmask_exceptions(exceptions);
+
+	memcpy((uint8_t *)buf + len - sizeof(ctr), &ctr, sizeof(ctr));
+
+	return TEE_SUCCESS;
+}
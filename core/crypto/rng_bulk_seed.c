@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <kernel/callout.h>
+#include <kernel/workqueue.h>
+#include <malloc.h>
+#include <string_ext.h>
+#include <trace.h>
+
+static TEE_Result (*bulk_read)(void *buf, size_t len);
+
+static TEE_Result bulk_seed(void)
+{
+	const size_t len = CFG_CRYPTO_RNG_BULK_SEED_BYTES;
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *buf = malloc(len);
+
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = bulk_read(buf, len);
+	if (!res)
+		res = crypto_rng_add_bulk(CRYPTO_RNG_SRC_HW_TRNG, buf, len);
+
+	memzero_explicit(buf, len);
+	free(buf);
+
+	return res;
+}
+
+#ifdef CFG_CRYPTO_RNG_BULK_SEED_REFRESH
+/*
+ * The callout runs in interrupt context, the TRNG is read and the pools
+ * are hashed from the work queue instead.
+ */
+static struct callout refresh_callout;
+static struct work refresh_work;
+
+static void refresh_work_fn(struct work *w __unused)
+{
+	TEE_Result res = bulk_seed();
+
+	if (res)
+		DMSG("RNG bulk refresh failed: %#"PRIx32, res);
+}
+
+static bool refresh_cb(struct callout *co __unused)
+{
+	work_queue(&refresh_work, refresh_work_fn);
+
+	return true;
+}
+
+static void start_refresh(void)
+{
+	callout_add(&refresh_callout, refresh_cb, CFG_CRYPTO_RNG_BULK_SEED_MS);
+}
+#else
+static void start_refresh(void)
+{
+}
+#endif
+
+void crypto_rng_set_bulk_source(TEE_Result (*read)(void *buf, size_t len))
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	assert(read && !bulk_read);
+	bulk_read = read;
+
+	/* The PRNG is already seeded, a failure here isn't fatal */
+	res = bulk_seed();
+	if (res)
+		EMSG("RNG bulk seeding failed: %#"PRIx32, res);
+
+	start_refresh();
+}
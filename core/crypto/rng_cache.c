@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/misc.h>
+#include <kernel/thread.h>
+#include <string.h>
+#include <string_ext.h>
+#include <util.h>
+
+#include "rng_cache.h"
+
+#define RNG_CACHE_SIZE		CFG_CORE_RNG_PCPU_CACHE_SIZE
+#define RNG_CACHE_MAX_READ	(RNG_CACHE_SIZE / 4)
+
+/*
+ * struct rng_cache - per-core buffer of not yet consumed random bytes
+ * @data:	Random bytes, valid bytes are @data[0 .. @avail - 1]
+ * @avail:	Number of valid bytes in @data
+ *
+ * Only accessed by the owning core with foreign interrupts masked.
+ * Consumed bytes are taken from the end of the valid range and wiped at
+ * once, so a later compromise of the cache doesn't reveal earlier output.
+ */
+struct rng_cache {
+	uint8_t data[RNG_CACHE_SIZE];
+	size_t avail;
+};
+
+static struct rng_cache rng_cache[CFG_TEE_CORE_NB_CORE];
+
+static void cache_take(struct rng_cache *c, void *buf, size_t blen)
+{
+	c->avail -= blen;
+	memcpy(buf, c->data + c->avail, blen);
+	memzero_explicit(c->data + c->avail, blen);
+}
+
+TEE_Result rng_cache_read(void *buf, size_t blen,
+			  TEE_Result (*refill)(void *buf, size_t blen))
+{
+	uint8_t fresh[RNG_CACHE_SIZE] = { };
+	uint32_t exceptions = 0;
+	struct rng_cache *c = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	COMPILE_TIME_ASSERT(RNG_CACHE_MAX_READ > 0);
+
+	if (!blen || blen > RNG_CACHE_MAX_READ)
+		return refill(buf, blen);
+
+	if (!buf)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	c = rng_cache + get_core_pos();
+	if (c->avail >= blen) {
+		cache_take(c, buf, blen);
+		thread_unmask_exceptions(exceptions);
+		return TEE_SUCCESS;
+	}
+	thread_unmask_exceptions(exceptions);
+
+	/*
+	 * The backend may sleep on a mutex, so it's called with foreign
+	 * interrupts unmasked and into a local buffer. We may have moved
+	 * to another core once it returns.
+	 */
+	res = refill(fresh, sizeof(fresh));
+	if (res)
+		goto out;
+
+	memcpy(buf, fresh, blen);
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	c = rng_cache + get_core_pos();
+	/* Keep the larger of what is cached and what is left of @fresh */
+	if (c->avail < sizeof(fresh) - blen) {
+		memcpy(c->data, fresh + blen, sizeof(fresh) - blen);
+		memzero_explicit(c->data + sizeof(fresh) - blen, blen);
+		c->avail = sizeof(fresh) - blen;
+	}
+	thread_unmask_exceptions(exceptions);
+
+out:
+	memzero_explicit(fresh, sizeof(fresh));
+	return res;
+}
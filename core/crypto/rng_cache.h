@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __CRYPTO_RNG_CACHE_H
+#define __CRYPTO_RNG_CACHE_H
+
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * rng_cache_read() - Read random bytes through the per-core output cache
+ * @buf:	Output buffer
+ * @blen:	Number of bytes to read
+ * @refill:	Backend used to fill @buf or the cache, for instance Fortuna
+ *		or the hardware RNG
+ *
+ * Small requests are served from a buffer private to the current core,
+ * without taking any global lock. The buffer is refilled in bulk from
+ * @refill when it cannot satisfy a request. Bytes are wiped from the
+ * cache as soon as they have been handed out so each output byte is
+ * returned exactly once.
+ */
+#ifdef CFG_CORE_RNG_PCPU_CACHE
+TEE_Result rng_cache_read(void *buf, size_t blen,
+			  TEE_Result (*refill)(void *buf, size_t blen));
+#else
+static inline TEE_Result
+rng_cache_read(void *buf, size_t blen,
+	       TEE_Result (*refill)(void *buf, size_t blen))
+{
+	return refill(buf, blen);
+}
+#endif
+
+#endif /*__CRYPTO_RNG_CACHE_H*/
@@ -9,15 +9,22 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <crypto/rng_stats.h>
 #include <kernel/mutex.h>
+#include <kernel/misc.h>
+#include <kernel/perf_stats.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
 #include <string.h>
+#include <string_ext.h>
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
 
+#include "rng_cache.h"
+
 #define NUM_POOLS		32
 #define BLOCK_SIZE		16
 #define KEY_SIZE		32
@@ -26,6 +33,8 @@
 #define MIN_POOL_SIZE		64
 #define MAX_EVENT_DATA_LEN	32U
 #define RING_BUF_DATA_SIZE	4U
+#define EVENT_HDR_SIZE		2U
+#define STAGE_POOL_SIZE		32U
 
 /*
  * struct fortuna_state - state of the Fortuna PRNG
@@ -58,18 +67,29 @@ static struct fortuna_state {
 
 static struct mutex state_mu = MUTEX_INITIALIZER;
 
-static struct {
-	struct {
-		uint8_t snum;
-		uint8_t pnum;
-		uint8_t dlen;
-		uint8_t data[RING_BUF_DATA_SIZE];
-	} elem[8];
-	unsigned int begin;
-	unsigned int end;
-} ring_buffer;
+/*
+ * struct event_stage - per core staging buffer of quick events
+ * @data:	For each pool the records { snum, dlen, data[dlen] } of the
+ *		queued events, this is the byte stream add_event() would
+ *		hash into the pool
+ * @len:	Number of bytes used in @data for each pool
+ * @dropped:	Number of events dropped because @data of their pool was full
+ * @lock:	Protects the above, only contended while draining
+ *
+ * Each core queues its quick events in its own buffer so interrupt
+ * context entropy sources on different cores never compete for a lock.
+ * While draining all events queued for a pool on a core are hashed with
+ * a single hash_update() call.
+ */
+static struct event_stage {
+	uint8_t data[NUM_POOLS][STAGE_POOL_SIZE];
+	uint8_t len[NUM_POOLS];
+	uint32_t dropped;
+	unsigned int lock;
+} event_stage[CFG_TEE_CORE_NB_CORE];
 
-unsigned int ring_buffer_spin_lock;
+/* Number of events added to the pools, protected by state_mu */
+static uint64_t events_consumed;
 
 static void inc_counter(uint64_t counter[2])
 {
@@ -135,6 +155,7 @@ TEE_Result crypto_rng_init(const void *data, size_t dlen)
 	size_t n;
 
 	COMPILE_TIME_ASSERT(sizeof(state.counter) == BLOCK_SIZE);
+	COMPILE_TIME_ASSERT(STAGE_POOL_SIZE <= UINT8_MAX);
 
 	if (state.ctx)
 		return TEE_ERROR_BAD_STATE;
@@ -172,51 +193,58 @@ err:
 	return res;
 }
 
-static void push_ring_buffer(uint8_t snum, uint8_t pnum, const void *data,
-			     size_t dlen)
+static void stage_event(uint8_t snum, uint8_t pnum, const void *data,
+			size_t dlen)
 {
 	uint8_t dl = MIN(RING_BUF_DATA_SIZE, dlen);
-	unsigned int next_begin;
-	uint32_t old_itr_status;
-
-	/* Spinlock to serialize writers */
-	old_itr_status = cpu_spin_lock_xsave(&ring_buffer_spin_lock);
+	struct event_stage *stage = NULL;
+	uint32_t exceptions = 0;
+	uint8_t *p = NULL;
 
-	next_begin = (ring_buffer.begin + 1) % ARRAY_SIZE(ring_buffer.elem);
-	if (next_begin == atomic_load_uint(&ring_buffer.end))
-		goto out; /* buffer is full */
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	stage = event_stage + get_core_pos();
+	cpu_spin_lock(&stage->lock);
 
-	ring_buffer.elem[next_begin].snum = snum;
-	ring_buffer.elem[next_begin].pnum = pnum;
-	ring_buffer.elem[next_begin].dlen = dl;
-	memcpy(ring_buffer.elem[next_begin].data, data, dl);
-
-	atomic_store_uint(&ring_buffer.begin, next_begin);
+	if (stage->len[pnum] + EVENT_HDR_SIZE + dl > STAGE_POOL_SIZE) {
+		stage->dropped++;
+	} else {
+		p = stage->data[pnum] + stage->len[pnum];
+		p[0] = snum;
+		p[1] = dl;
+		memcpy(p + EVENT_HDR_SIZE, data, dl);
+		stage->len[pnum] += EVENT_HDR_SIZE + dl;
+	}
 
-out:
-	cpu_spin_unlock_xrestore(&ring_buffer_spin_lock, old_itr_status);
+	cpu_spin_unlock(&stage->lock);
+	thread_unmask_exceptions(exceptions);
 }
 
-static size_t pop_ring_buffer(uint8_t *snum, uint8_t *pnum,
-			      uint8_t data[RING_BUF_DATA_SIZE])
+static size_t unstage_events(struct event_stage *stage, uint8_t pnum,
+			     uint8_t data[STAGE_POOL_SIZE])
 {
-	unsigned int next_end;
-	size_t dlen;
-
-	if (atomic_load_uint(&ring_buffer.begin) == ring_buffer.end)
-		return 0;
+	uint32_t exceptions = 0;
+	size_t len = 0;
 
-	next_end = (ring_buffer.end + 1) % ARRAY_SIZE(ring_buffer.elem);
+	exceptions = cpu_spin_lock_xsave(&stage->lock);
+	len = stage->len[pnum];
+	memcpy(data, stage->data[pnum], len);
+	stage->len[pnum] = 0;
+	cpu_spin_unlock_xrestore(&stage->lock, exceptions);
 
-	*snum = ring_buffer.elem[ring_buffer.end].snum;
-	*pnum = ring_buffer.elem[ring_buffer.end].pnum;
-	dlen = MIN(ring_buffer.elem[ring_buffer.end].dlen, RING_BUF_DATA_SIZE);
-	assert(ring_buffer.elem[ring_buffer.end].dlen == dlen);
-	memcpy(data, ring_buffer.elem[ring_buffer.end].data, dlen);
+	return len;
+}
 
-	atomic_store_uint(&ring_buffer.end, next_end);
+static void account_events(uint8_t pnum, const uint8_t *records, size_t len)
+{
+	unsigned int l = 0;
+	size_t n = 0;
 
-	return dlen;
+	for (n = 0; n < len; n += EVENT_HDR_SIZE + records[n + 1]) {
+		events_consumed++;
+		if (!pnum &&
+		    !ADD_OVERFLOW(state.pool0_length, records[n + 1], &l))
+			state.pool0_length = l;
+	}
 }
 
 static TEE_Result add_event(uint8_t snum, uint8_t pnum,
@@ -235,6 +263,7 @@ static TEE_Result add_event(uint8_t snum, uint8_t pnum,
 	res = hash_update(state.pool_ctx[pnum], data, dl);
 	if (res)
 		return res;
+	events_consumed++;
 	if (!pnum) {
 		unsigned int l;
 
@@ -245,23 +274,29 @@ static TEE_Result add_event(uint8_t snum, uint8_t pnum,
 	return TEE_SUCCESS;
 }
 
-static TEE_Result drain_ring_buffer(void)
+static TEE_Result drain_events(void)
 {
-	while (true) {
-		TEE_Result res;
-		uint8_t snum;
-		uint8_t pnum;
-		uint8_t data[RING_BUF_DATA_SIZE];
-		size_t dlen;
-
-		dlen = pop_ring_buffer(&snum, &pnum, data);
-		if (!dlen)
-			return TEE_SUCCESS;
-
-		res = add_event(snum, pnum, data, dlen);
-		if (res)
-			return res;
+	uint8_t data[STAGE_POOL_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t core = 0;
+	size_t len = 0;
+	uint8_t pn = 0;
+
+	for (core = 0; core < CFG_TEE_CORE_NB_CORE; core++) {
+		for (pn = 0; pn < NUM_POOLS; pn++) {
+			len = unstage_events(event_stage + core, pn, data);
+			if (!len)
+				continue;
+
+			res = hash_update(state.pool_ctx[pn], data, len);
+			if (res)
+				goto out;
+			account_events(pn, data, len);
+		}
 	}
+out:
+	memzero_explicit(data, sizeof(data));
+	return res;
 }
 
 static unsigned int get_next_pnum(unsigned int *pnum)
@@ -302,39 +337,84 @@ void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
 	uint8_t snum = sid >> 1;
 
 	if (CRYPTO_RNG_SRC_IS_QUICK(sid)) {
-		push_ring_buffer(snum, pn, data, dlen);
+		stage_event(snum, pn, data, dlen);
 	} else {
 		mutex_lock(&state_mu);
 		add_event(snum, pn, data, dlen);
-		drain_ring_buffer();
+		drain_events();
 		mutex_unlock(&state_mu);
 	}
 }
 
+TEE_Result crypto_rng_add_bulk(enum crypto_rng_src sid, const void *data,
+			       size_t dlen)
+{
+	/* A zero length tags a bulk slice, events have at least one byte */
+	const uint8_t v[] = { sid >> 1, 0 };
+	size_t slice = dlen / NUM_POOLS;
+	TEE_Result res = TEE_SUCCESS;
+	const uint8_t *p = data;
+	unsigned int l = 0;
+	size_t n = 0;
+
+	if (CRYPTO_RNG_SRC_IS_QUICK(sid) || !slice)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!state.ctx)
+		return TEE_ERROR_BAD_STATE;
+
+	mutex_lock(&state_mu);
+
+	for (n = 0; n < NUM_POOLS; n++) {
+		res = hash_update(state.pool_ctx[n], v, sizeof(v));
+		if (res)
+			goto out;
+		res = hash_update(state.pool_ctx[n], p + n * slice, slice);
+		if (res)
+			goto out;
+	}
+	events_consumed += NUM_POOLS;
+	if (!ADD_OVERFLOW(state.pool0_length, slice, &l))
+		state.pool0_length = l;
+
+	res = drain_events();
+out:
+	mutex_unlock(&state_mu);
+
+	return res;
+}
+
 /* GenerateBlocks */
 static TEE_Result generate_blocks(void *block, size_t nblocks)
 {
+	TEE_Result res = TEE_SUCCESS;
 	uint8_t *b = block;
 	size_t n;
 
+	/*
+	 * Lay out all the counter blocks in the output buffer and encrypt
+	 * them in place with a single call. This lets the cipher
+	 * implementation process several blocks at a time, the Arm CE
+	 * implementation for instance interleaves four AES blocks.
+	 *
+	 * The counter is increased for each block before encryption so
+	 * that it's never re-used with the same key even if the cipher
+	 * returns an error.
+	 */
 	for (n = 0; n < nblocks; n++) {
-		TEE_Result res = crypto_cipher_update(state.ctx,
-						      TEE_MODE_ENCRYPT, false,
-						      (void *)state.counter,
-						      BLOCK_SIZE,
-						      b + n * BLOCK_SIZE);
-
-		/*
-		 * Make sure to increase the counter before returning an
-		 * eventual errors, we must never re-use the counter with
-		 * the same key.
-		 */
+		memcpy(b + n * BLOCK_SIZE, state.counter, BLOCK_SIZE);
 		inc_counter(state.counter);
-		if (res)
-			return res;
 	}
 
-	return TEE_SUCCESS;
+	if (!nblocks)
+		return TEE_SUCCESS;
+
+	res = crypto_cipher_update(state.ctx, TEE_MODE_ENCRYPT, false, b,
+				   nblocks * BLOCK_SIZE, b);
+	/* Don't leave the predictable counter blocks in the output */
+	if (res)
+		memzero_explicit(b, nblocks * BLOCK_SIZE);
+
+	return res;
 }
 
 /* GenerateRandomData */
@@ -469,6 +549,7 @@ static TEE_Result maybe_reseed(void)
 	if (res)
 		return res;
 	inc_counter(state.counter);
+	rng_stats_reseed();
 
 	return TEE_SUCCESS;
 }
@@ -502,7 +583,7 @@ static TEE_Result fortuna_read(void *buf, size_t blen)
 			goto out;
 	}
 
-	res = drain_ring_buffer();
+	res = drain_events();
 out:
 	if (res)
 		fortuna_done();
@@ -511,7 +592,7 @@ out:
 	return res;
 }
 
-TEE_Result crypto_rng_read(void *buf, size_t blen)
+static TEE_Result fortuna_read_all(void *buf, size_t blen)
 {
 	size_t offs = 0;
 
@@ -529,3 +610,31 @@ TEE_Result crypto_rng_read(void *buf, size_t blen)
 		offs += n;
 	}
 }
+
+TEE_Result crypto_rng_read(void *buf, size_t blen)
+{
+	struct perf_stats_snap snap = { };
+	uint64_t start = rng_stats_now();
+	TEE_Result res = TEE_SUCCESS;
+
+	perf_stats_begin(&snap);
+	res = rng_cache_read(buf, blen, fortuna_read_all);
+	perf_stats_end(PERF_STATS_RNG_READ, &snap);
+
+	rng_stats_read(start, blen, res);
+
+	return res;
+}
+
+void crypto_rng_get_event_stats(uint64_t *consumed, uint64_t *dropped)
+{
+	size_t n = 0;
+
+	mutex_lock(&state_mu);
+	*consumed = events_consumed;
+	mutex_unlock(&state_mu);
+
+	*dropped = 0;
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+		*dropped += atomic_load_u32(&event_stage[n].dropped);
+}
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/rng_health.h>
+#include <crypto/rng_stats.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+/* -log2 of the false positive probability of each test */
+#define RNG_HEALTH_ALPHA_LOG2	20
+
+/*
+ * APT cutoffs for a window of 512 samples and alpha = 2^-20, from
+ * SP 800-90B table 2. A claim between two entries uses the lower one,
+ * which gives the larger and thus more permissive cutoff.
+ */
+static const struct {
+	unsigned int entropy;
+	uint32_t cutoff;
+} apt_cutoffs[] = {
+	{ .entropy = 8, .cutoff = 13 },
+	{ .entropy = 4, .cutoff = 62 },
+	{ .entropy = 2, .cutoff = 177 },
+	{ .entropy = 1, .cutoff = 311 },
+};
+
+void rng_health_init(struct rng_health *h, unsigned int entropy)
+{
+	size_t n = 0;
+
+	memset(h, 0, sizeof(*h));
+
+	entropy = MIN(entropy, 32U);
+	entropy = MAX(entropy, 1U);
+
+	/* SP 800-90B 4.4.1: C = 1 + ceil(-log2(alpha) / H) */
+	h->rct_cutoff = 1 + DIV_ROUND_UP(RNG_HEALTH_ALPHA_LOG2, entropy);
+
+	for (n = 0; n < ARRAY_SIZE(apt_cutoffs); n++) {
+		if (entropy >= apt_cutoffs[n].entropy)
+			break;
+	}
+	h->apt_cutoff = apt_cutoffs[n].cutoff;
+}
+
+TEE_Result rng_health_feed(struct rng_health *h, uint32_t sample)
+{
+	if (h->failed)
+		return TEE_ERROR_SECURITY;
+
+	/* Repetition Count Test */
+	if (h->rct_count && sample == h->rct_sample) {
+		if (++h->rct_count >= h->rct_cutoff) {
+			EMSG("Repetition count test failure");
+			goto fail;
+		}
+	} else {
+		h->rct_sample = sample;
+		h->rct_count = 1;
+	}
+
+	/* Adaptive Proportion Test */
+	if (!h->apt_index) {
+		h->apt_sample = sample;
+		h->apt_count = 1;
+	} else if (sample == h->apt_sample) {
+		if (++h->apt_count >= h->apt_cutoff) {
+			EMSG("Adaptive proportion test failure");
+			goto fail;
+		}
+	}
+	if (++h->apt_index == RNG_HEALTH_APT_WINDOW)
+		h->apt_index = 0;
+
+	return TEE_SUCCESS;
+
+fail:
+	h->failed = true;
+	rng_stats_health_failure();
+	return TEE_ERROR_SECURITY;
+}
+
+TEE_Result rng_health_feed_words(struct rng_health *h, const uint32_t *words,
+				 size_t nwords)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	for (n = 0; n < nwords && !res; n++)
+		res = rng_health_feed(h, words[n]);
+
+	return res;
+}
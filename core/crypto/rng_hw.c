@@ -3,11 +3,15 @@
 
 #include <compiler.h>
 #include <crypto/crypto.h>
+#include <crypto/rng_stats.h>
 #include <kernel/panic.h>
+#include <kernel/perf_stats.h>
 #include <rng_support.h>
 #include <tee/tee_cryp_utl.h>
 #include <types_ext.h>
 
+#include "rng_cache.h"
+
 /* This is a HW RNG, no need for seeding */
 TEE_Result crypto_rng_init(const void *data __unused, size_t dlen __unused)
 {
@@ -22,10 +26,37 @@ void crypto_rng_add_event(enum crypto_rng_src sid __unused,
 {
 }
 
-TEE_Result crypto_rng_read(void *buf, size_t blen)
+TEE_Result crypto_rng_add_bulk(enum crypto_rng_src sid __unused,
+			       const void *data __unused, size_t dlen __unused)
+{
+	return TEE_SUCCESS;
+}
+
+void crypto_rng_get_event_stats(uint64_t *consumed, uint64_t *dropped)
+{
+	*consumed = 0;
+	*dropped = 0;
+}
+
+static TEE_Result hw_read(void *buf, size_t blen)
 {
 	if (!buf)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	return hw_get_random_bytes(buf, blen);
 }
+
+TEE_Result crypto_rng_read(void *buf, size_t blen)
+{
+	struct perf_stats_snap snap = { };
+	uint64_t start = rng_stats_now();
+	TEE_Result res = TEE_SUCCESS;
+
+	perf_stats_begin(&snap);
+	res = rng_cache_read(buf, blen, hw_read);
+	perf_stats_end(PERF_STATS_RNG_READ, &snap);
+
+	rng_stats_read(start, blen, res);
+
+	return res;
+}
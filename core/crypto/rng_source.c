@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <atomic.h>
+#include <crypto/rng_source.h>
+#include <rng_support.h>
+#include <sys/queue.h>
+#include <trace.h>
+#include <util.h>
+
+/* A failing source is left out of at most 2^RNG_SOURCE_MAX_BACKOFF requests */
+#define RNG_SOURCE_MAX_BACKOFF	10
+
+/* Ordered by decreasing quality, then decreasing throughput */
+static SLIST_HEAD(, rng_source) sources = SLIST_HEAD_INITIALIZER(sources);
+static uint32_t request_count;
+
+static bool rng_source_before(struct rng_source *a, struct rng_source *b)
+{
+	if (a->quality != b->quality)
+		return a->quality > b->quality;
+
+	return a->bytes_per_sec > b->bytes_per_sec;
+}
+
+void rng_source_register(struct rng_source *src)
+{
+	struct rng_source *prev = NULL;
+	struct rng_source *s = NULL;
+
+	assert(src->read);
+
+	SLIST_FOREACH(s, &sources, link) {
+		if (rng_source_before(src, s))
+			break;
+		prev = s;
+	}
+
+	src->fail_count = 0;
+	if (prev)
+		SLIST_INSERT_AFTER(prev, src, link);
+	else
+		SLIST_INSERT_HEAD(&sources, src, link);
+
+	DMSG("RNG source %s, quality %u, %u bytes/s", src->name, src->quality,
+	     src->bytes_per_sec);
+}
+
+/* Reads from @s, retrying once to ride out transient errors like busy */
+static TEE_Result source_read(struct rng_source *s, uint32_t req, void *buf,
+			      size_t len)
+{
+	TEE_Result res = s->read(buf, len);
+
+	if (res)
+		res = s->read(buf, len);
+
+	if (!res) {
+		if (s->fail_count)
+			IMSG("RNG source %s recovered", s->name);
+		s->fail_count = 0;
+		return TEE_SUCCESS;
+	}
+
+	if (!s->fail_count)
+		EMSG("RNG source %s failed: %#"PRIx32", backing off", s->name,
+		     res);
+	if (s->fail_count < RNG_SOURCE_MAX_BACKOFF)
+		s->fail_count++;
+	s->retry_at = req + BIT(s->fail_count);
+	s->failed_at = req;
+
+	return res;
+}
+
+static bool source_backing_off(struct rng_source *s, uint32_t req)
+{
+	return s->fail_count && (int32_t)(s->retry_at - req) > 0;
+}
+
+/*
+ * The back-off state is updated without locking, concurrent requests may
+ * at worst retry a source a bit earlier or later than intended.
+ */
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	uint32_t req = atomic_inc32(&request_count);
+	TEE_Result res = TEE_ERROR_NOT_SUPPORTED;
+	struct rng_source *s = NULL;
+	bool skipped = false;
+
+	SLIST_FOREACH(s, &sources, link) {
+		if (source_backing_off(s, req)) {
+			skipped = true;
+			continue;
+		}
+
+		res = source_read(s, req, buf, len);
+		if (!res)
+			return TEE_SUCCESS;
+	}
+
+	if (!skipped)
+		return res;
+
+	/* The sources backing off are the last resort */
+	SLIST_FOREACH(s, &sources, link) {
+		if (!source_backing_off(s, req) || s->failed_at == req)
+			continue;
+
+		res = source_read(s, req, buf, len);
+		if (!res)
+			return TEE_SUCCESS;
+	}
+
+	return res;
+}
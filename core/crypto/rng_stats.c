@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/rng_stats.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * The times are accumulated in delay counter ticks and only converted to
+ * microseconds by rng_stats_get(), the *_us fields of @stats are unused
+ */
+static struct rng_stats stats;
+static uint64_t total_latency_cnt;
+static uint64_t max_latency_cnt;
+static uint64_t busy_wait_cnt;
+static unsigned int stats_lock = SPINLOCK_UNLOCK;
+
+static uint64_t cnt_to_us(uint64_t cnt)
+{
+	uint64_t freq = delay_cnt_freq();
+
+	if (!freq)
+		return 0;
+
+	return (cnt / freq) * 1000000 + (cnt % freq) * 1000000 / freq;
+}
+
+void rng_stats_read(uint64_t start, size_t len, TEE_Result res)
+{
+	uint64_t cnt = delay_cnt_read() - start;
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	stats.calls++;
+	if (res) {
+		stats.failures++;
+	} else {
+		stats.bytes += len;
+		total_latency_cnt += cnt;
+		max_latency_cnt = MAX(max_latency_cnt, cnt);
+	}
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+void rng_stats_reseed(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	stats.reseeds++;
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+void rng_stats_health_failure(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	stats.health_failures++;
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+void rng_stats_busy_wait(uint64_t start)
+{
+	uint64_t cnt = delay_cnt_read() - start;
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	busy_wait_cnt += cnt;
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+void rng_stats_seed_state(uint64_t bytes, uint64_t requests)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	stats.seed_bytes = bytes;
+	stats.seed_requests = requests;
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+void rng_stats_get(struct rng_stats *st)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+	uint64_t total_latency = total_latency_cnt;
+	uint64_t max_latency = max_latency_cnt;
+	uint64_t busy_wait = busy_wait_cnt;
+
+	*st = stats;
+
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+
+	st->total_latency_us = cnt_to_us(total_latency);
+	st->max_latency_us = cnt_to_us(max_latency);
+	st->busy_wait_us = cnt_to_us(busy_wait);
+}
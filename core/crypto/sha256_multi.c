@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <crypto/crypto_accel.h>
+#include <io.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_defines.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+#include <util.h>
+
+static TEE_Result hash_one(const struct crypto_hash_msg *msg)
+{
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+	size_t n = 0;
+
+	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+
+	res = crypto_hash_init(ctx);
+	for (n = 0; !res && n < msg->num_frags; n++)
+		res = crypto_hash_update(ctx, msg->frags[n].data,
+					 msg->frags[n].len);
+	if (!res)
+		res = crypto_hash_final(ctx, msg->digest,
+					TEE_SHA256_HASH_SIZE);
+
+	crypto_hash_free_ctx(ctx);
+
+	return res;
+}
+
+#ifdef CFG_CORE_CRYPTO_SHA256_ACCEL
+#define SHA256_BLOCK_SIZE	64
+/* Longer messages are hashed one at a time with crypto_hash_*() */
+#define SHA256_MULTI_MAX_BLOCKS	4
+
+struct sha256_stream {
+	uint32_t state[8];
+	uint8_t buf[SHA256_MULTI_MAX_BLOCKS * SHA256_BLOCK_SIZE];
+};
+
+static const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static size_t msg_len(const struct crypto_hash_msg *msg)
+{
+	size_t len = 0;
+	size_t n = 0;
+
+	for (n = 0; n < msg->num_frags; n++)
+		len += msg->frags[n].len;
+
+	return len;
+}
+
+/* Number of blocks of the padded message, 0 if too long */
+static size_t msg_blocks(const struct crypto_hash_msg *msg)
+{
+	size_t len = msg_len(msg);
+
+	if (len > SHA256_MULTI_MAX_BLOCKS * SHA256_BLOCK_SIZE - 9)
+		return 0;
+
+	return (len + 9 + SHA256_BLOCK_SIZE - 1) / SHA256_BLOCK_SIZE;
+}
+
+static void stream_load(struct sha256_stream *s,
+			const struct crypto_hash_msg *msg, size_t blocks)
+{
+	size_t pad_len = blocks * SHA256_BLOCK_SIZE;
+	size_t len = 0;
+	size_t n = 0;
+
+	for (n = 0; n < msg->num_frags; n++) {
+		memcpy(s->buf + len, msg->frags[n].data, msg->frags[n].len);
+		len += msg->frags[n].len;
+	}
+
+	memset(s->buf + len, 0, pad_len - len);
+	s->buf[len] = 0x80;
+	put_be64(s->buf + pad_len - 8, (uint64_t)len * 8);
+
+	memcpy(s->state, sha256_iv, sizeof(s->state));
+}
+
+static void stream_store(struct sha256_stream *s, uint8_t *digest)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(s->state); n++)
+		put_be32(digest + n * sizeof(uint32_t), s->state[n]);
+}
+
+static void hash_two(const struct crypto_hash_msg *msg0,
+		     const struct crypto_hash_msg *msg1, size_t blocks)
+{
+	struct sha256_stream s[2] = { };
+
+	stream_load(s, msg0, blocks);
+	stream_load(s + 1, msg1, blocks);
+
+	crypto_accel_sha256_compress_x2(s[0].state, s[0].buf, s[1].state,
+					s[1].buf, blocks);
+
+	stream_store(s, msg0->digest);
+	stream_store(s + 1, msg1->digest);
+	memzero_explicit(s, sizeof(s));
+}
+
+static void hash_single(const struct crypto_hash_msg *msg, size_t blocks)
+{
+	struct sha256_stream s = { };
+
+	stream_load(&s, msg, blocks);
+	crypto_accel_sha256_compress(s.state, s.buf, blocks);
+	stream_store(&s, msg->digest);
+	memzero_explicit(&s, sizeof(s));
+}
+
+TEE_Result crypto_sha256_multi(const struct crypto_hash_msg *msgs,
+			       size_t count)
+{
+	/* Index + 1 of a message waiting for a partner of the same size */
+	size_t pending[SHA256_MULTI_MAX_BLOCKS + 1] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t blocks = 0;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		blocks = msg_blocks(msgs + n);
+		if (!blocks) {
+			res = hash_one(msgs + n);
+			if (res)
+				return res;
+		} else if (pending[blocks]) {
+			hash_two(msgs + pending[blocks] - 1, msgs + n, blocks);
+			pending[blocks] = 0;
+		} else {
+			pending[blocks] = n + 1;
+		}
+	}
+
+	for (blocks = 1; blocks < ARRAY_SIZE(pending); blocks++)
+		if (pending[blocks])
+			hash_single(msgs + pending[blocks] - 1, blocks);
+
+	return TEE_SUCCESS;
+}
+#else
+TEE_Result crypto_sha256_multi(const struct crypto_hash_msg *msgs,
+			       size_t count)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	for (n = 0; n < count && !res; n++)
+		res = hash_one(msgs + n);
+
+	return res;
+}
+#endif
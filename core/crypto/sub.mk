@@ -1,4 +1,6 @@
 srcs-y += crypto.c
+srcs-y += nonce.c
+srcs-$(CFG_CRYPTO_DISPATCH) += crypto_dispatch.c
 
 ifeq (y-y,$(CFG_CRYPTO_AES)-$(CFG_CRYPTO_GCM))
 srcs-y += aes-gcm.c
@@ -17,6 +19,13 @@ srcs-y += rng_fortuna.c
 else
 srcs-y += rng_hw.c
 endif
+srcs-$(CFG_CORE_RNG_PCPU_CACHE) += rng_cache.c
+srcs-y += rng_health.c
+srcs-$(CFG_CORE_RNG_STATS) += rng_stats.c
+srcs-$(CFG_CORE_RNG_SOURCES) += rng_source.c
+srcs-$(CFG_CRYPTO_RNG_BULK_SEED) += rng_bulk_seed.c
+srcs-$(CFG_CORE_CTR_DRBG) += ctr_drbg.c
+srcs-$(CFG_CRYPTO_SHA256) += sha256_multi.c
 
 ifneq ($(CFG_CRYPTO_CBC_MAC_FROM_CRYPTOLIB),y)
 srcs-$(CFG_CRYPTO_CBC_MAC) += cbc-mac.c
@@ -4,6 +4,7 @@
  * Copyright (c) 2023, STMicroelectronics
  */
 
+#include <atomic.h>
 #include <config.h>
 #include <drivers/clk.h>
 #include <kernel/boot.h>
@@ -71,19 +72,34 @@ static bool __maybe_unused clk_check(struct clk *clk)
 	return true;
 }
 
-static void clk_compute_rate_no_lock(struct clk *clk)
+/*
+ * The rate of a clock is only recomputed when it was invalidated by a
+ * rate or parent change of the clock itself or when the rate of its
+ * parent changed, so a change invalidates the whole subtree below it.
+ */
+static unsigned long clk_compute_rate_no_lock(struct clk *clk)
 {
 	unsigned long parent_rate = 0;
 
-	if (clk->parent) {
-		clk_compute_rate_no_lock(clk->parent);
-		parent_rate = clk->parent->rate;
-	}
+	if (clk->parent)
+		parent_rate = clk_compute_rate_no_lock(clk->parent);
+
+	if (clk->rate_valid && clk->parent_rate == parent_rate)
+		return clk->rate;
 
 	if (clk->ops->get_rate)
 		clk->rate = clk->ops->get_rate(clk, parent_rate);
 	else
 		clk->rate = parent_rate;
+	clk->parent_rate = parent_rate;
+	clk->rate_valid = true;
+
+	return clk->rate;
+}
+
+static void clk_invalidate_rate(struct clk *clk)
+{
+	clk->rate_valid = false;
 }
 
 struct clk *clk_get_parent_by_index(struct clk *clk, size_t pidx)
@@ -184,10 +200,26 @@ static TEE_Result clk_enable_no_lock(struct clk *clk)
 	return TEE_SUCCESS;
 }
 
+/* Drops an enable reference unless it's the last one */
+static bool clk_put_unless_last(struct clk *clk)
+{
+	unsigned int val = refcount_val(&clk->enabled_count);
+
+	while (val > 1)
+		if (atomic_cas_uint(&clk->enabled_count.val, &val, val - 1))
+			return true;
+
+	return false;
+}
+
 TEE_Result clk_enable(struct clk *clk)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 
+	/* An already enabled clock only needs its reference counted */
+	if (refcount_inc(&clk->enabled_count))
+		return TEE_SUCCESS;
+
 	lock_clk();
 	res = clk_enable_no_lock(clk);
 	unlock_clk();
@@ -197,6 +229,10 @@ TEE_Result clk_enable(struct clk *clk)
 
 void clk_disable(struct clk *clk)
 {
+	/* Only dropping the last reference disables the clock */
+	if (clk_put_unless_last(clk))
+		return;
+
 	lock_clk();
 	clk_disable_no_lock(clk);
 	unlock_clk();
@@ -204,9 +240,7 @@ void clk_disable(struct clk *clk)
 
 unsigned long clk_get_rate(struct clk *clk)
 {
-	clk_compute_rate_no_lock(clk);
-
-	return clk->rate;
+	return clk_compute_rate_no_lock(clk);
 }
 
 static TEE_Result clk_set_rate_no_lock(struct clk *clk, unsigned long rate)
@@ -241,6 +275,7 @@ static TEE_Result clk_set_rate_no_lock(struct clk *clk, unsigned long rate)
 			return res;
 	}
 
+	clk_invalidate_rate(clk);
 	clk_compute_rate_no_lock(clk);
 
 	return TEE_SUCCESS;
@@ -312,6 +347,7 @@ static TEE_Result clk_set_parent_no_lock(struct clk *clk, struct clk *parent,
 	clk->parent = parent;
 
 	/* The parent changed and the rate might also have changed */
+	clk_invalidate_rate(clk);
 	clk_compute_rate_no_lock(clk);
 
 out:
@@ -8,6 +8,7 @@
 #include <caam_hal_clk.h>
 #include <caam_common.h>
 #include <caam_desc_helper.h>
+#include <caam_hal_cfg.h>
 #include <caam_hal_clk.h>
 #include <caam_hal_jr.h>
 #include <caam_io.h>
@@ -15,10 +16,16 @@
 #include <caam_rng.h>
 #include <caam_utils_delay.h>
 #include <caam_utils_mem.h>
+#include <caam_utils_status.h>
+#ifdef CFG_CRYPTO_DRV_ASYNC
+#include <drvcrypt_async.h>
+#endif
 #include <kernel/interrupt.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <tee/cache.h>
 
@@ -48,6 +55,7 @@ struct jr_privdata {
 	uint64_t paddr_outrings; /* CAAM physical addr of output queue */
 
 	uint8_t nb_jobs;         /* Number of Job ring entries managed */
+	uint8_t index;           /* Index in the Secure Job Rings array */
 
 	/* Input Job Ring Variables */
 	struct caam_inring_entry *inrings; /* Input JR HW queue */
@@ -67,9 +75,10 @@ struct jr_privdata {
 };
 
 /*
- * Job Ring module private data reference
+ * Job Ring module private data references, one per Secure Job Ring
  */
-static struct jr_privdata *jr_privdata;
+static struct jr_privdata *jr_privdata[CFG_NXP_CAAM_JR_NUM];
+static unsigned int jr_count;
 
 /*
  * Free module resources
@@ -151,22 +160,6 @@ end_alloc:
 	return retstatus;
 }
 
-/*
- * Job Ring Interrupt handler
- *
- * @handler  Interrupt Handler structure
- */
-static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
-{
-	JR_TRACE("Disable the interrupt");
-	interrupt_disable(handler->chip, handler->it);
-
-	/* Send a signal to exit WFE loop */
-	sev();
-
-	return ITRR_HANDLED;
-}
-
 /*
  * Returns all jobs completed depending on the input @wait_job_ids mask.
  *
@@ -174,9 +167,11 @@ static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
  * function. Function returns the bit mask of the expected completed job
  * (@wait_job_ids parameter)
  *
+ * @jr_priv       Job Ring private data
  * @wait_job_ids  Expected Jobs to be complete
  */
-static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
+static uint32_t do_jr_dequeue(struct jr_privdata *jr_priv,
+			      uint32_t wait_job_ids)
 {
 	uint32_t ret_job_id = 0;
 	struct caller_info *caller = NULL;
@@ -188,27 +183,27 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 	uint32_t nb_jobs_done = 0;
 	size_t nb_jobs_inv = 0;
 
-	exceptions = cpu_spin_lock_xsave(&jr_privdata->outlock);
+	exceptions = cpu_spin_lock_xsave(&jr_priv->outlock);
 
-	nb_jobs_done = caam_hal_jr_get_nbjob_done(jr_privdata->baseaddr);
+	nb_jobs_done = caam_hal_jr_get_nbjob_done(jr_priv->baseaddr);
 
 	if (nb_jobs_done == 0) {
-		cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
+		cpu_spin_unlock_xrestore(&jr_priv->outlock, exceptions);
 		return ret_job_id;
 	}
 
 	/* Ensure that output ring descriptor entries are not in cache */
-	if ((jr_privdata->outread_index + nb_jobs_done) >
-	    jr_privdata->nb_jobs) {
+	if ((jr_priv->outread_index + nb_jobs_done) >
+	    jr_priv->nb_jobs) {
 		/*
 		 * Invalidate the whole circular job buffer because some
 		 * completed job rings are at the beginning of the buffer
 		 */
-		jr_out = jr_privdata->outrings;
-		nb_jobs_inv = jr_privdata->nb_jobs;
+		jr_out = jr_priv->outrings;
+		nb_jobs_inv = jr_priv->nb_jobs;
 	} else {
 		/* Invalidate only the completed job */
-		jr_out = &jr_privdata->outrings[jr_privdata->outread_index];
+		jr_out = &jr_priv->outrings[jr_priv->outread_index];
 		nb_jobs_inv = nb_jobs_done;
 	}
 
@@ -216,14 +211,14 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 			sizeof(struct caam_outring_entry) * nb_jobs_inv);
 
 	for (; nb_jobs_done; nb_jobs_done--) {
-		jr_out = &jr_privdata->outrings[jr_privdata->outread_index];
+		jr_out = &jr_priv->outrings[jr_priv->outread_index];
 
 		/*
 		 * Lock the caller information array because enqueue is
 		 * also touching it
 		 */
-		cpu_spin_lock(&jr_privdata->callers_lock);
-		for (idx_jr = 0, found = false; idx_jr < jr_privdata->nb_jobs;
+		cpu_spin_lock(&jr_priv->callers_lock);
+		for (idx_jr = 0, found = false; idx_jr < jr_priv->nb_jobs;
 		     idx_jr++) {
 			/*
 			 * Search for the caller information corresponding to
@@ -232,7 +227,7 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 			 * completion can be out of order compared to input
 			 * buffer
 			 */
-			caller = &jr_privdata->callers[idx_jr];
+			caller = &jr_priv->callers[idx_jr];
 			if (caam_desc_pop(jr_out) == caller->pdesc) {
 				jobctx = caller->jobctx;
 				jobctx->status = caam_read_jobstatus(jr_out);
@@ -255,20 +250,20 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 				break;
 			}
 		}
-		cpu_spin_unlock(&jr_privdata->callers_lock);
+		cpu_spin_unlock(&jr_priv->callers_lock);
 
 		/*
 		 * Remove the JR from the output list even if no
 		 * JR caller found
 		 */
-		caam_hal_jr_del_job(jr_privdata->baseaddr);
+		caam_hal_jr_del_job(jr_priv->baseaddr);
 
 		/*
 		 * Increment index to next JR output entry taking care that
 		 * it is a circular buffer of nb_jobs size.
 		 */
-		jr_privdata->outread_index++;
-		jr_privdata->outread_index %= jr_privdata->nb_jobs;
+		jr_priv->outread_index++;
+		jr_priv->outread_index %= jr_priv->nb_jobs;
 
 		if (found && jobctx->callback) {
 			/* Finally, execute user's callback */
@@ -276,19 +271,74 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
+	cpu_spin_unlock_xrestore(&jr_priv->outlock, exceptions);
 
 	return ret_job_id;
 }
 
+/*
+ * Job Ring Interrupt handler
+ *
+ * @handler  Interrupt Handler structure
+ */
+static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
+{
+#ifdef CFG_NXP_CAAM_JR_ITR_DEQUEUE
+	struct jr_privdata *jr_priv = handler->data;
+
+	/* Acknowledge first to not miss a job completed while dequeuing */
+	caam_hal_jr_check_ack_itr(jr_priv->baseaddr);
+	do_jr_dequeue(jr_priv, 0);
+#else
+	JR_TRACE("Disable the interrupt");
+	interrupt_disable(handler->chip, handler->it);
+#endif
+
+	/* Send a signal to exit WFE loop */
+	sev();
+
+	return ITRR_HANDLED;
+}
+
+/*
+ * Returns the Job Ring to enqueue a new job on: the Job Ring assigned to
+ * the current core if it has a free input entry, otherwise the next one
+ * having a free input entry.
+ */
+static struct jr_privdata *get_jr(void)
+{
+	struct jr_privdata *jr_priv = NULL;
+	uint32_t exceptions = 0;
+	unsigned int first = 0;
+	unsigned int n = 0;
+
+	if (jr_count == 1)
+		return jr_privdata[0];
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	first = get_core_pos() % jr_count;
+	thread_unmask_exceptions(exceptions);
+
+	for (n = 0; n < jr_count; n++) {
+		jr_priv = jr_privdata[(first + n) % jr_count];
+		if (caam_hal_jr_read_nbslot_available(jr_priv->baseaddr))
+			return jr_priv;
+	}
+
+	/* All Job Rings are full, wait on the core's one */
+	return jr_privdata[first];
+}
+
 /*
  * Enqueues a new job in the Job Ring input queue. Keep the caller's
  * job context in private array.
  *
+ * @jr_priv  Job Ring private data
  * @jobctx   Caller's job context
  * @job_id   [out] Job ID enqueued
  */
-static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
+static enum caam_status do_jr_enqueue(struct jr_privdata *jr_priv,
+				      struct caam_jobctx *jobctx,
 				      uint32_t *job_id)
 {
 	enum caam_status retstatus = CAAM_BUSY;
@@ -299,7 +349,7 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	uint8_t idx_jr = 0;
 	bool found = false;
 
-	exceptions = cpu_spin_lock_xsave(&jr_privdata->inlock);
+	exceptions = cpu_spin_lock_xsave(&jr_priv->inlock);
 
 	caam_hal_clk_enable(true);
 
@@ -307,7 +357,7 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	 * Stay locked until a job is available
 	 * Check if there is an available JR index in the HW
 	 */
-	while (caam_hal_jr_read_nbslot_available(jr_privdata->baseaddr) == 0) {
+	while (caam_hal_jr_read_nbslot_available(jr_priv->baseaddr) == 0) {
 		/*
 		 * WFE will return thanks to a SEV generated by the
 		 * interrupt handler or by a spin_unlock
@@ -324,16 +374,16 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	 * Lock the caller information array because dequeue is
 	 * also touching it
 	 */
-	cpu_spin_lock(&jr_privdata->callers_lock);
-	for (idx_jr = 0; idx_jr < jr_privdata->nb_jobs; idx_jr++) {
-		if (jr_privdata->callers[idx_jr].job_id == JR_JOB_FREE) {
+	cpu_spin_lock(&jr_priv->callers_lock);
+	for (idx_jr = 0; idx_jr < jr_priv->nb_jobs; idx_jr++) {
+		if (jr_priv->callers[idx_jr].job_id == JR_JOB_FREE) {
 			JR_TRACE("Found a space #%" PRId8
 				 " free in the callers array",
 				 idx_jr);
 			job_mask = 1 << idx_jr;
 
 			/* Store the caller information for the JR completion */
-			caller = &jr_privdata->callers[idx_jr];
+			caller = &jr_priv->callers[idx_jr];
 			caller->job_id = job_mask;
 			caller->jobctx = jobctx;
 			caller->pdesc = virt_to_phys((void *)jobctx->desc);
@@ -342,7 +392,7 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 			break;
 		}
 	}
-	cpu_spin_unlock(&jr_privdata->callers_lock);
+	cpu_spin_unlock(&jr_priv->callers_lock);
 
 	if (!found) {
 		JR_TRACE("Error didn't find a free space in the callers array");
@@ -351,9 +401,10 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 
 	JR_TRACE("Push id=%" PRId16 ", job (0x%08" PRIx32
 		 ") context @0x%08" PRIxVA,
-		 jr_privdata->inwrite_index, job_mask, (vaddr_t)jobctx);
+		 jr_priv->inwrite_index, job_mask, (vaddr_t)jobctx);
 
-	cur_inrings = &jr_privdata->inrings[jr_privdata->inwrite_index];
+	cur_inrings = &jr_priv->inrings[jr_priv->inwrite_index];
+	jobctx->jr = jr_priv->index;
 
 	/* Push the descriptor into the JR HW list */
 	caam_desc_push(cur_inrings, caller->pdesc);
@@ -366,21 +417,21 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	 * Increment index to next JR input entry taking care that
 	 * it is a circular buffer of nb_jobs size.
 	 */
-	jr_privdata->inwrite_index++;
-	jr_privdata->inwrite_index %= jr_privdata->nb_jobs;
+	jr_priv->inwrite_index++;
+	jr_priv->inwrite_index %= jr_priv->nb_jobs;
 
 	/* Ensure that input descriptor is pushed in physical memory */
 	cache_operation(TEE_CACHECLEAN, jobctx->desc,
 			DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
 
 	/* Inform HW that a new JR is available */
-	caam_hal_jr_add_newjob(jr_privdata->baseaddr);
+	caam_hal_jr_add_newjob(jr_priv->baseaddr);
 
 	*job_id = job_mask;
 	retstatus = CAAM_NO_ERROR;
 
 end_enqueue:
-	cpu_spin_unlock_xrestore(&jr_privdata->inlock, exceptions);
+	cpu_spin_unlock_xrestore(&jr_priv->inlock, exceptions);
 
 	return retstatus;
 }
@@ -395,28 +446,29 @@ static void job_done(struct caam_jobctx *jobctx)
 	jobctx->completion = true;
 }
 
-void caam_jr_cancel(uint32_t job_id)
+void caam_jr_cancel(struct caam_jobctx *jobctx)
 {
+	struct jr_privdata *jr_priv = jr_privdata[jobctx->jr];
 	unsigned int idx = 0;
 
-	cpu_spin_lock(&jr_privdata->callers_lock);
+	cpu_spin_lock(&jr_priv->callers_lock);
 
-	JR_TRACE("Job cancel 0x%" PRIx32, job_id);
-	for (idx = 0; idx < jr_privdata->nb_jobs; idx++) {
+	JR_TRACE("Job cancel 0x%" PRIx32, jobctx->id);
+	for (idx = 0; idx < jr_priv->nb_jobs; idx++) {
 		/*
 		 * Search for the caller information corresponding to
-		 * the job_id mask.
+		 * the job context.
 		 */
-		if (jr_privdata->callers[idx].job_id == job_id) {
+		if (jr_priv->callers[idx].jobctx == jobctx) {
 			/* Clear the Entry Descriptor */
-			jr_privdata->callers[idx].pdesc = 0;
-			jr_privdata->callers[idx].jobctx = NULL;
-			jr_privdata->callers[idx].job_id = JR_JOB_FREE;
-			return;
+			jr_priv->callers[idx].pdesc = 0;
+			jr_priv->callers[idx].jobctx = NULL;
+			jr_priv->callers[idx].job_id = JR_JOB_FREE;
+			break;
 		}
 	}
 
-	cpu_spin_unlock(&jr_privdata->callers_lock);
+	cpu_spin_unlock(&jr_priv->callers_lock);
 }
 
 enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
@@ -425,6 +477,7 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 	uint32_t nb_loop = 0;
 	bool infinite = false;
 	bool it_active = false;
+	unsigned int n = 0;
 
 	if (timeout_ms == UINT_MAX)
 		infinite = true;
@@ -432,11 +485,20 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 		nb_loop = timeout_ms * 100;
 
 	do {
-		/* Call the do_jr_dequeue function to dequeue the jobs */
-		job_complete = do_jr_dequeue(job_ids);
+		job_complete = 0;
+		it_active = false;
 
-		/* Check if new job has been submitted and acknowledge it */
-		it_active = caam_hal_jr_check_ack_itr(jr_privdata->baseaddr);
+		for (n = 0; n < jr_count; n++) {
+			/* Dequeue the jobs completed on the Job Ring */
+			job_complete |= do_jr_dequeue(jr_privdata[n], job_ids);
+
+			/*
+			 * Check if new job has been submitted and
+			 * acknowledge it
+			 */
+			if (caam_hal_jr_check_ack_itr(jr_privdata[n]->baseaddr))
+				it_active = true;
+		}
 
 		if (job_complete & job_ids)
 			return CAAM_NO_ERROR;
@@ -449,6 +511,103 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 	return CAAM_TIMEOUT;
 }
 
+#ifdef CFG_CRYPTO_DRV_ASYNC
+/*
+ * Asynchronous job completion callback, forwards the completion to the
+ * drvcrypt job.
+ *
+ * @jobctx   Job context
+ */
+static void async_job_done(struct caam_jobctx *jobctx)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	jobctx->completion = true;
+	if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
+		res = TEE_ERROR_GENERIC;
+
+	drvcrypt_job_done(jobctx->context, res);
+}
+
+static TEE_Result async_submit(struct drvcrypt_job *job)
+{
+	struct caam_jobctx *jobctx = job->hw_ctx;
+	enum caam_status retstatus = CAAM_FAILURE;
+	uint32_t job_id = 0;
+
+	jobctx->callback = async_job_done;
+	jobctx->context = job;
+
+	retstatus = caam_jr_enqueue(jobctx, &job_id);
+	if (retstatus == CAAM_PENDING)
+		return TEE_SUCCESS;
+
+	jobctx->callback = NULL;
+
+	return caam_status_to_tee_result(retstatus);
+}
+
+static void async_poll(void)
+{
+	unsigned int n = 0;
+
+	for (n = 0; n < jr_count; n++) {
+		do_jr_dequeue(jr_privdata[n], 0);
+		caam_hal_jr_check_ack_itr(jr_privdata[n]->baseaddr);
+	}
+}
+
+static const struct drvcrypt_async_ops caam_async_ops = {
+	.submit = async_submit,
+	.poll = async_poll,
+};
+
+static bool can_wait_async(void)
+{
+	return drvcrypt_async_can_wait();
+}
+
+/*
+ * Synchronous job executed through the drvcrypt asynchronous interface:
+ * the calling thread sleeps while the job runs, letting other threads
+ * have their own jobs in the Job Ring meanwhile.
+ *
+ * @jobctx  Reference to the job context
+ */
+static enum caam_status do_jr_enqueue_wait(struct caam_jobctx *jobctx)
+{
+	struct drvcrypt_job job = { .hw_ctx = jobctx };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = drvcrypt_job_submit(&job);
+	if (res == TEE_ERROR_BUSY)
+		return CAAM_BUSY;
+	if (res)
+		return CAAM_FAILURE;
+
+	drvcrypt_job_wait(&job);
+
+	/* Erase local callback function */
+	jobctx->callback = NULL;
+
+	if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
+		return CAAM_JOB_STATUS;
+
+	return CAAM_NO_ERROR;
+}
+#else
+static bool can_wait_async(void)
+{
+	return false;
+}
+
+static enum caam_status
+do_jr_enqueue_wait(struct caam_jobctx *jobctx __unused)
+{
+	return CAAM_NOT_SUPPORTED;
+}
+#endif /* CFG_CRYPTO_DRV_ASYNC */
+
 enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 {
 	enum caam_status retstatus = CAAM_FAILURE;
@@ -472,6 +631,10 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 	jobctx->completion = false;
 	jobctx->status = 0;
 
+	/* Sleep rather than spin while a synchronous job runs if possible */
+	if (!job_id && can_wait_async())
+		return do_jr_enqueue_wait(jobctx);
+
 	/*
 	 * If parameter job_id is NULL, the job is synchronous, hence use
 	 * the local job_done callback function
@@ -481,7 +644,7 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 		jobctx->context = jobctx;
 	}
 
-	retstatus = do_jr_enqueue(jobctx, &jobctx->id);
+	retstatus = do_jr_enqueue(get_jr(), jobctx, &jobctx->id);
 
 	if (retstatus != CAAM_NO_ERROR) {
 		JR_TRACE("enqueue job error 0x%08x", retstatus);
@@ -506,7 +669,7 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 
 	if (timeout <= 0) {
 		/* Job timeout, cancel it and return in error */
-		caam_jr_cancel(jobctx->id);
+		caam_jr_cancel(jobctx);
 		retstatus = CAAM_TIMEOUT;
 	} else {
 		if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
@@ -535,19 +698,29 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 	return retstatus;
 }
 
-enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
+/*
+ * Initialize a Job Ring
+ *
+ * @privdata  [out] Job Ring private data
+ * @jrcfg     Job Ring configuration
+ * @index     Index of the Job Ring in the Secure Job Rings array
+ */
+static enum caam_status do_jr_init(struct jr_privdata **privdata,
+				   struct caam_jrcfg *jrcfg, unsigned int index)
 {
 	enum caam_status retstatus = CAAM_FAILURE;
+	struct jr_privdata *jr_priv = NULL;
 
-	JR_TRACE("Initialization");
+	JR_TRACE("Initialization of Job Ring @0x%" PRIxPA, jrcfg->offset);
 
 	/* Allocate the Job Ring resources */
-	retstatus = do_jr_alloc(&jr_privdata, jrcfg->nb_jobs);
+	retstatus = do_jr_alloc(&jr_priv, jrcfg->nb_jobs);
 	if (retstatus != CAAM_NO_ERROR)
-		goto end_init;
+		return retstatus;
 
-	jr_privdata->ctrladdr = jrcfg->base;
-	jr_privdata->jroffset = jrcfg->offset;
+	jr_priv->index = index;
+	jr_priv->ctrladdr = jrcfg->base;
+	jr_priv->jroffset = jrcfg->offset;
 
 	retstatus =
 		caam_hal_jr_setowner(jrcfg->base, jrcfg->offset, JROWN_ARM_S);
@@ -556,8 +729,8 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 	if (retstatus != CAAM_NO_ERROR)
 		goto end_init;
 
-	jr_privdata->baseaddr = jrcfg->base + jrcfg->offset;
-	retstatus = caam_hal_jr_reset(jr_privdata->baseaddr);
+	jr_priv->baseaddr = jrcfg->base + jrcfg->offset;
+	retstatus = caam_hal_jr_reset(jr_priv->baseaddr);
 	if (retstatus != CAAM_NO_ERROR)
 		goto end_init;
 
@@ -566,81 +739,137 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 	 * The HW configuration is 64 bits registers regardless
 	 * the CAAM or CPU addressing mode.
 	 */
-	jr_privdata->paddr_inrings = virt_to_phys(jr_privdata->inrings);
-	jr_privdata->paddr_outrings = virt_to_phys(jr_privdata->outrings);
-	if (!jr_privdata->paddr_inrings || !jr_privdata->paddr_outrings) {
+	jr_priv->paddr_inrings = virt_to_phys(jr_priv->inrings);
+	jr_priv->paddr_outrings = virt_to_phys(jr_priv->outrings);
+	if (!jr_priv->paddr_inrings || !jr_priv->paddr_outrings) {
 		JR_TRACE("JR bad queue pointers");
 		retstatus = CAAM_FAILURE;
 		goto end_init;
 	}
 
-	caam_hal_jr_config(jr_privdata->baseaddr, jr_privdata->nb_jobs,
-			   jr_privdata->paddr_inrings,
-			   jr_privdata->paddr_outrings);
+	caam_hal_jr_config(jr_priv->baseaddr, jr_priv->nb_jobs,
+			   jr_priv->paddr_inrings, jr_priv->paddr_outrings);
 
 	/*
 	 * Prepare the interrupt handler to secure the interrupt even
 	 * if the interrupt is not used
 	 */
-	jr_privdata->it_handler.chip = interrupt_get_main_chip();
-	jr_privdata->it_handler.it = jrcfg->it_num;
-	jr_privdata->it_handler.flags = ITRF_TRIGGER_LEVEL;
-	jr_privdata->it_handler.handler = caam_jr_irqhandler;
-	jr_privdata->it_handler.data = jr_privdata;
+	jr_priv->it_handler.chip = interrupt_get_main_chip();
+	jr_priv->it_handler.it = jrcfg->it_num;
+	jr_priv->it_handler.flags = ITRF_TRIGGER_LEVEL;
+	jr_priv->it_handler.handler = caam_jr_irqhandler;
+	jr_priv->it_handler.data = jr_priv;
 
 #if defined(CFG_NXP_CAAM_RUNTIME_JR) && defined(CFG_CAAM_ITR)
-	if (interrupt_add_handler(&jr_privdata->it_handler)) {
+	if (interrupt_add_handler(&jr_priv->it_handler)) {
 		retstatus = CAAM_FAILURE;
 		goto end_init;
 	}
 #endif
-	caam_hal_jr_enable_itr(jr_privdata->baseaddr);
+#ifdef CFG_NXP_CAAM_JR_ITR_DEQUEUE
+	interrupt_enable(jr_priv->it_handler.chip, jr_priv->it_handler.it);
+#endif
+	caam_hal_jr_enable_itr(jr_priv->baseaddr);
 
 	retstatus = CAAM_NO_ERROR;
 
 end_init:
 	if (retstatus != CAAM_NO_ERROR)
-		do_jr_free(jr_privdata);
+		do_jr_free(jr_priv);
+	else
+		*privdata = jr_priv;
 
 	return retstatus;
 }
 
-enum caam_status caam_jr_halt(void)
+enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 {
 	enum caam_status retstatus = CAAM_FAILURE;
-	__maybe_unused uint32_t job_complete = 0;
+	struct caam_jrcfg extra = { };
+	unsigned int n = 0;
+
+	JR_TRACE("Initialization");
 
-	retstatus = caam_hal_jr_halt(jr_privdata->baseaddr);
+	retstatus = do_jr_init(&jr_privdata[0], jrcfg, 0);
+	if (retstatus != CAAM_NO_ERROR)
+		return retstatus;
+
+	jr_count = 1;
 
 	/*
-	 * All jobs in the input queue have been done, call the
-	 * dequeue function to complete them.
+	 * Additional Job Rings are optional, the driver runs with the
+	 * ones successfully initialized.
 	 */
-	job_complete = do_jr_dequeue(UINT32_MAX);
-	JR_TRACE("Completion of jobs mask 0x%" PRIx32, job_complete);
+	for (n = 1; n < ARRAY_SIZE(jr_privdata); n++) {
+		if (caam_hal_cfg_get_extra_jobring(jrcfg, n, &extra) ||
+		    do_jr_init(&jr_privdata[n], &extra, n)) {
+			EMSG("CAAM Job Ring #%u not available", n);
+			break;
+		}
+
+		jr_count++;
+	}
+
+#ifdef CFG_CRYPTO_DRV_ASYNC
+	/* Synchronous jobs keep spinning if registration fails */
+	if (drvcrypt_async_register(&caam_async_ops))
+		DMSG("CAAM JR asynchronous interface not registered");
+#endif
+
+	return CAAM_NO_ERROR;
+}
+
+enum caam_status caam_jr_halt(void)
+{
+	enum caam_status retstatus = CAAM_NO_ERROR;
+	enum caam_status status = CAAM_FAILURE;
+	__maybe_unused uint32_t job_complete = 0;
+	unsigned int n = 0;
+
+	for (n = 0; n < jr_count; n++) {
+		status = caam_hal_jr_halt(jr_privdata[n]->baseaddr);
+		if (status != CAAM_NO_ERROR)
+			retstatus = status;
+
+		/*
+		 * All jobs in the input queue have been done, call the
+		 * dequeue function to complete them.
+		 */
+		job_complete = do_jr_dequeue(jr_privdata[n], UINT32_MAX);
+		JR_TRACE("Completion of jobs mask 0x%" PRIx32, job_complete);
+	}
 
 	return retstatus;
 }
 
 enum caam_status caam_jr_flush(void)
 {
-	enum caam_status retstatus = CAAM_FAILURE;
+	enum caam_status retstatus = CAAM_NO_ERROR;
+	enum caam_status status = CAAM_FAILURE;
 	__maybe_unused uint32_t job_complete = 0;
+	unsigned int n = 0;
 
-	retstatus = caam_hal_jr_flush(jr_privdata->baseaddr);
+	for (n = 0; n < jr_count; n++) {
+		status = caam_hal_jr_flush(jr_privdata[n]->baseaddr);
+		if (status != CAAM_NO_ERROR)
+			retstatus = status;
 
-	/*
-	 * All jobs in the input queue have been done, call the
-	 * dequeue function to complete them.
-	 */
-	job_complete = do_jr_dequeue(UINT32_MAX);
-	JR_TRACE("Completion of jobs mask 0x%" PRIx32, job_complete);
+		/*
+		 * All jobs in the input queue have been done, call the
+		 * dequeue function to complete them.
+		 */
+		job_complete = do_jr_dequeue(jr_privdata[n], UINT32_MAX);
+		JR_TRACE("Completion of jobs mask 0x%" PRIx32, job_complete);
+	}
 
 	return retstatus;
 }
 
 void caam_jr_resume(uint32_t pm_hint)
 {
+	struct jr_privdata *jr_priv = jr_privdata[0];
+	unsigned int n = 0;
+
 	if (pm_hint == PM_HINT_CONTEXT_STATE) {
 #ifndef CFG_NXP_CAAM_RUNTIME_JR
 		/*
@@ -649,40 +878,51 @@ void caam_jr_resume(uint32_t pm_hint)
 		 * hence, need reconfigure the Secure JR and release
 		 * it after RNG instantiation
 		 */
-		caam_hal_jr_setowner(jr_privdata->ctrladdr,
-				     jr_privdata->jroffset, JROWN_ARM_S);
+		caam_hal_jr_setowner(jr_priv->ctrladdr, jr_priv->jroffset,
+				     JROWN_ARM_S);
 
-		caam_hal_jr_config(jr_privdata->baseaddr, jr_privdata->nb_jobs,
-				   jr_privdata->paddr_inrings,
-				   jr_privdata->paddr_outrings);
+		caam_hal_jr_config(jr_priv->baseaddr, jr_priv->nb_jobs,
+				   jr_priv->paddr_inrings,
+				   jr_priv->paddr_outrings);
 #endif /* CFG_NXP_CAAM_RUNTIME_JR */
 
-		/* Read the current job ring index */
-		jr_privdata->inwrite_index =
-			caam_hal_jr_input_index(jr_privdata->baseaddr);
-		/* Read the current output ring index */
-		jr_privdata->outread_index =
-			caam_hal_jr_output_index(jr_privdata->baseaddr);
+		for (n = 0; n < jr_count; n++) {
+			jr_priv = jr_privdata[n];
+
+			/* Read the current job ring index */
+			jr_priv->inwrite_index =
+				caam_hal_jr_input_index(jr_priv->baseaddr);
+			/* Read the current output ring index */
+			jr_priv->outread_index =
+				caam_hal_jr_output_index(jr_priv->baseaddr);
+		}
 
 		if (caam_rng_instantiation() != CAAM_NO_ERROR)
 			panic();
 
 #ifndef CFG_NXP_CAAM_RUNTIME_JR
-		caam_hal_jr_setowner(jr_privdata->ctrladdr,
-				     jr_privdata->jroffset, JROWN_ARM_NS);
+		caam_hal_jr_setowner(jr_priv->ctrladdr, jr_priv->jroffset,
+				     JROWN_ARM_NS);
 #endif /* CFG_NXP_CAAM_RUNTIME_JR */
 	} else {
-		caam_hal_jr_resume(jr_privdata->baseaddr);
+		for (n = 0; n < jr_count; n++)
+			caam_hal_jr_resume(jr_privdata[n]->baseaddr);
 	}
 }
 
 enum caam_status caam_jr_complete(void)
 {
+	enum caam_status retstatus = CAAM_NO_ERROR;
 	enum caam_status ret = CAAM_BUSY;
+	unsigned int n = 0;
 
-	ret = caam_hal_jr_flush(jr_privdata->baseaddr);
-	if (ret == CAAM_NO_ERROR)
-		caam_hal_jr_resume(jr_privdata->baseaddr);
+	for (n = 0; n < jr_count; n++) {
+		ret = caam_hal_jr_flush(jr_privdata[n]->baseaddr);
+		if (ret == CAAM_NO_ERROR)
+			caam_hal_jr_resume(jr_privdata[n]->baseaddr);
+		else
+			retstatus = ret;
+	}
 
-	return ret;
+	return retstatus;
 }
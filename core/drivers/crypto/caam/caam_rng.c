@@ -14,11 +14,13 @@
 #include <caam_utils_status.h>
 #include <crypto/crypto.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <mm/core_memprot.h>
 #include <rng_support.h>
 #include <tee/cache.h>
 #include <tee/tee_cryp_utl.h>
 #include <string.h>
+#include <string_ext.h>
 
 /*
  * Define the number of descriptor entry to generate random data
@@ -133,6 +135,279 @@ exit:
 	caam_free_desc(&desc);
 	return ret;
 }
+
+#ifdef CFG_CAAM_RNG_POOL
+#define RNG_POOL_JOBS		CFG_CAAM_RNG_POOL_JOBS
+#define RNG_POOL_BUF_SIZE	CFG_CAAM_RNG_POOL_BUF_SIZE
+
+/*
+ * RNG_BUF_SUBMIT and RNG_BUF_BUSY mark a buffer owned by a submitter or a
+ * reader working on it outside of the pool lock
+ */
+enum rng_buf_state {
+	RNG_BUF_EMPTY,
+	RNG_BUF_SUBMIT,
+	RNG_BUF_PENDING,
+	RNG_BUF_READY,
+	RNG_BUF_BUSY,
+	RNG_BUF_ERROR,
+};
+
+/*
+ * Pre-built RNG_GEN_DATA job and its DMA buffer, kept in flight on the Job
+ * Ring until the data is consumed
+ */
+struct rng_buf {
+	struct caam_jobctx jobctx;
+	uint32_t *desc;
+	uint8_t *data;
+	struct dma_buf dma;		/* cache state of @data */
+	size_t offset;			/* first byte not consumed yet */
+	uint32_t job_id;
+	enum rng_buf_state state;
+};
+
+static struct rng_buf rng_pool[RNG_POOL_JOBS];
+static unsigned int rng_pool_lock = SPINLOCK_UNLOCK;
+static bool rng_pool_ready;
+
+/* Job Ring completion callback, called with the Job Ring output lock held */
+static void rng_pool_job_done(struct caam_jobctx *jobctx)
+{
+	struct rng_buf *rbuf = jobctx->context;
+	uint32_t exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+
+	if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
+		rbuf->state = RNG_BUF_ERROR;
+	else
+		rbuf->state = RNG_BUF_READY;
+
+	cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+}
+
+/* Hand the empty buffers back to the CAAM */
+static void rng_pool_submit(void)
+{
+	struct rng_buf *rbuf = NULL;
+	uint32_t exceptions = 0;
+	enum caam_status ret = CAAM_FAILURE;
+	uint32_t job_id = 0;
+	unsigned int n = 0;
+
+	for (n = 0; n < RNG_POOL_JOBS; n++) {
+		rbuf = &rng_pool[n];
+
+		exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+		if (rbuf->state != RNG_BUF_EMPTY) {
+			cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+			continue;
+		}
+		rbuf->state = RNG_BUF_SUBMIT;
+		cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+
+		/*
+		 * Consumed bytes were wiped, don't let them hit the DMA data.
+		 * Nothing to do when a job is enqueued again after the Job
+		 * Ring was full.
+		 */
+		dma_buf_to_device(&rbuf->dma);
+		rbuf->offset = 0;
+
+		ret = caam_jr_enqueue(&rbuf->jobctx, &job_id);
+
+		exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+		if (ret != CAAM_PENDING) {
+			/* Job Ring full, try again on the next read */
+			rbuf->state = RNG_BUF_EMPTY;
+		} else {
+			/*
+			 * Readers wait on @job_id once the buffer is pending,
+			 * unless the job has already completed
+			 */
+			rbuf->job_id = job_id;
+			if (rbuf->state == RNG_BUF_SUBMIT)
+				rbuf->state = RNG_BUF_PENDING;
+		}
+		cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+	}
+}
+
+static enum caam_status rng_pool_init(void)
+{
+	uint32_t op = RNG_GEN_DATA;
+	struct rng_buf *rbuf = NULL;
+	unsigned int n = 0;
+
+	if (IS_ENABLED(CFG_CAAM_RNG_RUNTIME_PR) && rng_privdata->pr_enabled)
+		op |= ALGO_RNG_PR;
+
+	for (n = 0; n < RNG_POOL_JOBS; n++) {
+		rbuf = &rng_pool[n];
+
+		rbuf->data = caam_calloc_align(RNG_POOL_BUF_SIZE);
+		rbuf->desc = caam_calloc_desc(RNG_GEN_DESC_ENTRIES);
+		if (!rbuf->data || !rbuf->desc) {
+			RNG_TRACE("RNG pool allocation failed");
+			goto err;
+		}
+
+		caam_desc_init(rbuf->desc);
+		caam_desc_add_word(rbuf->desc, DESC_HEADER(0));
+		caam_desc_add_word(rbuf->desc, op);
+		caam_desc_add_word(rbuf->desc, FIFO_ST(CLASS_NO, RNG_TO_MEM,
+						       RNG_POOL_BUF_SIZE));
+		caam_desc_add_ptr(rbuf->desc, virt_to_phys(rbuf->data));
+		RNG_DUMPDESC(rbuf->desc);
+
+		dma_buf_init(&rbuf->dma, rbuf->data, RNG_POOL_BUF_SIZE,
+			     DMA_BUF_FROM_DEVICE);
+		rbuf->jobctx.desc = rbuf->desc;
+		rbuf->jobctx.callback = rng_pool_job_done;
+		rbuf->jobctx.context = rbuf;
+		rbuf->state = RNG_BUF_EMPTY;
+	}
+
+	rng_pool_ready = true;
+	rng_pool_submit();
+
+	return CAAM_NO_ERROR;
+err:
+	for (n = 0; n < RNG_POOL_JOBS; n++) {
+		caam_free(rng_pool[n].data);
+		rng_pool[n].data = NULL;
+		caam_free_desc(&rng_pool[n].desc);
+	}
+
+	return CAAM_OUT_MEMORY;
+}
+
+/*
+ * Copy out and wipe up to @len bytes of a completed job claimed by
+ * rng_pool_claim(), then hand the buffer back to the pool
+ */
+static size_t rng_buf_take(struct rng_buf *rbuf, uint8_t *buf, size_t len)
+{
+	uint8_t *data = rbuf->data + rbuf->offset;
+	size_t cnt = MIN(len, RNG_POOL_BUF_SIZE - rbuf->offset);
+	uint32_t exceptions = 0;
+
+	if (!rbuf->offset)
+		dma_buf_to_cpu(&rbuf->dma);
+
+	memcpy(buf, data, cnt);
+	memzero_explicit(data, cnt);
+	dma_buf_cpu_write(&rbuf->dma);
+	rbuf->offset += cnt;
+
+	exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+	if (rbuf->offset == RNG_POOL_BUF_SIZE)
+		rbuf->state = RNG_BUF_EMPTY;
+	else
+		rbuf->state = RNG_BUF_READY;
+	cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+
+	return cnt;
+}
+
+/*
+ * Claim a completed job of the pool in @claimed, the cache maintenance and
+ * the copy are then done without holding the pool lock. When none is
+ * ready, @pending returns the IDs of the jobs to wait for.
+ */
+static TEE_Result rng_pool_claim(struct rng_buf **claimed, uint32_t *pending)
+{
+	TEE_Result ret = TEE_SUCCESS;
+	struct rng_buf *rbuf = NULL;
+	uint32_t exceptions = 0;
+	unsigned int n = 0;
+
+	*claimed = NULL;
+	*pending = 0;
+
+	exceptions = cpu_spin_lock_xsave(&rng_pool_lock);
+	for (n = 0; n < RNG_POOL_JOBS; n++) {
+		rbuf = &rng_pool[n];
+
+		switch (rbuf->state) {
+		case RNG_BUF_PENDING:
+			*pending |= rbuf->job_id;
+			break;
+		case RNG_BUF_READY:
+			rbuf->state = RNG_BUF_BUSY;
+			*claimed = rbuf;
+			goto out;
+		case RNG_BUF_ERROR:
+			RNG_TRACE("CAAM Status 0x%08" PRIx32,
+				  rbuf->jobctx.status);
+			ret = job_status_to_tee_result(rbuf->jobctx.status);
+			rbuf->state = RNG_BUF_EMPTY;
+			goto out;
+		default:
+			break;
+		}
+	}
+out:
+	cpu_spin_unlock_xrestore(&rng_pool_lock, exceptions);
+
+	return ret;
+}
+
+/*
+ * Serve @len bytes from the completed jobs of the pool, waiting on the Job
+ * Ring for the pending ones when none is ready
+ */
+static TEE_Result rng_pool_read(uint8_t *buf, size_t len)
+{
+	TEE_Result ret = TEE_SUCCESS;
+	struct rng_buf *rbuf = NULL;
+	uint32_t pending = 0;
+	size_t cnt = 0;
+
+	while (len) {
+		rng_pool_submit();
+
+		ret = rng_pool_claim(&rbuf, &pending);
+		if (ret)
+			break;
+
+		if (rbuf) {
+			cnt = rng_buf_take(rbuf, buf, len);
+			buf += cnt;
+			len -= cnt;
+			continue;
+		}
+
+		/* Job Ring busy with other jobs, don't wait for the pool */
+		if (!pending)
+			return do_rng_read(buf, len);
+
+		/* Completions are delivered from the dequeue */
+		caam_jr_dequeue(pending, 100);
+	}
+
+	/* Start refilling what this request has consumed */
+	rng_pool_submit();
+
+	return ret;
+}
+#endif /* CFG_CAAM_RNG_POOL */
+
+/*
+ * Return random data, small requests are served from the pool of
+ * pre-generated data if enabled
+ *
+ * @buf  [out] data buffer
+ * @len  number of bytes to returns
+ */
+static TEE_Result rng_read(uint8_t *buf, size_t len)
+{
+#ifdef CFG_CAAM_RNG_POOL
+	if (rng_pool_ready && len < RNG_POOL_BUF_SIZE)
+		return rng_pool_read(buf, len);
+#endif
+
+	return do_rng_read(buf, len);
+}
 #endif /* CFG_NXP_CAAM_RNG_DRV */
 
 /*
@@ -335,6 +610,11 @@ enum caam_status caam_rng_init(vaddr_t ctrl_addr)
 		retstatus = caam_rng_instantiation();
 	}
 
+#if defined(CFG_NXP_CAAM_RNG_DRV) && defined(CFG_CAAM_RNG_POOL)
+	if (retstatus == CAAM_NO_ERROR)
+		retstatus = rng_pool_init();
+#endif
+
 	if (retstatus != CAAM_NO_ERROR)
 		do_free();
 
@@ -343,6 +623,11 @@ enum caam_status caam_rng_init(vaddr_t ctrl_addr)
 
 #ifdef CFG_NXP_CAAM_RNG_DRV
 #ifdef CFG_WITH_SOFTWARE_PRNG
+static TEE_Result __maybe_unused bulk_rng_read(void *buf, size_t len)
+{
+	return do_rng_read(buf, len);
+}
+
 void plat_rng_init(void)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -361,6 +646,8 @@ void plat_rng_init(void)
 	}
 
 	RNG_TRACE("PRNG seeded from CAAM");
+
+	crypto_rng_set_bulk_source(bulk_rng_read);
 }
 #else /* !CFG_WITH_SOFTWARE_PRNG */
 TEE_Result hw_get_random_bytes(void *buf, size_t blen)
@@ -368,7 +655,7 @@ TEE_Result hw_get_random_bytes(void *buf, size_t blen)
 	if (!buf)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	return do_rng_read(buf, blen);
+	return rng_read(buf, blen);
 }
 
 void plat_rng_init(void)
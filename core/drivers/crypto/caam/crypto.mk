@@ -139,6 +139,22 @@ CFG_CAAM_ITR ?= y
 # Keep the CFG_JR_INDEX as secure at runtime
 CFG_NXP_CAAM_RUNTIME_JR ?= y
 
+# Number of Job Rings kept by the secure world at runtime, starting at
+# CFG_JR_INDEX. Jobs are spread over the rings by CPU core so that cores
+# don't contend on a single Job Ring lock.
+CFG_NXP_CAAM_JR_NUM ?= 1
+ifneq ($(CFG_NXP_CAAM_JR_NUM),1)
+$(call force, CFG_NXP_CAAM_RUNTIME_JR,y,Mandated by CFG_NXP_CAAM_JR_NUM)
+endif
+
+# Dequeue the completed jobs from the Job Ring interrupt handler instead
+# of only waking up the cores polling the Job Ring.
+CFG_NXP_CAAM_JR_ITR_DEQUEUE ?= n
+ifeq ($(CFG_NXP_CAAM_JR_ITR_DEQUEUE),y)
+$(call force, CFG_CAAM_ITR,y,Mandated by CFG_NXP_CAAM_JR_ITR_DEQUEUE)
+$(call force, CFG_NXP_CAAM_RUNTIME_JR,y,Mandated by CFG_NXP_CAAM_JR_ITR_DEQUEUE)
+endif
+
 # Define the RSA Private Key Format used by the CAAM
 #   Format #1: (n, d)
 #   Format #2: (p, q, d)
@@ -148,6 +164,11 @@ CFG_NXP_CAAM_RSA_KEY_FORMAT ?= 3
 # Disable device tree status of the secure job ring
 CFG_CAAM_JR_DISABLE_NODE ?= y
 
+# Let the CAAM DMA write output data in place in TA private memory (heap,
+# stack, static data) even if the buffer is not cache line aligned, instead
+# of bouncing the partial cache lines at its boundaries.
+CFG_NXP_CAAM_DMA_TA_INPLACE ?= y
+
 # Define the default CAAM private key encryption generation and the bignum
 # maximum size needed.
 # CAAM_KEY_PLAIN_TEXT    -> 4096 bits
@@ -161,6 +182,18 @@ CFG_CORE_BIGNUM_MAX_BITS ?= 4576
 # In this case the performance is drastically reduced.
 CFG_CAAM_RNG_RUNTIME_PR ?= n
 
+# CAAM RNG job pool
+# When this flag is y, CFG_CAAM_RNG_POOL_JOBS RNG jobs of
+# CFG_CAAM_RNG_POOL_BUF_SIZE bytes are kept in flight on the Job Ring and
+# requests smaller than a buffer are served from the completed ones instead
+# of building, submitting and waiting for a job each.
+CFG_CAAM_RNG_POOL ?= n
+CFG_CAAM_RNG_POOL_JOBS ?= 4
+CFG_CAAM_RNG_POOL_BUF_SIZE ?= 256
+ifeq ($(CFG_CAAM_RNG_POOL),y)
+$(call force, CFG_NXP_CAAM_RUNTIME_JR,y,Mandated by CFG_CAAM_RNG_POOL)
+endif
+
 # Enable CAAM non-crypto drivers
 $(foreach drv, $(caam-drivers), $(eval CFG_NXP_CAAM_$(drv)_DRV ?= y))
 
@@ -177,6 +210,15 @@ endif
 ifeq ($(CFG_CRYPTO_DRIVER), y)
 CFG_CRYPTO_DRIVER_DEBUG ?= 0
 
+# Run synchronous CAAM jobs through the drvcrypt asynchronous job interface:
+# the calling thread sleeps instead of spinning on the Job Ring, so jobs
+# from several threads can be in flight. A waiter polls for
+# CFG_CRYPTO_DRV_ASYNC_SPIN_US before sleeping, then is woken up at least
+# every CFG_CRYPTO_DRV_ASYNC_POLL_MS to poll again.
+CFG_CRYPTO_DRV_ASYNC ?= n
+CFG_CRYPTO_DRV_ASYNC_SPIN_US ?= 50
+CFG_CRYPTO_DRV_ASYNC_POLL_MS ?= 1
+
 # Enable CAAM Crypto drivers
 $(foreach drv, $(caam-crypto-drivers), $(eval CFG_NXP_CAAM_$(drv)_DRV ?= y))
 
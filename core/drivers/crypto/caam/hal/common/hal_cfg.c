@@ -77,6 +77,32 @@ exit_get_conf:
 	return retstatus;
 }
 
+enum caam_status caam_hal_cfg_get_extra_jobring(struct caam_jrcfg *jrcfg,
+						unsigned int idx,
+						struct caam_jrcfg *extra)
+{
+	paddr_t jr_offset = jrcfg->offset + idx * JRX_BLOCK_SIZE;
+	void *fdt = get_dt();
+
+	if (jr_offset / JRX_BLOCK_SIZE > caam_hal_ctrl_jrnum(jrcfg->base))
+		return CAAM_OUT_OF_BOUND;
+
+	if (IS_ENABLED(CFG_MX8M) && caam_hal_cfg_is_hab_jr(jr_offset))
+		return CAAM_OUT_OF_BOUND;
+
+	*extra = *jrcfg;
+	extra->offset = jr_offset;
+	/* Default to consecutive interrupt lines if not defined in the DTB */
+	extra->it_num = jrcfg->it_num + idx;
+
+	if (fdt)
+		caam_hal_cfg_get_extra_jobring_dt(fdt, extra);
+
+	caam_hal_jr_prepare_backup(extra->base, extra->offset);
+
+	return CAAM_NO_ERROR;
+}
+
 void __weak caam_hal_cfg_setup_nsjobring(struct caam_jrcfg *jrcfg)
 {
 	enum caam_status status = CAAM_FAILURE;
@@ -97,11 +123,13 @@ void __weak caam_hal_cfg_setup_nsjobring(struct caam_jrcfg *jrcfg)
 #ifdef CFG_NXP_CAAM_RUNTIME_JR
 		/*
 		 * When the Cryptographic driver is enabled, keep the
-		 * Secure Job Ring don't release it.
+		 * Secure Job Rings don't release them.
 		 * But save the configuration to restore it when
 		 * device reset after suspend.
 		 */
-		if (jr_offset == jrcfg->offset) {
+		if (jr_offset >= jrcfg->offset &&
+		    jr_offset < jrcfg->offset +
+				CFG_NXP_CAAM_JR_NUM * JRX_BLOCK_SIZE) {
 			caam_hal_jr_prepare_backup(jrcfg->base, jr_offset);
 			continue;
 		}
@@ -128,3 +128,28 @@ void caam_hal_cfg_disable_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
 		}
 	}
 }
+
+void caam_hal_cfg_get_extra_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
+{
+	int node = fdt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
+	int jr_it_num = 0;
+
+	for (; node != -FDT_ERR_NOTFOUND;
+	     node = fdt_node_offset_by_compatible(fdt, node,
+						  dt_jr_match_table)) {
+		if (fdt_reg_base_address(fdt, node) != jrcfg->offset)
+			continue;
+
+		HAL_TRACE("Found additional Job Ring node @%" PRId32, node);
+		if (!is_embedded_dt(fdt)) {
+			/* Disable JR for Normal World */
+			if (dt_enable_secure_status(fdt, node))
+				panic();
+		}
+
+		jr_it_num = dt_get_irq(fdt, node);
+		if (jr_it_num != DT_INFO_INVALID_INTERRUPT)
+			jrcfg->it_num = jr_it_num;
+		break;
+	}
+}
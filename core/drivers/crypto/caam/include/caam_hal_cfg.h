@@ -41,6 +41,22 @@ void caam_hal_cfg_hab_jr_mgmt(struct caam_jrcfg *jrcfg);
  */
 bool caam_hal_cfg_is_hab_jr(paddr_t jr_offset);
 
+/*
+ * Returns the configuration of an additional Job Ring used by the TEE.
+ * Additional Job Rings follow the one described by @jrcfg.
+ *
+ * @jrcfg   Job Ring configuration returned by caam_hal_cfg_get_conf()
+ * @idx     Index of the additional Job Ring, starting at 1
+ * @extra   [out] Additional Job Ring configuration
+ *
+ * Returns:
+ * CAAM_NO_ERROR       Success
+ * CAAM_OUT_OF_BOUND   Job Ring not available
+ */
+enum caam_status caam_hal_cfg_get_extra_jobring(struct caam_jrcfg *jrcfg,
+						unsigned int idx,
+						struct caam_jrcfg *extra);
+
 #ifdef CFG_DT
 /*
  * Returns the Job Ring configuration to be used by the TEE
@@ -65,6 +81,15 @@ void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg);
  * @jrcfg   Job Ring configuration
  */
 void caam_hal_cfg_disable_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg);
+
+/*
+ * Disable the DT node of an additional Job Ring used by secure world and
+ * update its interrupt number if defined in the DT node
+ *
+ * @fdt     Device Tree handle
+ * @jrcfg   [in/out] Additional Job Ring configuration
+ */
+void caam_hal_cfg_get_extra_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg);
 #else
 static inline void caam_hal_cfg_get_ctrl_dt(void *fdt __unused,
 					    vaddr_t *ctrl_base)
@@ -85,6 +110,12 @@ caam_hal_cfg_disable_jobring_dt(void *fdt __unused,
 				struct caam_jrcfg *jrcfg __unused)
 {
 }
+
+static inline void
+caam_hal_cfg_get_extra_jobring_dt(void *fdt __unused,
+				  struct caam_jrcfg *jrcfg __unused)
+{
+}
 #endif /* CFG_DT */
 
 #endif /* __CAAM_HAL_CFG_H__ */
@@ -17,6 +17,7 @@ struct caam_jobctx {
 	uint32_t *desc;      /* reference to the descriptor */
 	uint32_t status;     /* executed job status */
 	uint32_t id;         /* Job identifier */
+	uint8_t jr;          /* Job Ring the job is enqueued on */
 	bool completion;     /* job completion flag */
 	void *context;       /* caller job context */
 	void (*callback)(struct caam_jobctx *ctx); /* job completion callback */
@@ -68,16 +69,19 @@ struct caam_outring_entry {
 enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg);
 
 /*
- * Cancels a job ID. Remove the job from SW Job array
+ * Cancels a job. Remove the job from SW Job array of its Job Ring
  *
- * @job_id      Job ID
+ * @jobctx      Reference to the job context
  */
-void caam_jr_cancel(uint32_t job_id);
+void caam_jr_cancel(struct caam_jobctx *jobctx);
 
 /*
  * Checks if one of the given job IDs in bit mask format
  * is completed. If none is completed, wait until timeout expires.
  * Endlessly wait if @timeout_ms = UINT_MAX
+ * Job IDs are only unique within a Job Ring: when several Job Rings are
+ * used, the function may return as soon as a job with one of the given
+ * IDs completes on any of them, callers must check their job completion.
  *
  * @job_ids     Job IDs Mask
  * @timeout_ms  Timeout in millisecond
@@ -12,7 +12,10 @@
 #include <caam_utils_status.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/spinlock.h>
+#include <kernel/ts_manager.h>
+#include <kernel/user_ta.h>
 #include <mm/core_memprot.h>
+#include <mm/vm.h>
 #include <string.h>
 #include <tee/cache.h>
 
@@ -500,6 +503,33 @@ static TEE_Result check_buffer_alignment(struct priv_dmaobj *priv,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Return true if the output buffer @buf can be written in place by the
+ * CAAM DMA even though it starts and/or ends in the middle of a cache line.
+ *
+ * This is the case when @buf is inside the private memory of the calling
+ * TA: the TA is blocked in the syscall until the job completes, so the
+ * bytes sharing the boundary cache lines are not written meanwhile.
+ * Flushing the lines before the job and invalidating them after is then
+ * enough, and the partial lines don't need to be bounced.
+ *
+ * @buf  Output buffer
+ */
+static bool output_inplace_allowed(struct caambuf *buf)
+{
+	struct ts_session *sess = NULL;
+
+	if (!IS_ENABLED(CFG_NXP_CAAM_DMA_TA_INPLACE))
+		return false;
+
+	sess = ts_get_current_session_may_fail();
+	if (!sess || !is_user_ta_ctx(sess->ctx))
+		return false;
+
+	return vm_buf_is_inside_um_private(&to_user_ta_ctx(sess->ctx)->uctx,
+					   buf->data, buf->length);
+}
+
 /*
  * Go through all the @orig space to extract all physical area used to
  * map the buffer.
@@ -567,7 +597,8 @@ static TEE_Result check_buffer_boundary(struct caamdmaobj *obj,
 	 * Check the buffer alignment if the buffer is cacheable and
 	 * an output buffer.
 	 */
-	if (priv->type & DMAOBJ_OUTPUT && !orig->nocache) {
+	if (priv->type & DMAOBJ_OUTPUT && !orig->nocache &&
+	    !output_inplace_allowed(orig)) {
 		ret = check_buffer_alignment(priv, maxlen);
 		if (ret)
 			goto out;
@@ -78,6 +78,8 @@ void crypto_acipher_free_rsa_keypair(struct rsa_keypair *key)
 		rsa = drvcrypt_get_ops(CRYPTO_RSA);
 		if (rsa) {
 			CRYPTO_TRACE("RSA Keypair free");
+			/* Software fallbacks may have cached key state */
+			crypto_acipher_rsa_keypair_changed(key);
 			rsa->free_keypair(key);
 		}
 	}
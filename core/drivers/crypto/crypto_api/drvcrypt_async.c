@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Crypto Driver asynchronous job interface.
+ *
+ * Several threads may have jobs in flight at the same time. A thread
+ * waiting for its job polls the driver, which collects all completed
+ * jobs whoever submitted them, and wakes up the other waiters if it
+ * collected any. Between polls the waiting thread sleeps on a condition
+ * variable so the OP-TEE thread is released to normal world.
+ */
+#include <atomic.h>
+#include <drvcrypt.h>
+#include <drvcrypt_async.h>
+#include <kernel/delay.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
+
+static const struct drvcrypt_async_ops *async_ops;
+static struct mutex async_mu = MUTEX_INITIALIZER;
+static struct condvar async_cv = CONDVAR_INITIALIZER;
+/* Number of job completions, used to detect that waiters must be kicked */
+static uint32_t async_done_cnt;
+
+TEE_Result drvcrypt_async_register(const struct drvcrypt_async_ops *ops)
+{
+	if (async_ops || !ops || !ops->submit || !ops->poll) {
+		CRYPTO_TRACE("Fail to register async ops 0x%p", ops);
+		return TEE_ERROR_GENERIC;
+	}
+
+	CRYPTO_TRACE("Registering async ops 0x%p", ops);
+	async_ops = ops;
+
+	return TEE_SUCCESS;
+}
+
+bool drvcrypt_async_can_wait(void)
+{
+	return thread_get_id_may_fail() != THREAD_ID_INVALID &&
+	       thread_is_in_normal_mode() && !thread_foreign_intr_disabled();
+}
+
+TEE_Result drvcrypt_job_submit(struct drvcrypt_job *job)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!async_ops)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (!job || atomic_load_uint(&job->state) == DRVCRYPT_JOB_PENDING)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	job->result = TEE_ERROR_GENERIC;
+	atomic_store_uint(&job->state, DRVCRYPT_JOB_PENDING);
+
+	res = async_ops->submit(job);
+	if (res)
+		atomic_store_uint(&job->state, DRVCRYPT_JOB_IDLE);
+
+	return res;
+}
+
+void drvcrypt_job_done(struct drvcrypt_job *job, TEE_Result res)
+{
+	job->result = res;
+	if (job->callback)
+		job->callback(job);
+
+	/* The job may be released as soon as it is seen done */
+	atomic_store_uint(&job->state, DRVCRYPT_JOB_DONE);
+	atomic_inc32(&async_done_cnt);
+}
+
+static bool job_is_done(struct drvcrypt_job *job)
+{
+	return atomic_load_uint(&job->state) == DRVCRYPT_JOB_DONE;
+}
+
+/*
+ * Collect completed jobs and wake up the sleeping waiters if some of
+ * them may have been completed.
+ */
+static void poll_jobs(bool can_wait)
+{
+	uint32_t cnt = atomic_load_u32(&async_done_cnt);
+
+	async_ops->poll();
+
+	if (can_wait && atomic_load_u32(&async_done_cnt) != cnt) {
+		mutex_lock(&async_mu);
+		condvar_broadcast(&async_cv);
+		mutex_unlock(&async_mu);
+	}
+}
+
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job)
+{
+	uint64_t spin = timeout_init_us(CFG_CRYPTO_DRV_ASYNC_SPIN_US);
+	bool can_wait = drvcrypt_async_can_wait();
+
+	if (!async_ops || !job)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (atomic_load_uint(&job->state) == DRVCRYPT_JOB_IDLE)
+		return TEE_ERROR_BAD_STATE;
+
+	/*
+	 * Most jobs complete in a few microseconds: poll first to spare a
+	 * round trip to normal world. Contexts not allowed to sleep poll
+	 * until completion.
+	 */
+	while (!job_is_done(job) && (!can_wait || !timeout_elapsed(spin)))
+		poll_jobs(can_wait);
+
+	if (!job_is_done(job)) {
+		mutex_lock(&async_mu);
+		while (!job_is_done(job)) {
+			condvar_wait_timeout(&async_cv, &async_mu,
+					     CFG_CRYPTO_DRV_ASYNC_POLL_MS);
+			mutex_unlock(&async_mu);
+			poll_jobs(can_wait);
+			mutex_lock(&async_mu);
+		}
+		mutex_unlock(&async_mu);
+	}
+
+	atomic_store_uint(&job->state, DRVCRYPT_JOB_IDLE);
+
+	return job->result;
+}
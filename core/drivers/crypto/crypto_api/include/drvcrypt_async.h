@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Crypto Driver asynchronous job interface.
+ */
+#ifndef __DRVCRYPT_ASYNC_H__
+#define __DRVCRYPT_ASYNC_H__
+
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Job state
+ */
+enum drvcrypt_job_state {
+	DRVCRYPT_JOB_IDLE = 0, /* Not submitted or completion collected */
+	DRVCRYPT_JOB_PENDING,  /* Submitted to the hardware */
+	DRVCRYPT_JOB_DONE,     /* Completed, result is valid */
+};
+
+/*
+ * Asynchronous job. The caller owns the structure and must keep it alive
+ * until drvcrypt_job_wait() has returned.
+ */
+struct drvcrypt_job {
+	void *hw_ctx;	     /* Driver specific job context */
+	void *data;	     /* Caller private data */
+	/*
+	 * Optional completion callback, called from the driver completion
+	 * path which may hold spinlocks: it must not sleep.
+	 */
+	void (*callback)(struct drvcrypt_job *job);
+	TEE_Result result;   /* Job result once completed */
+	unsigned int state;  /* Job state (enum drvcrypt_job_state) */
+};
+
+/*
+ * Asynchronous operations provided by a hardware driver
+ */
+struct drvcrypt_async_ops {
+	/* Starts @job, must return without waiting for its completion */
+	TEE_Result (*submit)(struct drvcrypt_job *job);
+	/* Collects completed jobs and calls drvcrypt_job_done() on them */
+	void (*poll)(void);
+};
+
+#ifdef CFG_CRYPTO_DRV_ASYNC
+/*
+ * Register the asynchronous job operations of the hardware driver
+ *
+ * @ops  Asynchronous operations
+ */
+TEE_Result drvcrypt_async_register(const struct drvcrypt_async_ops *ops);
+
+/*
+ * Return true if the current context may sleep while waiting for a job,
+ * that is a thread with foreign interrupts unmasked.
+ */
+bool drvcrypt_async_can_wait(void);
+
+/*
+ * Submit a job to the registered driver. On success the job is pending
+ * and drvcrypt_job_wait() must be called to collect its completion.
+ *
+ * @job  Job to submit
+ */
+TEE_Result drvcrypt_job_submit(struct drvcrypt_job *job);
+
+/*
+ * Wait for the completion of a submitted job and return its result.
+ * The job is first polled for a short while and then, if the context
+ * allows it, the thread sleeps and lets other threads submit their own
+ * jobs until a completion is collected.
+ *
+ * @job  Job submitted with drvcrypt_job_submit()
+ */
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job);
+
+/*
+ * Called by the driver when a job is completed, from any context
+ *
+ * @job  Completed job
+ * @res  Job result
+ */
+void drvcrypt_job_done(struct drvcrypt_job *job, TEE_Result res);
+#else
+static inline TEE_Result
+drvcrypt_async_register(const struct drvcrypt_async_ops *ops __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline bool drvcrypt_async_can_wait(void)
+{
+	return false;
+}
+
+static inline TEE_Result drvcrypt_job_submit(struct drvcrypt_job *job __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void drvcrypt_job_done(struct drvcrypt_job *job __unused,
+				     TEE_Result res __unused)
+{
+}
+#endif /* CFG_CRYPTO_DRV_ASYNC */
+
+#endif /* __DRVCRYPT_ASYNC_H__ */
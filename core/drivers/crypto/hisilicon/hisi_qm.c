@@ -79,6 +79,9 @@
 #define QM_CQ_CQE_SIZE_SHIFT	12
 /* CQE */
 #define QM_CQE_PHASE(cqe) (((cqe)->w7) & QM_FVT_CFG_RDY_BIT)
+/* Empty CQ polls before waiting between polls */
+#define QM_POLL_SPIN_CNT	64
+#define QM_POLL_DELAY_US	1
 
 enum qm_mailbox_common_cmd {
 	QM_MB_CMD_SQC = 0x0,
@@ -776,43 +779,75 @@ static void qm_sq_tail_update(struct hisi_qp *qp)
 		qp->sq_tail++;
 }
 
+static enum hisi_drv_status qm_fill_sqe(struct hisi_qp *qp, void *msg)
+{
+	enum hisi_drv_status ret = HISI_QM_DRVCRYPT_NO_ERR;
+	struct hisi_qm *qm = qp->qm;
+	void *sqe = NULL;
+
+	sqe = (void *)((vaddr_t)qp->sqe + qm->sqe_size * qp->sq_tail);
+	memset(sqe, 0, qm->sqe_size);
+
+	ret = qp->fill_sqe(sqe, msg);
+	if (ret) {
+		EMSG("Fail to fill sqe");
+		return ret;
+	}
+
+	qm_sq_tail_update(qp);
+
+	return HISI_QM_DRVCRYPT_NO_ERR;
+}
+
 /*
  * One task thread will just bind to one hardware queue, and
  * hardware does not support msi. So we have no lock here.
  */
-enum hisi_drv_status hisi_qp_send(struct hisi_qp *qp, void *msg)
+enum hisi_drv_status hisi_qp_send_batch(struct hisi_qp *qp, void **msgs,
+					uint32_t num)
 {
 	enum hisi_drv_status ret = HISI_QM_DRVCRYPT_NO_ERR;
 	struct hisi_qm *qm = NULL;
-	void *sqe = NULL;
+	uint16_t sq_tail = 0;
+	uint32_t i = 0;
 
 	if (!qp) {
 		EMSG("QP is NULL");
 		return HISI_QM_DRVCRYPT_EINVAL;
 	}
 
+	if (!msgs || !num || num > HISI_QM_BATCH_MAX) {
+		EMSG("Invalid qp send batch parameters");
+		return HISI_QM_DRVCRYPT_EINVAL;
+	}
+
 	qm = qp->qm;
 	ret = qm->dev_status_check(qm);
 	if (ret)
 		return ret;
 
-	sqe = (void *)((vaddr_t)qp->sqe + qm->sqe_size * qp->sq_tail);
-	memset(sqe, 0, qm->sqe_size);
-
-	ret = qp->fill_sqe(sqe, msg);
-	if (ret) {
-		EMSG("Fail to fill sqe");
-		return ret;
+	sq_tail = qp->sq_tail;
+	for (i = 0; i < num; i++) {
+		ret = qm_fill_sqe(qp, msgs[i]);
+		if (ret) {
+			/* Nothing has been submitted to the hardware yet */
+			qp->sq_tail = sq_tail;
+			return ret;
+		}
 	}
 
-	qm_sq_tail_update(qp);
-
+	/* Ring the doorbell once for all the tasks of the batch */
 	dsb();
 	qm_db(qm, qp->qp_id, QM_DOORBELL_CMD_SQ, qp->sq_tail, 0);
 
 	return HISI_QM_DRVCRYPT_NO_ERR;
 }
 
+enum hisi_drv_status hisi_qp_send(struct hisi_qp *qp, void *msg)
+{
+	return hisi_qp_send_batch(qp, &msg, 1);
+}
+
 static void qm_cq_head_update(struct hisi_qp *qp)
 {
 	if (qp->cq_head == HISI_QM_Q_DEPTH - 1) {
@@ -823,33 +858,54 @@ static void qm_cq_head_update(struct hisi_qp *qp)
 	}
 }
 
-static enum hisi_drv_status hisi_qp_recv(struct hisi_qp *qp, void *msg)
+/*
+ * Collects the tasks of the batch completed in the CQ, ringing the CQ
+ * doorbell once for all of them. Returns the number of tasks collected.
+ *
+ * @qp: Handle of Queue Pair
+ * @msgs: The messages of the batch, in submission order
+ * @num: Number of messages of the batch
+ * @first: SQ index of the first message of the batch
+ * @task_ret: [out] Set to the first task error
+ */
+static uint32_t hisi_qp_recv(struct hisi_qp *qp, void **msgs, uint32_t num,
+			     uint16_t first, enum hisi_drv_status *task_ret)
 {
 	enum hisi_drv_status ret = HISI_QM_DRVCRYPT_NO_ERR;
 	struct hisi_qm *qm = qp->qm;
 	struct qm_cqe *cqe = NULL;
 	void *sqe = NULL;
+	uint32_t cnt = 0;
+	uint16_t idx = 0;
 
-	ret = qm->dev_status_check(qm);
-	if (ret)
-		return ret;
+	for (cnt = 0; cnt < num; cnt++) {
+		cqe = qp->cqe + qp->cq_head;
+		if (QM_CQE_PHASE(cqe) != qp->cqc_phase)
+			break;
 
-	cqe = qp->cqe + qp->cq_head;
-	if (QM_CQE_PHASE(cqe) == qp->cqc_phase) {
 		dsb_osh();
-		sqe = (void *)((vaddr_t)qp->sqe + qm->sqe_size * cqe->sq_head);
-		ret = qp->parse_sqe(sqe, msg);
-		qm_cq_head_update(qp);
-		qm_db(qm, qp->qp_id, QM_DOORBELL_CMD_CQ, qp->cq_head, 0);
-		if (ret) {
+		idx = (cqe->sq_head + HISI_QM_Q_DEPTH - first) %
+		      HISI_QM_Q_DEPTH;
+		if (idx < num) {
+			sqe = (void *)((vaddr_t)qp->sqe +
+				       qm->sqe_size * cqe->sq_head);
+			ret = qp->parse_sqe(sqe, msgs[idx]);
+		} else {
+			ret = HISI_QM_DRVCRYPT_FAIL;
+		}
+
+		if (ret && !*task_ret) {
 			EMSG("Fail to parse sqe");
-			return ret;
+			*task_ret = ret;
 		}
-	} else {
-		return HISI_QM_DRVCRYPT_NO_ERR;
+
+		qm_cq_head_update(qp);
 	}
 
-	return HISI_QM_DRVCRYPT_RECV_DONE;
+	if (cnt)
+		qm_db(qm, qp->qp_id, QM_DOORBELL_CMD_CQ, qp->cq_head, 0);
+
+	return cnt;
 }
 
 static void qm_dfx_dump(struct hisi_qm *qm)
@@ -867,32 +923,68 @@ static void qm_dfx_dump(struct hisi_qm *qm)
 	}
 }
 
-enum hisi_drv_status hisi_qp_recv_sync(struct hisi_qp *qp, void *msg)
+enum hisi_drv_status hisi_qp_recv_batch_sync(struct hisi_qp *qp, void **msgs,
+					     uint32_t num)
 {
+	enum hisi_drv_status task_ret = HISI_QM_DRVCRYPT_NO_ERR;
 	enum hisi_drv_status ret = HISI_QM_DRVCRYPT_NO_ERR;
 	uint32_t timeout = 0;
+	uint32_t done = 0;
+	uint32_t idle = 0;
+	uint32_t cnt = 0;
+	uint16_t first = 0;
 
-	if (!qp || !qp->qm || !msg) {
+	if (!qp || !qp->qm || !msgs || !num || num > HISI_QM_BATCH_MAX) {
 		EMSG("Invalid qp recv sync parameters");
 		return HISI_QM_DRVCRYPT_EINVAL;
 	}
 
+	first = (qp->sq_tail + HISI_QM_Q_DEPTH - num) % HISI_QM_Q_DEPTH;
 	timeout = timeout_init_us(QM_SINGLE_WAIT_TIME *
 				  HISI_QM_RECV_SYNC_TIMEOUT);
 	while (!timeout_elapsed(timeout)) {
-		ret = hisi_qp_recv(qp, msg);
-		if (ret) {
-			if (ret != HISI_QM_DRVCRYPT_RECV_DONE) {
-				EMSG("QM recv task error");
-				qm_dfx_dump(qp->qm);
-				return ret;
-			} else {
-				return HISI_QM_DRVCRYPT_NO_ERR;
-			}
+		ret = qp->qm->dev_status_check(qp->qm);
+		if (ret)
+			break;
+
+		cnt = hisi_qp_recv(qp, msgs + done, num - done,
+				   (first + done) % HISI_QM_Q_DEPTH, &task_ret);
+		done += cnt;
+		if (done == num) {
+			ret = task_ret;
+			break;
 		}
+
+		/*
+		 * Short tasks complete within a few polls, back off for
+		 * the long ones to not hammer the memory system.
+		 */
+		if (cnt)
+			idle = 0;
+		else if (++idle > QM_POLL_SPIN_CNT)
+			udelay(QM_POLL_DELAY_US);
+	}
+
+	if (ret) {
+		EMSG("QM recv task error");
+		qm_dfx_dump(qp->qm);
+		return ret;
 	}
 
+	if (done == num)
+		return HISI_QM_DRVCRYPT_NO_ERR;
+
 	EMSG("QM recv task timeout");
 	qm_dfx_dump(qp->qm);
 	return HISI_QM_DRVCRYPT_ETMOUT;
 }
+
+enum hisi_drv_status hisi_qp_recv_sync(struct hisi_qp *qp, void *msg)
+{
+	if (!msg) {
+		EMSG("Invalid qp recv sync parameters");
+		return HISI_QM_DRVCRYPT_EINVAL;
+	}
+
+	return hisi_qp_recv_batch_sync(qp, &msg, 1);
+}
@@ -22,6 +22,7 @@
 #define HISI_QM_PF_Q_NUM 64
 #define HISI_QM_VF_Q_NUM 15
 #define HISI_QM_Q_DEPTH 8
+#define HISI_QM_BATCH_MAX (HISI_QM_Q_DEPTH - 1)
 #define PHASE_DEFAULT_VAL 0x1
 
 #define HISI_QM_ABNML_INT_MASK 0x100004
@@ -259,6 +260,17 @@ void hisi_qm_release_qp(struct hisi_qp *qp);
  */
 enum hisi_drv_status hisi_qp_send(struct hisi_qp *qp, void *msg);
 
+/**
+ * @Description: Send a batch of SQEs to Kunpeng dev, ringing the doorbell
+ * once for the whole batch
+ * @param qp: Handle of Queue Pair
+ * @param msgs: The messages
+ * @param num: Number of messages, at most HISI_QM_BATCH_MAX
+ * @return success: HISI_QM_DRVCRYPT_NO_ERR，fail: HISI_QM_DRVCRYPT_EINVAL
+ */
+enum hisi_drv_status hisi_qp_send_batch(struct hisi_qp *qp, void **msgs,
+					uint32_t num);
+
 /**
  * @Description: Recevice result from Kunpeng dev
  * @param qp: Handle of Queue Pair
@@ -268,4 +280,16 @@ enum hisi_drv_status hisi_qp_send(struct hisi_qp *qp, void *msg);
  */
 enum hisi_drv_status hisi_qp_recv_sync(struct hisi_qp *qp, void *msg);
 
+/**
+ * @Description: Recevice the results of a batch sent with
+ * hisi_qp_send_batch() from Kunpeng dev
+ * @param qp: Handle of Queue Pair
+ * @param msgs: The messages, as given to hisi_qp_send_batch()
+ * @param num: Number of messages
+ * @return success: HISI_QM_DRVCRYPT_NO_ERR
+ * fail: HISI_QM_DRVCRYPT_EINVAL/ETMOUT or the first task error
+ */
+enum hisi_drv_status hisi_qp_recv_batch_sync(struct hisi_qp *qp, void **msgs,
+					     uint32_t num);
+
 #endif
@@ -7,6 +7,7 @@
 #include <drvcrypt.h>
 #include <drvcrypt_cipher.h>
 #include <initcall.h>
+#include <stdlib_ext.h>
 #include <trace.h>
 #include <utee_defines.h>
 
@@ -32,6 +33,26 @@ static TEE_Result sec_do_cipher_task(struct hisi_qp *qp, void *msg)
 	return TEE_SUCCESS;
 }
 
+static TEE_Result sec_do_cipher_batch(struct hisi_qp *qp, void **msgs,
+				      uint32_t num)
+{
+	enum hisi_drv_status ret = HISI_QM_DRVCRYPT_NO_ERR;
+
+	ret = hisi_qp_send_batch(qp, msgs, num);
+	if (ret) {
+		EMSG("Fail to send batch, ret=%d", ret);
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	ret = hisi_qp_recv_batch_sync(qp, msgs, num);
+	if (ret) {
+		EMSG("Recv batch error, ret=%d", ret);
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result sec_cipher_des_get_c_key_len(size_t key_len,
 					       uint8_t *c_key_len)
 {
@@ -677,11 +698,73 @@ static void sec_free_buffer(struct sec_cipher_ctx *c_ctx)
 	c_ctx->out = NULL;
 }
 
+/*
+ * Large ECB, CTR and CBC decryption updates don't chain the data between
+ * blocks, they are split in tasks submitted as one batch to let the SEC
+ * process them in parallel.
+ */
+static uint32_t sec_cipher_batch_num(struct sec_cipher_ctx *c_ctx)
+{
+	if (c_ctx->mode != C_MODE_ECB && c_ctx->mode != C_MODE_CTR &&
+	    (c_ctx->mode != C_MODE_CBC || c_ctx->encrypt))
+		return 1;
+
+	return MIN(c_ctx->len / SEC_CIPHER_BATCH_MIN_LEN, HISI_QM_BATCH_MAX);
+}
+
+static TEE_Result sec_cipher_do_batch(struct sec_cipher_ctx *c_ctx,
+				      uint32_t num)
+{
+	void *msgs[HISI_QM_BATCH_MAX] = { };
+	struct sec_cipher_ctx *sub = NULL;
+	TEE_Result ret = TEE_SUCCESS;
+	size_t chunk = 0;
+	size_t offs = 0;
+	uint32_t i = 0;
+
+	sub = calloc(num, sizeof(*sub));
+	if (!sub) {
+		EMSG("Fail to alloc batch ctx");
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	chunk = ROUNDDOWN(c_ctx->len / num, AES_SM4_BLOCK_SIZE);
+	for (i = 0; i < num; i++, offs += chunk) {
+		sub[i] = *c_ctx;
+		sub[i].in = c_ctx->in + offs;
+		sub[i].in_dma = c_ctx->in_dma + offs;
+		sub[i].out = c_ctx->out + offs;
+		sub[i].out_dma = c_ctx->out_dma + offs;
+		sub[i].len = chunk;
+		if (i == num - 1)
+			sub[i].len = c_ctx->len - offs;
+
+		/* Each task starts with the IV of its first block */
+		if (c_ctx->mode == C_MODE_CTR)
+			ctr_iv_inc(sub[i].iv, offs >> CTR_MODE_LEN_SHIFT);
+		else if (c_ctx->mode == C_MODE_CBC && offs)
+			memcpy(sub[i].iv, c_ctx->in + offs - c_ctx->iv_len,
+			       c_ctx->iv_len);
+
+		if (c_ctx->iv_len)
+			sub[i].iv_dma = virt_to_phys(sub[i].iv);
+
+		msgs[i] = sub + i;
+	}
+
+	ret = sec_do_cipher_batch(c_ctx->qp, msgs, num);
+
+	free_wipe(sub);
+
+	return ret;
+}
+
 static TEE_Result sec_cipher_update(struct drvcrypt_cipher_update *dupdate)
 {
 	struct sec_cipher_ctx *c_ctx = NULL;
 	TEE_Result ret = TEE_SUCCESS;
 	size_t padding_size = 0;
+	uint32_t batch_num = 0;
 
 	ret = sec_cipher_param_check(dupdate);
 	if (ret)
@@ -701,7 +784,11 @@ static TEE_Result sec_cipher_update(struct drvcrypt_cipher_update *dupdate)
 	memcpy(c_ctx->in + padding_size, dupdate->src.data,
 	       dupdate->src.length);
 
-	ret = sec_do_cipher_task(c_ctx->qp, c_ctx);
+	batch_num = sec_cipher_batch_num(c_ctx);
+	if (batch_num > 1)
+		ret = sec_cipher_do_batch(c_ctx, batch_num);
+	else
+		ret = sec_do_cipher_task(c_ctx->qp, c_ctx);
 	if (ret)
 		goto free_buffer;
 
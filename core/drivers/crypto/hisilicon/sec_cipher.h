@@ -28,6 +28,7 @@
 #define LEFT_MOST_BIT			7
 #define CTR_SRC_ALIGN_MASK		0xf
 #define CTR_SRC_BLOCK_SIZE		0x10
+#define SEC_CIPHER_BATCH_MIN_LEN	0x10000
 
 #define CKEY_LEN_128_BIT		0x1
 #define CKEY_LEN_192_BIT		0x2
@@ -5,10 +5,18 @@
  */
 
 #include <crypto/crypto.h>
+#include <initcall.h>
+#include <kernel/mutex.h>
+#include <kernel/panic.h>
 #include <rng_support.h>
 #include <se050.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee/tee_cryp_utl.h>
 
+/* Bytes requested from the secure element per APDU */
+#define RNG_BLOCK_SIZE		CFG_NXP_SE05X_RNG_BLOCK_SIZE
+
 static TEE_Result do_rng_read(void *buf, size_t blen)
 {
 	sss_status_t status = kStatus_SSS_Success;
@@ -24,6 +32,105 @@ static TEE_Result do_rng_read(void *buf, size_t blen)
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_NXP_SE05X_RNG_SEED
+/*
+ * Two rounds over the 32 Fortuna pools, pool 0 then holds enough data to
+ * trigger a reseed on the next read
+ */
+#define RNG_SEED_EVENTS		64
+#define RNG_SEED_EVENT_SIZE	32
+
+/*
+ * The secure element is only an entropy source of the software PRNG: the
+ * PRNG is seeded at boot before the session with the secure element is
+ * open, its pools are fed in bulk once the session is available.
+ */
+static TEE_Result se050_rng_seed(void)
+{
+	uint8_t block[RNG_BLOCK_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int pnum = 0;
+	size_t events = 0;
+	size_t n = 0;
+
+	COMPILE_TIME_ASSERT(!(RNG_BLOCK_SIZE % RNG_SEED_EVENT_SIZE));
+
+	while (events < RNG_SEED_EVENTS) {
+		res = do_rng_read(block, sizeof(block));
+		if (res) {
+			EMSG("Failed to read the SE050 RNG: %#"PRIx32, res);
+			break;
+		}
+
+		for (n = 0; n < sizeof(block) && events < RNG_SEED_EVENTS;
+		     n += RNG_SEED_EVENT_SIZE, events++)
+			crypto_rng_add_event(CRYPTO_RNG_SRC_SECURE_ELEMENT,
+					     &pnum, block + n,
+					     RNG_SEED_EVENT_SIZE);
+	}
+
+	memzero_explicit(block, sizeof(block));
+
+	return res;
+}
+
+driver_init_late(se050_rng_seed);
+#else
+/*
+ * Output of the last APDU not consumed yet, at the end of @data, so that a
+ * small request doesn't cost an APDU of its own
+ */
+static struct {
+	uint8_t data[RNG_BLOCK_SIZE];
+	size_t len;
+	struct mutex mu;
+} reservoir = { .mu = MUTEX_INITIALIZER };
+
+/* Called with the reservoir mutex held */
+static size_t reservoir_take(uint8_t *buf, size_t blen)
+{
+	uint8_t *data = reservoir.data + sizeof(reservoir.data) - reservoir.len;
+	size_t n = MIN(blen, reservoir.len);
+
+	memcpy(buf, data, n);
+	memzero_explicit(data, n);
+	reservoir.len -= n;
+
+	return n;
+}
+
+static TEE_Result rng_read(uint8_t *buf, size_t blen)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	mutex_lock(&reservoir.mu);
+
+	n = reservoir_take(buf, blen);
+	buf += n;
+	blen -= n;
+
+	/* Whole blocks go straight to the caller */
+	n = ROUNDDOWN(blen, RNG_BLOCK_SIZE);
+	if (n) {
+		res = do_rng_read(buf, n);
+		buf += n;
+		blen -= n;
+	}
+
+	if (!res && blen) {
+		res = do_rng_read(reservoir.data, sizeof(reservoir.data));
+		if (!res) {
+			reservoir.len = sizeof(reservoir.data);
+			reservoir_take(buf, blen);
+		}
+	}
+
+	mutex_unlock(&reservoir.mu);
+
+	return res;
+}
+
 void plat_rng_init(void)
 {
 }
@@ -33,5 +140,6 @@ TEE_Result hw_get_random_bytes(void *buf, size_t blen)
 	if (!buf)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	return do_rng_read(buf, blen);
+	return rng_read(buf, blen);
 }
+#endif
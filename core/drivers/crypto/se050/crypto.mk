@@ -62,10 +62,20 @@ $(call force,CFG_APDU_PTA,y,Mandated by CFG_NXP_SE05X_APDU)
 endif
 
 # Random Number Generator
+# CFG_NXP_SE05X_RNG_BLOCK_SIZE bytes are requested per APDU, what a request
+# doesn't use is kept for the next ones. With CFG_NXP_SE05X_RNG_SEED=y the
+# secure element only feeds the software PRNG instead of serving each
+# request.
 CFG_NXP_SE05X_RNG_DRV ?= y
+CFG_NXP_SE05X_RNG_BLOCK_SIZE ?= 256
+CFG_NXP_SE05X_RNG_SEED ?= n
 ifeq ($(CFG_NXP_SE05X_RNG_DRV),y)
+ifeq ($(CFG_NXP_SE05X_RNG_SEED),y)
+$(call force,CFG_WITH_SOFTWARE_PRNG,y,Required by CFG_NXP_SE05X_RNG_SEED)
+else
 $(call force,CFG_WITH_SOFTWARE_PRNG,n)
 endif
+endif
 
 se050-one-enabled = $(call cfg-one-enabled, \
                         $(foreach v,$(1), CFG_NXP_SE05X_$(v)_DRV))
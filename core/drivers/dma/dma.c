@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <drivers/dma.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
+#include <string.h>
+#include <tee/cache.h>
+#include <trace.h>
+#include <util.h>
+
+/* Number of transfers handed at once to the channel driver */
+#define DMA_XFER_BATCH	8
+
+static struct dma_chan *memcpy_chan;
+
+void dma_register_memcpy_chan(struct dma_chan *chan)
+{
+	assert(chan && chan->ops && chan->ops->copy);
+
+	if (!memcpy_chan)
+		memcpy_chan = chan;
+	else
+		DMSG("DMA memcpy channel already registered");
+}
+
+/* Return the byte size of the physically contiguous start of @va */
+static size_t contig_len(const uint8_t *va, size_t len)
+{
+	paddr_t pa = virt_to_phys((void *)va);
+	size_t l = MIN(len, SMALL_PAGE_SIZE - ((vaddr_t)va & SMALL_PAGE_MASK));
+
+	while (l < len && virt_to_phys((void *)(va + l)) == pa + l)
+		l += MIN(len - l, (size_t)SMALL_PAGE_SIZE);
+
+	return l;
+}
+
+/*
+ * Return TEE_ERROR_NOT_SUPPORTED if the buffers can't be reached by the
+ * DMA, the copy is then done by the CPU.
+ */
+static TEE_Result dma_copy(struct dma_chan *chan, uint8_t *dst,
+			   const uint8_t *src, size_t len)
+{
+	struct dma_xfer xfer[DMA_XFER_BATCH] = { };
+	bool dst_nsec = tee_vbuf_is_non_sec(dst, len);
+	bool src_nsec = tee_vbuf_is_non_sec(src, len);
+	TEE_Result res = TEE_SUCCESS;
+	size_t count = 0;
+	size_t n = 0;
+	size_t l = 0;
+
+	/* Each buffer must have a single security attribute */
+	if ((!dst_nsec && !tee_vbuf_is_sec(dst, len)) ||
+	    (!src_nsec && !tee_vbuf_is_sec(src, len)))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	for (n = 0; n < len; n += l) {
+		l = MIN(contig_len(dst + n, len - n),
+			contig_len(src + n, len - n));
+		xfer[count] = (struct dma_xfer){
+			.dst = virt_to_phys(dst + n),
+			.src = virt_to_phys((void *)(src + n)),
+			.len = l,
+			.dst_nsec = dst_nsec,
+			.src_nsec = src_nsec,
+		};
+		if (!xfer[count].dst || !xfer[count].src)
+			return TEE_ERROR_NOT_SUPPORTED;
+
+		count++;
+		if (count == ARRAY_SIZE(xfer)) {
+			res = chan->ops->copy(chan, xfer, count);
+			if (res)
+				return res;
+			count = 0;
+		}
+	}
+
+	if (count)
+		return chan->ops->copy(chan, xfer, count);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result dma_memcpy(void *dst, const void *src, size_t len)
+{
+	struct dma_chan *chan = memcpy_chan;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!chan || len < chan->min_len)
+		goto cpu_copy;
+
+	/*
+	 * Dirty lines of the destination are flushed so that they can't be
+	 * evicted over the copied data, lines allocated meanwhile by
+	 * speculative accesses are invalidated after the copy.
+	 */
+	res = cache_operation(TEE_CACHECLEAN, (void *)src, len);
+	if (!res)
+		res = cache_operation(TEE_CACHEFLUSH, dst, len);
+	if (!res)
+		res = dma_copy(chan, dst, src, len);
+	if (!res)
+		return cache_operation(TEE_CACHEINVALIDATE, dst, len);
+	if (res != TEE_ERROR_NOT_SUPPORTED && res != TEE_ERROR_ACCESS_DENIED)
+		return res;
+
+cpu_copy:
+	memcpy(dst, src, len);
+
+	return TEE_SUCCESS;
+}
@@ -0,0 +1 @@
+srcs-y += dma.c
@@ -47,6 +47,7 @@
 #define GICD_ITARGETSR(n)	(0x800 + (n) * 4)
 #define GICD_ICFGR(n)		(0xc00 + (n) * 4)
 #define GICD_IGROUPMODR(n)	(0xd00 + (n) * 4)
+#define GICD_IROUTER(n)		(0x6000 + (n) * 8)
 #define GICD_SGIR		(0xF00)
 
 #ifdef CFG_ARM_GICV3
@@ -109,6 +110,8 @@
 #define ITARGETSR_FIELD_MASK	0xff
 
 #define GICD_TYPER_IT_LINES_NUM_MASK	0x1f
+#define GICD_TYPER_NO1N			BIT32(25)
+#define GICD_IROUTER_IRM		BIT64(31)
 #define GICC_IAR_IT_ID_MASK	0x3ff
 #define GICC_IAR_CPU_ID_MASK	0x7
 #define GICC_IAR_CPU_ID_SHIFT	10
@@ -126,6 +129,11 @@
 #define GICD_SGIR_CPU_TARGET_LIST_SHIFT		16
 
 /* GICD ICFGR bit fields */
+/* Priority of secure interrupts, lower values are more urgent */
+#define GIC_DEFAULT_PRIO		0x1
+/* Values from this one on are masked by the ICC_PMR/GICC_PMR setting */
+#define GIC_SEC_PRIO_LIMIT		0x80
+
 #define GICD_ICFGR_TYPE_EDGE		2
 #define GICD_ICFGR_TYPE_LEVEL		0
 #define GICD_ICFGR_FIELD_BITS		2
@@ -138,6 +146,7 @@ struct gic_data {
 	vaddr_t gicd_base;
 #if defined(CFG_ARM_GICV3)
 	vaddr_t gicr_base[CFG_TEE_CORE_NB_CORE];
+	uint64_t core_aff[CFG_TEE_CORE_NB_CORE];
 #endif
 	size_t max_it;
 	uint32_t per_cpu_group_status;
@@ -434,14 +443,28 @@ static int gic_dt_get_irq(const uint32_t *properties, int count, uint32_t *type,
 	int it_num = DT_INFO_INVALID_INTERRUPT;
 	uint32_t detection_type = IRQ_TYPE_NONE;
 	uint32_t interrupt_type = GIC_PPI;
+	uint32_t it_prio = 0;
 
-	if (!properties || count < 2 || count > 3)
+	if (!properties || count < 2 || count > 4)
 		return DT_INFO_INVALID_INTERRUPT;
 
 	interrupt_type = fdt32_to_cpu(properties[0]);
 	it_num = (int)fdt32_to_cpu(properties[1]);
 
-	if (count == 3) {
+	/*
+	 * An optional 4th cell holds the priority of a secure SPI, 0 for
+	 * the default one. It must stay in the secure half of the range.
+	 */
+	if (count == 4) {
+		it_prio = fdt32_to_cpu(properties[3]);
+		if (interrupt_type != GIC_SPI ||
+		    it_prio >= GIC_SEC_PRIO_LIMIT) {
+			EMSG("Invalid priority %#"PRIx32, it_prio);
+			return DT_INFO_INVALID_INTERRUPT;
+		}
+	}
+
+	if (count >= 3) {
 		detection_type = fdt32_to_cpu(properties[2]) & GENMASK_32(3, 0);
 		if (interrupt_type == GIC_PPI &&
 		    detection_type != IRQ_TYPE_EDGE_RISING) {
@@ -473,12 +496,13 @@ static int gic_dt_get_irq(const uint32_t *properties, int count, uint32_t *type,
 		*type = detection_type;
 
 	if (prio)
-		*prio = 0;
+		*prio = it_prio;
 
 	return it_num;
 }
 
 static void __maybe_unused probe_redist_base_addrs(vaddr_t *gicr_base_addrs,
+						   uint64_t *core_aff,
 						   paddr_t gicr_base_pa)
 {
 	size_t sz = GICR_V3_PCPUBASE_SIZE;
@@ -511,6 +535,11 @@ static void __maybe_unused probe_redist_base_addrs(vaddr_t *gicr_base_addrs,
 		if (core_pos < CFG_TEE_CORE_NB_CORE) {
 			DMSG("GICR_BASE[%zu] at %#"PRIxVA, core_pos, va);
 			gicr_base_addrs[core_pos] = va;
+			/* Affinity fields are laid out as in GICD_IROUTER */
+			core_aff[core_pos] = mpidr & (MPIDR_AFF0_MASK |
+						      MPIDR_AFF1_MASK |
+						      MPIDR_AFF2_MASK |
+						      MPIDR_AFF3_MASK);
 		} else {
 			EMSG("Skipping too large core_pos %zu from GICR_TYPER",
 			     core_pos);
@@ -553,7 +582,8 @@ static void gic_init_base_addr(paddr_t gicc_base_pa, paddr_t gicd_base_pa,
 	gd->max_it = probe_max_it(gicc_base, gicd_base);
 #if defined(CFG_ARM_GICV3)
 	if (affinity_routing_is_enabled(gd) && gicr_base_pa)
-		probe_redist_base_addrs(gd->gicr_base, gicr_base_pa);
+		probe_redist_base_addrs(gd->gicr_base, gd->core_aff,
+					gicr_base_pa);
 #endif
 	gd->chip.ops = &gic_ops;
 
@@ -660,6 +690,32 @@ static void gic_it_add(struct gic_data *gd, size_t it)
 #endif
 }
 
+static void gic_it_set_route(struct gic_data *gd __maybe_unused,
+			     size_t it __maybe_unused,
+			     uint8_t cpu_mask __maybe_unused)
+{
+#if defined(CFG_ARM_GICV3)
+	uint64_t route = GICD_IROUTER_IRM;
+	size_t pos = 0;
+
+	assert(it >= GIC_SPI_BASE);
+
+	/* A single core is targeted by its affinity, several by 1 of N */
+	if (IS_POWER_OF_TWO(cpu_mask)) {
+		pos = __builtin_ctz(cpu_mask);
+		if (pos < CFG_TEE_CORE_NB_CORE && gd->gicr_base[pos])
+			route = gd->core_aff[pos];
+	}
+
+	/* Keep the current routing if 1 of N isn't implemented */
+	if (route == GICD_IROUTER_IRM &&
+	    io_read32(gd->gicd_base + GICD_TYPER) & GICD_TYPER_NO1N)
+		return;
+
+	io_write64(gd->gicd_base + GICD_IROUTER(it), route);
+#endif
+}
+
 static void gic_it_set_cpu_mask(struct gic_data *gd, size_t it,
 				uint8_t cpu_mask)
 {
@@ -675,6 +731,12 @@ static void gic_it_set_cpu_mask(struct gic_data *gd, size_t it,
 	/* Assigned to group0 */
 	assert(!(io_read32(gd->gicd_base + GICD_IGROUPR(idx)) & mask));
 
+	/* GICD_ITARGETSR is ignored when affinity routing is enabled */
+	if (affinity_routing_is_enabled(gd)) {
+		gic_it_set_route(gd, it, cpu_mask);
+		return;
+	}
+
 	/* Route it to selected CPUs */
 	target = io_read32(itargetsr);
 	target_shift = (it % NUM_TARGETS_PER_REG) * ITARGETSR_FIELD_BITS;
@@ -965,7 +1027,7 @@ void interrupt_main_handler(void)
 #endif /*CFG_CORE_WORKAROUND_ARM_NMFI*/
 
 static void gic_op_add(struct itr_chip *chip, size_t it,
-		       uint32_t type, uint32_t prio __unused)
+		       uint32_t type, uint32_t prio)
 {
 	struct gic_data *gd = container_of(chip, struct gic_data, chip);
 
@@ -1006,7 +1068,7 @@ static void gic_op_add(struct itr_chip *chip, size_t it,
 		gic_it_add(gd, it);
 		/* Set the CPU mask to deliver interrupts to any online core */
 		gic_it_set_cpu_mask(gd, it, 0xff);
-		gic_it_set_prio(gd, it, 0x1);
+		gic_it_set_prio(gd, it, prio ? prio : GIC_DEFAULT_PRIO);
 		if (type != IRQ_TYPE_NONE)
 			gic_it_set_type(gd, it, type);
 	}
@@ -1088,6 +1150,10 @@ static void gic_op_set_affinity(struct itr_chip *chip, size_t it,
 	if (it > gd->max_it)
 		panic();
 
+	/* Per-CPU interrupts are banked, they can't be routed */
+	if (it < GIC_SPI_BASE)
+		return;
+
 	gic_it_set_cpu_mask(gd, it, cpu_mask);
 }
 
@@ -1098,7 +1164,7 @@ static TEE_Result dt_get_gic_chip_cb(struct dt_pargs *arg, void *priv_data,
 {
 	int itr_num = DT_INFO_INVALID_INTERRUPT;
 	struct itr_chip *chip = priv_data;
-	uint32_t phandle_args[3] = { };
+	uint32_t phandle_args[4] = { };
 	uint32_t type = 0;
 	uint32_t prio = 0;
 
@@ -1108,7 +1174,7 @@ static TEE_Result dt_get_gic_chip_cb(struct dt_pargs *arg, void *priv_data,
 	 * gic_dt_get_irq() expects phandle arguments passed are still in DT
 	 * format (big-endian) whereas struct dt_pargs carries converted
 	 * formats. Therefore swap again phandle arguments. gic_dt_get_irq()
-	 * consumes only the 2 first arguments.
+	 * consumes up to the 4 first arguments.
 	 */
 	if (arg->args_count < 2)
 		return TEE_ERROR_GENERIC;
@@ -1117,6 +1183,8 @@ static TEE_Result dt_get_gic_chip_cb(struct dt_pargs *arg, void *priv_data,
 	phandle_args[1] = cpu_to_fdt32(arg->args[1]);
 	if (arg->args_count >= 3)
 		phandle_args[2] = cpu_to_fdt32(arg->args[2]);
+	if (arg->args_count >= 4)
+		phandle_args[3] = cpu_to_fdt32(arg->args[3]);
 
 	itr_num = gic_dt_get_irq((const void *)phandle_args, arg->args_count,
 				 &type, &prio);
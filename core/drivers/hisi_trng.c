@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: BSD-2-Clause
 /* Copyright (c) 2023 HiSilicon Limited. */
 
+#include <drivers/hwrng_burst.h>
 #include <initcall.h>
 #include <io.h>
 #include <kernel/spinlock.h>
@@ -9,9 +10,11 @@
 #include <platform_config.h>
 #include <rng_support.h>
 #include <string.h>
+#include <string_ext.h>
 
 #define HTRNG_RANDATA_REG 0xF0
 #define HTRNG_BYTES 4U
+#define HTRNG_BURST_WORDS 8U
 
 #define POLL_PERIOD 10
 #define POLL_TIMEOUT 1000
@@ -23,16 +26,22 @@ struct hisi_trng {
 static unsigned int trng_lock = SPINLOCK_UNLOCK;
 static struct hisi_trng *trng_dev;
 
-static TEE_Result trng_read(uint32_t *val)
+static TEE_Result trng_read(uint32_t *words, size_t nwords)
 {
 	TEE_Result ret = TEE_SUCCESS;
 	uint32_t exceptions = 0;
+	size_t n = 0;
 
+	/* Take the lock once for the whole block rather than per word */
 	exceptions = cpu_spin_lock_xsave(&trng_lock);
-	if (IO_READ32_POLL_TIMEOUT(trng_dev->base + HTRNG_RANDATA_REG,
-				   *val, *val, POLL_PERIOD, POLL_TIMEOUT)) {
-		EMSG("Hardware busy");
-		ret = TEE_ERROR_BUSY;
+	for (n = 0; n < nwords; n++) {
+		if (IO_READ32_POLL_TIMEOUT(trng_dev->base + HTRNG_RANDATA_REG,
+					   words[n], words[n], POLL_PERIOD,
+					   POLL_TIMEOUT)) {
+			EMSG("Hardware busy");
+			ret = TEE_ERROR_BUSY;
+			break;
+		}
 	}
 	cpu_spin_unlock_xrestore(&trng_lock, exceptions);
 
@@ -41,10 +50,10 @@ static TEE_Result trng_read(uint32_t *val)
 
 TEE_Result hw_get_random_bytes(void *buf, size_t len)
 {
-	TEE_Result ret = TEE_ERROR_GENERIC;
+	uint32_t words[HTRNG_BURST_WORDS] = { 0 };
+	TEE_Result ret = TEE_SUCCESS;
 	size_t current_len = 0;
-	uint32_t val = 0;
-	size_t size = 0;
+	size_t nwords = 0;
 
 	if (!trng_dev) {
 		EMSG("No valid TRNG device");
@@ -57,16 +66,22 @@ TEE_Result hw_get_random_bytes(void *buf, size_t len)
 	}
 
 	while (current_len < len) {
-		ret = trng_read(&val);
-		if (ret)
-			return TEE_ERROR_BUSY;
-
-		size = MIN(HTRNG_BYTES, len - current_len);
-		memcpy((uint8_t *)buf + current_len, &val, size);
-		current_len += size;
+		nwords = MIN(HTRNG_BURST_WORDS,
+			     DIV_ROUND_UP(len - current_len, HTRNG_BYTES));
+		ret = trng_read(words, nwords);
+		if (ret) {
+			ret = TEE_ERROR_BUSY;
+			break;
+		}
+
+		current_len += hwrng_burst_copy((uint8_t *)buf + current_len,
+						len - current_len, words,
+						nwords);
 	}
 
-	return TEE_SUCCESS;
+	memzero_explicit(words, sizeof(words));
+
+	return ret;
 }
 
 static TEE_Result trng_init(void)
@@ -30,3 +30,23 @@ struct i2c_dev *i2c_create_dev(struct i2c_ctrl *i2c_ctrl, const void *fdt,
 
 	return i2c_dev;
 }
+
+TEE_Result i2c_transfer(struct i2c_dev *i2c_dev, struct i2c_msg *msgs,
+			size_t count)
+{
+	const struct i2c_ctrl_ops *ops = i2c_dev->ctrl->ops;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (ops->transfer)
+		return ops->transfer(i2c_dev, msgs, count);
+
+	for (n = 0; !res && n < count; n++) {
+		if (msgs[n].flags & I2C_MSG_RD)
+			res = i2c_read(i2c_dev, msgs[n].buf, msgs[n].len);
+		else
+			res = i2c_write(i2c_dev, msgs[n].buf, msgs[n].len);
+	}
+
+	return res;
+}
@@ -10,6 +10,7 @@
 #include <kernel/delay.h>
 #include <kernel/dt.h>
 #include <libfdt.h>
+#include <limits.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <platform_config.h>
@@ -379,22 +380,51 @@ static TEE_Result i2c_init_transfer(uint8_t bid, uint8_t chip)
 	return i2c_write_data(bid, &chip, 1);
 }
 
-TEE_Result imx_i2c_read(uint8_t bid, uint8_t chip, uint8_t *buf, int len)
+TEE_Result imx_i2c_transfer(uint8_t bid, uint8_t chip, struct i2c_msg *msgs,
+			    size_t count)
 {
 	TEE_Result ret = TEE_SUCCESS;
+	uint8_t addr = 0;
+	uint32_t tmp = 0;
+	size_t n = 0;
 
 	if (bid >= ARRAY_SIZE(i2c_bus))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	if ((len && !buf) || chip > 0x7F)
+	if (!count || chip > 0x7F)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	if (!i2c_bus[bid].va)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	ret = i2c_init_transfer(bid, chip << 1 | BIT(0));
-	if (!ret)
-		ret = i2c_read_data(bid, buf, len);
+	for (n = 0; n < count; n++) {
+		if ((msgs[n].len && !msgs[n].buf) || msgs[n].len > INT_MAX)
+			return TEE_ERROR_BAD_PARAMETERS;
+		/* A read can only be terminated by a stop condition */
+		if ((msgs[n].flags & I2C_MSG_RD) && n != count - 1)
+			return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	for (n = 0; !ret && n < count; n++) {
+		addr = chip << 1;
+		if (msgs[n].flags & I2C_MSG_RD)
+			addr |= BIT(0);
+
+		if (!n) {
+			ret = i2c_init_transfer(bid, addr);
+		} else {
+			tmp = i2c_io_read8(bid, I2CR) | I2CR_RSTA;
+			i2c_io_write8(bid, I2CR, tmp);
+			ret = i2c_write_data(bid, &addr, 1);
+		}
+		if (ret)
+			break;
+
+		if (msgs[n].flags & I2C_MSG_RD)
+			ret = i2c_read_data(bid, msgs[n].buf, msgs[n].len);
+		else
+			ret = i2c_write_data(bid, msgs[n].buf, msgs[n].len);
+	}
 
 	if (i2c_idle_bus(bid))
 		IMSG("bus not idle");
@@ -402,27 +432,24 @@ TEE_Result imx_i2c_read(uint8_t bid, uint8_t chip, uint8_t *buf, int len)
 	return ret;
 }
 
-TEE_Result imx_i2c_write(uint8_t bid, uint8_t chip, const uint8_t *buf, int len)
+TEE_Result imx_i2c_read(uint8_t bid, uint8_t chip, uint8_t *buf, int len)
 {
-	TEE_Result ret = TEE_SUCCESS;
+	struct i2c_msg msg = { .flags = I2C_MSG_RD, .buf = buf, .len = len };
 
-	if (bid >= ARRAY_SIZE(i2c_bus))
+	if (len < 0)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	if ((len && !buf) || chip > 0x7F)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	if (!i2c_bus[bid].va)
-		return TEE_ERROR_BAD_PARAMETERS;
+	return imx_i2c_transfer(bid, chip, &msg, 1);
+}
 
-	ret = i2c_init_transfer(bid, chip << 1);
-	if (!ret)
-		ret = i2c_write_data(bid, buf, len);
+TEE_Result imx_i2c_write(uint8_t bid, uint8_t chip, const uint8_t *buf, int len)
+{
+	struct i2c_msg msg = { .buf = (uint8_t *)buf, .len = len };
 
-	if (i2c_idle_bus(bid))
-		IMSG("bus not idle");
+	if (len < 0)
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	return ret;
+	return imx_i2c_transfer(bid, chip, &msg, 1);
 }
 
 TEE_Result imx_i2c_probe(uint8_t bid, uint8_t chip)
@@ -3,19 +3,30 @@
  * Copyright (c) 2024 Andes Technology Corporation
  */
 
+#include <config.h>
 #include <crypto/crypto.h>
 #include <encoding.h>
+#include <initcall.h>
 #include <kernel/delay.h>
 #include <kernel/panic.h>
 #include <riscv.h>
 #include <rng_support.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee/tee_cryp_utl.h>
+#include <utee_defines.h>
+#include <util.h>
 
 #define RNG_TIMEOUT_US	1000000
 
+/* Samples read from the seed CSR in a row */
+#define RNG_BATCH_SAMPLES	32
+/* Samples hashed into each conditioned block, a 2:1 input to output ratio */
+#define RNG_COND_SAMPLES	(TEE_SHA256_HASH_SIZE * 2 / sizeof(uint16_t))
+
 static bool __must_check seed_get_random_u16(uint16_t *val)
 {
-	uint64_t timeout = timeout_init_us(RNG_TIMEOUT_US);
+	uint64_t timeout = 0;
 	uint32_t seed = 0;
 	uint32_t opst = 0;
 
@@ -39,6 +50,9 @@ static bool __must_check seed_get_random_u16(uint16_t *val)
 		case SEED_OPST_BIST:
 		case SEED_OPST_WAIT:
 		default:
+			/* Only arm the timeout when the source isn't ready */
+			if (!timeout)
+				timeout = timeout_init_us(RNG_TIMEOUT_US);
 			riscv_cpu_pause();
 		}
 	} while (!timeout_elapsed(timeout));
@@ -55,27 +69,132 @@ static bool __must_check seed_get_random_u16(uint16_t *val)
 	return false;
 }
 
-TEE_Result hw_get_random_bytes(void *buf, size_t len)
+static bool __must_check seed_get_samples(uint16_t *samples, size_t count)
 {
+	size_t n = 0;
+
+	for (n = 0; n < count; n++)
+		if (!seed_get_random_u16(samples + n))
+			return false;
+
+	return true;
+}
+
+static TEE_Result raw_get_random_bytes(void *buf, size_t len)
+{
+	uint16_t samples[RNG_BATCH_SAMPLES] = { };
 	uint8_t *ptr = buf;
-	uint16_t seed = 0;
+	size_t count = 0;
+	size_t n = 0;
 
 	while (len > 0) {
-		if (!seed_get_random_u16(&seed))
+		n = MIN(len, sizeof(samples));
+		count = DIV_ROUND_UP(n, sizeof(uint16_t));
+		if (!seed_get_samples(samples, count)) {
+			memzero_explicit(samples, sizeof(samples));
 			return TEE_ERROR_ACCESS_DENIED;
-		*ptr++ = seed & 0xff;
-		len--;
-		if (len > 0) {
-			*ptr++ = seed >> 8;
-			len--;
 		}
+
+		/* Low byte of each sample first */
+		memcpy(ptr, samples, n);
+		ptr += n;
+		len -= n;
 	}
 
+	memzero_explicit(samples, sizeof(samples));
+
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_RISCV_ZKR_RNG_CONDITIONED
+/* Set once the crypto API is initialized and SHA-256 can be used */
+static bool cond_ready;
+
+/* Each SHA-256 output block is made from RNG_COND_SAMPLES raw samples */
+static TEE_Result cond_get_random_bytes(void *buf, size_t len)
+{
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
+	uint16_t samples[RNG_COND_SAMPLES] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *ptr = buf;
+	void *ctx = NULL;
+	size_t n = 0;
+
+	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+
+	while (len) {
+		if (!seed_get_samples(samples, ARRAY_SIZE(samples))) {
+			res = TEE_ERROR_ACCESS_DENIED;
+			break;
+		}
+
+		res = crypto_hash_init(ctx);
+		if (!res)
+			res = crypto_hash_update(ctx, (uint8_t *)samples,
+						 sizeof(samples));
+		if (!res)
+			res = crypto_hash_final(ctx, digest, sizeof(digest));
+		if (res)
+			break;
+
+		n = MIN(len, sizeof(digest));
+		memcpy(ptr, digest, n);
+		ptr += n;
+		len -= n;
+	}
+
+	memzero_explicit(samples, sizeof(samples));
+	memzero_explicit(digest, sizeof(digest));
+	crypto_hash_free_ctx(ctx);
+
+	return res;
+}
+
+/* Runs after service_init_crypto() initcalls, crypto_init() is done */
+static TEE_Result riscv_zkr_rng_cond_init(void)
+{
+	cond_ready = true;
+
+	return TEE_SUCCESS;
+}
+service_init(riscv_zkr_rng_cond_init);
+
+/*
+ * The hash context is allocated on each call once the crypto API can be
+ * used, earlier requests, e.g. crypto_rng_read() from early boot without
+ * a software PRNG, get the raw samples.
+ */
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	if (cond_ready)
+		return cond_get_random_bytes(buf, len);
+
+	return raw_get_random_bytes(buf, len);
+}
+#else
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	return raw_get_random_bytes(buf, len);
+}
+#endif
+
 void plat_rng_init(void)
 {
 	if (!riscv_detect_csr_seed())
 		panic("RISC-V Zkr is not supported or unavailable in S-mode");
+
+	if (IS_ENABLED(CFG_WITH_SOFTWARE_PRNG)) {
+		/* Seed the PRNG with a whole batch of samples at once */
+		uint8_t seed[RNG_BATCH_SAMPLES * sizeof(uint16_t)] = { };
+
+		if (hw_get_random_bytes(seed, sizeof(seed)))
+			panic();
+
+		if (crypto_rng_init(seed, sizeof(seed)))
+			panic();
+
+		memzero_explicit(seed, sizeof(seed));
+	}
 }
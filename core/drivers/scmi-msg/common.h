@@ -128,7 +128,8 @@ bool scmi_msg_claim_channel(struct scmi_msg_channel *channel);
 void scmi_msg_release_channel(struct scmi_msg_channel *channel);
 
 /*
- * Entry for processing a channel using SMT shared memory protocol
+ * Entry for processing a channel using SMT shared memory protocol, with
+ * CFG_SCMI_MSG_SMT_BATCH until no message is pending in the channel
  * @channel_id: SCMI channel identifier provided by client
  * @payload_buf: Secure buffer where to copy input message
  */
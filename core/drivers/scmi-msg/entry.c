@@ -49,7 +49,12 @@ bool scmi_msg_claim_channel(struct scmi_msg_channel *channel)
 
 void scmi_msg_release_channel(struct scmi_msg_channel *channel)
 {
+	/* The lock orders the release before a new look at the channel */
+	uint32_t exceptions = cpu_spin_lock_xsave(&smt_channels_lock);
+
 	channel->busy = false;
+
+	cpu_spin_unlock_xrestore(&smt_channels_lock, exceptions);
 }
 
 void scmi_status_response(struct scmi_msg *msg, int32_t status)
@@ -4,6 +4,7 @@
  * Copyright (c) 2019-2022, Linaro Limited
  */
 #include <assert.h>
+#include <config.h>
 #include <drivers/scmi-msg.h>
 #include <drivers/scmi.h>
 #include <io.h>
@@ -59,37 +60,26 @@ static struct smt_header *channel_to_smt_hdr(struct scmi_msg_channel *channel)
 						sizeof(struct smt_header));
 }
 
+/* True when the agent has posted a message not yet processed */
+static bool smt_msg_pending(struct smt_header *smt_hdr)
+{
+	return !(READ_ONCE(smt_hdr->status) & SMT_STATUS_FREE);
+}
+
 /*
  * Creates a SCMI message instance in secure memory and push it in the SCMI
  * message drivers. Message structure contains SCMI protocol meta-data and
  * references to input payload in secure memory and output message buffer
  * in shared memory.
  */
-void scmi_entry_smt(unsigned int channel_id, uint32_t *payload_buf)
+static void process_smt_message(struct scmi_msg_channel *channel,
+				unsigned int channel_id,
+				struct smt_header *smt_hdr,
+				uint32_t *payload_buf)
 {
-	struct scmi_msg_channel *channel = NULL;
-	struct smt_header *smt_hdr = NULL;
 	size_t in_payload_size = 0;
 	uint32_t smt_status = 0;
 	struct scmi_msg msg = { };
-	bool error = true;
-
-	channel = plat_scmi_get_channel(channel_id);
-	if (!channel) {
-		DMSG("Invalid channel ID %u", channel_id);
-		return;
-	}
-
-	smt_hdr = channel_to_smt_hdr(channel);
-	if (!smt_hdr) {
-		DMSG("No shared buffer for channel ID %u", channel_id);
-		return;
-	}
-
-	if (!scmi_msg_claim_channel(channel)) {
-		DMSG("SCMI channel %u busy", channel_id);
-		goto out;
-	}
 
 	smt_status = READ_ONCE(smt_hdr->status);
 
@@ -98,13 +88,13 @@ void scmi_entry_smt(unsigned int channel_id, uint32_t *payload_buf)
 
 	if (in_payload_size > SCMI_SEC_PAYLOAD_SIZE) {
 		DMSG("SCMI payload too big %zu", in_payload_size);
-		goto out;
+		goto err;
 	}
 
 	if (smt_status & (SMT_STATUS_ERROR | SMT_STATUS_FREE)) {
 		DMSG("SCMI channel bad status 0x%x",
 		     smt_hdr->status & (SMT_STATUS_ERROR | SMT_STATUS_FREE));
-		goto out;
+		goto err;
 	}
 
 	/* Fill message */
@@ -127,15 +117,56 @@ void scmi_entry_smt(unsigned int channel_id, uint32_t *payload_buf)
 	/* Update message length with the length of the response message */
 	smt_hdr->length = msg.out_size_out + sizeof(smt_hdr->message_header);
 
-	scmi_msg_release_channel(channel);
-	error = false;
+	smt_hdr->status |= SMT_STATUS_FREE;
+	return;
+
+err:
+	DMSG("SCMI error");
+	smt_hdr->status |= SMT_STATUS_ERROR | SMT_STATUS_FREE;
+}
+
+void scmi_entry_smt(unsigned int channel_id, uint32_t *payload_buf)
+{
+	struct scmi_msg_channel *channel = NULL;
+	struct smt_header *smt_hdr = NULL;
+
+	channel = plat_scmi_get_channel(channel_id);
+	if (!channel) {
+		DMSG("Invalid channel ID %u", channel_id);
+		return;
+	}
+
+	smt_hdr = channel_to_smt_hdr(channel);
+	if (!smt_hdr) {
+		DMSG("No shared buffer for channel ID %u", channel_id);
+		return;
+	}
+
+	if (!IS_ENABLED(CFG_SCMI_MSG_SMT_BATCH)) {
+		if (!scmi_msg_claim_channel(channel)) {
+			DMSG("SCMI channel %u busy", channel_id);
+			smt_hdr->status |= SMT_STATUS_ERROR | SMT_STATUS_FREE;
+			return;
+		}
+		process_smt_message(channel, channel_id, smt_hdr, payload_buf);
+		scmi_msg_release_channel(channel);
+		return;
+	}
 
-out:
-	if (error) {
-		DMSG("SCMI error");
-		smt_hdr->status |= SMT_STATUS_ERROR | SMT_STATUS_FREE;
-	} else {
-		smt_hdr->status |= SMT_STATUS_FREE;
+	/*
+	 * The agent may post its next message as soon as it has read the
+	 * response to the previous one, without notifying us again. Keep
+	 * processing until the channel is empty. An entry finding the
+	 * channel empty or already claimed has nothing to do: the message
+	 * was consumed by, or will be seen by, the entry owning the
+	 * channel. That one checks the channel again once released so a
+	 * message posted while the other entry gave up isn't left behind.
+	 */
+	while (smt_msg_pending(smt_hdr) && scmi_msg_claim_channel(channel)) {
+		while (smt_msg_pending(smt_hdr))
+			process_smt_message(channel, channel_id, smt_hdr,
+					    payload_buf);
+		scmi_msg_release_channel(channel);
 	}
 }
 
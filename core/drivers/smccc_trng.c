@@ -6,12 +6,17 @@
 #include <assert.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <crypto/rng_source.h>
+#include <initcall.h>
+#include <kernel/callout.h>
+#include <kernel/delay.h>
 #include <kernel/panic.h>
 #include <kernel/thread_arch.h>
 #include <rng_support.h>
 #include <sm/std_smc.h>
 #include <stdbool.h>
 #include <string.h>
+#include <string_ext.h>
 #include <util.h>
 #include <tee_api_types.h>
 #include <tee/tee_cryp_utl.h>
@@ -45,6 +50,10 @@
 #define TRNG_MAX_RND_64		(192 / 8)
 #define TRNG_MAX_RND_32		(96 / 8)
 
+#define TRNG_BACKOFF_MIN_US		1
+#define TRNG_BACKOFF_MAX_US		1024
+#define TRNG_NO_ENTROPY_TIMEOUT_US	1000000
+
 /* Function ID discovered for getting random bytes or 0 if not supported */
 static uint32_t trng_rnd_fid;
 
@@ -126,36 +135,64 @@ static void read_samples(struct thread_smc_args *args, uint8_t *buf, size_t len)
 	read_bytes(args->a1, byte_count, &ptr, &rem);
 }
 
+static size_t trng_max_burst(void)
+{
+	if (trng_rnd_fid == ARM_SMCCC_TRNG_RND_64)
+		return TRNG_MAX_RND_64;
+
+	return TRNG_MAX_RND_32;
+}
+
+/* One TRNG_RND call for at most trng_max_burst() bytes */
+static unsigned long trng_rnd(uint8_t *buf, size_t len)
+{
+	struct thread_smc_args args = {
+		.a0 = trng_rnd_fid,
+		.a1 = len * 8,
+	};
+
+	thread_smccc(&args);
+	if (args.a0 == ARM_SMCCC_RET_TRNG_SUCCESS)
+		read_samples(&args, buf, len);
+
+	return args.a0;
+}
+
+/*
+ * The firmware returns NO_ENTROPY while its source is catching up, back
+ * off exponentially instead of calling it again right away, and give up
+ * once no progress has been made for TRNG_NO_ENTROPY_TIMEOUT_US.
+ */
 static TEE_Result __maybe_unused smccc_trng_read(void *buf, size_t len)
 {
-	struct thread_smc_args args = { };
+	unsigned int backoff = TRNG_BACKOFF_MIN_US;
+	size_t max_burst = 0;
 	uint8_t *ptr = buf;
+	uint64_t tref = 0;
 	size_t rem = len;
-	size_t max_burst = 0;
 
 	if (!smccc_trng_is_supported())
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	if (trng_rnd_fid == ARM_SMCCC_TRNG_RND_64)
-		max_burst = TRNG_MAX_RND_64;
-	else
-		max_burst = TRNG_MAX_RND_32;
+	max_burst = trng_max_burst();
 
 	while (rem) {
 		size_t burst = MIN(rem, max_burst);
 
-		args.a0 = trng_rnd_fid;
-		args.a1 = burst * 8;
-
-		thread_smccc(&args);
-
-		switch (args.a0) {
+		switch (trng_rnd(ptr, burst)) {
 		case ARM_SMCCC_RET_TRNG_SUCCESS:
-			read_samples(&args, ptr, burst);
 			rem -= burst;
 			ptr += burst;
+			backoff = TRNG_BACKOFF_MIN_US;
+			tref = 0;
 			break;
 		case ARM_SMCCC_RET_TRNG_NO_ENTROPY:
+			if (!tref)
+				tref = timeout_init_us(TRNG_NO_ENTROPY_TIMEOUT_US);
+			else if (timeout_elapsed(tref))
+				return TEE_ERROR_BUSY;
+			udelay(backoff);
+			backoff = MIN(backoff * 2, TRNG_BACKOFF_MAX_US);
 			break;
 		default:
 			return TEE_ERROR_GENERIC;
@@ -208,11 +245,64 @@ void plat_rng_init(void)
 
 		if (crypto_rng_init(seed, sizeof(seed)))
 			panic();
+
+		crypto_rng_set_bulk_source(smccc_trng_read);
 	}
 }
 
+#if defined(CFG_WITH_SOFTWARE_PRNG) && defined(CFG_ARM_SMCCC_TRNG_FEED)
+/*
+ * Keep feeding the Fortuna pools after the initial seed, one burst per
+ * period. The callout runs in interrupt context, the burst is queued and
+ * a NO_ENTROPY answer just skips a period.
+ */
+static struct callout trng_feed_callout;
+static unsigned int trng_feed_pnum;
+
+static bool trng_feed_cb(struct callout *co __unused)
+{
+	uint8_t sample[TRNG_MAX_RND_64] = { };
+	size_t len = trng_max_burst();
+
+	if (trng_rnd(sample, len) == ARM_SMCCC_RET_TRNG_SUCCESS)
+		crypto_rng_add_event(CRYPTO_RNG_SRC_FIRMWARE, &trng_feed_pnum,
+				     sample, len);
+	memzero_explicit(sample, sizeof(sample));
+
+	return true;
+}
+
+static TEE_Result smccc_trng_feed_init(void)
+{
+	if (smccc_trng_is_supported())
+		callout_add(&trng_feed_callout, trng_feed_cb,
+			    CFG_ARM_SMCCC_TRNG_FEED_MS);
+
+	return TEE_SUCCESS;
+}
+
+service_init(smccc_trng_feed_init);
+#endif
+
 /* If CFG_WITH_SOFTWARE_PRNG is disabled, TRNG is our HW RNG */
-#ifndef CFG_WITH_SOFTWARE_PRNG
+#if defined(CFG_CORE_RNG_SOURCES)
+static struct rng_source smccc_trng_source = {
+	.name = "smccc-trng",
+	.read = smccc_trng_read,
+	.quality = 8,
+	.bytes_per_sec = 256 * 1024,
+};
+
+static TEE_Result smccc_trng_source_init(void)
+{
+	if (smccc_trng_is_supported())
+		rng_source_register(&smccc_trng_source);
+
+	return TEE_SUCCESS;
+}
+
+early_init(smccc_trng_source_init);
+#elif !defined(CFG_WITH_SOFTWARE_PRNG)
 TEE_Result hw_get_random_bytes(void *buf, size_t len)
 {
 	return smccc_trng_read(buf, len);
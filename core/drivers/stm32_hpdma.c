@@ -7,6 +7,7 @@
 #include <config.h>
 #include <drivers/clk.h>
 #include <drivers/clk_dt.h>
+#include <drivers/dma.h>
 #include <drivers/stm32_gpio.h>
 #include <drivers/stm32_rif.h>
 #include <io.h>
@@ -14,6 +15,7 @@
 #include <kernel/delay.h>
 #include <kernel/dt.h>
 #include <kernel/dt_driver.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <libfdt.h>
@@ -28,6 +30,15 @@
 #define _HPDMA_RCFGLOCKR		U(0x008)
 #define _HPDMA_CIDCFGR(x)		(U(0x054) + U(0x080) * (x))
 #define _HPDMA_SEMCR(x)			(U(0x058) + U(0x080) * (x))
+#define _HPDMA_CFCR(x)			(U(0x05C) + U(0x080) * (x))
+#define _HPDMA_CSR(x)			(U(0x060) + U(0x080) * (x))
+#define _HPDMA_CCR(x)			(U(0x064) + U(0x080) * (x))
+#define _HPDMA_CTR1(x)			(U(0x090) + U(0x080) * (x))
+#define _HPDMA_CTR2(x)			(U(0x094) + U(0x080) * (x))
+#define _HPDMA_CBR1(x)			(U(0x098) + U(0x080) * (x))
+#define _HPDMA_CSAR(x)			(U(0x09C) + U(0x080) * (x))
+#define _HPDMA_CDAR(x)			(U(0x0A0) + U(0x080) * (x))
+#define _HPDMA_CLLR(x)			(U(0x0CC) + U(0x080) * (x))
 
 /*
  * CFGR register bitfields
@@ -66,6 +77,34 @@
 #define _HPDMA_SEMCR_SCID_MASK		GENMASK_32(5, 4)
 #define _HPDMA_SEMCR_SCID_SHIFT		U(4)
 
+/*
+ * CSR and CFCR register bitfields
+ */
+#define _HPDMA_CSR_TCF			BIT(8)
+#define _HPDMA_CSR_ERR_MASK		GENMASK_32(12, 10)
+#define _HPDMA_CSR_FLAGS_MASK		GENMASK_32(14, 8)
+
+/*
+ * CCR register bitfields
+ */
+#define _HPDMA_CCR_EN			BIT(0)
+#define _HPDMA_CCR_RESET		BIT(1)
+
+/*
+ * CTR1 register bitfields
+ */
+#define _HPDMA_CTR1_SDW_LOG2_SHIFT	U(0)
+#define _HPDMA_CTR1_SINC		BIT(3)
+#define _HPDMA_CTR1_SSEC		BIT(15)
+#define _HPDMA_CTR1_DDW_LOG2_SHIFT	U(16)
+#define _HPDMA_CTR1_DINC		BIT(19)
+#define _HPDMA_CTR1_DSEC		BIT(31)
+
+/*
+ * CTR2 register bitfields
+ */
+#define _HPDMA_CTR2_SWREQ		BIT(9)
+
 /*
  * Miscellaneous
  */
@@ -74,11 +113,19 @@
 
 #define HPDMA_NB_MAX_CID_SUPPORTED	U(3)
 
+/* Largest block size of a transfer that is a multiple of a word size */
+#define HPDMA_MAX_BLOCK_SIZE		U(0xFFFC)
+#define HPDMA_TIMEOUT_US		U(100000)
+/* Below this size, setting up the channel costs more than the copy */
+#define HPDMA_MEMCPY_MIN_SIZE		U(1024)
+
 struct hpdma_pdata {
 	struct clk *hpdma_clock;
 	struct rif_conf_data *conf_data;
 	unsigned int nb_channels;
 	vaddr_t base;
+	struct dma_chan memcpy_chan;
+	struct mutex memcpy_lock;
 
 	SLIST_ENTRY(hpdma_pdata) link;
 };
@@ -319,6 +366,121 @@ stm32_hpdma_pm(enum pm_op op, unsigned int pm_hint,
 	return TEE_SUCCESS;
 }
 
+#if defined(CFG_DRIVERS_DMA) && CFG_STM32_HPDMA_MEMCPY_CHANNEL >= 0
+static TEE_Result hpdma_copy_block(struct hpdma_pdata *hpdma_d, paddr_t dst,
+				   paddr_t src, size_t len, uint32_t tr1)
+{
+	unsigned int ch = CFG_STM32_HPDMA_MEMCPY_CHANNEL;
+	vaddr_t base = hpdma_d->base;
+	uint32_t sr = 0;
+
+	io_write32(base + _HPDMA_CFCR(ch), _HPDMA_CSR_FLAGS_MASK);
+	io_write32(base + _HPDMA_CTR1(ch), tr1);
+	io_write32(base + _HPDMA_CTR2(ch), _HPDMA_CTR2_SWREQ);
+	io_write32(base + _HPDMA_CBR1(ch), len);
+	io_write32(base + _HPDMA_CSAR(ch), src);
+	io_write32(base + _HPDMA_CDAR(ch), dst);
+	io_write32(base + _HPDMA_CLLR(ch), 0);
+	io_setbits32(base + _HPDMA_CCR(ch), _HPDMA_CCR_EN);
+
+	if (IO_READ32_POLL_TIMEOUT(base + _HPDMA_CSR(ch), sr,
+				   sr & (_HPDMA_CSR_TCF | _HPDMA_CSR_ERR_MASK),
+				   0, HPDMA_TIMEOUT_US) ||
+	    (sr & _HPDMA_CSR_ERR_MASK)) {
+		EMSG("HPDMA channel %u transfer failed, status %#"PRIx32,
+		     ch, sr);
+		io_setbits32(base + _HPDMA_CCR(ch), _HPDMA_CCR_RESET);
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result hpdma_copy(struct dma_chan *chan,
+			     const struct dma_xfer *xfer, size_t count)
+{
+	struct hpdma_pdata *hpdma_d = chan->priv;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int width_log2 = 0;
+	uint32_t tr1 = 0;
+	size_t len = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	/* The channel only has 32-bit address registers */
+	for (i = 0; i < count; i++)
+		if ((uint64_t)xfer[i].dst + xfer[i].len > BIT64(32) ||
+		    (uint64_t)xfer[i].src + xfer[i].len > BIT64(32))
+			return TEE_ERROR_NOT_SUPPORTED;
+
+	mutex_lock(&hpdma_d->memcpy_lock);
+
+	res = clk_enable(hpdma_d->hpdma_clock);
+	if (res)
+		goto out;
+
+	for (i = 0; !res && i < count; i++) {
+		/* Widest data width up to a word the transfer is aligned on */
+		if (!((xfer[i].dst | xfer[i].src | xfer[i].len) & 3))
+			width_log2 = 2;
+		else if (!((xfer[i].dst | xfer[i].src | xfer[i].len) & 1))
+			width_log2 = 1;
+		else
+			width_log2 = 0;
+
+		tr1 = _HPDMA_CTR1_SINC | _HPDMA_CTR1_DINC |
+		      SHIFT_U32(width_log2, _HPDMA_CTR1_SDW_LOG2_SHIFT) |
+		      SHIFT_U32(width_log2, _HPDMA_CTR1_DDW_LOG2_SHIFT);
+		if (!xfer[i].src_nsec)
+			tr1 |= _HPDMA_CTR1_SSEC;
+		if (!xfer[i].dst_nsec)
+			tr1 |= _HPDMA_CTR1_DSEC;
+
+		for (n = 0; !res && n < xfer[i].len; n += len) {
+			len = MIN(xfer[i].len - n, (size_t)HPDMA_MAX_BLOCK_SIZE);
+			res = hpdma_copy_block(hpdma_d, xfer[i].dst + n,
+					       xfer[i].src + n, len, tr1);
+		}
+	}
+
+	clk_disable(hpdma_d->hpdma_clock);
+out:
+	mutex_unlock(&hpdma_d->memcpy_lock);
+
+	return res;
+}
+
+static const struct dma_ops hpdma_memcpy_ops = {
+	.copy = hpdma_copy,
+};
+
+/* This function expects HPDMA bus clock is enabled */
+static void register_memcpy_chan(struct hpdma_pdata *hpdma_d)
+{
+	unsigned int ch = CFG_STM32_HPDMA_MEMCPY_CHANNEL;
+
+	/* The channel must be secure and privileged to be used by the core */
+	if (ch >= HPDMA_RIF_CHANNELS ||
+	    !(io_read32(hpdma_d->base + _HPDMA_SECCFGR) & BIT(ch)) ||
+	    !(io_read32(hpdma_d->base + _HPDMA_PRIVCFGR) & BIT(ch))) {
+		EMSG("HPDMA channel %u can't be used for memory copies", ch);
+		return;
+	}
+
+	mutex_init(&hpdma_d->memcpy_lock);
+	hpdma_d->memcpy_chan = (struct dma_chan){
+		.ops = &hpdma_memcpy_ops,
+		.min_len = HPDMA_MEMCPY_MIN_SIZE,
+		.priv = hpdma_d,
+	};
+	dma_register_memcpy_chan(&hpdma_d->memcpy_chan);
+}
+#else
+static void register_memcpy_chan(struct hpdma_pdata *hpdma_d __unused)
+{
+}
+#endif
+
 static TEE_Result stm32_hpdma_probe(const void *fdt, int node,
 				    const void *compat_data __unused)
 {
@@ -347,6 +509,8 @@ static TEE_Result stm32_hpdma_probe(const void *fdt, int node,
 	if (res)
 		panic("Failed to apply RIF config");
 
+	register_memcpy_chan(hpdma_d);
+
 	clk_disable(hpdma_d->hpdma_clock);
 
 	SLIST_INSERT_HEAD(&hpdma_list, hpdma_d, link);
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <crypto/rng_health.h>
 #include <drivers/clk.h>
 #include <drivers/clk_dt.h>
 #include <drivers/rstctrl.h>
@@ -16,6 +17,7 @@
 #include <kernel/dt.h>
 #include <kernel/dt_driver.h>
 #include <kernel/boot.h>
+#include <kernel/callout.h>
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <kernel/thread.h>
@@ -25,6 +27,7 @@
 #include <stdbool.h>
 #include <stm32_util.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee/tee_cryp_utl.h>
 
 #define RNG_CR			U(0x00)
@@ -69,6 +72,9 @@
 
 #define RNG_FIFO_BYTE_DEPTH	U(16)
 
+/* Min-entropy in bits claimed per data word for the health tests */
+#define RNG_SAMPLE_ENTROPY	8
+
 #define RNG_CONFIG_MASK		(RNG_CR_ENTROPY_SRC_MASK | RNG_CR_CED | \
 				 RNG_CR_CLKDIV)
 
@@ -96,8 +102,24 @@ struct stm32_rng_instance {
 	uint32_t health_test_conf;
 	uint32_t noise_ctrl_conf;
 	uint32_t rng_config;
+	struct rng_health health;
 	bool clock_error;
 	bool error_conceal;
+#if defined(CFG_STM32_RNG_KEEP_WARM)
+	struct callout idle_callout;
+	bool warm;
+	bool used;
+	/* FIFO data left over by a small request, at the end of @cache */
+	uint8_t cache[RNG_FIFO_BYTE_DEPTH];
+	size_t cache_len;
+#endif
+#if defined(CFG_STM32_RNG_RESUME_POOL)
+	/* RNG output read at suspend, at the end of @pool */
+	uint8_t pool[CFG_STM32_RNG_RESUME_POOL_SIZE];
+	size_t pool_len;
+	/* Conditioning reset of the resume still running, clock held */
+	bool resume_pending;
+#endif
 };
 
 /* Expect at most a single RNG instance */
@@ -128,6 +150,15 @@ static vaddr_t get_base(void)
  * 3. If SECS was set in step 1 (no auto-reset) wait for SECS to be
  * cleared by RNG. The random number generation is now back to normal.
  */
+/*
+ * The health tests restart from scratch once the noise source has been
+ * reset, a failure is otherwise sticky.
+ */
+static void reset_health(void)
+{
+	rng_health_init(&stm32_rng->health, RNG_SAMPLE_ENTROPY);
+}
+
 static void conceal_seed_error_cond_reset(void)
 {
 	struct stm32_rng_instance *dev = stm32_rng;
@@ -148,6 +179,7 @@ static void conceal_seed_error_cond_reset(void)
 		} else {
 			/* RNG auto-reset (step 2.) */
 			io_clrbits32(rng_base + RNG_SR, RNG_SR_SEIS);
+			reset_health();
 		}
 	} else {
 		/* Measure time before possible reschedule */
@@ -176,6 +208,7 @@ static void conceal_seed_error_cond_reset(void)
 		}
 
 		dev->error_conceal = false;
+		reset_health();
 	}
 }
 
@@ -206,6 +239,8 @@ static void conceal_seed_error_sw_reset(void)
 
 	if (io_read32(rng_base + RNG_SR) & RNG_SR_SEIS)
 		panic("RNG noise");
+
+	reset_health();
 }
 
 static void conceal_seed_error(void)
@@ -216,6 +251,25 @@ static void conceal_seed_error(void)
 		conceal_seed_error_sw_reset();
 }
 
+/*
+ * Resets the noise source after a failed health test, the health tests
+ * are reset once the reset has completed.
+ */
+static void recover_health_failure(void)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	vaddr_t rng_base = get_base();
+
+	if (dev->ddata->has_cond_reset) {
+		io_setbits32(rng_base + RNG_CR, RNG_CR_CONDRST);
+		io_clrbits32(rng_base + RNG_CR, RNG_CR_CONDRST);
+		dev->error_to_ref = timeout_init_us(RNG_READY_TIMEOUT_US);
+		dev->error_conceal = true;
+	} else {
+		conceal_seed_error_sw_reset();
+	}
+}
+
 static TEE_Result read_available(vaddr_t rng_base, uint8_t *out, size_t *size)
 {
 	struct stm32_rng_instance *dev = stm32_rng;
@@ -255,6 +309,11 @@ static TEE_Result read_available(vaddr_t rng_base, uint8_t *out, size_t *size)
 			return TEE_ERROR_NO_DATA;
 		}
 
+		if (rng_health_feed(&dev->health, data32)) {
+			recover_health_failure();
+			return TEE_ERROR_SECURITY;
+		}
+
 		memcpy(buf, &data32, sz);
 		buf += sz;
 		len -= sz;
@@ -400,6 +459,193 @@ out:
 	return res;
 }
 
+#if defined(CFG_STM32_RNG_KEEP_WARM)
+/* Called with the instance lock held */
+static size_t cache_take(uint8_t *out, size_t size)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint8_t *data = dev->cache + RNG_FIFO_BYTE_DEPTH - dev->cache_len;
+	size_t n = MIN(size, dev->cache_len);
+
+	memcpy(out, data, n);
+	memzero_explicit(data, n);
+	dev->cache_len -= n;
+
+	return n;
+}
+
+/* Called with the instance lock held */
+static void cache_flush(void)
+{
+	memzero_explicit(stm32_rng->cache, sizeof(stm32_rng->cache));
+	stm32_rng->cache_len = 0;
+}
+
+/*
+ * Read a whole FIFO for a request smaller than it and keep what's left for
+ * the next request. Called with the instance lock held.
+ */
+static TEE_Result read_available_cached(vaddr_t rng_base, uint8_t *out,
+					size_t *size)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint8_t fifo[RNG_FIFO_BYTE_DEPTH] = { };
+	size_t len = sizeof(fifo);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = read_available(rng_base, fifo, &len);
+	if (!res) {
+		*size = MIN(*size, len);
+		memcpy(out, fifo, *size);
+		if (!dev->cache_len && len > *size) {
+			dev->cache_len = len - *size;
+			memcpy(dev->cache + sizeof(dev->cache) - dev->cache_len,
+			       fifo + *size, dev->cache_len);
+		}
+	}
+	memzero_explicit(fifo, sizeof(fifo));
+
+	return res;
+}
+
+/*
+ * Drop the clock reference held since the first request of the burst once
+ * a whole idle period went by without a request
+ */
+static bool stm32_rng_idle_cb(struct callout *co __unused)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint32_t exceptions = may_spin_lock(&dev->lock);
+	bool cool_down = dev->warm && !dev->used;
+	bool keep = dev->warm && dev->used;
+
+	dev->used = false;
+	if (cool_down) {
+		dev->warm = false;
+		cache_flush();
+	}
+	may_spin_unlock(&dev->lock, exceptions);
+
+	if (cool_down)
+		disable_rng_clock();
+
+	return keep;
+}
+
+static void stm32_rng_keep_warm(void)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint32_t exceptions = may_spin_lock(&dev->lock);
+	bool warm_up = !dev->warm;
+
+	dev->warm = true;
+	dev->used = true;
+	may_spin_unlock(&dev->lock, exceptions);
+
+	if (!warm_up)
+		return;
+
+	if (enable_rng_clock()) {
+		exceptions = may_spin_lock(&dev->lock);
+		dev->warm = false;
+		may_spin_unlock(&dev->lock, exceptions);
+		return;
+	}
+
+	callout_add(&dev->idle_callout, stm32_rng_idle_cb,
+		    CFG_STM32_RNG_KEEP_WARM_MS);
+}
+
+static void stm32_rng_cool_down(void)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint32_t exceptions = may_spin_lock(&dev->lock);
+	bool was_warm = dev->warm;
+
+	dev->warm = false;
+	cache_flush();
+	may_spin_unlock(&dev->lock, exceptions);
+
+	callout_rem(&dev->idle_callout);
+	if (was_warm)
+		disable_rng_clock();
+}
+#else
+static size_t cache_take(uint8_t *out __unused, size_t size __unused)
+{
+	return 0;
+}
+
+static TEE_Result read_available_cached(vaddr_t rng_base, uint8_t *out,
+					size_t *size)
+{
+	return read_available(rng_base, out, size);
+}
+
+static void stm32_rng_keep_warm(void)
+{
+}
+
+static void stm32_rng_cool_down(void)
+{
+}
+#endif /* CFG_STM32_RNG_KEEP_WARM */
+
+#if defined(CFG_STM32_RNG_RESUME_POOL)
+static size_t pool_take(uint8_t *out, size_t size)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint32_t exceptions = may_spin_lock(&dev->lock);
+	uint8_t *data = dev->pool + sizeof(dev->pool) - dev->pool_len;
+	size_t n = MIN(size, dev->pool_len);
+
+	memcpy(out, data, n);
+	memzero_explicit(data, n);
+	dev->pool_len -= n;
+	may_spin_unlock(&dev->lock, exceptions);
+
+	return n;
+}
+
+/*
+ * Wait for the end of the conditioning reset started by the resume and
+ * drop the clock reference it held. Called with the clock enabled.
+ */
+static TEE_Result finish_resume(vaddr_t rng_base)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint32_t exceptions = may_spin_lock(&dev->lock);
+	bool pending = dev->resume_pending;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t value = 0;
+
+	dev->resume_pending = false;
+	may_spin_unlock(&dev->lock, exceptions);
+
+	if (!pending)
+		return TEE_SUCCESS;
+
+	if (IO_READ32_POLL_TIMEOUT(rng_base + RNG_CR, value,
+				   !(value & RNG_CR_CONDRST), 0,
+				   RNG_READY_TIMEOUT_US))
+		res = TEE_ERROR_GENERIC;
+
+	disable_rng_clock();
+
+	return res;
+}
+#else
+static size_t pool_take(uint8_t *out __unused, size_t size __unused)
+{
+	return 0;
+}
+
+static TEE_Result finish_resume(vaddr_t rng_base __unused)
+{
+	return TEE_SUCCESS;
+}
+#endif /* CFG_STM32_RNG_RESUME_POOL */
+
 static TEE_Result stm32_rng_read(uint8_t *out, size_t size)
 {
 	TEE_Result rc = TEE_ERROR_GENERIC;
@@ -409,18 +655,39 @@ static TEE_Result stm32_rng_read(uint8_t *out, size_t size)
 	uint8_t *out_ptr = out;
 	vaddr_t rng_base = 0;
 	size_t out_size = 0;
+	size_t n = 0;
 
 	if (!stm32_rng) {
 		DMSG("No RNG");
 		return TEE_ERROR_NOT_SUPPORTED;
 	}
 
+	/* Serve what was put aside at suspend while the RNG comes back */
+	out_size = pool_take(out_ptr, size);
+	out_ptr += out_size;
+	if (out_size == size)
+		return TEE_SUCCESS;
+
 	rc = enable_rng_clock();
 	if (rc)
 		return rc;
 
 	rng_base = get_base();
 
+	rc = finish_resume(rng_base);
+	if (rc)
+		goto out;
+
+	if (IS_ENABLED(CFG_STM32_RNG_KEEP_WARM)) {
+		stm32_rng_keep_warm();
+
+		exceptions = may_spin_lock(&stm32_rng->lock);
+		n = cache_take(out_ptr, size - out_size);
+		out_size += n;
+		out_ptr += n;
+		may_spin_unlock(&stm32_rng->lock, exceptions);
+	}
+
 	/* Arm timeout */
 	timeout_ref = timeout_init_us(RNG_READY_TIMEOUT_US);
 	burst_timeout = false;
@@ -431,16 +698,24 @@ static TEE_Result stm32_rng_read(uint8_t *out, size_t size)
 
 		exceptions = may_spin_lock(&stm32_rng->lock);
 
-		rc = read_available(rng_base, out_ptr, &sz);
+		if (sz < RNG_FIFO_BYTE_DEPTH)
+			rc = read_available_cached(rng_base, out_ptr, &sz);
+		else
+			rc = read_available(rng_base, out_ptr, &sz);
 
 		/* Raise timeout only if we failed to get some samples */
-		assert(!rc || rc == TEE_ERROR_NO_DATA);
-		if (rc)
+		assert(!rc || rc == TEE_ERROR_NO_DATA ||
+		       rc == TEE_ERROR_SECURITY);
+		if (rc == TEE_ERROR_NO_DATA)
 			burst_timeout = timeout_elapsed(timeout_ref);
 
 		may_spin_unlock(&stm32_rng->lock, exceptions);
 
-		if (burst_timeout) {
+		/*
+		 * Data of a failed health test can't be used, the request
+		 * fails while the noise source is reset for the next ones.
+		 */
+		if (burst_timeout || rc == TEE_ERROR_SECURITY) {
 			rc = TEE_ERROR_GENERIC;
 			goto out;
 		}
@@ -492,12 +767,57 @@ void plat_rng_init(void)
 }
 #endif
 
+#if defined(CFG_STM32_RNG_RESUME_POOL)
+/* Put aside RNG output to serve the first requests after resume */
+static void pool_fill(void)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+	uint8_t buf[sizeof(dev->pool)] = { };
+	uint32_t exceptions = 0;
+
+	exceptions = may_spin_lock(&dev->lock);
+	memzero_explicit(dev->pool, sizeof(dev->pool));
+	dev->pool_len = 0;
+	may_spin_unlock(&dev->lock, exceptions);
+
+	if (!stm32_rng_read(buf, sizeof(buf))) {
+		exceptions = may_spin_lock(&dev->lock);
+		memcpy(dev->pool, buf, sizeof(buf));
+		dev->pool_len = sizeof(buf);
+		may_spin_unlock(&dev->lock, exceptions);
+	}
+	memzero_explicit(buf, sizeof(buf));
+}
+
+static bool resume_lazily(void)
+{
+	struct stm32_rng_instance *dev = stm32_rng;
+
+	if (!dev->pool_len || enable_rng_clock())
+		return false;
+
+	dev->resume_pending = true;
+
+	return true;
+}
+#else
+static void pool_fill(void)
+{
+}
+
+static bool resume_lazily(void)
+{
+	return false;
+}
+#endif /* CFG_STM32_RNG_RESUME_POOL */
+
 static TEE_Result stm32_rng_pm_resume(void)
 {
 	vaddr_t base = get_base();
 
 	/* Clean error indications */
 	io_write32(base + RNG_SR, 0);
+	reset_health();
 
 	if (stm32_rng->ddata->has_cond_reset) {
 		uint64_t timeout_ref = 0;
@@ -516,6 +836,14 @@ static TEE_Result stm32_rng_pm_resume(void)
 
 		io_clrsetbits32(base + RNG_CR, RNG_CR_CONDRST, RNG_CR_RNGEN);
 
+		/*
+		 * With output put aside at suspend, let the conditioning
+		 * reset complete while the first requests are served from
+		 * it. The clock stays enabled until finish_resume().
+		 */
+		if (resume_lazily())
+			return TEE_SUCCESS;
+
 		timeout_ref = timeout_init_us(RNG_READY_TIMEOUT_US);
 		while (io_read32(base + RNG_CR) & RNG_CR_CONDRST)
 			if (timeout_elapsed(timeout_ref))
@@ -572,15 +900,29 @@ stm32_rng_pm(enum pm_op op, unsigned int pm_hint __unused,
 
 	assert(stm32_rng && (op == PM_OP_SUSPEND || op == PM_OP_RESUME));
 
+	/* Don't keep the RNG clocked nor its data across a low power state */
+	if (op == PM_OP_SUSPEND) {
+		pool_fill();
+		stm32_rng_cool_down();
+	}
+
 	res = enable_rng_clock();
 	if (res)
 		return res;
 
+	/* A resume not followed by any request */
+	if (op == PM_OP_SUSPEND) {
+		res = finish_resume(get_base());
+		if (res)
+			goto out;
+	}
+
 	if (op == PM_OP_RESUME)
 		res = stm32_rng_pm_resume();
 	else
 		res = stm32_rng_pm_suspend();
 
+out:
 	disable_rng_clock();
 
 	return res;
@@ -651,6 +993,8 @@ static TEE_Result stm32_rng_probe(const void *fdt, int offs,
 	stm32_rng->ddata = compat_data;
 	assert(stm32_rng->ddata);
 
+	reset_health();
+
 	res = stm32_rng_parse_fdt(fdt, offs);
 	if (res)
 		goto err;
@@ -98,6 +98,7 @@ srcs-$(CFG_OPENEDGES_OMC) += openedges_omc.c
 subdirs-y += crypto
 subdirs-$(CFG_BNXT_FW) += bnxt
 subdirs-$(CFG_DRIVERS_CLK) += clk
+subdirs-$(CFG_DRIVERS_DMA) += dma
 subdirs-$(CFG_DRIVERS_FIREWALL) += firewall
 subdirs-$(CFG_DRIVERS_GPIO) += gpio
 subdirs-$(CFG_DRIVERS_I2C) += i2c
@@ -53,65 +53,40 @@
  */
 #include <arm.h>
 #include <crypto/crypto.h>
+#include <crypto/rng_health.h>
+#include <crypto/rng_source.h>
+#include <crypto/rng_stats.h>
 #include <initcall.h>
 #include <io.h>
 #include <kernel/delay.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <mm/core_mmu.h>
 #include <mm/core_memprot.h>
 #include <platform_config.h>
 #include <rng_support.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee/tee_cryp_utl.h>
 #include <trace.h>
+#include <drivers/hwrng_burst.h>
 #include <drivers/versal_trng.h>
 #include <drivers/versal_mbox.h>
+#include <drivers/xil_sutil.h>
 #include <drivers/xtrngpsx.h>
-
-#define TRNG_STATUS			0x04
-#define TRNG_STATUS_QCNT_SHIFT		9
-#define TRNG_STATUS_QCNT_MASK		(BIT(9) | BIT(10) | BIT(11))
-#define TRNG_STATUS_CERTF_MASK		BIT(3)
-#define TRNG_STATUS_DTF_MASK		BIT(1)
-#define TRNG_STATUS_DONE_MASK		BIT(0)
-#define TRNG_CTRL			0x08
-#define TRNG_CTRL_PERSODISABLE		BIT(10)
-#define TRNG_CTRL_SINGLEGENMODE		BIT(9)
-#define TRNG_CTRL_EUMODE_MASK		BIT(8)
-#define TRNG_CTRL_PRNGMODE_MASK		BIT(7)
-#define TRNG_CTRL_TSTMODE_MASK		BIT(6)
-#define TRNG_CTRL_PRNGSTART_MASK	BIT(5)
-#define TRNG_CTRL_PRNGXS_MASK		BIT(3)
-#define TRNG_CTRL_TRSSEN_MASK		BIT(2)
-#define TRNG_CTRL_PRNGSRST_MASK		BIT(0)
+#include <drivers/xtrngpsx_hw.h>
 
 #if defined(CFG_VERSAL_RNG_DRV_V2)
-#define TRNG_CTRL_2			0x0C
-#define TRNG_CTRL_2_RCTCUTOFF_SHIFT	8
-#define TRNG_CTRL_2_RCTCUTOFF_MASK	GENMASK_32(16, 8)
-#define TRNG_CTRL_2_RCTCUTOFF_DEFVAL	0x21
-#define TRNG_CTRL_2_DIT_SHIFT		0
-#define TRNG_CTRL_2_DIT_MASK		GENMASK_32(4, 0)
-#define TRNG_CTRL_2_DIT_DEFVAL		0xC
-#define TRNG_CTRL_3			0x10
-#define TRNG_CTRL_3_APTCUTOFF_SHIFT	8
-#define TRNG_CTRL_3_APTCUTOFF_MASK	GENMASK_32(17, 8)
-#define TRNG_CTRL_3_APTCUTOFF_DEFVAL	0x264
-#define TRNG_CTRL_3_DLEN_SHIFT		0
-#define TRNG_CTRL_3_DLEN_MASK		GENMASK_32(7, 0)
-#define TRNG_CTRL_3_DLEN_DEFVAL		0x9
-#define TRNG_CTRL_4			0x14
 #define TRNG_DF_NUM_OF_BYTES_BEFORE_MIN_700CLKS_WAIT	8U
 #define TRNG_PERS_STRING_LEN_IN_WORDS	12U
 #define TRNG_WORD_LEN_IN_BYTES			4U
 #define TRNG_BYTE_LEN_IN_BITS			8U
-#define TRNG_PER_STRNG_11				(0x000000ACU)
 #define TRNG_DF_2CLKS_WAIT				2U
 #define TRNG_BLOCK_LEN_IN_BYTES			16U
 #define TRNG_DF_700CLKS_WAIT			10U
-#define TRNG_CTRL_PERSODISABLE_MASK		0x00000400U
-#define TRNG_CTRL_PERSODISABLE_DEFVAL	0x0U
 
 #define XTRNGPSX_EXAMPLE_SEEDLIFE			12U
 #define XTRNGPSX_EXAMPLE_DFLENMUL			4U
@@ -157,11 +132,6 @@
  * Register: TRNG_PER_STRING_10		0x000000A8
  * Register: TRNG_PER_STRING_11		0x000000AC
  */
-#define TRNG_CORE_OUTPUT		0xC0
-#define TRNG_RESET			0xD0
-#define TRNG_RESET_VAL_MASK		BIT(0)
-#define TRNG_OSC_EN			0xD4
-#define TRNG_OSC_EN_VAL_MASK		BIT(0)
 
 /* TRNG configuration  */
 #define TRNG_BURST_SIZE		16
@@ -174,6 +144,8 @@
 #define TRNG_GENERATE_TIMEOUT	8000
 #define TRNG_MIN_DFLENMULT	2
 #define TRNG_MAX_DFLENMULT	9
+/* Min-entropy in bits claimed per raw PTRNG word for the health tests */
+#define TRNG_SAMPLE_ENTROPY	8
 #define PRNGMODE_RESEED		0
 #define PRNGMODE_GEN		TRNG_CTRL_PRNGMODE_MASK
 #define RESET_DELAY		10
@@ -183,6 +155,16 @@
 #define BYTES_PER_BLOCK		16
 #define ALL_A_PATTERN_32	0xAAAAAAAA
 #define ALL_5_PATTERN_32	0x55555555
+#define TRNG_SYNC_CHUNK_LEN	256
+#define TRNG_CLAIM_DELAY_US	10
+
+#if defined(CFG_VERSAL_TRNG_RING)
+#define TRNG_RING_SIZE		CFG_VERSAL_TRNG_RING_SIZE
+#define TRNG_RING_WATERMARK	(TRNG_RING_SIZE / 2)
+#define TRNG_RING_CHUNK_LEN	TRNG_SEC_STRENGTH_LEN
+#define TRNG_RING_IDLE_MS	10
+#define TRNG_RING_BUSY_MS	1
+#endif
 
 /* Derivative function variables */
 static unsigned char sbx1[256];
@@ -273,6 +255,7 @@ static void shift_row_sbox(uint8_t *f)
 	rota4(&f[15], &f[11], &f[7], &f[3]);
 }
 
+__maybe_unused
 static void encrypt(uint8_t *in, uint8_t *out)
 {
 	uint8_t fa[BLK_SIZE] = { 0 };
@@ -289,16 +272,8 @@ static void encrypt(uint8_t *in, uint8_t *out)
 	set_key(out, fa, roundval);
 }
 
-static void checksum(unsigned char *in, uint8_t *iv, int max_blk)
-{
-	while (max_blk > 0) {
-		xorb(iv, in);
-		encrypt(iv, iv);
-		in += BLK_SIZE;
-		max_blk -= 1;
-	}
-}
 
+__maybe_unused
 static void setup_key(const unsigned char *k, size_t klen)
 {
 	unsigned char rcon = 1;
@@ -333,6 +308,7 @@ static void setup_key(const unsigned char *k, size_t klen)
 	}
 }
 
+__maybe_unused
 static void trng_df_init(void)
 {
 	const uint8_t sb[] = {
@@ -372,6 +348,70 @@ static void trng_df_init(void)
 	}
 }
 
+#if defined(CFG_VERSAL_TRNG_DF_CRYPTO)
+/*
+ * The DF block cipher is plain AES-256 encryption, run it through the crypto
+ * API so it uses the ARMv8 Crypto Extensions when available.
+ */
+static void *df_ctx;
+
+static void df_setup_key(const uint8_t *key)
+{
+	static bool df_keyed;
+
+	if (!df_ctx && crypto_cipher_alloc_ctx(&df_ctx, TEE_ALG_AES_ECB_NOPAD))
+		panic();
+
+	if (df_keyed)
+		crypto_cipher_final(df_ctx);
+
+	if (crypto_cipher_init(df_ctx, TEE_MODE_ENCRYPT, key, DF_KEY_LEN,
+			       NULL, 0, NULL, 0))
+		panic();
+	df_keyed = true;
+}
+
+static void df_encrypt(const uint8_t *in, uint8_t *out)
+{
+	if (crypto_cipher_update(df_ctx, TEE_MODE_ENCRYPT, false, in, BLK_SIZE,
+				 out))
+		panic();
+}
+#else
+static void df_setup_key(const uint8_t *key)
+{
+	static bool df_init;
+
+	if (!df_init) {
+		trng_df_init();
+		df_init = true;
+	}
+
+	setup_key(key, DF_KEY_LEN);
+}
+
+static void df_encrypt(const uint8_t *in, uint8_t *out)
+{
+	uint8_t blk[BLK_SIZE] = { 0 };
+
+	memcpy(blk, in, BLK_SIZE);
+	encrypt(blk, out);
+}
+#endif
+
+static void checksum(unsigned char *in, uint8_t *iv, int max_blk)
+{
+	uint8_t blk[BLK_SIZE] = { 0 };
+
+	while (max_blk > 0) {
+		xorb(iv, in);
+		memcpy(blk, iv, BLK_SIZE);
+		df_encrypt(blk, iv);
+		in += BLK_SIZE;
+		max_blk -= 1;
+	}
+}
+
 /*
  * This function implements the Derivative Function by distilling the entropy
  * available in its input into a smaller number of bits on the output.
@@ -383,7 +423,6 @@ static void trng_df_init(void)
 static void trng_df_algorithm(struct versal_trng *trng, uint8_t *dfout,
 			      uint32_t flag, const uint8_t *pstr)
 {
-	static bool df_init;
 	const uint8_t df_key[DF_KEY_LEN] = {
 		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
 		17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
@@ -398,11 +437,6 @@ static void trng_df_algorithm(struct versal_trng *trng, uint8_t *dfout,
 	uintptr_t dst = 0;
 	size_t offset = 0;
 
-	if (!df_init) {
-		trng_df_init();
-		df_init = true;
-	}
-
 	if (flag == DF_SEED)
 		trng->dfin.val2 = TEE_U32_TO_BIG_ENDIAN(TRNG_PERS_STR_LEN);
 	else
@@ -445,7 +479,7 @@ static void trng_df_algorithm(struct versal_trng *trng, uint8_t *dfout,
 	}
 
 	/* DF algorithm - step 1 */
-	setup_key(df_key, DF_KEY_LEN);
+	df_setup_key(df_key);
 	for (index = 0; index < TRNG_SEED_LEN; index += BLK_SIZE) {
 		memset((void *)(trng->dfout + index), 0, BLK_SIZE);
 		trng->dfin.ivc[0] = TEE_U32_TO_BIG_ENDIAN(index / BLK_SIZE);
@@ -454,7 +488,7 @@ static void trng_df_algorithm(struct versal_trng *trng, uint8_t *dfout,
 	}
 
 	/* DF algorithm - step 2 */
-	setup_key(trng->dfout, DF_KEY_LEN);
+	df_setup_key(trng->dfout);
 	for (index = 0; index < TRNG_SEED_LEN; index += BLK_SIZE) {
 		if (!index)
 			inp_blk = &dfout[TRNG_SEC_STRENGTH_LEN];
@@ -462,7 +496,7 @@ static void trng_df_algorithm(struct versal_trng *trng, uint8_t *dfout,
 			inp_blk = &dfout[index - BLK_SIZE];
 
 		out_blk = &dfout[index];
-		encrypt(inp_blk, out_blk);
+		df_encrypt(inp_blk, out_blk);
 	}
 }
 
@@ -477,25 +511,6 @@ static void trng_write32(vaddr_t addr, size_t off, uint32_t val)
 }
 
 #if defined(CFG_VERSAL_RNG_DRV_V2)
-static uint32_t trng_write32_v2(vaddr_t addr, uint32_t mask, uint32_t value)
-{
-	uint32_t status = TEE_ERROR_GENERIC;
-	uint32_t regval;
-	uint32_t val;
-
-	val = io_read32(addr);
-	val = (val & (~mask)) | (mask & value);
-	io_write32(addr, val);
-
-	/* verify value written to specified address */
-	regval = io_read32(addr) & mask;
-
-	if (regval == (mask & value))
-		status = TEE_SUCCESS;
-
-	return status;
-}
-
 static int trng_write_perstr(const struct versal_trng *trng,
 			     const uint8_t *perstr)
 {
@@ -591,12 +606,15 @@ static TEE_Result trng_wait_for_event(vaddr_t addr, size_t off, uint32_t mask,
 				      uint32_t event, uint32_t time_out)
 {
 	uint64_t tref = timeout_init_us(time_out);
+	uint64_t start = rng_stats_now();
 
 	do {
 		if (timeout_elapsed(tref))
 			break;
 	} while ((io_read32(addr + off) & mask) != event);
 
+	rng_stats_busy_wait(start);
+
 	/* Normal world might have suspended the OP-TEE thread, check again  */
 	if ((io_read32(addr + off) & mask) != event)
 		return TEE_ERROR_GENERIC;
@@ -604,6 +622,60 @@ static TEE_Result trng_wait_for_event(vaddr_t addr, size_t off, uint32_t mask,
 	return TEE_SUCCESS;
 }
 
+TEE_Result versal_trng_stream(vaddr_t addr, void *dst, size_t len,
+			      bool check_dtf, struct rng_health *health)
+{
+	const size_t bursts = DIV_ROUND_UP(len, TRNG_BURST_SIZE);
+	uint32_t burst[RAND_BUF_LEN] = { 0 };
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *p = dst;
+	size_t bcnt = 0;
+	size_t n = 0;
+
+	COMPILE_TIME_ASSERT(sizeof(burst) == TRNG_BURST_SIZE);
+
+	/*
+	 * In each burst 128 bits are generated, which is reflected in QCNT
+	 * value of 4 by hardware.
+	 */
+	for (bcnt = 0; bcnt < bursts; bcnt++) {
+		if (trng_wait_for_event(addr, TRNG_STATUS,
+					TRNG_STATUS_QCNT_MASK,
+					TRNG_MAX_QCNT << TRNG_STATUS_QCNT_SHIFT,
+					TRNG_GENERATE_TIMEOUT)) {
+			res = TEE_ERROR_TIMEOUT;
+			goto out;
+		}
+
+		if (check_dtf &&
+		    (io_read32(addr + TRNG_STATUS) & TRNG_STATUS_DTF_MASK)) {
+			res = TEE_ERROR_SECURITY;
+			goto out;
+		}
+
+		/* Read the core output register 4 times to consume a burst */
+		hwrng_burst_drain(addr + TRNG_CORE_OUTPUT, burst,
+				  RAND_BUF_LEN);
+		hwrng_burst_to_be(burst, RAND_BUF_LEN);
+
+		if (health &&
+		    rng_health_feed_words(health, burst, RAND_BUF_LEN)) {
+			res = TEE_ERROR_BAD_STATE;
+			goto out;
+		}
+
+		if (p) {
+			n = hwrng_burst_copy(p, len, burst, RAND_BUF_LEN);
+			p += n;
+			len -= n;
+		}
+	}
+
+out:
+	memzero_explicit(burst, sizeof(burst));
+	return res;
+}
+
 static void trng_soft_reset(const struct versal_trng *trng)
 {
 	trng_clrset32(trng->cfg.addr, TRNG_CTRL, TRNG_CTRL_PRNGSRST_MASK,
@@ -647,73 +719,154 @@ static TEE_Result trng_check_seed(uint8_t *entropy, uint32_t len)
 static TEE_Result trng_collect_random(struct versal_trng *trng, uint8_t *dst,
 				      size_t len)
 {
-	const size_t bursts = len / TRNG_BURST_SIZE;
-	const size_t words = TRNG_BURST_SIZE_BITS / TRNG_REG_SIZE;
-	uint32_t *p = (void *)dst;
-	size_t bcnt = 0;
-	size_t wcnt = 0;
-	size_t index = 0;
-	uint32_t val = 0;
-	bool match = false;
+	TEE_Result res = TEE_SUCCESS;
 
 	trng_clrset32(trng->cfg.addr, TRNG_CTRL,
 		      TRNG_CTRL_PRNGSTART_MASK, TRNG_CTRL_PRNGSTART_MASK);
 
 	/*
-	 * Loop as many times based on len requested. In each burst 128 bits
-	 * are generated, which is reflected in QCNT value of 4 by hardware.
+	 * DTF flag set during generate indicates catastrophic condition,
+	 * which needs to be checked for every burst unless we are in PTRNG
+	 * mode.
+	 *
+	 * The continuous health tests are only meaningful on the raw
+	 * entropy of PTRNG mode. In the DRBG based modes the core output
+	 * says nothing of the noise source, which is then covered by the
+	 * hardware tests reported with DTF.
 	 */
-	for (bcnt = 0; bcnt < bursts; bcnt++) {
-		if (trng_wait_for_event(trng->cfg.addr,
-					TRNG_STATUS, TRNG_STATUS_QCNT_MASK,
-					TRNG_MAX_QCNT << TRNG_STATUS_QCNT_SHIFT,
-					TRNG_GENERATE_TIMEOUT)) {
-			EMSG("Timeout waiting for randomness");
-			return TEE_ERROR_GENERIC;
-		}
+	res = versal_trng_stream(trng->cfg.addr, dst, len,
+				 trng->usr_cfg.mode != TRNG_PTRNG,
+				 trng->usr_cfg.mode == TRNG_PTRNG ?
+				 &trng->health : NULL);
+	switch (res) {
+	case TEE_SUCCESS:
+		return TEE_SUCCESS;
+	case TEE_ERROR_TIMEOUT:
+		EMSG("Timeout waiting for randomness");
+		return TEE_ERROR_GENERIC;
+	case TEE_ERROR_SECURITY:
+		EMSG("Catastrophic DFT error");
+		break;
+	default:
+		EMSG("Catastrophic health test error");
+		break;
+	}
 
-		/*
-		 * DTF flag set during generate indicates catastrophic
-		 * condition, which needs to be checked for every time unless we
-		 * are in PTRNG mode
-		 */
-		if (trng->usr_cfg.mode != TRNG_PTRNG) {
-			val = trng_read32(trng->cfg.addr, TRNG_STATUS);
-			if (val & TRNG_STATUS_DTF_MASK) {
-				EMSG("Catastrophic DFT error");
-				trng->status = TRNG_CATASTROPHIC;
+	trng->status = TRNG_CATASTROPHIC;
+	return TEE_ERROR_GENERIC;
+}
 
-				return TEE_ERROR_GENERIC;
-			}
-		}
-		/*
-		 * Read the core output register 4 times to consume the random
-		 * data generated for every burst.
-		 */
-		match = true;
-		for (wcnt = 0; wcnt < words; wcnt++) {
-			val = trng_read32(trng->cfg.addr, TRNG_CORE_OUTPUT);
+#if defined(CFG_VERSAL_TRNG_ADAPTIVE_DF)
+/* Raw bytes per estimate */
+#define TRNG_EST_WINDOW		65536
+/* Input min-entropy wanted per DF output, security strength plus 64 bits */
+#define TRNG_EST_TARGET_BITS	(TRNG_SEC_STRENGTH_LEN * 8 + 64)
+
+/*
+ * Largest most common value count in a window for which the
+ * (dfmul + 1) * BYTES_PER_BLOCK raw bytes of a DF input still carry
+ * TRNG_EST_TARGET_BITS of min-entropy, that is
+ * TRNG_EST_WINDOW * 2^(-TRNG_EST_TARGET_BITS / ((dfmul + 1) * 16)),
+ * indexed by dfmul - TRNG_MIN_DFLENMULT.
+ */
+static const uint32_t trng_est_max_count[] = {
+	645, 2048, 4096, 6501, 9044, 11585, 14045, 16384,
+};
 
-			if (bcnt > 0 && trng->buf[wcnt] != val)
-				match = false;
+static_assert(ARRAY_SIZE(trng_est_max_count) ==
+	      TRNG_MAX_DFLENMULT - TRNG_MIN_DFLENMULT + 1);
 
-			trng->buf[wcnt] = val;
+static uint64_t trng_est_sqrt(uint64_t v)
+{
+	uint64_t bit = BIT64(62);
+	uint64_t r = 0;
 
-			if (dst) {
-				p[index] = TEE_U32_TO_BIG_ENDIAN(val);
-				index++;
-			}
-		}
+	while (bit > v)
+		bit >>= 2;
 
-		if (bursts > 1 && bcnt > 0 && match) {
-			EMSG("Catastrophic software error");
-			trng->status = TRNG_CATASTROPHIC;
-			return TEE_ERROR_GENERIC;
+	while (bit) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
 		}
+		bit >>= 2;
 	}
 
-	return TEE_SUCCESS;
+	return r;
+}
+
+/*
+ * Most common value estimate of NIST SP 800-90B section 6.3.1 over the
+ * window just completed. The multiplier is set to the lowest one, not
+ * below the configured floor, whose DF input carries enough min-entropy
+ * according to the upper bound of the 99% confidence interval of the
+ * most common value probability.
+ */
+static void trng_est_update(struct versal_trng *trng)
+{
+	struct trng_entropy_est *est = &trng->est;
+	uint32_t mul = est->dfmul_min;
+	uint64_t bound = 0;
+	uint64_t cmax = 0;
+	uint64_t var = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(est->hist); n++)
+		cmax = MAX(cmax, (uint64_t)est->hist[n]);
+
+	/* In 1/256 of a count */
+	var = cmax * (TRNG_EST_WINDOW - cmax) * 65536 / (TRNG_EST_WINDOW - 1);
+	bound = cmax * 256 + trng_est_sqrt(var) * 2576 / 1000;
+
+	while (mul < TRNG_MAX_DFLENMULT &&
+	       bound > trng_est_max_count[mul - TRNG_MIN_DFLENMULT] * 256ULL)
+		mul++;
+
+	if (mul != trng->usr_cfg.dfmul)
+		DMSG("TRNG DF multiplier %"PRIu32" -> %"PRIu32", MCV %"PRIu64,
+		     trng->usr_cfg.dfmul, mul, cmax);
+	trng->usr_cfg.dfmul = mul;
+
+	memset(est->hist, 0, sizeof(est->hist));
+	est->count = 0;
+}
+
+/* Feed raw entropy source bytes to the estimator */
+static void trng_estimate(struct versal_trng *trng, const uint8_t *buf,
+			  size_t len)
+{
+	struct trng_entropy_est *est = &trng->est;
+	size_t n = 0;
+
+	if (!est->dfmul_min)
+		return;
+
+	for (n = 0; n < len; n++) {
+		est->hist[buf[n]]++;
+		if (++est->count == TRNG_EST_WINDOW)
+			trng_est_update(trng);
+	}
+}
+
+static void trng_est_init(struct versal_trng *trng)
+{
+	memset(&trng->est, 0, sizeof(trng->est));
+	if (!trng->usr_cfg.df_disable && trng->usr_cfg.mode != TRNG_DRNG)
+		trng->est.dfmul_min = MAX(CFG_VERSAL_TRNG_ADAPTIVE_DF_MIN,
+					  TRNG_MIN_DFLENMULT);
+}
+#else
+static void trng_estimate(struct versal_trng *trng __unused,
+			  const uint8_t *buf __unused, size_t len __unused)
+{
+}
+
+static void trng_est_init(struct versal_trng *trng __unused)
+{
 }
+#endif /* CFG_VERSAL_TRNG_ADAPTIVE_DF */
 
 static TEE_Result trng_reseed_internal_nodf(struct versal_trng *trng,
 					    uint8_t *eseed,
@@ -726,11 +879,11 @@ static TEE_Result trng_reseed_internal_nodf(struct versal_trng *trng,
 	uint32_t ret = TEE_ERROR_GENERIC;
 
 	if (trng->cfg.version == TRNG_V2) {
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL_3,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL_3,
 				      TRNG_CTRL_3_DLEN_MASK,
 				      (mul << TRNG_CTRL_3_DLEN_SHIFT));
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 	}
 
 	if (str) {
@@ -740,54 +893,54 @@ static TEE_Result trng_reseed_internal_nodf(struct versal_trng *trng,
 		persmask = TRNG_CTRL_PERSODISABLE_DEFVAL;
 	}
 
-	ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL,
+	ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL,
 			      TRNG_CTRL_PERSODISABLE_MASK |
 			      TRNG_CTRL_PRNGSTART_MASK,
 			      persmask);
-	if (ret != TEE_SUCCESS)
-		return ret;
+	if (ret != XST_SUCCESS)
+		return TEE_ERROR_GENERIC;
 	/* DRNG Mode */
 	if (eseed) {
 		/* Enable TST mode and set PRNG mode for reseed operation*/
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL,
 				      TRNG_CTRL_PRNGMODE_MASK |
 				      TRNG_CTRL_TSTMODE_MASK |
 				      TRNG_CTRL_TRSSEN_MASK,
 				      TRNG_CTRL_TSTMODE_MASK |
 				      TRNG_CTRL_TRSSEN_MASK);
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 		/* Start reseed operation */
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL,
 				      TRNG_CTRL_PRNGSTART_MASK,
 				      TRNG_CTRL_PRNGSTART_MASK);
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 		/* To write seed to DF, need to set PRNG */
 		ret = trng_write_seed(trng, eseed, mul);
 		if (ret != TEE_SUCCESS)
 			return ret;
 	} else { /* HTRNG Mode */
 		/* Enable ring oscillators for random seed source */
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_OSC_EN,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_OSC_EN,
 				      TRNG_OSC_EN_VAL_MASK,
 				      TRNG_OSC_EN_VAL_MASK);
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 		/* Enable TRSSEN and set PRNG mode for reseed operation */
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL,
 				      TRNG_CTRL_PRNGMODE_MASK |
 				      TRNG_CTRL_TRSSEN_MASK |
 				      TRNG_CTRL_PRNGXS_MASK,
 				      TRNG_CTRL_TRSSEN_MASK);
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 		/* Start reseed operation */
-		ret = trng_write32_v2(trng->cfg.addr + TRNG_CTRL,
+		ret = Xil_SecureRMW32(trng->cfg.addr + TRNG_CTRL,
 				      TRNG_CTRL_PRNGSTART_MASK,
 				      TRNG_CTRL_PRNGSTART_MASK);
-		if (ret != TEE_SUCCESS)
-			return ret;
+		if (ret != XST_SUCCESS)
+			return TEE_ERROR_GENERIC;
 	}
 	trng->stats.elapsed_seed_life = 0;
 #else
@@ -841,6 +994,8 @@ static TEE_Result trng_reseed_internal_df(struct versal_trng *trng,
 
 		if (trng_check_seed(trng->dfin.entropy, trng->len))
 			return TEE_ERROR_GENERIC;
+
+		trng_estimate(trng, trng->dfin.entropy, trng->len);
 		break;
 	case TRNG_DRNG:
 		memcpy(trng->dfin.entropy, eseed, trng->len);
@@ -863,6 +1018,7 @@ static TEE_Result trng_reseed_internal(struct versal_trng *trng,
 
 	trng->stats.bytes_reseed = 0;
 	trng->stats.elapsed_seed_life = 0;
+	rng_stats_reseed();
 
 	if (trng->usr_cfg.df_disable)
 		trng->len = TRNG_SEED_LEN;
@@ -944,6 +1100,8 @@ static TEE_Result trng_instantiate(struct versal_trng *trng,
 		goto error;
 
 	memcpy(&trng->usr_cfg, usr_cfg, sizeof(struct trng_usr_cfg));
+	rng_health_init(&trng->health, TRNG_SAMPLE_ENTROPY);
+	trng_est_init(trng);
 	/* Bring TRNG and PRNG unit core out of reset */
 	trng_reset(trng);
 
@@ -957,13 +1115,13 @@ static TEE_Result trng_instantiate(struct versal_trng *trng,
 	    (usr_cfg->mode == TRNG_PTRNG || usr_cfg->mode == TRNG_HRNG)) {
 		/* Configure cutoff test values */
 		trng_clrset32(trng->cfg.addr, TRNG_CTRL_3,
-			      TRNG_CTRL_3_APTCUTOFF_MASK,
-			      TRNG_CTRL_3_APTCUTOFF_DEFVAL
-			      << TRNG_CTRL_3_APTCUTOFF_SHIFT);
+			      TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_MASK,
+			      TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_DEFVAL
+			      << TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_SHIFT);
 		trng_clrset32(trng->cfg.addr, TRNG_CTRL_2,
-			      TRNG_CTRL_2_RCTCUTOFF_MASK,
-			      TRNG_CTRL_2_RCTCUTOFF_DEFVAL
-			      << TRNG_CTRL_2_RCTCUTOFF_SHIFT);
+			      TRNG_CTRL_2_REPCOUNTTESTCUTOFF_MASK,
+			      TRNG_CTRL_2_REPCOUNTTESTCUTOFF_DEFVAL
+			      << TRNG_CTRL_2_REPCOUNTTESTCUTOFF_SHIFT);
 		/* Configure default DIT value */
 		trng_clrset32(trng->cfg.addr, TRNG_CTRL_2,
 			      TRNG_CTRL_2_DIT_MASK,
@@ -1096,9 +1254,80 @@ static TEE_Result trng_generate(struct versal_trng *trng, uint8_t *buf,
 	trng->stats.bytes_reseed += len;
 	trng->stats.bytes += len;
 	trng->stats.elapsed_seed_life++;
+	rng_stats_seed_state(trng->stats.bytes_reseed,
+			     trng->stats.elapsed_seed_life);
 
-	if (!trng->usr_cfg.df_disable && trng->usr_cfg.mode == TRNG_PTRNG)
+	if (!trng->usr_cfg.df_disable && trng->usr_cfg.mode == TRNG_PTRNG) {
+		trng_estimate(trng, p, len);
 		trng_df_algorithm(trng, buf, DF_RAND, NULL);
+	}
+
+	return TEE_SUCCESS;
+error:
+	if (trng->status != TRNG_CATASTROPHIC)
+		trng->status = TRNG_ERROR;
+
+	return TEE_ERROR_GENERIC;
+}
+
+/*
+ * Multi-burst variant of trng_generate() for the DRBG based modes: the core
+ * is put once in generate state and all the bursts available until the next
+ * seed life boundary are drained with a single PRNG start. @blen must be a
+ * multiple of TRNG_SEC_STRENGTH_LEN, each such chunk accounts for one
+ * request in the seed life.
+ */
+static TEE_Result trng_generate_bulk(struct versal_trng *trng, uint8_t *buf,
+				     size_t blen)
+{
+	uint64_t left = 0;
+	size_t len = 0;
+
+	if (!trng)
+		return TEE_ERROR_GENERIC;
+
+	if (!buf || !blen || blen % TRNG_SEC_STRENGTH_LEN)
+		goto error;
+
+	if (trng->status != TRNG_HEALTHY)
+		goto error;
+
+	if (trng->usr_cfg.mode != TRNG_HRNG && trng->usr_cfg.mode != TRNG_DRNG)
+		goto error;
+
+	while (blen) {
+		if (trng->usr_cfg.mode == TRNG_HRNG) {
+			if (trng->stats.elapsed_seed_life >=
+			    trng->usr_cfg.seed_life) {
+				if (trng_reseed_internal(trng, NULL, NULL, 0))
+					goto error;
+			}
+			left = trng->usr_cfg.seed_life -
+			       trng->stats.elapsed_seed_life;
+		} else {
+			/* Same bound as trng_generate(), no automatic reseed */
+			if (trng->stats.elapsed_seed_life >
+			    trng->usr_cfg.seed_life)
+				goto error;
+			left = trng->usr_cfg.seed_life + 1 -
+			       trng->stats.elapsed_seed_life;
+		}
+
+		len = MIN(blen, left * TRNG_SEC_STRENGTH_LEN);
+
+		trng_write32(trng->cfg.addr, TRNG_CTRL, PRNGMODE_GEN);
+		if (trng_collect_random(trng, buf, len))
+			goto error;
+
+		trng->stats.bytes_reseed += len;
+		trng->stats.bytes += len;
+		trng->stats.elapsed_seed_life += len / TRNG_SEC_STRENGTH_LEN;
+		rng_stats_seed_state(trng->stats.bytes_reseed,
+				     trng->stats.elapsed_seed_life);
+
+		buf += len;
+		blen -= len;
+	}
 
 	return TEE_SUCCESS;
 error:
@@ -1120,9 +1349,15 @@ static TEE_Result trng_release(struct versal_trng *trng)
 	trng_write32_range(trng, TRNG_PER_STRING_0, TRNG_PERS_STR_REGS, NULL);
 	trng_hold_reset(trng);
 
+#if defined(CFG_VERSAL_TRNG_PTRNG_DRBG)
+	if (trng->drbg_ready)
+		ctr_drbg_uninstantiate(&trng->drbg);
+	trng->drbg_ready = false;
+#endif
+
 	/* Clear the instance */
 	memset(&trng->usr_cfg, 0, sizeof(trng->usr_cfg));
-	memset(trng->buf, 0, sizeof(trng->buf));
+	memset(&trng->health, 0, sizeof(trng->health));
 	memset(trng->dfout, 0, sizeof(trng->dfout));
 	trng->status = TRNG_UNINITIALIZED;
 
@@ -1854,25 +2089,452 @@ error:
 	return TEE_ERROR_GENERIC;
 }
 
-TEE_Result versal_trng_get_random_bytes(struct versal_trng *trng,
-					void *buf, size_t len)
+/*
+ * Reseed policy applied per request to the HRNG instance, on top of the
+ * seed life of the core which counts generate blocks. A reseed is due
+ * before each request with CFG_VERSAL_TRNG_RESEED_PER_REQUEST, or once
+ * CFG_VERSAL_TRNG_RESEED_BYTES have been generated on the current seed.
+ * With @ahead the check is made from the callout, which reseeds a bit early
+ * so that requests don't pay the reseed latency.
+ */
+static bool trng_reseed_due(struct versal_trng *trng, bool ahead)
+{
+	uint64_t limit = CFG_VERSAL_TRNG_RESEED_BYTES;
+
+	if (trng->usr_cfg.mode != TRNG_HRNG || trng->status != TRNG_HEALTHY)
+		return false;
+
+	/* Nothing was generated on a fresh seed */
+	if (IS_ENABLED(CFG_VERSAL_TRNG_RESEED_PER_REQUEST))
+		return trng->stats.bytes_reseed;
+
+	if (!limit)
+		return false;
+
+	if (ahead)
+		limit -= limit / 4;
+
+	return trng->stats.bytes_reseed >= limit;
+}
+
+#if defined(CFG_VERSAL_TRNG_PTRNG_DRBG)
+#define TRNG_DRBG_RESEED_BYTES	CFG_VERSAL_TRNG_PTRNG_DRBG_RESEED_BYTES
+
+/*
+ * PTRNG output conditioned by the DF seeds a CTR_DRBG which serves the
+ * requests, the PTRNG only runs again when the DRBG is due for a reseed.
+ */
+static TEE_Result trng_drbg_read(struct versal_trng *trng, void *buf,
+				 size_t len)
+{
+	uint8_t seed[2 * TRNG_SEC_STRENGTH_LEN] = { 0 };
+	TEE_Result res = TEE_SUCCESS;
+
+	COMPILE_TIME_ASSERT(sizeof(seed) >= CTR_DRBG_SEED_LEN);
+
+	if (!trng->drbg_ready || trng->drbg_bytes >= TRNG_DRBG_RESEED_BYTES) {
+		/* Each chunk goes through the DF on its own */
+		res = trng_generate(trng, seed, TRNG_SEC_STRENGTH_LEN, false);
+		if (!res)
+			res = trng_generate(trng, seed + TRNG_SEC_STRENGTH_LEN,
+					    TRNG_SEC_STRENGTH_LEN, false);
+		if (!res && trng->drbg_ready)
+			res = ctr_drbg_reseed(&trng->drbg, seed);
+		else if (!res)
+			res = ctr_drbg_instantiate(&trng->drbg, seed);
+		memzero_explicit(seed, sizeof(seed));
+		if (res)
+			return res;
+
+		trng->drbg_ready = true;
+		trng->drbg_bytes = 0;
+		rng_stats_reseed();
+	}
+
+	res = ctr_drbg_generate(&trng->drbg, buf, len);
+	if (!res)
+		trng->drbg_bytes += len;
+
+	return res;
+}
+#endif
+
+static TEE_Result trng_get_random_bytes_sync(struct versal_trng *trng,
+					     void *buf, size_t len)
 {
 	uint8_t random[TRNG_SEC_STRENGTH_LEN] = { 0 };
+	size_t bulk = ROUNDDOWN(len, TRNG_SEC_STRENGTH_LEN);
+	TEE_Result res = TEE_SUCCESS;
 	uint8_t *p = buf;
 	size_t i = 0;
 
-	for (i = 0; i < len / TRNG_SEC_STRENGTH_LEN; i++) {
-		if (trng_generate(trng, p + i * TRNG_SEC_STRENGTH_LEN,
-				  TRNG_SEC_STRENGTH_LEN, false))
-			panic();
+#if defined(CFG_VERSAL_TRNG_PTRNG_DRBG)
+	if (trng->usr_cfg.mode == TRNG_PTRNG)
+		return trng_drbg_read(trng, buf, len);
+#endif
+
+	if (trng->usr_cfg.mode != TRNG_PTRNG) {
+		/* Stream all the full chunks out of the DRBG at once */
+		if (bulk)
+			res = trng_generate_bulk(trng, p, bulk);
+	} else {
+		/* Each PTRNG chunk goes through the DF on its own */
+		for (i = 0; !res && i < bulk; i += TRNG_SEC_STRENGTH_LEN)
+			res = trng_generate(trng, p + i, TRNG_SEC_STRENGTH_LEN,
+					    false);
 	}
 
-	if (len % TRNG_SEC_STRENGTH_LEN) {
-		if (trng_generate(trng, random, TRNG_SEC_STRENGTH_LEN,
-				  false))
-			panic();
-		memcpy(p + i * TRNG_SEC_STRENGTH_LEN, random,
-		       len % TRNG_SEC_STRENGTH_LEN);
+	if (!res && len % TRNG_SEC_STRENGTH_LEN) {
+		res = trng_generate(trng, random, TRNG_SEC_STRENGTH_LEN,
+				    false);
+		if (!res)
+			memcpy(p + bulk, random, len % TRNG_SEC_STRENGTH_LEN);
+		memzero_explicit(random, sizeof(random));
+	}
+
+	return res;
+}
+
+/*
+ * The hardware is owned by one generator at a time, either a synchronous
+ * request or the ring callout. Ownership is tracked with @hw_busy rather
+ * than by holding @lock so that a synchronous request doesn't need to
+ * keep interrupts masked while it waits for the TRNG.
+ */
+static bool trng_hw_claim(struct versal_trng *trng)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&trng->lock);
+	bool claimed = !trng->hw_busy;
+
+	if (claimed)
+		trng->hw_busy = true;
+	cpu_spin_unlock_xrestore(&trng->lock, exceptions);
+
+	return claimed;
+}
+
+static void trng_hw_release(struct versal_trng *trng)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&trng->lock);
+
+	trng->hw_busy = false;
+	cpu_spin_unlock_xrestore(&trng->lock, exceptions);
+}
+
+/*
+ * With CFG_VERSAL_TRNG_PREEMPTIBLE=y synchronous requests are serialized
+ * with a mutex and run with foreign interrupts unmasked, the normal world
+ * can then preempt the thread while the TRNG collects entropy. Otherwise
+ * all exceptions stay masked for the whole chunk.
+ */
+static uint32_t trng_hw_get(struct versal_trng *trng)
+{
+	uint32_t exceptions = 0;
+
+	if (IS_ENABLED(CFG_VERSAL_TRNG_PREEMPTIBLE))
+		mutex_lock(&trng->mu);
+	else
+		exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	/* The callout may be refilling the ring on another core */
+	while (!trng_hw_claim(trng))
+		udelay(TRNG_CLAIM_DELAY_US);
+
+	return exceptions;
+}
+
+static void trng_hw_put(struct versal_trng *trng, uint32_t exceptions)
+{
+	trng_hw_release(trng);
+
+	if (IS_ENABLED(CFG_VERSAL_TRNG_PREEMPTIBLE))
+		mutex_unlock(&trng->mu);
+	else
+		thread_unmask_exceptions(exceptions);
+}
+
+#if defined(CFG_VERSAL_TRNG_RING)
+static size_t trng_ring_take(struct versal_trng *trng, uint8_t *buf,
+			     size_t len)
+{
+	struct trng_ring *ring = &trng->ring;
+	uint32_t exceptions = 0;
+	size_t done = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&ring->lock);
+	while (done < len && ring->count) {
+		n = MIN(len - done, ring->count);
+		n = MIN(n, TRNG_RING_SIZE - ring->head);
+		memcpy(buf + done, ring->data + ring->head, n);
+		memzero_explicit(ring->data + ring->head, n);
+		ring->head = (ring->head + n) % TRNG_RING_SIZE;
+		ring->count -= n;
+		done += n;
+	}
+	if (ring->count < TRNG_RING_WATERMARK)
+		ring->refilling = true;
+	cpu_spin_unlock_xrestore(&ring->lock, exceptions);
+
+	return done;
+}
+
+static void trng_ring_put(struct versal_trng *trng, const uint8_t *buf,
+			  size_t len)
+{
+	struct trng_ring *ring = &trng->ring;
+	uint32_t exceptions = 0;
+	size_t tail = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&ring->lock);
+	len = MIN(len, TRNG_RING_SIZE - ring->count);
+	while (len) {
+		tail = (ring->head + ring->count) % TRNG_RING_SIZE;
+		n = MIN(len, TRNG_RING_SIZE - tail);
+		memcpy(ring->data + tail, buf, n);
+		ring->count += n;
+		buf += n;
+		len -= n;
+	}
+	if (ring->count == TRNG_RING_SIZE)
+		ring->refilling = false;
+	cpu_spin_unlock_xrestore(&ring->lock, exceptions);
+}
+
+/*
+ * Reseeds ahead of the policy boundary and generates one chunk into the
+ * ring if it's below the watermark, the caller owns the hardware. Returns
+ * false once the ring has been stopped on an error.
+ */
+static bool trng_ring_fill(struct versal_trng *trng)
+{
+	uint8_t chunk[TRNG_RING_CHUNK_LEN] = { 0 };
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Reseed ahead of the policy boundary, off the request path */
+	if (trng_reseed_due(trng, true))
+		res = trng_reseed_internal(trng, NULL, NULL, 0);
+	if (res) {
+		EMSG("TRNG background reseed failed");
+		goto err;
+	}
+
+	if (!trng->ring.enabled || !trng->ring.refilling)
+		return true;
+
+	res = trng_generate_bulk(trng, chunk, sizeof(chunk));
+	if (res) {
+		EMSG("TRNG ring refill failed, using synchronous generation");
+		goto err;
+	}
+
+	trng_ring_put(trng, chunk, sizeof(chunk));
+	memzero_explicit(chunk, sizeof(chunk));
+
+	return true;
+err:
+	trng->ring.enabled = false;
+	trng->ring.stopped = true;
+	return false;
+}
+
+static bool trng_ring_work_due(struct versal_trng *trng)
+{
+	return (trng->ring.enabled && trng->ring.refilling) ||
+	       trng_reseed_due(trng, true);
+}
+
+#if defined(CFG_CORE_WORKQUEUE)
+/*
+ * Called from a bottom half thread: the ring is refilled one chunk at a
+ * time with exceptions masked only while the hardware is owned, so the
+ * thread can be preempted between chunks.
+ */
+static void trng_ring_work(struct work *w)
+{
+	struct versal_trng *trng = container_of(w, struct versal_trng,
+						ring.work);
+	uint32_t exceptions = 0;
+	bool cont = true;
+
+	while (cont && trng_ring_work_due(trng)) {
+		exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+		/* Queued again by the callout if a request owns the hardware */
+		if (!trng_hw_claim(trng)) {
+			thread_unmask_exceptions(exceptions);
+			return;
+		}
+		cont = trng_ring_fill(trng) && trng->ring.enabled;
+		trng_hw_release(trng);
+		thread_unmask_exceptions(exceptions);
+	}
+}
+
+/* Called from the timer interrupt, only queues the refill */
+static bool trng_ring_cb(struct callout *co)
+{
+	struct versal_trng *trng = container_of(co, struct versal_trng,
+						ring.callout);
+
+	if (trng->ring.stopped)
+		return false;
+
+	if (trng_ring_work_due(trng))
+		work_queue(&trng->ring.work, trng_ring_work);
+
+	return true;
+}
+#else
+/*
+ * Called from the timer interrupt: generates at most TRNG_RING_CHUNK_LEN
+ * bytes per invocation to bound the time spent busy-polling the hardware
+ * with interrupts masked and calls back sooner while the ring isn't full
+ * again.
+ */
+static bool trng_ring_cb(struct callout *co)
+{
+	struct versal_trng *trng = container_of(co, struct versal_trng,
+						ring.callout);
+
+	/* A synchronous request owns the hardware, try again shortly */
+	if (!trng_hw_claim(trng)) {
+		callout_set_next_timeout(co, TRNG_RING_BUSY_MS);
+		return true;
+	}
+
+	if (!trng_ring_fill(trng)) {
+		trng_hw_release(trng);
+		return false;
+	}
+	trng_hw_release(trng);
+
+	if (trng->ring.enabled && trng->ring.refilling)
+		callout_set_next_timeout(co, TRNG_RING_BUSY_MS);
+	else
+		callout_set_next_timeout(co, TRNG_RING_IDLE_MS);
+
+	return true;
+}
+#endif
+
+static void trng_ring_start(struct versal_trng *trng)
+{
+	COMPILE_TIME_ASSERT(!(TRNG_RING_SIZE % TRNG_RING_CHUNK_LEN));
+
+	/* The ring is fed by the DRBG, PTRNG output goes through the DF */
+	if (trng->usr_cfg.mode == TRNG_PTRNG)
+		return;
+
+	/*
+	 * Without a work queue the callout refills in interrupt context where
+	 * the VFP unit used by the crypto API can't be enabled, and the work
+	 * masks exceptions too, so a reseed must not need the crypto API DF
+	 * backend.
+	 */
+	if (IS_ENABLED(CFG_VERSAL_TRNG_DF_CRYPTO) &&
+	    !trng->usr_cfg.df_disable && trng->cfg.version != TRNG_V2)
+		return;
+
+	/*
+	 * Output kept in the ring would span requests, with a reseed per
+	 * request the callout only reseeds ahead of the next request.
+	 */
+	trng->ring.refilling = true;
+	trng->ring.enabled = !IS_ENABLED(CFG_VERSAL_TRNG_RESEED_PER_REQUEST);
+	if (IS_ENABLED(CFG_CORE_WORKQUEUE))
+		callout_add(&trng->ring.callout, trng_ring_cb,
+			    TRNG_RING_IDLE_MS);
+	else
+		callout_add(&trng->ring.callout, trng_ring_cb,
+			    TRNG_RING_BUSY_MS);
+}
+#endif
+
+/*
+ * Health test, instantiation and first reseed of the instance, the part of
+ * the initialization that waits for the entropy source.
+ */
+static TEE_Result trng_bring_up(struct versal_trng *trng,
+				struct trng_usr_cfg *usr_cfg)
+{
+	if (trng_health_test(trng)) {
+		EMSG("RunHealthTest Failed");
+		return TEE_ERROR_GENERIC;
+	}
+
+	if (trng_instantiate(trng, usr_cfg)) {
+		EMSG("Driver instantiation Failed");
+		return TEE_ERROR_GENERIC;
+	}
+
+	if (trng_reseed(trng, NULL, usr_cfg->dfmul)) {
+		EMSG("Reseed Failed");
+		return TEE_ERROR_GENERIC;
+	}
+
+#if defined(CFG_VERSAL_TRNG_RING)
+	trng_ring_start(trng);
+#endif
+
+	return TEE_SUCCESS;
+}
+
+/* Called by the first consumer with the hardware claimed */
+static TEE_Result trng_complete_init(struct versal_trng *trng)
+{
+	TEE_Result res = trng_bring_up(trng, &trng->init_cfg);
+
+	memzero_explicit(&trng->init_cfg, sizeof(trng->init_cfg));
+	trng->init_pending = false;
+
+	return res;
+}
+
+TEE_Result versal_trng_get_random_bytes(struct versal_trng *trng,
+					void *buf, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	uint8_t *p = buf;
+	size_t n = 0;
+
+#if defined(CFG_VERSAL_TRNG_RING)
+	if (trng->ring.enabled) {
+		n = trng_ring_take(trng, p, len);
+		p += n;
+		len -= n;
+	}
+#endif
+
+	/*
+	 * Ring empty or disabled, fall back to synchronous generation. With
+	 * a reseed per request only the first chunk may need one.
+	 */
+	while (len) {
+		n = MIN(len, (size_t)TRNG_SYNC_CHUNK_LEN);
+		exceptions = trng_hw_get(trng);
+		if (trng->init_pending)
+			res = trng_complete_init(trng);
+		/*
+		 * A failed reseed leaves the instance in TRNG_ERROR, it
+		 * doesn't generate anymore until it's instantiated again.
+		 */
+		if (!res &&
+		    (p == buf ||
+		     !IS_ENABLED(CFG_VERSAL_TRNG_RESEED_PER_REQUEST)) &&
+		    trng_reseed_due(trng, false))
+			res = trng_reseed_internal(trng, NULL, NULL, 0);
+		if (!res)
+			res = trng_get_random_bytes_sync(trng, p, n);
+		trng_hw_put(trng, exceptions);
+		if (res) {
+			/* Nothing already produced is handed out */
+			memzero_explicit(buf, p - (uint8_t *)buf);
+			return res;
+		}
+		p += n;
+		len -= n;
 	}
 
 	return TEE_SUCCESS;
@@ -1881,6 +2543,8 @@ TEE_Result versal_trng_get_random_bytes(struct versal_trng *trng,
 TEE_Result versal_trng_hw_init(struct versal_trng *trng,
 			       struct trng_usr_cfg *usr_cfg)
 {
+	mutex_init(&trng->mu);
+
 	trng->cfg.addr = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC,
 						       trng->cfg.base,
 						       trng->cfg.len);
@@ -1927,20 +2591,18 @@ TEE_Result versal_trng_hw_init(struct versal_trng *trng,
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
-	if (trng_health_test(trng)) {
-		EMSG("RunHealthTest Failed");
-		panic();
-	}
-
-	if (trng_instantiate(trng, usr_cfg)) {
-		EMSG("Driver instantiation Failed");
-		panic();
+	/*
+	 * The KAT above doesn't depend on the entropy source, the rest of
+	 * the initialization can wait for the first request.
+	 */
+	if (IS_ENABLED(CFG_VERSAL_TRNG_LAZY_INIT)) {
+		trng->init_cfg = *usr_cfg;
+		trng->init_pending = true;
+		return TEE_SUCCESS;
 	}
 
-	if (trng_reseed(trng, NULL, usr_cfg->dfmul)) {
-		EMSG("Reseed Failed");
+	if (trng_bring_up(trng, usr_cfg))
 		panic();
-	}
 
 	return TEE_SUCCESS;
 }
@@ -1955,10 +2617,24 @@ static struct versal_trng versal_trng = {
 	.cfg.version = TRNG_V1,
 };
 
+#if defined(CFG_CORE_RNG_SOURCES)
+static TEE_Result versal_trng_source_read(void *buf, size_t len)
+{
+	return versal_trng_get_random_bytes(&versal_trng, buf, len);
+}
+
+static struct rng_source versal_trng_source = {
+	.name = "versal-trng",
+	.read = versal_trng_source_read,
+	.quality = 8,
+	.bytes_per_sec = 1024 * 1024,
+};
+#else
 TEE_Result hw_get_random_bytes(void *buf, size_t len)
 {
 	return versal_trng_get_random_bytes(&versal_trng, buf, len);
 }
+#endif
 
 static TEE_Result trng_hrng_mode_init(void)
 {
@@ -1981,10 +2657,17 @@ static TEE_Result trng_hrng_mode_init(void)
 		.iseed_en =  false,
 		.pstr_en = true,
 	};
+	TEE_Result res = TEE_SUCCESS;
 
 	memcpy(usr_cfg.pstr, pers_str, TRNG_PERS_STR_LEN);
 
-	return versal_trng_hw_init(&versal_trng, &usr_cfg);
+	res = versal_trng_hw_init(&versal_trng, &usr_cfg);
+#if defined(CFG_CORE_RNG_SOURCES)
+	if (!res)
+		rng_source_register(&versal_trng_source);
+#endif
+
+	return res;
 }
 
 driver_init(trng_hrng_mode_init);
@@ -1996,60 +2679,110 @@ driver_init(trng_hrng_mode_init);
 
 #define VERSAL_TRNG_GENERATE 22
 
-#define VERSAL_TRNG_SEC_STRENGTH_IN_BYTES 32
+#define VERSAL_TRNG_PLM_MAX_LEN	CFG_VERSAL_RNG_PLM_MAX_REQ
+#define VERSAL_TRNG_PLM_BUF_LEN	1024
 
-TEE_Result hw_get_random_bytes(void *buf, size_t len)
+/* Persistent bounce buffer shared with the PLM, allocated on first use */
+static struct versal_mbox_mem plm_buf;
+static struct mutex plm_buf_lock = MUTEX_INITIALIZER;
+
+/* One IPI per VERSAL_TRNG_PLM_MAX_LEN bytes, written straight into @mem */
+static TEE_Result plm_trng_fill(struct versal_mbox_mem *mem, size_t len)
 {
-	uint32_t a = 0;
-	uint32_t b = 0;
 	struct versal_ipi_cmd cmd = { };
-	struct versal_mbox_mem p = { };
 	TEE_Result ret = TEE_SUCCESS;
 	uint32_t status = 0;
-	uint32_t offset = 0;
-
-	ret = versal_mbox_alloc(len, NULL, &p);
-	if (ret)
-		return ret;
+	size_t offset = 0;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	size_t n = 0;
 
 	cmd.data[0] = CRYPTO_API_ID(VERSAL_TRNG_GENERATE);
-	cmd.ibuf[0].mem = p;
+	cmd.ibuf[0].mem = *mem;
 
-	while (len > VERSAL_TRNG_SEC_STRENGTH_IN_BYTES) {
-		reg_pair_from_64(virt_to_phys(p.buf) + offset, &b, &a);
+	while (offset < len) {
+		n = MIN(len - offset, (size_t)VERSAL_TRNG_PLM_MAX_LEN);
+		reg_pair_from_64(virt_to_phys(mem->buf) + offset, &b, &a);
 
 		cmd.data[1] = a;
 		cmd.data[2] = b;
-		cmd.data[3] = (uint32_t)VERSAL_TRNG_SEC_STRENGTH_IN_BYTES;
+		cmd.data[3] = n;
 
 		ret = versal_mbox_notify_pmc(&cmd, NULL, &status);
-		if (!ret) {
-			memcpy((uint8_t *)buf + offset,
-			       (uint8_t *)p.buf + offset,
-			       VERSAL_TRNG_SEC_STRENGTH_IN_BYTES);
-		} else {
+		if (ret) {
 			DMSG("Getting randomness returned 0x%" PRIx32, status);
-			goto out;
+			return ret;
 		}
 
-		offset += VERSAL_TRNG_SEC_STRENGTH_IN_BYTES;
-		len -= VERSAL_TRNG_SEC_STRENGTH_IN_BYTES;
+		offset += n;
 	}
 
-	reg_pair_from_64(virt_to_phys(p.buf) + offset, &b, &a);
+	return TEE_SUCCESS;
+}
 
-	cmd.data[1] = a;
-	cmd.data[2] = b;
-	cmd.data[3] = (uint32_t)len;
+/*
+ * The PLM can write the result directly into the caller buffer when it is
+ * secure, physically contiguous and meets the mailbox cache maintenance
+ * alignment constraints.
+ */
+static bool plm_trng_direct(void *buf, size_t len)
+{
+	paddr_t pa = virt_to_phys(buf);
+	size_t offs = 0;
 
-	ret = versal_mbox_notify_pmc(&cmd, NULL, &status);
-	if (!ret)
-		memcpy((uint8_t *)buf + offset, (uint8_t *)p.buf + offset, len);
-	else
-		DMSG("Getting randomness returned 0x%" PRIx32, status);
+	if (!pa || !IS_ALIGNED((vaddr_t)buf, CACHELINE_LEN) ||
+	    !IS_ALIGNED(len, CACHELINE_LEN) || !tee_vbuf_is_sec(buf, len))
+		return false;
+
+	for (offs = ROUNDUP((vaddr_t)buf + 1, SMALL_PAGE_SIZE) - (vaddr_t)buf;
+	     offs < len; offs += SMALL_PAGE_SIZE)
+		if (virt_to_phys((uint8_t *)buf + offs) != pa + offs)
+			return false;
 
+	return true;
+}
+
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	struct versal_mbox_mem mem = {
+		.alloc_len = len,
+		.len = len,
+		.buf = buf,
+	};
+	TEE_Result ret = TEE_SUCCESS;
+	uint8_t *p = buf;
+	size_t n = 0;
+
+	if (!len)
+		return TEE_SUCCESS;
+
+	if (plm_trng_direct(buf, len))
+		return plm_trng_fill(&mem, len);
+
+	mutex_lock(&plm_buf_lock);
+
+	if (!plm_buf.buf) {
+		ret = versal_mbox_alloc(VERSAL_TRNG_PLM_BUF_LEN, NULL,
+					&plm_buf);
+		if (ret)
+			goto out;
+	}
+
+	while (len) {
+		n = MIN(len, plm_buf.alloc_len);
+		ret = plm_trng_fill(&plm_buf, n);
+		if (ret)
+			break;
+
+		memcpy(p, plm_buf.buf, n);
+		p += n;
+		len -= n;
+	}
+
+	memzero_explicit(plm_buf.buf, plm_buf.alloc_len);
 out:
-	versal_mbox_free(&p);
+	mutex_unlock(&plm_buf_lock);
+
 	return ret;
 }
 #endif
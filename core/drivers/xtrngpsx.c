@@ -34,16 +34,18 @@
 ******************************************************************************/
 
 /***************************** Include Files *********************************/
+#include <crypto/rng_stats.h>
+#include <drivers/versal_trng.h>
 #include <drivers/xtrngpsx.h>
 #include <drivers/xtrngpsx_hw.h>
 #include <drivers/sleep.h>
 #include <drivers/xstatus.h>
 #include <drivers/xil_sutil.h>
 #include <string.h>
+#include <string_ext.h>
 
 /************************** Constant Definitions *****************************/
 #define XTRNGPSX_RESEED_TIMEOUT			1500000U /**< Reseed timeout in micro-seconds */
-#define XTRNGPSX_GENERATE_TIMEOUT		1500000U /**< Generate timeout in micro-seconds */
 #define XTRNGPSX_WORD_LEN_IN_BYTES		4U	     /**< Word length in bytes */
 #define XTRNGPSX_BYTE_LEN_IN_BITS		8U	     /**< Byte length in bits */
 #define XTRNGPSX_BLOCK_LEN_IN_BYTES		16U	     /**< TRNG block length length in bytes */
@@ -62,7 +64,6 @@
 #define XTRNGPSX_RESET_DELAY_US					10U    /** < Reset delay */
 #define XTRNGPSX_DF_700CLKS_WAIT				10U    /** < delay after 4bytes */
 #define XTRNGPSX_DF_2CLKS_WAIT					2U     /** < delay after 1byte */
-#define XTRNGPSX_STATUS_QCNT_VAL				4U     /** < QCNT value for single burst */
 
 #define XTRNGPSX_TEMPORAL_IMPL 					XSECURE_TEMPORAL_IMPL
 #define XTRNGPSX_TEMPORAL_CHECK 				XSECURE_TEMPORAL_CHECK
@@ -78,8 +79,6 @@ static int XTrngpsx_WriteSeed(XTrngpsx_Instance *InstancePtr, const u8 *Seed, u8
 static inline int XTrngpsx_WaitForEvent(UINTPTR Addr, u32 EventMask, u32 Event,
 		u32 Timeout);
 static inline void XTrngpsx_WriteReg(UINTPTR Address, u32 RegValue);
-static inline u32 XTrngpsx_ReadReg(UINTPTR RegAddress);
-static inline int XTrngpsx_UtilRMW32(UINTPTR RegAddress, u32 Mask, u32 Value);
 static int XTrngpsx_Set(XTrngpsx_Instance *InstancePtr);
 static int XTrngpsx_Reset(XTrngpsx_Instance *InstancePtr);
 static int XTrngpsx_PrngReset(XTrngpsx_Instance *InstancePtr);
@@ -128,106 +127,6 @@ static inline void XTrngpsx_WriteReg(UINTPTR Address, u32 RegValue)
 	Xil_Out32(Address, RegValue);
 }
 
-
-static u32 Xil_EndianSwap32(u32 Data)
-{
-	u16 LoWord;
-	u16 HiWord;
-
-	/* get each of the half words from the 32 bit word */
-
-	LoWord = (u16) (Data & 0x0000FFFFU);
-	HiWord = (u16) ((Data & 0xFFFF0000U) >> 16U);
-
-	/* byte swap each of the 16 bit half words */
-
-	LoWord = (u16)(((LoWord & 0xFF00U) >> 8U) | ((LoWord & 0x00FFU) << 8U));
-	HiWord = (u16)(((HiWord & 0xFF00U) >> 8U) | ((HiWord & 0x00FFU) << 8U));
-
-	/* swap the half words before returning the value */
-
-	return ((((u32)LoWord) << (u32)16U) | (u32)HiWord);
-}
-
-/*************************************************************************************************/
-/**
- * @brief
- * Read from the register.
- *
- * @param	RegAddress Address of the register.
- *
- * @return	The value read from the register.
- *
- **************************************************************************************************/
-static inline u32 XTrngpsx_ReadReg(UINTPTR RegAddress)
-{
-	return Xil_In32(RegAddress);
-}
-
-// Xil_SecureRMW32(addr, mask, val)
-
-// static inline s32 Xil_SecureRMW32(vaddr_t addr, uint32_t mask, uint32_t value)
-// {
-// 	int status = XST_FAILURE;
-// 	uint32_t reg = io_read32(addr);
-// 	uint32_t val;
-// 	val = (val & ~mask) | (value & mask);
-// 	io_write32(addr, val);
-
-// 	//Verify
-// 	reg = io_read32(addr) & mask;
-// 	if(reg == (mask & value)){
-// 		status = XST_SUCCESS;
-// 	} else {
-// 		IMSG("Reg value is not what was written !");
-// 	}
-
-// 	return status;
-// }
-
-// static inline int secure_rmw32(vaddr_t addr, uint32_t mask, uint32_t value)
-// {
-// 	int status = XST_FAILURE;
-// 	uint32_t reg = io_read32(addr);
-// 	uint32_t val;
-// 	val = (val & ~mask) | (value & mask);
-// 	io_write32(addr, val);
-
-// 	//Verify
-// 	reg = io_read32(addr) & mask;
-// 	if(reg == (mask & value)){
-// 		status = XST_SUCCESS;
-// 	} else {
-// 		IMSG("Reg value is not what was written !");
-// 	}
-
-// 	return status;
-// }
-
-
-/*************************************************************************************************/
-/**
- * @brief
- * This function reads, modifies and writes in to the register
- *
- * @param	RegAddress Address of the register.
- * @param	Mask Indicates the bits to be modified
- * @param	Value Contains 32 bit Value to be written at the specified address
- *
- * @return
- * 		-XST_SUCCESS On successful write
- * 		-XST_FAILURE On failure
- *
- **************************************************************************************************/
-static inline int XTrngpsx_UtilRMW32(UINTPTR RegAddress, u32 Mask, u32 Value) {
-
-	int Status = XST_FAILURE;
-
-	Status = Xil_SecureRMW32(RegAddress, Mask, Value);
-
-	return Status;
-}
-
 /*************************************************************************************************/
 /**
  * @brief
@@ -248,7 +147,7 @@ static int XTrngpsx_Set(XTrngpsx_Instance *InstancePtr) {
 		goto END;
 	}
 	udelay(XTRNGPSX_RESET_DELAY_US);
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_RESET), TRNG_RESET_VAL_MASK, 0U);
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_RESET), TRNG_RESET_VAL_MASK, 0U);
 	if (Status != XST_SUCCESS) {
 		goto END;
 	}
@@ -273,7 +172,7 @@ END:
 static int XTrngpsx_Reset(XTrngpsx_Instance *InstancePtr) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_RESET), TRNG_RESET_VAL_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_RESET), TRNG_RESET_VAL_MASK,
 		TRNG_RESET_DEFVAL);
 
 	return Status;
@@ -299,7 +198,7 @@ static int XTrngpsx_PrngSet(XTrngpsx_Instance *InstancePtr) {
 		goto END;
 	}
 	udelay(XTRNGPSX_RESET_DELAY_US);
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSRST_MASK, 0U);
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSRST_MASK, 0U);
 END:
 	return Status;
 }
@@ -319,7 +218,7 @@ END:
 static int XTrngpsx_PrngReset(XTrngpsx_Instance *InstancePtr) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSRST_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSRST_MASK,
 		TRNG_CTRL_PRNGSRST_MASK);
 
 	return Status;
@@ -341,7 +240,7 @@ static int XTrngpsx_PrngReset(XTrngpsx_Instance *InstancePtr) {
 static int XTrngpsx_CfgDfLen(XTrngpsx_Instance *InstancePtr, u8 DfLen) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_3), TRNG_CTRL_3_DLEN_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_3), TRNG_CTRL_3_DLEN_MASK,
 		(DfLen << TRNG_CTRL_3_DLEN_SHIFT));
 
 	return Status;
@@ -363,7 +262,7 @@ static int XTrngpsx_CfgDfLen(XTrngpsx_Instance *InstancePtr, u8 DfLen) {
 static int XTrngpsx_CfgAdaptPropTestCutoff(XTrngpsx_Instance *InstancePtr, u16 AdaptPropTestCutoff) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_3), TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_3), TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_MASK,
 		(AdaptPropTestCutoff << TRNG_CTRL_3_ADAPTPROPTESTCUTOFF_SHIFT));
 
 	return Status;
@@ -385,7 +284,7 @@ static int XTrngpsx_CfgAdaptPropTestCutoff(XTrngpsx_Instance *InstancePtr, u16 A
 static int XTrngpsx_CfgRepCountTestCutoff(XTrngpsx_Instance *InstancePtr, u16 RepCountTestCutoff) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_2), TRNG_CTRL_2_REPCOUNTTESTCUTOFF_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_2), TRNG_CTRL_2_REPCOUNTTESTCUTOFF_MASK,
 		(RepCountTestCutoff << TRNG_CTRL_2_REPCOUNTTESTCUTOFF_SHIFT));
 
 	return Status;
@@ -407,7 +306,7 @@ static int XTrngpsx_CfgRepCountTestCutoff(XTrngpsx_Instance *InstancePtr, u16 Re
 static int XTrngpsx_CfgDIT(XTrngpsx_Instance *InstancePtr, u8 DITValue) {
 	int Status = XST_FAILURE;
 
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_2), TRNG_CTRL_2_DIT_MASK,
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL_2), TRNG_CTRL_2_DIT_MASK,
 		(DITValue << TRNG_CTRL_2_DIT_SHIFT));
 
 	return Status;
@@ -942,7 +841,7 @@ static int XTrngpsx_WaitForReseed(XTrngpsx_Instance *InstancePtr) {
 		Status = XTRNGPSX_CATASTROPHIC_CTF_ERROR;
 		goto END;
 	}
-	Status = XTrngpsx_UtilRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSTART_MASK |
+	Status = Xil_SecureRMW32((InstancePtr->Config.BaseAddress + TRNG_CTRL), TRNG_CTRL_PRNGSTART_MASK |
 			TRNG_CTRL_TRSSEN_MASK, 0U);
 	
 END:
@@ -967,12 +866,9 @@ END:
 static int XTrngpsx_CollectRandData(XTrngpsx_Instance *InstancePtr, u8 *RandBuf, u32 RandBufSize) {
 	volatile int Status = XST_FAILURE;
 	volatile int StatusTmp = XST_FAILURE;
-	// volatile int SStatus = XST_FAILURE;
-	u8 Idx = 0U;
-	volatile u8 NumofBursts = 0U;
-	u8 BurstIdx = 0U;
-	u32 RegVal = 0U;
-	u32 Size = RandBufSize / XTRNGPSX_WORD_LEN_IN_BYTES;
+	u8 Block[XTRNGPSX_SEC_STRENGTH_IN_BURSTS * XTRNGPSX_BURST_SIZE_IN_WORDS *
+		 XTRNGPSX_WORD_LEN_IN_BYTES] = { 0U };
+	TEE_Result Res = TEE_SUCCESS;
 	u32 SingleGenModeVal = 0U;
 
 	if (InstancePtr->UserCfg.PredResistance == TRUE) {
@@ -993,40 +889,30 @@ static int XTrngpsx_CollectRandData(XTrngpsx_Instance *InstancePtr, u8 *RandBuf,
 		goto END;
 	}
 
-	for (NumofBursts = 0; NumofBursts < XTRNGPSX_SEC_STRENGTH_IN_BURSTS; NumofBursts++) {
-		XTRNGPSX_TEMPORAL_IMPL(Status, StatusTmp, wait_for_event, (UINTPTR)(InstancePtr->Config.BaseAddress + TRNG_STATUS),
-			TRNG_STATUS_QCNT_MASK,
-			(XTRNGPSX_STATUS_QCNT_VAL << TRNG_STATUS_QCNT_SHIFT),
-			XTRNGPSX_GENERATE_TIMEOUT);
-		if ((Status != XST_SUCCESS) || (StatusTmp != XST_SUCCESS)) {
-			Status = XTRNGPSX_TIMEOUT_ERROR;
-			goto END;
-		}
-		if ((Xil_In32(InstancePtr->Config.BaseAddress + TRNG_STATUS) & TRNG_STATUS_DTF_MASK) ==
-			TRNG_STATUS_DTF_MASK) {
-			InstancePtr->ErrorState = XTRNGPSX_CATASTROPHIC;
-			Status = XTRNGPSX_CATASTROPHIC_DTF_ERROR;
-			goto END;
-		}
-		BurstIdx = NumofBursts * XTRNGPSX_BURST_SIZE_IN_WORDS;
-		for (Idx = 0U; Idx < XTRNGPSX_BURST_SIZE_IN_WORDS; Idx++) {
-			RegVal = XTrngpsx_ReadReg((InstancePtr->Config.BaseAddress + TRNG_CORE_OUTPUT));
-			if ((Idx + BurstIdx) < Size) {
-				*((u32*)RandBuf + Idx + BurstIdx) =
-						Xil_EndianSwap32(RegVal);
-			}
-		}
+	/*
+	 * Shared streaming path with the versal_trng driver: always drain the
+	 * full security strength worth of bursts, only the first RandBufSize
+	 * bytes are returned.
+	 */
+	Res = versal_trng_stream(InstancePtr->Config.BaseAddress, Block,
+				 sizeof(Block), true, NULL);
+	if (Res == TEE_ERROR_TIMEOUT) {
+		Status = XTRNGPSX_TIMEOUT_ERROR;
+		goto END;
 	}
-	if (NumofBursts == XTRNGPSX_SEC_STRENGTH_IN_BURSTS) {
-		Status = XST_SUCCESS;
+	if (Res != TEE_SUCCESS) {
+		InstancePtr->ErrorState = XTRNGPSX_CATASTROPHIC;
+		Status = XTRNGPSX_CATASTROPHIC_DTF_ERROR;
+		goto END;
 	}
 
+	memcpy(RandBuf, Block, MIN(RandBufSize, (u32)sizeof(Block)));
+	Status = XST_SUCCESS;
+
 END:
+	memzero_explicit(Block, sizeof(Block));
 	if (Status != XST_SUCCESS) {
 		memset(RandBuf, 0U, RandBufSize);
-		// if (SStatus != XST_SUCCESS) {
-		// 	Status |= SStatus;
-		// }
 	}
 
 	return Status;
@@ -1131,7 +1017,12 @@ static int XTrngpsx_WritePersString(XTrngpsx_Instance *InstancePtr, const u8 *Pe
 static inline int XTrngpsx_WaitForEvent(UINTPTR Addr, u32 EventMask, u32 Event,
 		u32 Timeout)
 {
-	return (int)Xil_WaitForEvent(Addr, EventMask, Event, Timeout);
+	uint64_t Start = rng_stats_now();
+	int Status = (int)Xil_WaitForEvent(Addr, EventMask, Event, Timeout);
+
+	rng_stats_busy_wait(Start);
+
+	return Status;
 }
 
 #define TIMEOUT_VAL 1000000
\ No newline at end of file
@@ -35,6 +35,37 @@ TEE_Result crypto_hash_final(void *ctx, uint8_t *digest, size_t len);
 void crypto_hash_free_ctx(void *ctx);
 void crypto_hash_copy_state(void *dst_ctx, void *src_ctx);
 
+/*
+ * struct crypto_hash_frag - Fragment of a message
+ * @data:	Data of the fragment
+ * @len:	Length of @data in bytes
+ */
+struct crypto_hash_frag {
+	const void *data;
+	size_t len;
+};
+
+/*
+ * struct crypto_hash_msg - Message for crypto_sha256_multi()
+ * @frags:	Fragments making up the message, hashed in order
+ * @num_frags:	Number of entries in @frags
+ * @digest:	Receives the TEE_SHA256_HASH_SIZE bytes long digest
+ */
+struct crypto_hash_msg {
+	const struct crypto_hash_frag *frags;
+	size_t num_frags;
+	uint8_t *digest;
+};
+
+/*
+ * Computes the SHA-256 digests of @count independent messages. With
+ * CFG_CORE_CRYPTO_SHA256_ACCEL=y short messages of the same number of
+ * blocks are hashed two at a time by the multi-buffer implementation,
+ * everything else is hashed one message at a time.
+ */
+TEE_Result crypto_sha256_multi(const struct crypto_hash_msg *msgs,
+			       size_t count);
+
 /* Symmetric ciphers */
 TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo);
 TEE_Result crypto_cipher_init(void *ctx, TEE_OperationMode mode,
@@ -117,6 +148,12 @@ struct rsa_keypair {
 	struct bignum *qp;	/* 1/q mod p */
 	struct bignum *dp;	/* d mod (p-1) */
 	struct bignum *dq;	/* d mod (q-1) */
+
+	/*
+	 * State derived from the key by the crypto backend, dropped with
+	 * crypto_acipher_rsa_keypair_changed()
+	 */
+	void *priv;
 };
 
 struct rsa_public_key {
@@ -195,6 +232,12 @@ TEE_Result crypto_acipher_alloc_rsa_public_key(struct rsa_public_key *s,
 				   size_t key_size_bits);
 void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s);
 void crypto_acipher_free_rsa_keypair(struct rsa_keypair *s);
+/*
+ * Release the state a backend derived from @s to speed up repeated private
+ * key operations with the same key. Must be called whenever the bignums of
+ * @s are modified or freed other than by crypto_acipher_free_rsa_keypair().
+ */
+void crypto_acipher_rsa_keypair_changed(struct rsa_keypair *s);
 TEE_Result crypto_acipher_alloc_dsa_keypair(struct dsa_keypair *s,
 				size_t key_size_bits);
 TEE_Result crypto_acipher_alloc_dsa_public_key(struct dsa_public_key *s,
@@ -366,6 +409,9 @@ enum crypto_rng_src {
 	CRYPTO_RNG_SRC_JITTER_SESSION	= (0 << 1 | 0),
 	CRYPTO_RNG_SRC_JITTER_RPC	= (1 << 1 | 1),
 	CRYPTO_RNG_SRC_NONSECURE	= (1 << 1 | 0),
+	CRYPTO_RNG_SRC_FIRMWARE		= (2 << 1 | 1),
+	CRYPTO_RNG_SRC_SECURE_ELEMENT	= (3 << 1 | 0),
+	CRYPTO_RNG_SRC_HW_TRNG		= (4 << 1 | 0),
 };
 
 /*
@@ -382,15 +428,47 @@ TEE_Result crypto_rng_init(const void *data, size_t dlen);
  * @data:	Data associated with the event
  * @dlen:	Length of @data
  *
- * @sid controls whether the event is merly queued in a ring buffer or if
- * it's added to one of the pools directly. If CRYPTO_RNG_SRC_IS_QUICK() is
- * true (lowest bit set) events are queue otherwise added to corresponding
- * pool. If CRYPTO_RNG_SRC_IS_QUICK() is false, eventual queued events are
- * added to their queues too.
+ * @sid controls whether the event is merly queued in a per core staging
+ * buffer or if it's added to one of the pools directly. If
+ * CRYPTO_RNG_SRC_IS_QUICK() is true (lowest bit set) events are queue
+ * otherwise added to corresponding pool. If CRYPTO_RNG_SRC_IS_QUICK() is
+ * false, eventual queued events are added to their queues too.
  */
 void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
 			  const void *data, size_t dlen);
 
+/*
+ * crypto_rng_add_bulk() - supply a batch of entropy source output to the RNG
+ * @sid:	Source identifier, must not be a quick source
+ * @data:	Output of the entropy source
+ * @dlen:	Length of @data, at least one byte per pool
+ *
+ * @data is split in one slice per pool and each pool is updated with its
+ * slice in one go, instead of one crypto_rng_add_event() call per small
+ * event. Must be called from a thread context.
+ */
+TEE_Result crypto_rng_add_bulk(enum crypto_rng_src sid, const void *data,
+			       size_t dlen);
+
+#ifdef CFG_CRYPTO_RNG_BULK_SEED
+/*
+ * crypto_rng_set_bulk_source() - set the hardware TRNG used for bulk seeding
+ * @read:	Reads random bytes from the TRNG
+ *
+ * Called by a TRNG driver once crypto_rng_init() has been called, from
+ * plat_rng_init() typically. CFG_CRYPTO_RNG_BULK_SEED_BYTES bytes are read
+ * and added with crypto_rng_add_bulk() right away and again every
+ * CFG_CRYPTO_RNG_BULK_SEED_MS milliseconds with
+ * CFG_CRYPTO_RNG_BULK_SEED_REFRESH=y.
+ */
+void crypto_rng_set_bulk_source(TEE_Result (*read)(void *buf, size_t len));
+#else
+static inline void
+crypto_rng_set_bulk_source(TEE_Result (*read)(void *buf, size_t len) __unused)
+{
+}
+#endif
+
 /*
  * crypto_rng_read() - read cryptograhically secure RNG
  * @buf:	Buffer to hold the data
@@ -401,6 +479,29 @@ void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
  */
 TEE_Result crypto_rng_read(void *buf, size_t len);
 
+#define CRYPTO_NONCE_MIN_SIZE	12
+#define CRYPTO_NONCE_MAX_SIZE	16
+
+/*
+ * crypto_nonce_read() - get a unique nonce
+ * @buf:	Buffer to hold the nonce
+ * @len:	Length of @buf, CRYPTO_NONCE_MIN_SIZE to CRYPTO_NONCE_MAX_SIZE
+ *
+ * The nonce is a random prefix drawn once per core and boot followed by
+ * a 64-bit per-core counter. It's unique but predictable, so only for
+ * values like IVs which must not repeat, never for keys or secrets.
+ */
+TEE_Result crypto_nonce_read(void *buf, size_t len);
+
+/*
+ * crypto_rng_get_event_stats() - get accounting of entropy events
+ * @consumed:	Number of events added to the pools
+ * @dropped:	Number of queued events dropped due to a full staging buffer
+ *
+ * Both counters are zero if the RNG doesn't use entropy events.
+ */
+void crypto_rng_get_event_stats(uint64_t *consumed, uint64_t *dropped);
+
 /*
  * crypto_aes_expand_enc_key() - Expand an AES key
  * @key:	AES key buffer
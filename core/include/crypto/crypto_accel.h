@@ -40,10 +40,25 @@ void crypto_accel_aes_xts_dec(void *out, const void *in, const void *key1,
 			      unsigned int block_count, const void *key2,
 			      void *tweak);
 
+/*
+ * CCM payload of @block_count blocks. @ctr holds the last counter value
+ * used and @mac the encrypted CBC-MAC state, both are updated.
+ */
+void crypto_accel_aes_ccm_enc(void *out, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count, void *ctr, void *mac);
+void crypto_accel_aes_ccm_dec(void *out, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count, void *ctr, void *mac);
+
 void crypto_accel_sha1_compress(uint32_t state[5], const void *src,
 				unsigned int block_count);
 void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 				  unsigned int block_count);
+/* Compresses two independent streams of @block_count blocks each */
+void crypto_accel_sha256_compress_x2(uint32_t state0[8], const void *src0,
+				     uint32_t state1[8], const void *src1,
+				     unsigned int block_count);
 void crypto_accel_sha512_compress(uint64_t state[8], const void *src,
 				  unsigned int block_count);
 void crypto_accel_sha3_compress(uint64_t state[25], const void *src,
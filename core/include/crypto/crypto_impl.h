@@ -376,6 +376,38 @@ drvcrypt_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx __unused,
 }
 #endif /* CFG_CRYPTO_DRV_CIPHER */
 
+/* Software implementations, regardless of any matching drvcrypt device */
+TEE_Result crypto_hash_sw_alloc_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo);
+TEE_Result crypto_cipher_sw_alloc_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo);
+
+#ifdef CFG_CRYPTO_DISPATCH
+/*
+ * Wrap the drvcrypt context @ctx of @algo together with a software one so
+ * that each operation is routed to the faster of the two for its size.
+ * @ctx is left unchanged if @algo isn't subject to dispatching.
+ */
+TEE_Result crypto_dispatch_hash_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo);
+TEE_Result crypto_dispatch_cipher_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo);
+#else
+static inline TEE_Result
+crypto_dispatch_hash_ctx(struct crypto_hash_ctx **ctx __unused,
+			 uint32_t algo __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static inline TEE_Result
+crypto_dispatch_cipher_ctx(struct crypto_cipher_ctx **ctx __unused,
+			   uint32_t algo __unused)
+{
+	return TEE_SUCCESS;
+}
+#endif /* CFG_CRYPTO_DISPATCH */
+
 #ifdef CFG_CRYPTO_DRV_MAC
 /* Cryptographic MAC driver context allocation */
 TEE_Result drvcrypt_mac_alloc_ctx(struct crypto_mac_ctx **ctx, uint32_t algo);
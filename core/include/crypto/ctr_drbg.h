@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __CRYPTO_CTR_DRBG_H
+#define __CRYPTO_CTR_DRBG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * CTR_DRBG of NIST SP 800-90A section 10.2 using AES-256 without a
+ * derivation function, for drivers which want to stretch the conditioned
+ * output of a slow entropy source. The seed material must be full entropy,
+ * the caller decides when to reseed.
+ */
+
+#define CTR_DRBG_SEED_LEN	48
+/* Maximum number of bytes per request, 2^19 bits */
+#define CTR_DRBG_MAX_REQUEST	65536
+
+/*
+ * struct ctr_drbg - DRBG working state
+ * @ctx:	AES-256 ECB context holding the key
+ * @v:		Counter block
+ */
+struct ctr_drbg {
+	void *ctx;
+	uint8_t v[16];
+};
+
+/*
+ * ctr_drbg_instantiate() - Instantiate the DRBG
+ * @drbg:	DRBG state
+ * @seed:	CTR_DRBG_SEED_LEN bytes of full entropy seed material
+ */
+TEE_Result ctr_drbg_instantiate(struct ctr_drbg *drbg, const uint8_t *seed);
+
+/*
+ * ctr_drbg_reseed() - Mix fresh seed material into the DRBG state
+ * @drbg:	DRBG state
+ * @seed:	CTR_DRBG_SEED_LEN bytes of full entropy seed material
+ */
+TEE_Result ctr_drbg_reseed(struct ctr_drbg *drbg, const uint8_t *seed);
+
+/*
+ * ctr_drbg_generate() - Generate random bytes
+ * @drbg:	DRBG state
+ * @buf:	Output buffer
+ * @len:	Number of bytes, split internally in requests of at most
+ *		CTR_DRBG_MAX_REQUEST bytes each followed by a state update
+ */
+TEE_Result ctr_drbg_generate(struct ctr_drbg *drbg, void *buf, size_t len);
+
+/* ctr_drbg_uninstantiate() - Free and wipe the DRBG state */
+void ctr_drbg_uninstantiate(struct ctr_drbg *drbg);
+
+#endif /* __CRYPTO_CTR_DRBG_H */
@@ -16,6 +16,15 @@
 #include <crypto/ghash-ce-core.h>
 #else
 struct internal_ghash_key {
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	/* Powers of H, must come first as expected by ghash-ce-core_a64.S */
+	uint64_t h[2];
+	uint64_t h2[2];
+	uint64_t h3[2];
+	uint64_t h4[2];
+	/* True if the fields above are used instead of the ones below */
+	bool use_pmull;
+#endif
 #ifdef CFG_AES_GCM_TABLE_BASED
 	uint64_t HL[16];
 	uint64_t HH[16];
@@ -23,12 +32,24 @@ struct internal_ghash_key {
 	uint64_t hash_subkey[2];
 #endif
 };
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+#include <crypto/ghash-ce-core.h>
+#endif
 #endif
 
 struct internal_aes_gcm_key {
 	/* AES (CTR) encryption key and number of rounds */
 	uint64_t data[30];
 	unsigned int rounds;
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	/*
+	 * Same key expanded for the AES instructions, only valid if
+	 * use_ce is true. Keys not set up by internal_aes_gcm_init() have
+	 * use_ce cleared and take the software path.
+	 */
+	uint64_t ce_data[30];
+	bool use_ce;
+#endif
 };
 
 struct internal_aes_gcm_state {
@@ -52,6 +73,16 @@ struct internal_aes_gcm_ctx {
 	struct internal_aes_gcm_key key;
 };
 
+/*
+ * Key with a precomputed GHASH key, for a key used for many messages
+ * where deriving the GHASH key for each message would be a significant
+ * part of the cost.
+ */
+struct internal_aes_gcm_prekey {
+	struct internal_aes_gcm_key key;
+	struct internal_ghash_key ghash_key;
+};
+
 TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
 				 TEE_OperationMode mode, const void *key,
 				 size_t key_len, const void *nonce,
@@ -84,6 +115,28 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 				const void *src, size_t len, void *dst,
 				const void *tag, size_t tag_len);
 
+/*
+ * Derives @pk->ghash_key from @pk->key which must be set up already. The
+ * key can then be used with internal_aes_gcm_prekey_enc() and
+ * internal_aes_gcm_prekey_dec() which take the same arguments as
+ * internal_aes_gcm_enc() and internal_aes_gcm_dec().
+ */
+void internal_aes_gcm_prekey_init(struct internal_aes_gcm_prekey *pk);
+
+TEE_Result
+internal_aes_gcm_prekey_enc(const struct internal_aes_gcm_prekey *pk,
+			    const void *nonce, size_t nonce_len,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    void *tag, size_t *tag_len);
+
+TEE_Result
+internal_aes_gcm_prekey_dec(const struct internal_aes_gcm_prekey *pk,
+			    const void *nonce, size_t nonce_len,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    const void *tag, size_t tag_len);
+
 void internal_aes_gcm_gfmul(const uint64_t X[2], const uint64_t Y[2],
 			    uint64_t product[2]);
 
@@ -112,8 +165,31 @@ void internal_aes_gcm_ghash_mult_tbl(struct internal_ghash_key *ghash_key,
 				     unsigned char output[16]);
 #endif
 
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+/*
+ * Implemented in core/arch/arm/crypto/aes-gcm-ce.c, sets up @ek->ce_data
+ * if the CPU implements the AES and PMULL instructions.
+ */
+void internal_aes_gcm_expand_ce_key(struct internal_aes_gcm_key *ek,
+				    const void *key, size_t key_len);
+
+/* Software fallbacks of the functions below, from aes-gcm-sw.c */
+void internal_aes_gcm_sw_set_key(struct internal_aes_gcm_state *state,
+				 const struct internal_aes_gcm_key *enc_key);
+void internal_aes_gcm_sw_ghash_update(struct internal_aes_gcm_state *state,
+				      const void *head, const void *data,
+				      size_t num_blocks);
+void
+internal_aes_gcm_sw_update_payload_blocks(struct internal_aes_gcm_state *state,
+					  const struct internal_aes_gcm_key *ek,
+					  TEE_OperationMode mode,
+					  const void *src, size_t num_blocks,
+					  void *dst);
+#endif
+
 /*
- * Must be implemented in core/arch/arm/crypto/ if CFG_CRYPTO_WITH_CE=y
+ * Must be implemented in core/arch/arm/crypto/ if CFG_CRYPTO_WITH_CE=y or
+ * CFG_CRYPTO_AES_GCM_CE_RUNTIME=y
  */
 void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
 			      const struct internal_aes_gcm_key *enc_key);
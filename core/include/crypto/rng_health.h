@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __CRYPTO_RNG_HEALTH_H
+#define __CRYPTO_RNG_HEALTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Continuous health tests of NIST SP 800-90B section 4.4, the
+ * Repetition Count Test (RCT) and the Adaptive Proportion Test (APT).
+ *
+ * Drivers feed each raw sample read from their entropy source as it is
+ * produced, the state is updated in constant time per sample so there is
+ * no need for a separate pass over the output buffer. Both cutoffs are
+ * derived from the min-entropy claimed per sample for a false positive
+ * probability of 2^-20, as recommended by SP 800-90B.
+ *
+ * A failure is sticky: once a test has failed every further sample is
+ * rejected until rng_health_init() is called again.
+ */
+
+/* Window size of the APT for non-binary samples */
+#define RNG_HEALTH_APT_WINDOW	512
+
+struct rng_health {
+	uint32_t rct_cutoff;
+	uint32_t apt_cutoff;
+	uint32_t rct_sample;
+	uint32_t rct_count;
+	uint32_t apt_sample;
+	uint32_t apt_count;
+	uint32_t apt_index;
+	bool failed;
+};
+
+/*
+ * rng_health_init() - Initialize the continuous health test state
+ * @h:		Health test state
+ * @entropy:	Min-entropy in bits claimed per sample, 1 to 32
+ */
+void rng_health_init(struct rng_health *h, unsigned int entropy);
+
+/*
+ * rng_health_feed() - Run the continuous tests on one sample
+ * @h:		Health test state
+ * @sample:	Raw sample from the noise source
+ *
+ * Returns TEE_ERROR_SECURITY if a test fails or has failed before,
+ * TEE_SUCCESS otherwise.
+ */
+TEE_Result rng_health_feed(struct rng_health *h, uint32_t sample);
+
+/*
+ * rng_health_feed_words() - Run the continuous tests on consecutive samples
+ * @h:		Health test state
+ * @words:	Raw samples
+ * @nwords:	Number of samples in @words
+ */
+TEE_Result rng_health_feed_words(struct rng_health *h, const uint32_t *words,
+				 size_t nwords);
+
+static inline bool rng_health_failed(struct rng_health *h)
+{
+	return h->failed;
+}
+
+#endif /* __CRYPTO_RNG_HEALTH_H */
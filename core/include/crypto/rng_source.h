@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __CRYPTO_RNG_SOURCE_H
+#define __CRYPTO_RNG_SOURCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * struct rng_source - hardware entropy source behind hw_get_random_bytes()
+ * @name:		Name of the source, for traces
+ * @read:		Fills @buf with @len random bytes
+ * @quality:		Claimed min-entropy of the output in bits per byte,
+ *			sources of a higher quality are preferred regardless
+ *			of their throughput
+ * @bytes_per_sec:	Nominal throughput, an order of magnitude is enough,
+ *			the fastest source of the best quality is used
+ * @fail_count:	Number of consecutive failed reads, reset by a
+ *			successful one
+ * @retry_at:		Request from which a failed source is tried again,
+ *			the wait doubles with each failure
+ * @failed_at:		Request in which the source last failed
+ * @link:		Link in the list of registered sources
+ */
+struct rng_source {
+	const char *name;
+	TEE_Result (*read)(void *buf, size_t len);
+	unsigned int quality;
+	unsigned int bytes_per_sec;
+	unsigned int fail_count;
+	uint32_t retry_at;
+	uint32_t failed_at;
+	SLIST_ENTRY(rng_source) link;
+};
+
+/*
+ * Register an entropy source, only from initcalls. With
+ * CFG_CORE_RNG_SOURCES=y drivers register here instead of providing
+ * hw_get_random_bytes() which then reads from the preferred source still
+ * working, failing over to the next one when a read fails. A failed read
+ * is retried once, a source failing again is left out for an increasing
+ * number of requests unless no other source works.
+ */
+void rng_source_register(struct rng_source *src);
+
+#endif /* __CRYPTO_RNG_SOURCE_H */
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __CRYPTO_RNG_STATS_H
+#define __CRYPTO_RNG_STATS_H
+
+#include <kernel/delay.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * struct rng_stats - runtime statistics of the random number generator
+ * @calls:		Number of crypto_rng_read() calls
+ * @bytes:		Number of bytes returned by crypto_rng_read()
+ * @failures:		Number of failed crypto_rng_read() calls
+ * @total_latency_us:	Accumulated time spent in crypto_rng_read()
+ * @max_latency_us:	Longest crypto_rng_read() call
+ * @reseeds:		Number of reseeds of the DRBG or hardware generator
+ * @health_failures:	Number of failed entropy source health tests
+ * @busy_wait_us:	Time spent by drivers polling the hardware
+ * @seed_bytes:		Bytes generated since the last reseed, if reported
+ *			by the driver
+ * @seed_requests:	Generate requests since the last reseed, if reported
+ *			by the driver
+ */
+struct rng_stats {
+	uint64_t calls;
+	uint64_t bytes;
+	uint64_t failures;
+	uint64_t total_latency_us;
+	uint64_t max_latency_us;
+	uint64_t reseeds;
+	uint64_t health_failures;
+	uint64_t busy_wait_us;
+	uint64_t seed_bytes;
+	uint64_t seed_requests;
+};
+
+#ifdef CFG_CORE_RNG_STATS
+static inline uint64_t rng_stats_now(void)
+{
+	return delay_cnt_read();
+}
+
+/* Record a crypto_rng_read() call of @len bytes started at @start */
+void rng_stats_read(uint64_t start, size_t len, TEE_Result res);
+void rng_stats_reseed(void);
+void rng_stats_health_failure(void);
+/* Record a hardware polling loop started at @start */
+void rng_stats_busy_wait(uint64_t start);
+void rng_stats_seed_state(uint64_t bytes, uint64_t requests);
+void rng_stats_get(struct rng_stats *stats);
+#else
+static inline uint64_t rng_stats_now(void)
+{
+	return 0;
+}
+
+static inline void rng_stats_read(uint64_t start __unused,
+				  size_t len __unused,
+				  TEE_Result res __unused)
+{
+}
+
+static inline void rng_stats_reseed(void)
+{
+}
+
+static inline void rng_stats_health_failure(void)
+{
+}
+
+static inline void rng_stats_busy_wait(uint64_t start __unused)
+{
+}
+
+static inline void rng_stats_seed_state(uint64_t bytes __unused,
+					uint64_t requests __unused)
+{
+}
+
+static inline void rng_stats_get(struct rng_stats *stats __unused)
+{
+}
+#endif
+
+#endif /* __CRYPTO_RNG_STATS_H */
@@ -27,6 +27,8 @@
  * @ops: Clock operations
  * @parent: Current parent
  * @rate: Current clock rate (cached after init or rate change)
+ * @parent_rate: Parent rate @rate was computed from
+ * @rate_valid: True when @rate holds as long as the parent rate is unchanged
  * @flags: Specific clock flags
  * @enabled_count: Enable/disable reference counter
  * @num_parents: Number of parents
@@ -39,6 +41,8 @@ struct clk {
 	const struct clk_ops *ops;
 	struct clk *parent;
 	unsigned long rate;
+	unsigned long parent_rate;
+	bool rate_valid;
 	unsigned int flags;
 	struct refcount enabled_count;
 #ifdef CFG_DRIVERS_CLK_PRINT_TREE
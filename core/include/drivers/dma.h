@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __DRIVERS_DMA_H
+#define __DRIVERS_DMA_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * struct dma_xfer - One physically contiguous memory to memory transfer
+ * @dst: Physical address of the destination
+ * @src: Physical address of the source
+ * @len: Byte size of the transfer
+ * @dst_nsec: Destination is non-secure memory
+ * @src_nsec: Source is non-secure memory
+ */
+struct dma_xfer {
+	paddr_t dst;
+	paddr_t src;
+	size_t len;
+	bool dst_nsec;
+	bool src_nsec;
+};
+
+struct dma_chan;
+
+/*
+ * struct dma_ops - DMA channel driver operations
+ * @copy: Process @count transfers and return once they have all completed
+ * or on the first error. Cache maintenance is done by the caller.
+ */
+struct dma_ops {
+	TEE_Result (*copy)(struct dma_chan *chan, const struct dma_xfer *xfer,
+			   size_t count);
+};
+
+/*
+ * struct dma_chan - DMA channel able to do memory to memory transfers
+ * @ops: Channel driver operation handlers
+ * @min_len: Copies smaller than this are done by the CPU
+ * @priv: Channel driver private data
+ */
+struct dma_chan {
+	const struct dma_ops *ops;
+	size_t min_len;
+	void *priv;
+};
+
+#ifdef CFG_DRIVERS_DMA
+/*
+ * dma_register_memcpy_chan() - Register the channel used by dma_memcpy()
+ * @chan: Channel to register, only the first registered channel is used
+ */
+void dma_register_memcpy_chan(struct dma_chan *chan);
+
+/*
+ * dma_memcpy() - Copy @len bytes from @src to @dst
+ *
+ * The copy is done with the registered DMA channel when there is one and
+ * the copy is large enough, with the CPU otherwise. Both buffers must be
+ * mapped in the core address space, they don't have to be physically
+ * contiguous. The function returns once the copy has completed and must
+ * be called from a thread context.
+ *
+ * Return TEE_SUCCESS on success or a TEE_Result compliant code on error,
+ * in which case the content of @dst is undefined.
+ */
+TEE_Result dma_memcpy(void *dst, const void *src, size_t len);
+#else
+static inline void dma_register_memcpy_chan(struct dma_chan *chan __unused)
+{
+}
+
+static inline TEE_Result dma_memcpy(void *dst, const void *src, size_t len)
+{
+	memcpy(dst, src, len);
+	return TEE_SUCCESS;
+}
+#endif /*CFG_DRIVERS_DMA*/
+
+#endif /* __DRIVERS_DMA_H */
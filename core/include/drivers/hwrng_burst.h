@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __DRIVERS_HWRNG_BURST_H
+#define __DRIVERS_HWRNG_BURST_H
+
+#include <io.h>
+#include <string.h>
+#include <types_ext.h>
+#include <util.h>
+#include <utee_defines.h>
+
+/*
+ * Helpers for hardware RNG drivers that read their output one 32-bit
+ * word at a time from a data or FIFO register. A burst is first drained
+ * into a word aligned local block, optionally converted in place and then
+ * copied to the caller buffer with a single memcpy(), so the destination
+ * may have any alignment.
+ */
+
+/*
+ * hwrng_burst_drain() - Read @nwords consecutive words from @reg
+ * @reg:	Virtual address of the output register
+ * @words:	Local block receiving the raw register values
+ * @nwords:	Number of words to read
+ */
+static inline void hwrng_burst_drain(vaddr_t reg, uint32_t *words,
+				     size_t nwords)
+{
+	size_t n = 0;
+
+	for (n = 0; n < nwords; n++)
+		words[n] = io_read32(reg);
+}
+
+/*
+ * hwrng_burst_to_be() - Convert a drained block to big endian in place
+ * @words:	Block of words
+ * @nwords:	Number of words in @words
+ *
+ * The loop has no dependency between iterations and compiles to one
+ * rev instruction per word on little endian Arm cores.
+ */
+static inline void hwrng_burst_to_be(uint32_t *words, size_t nwords)
+{
+	size_t n = 0;
+
+	for (n = 0; n < nwords; n++)
+		words[n] = TEE_U32_TO_BIG_ENDIAN(words[n]);
+}
+
+/*
+ * hwrng_burst_copy() - Copy the head of a drained block to @dst
+ * @dst:	Destination buffer, any alignment
+ * @len:	Number of bytes still wanted in @dst
+ * @words:	Block of words
+ * @nwords:	Number of words in @words
+ *
+ * Returns the number of bytes copied, that is at most @nwords * 4.
+ */
+static inline size_t hwrng_burst_copy(void *dst, size_t len,
+				      const uint32_t *words, size_t nwords)
+{
+	size_t n = MIN(len, nwords * sizeof(*words));
+
+	memcpy(dst, words, n);
+
+	return n;
+}
+
+#endif /* __DRIVERS_HWRNG_BURST_H */
@@ -9,6 +9,7 @@
 #include <kernel/dt_driver.h>
 #include <libfdt.h>
 #include <tee_api_types.h>
+#include <util.h>
 
 /**
  * DEFINE_I2C_DEV_DRIVER - Declare an I2C driver
@@ -55,6 +56,22 @@ enum i2c_smbus_protocol {
 	I2C_SMBUS_PROTO_BLOCK_RAW,
 };
 
+/* Message flags */
+#define I2C_MSG_RD	BIT(0)
+
+/**
+ * struct i2c_msg - One message of a combined I2C transfer
+ *
+ * @flags: I2C_MSG_RD for a read, the message is a write otherwise
+ * @buf: Buffer of data to be read or written
+ * @len: Length of data to be read or written
+ */
+struct i2c_msg {
+	uint32_t flags;
+	uint8_t *buf;
+	size_t len;
+};
+
 struct i2c_ctrl;
 
 /**
@@ -74,6 +91,8 @@ struct i2c_dev {
  * @read: I2C read operation
  * @write: I2C write operation
  * @smbus: SMBus protocol operation
+ * @transfer: Combined transfer operation, messages are separated by a
+ *	repeated start condition and the bus is released after the last one
  */
 struct i2c_ctrl_ops {
 	TEE_Result (*read)(struct i2c_dev *i2c_dev, uint8_t *buf, size_t len);
@@ -82,6 +101,8 @@ struct i2c_ctrl_ops {
 	TEE_Result (*smbus)(struct i2c_dev *i2c_dev, enum i2c_smbus_dir dir,
 			    enum i2c_smbus_protocol proto, uint8_t cmd_code,
 			    uint8_t *buf, size_t len);
+	TEE_Result (*transfer)(struct i2c_dev *i2c_dev, struct i2c_msg *msgs,
+			       size_t count);
 };
 
 /**
@@ -142,6 +163,44 @@ static inline TEE_Result i2c_read(struct i2c_dev *i2c_dev, uint8_t *buf,
 	return i2c_dev->ctrl->ops->read(i2c_dev, buf, len);
 }
 
+/**
+ * i2c_transfer() - Execute a combined transfer of several messages
+ *
+ * @i2c_dev: I2C device used for the transfer
+ * @msgs: Messages to be read or written, in order
+ * @count: Number of messages
+ *
+ * Controllers not supporting combined transfers get one transfer per
+ * message, releasing the bus in between.
+ *
+ * Return a TEE_Result compliant value
+ */
+TEE_Result i2c_transfer(struct i2c_dev *i2c_dev, struct i2c_msg *msgs,
+			size_t count);
+
+/**
+ * i2c_write_read() - Execute a write followed by a read in one transfer
+ *
+ * @i2c_dev: I2C device used for the transfer
+ * @wbuf: Buffer of data to be written
+ * @wlen: Length of data to be written
+ * @rbuf: Buffer containing the read data
+ * @rlen: Length of data to be read
+ *
+ * Return a TEE_Result compliant value
+ */
+static inline TEE_Result i2c_write_read(struct i2c_dev *i2c_dev,
+					const uint8_t *wbuf, size_t wlen,
+					uint8_t *rbuf, size_t rlen)
+{
+	struct i2c_msg msgs[] = {
+		{ .buf = (uint8_t *)wbuf, .len = wlen },
+		{ .flags = I2C_MSG_RD, .buf = rbuf, .len = rlen },
+	};
+
+	return i2c_transfer(i2c_dev, msgs, ARRAY_SIZE(msgs));
+}
+
 /**
  * i2c_smbus_raw() - Execute a raw SMBUS request
  *
@@ -209,6 +268,22 @@ static inline TEE_Result i2c_read(struct i2c_dev *i2c_dev __unused,
 	return TEE_ERROR_NOT_SUPPORTED;
 }
 
+static inline TEE_Result i2c_transfer(struct i2c_dev *i2c_dev __unused,
+				      struct i2c_msg *msgs __unused,
+				      size_t count __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result i2c_write_read(struct i2c_dev *i2c_dev __unused,
+					const uint8_t *wbuf __unused,
+					size_t wlen __unused,
+					uint8_t *rbuf __unused,
+					size_t rlen __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
 static inline TEE_Result i2c_smbus_raw(struct i2c_dev *i2c_dev __unused,
 				       enum i2c_smbus_dir dir __unused,
 				       enum i2c_smbus_protocol proto __unused,
@@ -6,12 +6,20 @@
 #ifndef __DRIVERS_IMX_I2C_H
 #define __DRIVERS_IMX_I2C_H
 
+#include <drivers/i2c.h>
 #include <stdint.h>
 #include <tee_api_types.h>
 
 TEE_Result imx_i2c_write(uint8_t bid, uint8_t chip, const uint8_t *p, int l);
 TEE_Result imx_i2c_read(uint8_t bid, uint8_t chip, uint8_t *p, int l);
 TEE_Result imx_i2c_probe(uint8_t bid, uint8_t chip);
+
+/*
+ * Execute @count messages as one transfer, separated by repeated start
+ * conditions. Only the last message can be a read.
+ */
+TEE_Result imx_i2c_transfer(uint8_t bid, uint8_t chip, struct i2c_msg *msgs,
+			    size_t count);
 TEE_Result imx_i2c_init(uint8_t bid, int bps);
 
 #endif /*__DRIVERS_IMX_I2C_H*/
@@ -106,7 +106,8 @@ static inline void scmi_smt_interrupt_entry(unsigned int channel_id __unused)
 /*
  * Process SMT formatted message in a TEE thread execution context.
  * When returning, output message is available in shared memory for
- * agent to read the response.
+ * agent to read the response. With CFG_SCMI_MSG_SMT_BATCH, messages the
+ * agent posts meanwhile are processed too until the channel is empty.
  * This function depends on CFG_SCMI_MSG_SMT_THREAD_ENTRY.
  *
  * @channel_id: SCMI channel ID the SMT belongs to
@@ -8,6 +8,11 @@
 #ifndef __DRIVERS_VERSAL_TRNG_H
 #define __DRIVERS_VERSAL_TRNG_H
 
+#include <crypto/ctr_drbg.h>
+#include <crypto/rng_health.h>
+#include <kernel/callout.h>
+#include <kernel/mutex.h>
+#include <kernel/workqueue.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <tee_api_types.h>
@@ -86,17 +91,77 @@ struct trng_dfin {
 	uint8_t pad_data[DF_PAD_DATA_LEN];  /* pad to multiples of 16 bytes*/
 };
 
+#if defined(CFG_VERSAL_TRNG_RING)
+/* pre-generated output, topped up from a callout or a queued work */
+struct trng_ring {
+	uint8_t data[CFG_VERSAL_TRNG_RING_SIZE];
+	size_t head;                  /* index of the oldest byte       */
+	size_t count;                 /* number of bytes available      */
+	bool enabled;
+	bool refilling;               /* below watermark, fill up again */
+	bool stopped;                 /* error, the callout is removed  */
+	unsigned int lock;
+	struct callout callout;
+	struct work work;
+};
+#endif
+
+#if defined(CFG_VERSAL_TRNG_ADAPTIVE_DF)
+/* online min-entropy estimate of the raw entropy source output */
+struct trng_entropy_est {
+	uint32_t hist[256];           /* byte values in the window      */
+	uint32_t count;               /* bytes in the window            */
+	uint32_t dfmul_min;           /* lowest DF multiplier, 0: off   */
+};
+#endif
+
 struct versal_trng {
 	struct trng_cfg cfg;
 	struct trng_usr_cfg usr_cfg;
 	struct trng_stats stats;
 	enum trng_status status;
-	uint32_t buf[RAND_BUF_LEN];   /* buffer of random bits      */
+	struct rng_health health;     /* continuous output tests    */
 	size_t len;
 	struct trng_dfin dfin;
 	uint8_t dfout[TRNG_SEED_LEN]; /* output of the DF operation */
+	struct mutex mu;              /* serializes sync requests   */
+	unsigned int lock;            /* protects @hw_busy          */
+	bool hw_busy;                 /* hardware owned by a caller */
+	bool init_pending;            /* instantiated on first use  */
+	struct trng_usr_cfg init_cfg; /* configuration to apply     */
+#if defined(CFG_VERSAL_TRNG_RING)
+	struct trng_ring ring;
+#endif
+#if defined(CFG_VERSAL_TRNG_ADAPTIVE_DF)
+	struct trng_entropy_est est;
+#endif
+#if defined(CFG_VERSAL_TRNG_PTRNG_DRBG)
+	struct ctr_drbg drbg;         /* stretches the PTRNG output */
+	size_t drbg_bytes;            /* output since the last seed */
+	bool drbg_ready;
+#endif
 };
 
+/*
+ * versal_trng_stream() - Drain generated bursts from a TRNG core
+ * @addr:	Virtual base address of the TRNG registers
+ * @dst:	Destination buffer, any alignment, or NULL to discard output
+ * @len:	Number of bytes to produce, whole 16 bytes bursts are drained
+ *		and the bytes of the last one beyond @len are dropped
+ * @check_dtf:	Fail if the DTF status flag is raised during generation
+ * @health:	If not NULL, continuous health tests fed with every word
+ *		read from the core
+ *
+ * This is the common generate path of the TRNG drivers, the core must
+ * already be started in generate or entropy mode. The output is stored in
+ * big endian word order.
+ *
+ * Returns TEE_ERROR_TIMEOUT if no burst is produced in time,
+ * TEE_ERROR_SECURITY on DTF error, TEE_ERROR_BAD_STATE when a health
+ * test fails, TEE_SUCCESS otherwise.
+ */
+TEE_Result versal_trng_stream(vaddr_t addr, void *dst, size_t len,
+			      bool check_dtf, struct rng_health *health);
 TEE_Result versal_trng_hw_init(struct versal_trng *trng,
 			       struct trng_usr_cfg *usr_cfg);
 TEE_Result versal_trng_get_random_bytes(struct versal_trng *trng,
@@ -6,19 +6,25 @@
 #ifndef __INITCALL_H
 #define __INITCALL_H
 
+#include <compiler.h>
 #include <scattered_array.h>
+#include <stddef.h>
 #include <tee_api_types.h>
 #include <trace.h>
 
+#if TRACE_LEVEL >= TRACE_DEBUG || defined(CFG_CORE_INITCALL_STATS)
+#define __INITCALL_WITH_NAME
+#endif
+
 struct initcall {
 	TEE_Result (*func)(void);
-#if TRACE_LEVEL >= TRACE_DEBUG
+#ifdef __INITCALL_WITH_NAME
 	int level;
 	const char *func_name;
 #endif
 };
 
-#if TRACE_LEVEL >= TRACE_DEBUG
+#ifdef __INITCALL_WITH_NAME
 #define __define_initcall(type, lvl, fn) \
 	SCATTERED_ARRAY_DEFINE_PG_ITEM_ORDERED(type ## call, lvl, \
 					       struct initcall) = \
@@ -52,6 +58,11 @@ struct initcall {
 #define finalcall_begin	SCATTERED_ARRAY_BEGIN(finalcall, struct initcall)
 #define finalcall_end	SCATTERED_ARRAY_END(finalcall, struct initcall)
 
+#define deferredcall_begin \
+			SCATTERED_ARRAY_BEGIN(deferredcall, struct initcall)
+#define deferredcall_end \
+			SCATTERED_ARRAY_END(deferredcall, struct initcall)
+
 /*
  * The preinit_*(), *_init() and boot_final() macros are used to register
  * callback functions to be called at different stages during
@@ -112,6 +123,20 @@ struct initcall {
 #define driver_init_late(fn)		__define_initcall(driver_init, 2, fn)
 #define release_init_resource(fn)	__define_initcall(driver_init, 3, fn)
 
+/*
+ * driver_init_deferred() registers a driver initialization which doesn't
+ * have to be completed at boot. With CFG_CORE_DEFERRED_INITCALLS it's
+ * called on the first yielding call instead, in a thread which may use
+ * RPCs. Other services must not depend on it during boot, the driver
+ * itself must handle being used before it's initialized. Without
+ * CFG_CORE_DEFERRED_INITCALLS it's the same as driver_init_late().
+ */
+#ifdef CFG_CORE_DEFERRED_INITCALLS
+#define driver_init_deferred(fn)	__define_initcall(deferred, 1, fn)
+#else
+#define driver_init_deferred(fn)	driver_init_late(fn)
+#endif
+
 #define boot_final(fn)			__define_initcall(final, 1, fn)
 
 /*
@@ -146,4 +171,32 @@ void call_driver_initcalls(void);
 void call_initcalls(void);
 void call_finalcalls(void);
 
+#ifdef CFG_CORE_DEFERRED_INITCALLS
+/* Calls the driver_init_deferred() functions the first time it's called */
+void call_deferred_initcalls(void);
+#else
+static inline void call_deferred_initcalls(void)
+{
+}
+#endif
+
+/*
+ * initcall_stats_get() - Get the durations of the init-calls done so far
+ * @buf:	Array of struct pta_stats_initcall
+ * @buf_size:	In: size of @buf, out: size used or needed
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_INITCALL_STATS is
+ * enabled and TEE_ERROR_SHORT_BUFFER with the needed size in @buf_size if
+ * @buf is too small.
+ */
+#ifdef CFG_CORE_INITCALL_STATS
+TEE_Result initcall_stats_get(void *buf, size_t *buf_size);
+#else
+static inline TEE_Result initcall_stats_get(void *buf __unused,
+					    size_t *buf_size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 #endif
@@ -112,6 +112,11 @@ int mark_static_shm_as_reserved(struct dt_descriptor *dt);
  * and address cells registered with boot_mem_add_reloc() during virtual
  * memory initialization. Unused memory is unmapped and released to pool of
  * free physical memory once MMU is initialized.
+ *
+ * boot_mem_free_tmp() releases a single allocation from
+ * boot_mem_alloc_tmp(). The memory becomes available again once all
+ * temporary allocations made after it have been released too, any
+ * remaining temporary memory is released by boot_mem_release_tmp_alloc().
  */
 void boot_mem_init(vaddr_t start, vaddr_t end, vaddr_t orig_end);
 void boot_mem_foreach_padding(bool (*func)(vaddr_t va, size_t len, void *ptr),
@@ -120,6 +125,7 @@ void boot_mem_add_reloc(void *ptr);
 void boot_mem_relocate(size_t offs);
 void *boot_mem_alloc(size_t len, size_t align);
 void *boot_mem_alloc_tmp(size_t len, size_t align);
+void boot_mem_free_tmp(void *ptr, size_t len);
 vaddr_t boot_mem_release_unused(void);
 void boot_mem_release_tmp_alloc(void);
 #else
@@ -133,6 +139,8 @@ static inline void *boot_mem_alloc(size_t len __unused, size_t align __unused)
 static inline void *boot_mem_alloc_tmp(size_t len __unused,
 				       size_t align __unused)
 { return NULL; }
+static inline void boot_mem_free_tmp(void *ptr __unused, size_t len __unused)
+{ }
 static inline vaddr_t boot_mem_release_unused(void) { return 0; }
 static inline void boot_mem_release_tmp_alloc(void) { }
 #endif
@@ -15,6 +15,7 @@
  * @callback:	  function to be called when a callout expires
  * @expiry_value: callout expiry time counter value
  * @period:	  ticks to next timeout
+ * @slot:	  position in the callout service, 0 when inactive
  * @link:	  linked list element
  *
  * @callback is called from an interrupt handler so thread resources must
@@ -30,7 +31,8 @@ struct callout {
 	bool (*callback)(struct callout *co);
 	uint64_t expiry_value;
 	uint64_t period;
-	TAILQ_ENTRY(callout) link;
+	unsigned int slot;
+	LIST_ENTRY(callout) link;
 };
 
 /*
@@ -48,7 +50,8 @@ struct callout {
  *
  * The callout structure can reside in global data or on the heap. It's
  * safe to embed it inside another struct, but it must not be freed until
- * removed with callout_rem() or equivalent.
+ * removed with callout_rem() or equivalent. It must be zero initialized
+ * before it's first used.
  *
  * The function takes the main callout service for synchronization so it
  * can't be called from within a callback function in a callout or there's
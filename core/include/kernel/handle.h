@@ -7,14 +7,29 @@
 #define __KERNEL_HANDLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/*
+ * A handle is the index of a slot in the database combined with the
+ * generation of the slot. The generation is incremented each time the
+ * slot is released, so a stale handle doesn't find a later user of the
+ * same slot. Free slots are linked into a list through @next_free.
+ */
+struct handle_db_slot {
+	void *ptr;
+	uint32_t gen;
+	uint32_t next_free;	/* Index + 1 of next free slot, 0 for none */
+};
+
 struct handle_db {
-	void **ptrs;
+	struct handle_db_slot *slots;
 	size_t max_ptrs;
+	size_t num_ptrs;
+	uint32_t first_free;	/* Index + 1 of first free slot, 0 for none */
 };
 
-#define HANDLE_DB_INITIALIZER { NULL, 0 }
+#define HANDLE_DB_INITIALIZER { NULL, 0, 0, 0 }
 
 /*
  * Frees all internal data structures of the database, but does not free
@@ -38,7 +53,8 @@ int handle_get(struct handle_db *db, void *ptr);
 
 /*
  * Deallocates a handle. Returns the assiciated pointer of the handle
- * if the handle was valid or NULL if it's invalid.
+ * if the handle was valid or NULL if it's invalid or already
+ * deallocated.
  */
 void *handle_put(struct handle_db *db, int handle);
 
@@ -21,20 +21,26 @@
 /* Forward the interrupt to all CPUs except the current CPU */
 #define ITR_CPU_MASK_TO_OTHER_CPUS	BIT(30)
 
+/* Number of lists of handlers of an interrupt controller, a power of 2 */
+#define ITR_HANDLER_BUCKETS	32
+
 struct itr_handler;
 
+SLIST_HEAD(itr_handler_head, itr_handler);
+
 /*
  * struct itr_chip - Interrupt controller
  *
  * @ops Operation callback functions
  * @name Controller name, for debug purpose
- * @handlers Registered handlers list head
+ * @handlers Registered handlers, listed by interrupt number modulo
+ * ITR_HANDLER_BUCKETS
  * @dt_get_irq Device tree node parsing function
  */
 struct itr_chip {
 	const struct itr_ops *ops;
 	const char *name;
-	SLIST_HEAD(, itr_handler) handlers;
+	struct itr_handler_head handlers[ITR_HANDLER_BUCKETS];
 	/*
 	 * dt_get_irq - parse a device tree interrupt property
 	 *
@@ -105,7 +111,7 @@ typedef enum itr_return (*itr_handler_t)(struct itr_handler *h);
  * @flags Property bit flags (ITRF_*) or 0
  * @data Private data for that interrupt handler
  * @chip Interrupt controller chip device
- * @link Reference in controller handler list
+ * @link Reference in controller handler list for the interrupt number
  */
 struct itr_handler {
 	size_t it;
@@ -312,6 +318,17 @@ static inline void interrupt_set_affinity(struct itr_chip *chip, size_t itr_num,
 	chip->ops->set_affinity(chip, itr_num, cpu_mask);
 }
 
+/*
+ * interrupt_route_to_this_cpu() - Route a controller interrupt to this CPU
+ * @chip	Interrupt controller
+ * @itr_num	Interrupt number to route
+ *
+ * Meant for drivers that submit a job to a device from any core and want
+ * the completion interrupt to be taken on the submitting core. This is a
+ * no-op when the controller can't set the affinity of the interrupt.
+ */
+void interrupt_route_to_this_cpu(struct itr_chip *chip, size_t itr_num);
+
 /*
  * interrupt_configure() - Configure an interrupt in an interrupt controller
  * @chip	Interrupt controller
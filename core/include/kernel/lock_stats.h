@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_LOCK_STATS_H
+#define __KERNEL_LOCK_STATS_H
+
+#include <compiler.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+enum lock_stats_type {
+	LOCK_STATS_MUTEX = 0,
+	LOCK_STATS_SPINLOCK = 1,
+};
+
+#ifdef CFG_LOCK_CONTENTION_STATS
+/*
+ * lock_stats_wait_begin() - Start timing a wait on a contended lock
+ *
+ * Returns the current generic timer counter value, to be passed to
+ * lock_stats_wait_end() once the lock has been acquired.
+ */
+uint64_t lock_stats_wait_begin(void);
+
+/*
+ * lock_stats_wait_end() - Account a wait on a contended lock
+ * @lock:	Address of the lock, used to identify it
+ * @type:	Type of the lock
+ * @begin:	Counter value returned by lock_stats_wait_begin()
+ *
+ * May be called with or without exceptions masked, but not while holding
+ * the spinlock protecting the statistics themselves.
+ */
+void lock_stats_wait_end(const void *lock, enum lock_stats_type type,
+			 uint64_t begin);
+
+/*
+ * lock_stats_get() - Copy the lock contention statistics
+ * @buf:	Array of struct pta_stats_lock or NULL to query the size
+ * @buf_size:	In: size of @buf, out: size used or needed
+ *
+ * Returns TEE_ERROR_SHORT_BUFFER with the needed size in @buf_size if
+ * @buf is too small and TEE_ERROR_ITEM_NOT_FOUND if no lock has been
+ * contended yet.
+ */
+TEE_Result lock_stats_get(void *buf, size_t *buf_size);
+#else
+static inline uint64_t lock_stats_wait_begin(void)
+{
+	return 0;
+}
+
+static inline void lock_stats_wait_end(const void *lock __unused,
+				       enum lock_stats_type type __unused,
+				       uint64_t begin __unused)
+{
+}
+
+static inline TEE_Result lock_stats_get(void *buf __unused,
+					size_t *buf_size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#endif /*__KERNEL_LOCK_STATS_H*/
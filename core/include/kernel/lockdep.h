@@ -12,40 +12,81 @@
 #include <tee_api_types.h>
 #include <trace.h>
 #include <types_ext.h>
+#include <util.h>
 
 /*
  * Lock graph. If node A has an edge to node B, then A was locked before B in
  * the same thread of execution.
+ *
+ * Nodes and edges are also kept in hash tables so that finding the node of
+ * a lock and checking if a lock order has already been seen and validated
+ * doesn't depend on the size of the graph.
  */
 
+#define LOCKDEP_HASH_BITS	6
+#define LOCKDEP_HASH_SIZE	BIT(LOCKDEP_HASH_BITS)
+
+/* Maximum number of locks held at the same time by a thread of execution */
+#define LOCKDEP_MAX_HELD	16
+
 struct lockdep_edge {
+	struct lockdep_node *from;
 	struct lockdep_node *to;
 	uintptr_t thread_id;
 	vaddr_t *call_stack_from;
 	vaddr_t *call_stack_to;
-	STAILQ_ENTRY(lockdep_edge) link;
+	LIST_ENTRY(lockdep_edge) link;		/* In from->edges */
+	LIST_ENTRY(lockdep_edge) in_link;	/* In to->in_edges */
+	LIST_ENTRY(lockdep_edge) hash_link;
 };
 
-STAILQ_HEAD(lockdep_edge_head, lockdep_edge);
+LIST_HEAD(lockdep_edge_head, lockdep_edge);
 
 struct lockdep_node {
 	uintptr_t lock_id; /* For instance, address of actual lock object */
 	struct lockdep_edge_head edges;
+	struct lockdep_edge_head in_edges;
 	TAILQ_ENTRY(lockdep_node) link;
+	LIST_ENTRY(lockdep_node) hash_link;
+	unsigned int visit_gen; /* Used when searching for a path */
 	uint8_t flags; /* Used temporarily when walking the graph */
 };
 
-TAILQ_HEAD(lockdep_node_head, lockdep_node);
+TAILQ_HEAD(lockdep_node_list, lockdep_node);
+LIST_HEAD(lockdep_node_bucket, lockdep_node);
 
-/* Per-thread queue of currently owned locks (point to nodes in the graph) */
+struct lockdep_node_head {
+	struct lockdep_node_list nodes;
+	struct lockdep_node_bucket node_hash[LOCKDEP_HASH_SIZE];
+	struct lockdep_edge_head edge_hash[LOCKDEP_HASH_SIZE];
+	unsigned int visit_gen;
+};
+
+#define LOCKDEP_GRAPH_INITIALIZER(graph) \
+	{ .nodes = TAILQ_HEAD_INITIALIZER((graph).nodes) }
+
+/* Per-thread stack of currently owned locks (point to nodes in the graph) */
 
 struct lockdep_lock {
 	struct lockdep_node *node;
 	vaddr_t *call_stack;
-	TAILQ_ENTRY(lockdep_lock) link;
 };
 
-TAILQ_HEAD(lockdep_lock_head, lockdep_lock);
+struct lockdep_lock_head {
+	struct lockdep_lock locks[LOCKDEP_MAX_HELD];
+	size_t count;
+};
+
+static inline void lockdep_graph_init(struct lockdep_node_head *graph)
+{
+	*graph = (struct lockdep_node_head){ };
+	TAILQ_INIT(&graph->nodes);
+}
+
+static inline void lockdep_queue_init(struct lockdep_lock_head *owned)
+{
+	owned->count = 0;
+}
 
 #ifdef CFG_LOCKDEP
 
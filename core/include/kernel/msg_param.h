@@ -60,6 +60,31 @@ msg_param_mobj_from_noncontig(paddr_t buf_ptr __unused, size_t size __unused,
 }
 #endif
 
+/**
+ * msg_param_mobj_from_extents() - construct mobj from an
+ * OPTEE_MSG_ATTR_EXTENTS list of runs of pages.
+ *
+ * @buf_ptr - optee_msg_param.u.tmem.buf_ptr value
+ * @size - optee_msg_param.u.tmem.size value
+ * @shm_ref - optee_msg_param.u.tmem.shm_ref value
+ * @map_buffer - true if buffer needs to be mapped into OP-TEE address space
+ *
+ * return:
+ *	mobj or NULL on error
+ */
+#ifdef CFG_CORE_DYN_SHM
+struct mobj *msg_param_mobj_from_extents(paddr_t buf_ptr, size_t size,
+					 uint64_t shm_ref, bool map_buffer);
+#else
+static inline struct mobj *
+msg_param_mobj_from_extents(paddr_t buf_ptr __unused, size_t size __unused,
+			    uint64_t shm_ref __unused,
+			    bool map_buffer __unused)
+{
+	return NULL;
+}
+#endif
+
 /**
  * msg_param_attr_is_tmem - helper functions that cheks if attribute is tmem
  *
@@ -12,4 +12,12 @@
 TEE_Result nv_counter_get_ree_fs(uint32_t *value);
 TEE_Result nv_counter_incr_ree_fs_to(uint32_t value);
 
+/*
+ * Same as above with the counter value kept in secure memory: it's read
+ * from the platform once and increments to a value the counter already
+ * has are skipped.
+ */
+TEE_Result nv_counter_get_ree_fs_cached(uint32_t *value);
+TEE_Result nv_counter_incr_ree_fs_to_cached(uint32_t value);
+
 #endif /*__KERNEL_NV_COUNTER_H*/
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __KERNEL_PC_SAMPLE_H
+#define __KERNEL_PC_SAMPLE_H
+
+#include <compiler.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+#ifdef CFG_CORE_PC_SAMPLING
+/*
+ * core_pc_sample() - Record a sample of the program counter of the core
+ * @pc:		Interrupted program counter
+ *
+ * Called with exceptions masked when a thread executing in the core is
+ * suspended by a foreign interrupt. Samples outside of the core text
+ * are only counted.
+ */
+void core_pc_sample(vaddr_t pc);
+
+/*
+ * core_pc_sample_start() - Start sampling the core
+ * @shift:	Each histogram bucket covers 2^@shift bytes of text
+ *
+ * Any previous histogram is discarded.
+ */
+TEE_Result core_pc_sample_start(unsigned int shift);
+
+/* core_pc_sample_stop() - Stop sampling, the histogram is kept */
+void core_pc_sample_stop(void);
+
+/*
+ * core_pc_sample_read() - Copy the histogram of a stopped sampling
+ * @buf:	Destination of the histogram, an array of uint32_t
+ * @len:	Length of @buf, updated with the length of the histogram
+ * @shift:	Updated with the shift given to core_pc_sample_start()
+ * @count:	Updated with the total number of samples
+ *
+ * Bucket n counts the samples in [__text_start + (n << @shift),
+ * __text_start + ((n + 1) << @shift)).
+ *
+ * Returns TEE_ERROR_SHORT_BUFFER with the required length in @len if
+ * @buf is too small.
+ */
+TEE_Result core_pc_sample_read(void *buf, size_t *len, unsigned int *shift,
+			       uint32_t *count);
+#else
+static inline void core_pc_sample(vaddr_t pc __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_PC_SAMPLE_H*/
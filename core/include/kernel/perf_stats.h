@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_PERF_STATS_H
+#define __KERNEL_PERF_STATS_H
+
+#include <compiler.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/* Instrumented regions, reported as STATS_PERF_POINT_* by stats.pta */
+enum perf_stats_point {
+	PERF_STATS_STD_SMC = 0,
+	PERF_STATS_SYSCALL = 1,
+	PERF_STATS_RNG_READ = 2,
+	PERF_STATS_FS_HTREE_IO = 3,
+	PERF_STATS_POINT_COUNT,
+};
+
+/*
+ * Hardware counters, in the order of the counters in
+ * struct pta_stats_perf
+ */
+enum perf_stats_ctr {
+	PERF_STATS_CYCLES = 0,
+	PERF_STATS_INSTRUCTIONS = 1,
+	PERF_STATS_L1D_REFILL = 2,
+	PERF_STATS_L2D_REFILL = 3,
+	PERF_STATS_TLB_REFILL = 4,
+	PERF_STATS_CTR_COUNT,
+};
+
+/* Counter values at the start of a region, see perf_stats_begin() */
+struct perf_stats_snap {
+	uint64_t ctr[PERF_STATS_CTR_COUNT];
+	size_t core_pos;
+};
+
+#ifdef CFG_CORE_PERF_STATS
+/*
+ * perf_stats_begin() - Start measuring a region
+ * @snap:	Filled with the current counter values
+ */
+void perf_stats_begin(struct perf_stats_snap *snap);
+
+/*
+ * perf_stats_end() - Account a region measured since perf_stats_begin()
+ * @point:	Instrumentation point the region belongs to
+ * @snap:	Snapshot filled by perf_stats_begin()
+ *
+ * The counters are per CPU, a region that ended on another CPU than it
+ * started is only counted as migrated.
+ */
+void perf_stats_end(enum perf_stats_point point,
+		    const struct perf_stats_snap *snap);
+
+/*
+ * perf_stats_get() - Copy the statistics of all instrumentation points
+ * @buf:	Array of struct pta_stats_perf
+ * @buf_size:	In: size of @buf, out: size used or needed
+ *
+ * Returns TEE_ERROR_SHORT_BUFFER with the needed size in @buf_size if
+ * @buf is too small.
+ */
+TEE_Result perf_stats_get(void *buf, size_t *buf_size);
+#else
+static inline void perf_stats_begin(struct perf_stats_snap *snap __unused)
+{
+}
+
+static inline void
+perf_stats_end(enum perf_stats_point point __unused,
+	       const struct perf_stats_snap *snap __unused)
+{
+}
+
+static inline TEE_Result perf_stats_get(void *buf __unused,
+					size_t *buf_size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#endif /*__KERNEL_PERF_STATS_H*/
@@ -13,6 +13,7 @@
 #ifndef __ASSEMBLER__
 #include <assert.h>
 #include <compiler.h>
+#include <kernel/lock_stats.h>
 #include <kernel/thread.h>
 #include <stdbool.h>
 
@@ -35,10 +36,29 @@ void __cpu_spin_unlock(unsigned int *lock);
 /* returns 0 on locking success, non zero on failure */
 unsigned int __cpu_spin_trylock(unsigned int *lock);
 
+#ifdef CFG_LOCK_CONTENTION_STATS
+static inline void __cpu_spin_lock_stats(unsigned int *lock)
+{
+	uint64_t begin = 0;
+
+	if (!__cpu_spin_trylock(lock))
+		return;
+
+	begin = lock_stats_wait_begin();
+	__cpu_spin_lock(lock);
+	lock_stats_wait_end(lock, LOCK_STATS_SPINLOCK, begin);
+}
+#else
+static inline void __cpu_spin_lock_stats(unsigned int *lock)
+{
+	__cpu_spin_lock(lock);
+}
+#endif
+
 static inline void cpu_spin_lock_no_dldetect(unsigned int *lock)
 {
 	assert(thread_foreign_intr_disabled());
-	__cpu_spin_lock(lock);
+	__cpu_spin_lock_stats(lock);
 	spinlock_count_incr();
 }
 
@@ -73,10 +93,16 @@ static inline void cpu_spin_lock_dldetect(const char *func, const int line,
 {
 	unsigned int retries = 0;
 	unsigned int reminder = 0;
+	uint64_t begin = 0;
+	bool waited = false;
 
 	assert(thread_foreign_intr_disabled());
 
 	while (__cpu_spin_trylock(lock)) {
+		if (!waited) {
+			begin = lock_stats_wait_begin();
+			waited = true;
+		}
 		retries++;
 		if (!retries) {
 			/* wrapped, time to report */
@@ -88,6 +114,8 @@ static inline void cpu_spin_lock_dldetect(const char *func, const int line,
 		}
 	}
 
+	if (waited)
+		lock_stats_wait_end(lock, LOCK_STATS_SPINLOCK, begin);
 	spinlock_count_incr();
 }
 #else
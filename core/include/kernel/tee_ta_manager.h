@@ -64,10 +64,24 @@ struct sample_buf {
 };
 #endif
 
+/*
+ * Random number accounting of a TA, updated by the random number syscall
+ * through tee_ta_rng_throttle() and tee_ta_rng_charge(). Protected by a
+ * global spinlock since a concurrent single instance TA may generate from
+ * several threads.
+ */
+struct tee_ta_rng_acct {
+	uint64_t bytes;		/* Bytes generated since the TA was loaded */
+	uint64_t throttled;	/* Chunks served at the throttled rate */
+	uint64_t window_start;	/* Start of current budget window in ms */
+	size_t window_bytes;	/* Bytes generated in the current window */
+};
+
 /* Context of a loaded TA */
 struct tee_ta_ctx {
 	uint32_t flags;		/* TA_FLAGS from TA header */
 	TAILQ_ENTRY(tee_ta_ctx) link;
+	SLIST_ENTRY(tee_ta_ctx) uuid_link; /* Link in the UUID index */
 	struct ts_ctx ts_ctx;
 	uint32_t panicked;	/* True if TA has panicked, written from asm */
 	uint32_t panic_code;	/* Code supplied for panic */
@@ -75,11 +89,17 @@ struct tee_ta_ctx {
 	bool busy;		/* Context is busy and cannot be entered */
 	bool is_initializing;	/* Context initialization is not completed */
 	bool is_releasing;	/* Context is about to be released */
+	bool flush_params;	/* Drop kept parameter mappings when idle */
 	struct condvar busy_cv;	/* CV used when context is busy */
+#if defined(CFG_TA_RNG_QOS)
+	struct tee_ta_rng_acct rng_acct;
+#endif
 };
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	SLIST_ENTRY(tee_ta_session) id_link; /* Link in the session index */
+	struct tee_ta_session_head *head; /* List the session is linked in */
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -101,6 +121,30 @@ extern struct tee_ta_ctx_head tee_ctxes;
 extern struct mutex tee_ta_mutex;
 extern struct condvar tee_ta_init_cv;
 
+/*
+ * tee_ta_link_ctx() - Add a context to tee_ctxes and to the UUID index
+ * @ctx:	Context with its UUID set
+ *
+ * Requires tee_ta_mutex to be held.
+ */
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx);
+
+/*
+ * tee_ta_unlink_ctx() - Remove a context from tee_ctxes and the UUID index
+ * @ctx:	Context added with tee_ta_link_ctx()
+ *
+ * Requires tee_ta_mutex to be held.
+ */
+void tee_ta_unlink_ctx(struct tee_ta_ctx *ctx);
+
+/*
+ * tee_ta_flush_param_mappings() - Remove the parameter mappings user TAs
+ * keep between calls
+ *
+ * Idle contexts are flushed right away, busy ones when they become idle.
+ */
+void tee_ta_flush_param_mappings(void);
+
 TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 			       struct tee_ta_session **sess,
 			       struct tee_ta_session_head *open_sessions,
@@ -109,6 +153,21 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 			       uint32_t cancel_req_to,
 			       struct tee_ta_param *param);
 
+/*
+ * tee_ta_preload() - Load a keep-alive TA ahead of its first session
+ * @uuid:	UUID of the TA
+ *
+ * Creates the context of a user TA flagged with TA_FLAG_SINGLE_INSTANCE
+ * and TA_FLAG_INSTANCE_KEEP_ALIVE without opening a session, so the
+ * first session open doesn't have to load and relocate it. Does nothing
+ * more if the TA is already loaded.
+ *
+ * Returns TEE_SUCCESS on success, TEE_ERROR_NOT_SUPPORTED if the TA
+ * isn't a keep-alive user TA, in which case nothing is kept loaded, or
+ * another TEE_ERROR_* code on failure.
+ */
+TEE_Result tee_ta_preload(const TEE_UUID *uuid);
+
 TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 				 struct tee_ta_session *sess,
 				 const TEE_Identity *clnt_id,
@@ -173,4 +232,32 @@ static inline struct tee_ta_ctx *__noprof to_ta_ctx(struct ts_ctx *ctx)
 TEE_Result tee_ta_instance_stats(void *buff, size_t *buff_size);
 #endif
 
+#if defined(CFG_TA_RESOURCE_STATS)
+/*
+ * tee_ta_resource_stats() - Get the resource accounting of user TAs
+ * @buf:	Array of struct pta_stats_ta_resources
+ * @buf_size:	Size of @buf, updated with the size used or needed
+ * @since:	In: counter value, only TAs entered or returned since or
+ *		still running are reported. Out: counter value to pass to
+ *		the next call
+ */
+TEE_Result tee_ta_resource_stats(void *buf, size_t *buf_size,
+				 uint64_t *since);
+#endif
+
+#if defined(CFG_TA_RNG_QOS)
+/*
+ * tee_ta_rng_throttle() - Check the random number budget of a TA
+ * @ctx:	Context of the TA
+ * @now_ms:	Current system time in milliseconds
+ *
+ * Returns true if the TA has exhausted its CFG_TA_RNG_BUDGET for the
+ * current window and should be served at the throttled rate.
+ */
+bool tee_ta_rng_throttle(struct tee_ta_ctx *ctx, uint64_t now_ms);
+/* Account @len random bytes generated for the TA of @ctx */
+void tee_ta_rng_charge(struct tee_ta_ctx *ctx, size_t len);
+TEE_Result tee_ta_rng_stats(void *buff, size_t *buff_size);
+#endif
+
 #endif
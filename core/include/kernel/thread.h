@@ -43,6 +43,7 @@ struct thread_specific_data {
 	bool stackcheck_recursion;
 #endif
 	unsigned int syscall_recursion;
+	uint64_t yield_stamp;	/* See thread_yield_point() */
 #ifdef CFG_FAULT_MITIGATION
 	struct ftmn_func_arg *ftmn_arg;
 #endif
@@ -104,6 +105,71 @@ short int thread_get_id(void);
  */
 short int thread_get_id_may_fail(void);
 
+/*
+ * Reports the number of calls refused so far because all threads were
+ * busy in @limit_hits, the number of threads which currently have a
+ * stack, static or allocated on demand, in @stacks, the current quota
+ * set with thread_set_quota() in @quota and the highest number of threads
+ * active at the same time so far in @peak.
+ */
+void thread_get_pool_stats(unsigned int *limit_hits, unsigned int *stacks,
+			   unsigned int *quota, unsigned int *peak);
+
+/*
+ * Limits the number of threads active at the same time to @quota, from 1
+ * to CFG_NUM_THREADS. Calls beyond it are refused as if all threads were
+ * busy. With CFG_NS_VIRTUALIZATION each guest has its own threads and
+ * quota.
+ */
+void thread_set_quota(size_t quota);
+
+/*
+ * struct thread_time_stats - time accounting of a thread
+ * @run_ticks:		ticks spent executing on a CPU
+ * @suspended_ticks:	ticks spent suspended in RPC or by foreign interrupts
+ * @wait_ticks:		ticks spent waiting on a mutex or a condition variable,
+ *			also included in @run_ticks and @suspended_ticks
+ * @resumes:		number of times the thread was resumed or started
+ * @stamp:		counter value at the last start, resume or suspend
+ * @wait_stamp:		counter value at the start of the current wait
+ *
+ * Ticks are generic timer counter ticks, the counters are cumulated over
+ * all the calls served by the thread.
+ */
+struct thread_time_stats {
+	uint64_t run_ticks;
+	uint64_t suspended_ticks;
+	uint64_t wait_ticks;
+	uint64_t resumes;
+	uint64_t stamp;
+	uint64_t wait_stamp;
+};
+
+#ifdef CFG_CORE_THREAD_TIME_STATS
+/* Copies the time accounting of thread @thread_idx into @stats */
+void thread_get_time_stats(size_t thread_idx, struct thread_time_stats *stats);
+
+/*
+ * Reports the ticks spent executing threads on CPU @core_pos in
+ * @run_ticks and the number of times a thread was started or resumed on
+ * it in @entries.
+ */
+void thread_get_core_time_stats(size_t core_pos, uint64_t *run_ticks,
+				uint64_t *entries);
+
+/* Accounts the time the current thread spends waiting on a wait queue */
+void thread_time_stats_wait_begin(void);
+void thread_time_stats_wait_end(void);
+#else
+static inline void thread_time_stats_wait_begin(void)
+{
+}
+
+static inline void thread_time_stats_wait_end(void)
+{
+}
+#endif
+
 /* Returns Thread Specific Data (TSD) pointer. */
 struct thread_specific_data *thread_get_tsd(void);
 
@@ -335,6 +401,30 @@ struct thread_param {
 uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		struct thread_param *params);
 
+/*
+ * thread_rpc_yield() - Return to normal world and resume right away
+ *
+ * Normal world handles the return as a foreign interrupt and may schedule
+ * other tasks on this core before resuming the thread.
+ */
+void thread_rpc_yield(void);
+
+/*
+ * thread_yield_point() - Yield to normal world when running for too long
+ *
+ * Called from long running loops. Does thread_rpc_yield() when at least
+ * CFG_CORE_YIELD_INTERVAL_US has elapsed since the first call after the
+ * thread entered secure world. Does nothing when foreign interrupts are
+ * masked, since an RPC isn't possible then.
+ */
+#if CFG_CORE_YIELD_INTERVAL_US
+void thread_yield_point(void);
+#else
+static inline void thread_yield_point(void)
+{
+}
+#endif
+
 /**
  * Allocate data for payload buffers shared with both user space applications
  * and the non-secure kernel. Ensure consistency with the enumeration
@@ -372,6 +462,7 @@ enum thread_shm_type {
  * @THREAD_SHM_CACHE_USER_FS - filesystem access
  * @THREAD_SHM_CACHE_USER_I2C - I2C communication
  * @THREAD_SHM_CACHE_USER_RPMB - RPMB communication
+ * @THREAD_SHM_CACHE_USER_FS_BATCH - batched filesystem writes
  *
  * To ensure that each user of the shared memory cache doesn't interfere
  * with each other a unique ID per user is used.
@@ -381,6 +472,7 @@ enum thread_shm_cache_user {
 	THREAD_SHM_CACHE_USER_FS,
 	THREAD_SHM_CACHE_USER_I2C,
 	THREAD_SHM_CACHE_USER_RPMB,
+	THREAD_SHM_CACHE_USER_FS_BATCH,
 };
 
 /*
@@ -52,6 +52,9 @@ struct thread_ctx {
 	struct mobj *rpc_mobj;
 	struct thread_shm_cache shm_cache;
 	struct thread_specific_data tsd;
+#ifdef CFG_CORE_THREAD_TIME_STATS
+	struct thread_time_stats time_stats;
+#endif
 };
 #endif /*__ASSEMBLER__*/
 
@@ -87,7 +90,50 @@ void thread_check_canaries(void);
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
+/*
+ * Claims a free thread and marks it active, allocating its stack first if
+ * it is one of the threads above CFG_NUM_THREADS_STATIC which hasn't been
+ * used yet. Returns false if no thread could be claimed, which is counted
+ * as a thread limit hit.
+ */
+bool thread_claim_free(size_t *thread_idx);
+
+/*
+ * Account thread @thread_idx being started or resumed on the current CPU
+ * and being suspended or freed, called with exceptions masked.
+ */
+#ifdef CFG_CORE_THREAD_TIME_STATS
+void thread_time_stats_enter(size_t thread_idx);
+void thread_time_stats_exit(size_t thread_idx, bool freed);
+#else
+static inline void thread_time_stats_enter(size_t thread_idx __unused)
+{
+}
+
+static inline void thread_time_stats_exit(size_t thread_idx __unused,
+					  bool freed __unused)
+{
+}
+#endif
+
 /* Frees the cache of allocated FS RPC memory */
 void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
+
+/*
+ * Frees the entries of the cache of allocated RPC memory which can't be
+ * kept once the secure thread has completed its execution, that is all
+ * but the THREAD_SHM_TYPE_KERNEL_PRIVATE ones. Those are allocated by the
+ * normal world driver like the preallocated RPC arg struct, and can be
+ * handed back with thread_rpc_shm_cache_pop_kernel() when the cache is
+ * disabled.
+ */
+void thread_rpc_shm_cache_trim(struct thread_shm_cache *cache);
+
+/*
+ * Removes one THREAD_SHM_TYPE_KERNEL_PRIVATE entry from the cache and
+ * returns its mobj, the caller is responsible for handing it back to
+ * normal world. Returns NULL if there's no such entry.
+ */
+struct mobj *thread_rpc_shm_cache_pop_kernel(struct thread_shm_cache *cache);
 #endif /*__ASSEMBLER__*/
 #endif /*__KERNEL_THREAD_PRIVATE_H*/
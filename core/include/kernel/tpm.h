@@ -20,6 +20,28 @@ TEE_Result tpm_get_event_log(void *buf, size_t *size);
 
 TEE_Result tpm_get_event_log_size(size_t *size);
 
+/*
+ * Copies whole events of the TPM Event log, starting with event @first.
+ * The log is indexed when mapped so this doesn't parse it again.
+ *
+ * @buf Pointer to a buffer where to store the events.
+ * @size Size of @buf, updated with the number of bytes copied or with
+ * the size of event @first if it doesn't fit in @buf.
+ * @count Updated with the number of events copied.
+ * @total Updated with the number of events in the log.
+ */
+TEE_Result tpm_read_events(size_t first, void *buf, size_t *size,
+			   size_t *count, size_t *total);
+
+/*
+ * Appends an event to the TPM Event log, in the format of the events
+ * already in the log.
+ *
+ * @event Pointer to the event to append.
+ * @size Size of the event.
+ */
+TEE_Result tpm_append_event(const void *event, size_t size);
+
 /*
  * Reads the TPM Event log information and store it internally.
  * If support for DTB is enabled, it will read the parameters there.
@@ -43,6 +65,21 @@ static inline TEE_Result tpm_get_event_log_size(size_t *size __unused)
 	return TEE_ERROR_NOT_SUPPORTED;
 }
 
+static inline TEE_Result tpm_read_events(size_t first __unused,
+					 void *buf __unused,
+					 size_t *size __unused,
+					 size_t *count __unused,
+					 size_t *total __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result tpm_append_event(const void *event __unused,
+					  size_t size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
 static inline void tpm_map_log_area(void *fdt __unused)
 {}
 
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __KERNEL_TRACE_RING_H
+#define __KERNEL_TRACE_RING_H
+
+#include <stddef.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+#ifdef CFG_CORE_TRACE_RING
+/*
+ * trace_ring_read() - Consume buffered trace output
+ * @buf:	Destination buffer
+ * @len:	Length of @buf
+ *
+ * With CFG_CORE_TRACE_RING=y trace output of the core is appended to a
+ * per-core ring buffer instead of being written to the console. The
+ * oldest output is overwritten when a ring is full. This function moves
+ * as much buffered output as fits in @buf, one core after another.
+ *
+ * Returns the number of bytes copied to @buf.
+ */
+size_t trace_ring_read(char *buf, size_t len);
+
+/*
+ * trace_ring_set_shm() - Write trace output to non-secure memory
+ * @pa:		Physical address of the non-secure buffer
+ * @len:	Length of the buffer
+ *
+ * The buffer is split in one ring per core, each starting with a
+ * struct pta_trace_ring_hdr. Trace output is written there instead of
+ * to the secure rings, without taking any lock, so the normal world can
+ * read it directly. Can only be done once, by the first caller. With
+ * CFG_NS_VIRTUALIZATION=y the rings are shared by all guests.
+ *
+ * Returns TEE_SUCCESS on success or an error code on failure.
+ */
+TEE_Result trace_ring_set_shm(paddr_t pa, size_t len);
+
+/*
+ * trace_ring_flush() - Write buffered trace output to the console and
+ * send all trace output after this straight to the console
+ *
+ * Used when panicking.
+ */
+void trace_ring_flush(void);
+#else
+static inline size_t trace_ring_read(char *buf __unused, size_t len __unused)
+{
+	return 0;
+}
+
+static inline TEE_Result trace_ring_set_shm(paddr_t pa __unused,
+					    size_t len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void trace_ring_flush(void)
+{
+}
+#endif
+
+#endif /*__KERNEL_TRACE_RING_H*/
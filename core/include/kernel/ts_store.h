@@ -57,6 +57,14 @@ struct ts_store_ops {
 	void (*close)(struct ts_store_handle *h);
 };
 
+/*
+ * ts_store_flush_ta_cache() - Forget which TA store each TA was loaded from
+ *
+ * Must be called when a TA is added to a TA store, the TA could otherwise
+ * still be loaded from a store with lower priority.
+ */
+void ts_store_flush_ta_cache(void);
+
 /*
  * Registers a TA storage.
  *
@@ -20,11 +20,23 @@ static inline void print_kernel_stack(void)
 #ifdef CFG_UNWIND
 /* Get current call stack as an array allocated on the heap */
 vaddr_t *unw_get_kernel_stack(void);
+/*
+ * Stores at most @count return addresses of the current call stack in
+ * @addr, innermost first, and returns the number stored. Doesn't
+ * allocate memory so it can be used from the heap allocator.
+ */
+size_t unw_fill_kernel_stack(vaddr_t *addr, size_t count);
 #else
 static inline void *unw_get_kernel_stack(void)
 {
 	return NULL;
 }
+
+static inline size_t unw_fill_kernel_stack(vaddr_t *addr __unused,
+					   size_t count __unused)
+{
+	return 0;
+}
 #endif /* CFG_UNWIND  */
 
 #endif /*__KERNEL_UNWIND*/
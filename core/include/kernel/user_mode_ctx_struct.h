@@ -11,6 +11,20 @@
 #include <kernel/thread.h>
 #include <mm/tee_mmu_types.h>
 
+#define BB_TAG_CACHE_ENTRIES	4
+
+/*
+ * struct bb_tag_entry - Bounce buffer region which kept its memory tag
+ * @offs:	Offset of the region in the bounce buffer
+ * @len:	Size of the region, 0 if the entry is unused
+ * @tag:	Tag of the region
+ */
+struct bb_tag_entry {
+	size_t offs;
+	size_t len;
+	uint8_t tag;
+};
+
 /*
  * struct user_mode_ctx - user mode context
  * @vm_info:		Virtual memory map of this context
@@ -30,6 +44,8 @@
  * @bbuf:		Bounce buffer for user buffers
  * @bbuf_size:		Size of bounce buffer
  * @bbuf_offs:		Offset to unused part of bounce buffer
+ * @bbuf_tags:		Tagged bounce buffer regions which can be reused
+ * @bbuf_tags_next:	Next entry of @bbuf_tags to replace
  */
 struct user_mode_ctx {
 	struct vm_info vm_info;
@@ -55,6 +71,10 @@ struct user_mode_ctx {
 	uint8_t *bbuf;
 	size_t bbuf_size;
 	size_t bbuf_offs;
+#if defined(CFG_MEMTAG_BB_TAG_CACHE)
+	struct bb_tag_entry bbuf_tags[BB_TAG_CACHE_ENTRIES];
+	unsigned int bbuf_tags_next;
+#endif
 };
 #endif /*__KERNEL_USER_MODE_CTX_STRUCT_H*/
 
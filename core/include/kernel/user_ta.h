@@ -13,6 +13,7 @@
 #include <mm/file.h>
 #include <mm/tee_mm.h>
 #include <scattered_array.h>
+#include <tee_syscall_numbers.h>
 #include <tee_api_types.h>
 #include <types_ext.h>
 #include <util.h>
@@ -22,6 +23,36 @@ TAILQ_HEAD(tee_obj_head, tee_obj);
 TAILQ_HEAD(tee_storage_enum_head, tee_storage_enum);
 SLIST_HEAD(load_seg_head, load_seg);
 
+/*
+ * struct user_ta_acct - resource accounting of a user TA
+ * @lock:		Protects the fields below, a concurrent TA may run on
+ *			several threads at once
+ * @cpu_ticks:		Counter ticks spent running the TA, in user mode and
+ *			in syscalls
+ * @kernel_ticks:	Part of @cpu_ticks spent in syscalls
+ * @page_faults:	Page faults of the TA resolved by the pager
+ * @rpcs:		RPCs to normal world on behalf of the TA
+ * @heap_max_allocated:	Heap high-water mark of the TA as of the last
+ *			STATS_CMD_TA_STATS, the core can't see it otherwise
+ * @last_active:	Counter value when the TA was last entered or returned
+ * @running:		Number of threads currently running the TA
+ * @syscalls:		Number of syscalls by syscall number
+ *
+ * With CFG_CORE_THREAD_TIME_STATS the time the thread is suspended is
+ * excluded from the ticks, otherwise they're elapsed time.
+ */
+struct user_ta_acct {
+	unsigned int lock;
+	uint64_t cpu_ticks;
+	uint64_t kernel_ticks;
+	uint64_t page_faults;
+	uint64_t rpcs;
+	uint64_t heap_max_allocated;
+	uint64_t last_active;
+	uint32_t running;
+	uint32_t syscalls[TEE_SCN_MAX + 1];
+};
+
 /*
  * struct user_ta_ctx - user TA context
  * @open_sessions:	List of sessions opened by this TA
@@ -30,14 +61,22 @@ SLIST_HEAD(load_seg_head, load_seg);
  * @storage_enums:	List of storage enumerators opened by this TA
  * @uctx:		Generic user mode context
  * @ctx:		Generic TA context
+ * @acct:		Resource accounting, with CFG_TA_RESOURCE_STATS
  */
 struct user_ta_ctx {
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
 	struct tee_obj_head objects;
 	struct tee_storage_enum_head storage_enums;
+	/* Storage of an ongoing syscall_storage_transaction(), or NULL */
+	const struct tee_file_operations *storage_trans_fops;
 	struct user_mode_ctx uctx;
 	struct tee_ta_ctx ta_ctx;
+	/* Session the parameter mappings kept by vm_clean_param() belong to */
+	struct ts_session *param_sess;
+#if defined(CFG_TA_RESOURCE_STATS)
+	struct user_ta_acct acct;
+#endif
 };
 
 #ifdef CFG_WITH_USER_TA
@@ -85,4 +124,42 @@ tee_ta_complete_user_ta_session(struct tee_ta_session *s __unused)
 	return TEE_ERROR_GENERIC;
 }
 #endif /*CFG_WITH_USER_TA*/
+
+#if defined(CFG_TA_RESOURCE_STATS)
+/*
+ * Returns a counter value to pass to user_ta_acct_syscall(), the
+ * difference of two values is the CPU time in between.
+ */
+uint64_t user_ta_acct_stamp(void);
+/* Accounts syscall @scn of the current TA, started at @stamp */
+void user_ta_acct_syscall(size_t scn, uint64_t stamp);
+/* Accounts a page fault of the TA of the current thread, if any */
+void user_ta_acct_page_fault(void);
+/* Accounts an RPC on behalf of the TA of the current thread, if any */
+void user_ta_acct_rpc(void);
+/*
+ * user_ta_syscall_latency_stats() - Get the syscall latency histograms
+ * @buf:	Array of struct pta_stats_syscall_latency
+ * @buf_size:	Size of @buf, updated with the size used or needed
+ */
+TEE_Result user_ta_syscall_latency_stats(void *buf, size_t *buf_size);
+#else
+static inline uint64_t user_ta_acct_stamp(void)
+{
+	return 0;
+}
+
+static inline void user_ta_acct_syscall(size_t scn __unused,
+					uint64_t stamp __unused)
+{
+}
+
+static inline void user_ta_acct_page_fault(void)
+{
+}
+
+static inline void user_ta_acct_rpc(void)
+{
+}
+#endif
 #endif /*__KERNEL_USER_TA_H*/
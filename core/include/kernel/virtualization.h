@@ -9,6 +9,7 @@
 
 #include <bitstring.h>
 #include <mm/core_mmu.h>
+#include <mm/tee_mm.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <tee_api_types.h>
@@ -39,6 +40,45 @@ TEE_Result virt_guest_created(uint16_t guest_id);
  */
 TEE_Result virt_guest_destroyed(uint16_t guest_id);
 
+/**
+ * plat_virt_guest_thread_quota() - thread quota of a new guest VM
+ * @guest_id: VM id provided by hypervisor
+ *
+ * Returns how many threads the guest may have active at the same time,
+ * giving some guests a larger share than others. Called from
+ * virt_guest_created(), the value is capped to CFG_NUM_THREADS. The
+ * default __weak implementation returns CFG_VIRT_GUEST_THREAD_QUOTA.
+ */
+size_t plat_virt_guest_thread_quota(uint16_t guest_id);
+
+/**
+ * plat_virt_guest_ta_ram_limit() - TA RAM limit of a new guest VM
+ * @guest_id: VM id provided by hypervisor
+ *
+ * With CFG_VIRT_GUEST_TA_RAM_ON_DEMAND returns how many bytes of TA RAM
+ * the guest may draw from the shared secure pool. The limits of all
+ * guests may add up to more than the pool, overcommitting it. The
+ * default __weak implementation returns the size each guest would be
+ * given without CFG_VIRT_GUEST_TA_RAM_ON_DEMAND.
+ */
+size_t plat_virt_guest_ta_ram_limit(uint16_t guest_id);
+
+/**
+ * virt_ta_mem_alloc() - draw TA memory for the current guest VM
+ * @size: size in bytes
+ *
+ * Allocates from the nexus pools within the TA RAM limit of the guest,
+ * only available with CFG_VIRT_GUEST_TA_RAM_ON_DEMAND. Returns NULL if
+ * the limit is reached or the pools are exhausted.
+ */
+tee_mm_entry_t *virt_ta_mem_alloc(size_t size);
+
+/**
+ * virt_ta_mem_free() - return TA memory of the current guest VM
+ * @mm: memory allocated with virt_ta_mem_alloc()
+ */
+void virt_ta_mem_free(tee_mm_entry_t *mm);
+
 /**
  * virt_set_guest() - set guest VM context for current core
  * @guest_id: VM id provided by hypervisor
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_WORKQUEUE_H
+#define __KERNEL_WORKQUEUE_H
+
+#include <stddef.h>
+#include <sys/queue.h>
+
+/*
+ * struct work - deferred work reference
+ * @fn:		function to call, set by work_queue()
+ * @state:	WORK_STATE_* private to the work queue service
+ * @link:	linked list element
+ *
+ * @fn is called from a yielding context, that is, a normal thread
+ * executing a bottom half call from normal world. It may use mutexes,
+ * condition variables and RPC but should not block for long since it
+ * delays the other queued works.
+ */
+struct work {
+	void (*fn)(struct work *w);
+	unsigned int state;
+	TAILQ_ENTRY(work) link;
+};
+
+#ifdef CFG_CORE_WORKQUEUE
+/*
+ * work_queue() - Queue work to be done in a yielding context
+ * @w:		work reference
+ * @fn:		function to call with @w
+ *
+ * Adds @w to the work queue of the current CPU and requests a bottom half
+ * call from normal world. The queues are served by at most
+ * CFG_CORE_WORKQUEUE_WORKERS threads at once, each worker taking work from
+ * the queue of the CPU it executes on first and stealing work from the
+ * other queues once it's empty.
+ *
+ * If @w is already queued, this function does nothing. Once @fn has been
+ * called, @w may be queued again, also from @fn itself.
+ *
+ * The work structure can reside in global data or on the heap, but it must
+ * not be freed while queued. work_queue() may be called from any context,
+ * including interrupt handlers.
+ */
+void work_queue(struct work *w, void (*fn)(struct work *w));
+
+/*
+ * workqueue_run() - Run queued works
+ *
+ * Called from a yielding context when normal world does a bottom half
+ * call. Returns when all queues are empty or when enough other threads
+ * are already serving them.
+ */
+void workqueue_run(void);
+#else
+static inline void workqueue_run(void)
+{
+}
+#endif
+
+#endif /*__KERNEL_WORKQUEUE_H*/
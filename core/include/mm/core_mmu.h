@@ -447,6 +447,29 @@ void core_mmu_set_entry(struct core_mmu_table_info *tbl_info, unsigned idx,
 void core_mmu_get_entry_primitive(const void *table, size_t level, size_t idx,
 				  paddr_t *pa, uint32_t *attr);
 
+/* Number of small page entries in a block tagged with TEE_MATTR_CONTIG */
+#define CORE_MMU_CONTIG_ENTRIES		16
+#define CORE_MMU_CONTIG_SIZE		(CORE_MMU_CONTIG_ENTRIES * \
+					 SMALL_PAGE_SIZE)
+
+/*
+ * core_mmu_set_user_entries() - Map physically contiguous memory in a
+ *				 user mode translation table
+ * @tbl_info:	Translation table properties
+ * @va:		Virtual address of the first entry to update
+ * @pa:		Physical address to map at @va
+ * @size:	Size of the range to map
+ * @attr:	Attributes to assign the entries
+ *
+ * With CFG_CORE_MMU_CONTIG_HINT=y the entries of each naturally aligned
+ * block of CORE_MMU_CONTIG_ENTRIES small pages inside the range are tagged
+ * with TEE_MATTR_CONTIG if the physical address is aligned too, allowing
+ * the block to be held in a single TLB entry.
+ */
+void core_mmu_set_user_entries(struct core_mmu_table_info *tbl_info,
+			       vaddr_t va, paddr_t pa, size_t size,
+			       uint32_t attr);
+
 /*
  * core_mmu_get_entry() - Get entry from translation table
  * @tbl_info:	Translation table properties
@@ -634,6 +657,15 @@ void core_mmu_set_discovered_nsec_ddr(struct core_mmu_phys_mem *start,
 void core_init_mmu_prtn(struct mmu_partition *prtn, struct memory_map *mem_map);
 
 unsigned int asid_alloc(void);
+
+/*
+ * asid_free() - Release an ASID allocated with asid_alloc()
+ * @asid:	Address space identifier
+ *
+ * TLB entries still tagged with @asid are invalidated before the ASID is
+ * returned by asid_alloc() again, the caller doesn't need to invalidate
+ * them.
+ */
 void asid_free(unsigned int asid);
 
 #ifdef CFG_SECURE_DATA_PATH
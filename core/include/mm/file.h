@@ -94,6 +94,24 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen);
  */
 void file_put(struct file *f);
 
+/*
+ * file_keep() - Keep a verified file for later loads
+ * @f:		File pointer
+ *
+ * Holds a reference to @f so that its slices remain available for
+ * sharing after the last context using them is gone. Only the
+ * CFG_FILE_KEEP_COUNT most recently kept files are held, older ones are
+ * released. Does nothing if CFG_FILE_KEEP_COUNT is 0.
+ */
+void file_keep(struct file *f);
+
+/*
+ * file_release_kept() - Release all files held by file_keep()
+ *
+ * Used to give memory back when an allocation has failed.
+ */
+void file_release_kept(void);
+
 /*
  * file_find_slice() - Find a slice covering the @page_offset
  * @f:		 File pointer
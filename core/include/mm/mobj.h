@@ -251,10 +251,36 @@ TEE_Result mobj_ffa_add_pages_at(struct mobj_ffa *mobj, unsigned int *idx,
 uint64_t mobj_ffa_push_to_inactive(struct mobj_ffa *mobj);
 
 #elif defined(CFG_CORE_DYN_SHM)
+/*
+ * struct mobj_shm_extent - Physically contiguous range of shared memory
+ * @pa:		Physical address of the first page, page aligned
+ * @num_pages:	Number of small pages in the range
+ */
+struct mobj_shm_extent {
+	paddr_t pa;
+	size_t num_pages;
+};
+
 /* reg_shm represents TEE shared memory */
 struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 				paddr_t page_offset, uint64_t cookie);
 
+/**
+ * mobj_reg_shm_alloc_extents() - register shared memory described by extents
+ * @ext:	Array of extents, in the order they appear in the buffer
+ * @num_ext:	Number of elements in @ext
+ * @page_offset: Offset of the buffer in the first page
+ * @cookie:	Cookie used by normal world to refer to the buffer
+ *
+ * Same as mobj_reg_shm_alloc() except that the buffer is described by
+ * ranges of pages, each checked once, instead of by one entry per page.
+ *
+ * Returns a valid pointer on success or NULL on failure.
+ */
+struct mobj *mobj_reg_shm_alloc_extents(const struct mobj_shm_extent *ext,
+					size_t num_ext, paddr_t page_offset,
+					uint64_t cookie);
+
 /**
  * mobj_reg_shm_get_by_cookie() - get a MOBJ based on cookie
  * @cookie:	Cookie used by normal world when suppling the shared memory
@@ -280,12 +306,32 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie);
  */
 void mobj_reg_shm_unguard(struct mobj *mobj);
 
+/**
+ * mobj_is_registered_shm() - tell if a MOBJ is registered shared memory
+ * @mobj:	pointer to a MOBJ
+ *
+ * Returns true if @mobj is shared memory registered by normal world,
+ * unguarded with mobj_reg_shm_unguard() and not being released.
+ */
+bool mobj_is_registered_shm(struct mobj *mobj);
+
+/**
+ * mobj_reg_shm_get_stats() - get the number of registered shared memories
+ * @count:	Number of currently registered shared memory MOBJs
+ * @max_count:	Highest number of registered shared memory MOBJs seen
+ */
+void mobj_reg_shm_get_stats(size_t *count, size_t *max_count);
+
 /*
  * mapped_shm represents registered shared buffer
  * which is mapped into OPTEE va space
  */
 struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 				   paddr_t page_offset, uint64_t cookie);
+struct mobj *
+mobj_mapped_shm_alloc_extents(const struct mobj_shm_extent *ext,
+			      size_t num_ext, paddr_t page_offset,
+			      uint64_t cookie);
 #endif /*CFG_CORE_DYN_SHM*/
 
 #if !defined(CFG_CORE_DYN_SHM)
@@ -303,6 +349,19 @@ static inline struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie __unused)
 }
 #endif
 
+#if !defined(CFG_CORE_DYN_SHM) || defined(CFG_CORE_FFA)
+static inline void mobj_reg_shm_get_stats(size_t *count, size_t *max_count)
+{
+	*count = 0;
+	*max_count = 0;
+}
+
+static inline bool mobj_is_registered_shm(struct mobj *mobj __unused)
+{
+	return false;
+}
+#endif
+
 struct mobj *mobj_shm_alloc(paddr_t pa, size_t size, uint64_t cookie);
 
 #ifdef CFG_PAGED_USER_TA
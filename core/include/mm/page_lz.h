@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __MM_PAGE_LZ_H
+#define __MM_PAGE_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * A small LZ77 codec used to compress paged out pages. It's byte
+ * oriented and greedy in order to be fast rather than to compress well,
+ * typical data in TA heaps and stacks still compresses to a fraction
+ * of a page.
+ */
+
+#define PAGE_LZ_HASH_BITS	10
+
+/*
+ * struct page_lz_work - work area of page_lz_compress()
+ * @htab:	Last seen position + 1 of hashed 4 byte sequences
+ */
+struct page_lz_work {
+	uint16_t htab[1 << PAGE_LZ_HASH_BITS];
+};
+
+/*
+ * page_lz_compress() - Compress a buffer
+ * @src:	Data to compress
+ * @src_len:	Length of @src, at most 64 KiB
+ * @dst:	Output buffer
+ * @dst_len:	Length of @dst
+ * @work:	Work area
+ *
+ * Returns the length of the compressed data or 0 if it doesn't fit in
+ * @dst.
+ */
+size_t page_lz_compress(const uint8_t *src, size_t src_len, uint8_t *dst,
+			size_t dst_len, struct page_lz_work *work);
+
+/*
+ * page_lz_decompress() - Decompress a buffer
+ * @src:	Compressed data
+ * @src_len:	Length of @src
+ * @dst:	Output buffer
+ * @dst_len:	Expected length of the decompressed data
+ *
+ * Returns TEE_SUCCESS if exactly @dst_len bytes were decompressed or
+ * TEE_ERROR_CORRUPT_OBJECT if @src is malformed.
+ */
+TEE_Result page_lz_decompress(const uint8_t *src, size_t src_len,
+			      uint8_t *dst, size_t dst_len);
+
+#endif /*__MM_PAGE_LZ_H*/
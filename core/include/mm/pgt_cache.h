@@ -20,6 +20,27 @@
 #endif
 
 struct ts_ctx;
+struct mobj;
+
+#if defined(CFG_PGT_CACHE_REUSE_RO)
+/*
+ * struct pgt_ro_map - describes a read-only mapping in a translation table
+ * @mobj:	mobj of the mapping, a reference is held
+ * @va:		virtual address of the mapping
+ * @size:	size of the mapping
+ * @offset:	offset into @mobj
+ * @attr:	TEE_MATTR_* attributes of the mapping
+ */
+struct pgt_ro_map {
+	struct mobj *mobj;
+	vaddr_t va;
+	size_t size;
+	size_t offset;
+	uint32_t attr;
+};
+
+#define PGT_RO_MAP_COUNT	4
+#endif
 
 struct pgt {
 	void *tbl;
@@ -34,6 +55,14 @@ struct pgt {
 #if defined(CFG_CORE_PREALLOC_EL0_TBLS) || \
 	(defined(CFG_WITH_PAGER) && !defined(CFG_WITH_LPAE))
 	struct pgt_parent *parent;
+#endif
+#if defined(CFG_PGT_CACHE_REUSE_RO)
+	/*
+	 * If num_ro_maps isn't 0 the content of the table is completely
+	 * described by the read-only mappings in ro_maps[].
+	 */
+	struct pgt_ro_map ro_maps[PGT_RO_MAP_COUNT];
+	uint8_t num_ro_maps;
 #endif
 	SLIST_ENTRY(pgt) link;
 };
@@ -88,6 +117,37 @@ void pgt_init(void);
 
 void pgt_flush(struct user_mode_ctx *uctx);
 
+/*
+ * pgt_reuse_ro_tables() - copy read-only translation tables from the cache
+ * @uctx:	the context owning the tables
+ *
+ * Each not yet populated table of @uctx which only holds read-only
+ * mappings is recorded as such. If another context has left an identical
+ * table in the cache the content of that table is copied and the table is
+ * marked as populated. Multiple instances of a TA mapping the same
+ * read-only segments at the same addresses can this way skip populating
+ * the tables from scratch.
+ *
+ * pgt_forget_ro_maps() - forget the read-only mappings recorded for a table
+ * @pgt:	the table
+ *
+ * Must be called before a table is modified. The caller must either hold
+ * the table in the pgt_cache of a context or have removed it from the
+ * cache.
+ */
+#if defined(CFG_PGT_CACHE_REUSE_RO)
+void pgt_reuse_ro_tables(struct user_mode_ctx *uctx);
+void pgt_forget_ro_maps(struct pgt *pgt);
+#else
+static inline void pgt_reuse_ro_tables(struct user_mode_ctx *uctx __unused)
+{
+}
+
+static inline void pgt_forget_ro_maps(struct pgt *pgt __unused)
+{
+}
+#endif
+
 #if defined(CFG_PAGED_USER_TA)
 static inline void pgt_inc_used_entries(struct pgt *pgt)
 {
@@ -29,6 +29,11 @@ tee_mm_entry_t *phys_mem_mm_find(paddr_t addr);
 tee_mm_entry_t *phys_mem_core_alloc(size_t size);
 tee_mm_entry_t *phys_mem_ta_alloc(size_t size);
 tee_mm_entry_t *phys_mem_alloc2(paddr_t base, size_t size);
+/*
+ * Frees memory allocated with phys_mem_ta_alloc(), which may have been
+ * drawn from the nexus pools with CFG_VIRT_GUEST_TA_RAM_ON_DEMAND.
+ */
+void phys_mem_free(tee_mm_entry_t *mm);
 #ifdef CFG_WITH_STATS
 void phys_mem_stats(struct pta_stats_alloc *stats, bool reset);
 #endif
@@ -59,6 +64,11 @@ static inline tee_mm_entry_t *phys_mem_alloc2(paddr_t base, size_t size)
 	return nex_phys_mem_alloc2(base, size);
 }
 
+static inline void phys_mem_free(tee_mm_entry_t *mm)
+{
+	tee_mm_free(mm);
+}
+
 #ifdef CFG_WITH_STATS
 static inline void phys_mem_stats(struct pta_stats_alloc *stats, bool reset)
 {
@@ -17,23 +17,38 @@
 /* Flag to indicate that pool should use nex_malloc instead of malloc */
 #define TEE_MM_POOL_NEX_MALLOC             (1u << 1)
 
+/*
+ * Allocated entries are kept in an AVL tree ordered by address, from the
+ * top of the pool with TEE_MM_POOL_HI_ALLOC. Each node records the free
+ * space before it and the largest such space in its subtree so a free
+ * area can be found in logarithmic time.
+ */
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
-	struct _tee_mm_entry_t *next;
+	struct _tee_mm_entry_t *left;
+	struct _tee_mm_entry_t *right;
 	uint32_t offset;	/* offset in pages/sections */
 	uint32_t size;		/* size in pages/sections */
+	uint32_t gap;		/* free pages/sections before this entry */
+	uint32_t max_gap;	/* largest gap in this subtree */
+	uint8_t height;		/* height of this subtree */
 };
 typedef struct _tee_mm_entry_t tee_mm_entry_t;
 
 struct _tee_mm_pool_t {
-	tee_mm_entry_t *entry;
+	tee_mm_entry_t *root;
 	paddr_t lo;		/* low boundary of the pool */
 	paddr_size_t size;	/* pool size */
 	uint32_t flags;		/* Config flags for the pool */
 	uint8_t shift;		/* size shift */
+	bool initialized;
 	unsigned int lock;
 #ifdef CFG_WITH_STATS
+	size_t allocated;
 	size_t max_allocated;
+	size_t num_alloc_fail;
+	size_t biggest_alloc_fail;
+	size_t biggest_alloc_fail_used;
 #endif
 };
 typedef struct _tee_mm_pool_t tee_mm_pool_t;
@@ -52,6 +52,13 @@
 
 #define TEE_MATTR_GUARDED		BIT(15)
 
+/*
+ * Tags an entry as part of a naturally aligned block of
+ * CORE_MMU_CONTIG_ENTRIES entries mapping physically contiguous memory
+ * with identical attributes. Only used in user mode translation tables.
+ */
+#define TEE_MATTR_CONTIG		BIT(16)
+
 /*
  * Tags TA mappings which are only used during a single call (open session
  * or invoke command parameters).
@@ -127,9 +134,19 @@ struct vm_paged_region {
 TAILQ_HEAD(vm_paged_region_head, vm_paged_region);
 TAILQ_HEAD(vm_region_head, vm_region);
 
+/*
+ * struct vm_info - virtual memory of a user mode context
+ * @regions:	mapped regions, sorted on virtual address
+ * @last_region: region last found by virtual address, or NULL
+ * @asid:	address space identifier
+ * @gen:	generation, changed to a value not used before by any context
+ *		each time a non-ephemeral region is mapped, unmapped or split
+ */
 struct vm_info {
 	struct vm_region_head regions;
+	struct vm_region *last_region;
 	unsigned int asid;
+	uint32_t gen;
 };
 
 static inline void mattr_perm_to_str(char *str, size_t size, uint32_t attr)
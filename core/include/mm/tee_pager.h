@@ -263,6 +263,10 @@ struct tee_pager_stats {
 	size_t zi_released;
 	size_t npages;		/* number of load pages */
 	size_t npages_all;	/* number of pages */
+	size_t read_ahead_pages;	/* pages loaded ahead of a fault */
+	size_t read_ahead_hits;		/* read-ahead pages used later */
+	size_t evictions;		/* pages evicted to load another */
+	size_t refaults;		/* evicted pages soon loaded again */
 };
 
 #ifdef CFG_WITH_PAGER
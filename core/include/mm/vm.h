@@ -57,10 +57,19 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 TEE_Result vm_unmap(struct user_mode_ctx *uctx, vaddr_t va, size_t len);
 
-/* Map parameters for a user TA */
+/*
+ * Map parameters for a user TA. Mappings kept by vm_clean_param() are
+ * reused when they cover a parameter and removed otherwise.
+ */
 TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 			void *param_va[TEE_NUM_PARAMS]);
+/*
+ * Remove the parameter mappings, except those of registered shared memory
+ * with CFG_TA_PARAM_MAP_CACHE
+ */
 void vm_clean_param(struct user_mode_ctx *uctx);
+/* Remove all the parameter mappings */
+void vm_flush_param(struct user_mode_ctx *uctx);
 
 /*
  * User mode private memory is defined as user mode image static segment
@@ -70,6 +70,27 @@
  */
 #define OPTEE_MSG_ATTR_NONCONTIG		BIT(9)
 
+/*
+ * Used together with OPTEE_MSG_ATTR_NONCONTIG, the list pointed to by
+ * buf_ptr describes the buffer with runs of physically contiguous pages
+ * instead of one entry per page. Each run is a page aligned physical
+ * address followed by a number of 4KB pages, both 64 bit values, and
+ * runs are placed like members of this structure:
+ *
+ * struct extent_data {
+ *   struct {
+ *     uint64_t pa;
+ *     uint64_t num_pages;
+ *   } extents[(OPTEE_MSG_NONCONTIG_PAGE_SIZE / sizeof(uint64_t) - 2) / 2];
+ *   uint64_t reserved;
+ *   uint64_t next_page_data;
+ * };
+ *
+ * The list ends with the run completing the size of the buffer. Only
+ * valid if OPTEE_SMC_SEC_CAP_SHM_EXTENTS is reported by secure world.
+ */
+#define OPTEE_MSG_ATTR_EXTENTS			BIT(10)
+
 /*
  * Memory attributes for caching passed with temp memrefs. The actual value
  * used is defined outside the message protocol with the exception of
@@ -331,6 +352,39 @@ struct optee_msg_arg {
  * OPTEE_MSG_CMD_STOP_ASYNC_NOTIF informs secure world that from now is
  * normal world unable to process asynchronous notifications. Typically
  * used when the driver is shut down.
+ *
+ * OPTEE_MSG_CMD_INVOKE_BATCH invokes several commands in previously opened
+ * sessions with a single call. The commands are passed in a shared memory
+ * buffer holding consecutive struct optee_msg_arg, each with cmd set to
+ * OPTEE_MSG_CMD_INVOKE_COMMAND, at most 4 parameters and taking
+ * OPTEE_MSG_GET_ARG_SIZE(num_params) bytes. The commands are executed in
+ * order and each gets its own ret and ret_origin updated as with
+ * OPTEE_MSG_CMD_INVOKE_COMMAND. The buffer is passed as:
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_{T,R,F}MEM_INOUT
+ * [in] param[0].u.{t,r,f}mem		buffer with the commands
+ * ret is TEE_SUCCESS if all commands were executed, else the buffer was
+ * malformed and the commands following the first malformed one were not
+ * executed.
+ *
+ * OPTEE_MSG_CMD_INVOKE_ASYNC submits an invoke command without waiting for
+ * it to complete. It takes the same arguments as
+ * OPTEE_MSG_CMD_INVOKE_COMMAND preceded by a meta parameter:
+ * [out] param[0].attr			OPTEE_MSG_ATTR_TYPE_VALUE_OUTPUT |
+ *					OPTEE_MSG_ATTR_META
+ * [out] param[0].u.value.a		asynchronous notification value
+ * The command is executed by a later OPTEE_MSG_CMD_DO_BOTTOM_HALF and
+ * param[0].u.value.a is signalled as an asynchronous notification once
+ * it has completed. Memory referenced by the parameters must stay valid
+ * until then. Requires asynchronous notifications to be started.
+ *
+ * OPTEE_MSG_CMD_INVOKE_ASYNC_RESULT retrieves the result of a command
+ * submitted with OPTEE_MSG_CMD_INVOKE_ASYNC. The parameters are updated
+ * as with OPTEE_MSG_CMD_INVOKE_COMMAND, following a meta parameter:
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_VALUE_INPUT |
+ *					OPTEE_MSG_ATTR_META
+ * [in] param[0].u.value.a		value from OPTEE_MSG_CMD_INVOKE_ASYNC
+ * ret is TEE_ERROR_BUSY with ret_origin TEE_ORIGIN_TEE if the command
+ * hasn't completed yet.
  */
 #define OPTEE_MSG_CMD_OPEN_SESSION	U(0)
 #define OPTEE_MSG_CMD_INVOKE_COMMAND	U(1)
@@ -340,6 +394,9 @@ struct optee_msg_arg {
 #define OPTEE_MSG_CMD_UNREGISTER_SHM	U(5)
 #define OPTEE_MSG_CMD_DO_BOTTOM_HALF	U(6)
 #define OPTEE_MSG_CMD_STOP_ASYNC_NOTIF	U(7)
+#define OPTEE_MSG_CMD_INVOKE_BATCH	U(8)
+#define OPTEE_MSG_CMD_INVOKE_ASYNC	U(9)
+#define OPTEE_MSG_CMD_INVOKE_ASYNC_RESULT U(10)
 #define OPTEE_MSG_FUNCID_CALL_WITH_ARG	U(0x0004)
 
 #endif /* __OPTEE_MSG_H */
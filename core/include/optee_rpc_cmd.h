@@ -322,6 +322,22 @@
  */
 #define OPTEE_RPC_FS_READDIR		U(10)
 
+/*
+ * Write several blocks of a file
+ *
+ * [in]     value[0].a	    OPTEE_RPC_FS_WRITEV
+ * [in]     value[0].b	    File descriptor of open file
+ * [in]     value[0].c	    Number of writes
+ * [in]     memref[1]	    Buffer holding the writes
+ *
+ * Each write in the buffer starts with a 64-bit offset into the file
+ * followed by a 32-bit length and 32 bits of padding, all in native
+ * endianness, and then the data to be written. The next write starts at
+ * the following 8 byte aligned offset in the buffer. The writes are done
+ * in order, processing stops at the first failing write.
+ */
+#define OPTEE_RPC_FS_WRITEV		U(11)
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_FS */
 
 /*
@@ -395,6 +411,29 @@
  */
 #define OPTEE_RPC_SOCKET_IOCTL	U(5)
 
+/*
+ * Set up the shared memory ring of a socket, struct pta_socket_ring
+ * followed by the send and receive data areas
+ *
+ * [in]     value[0].a	    OPTEE_RPC_SOCKET_RING_SETUP
+ * [in]     value[0].b	    TA instance id
+ * [in]     value[0].c	    Socket handle
+ * [in]     memref[1]	    Ring
+ */
+#define OPTEE_RPC_SOCKET_RING_SETUP	U(6)
+
+/*
+ * Send the data queued in the ring of a socket and receive into its free
+ * space, waiting until data can be received or all queued data is sent
+ *
+ * [in]     value[0].a	    OPTEE_RPC_SOCKET_RING_KICK
+ * [in]     value[0].b	    TA instance id
+ * [in]     value[0].c	    Socket handle
+ * [in]     value[1].a	    Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * [out]    value[1].b	    Readiness events, PTA_SOCKET_RING_*
+ */
+#define OPTEE_RPC_SOCKET_RING_KICK	U(7)
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_SOCKET */
 
 /*
@@ -5,8 +5,51 @@
 #ifndef __TEE_CACHE_H
 #define __TEE_CACHE_H
 
+#include <stdbool.h>
 #include <utee_types.h>
 
 TEE_Result cache_operation(enum utee_cache_operation op, void *va, size_t len);
 
+enum dma_buf_dir {
+	DMA_BUF_TO_DEVICE,
+	DMA_BUF_FROM_DEVICE,
+	DMA_BUF_BIDIRECTIONAL,
+};
+
+/*
+ * struct dma_buf - Memory buffer accessed by a non-coherent DMA master
+ * @va:		Start of the buffer
+ * @len:	Byte size of the buffer
+ * @dir:	Direction of the transfers done by the device
+ * @dev_owned:	Buffer is handed to the device
+ * @cpu_dirty:	CPU may have written to the buffer since the last clean
+ *
+ * The cache maintenance is only done when the ownership of the buffer
+ * changes and only when needed: a buffer the CPU didn't write isn't
+ * cleaned again and a buffer the device only reads isn't invalidated.
+ */
+struct dma_buf {
+	void *va;
+	size_t len;
+	enum dma_buf_dir dir;
+	bool dev_owned;
+	bool cpu_dirty;
+};
+
+/* Initialize @db, owned by the CPU and with an unknown cache state */
+void dma_buf_init(struct dma_buf *db, void *va, size_t len,
+		  enum dma_buf_dir dir);
+
+/* Record that the CPU wrote to @db while owning it */
+static inline void dma_buf_cpu_write(struct dma_buf *db)
+{
+	db->cpu_dirty = true;
+}
+
+/* Hand @db to the device, does nothing if the device already owns it */
+TEE_Result dma_buf_to_device(struct dma_buf *db);
+
+/* Hand @db back to the CPU, does nothing if the CPU already owns it */
+TEE_Result dma_buf_to_cpu(struct dma_buf *db);
+
 #endif /* __TEE_CACHE_H */
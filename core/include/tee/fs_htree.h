@@ -69,6 +69,7 @@ enum tee_fs_htree_type {
 	TEE_FS_HTREE_TYPE_BLOCK,
 };
 
+struct tee_fs_rpc_batch;
 struct tee_fs_rpc_operation;
 
 /**
@@ -79,6 +80,13 @@ struct tee_fs_rpc_operation;
  *			operation
  * @rpc_write_init:	initialize a struct tee_fs_rpc_operation for an RPC
  *			write operation
+ * @rpc_batch_init:	optional, initialize a struct tee_fs_rpc_batch used
+ *			to write the nodes when syncing the hash tree and
+ *			to write consecutive data blocks
+ * @rpc_batch_add:	queue a write in a struct tee_fs_rpc_batch
+ * @rpc_batch_flush:	send the writes queued in a struct tee_fs_rpc_batch,
+ *			@rpc_batch_add and @rpc_batch_flush are required if
+ *			@rpc_batch_init is supplied
  *
  * The @idx arguments starts counting from 0. The @vers arguments are either
  * 0 or 1. The @data arguments is a pointer to a buffer in non-secure shared
@@ -95,6 +103,11 @@ struct tee_fs_htree_storage {
 				     enum tee_fs_htree_type type, size_t idx,
 				     uint8_t vers, void **data);
 	TEE_Result (*rpc_write_final)(struct tee_fs_rpc_operation *op);
+	void (*rpc_batch_init)(void *aux, struct tee_fs_rpc_batch *b);
+	TEE_Result (*rpc_batch_add)(void *aux, struct tee_fs_rpc_batch *b,
+				    enum tee_fs_htree_type type, size_t idx,
+				    uint8_t vers, void **data);
+	TEE_Result (*rpc_batch_flush)(struct tee_fs_rpc_batch *b);
 };
 
 struct tee_fs_htree;
@@ -153,6 +166,26 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht,
  */
 TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht, size_t block_num);
 
+/**
+ * tee_fs_htree_batch_writes() - queue data block writes in a batch
+ * @ht:		hash tree
+ *
+ * Following calls to tee_fs_htree_write_block() queue the encrypted
+ * blocks in a struct tee_fs_rpc_batch instead of writing them one by one.
+ * The batch is sent by tee_fs_htree_flush_writes(), or before any data
+ * block is read and before the hash tree is synced. Does nothing unless
+ * the storage supplies @rpc_batch_init.
+ */
+void tee_fs_htree_batch_writes(struct tee_fs_htree *ht);
+
+/**
+ * tee_fs_htree_flush_writes() - write the data blocks queued in a batch
+ * @ht:		hash tree
+ *
+ * Frees the hash tree and sets *ht to NULL on failure and returns an error code
+ */
+TEE_Result tee_fs_htree_flush_writes(struct tee_fs_htree **ht);
+
 /**
  * tee_fs_htree_write_block() - encrypt and write a data block to storage
  * @ht:		hash tree
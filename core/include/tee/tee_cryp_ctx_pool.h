@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __TEE_TEE_CRYP_CTX_POOL_H
+#define __TEE_TEE_CRYP_CTX_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+#ifdef CFG_CRYPTO_CTX_POOL
+/*
+ * tee_cryp_ctx_pool_get() - Get a cached context for @algo
+ * @algo:	TEE_ALG_* identifier of a cipher, AE, MAC or digest
+ *
+ * Returns a context previously released with tee_cryp_ctx_pool_put() or
+ * NULL if none is available, in which case the caller allocates a new one
+ * with the crypto_*_alloc_ctx() function of the algorithm class.
+ */
+void *tee_cryp_ctx_pool_get(uint32_t algo);
+
+/*
+ * tee_cryp_ctx_pool_put() - Release a context into the pool
+ * @algo:	TEE_ALG_* identifier @ctx was allocated for
+ * @ctx:	Context to release
+ *
+ * The state of @ctx is overwritten with that of a never initialized
+ * context of the same algorithm before it's cached. Returns true if @ctx
+ * was taken by the pool, false if the caller still has to free it.
+ */
+bool tee_cryp_ctx_pool_put(uint32_t algo, void *ctx);
+
+void tee_cryp_ctx_pool_get_stats(uint64_t *hits, uint64_t *misses);
+#else
+static inline void *tee_cryp_ctx_pool_get(uint32_t algo __unused)
+{
+	return NULL;
+}
+
+static inline bool tee_cryp_ctx_pool_put(uint32_t algo __unused,
+					 void *ctx __unused)
+{
+	return false;
+}
+
+static inline void tee_cryp_ctx_pool_get_stats(uint64_t *hits,
+					       uint64_t *misses)
+{
+	*hits = 0;
+	*misses = 0;
+}
+#endif
+
+#endif /*__TEE_TEE_CRYP_CTX_POOL_H*/
@@ -52,6 +52,18 @@ struct tee_file_operations {
 	TEE_Result (*opendir)(const TEE_UUID *uuid, struct tee_fs_dir **d);
 	TEE_Result (*readdir)(struct tee_fs_dir *d, struct tee_fs_dirent **ent);
 	void (*closedir)(struct tee_fs_dir *d);
+
+	/*
+	 * Optional transaction support. Once a file handle has joined the
+	 * transaction of @owner, writes and truncations through it are kept
+	 * pending until the transaction is committed or aborted, also if
+	 * the handle is closed in between. All pending files are committed
+	 * together.
+	 */
+	void (*join_transaction)(struct tee_file_handle *fh,
+				 const void *owner);
+	TEE_Result (*commit_transaction)(const void *owner);
+	void (*abort_transaction)(const void *owner);
 };
 
 #ifdef CFG_REE_FS
@@ -6,6 +6,8 @@
 #ifndef __TEE_TEE_FS_KEY_MANAGER_H
 #define __TEE_TEE_FS_KEY_MANAGER_H
 
+#include <compiler.h>
+#include <stdint.h>
 #include <tee_api_types.h>
 #include <utee_defines.h>
 
@@ -27,4 +29,31 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 			    const uint8_t *in_key, size_t size,
 			    uint8_t *out_key);
 
+/*
+ * With CFG_CORE_THREAD_TIME_STATS the generic timer ticks each thread
+ * spends encrypting, decrypting and hashing secure storage data are
+ * accounted. tee_fs_crypto_time_begin() returns the start of a
+ * measurement to pass to tee_fs_crypto_time_end(), tee_fs_crypto_ticks()
+ * returns the total of the current thread.
+ */
+#ifdef CFG_CORE_THREAD_TIME_STATS
+uint64_t tee_fs_crypto_time_begin(void);
+void tee_fs_crypto_time_end(uint64_t begin);
+uint64_t tee_fs_crypto_ticks(void);
+#else
+static inline uint64_t tee_fs_crypto_time_begin(void)
+{
+	return 0;
+}
+
+static inline void tee_fs_crypto_time_end(uint64_t begin __unused)
+{
+}
+
+static inline uint64_t tee_fs_crypto_ticks(void)
+{
+	return 0;
+}
+#endif
+
 #endif
@@ -42,6 +42,44 @@ TEE_Result tee_fs_rpc_write_init(struct tee_fs_rpc_operation *op,
 				 size_t data_len, void **data);
 TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op);
 
+/*
+ * struct tee_fs_rpc_batch - writes queued for one OPTEE_RPC_FS_WRITEV
+ * @id:		RPC command, OPTEE_RPC_CMD_FS
+ * @fd:		file descriptor the writes are for
+ * @mobj:	shared memory holding the queued writes
+ * @buf:	virtual address of @mobj
+ * @used:	bytes of @buf in use
+ * @count:	number of queued writes
+ */
+struct tee_fs_rpc_batch {
+	uint32_t id;
+	int fd;
+	struct mobj *mobj;
+	uint8_t *buf;
+	size_t used;
+	size_t count;
+};
+
+/*
+ * Initializes an empty batch of writes to @fd. No memory is allocated
+ * until the first write is queued.
+ */
+void tee_fs_rpc_batch_init(struct tee_fs_rpc_batch *b, uint32_t id, int fd);
+
+/*
+ * Queues a write of @data_len bytes at @offset and returns in @data where
+ * to store the data. The batch is flushed first if it's full.
+ */
+TEE_Result tee_fs_rpc_batch_add(struct tee_fs_rpc_batch *b,
+				tee_fs_off_t offset, size_t data_len,
+				void **data);
+
+/*
+ * Sends the queued writes. Falls back to one OPTEE_RPC_FS_WRITE per write
+ * if normal world doesn't support OPTEE_RPC_FS_WRITEV.
+ */
+TEE_Result tee_fs_rpc_batch_flush(struct tee_fs_rpc_batch *b);
+
 
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len);
 TEE_Result tee_fs_rpc_remove_dfh(uint32_t id,
@@ -12,7 +12,8 @@
 #include <tee/tee_fs.h>
 
 struct tee_pobj {
-	TAILQ_ENTRY(tee_pobj) link;
+	LIST_ENTRY(tee_pobj) link;
+	unsigned int bucket_idx;	/* index of the hash bucket */
 	uint32_t refcnt;
 	TEE_UUID uuid;
 	void *obj_id;
@@ -20,7 +21,7 @@ struct tee_pobj {
 	uint32_t flags;
 	uint32_t obj_info_usage;
 	bool temporary;	/* can be changed while creating == true */
-	bool creating;	/* can only be changed with mutex held */
+	bool creating;	/* can only be changed with bucket mutex held */
 	/* Filesystem handling this object */
 	const struct tee_file_operations *fops;
 };
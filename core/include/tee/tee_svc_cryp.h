@@ -66,6 +66,8 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 TEE_Result syscall_authenc_update_payload(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len);
+TEE_Result syscall_cryp_update_vec(unsigned long state,
+				   struct utee_cryp_vec *vec, size_t num_vec);
 TEE_Result syscall_authenc_enc_final(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len, void *tag, uint64_t *tag_len);
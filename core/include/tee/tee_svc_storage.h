@@ -59,7 +59,18 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 				    unsigned long whence);
 
+/*
+ * Begins or commits a transaction across persistent objects of one
+ * storage, @op is an enum utee_storage_transaction_op. Writes and
+ * truncations through object handles of the TA are kept pending until
+ * the transaction is committed, all of them are then committed together.
+ * Creating, renaming and deleting objects take effect immediately.
+ */
+TEE_Result syscall_storage_transaction(unsigned long storage_id,
+				       unsigned long op);
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc);
+void tee_svc_storage_abort_transaction(struct user_ta_ctx *utc);
 TEE_Result tee_svc_storage_write_usage(struct tee_obj *o, uint32_t usage);
 
 void tee_svc_storage_init(void);
@@ -7,39 +7,192 @@
 #include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <mm/core_memprot.h>
+#include <util.h>
 
-TAILQ_HEAD(callout_head, callout);
+/*
+ * Active callouts are kept in a hierarchical timer wheel indexed with the
+ * expiry time in jiffies, a jiffy being the largest power of two number of
+ * ticks not exceeding a millisecond. Level 0 has one slot per jiffy and
+ * each following level has slots CALLOUT_SLOTS times wider. A callout is
+ * hashed into the lowest level where it's less than CALLOUT_SLOTS slots
+ * ahead of callout_clk, the callouts too far away for the top level are
+ * kept in callout_overflow. This makes adding and removing a callout O(1).
+ *
+ * Only callout_service_cb() advances callout_clk: it collects all the
+ * slots passed since the last time, calls the callouts which have expired
+ * and inserts the others again, which moves them to a lower level. The
+ * exact expiry value of each callout is kept and the timer is programmed
+ * for the earliest one, found with the bitmaps of non-empty slots. As a
+ * level never holds more than one revolution ahead of callout_clk, its
+ * earliest callouts are in the first non-empty slot from the current one.
+ */
+#define CALLOUT_SLOT_SHIFT	6
+#define CALLOUT_SLOTS		BIT(CALLOUT_SLOT_SHIFT)
+#define CALLOUT_LEVELS		3
+#define CALLOUT_WHEEL_SIZE	(CALLOUT_LEVELS * CALLOUT_SLOTS)
+
+/* Values of struct callout::slot besides 1 + an index in callout_wheel[] */
+#define CALLOUT_INACTIVE	0
+#define CALLOUT_PENDING		(CALLOUT_WHEEL_SIZE + 1)
+#define CALLOUT_OVERFLOW	(CALLOUT_WHEEL_SIZE + 2)
+
+LIST_HEAD(callout_head, callout);
 
 static unsigned int callout_sched_lock __nex_data = SPINLOCK_UNLOCK;
 static size_t callout_sched_core __nex_bss;
 static unsigned int callout_lock __nex_data = SPINLOCK_UNLOCK;
 static const struct callout_timer_desc *callout_desc __nex_bss;
-static struct callout_head callout_head __nex_data =
-	TAILQ_HEAD_INITIALIZER(callout_head);
+static struct callout_head callout_wheel[CALLOUT_WHEEL_SIZE] __nex_bss;
+static uint64_t callout_bitmap[CALLOUT_LEVELS] __nex_bss;
+static struct callout_head callout_overflow __nex_bss;
+/* Callouts added before callout_service_init() */
+static struct callout_head callout_pending __nex_bss;
+static unsigned int callout_jiffy_shift __nex_bss;
+static uint64_t callout_clk __nex_bss;
+/* Expiry value the timer is programmed with, UINT64_MAX if disabled */
+static uint64_t callout_next_expiry __nex_data = UINT64_MAX;
+
+static unsigned int level_shift(unsigned int level)
+{
+	return level * CALLOUT_SLOT_SHIFT;
+}
 
-static void insert_callout(struct callout *co)
+static unsigned int level_slot(unsigned int level, uint64_t jiffies)
 {
-	struct callout *co2 = NULL;
+	return (jiffies >> level_shift(level)) & (CALLOUT_SLOTS - 1);
+}
 
-	TAILQ_FOREACH(co2, &callout_head, link) {
-		if (co->expiry_value < co2->expiry_value) {
-			TAILQ_INSERT_BEFORE(co2, co, link);
+static bool wheel_is_empty(void)
+{
+	unsigned int level = 0;
+
+	for (level = 0; level < CALLOUT_LEVELS; level++)
+		if (callout_bitmap[level])
+			return false;
+
+	return LIST_EMPTY(&callout_overflow);
+}
+
+static void insert_callout(struct callout *co)
+{
+	uint64_t exp = MAX(co->expiry_value >> callout_jiffy_shift,
+			   callout_clk);
+	unsigned int level = 0;
+	unsigned int shift = 0;
+	unsigned int n = 0;
+
+	for (level = 0; level < CALLOUT_LEVELS; level++) {
+		shift = level_shift(level);
+		if ((exp >> shift) - (callout_clk >> shift) < CALLOUT_SLOTS) {
+			n = level_slot(level, exp);
+			LIST_INSERT_HEAD(callout_wheel + level * CALLOUT_SLOTS + n,
+					 co, link);
+			callout_bitmap[level] |= BIT64(n);
+			co->slot = level * CALLOUT_SLOTS + n + 1;
 			return;
 		}
 	}
 
-	TAILQ_INSERT_TAIL(&callout_head, co, link);
+	LIST_INSERT_HEAD(&callout_overflow, co, link);
+	co->slot = CALLOUT_OVERFLOW;
 }
 
-static void schedule_next_timeout(void)
+static void remove_callout(struct callout *co)
+{
+	unsigned int n = co->slot - 1;
+
+	LIST_REMOVE(co, link);
+	if (n < CALLOUT_WHEEL_SIZE && LIST_EMPTY(callout_wheel + n))
+		callout_bitmap[n / CALLOUT_SLOTS] &= ~BIT64(n % CALLOUT_SLOTS);
+	co->slot = CALLOUT_INACTIVE;
+}
+
+static void move_callouts(struct callout_head *dst, struct callout_head *src)
+{
+	struct callout *co = NULL;
+
+	while (!LIST_EMPTY(src)) {
+		co = LIST_FIRST(src);
+		LIST_REMOVE(co, link);
+		LIST_INSERT_HEAD(dst, co, link);
+	}
+}
+
+/*
+ * Moves the callouts in all the slots passed from callout_clk up to and
+ * including @now_jiffies, and those in callout_overflow, to @head and
+ * advances callout_clk to @now_jiffies.
+ */
+static void collect_callouts(uint64_t now_jiffies, struct callout_head *head)
+{
+	unsigned int level = 0;
+	unsigned int shift = 0;
+	unsigned int count = 0;
+	unsigned int slot = 0;
+	unsigned int n = 0;
+
+	for (level = 0; level < CALLOUT_LEVELS; level++) {
+		shift = level_shift(level);
+		count = MIN((now_jiffies >> shift) - (callout_clk >> shift) + 1,
+			    (uint64_t)CALLOUT_SLOTS);
+		for (n = 0; n < count && callout_bitmap[level]; n++) {
+			slot = level_slot(level,
+					  callout_clk + ((uint64_t)n << shift));
+			if (!(callout_bitmap[level] & BIT64(slot)))
+				continue;
+			move_callouts(head, callout_wheel +
+					    level * CALLOUT_SLOTS + slot);
+			callout_bitmap[level] &= ~BIT64(slot);
+		}
+	}
+	move_callouts(head, &callout_overflow);
+
+	callout_clk = now_jiffies;
+}
+
+static uint64_t min_expiry(struct callout_head *head)
+{
+	uint64_t min = UINT64_MAX;
+	struct callout *co = NULL;
+
+	LIST_FOREACH(co, head, link)
+		min = MIN(min, co->expiry_value);
+
+	return min;
+}
+
+static uint64_t next_expiry(void)
+{
+	uint64_t min = min_expiry(&callout_overflow);
+	unsigned int level = 0;
+	unsigned int cur = 0;
+	uint64_t bm = 0;
+
+	for (level = 0; level < CALLOUT_LEVELS; level++) {
+		bm = callout_bitmap[level];
+		if (!bm)
+			continue;
+		/* Rotate so that bit 0 is the slot of callout_clk */
+		cur = level_slot(level, callout_clk);
+		if (cur)
+			bm = (bm >> cur) | (bm << (CALLOUT_SLOTS - cur));
+		cur = (cur + __builtin_ctzll(bm)) & (CALLOUT_SLOTS - 1);
+		min = MIN(min, min_expiry(callout_wheel +
+					  level * CALLOUT_SLOTS + cur));
+	}
+
+	return min;
+}
+
+static void program_timeout(uint64_t expiry)
 {
 	const struct callout_timer_desc *desc = callout_desc;
-	struct callout *co = TAILQ_FIRST(&callout_head);
 
-	if (co)
-		desc->set_next_timeout(desc, co->expiry_value);
+	if (expiry != UINT64_MAX)
+		desc->set_next_timeout(desc, expiry);
 	else
 		desc->disable_timeout(desc);
+	callout_next_expiry = expiry;
 
 	if (desc->is_per_cpu) {
 		/*
@@ -53,26 +206,29 @@ static void schedule_next_timeout(void)
 	}
 }
 
-static bool callout_is_active(struct callout *co)
+static void schedule_next_timeout(void)
 {
-	struct callout *co2 = NULL;
-
-	TAILQ_FOREACH(co2, &callout_head, link)
-		if (co2 == co)
-			return true;
+	program_timeout(next_expiry());
+}
 
-	return false;
+static bool callout_is_active(struct callout *co)
+{
+	return co->slot != CALLOUT_INACTIVE;
 }
 
 void callout_rem(struct callout *co)
 {
 	uint32_t state = 0;
+	bool pending = false;
 
 	state = cpu_spin_lock_xsave(&callout_lock);
 
 	if (callout_is_active(co)) {
-		TAILQ_REMOVE(&callout_head, co, link);
-		schedule_next_timeout();
+		pending = (co->slot == CALLOUT_PENDING);
+		remove_callout(co);
+		/* Only the earliest callout affects the timer */
+		if (!pending && co->expiry_value <= callout_next_expiry)
+			schedule_next_timeout();
 	}
 
 	cpu_spin_unlock_xrestore(&callout_lock, state);
@@ -83,6 +239,7 @@ void callout_add(struct callout *co, bool (*callback)(struct callout *co),
 {
 	const struct callout_timer_desc *desc = callout_desc;
 	uint32_t state = 0;
+	uint64_t now = 0;
 
 	state = cpu_spin_lock_xsave(&callout_lock);
 
@@ -90,17 +247,22 @@ void callout_add(struct callout *co, bool (*callback)(struct callout *co),
 	*co = (struct callout){ .callback = callback, };
 
 	if (desc) {
+		now = desc->get_now(desc);
 		co->period = desc->ms_to_ticks(desc, ms);
-		co->expiry_value = desc->get_now(desc) + co->period;
+		co->expiry_value = now + co->period;
+		/* An empty wheel can be moved to the current time for free */
+		if (wheel_is_empty())
+			callout_clk = now >> callout_jiffy_shift;
+		insert_callout(co);
+		if (co->expiry_value < callout_next_expiry)
+			program_timeout(co->expiry_value);
 	} else {
 		/* This will be converted to ticks in callout_service_init(). */
 		co->period = ms;
+		LIST_INSERT_HEAD(&callout_pending, co, link);
+		co->slot = CALLOUT_PENDING;
 	}
 
-	insert_callout(co);
-	if (desc && co == TAILQ_FIRST(&callout_head))
-		schedule_next_timeout();
-
 	cpu_spin_unlock_xrestore(&callout_lock, state);
 }
 
@@ -111,8 +273,8 @@ void callout_set_next_timeout(struct callout *co, uint32_t ms)
 
 void callout_service_init(const struct callout_timer_desc *desc)
 {
-	struct callout_head tmp_head = TAILQ_HEAD_INITIALIZER(tmp_head);
 	struct callout *co = NULL;
+	uint64_t ticks = 0;
 	uint32_t state = 0;
 	uint64_t now = 0;
 
@@ -124,12 +286,15 @@ void callout_service_init(const struct callout_timer_desc *desc)
 	       is_unpaged(desc->ms_to_ticks) && is_unpaged(desc->get_now));
 
 	callout_desc = desc;
+	ticks = desc->ms_to_ticks(desc, 1);
+	if (ticks)
+		callout_jiffy_shift = 63 - __builtin_clzll(ticks);
 	now = desc->get_now(desc);
+	callout_clk = now >> callout_jiffy_shift;
 
-	TAILQ_CONCAT(&tmp_head, &callout_head, link);
-	while (!TAILQ_EMPTY(&tmp_head)) {
-		co = TAILQ_FIRST(&tmp_head);
-		TAILQ_REMOVE(&tmp_head, co, link);
+	while (!LIST_EMPTY(&callout_pending)) {
+		co = LIST_FIRST(&callout_pending);
+		LIST_REMOVE(co, link);
 
 		/*
 		 * Periods set before the timer descriptor are in
@@ -148,6 +313,7 @@ void callout_service_init(const struct callout_timer_desc *desc)
 void callout_service_cb(void)
 {
 	const struct callout_timer_desc *desc = callout_desc;
+	struct callout_head head = LIST_HEAD_INITIALIZER(head);
 	struct callout *co = NULL;
 	uint64_t now = 0;
 
@@ -173,16 +339,24 @@ void callout_service_cb(void)
 	cpu_spin_lock(&callout_lock);
 
 	now = desc->get_now(desc);
-	while (!TAILQ_EMPTY(&callout_head)) {
-		co = TAILQ_FIRST(&callout_head);
-		if (co->expiry_value > now)
-			break;
+	collect_callouts(now >> callout_jiffy_shift, &head);
+	while (!LIST_EMPTY(&head)) {
+		co = LIST_FIRST(&head);
+		LIST_REMOVE(co, link);
+		co->slot = CALLOUT_INACTIVE;
 
-		TAILQ_REMOVE(&callout_head, co, link);
+		if (co->expiry_value > now) {
+			insert_callout(co);
+			continue;
+		}
 
 		if (co->callback(co)) {
 			co->expiry_value += co->period;
-			insert_callout(co);
+			/* A late periodic callout may be due again already */
+			if (co->expiry_value <= now)
+				LIST_INSERT_HEAD(&head, co, link);
+			else
+				insert_callout(co);
 		}
 	}
 	schedule_next_timeout();
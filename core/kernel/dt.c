@@ -13,6 +13,7 @@
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 
@@ -473,18 +474,33 @@ struct cached_node {
 	uint32_t phandle;
 };
 
+/*
+ * struct cached_phandle - Phandle index entry
+ *
+ * @phandle: Phandle of the node
+ * @node_offset: Offset of the node in @cached_node_info_fdt
+ */
+struct cached_phandle {
+	uint32_t phandle;
+	int node_offset;
+};
+
 /*
  * struct dt_node_cache - Reference to cached information of DT nodes
  *
- * @array: Array of the cached node
+ * @array: Array of the cached node, sorted by node offset
  * @count: Number of initialized cells in @array
  * @alloced_count: Number of allocated cells in @array
+ * @phandles: Nodes with a phandle, sorted by phandle
+ * @phandle_count: Number of cells in @phandles
  * @fdt: Reference to the FDT for which node information are cached
  */
 struct dt_node_cache {
 	struct cached_node *array;
 	size_t count;
 	size_t alloced_count;
+	struct cached_phandle *phandles;
+	size_t phandle_count;
 	const void *fdt;
 };
 
@@ -498,17 +514,28 @@ static bool fdt_node_info_are_cached(const void *fdt)
 static struct cached_node *find_cached_parent_node(const void *fdt,
 						   int node_offset)
 {
-	struct cached_node *cell = NULL;
+	struct cached_node *array = NULL;
+	size_t hi = 0;
+	size_t lo = 0;
 	size_t n = 0;
 
 	if (!fdt_node_info_are_cached(fdt))
 		return NULL;
 
-	for (n = 0; n < dt_node_cache->count; n++)
-		if (dt_node_cache->array[n].node_offset == node_offset)
-			cell = dt_node_cache->array + n;
+	/* Nodes are cached in the order of the FDT, so by offset */
+	array = dt_node_cache->array;
+	hi = dt_node_cache->count;
+	while (lo < hi) {
+		n = lo + (hi - lo) / 2;
+		if (array[n].node_offset == node_offset)
+			return array + n;
+		if (array[n].node_offset < node_offset)
+			lo = n + 1;
+		else
+			hi = n;
+	}
 
-	return cell;
+	return NULL;
 }
 
 int fdt_find_cached_parent_node(const void *fdt, int node_offset,
@@ -555,22 +582,75 @@ int fdt_find_cached_parent_reg_cells(const void *fdt, int node_offset,
 int fdt_find_cached_node_phandle(const void *fdt, uint32_t phandle,
 				 int *node_offset)
 {
-	struct cached_node *cell = NULL;
+	struct cached_phandle *array = NULL;
+	size_t hi = 0;
+	size_t lo = 0;
 	size_t n = 0;
 
-	if (!fdt_node_info_are_cached(fdt))
+	if (!fdt_node_info_are_cached(fdt) || !dt_node_cache->phandles)
 		return -FDT_ERR_NOTFOUND;
 
+	array = dt_node_cache->phandles;
+	hi = dt_node_cache->phandle_count;
+	while (lo < hi) {
+		n = lo + (hi - lo) / 2;
+		if (array[n].phandle == phandle) {
+			*node_offset = array[n].node_offset;
+			return 0;
+		}
+		if (array[n].phandle < phandle)
+			lo = n + 1;
+		else
+			hi = n;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static int cmp_cached_phandle(const void *a, const void *b)
+{
+	const struct cached_phandle *pa = a;
+	const struct cached_phandle *pb = b;
+
+	return CMP_TRILEAN(pa->phandle, pb->phandle);
+}
+
+/*
+ * Builds the phandle index. It's only an accelerator: when it can't be
+ * allocated, lookups by phandle fall back to libfdt.
+ */
+static void init_phandle_index(void)
+{
+	struct cached_phandle *phandles = NULL;
+	uint32_t phandle = 0;
+	size_t count = 0;
+	size_t n = 0;
+
 	for (n = 0; n < dt_node_cache->count; n++)
-		if (dt_node_cache->array[n].phandle == phandle)
-			cell = dt_node_cache->array + n;
+		if (dt_node_cache->array[n].phandle)
+			count++;
+	if (!count)
+		return;
 
-	if (!cell)
-		return -FDT_ERR_NOTFOUND;
+	phandles = calloc(count, sizeof(*phandles));
+	if (!phandles)
+		return;
 
-	*node_offset = cell->node_offset;
+	count = 0;
+	for (n = 0; n < dt_node_cache->count; n++) {
+		phandle = dt_node_cache->array[n].phandle;
+		if (!phandle)
+			continue;
+		phandles[count] = (struct cached_phandle){
+			.phandle = phandle,
+			.node_offset = dt_node_cache->array[n].node_offset,
+		};
+		count++;
+	}
+	qsort(phandles, count, sizeof(*phandles), cmp_cached_phandle);
 
-	return 0;
+	dt_node_cache->phandles = phandles;
+	dt_node_cache->phandle_count = count;
 }
 
 static TEE_Result realloc_cached_node_array(void)
@@ -600,8 +680,13 @@ static TEE_Result add_cached_node(int parent_offset,
 				  int node_offset, int address_cells,
 				  int size_cells)
 {
+	uint32_t phandle = fdt_get_phandle(dt_node_cache->fdt, node_offset);
 	TEE_Result res = TEE_ERROR_GENERIC;
 
+	/* fdt_get_phandle() returns (uint32_t)-1 for a malformed phandle */
+	if (phandle == (uint32_t)-1)
+		phandle = 0;
+
 	res = realloc_cached_node_array();
 	if (res)
 		return res;
@@ -611,7 +696,7 @@ static TEE_Result add_cached_node(int parent_offset,
 		.parent_offset = parent_offset,
 		.address_cells = address_cells,
 		.size_cells = size_cells,
-		.phandle = fdt_get_phandle(dt_node_cache->fdt, node_offset),
+		.phandle = phandle,
 	};
 
 	dt_node_cache->count++;
@@ -654,6 +739,7 @@ static TEE_Result add_cached_node_subtree(int node_offset)
 static TEE_Result release_node_cache_info(void)
 {
 	if (dt_node_cache) {
+		free(dt_node_cache->phandles);
 		free(dt_node_cache->array);
 		free(dt_node_cache);
 		dt_node_cache = NULL;
@@ -674,6 +760,8 @@ static void init_node_cache_info(const void *fdt)
 	if (dt_node_cache) {
 		dt_node_cache->fdt = fdt;
 		res = add_cached_node_subtree(0);
+		if (!res)
+			init_phandle_index();
 	} else {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 	}
@@ -14,9 +14,13 @@
 #include <kernel/dt_driver.h>
 #include <libfdt.h>
 #include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
+#include <util.h>
 
 /*
  * struct dt_driver_probe - Node instance in secure FDT to probe a driver for
@@ -60,6 +64,19 @@ struct dt_driver_provider {
 	SLIST_ENTRY(dt_driver_provider) link;
 };
 
+/*
+ * struct dt_compat_entry - Entry of the compatible string index
+ *
+ * @compat: Compatible string of @dm
+ * @dt_drv: Driver matching @compat
+ * @dm: Entry of @dt_drv match table for @compat
+ */
+struct dt_compat_entry {
+	const char *compat;
+	const struct dt_driver *dt_drv;
+	const struct dt_device_match *dm;
+};
+
 /*
  * Device driver providers are able to provide a driver specific instance
  * related to device phandle arguments found in the secure embedded FDT.
@@ -79,6 +96,14 @@ static TAILQ_HEAD(, dt_driver_probe) dt_driver_ready_list =
 static TAILQ_HEAD(, dt_driver_probe) dt_driver_failed_list =
 	TAILQ_HEAD_INITIALIZER(dt_driver_failed_list);
 
+/*
+ * Match table entries of all drivers sorted by compatible string then in
+ * drivers order, used while the FDT is parsed instead of scanning all
+ * match tables for each compatible string of each node.
+ */
+static struct dt_compat_entry *dt_compat_index;
+static size_t dt_compat_count;
+
 /* Flag enabled when a new node (possibly typed) is added in the probe list */
 static bool added_node;
 
@@ -600,6 +625,364 @@ TEE_Result dt_driver_probe_device_by_node(const void *fdt, int nodeoffset,
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
+/*
+ * struct probe_dep - Provider/consumer dependency between probe elements
+ *
+ * @provider: Index of the provider element in struct probe_graph::elts
+ * @consumer: Index of the consumer element in struct probe_graph::elts
+ */
+struct probe_dep {
+	size_t provider;
+	size_t consumer;
+};
+
+/*
+ * struct probe_node - Node offset index entry
+ *
+ * @nodeoffset: Node offset of the element
+ * @idx: Index of the element in struct probe_graph::elts
+ */
+struct probe_node {
+	int nodeoffset;
+	size_t idx;
+};
+
+/*
+ * struct probe_graph - Dependency graph of the probe list elements
+ *
+ * @fdt: FDT the elements refer to
+ * @elts: Elements of the probe list, in probe order
+ * @nodes: Index of @elts sorted by node offset
+ * @count: Number of cells in @elts and @nodes
+ * @deps: Dependencies found between elements of @elts
+ * @dep_count: Number of initialized cells in @deps
+ * @alloced_dep_count: Number of allocated cells in @deps
+ */
+struct probe_graph {
+	const void *fdt;
+	struct dt_driver_probe **elts;
+	struct probe_node *nodes;
+	size_t count;
+	struct probe_dep *deps;
+	size_t dep_count;
+	size_t alloced_dep_count;
+};
+
+static int cmp_probe_node(const void *a, const void *b)
+{
+	const struct probe_node *na = a;
+	const struct probe_node *nb = b;
+
+	return CMP_TRILEAN(na->nodeoffset, nb->nodeoffset);
+}
+
+static TEE_Result add_probe_dep(struct probe_graph *g, size_t provider,
+				size_t consumer)
+{
+	struct probe_dep *deps = NULL;
+	size_t count = 0;
+
+	if (g->dep_count == g->alloced_dep_count) {
+		count = MAX(g->alloced_dep_count * 2, (size_t)16);
+		deps = realloc(g->deps, count * sizeof(*deps));
+		if (!deps)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		g->deps = deps;
+		g->alloced_dep_count = count;
+	}
+
+	g->deps[g->dep_count].provider = provider;
+	g->deps[g->dep_count].consumer = consumer;
+	g->dep_count++;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Make element @consumer depend on the elements probing node @node. When
+ * @walk_up is true and there are none, the parents of @node are tried:
+ * pin configurations for instance are subnodes of their controller.
+ */
+static TEE_Result add_node_deps(struct probe_graph *g, size_t consumer,
+				int node, bool walk_up)
+{
+	int consumer_node = g->elts[consumer]->nodeoffset;
+	TEE_Result res = TEE_SUCCESS;
+	bool found = false;
+	size_t hi = 0;
+	size_t lo = 0;
+	size_t n = 0;
+
+	while (node >= 0 && node != consumer_node) {
+		lo = 0;
+		hi = g->count;
+		while (lo < hi) {
+			n = lo + (hi - lo) / 2;
+			if (g->nodes[n].nodeoffset < node)
+				lo = n + 1;
+			else
+				hi = n;
+		}
+
+		for (n = lo; n < g->count && g->nodes[n].nodeoffset == node;
+		     n++) {
+			res = add_probe_dep(g, g->nodes[n].idx, consumer);
+			if (res)
+				return res;
+			found = true;
+		}
+
+		if (found || !walk_up)
+			break;
+		node = fdt_parent_offset(g->fdt, node);
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Add the dependencies of element @consumer on the providers referenced in
+ * property @prop_name, a list of phandles each followed by the argument
+ * cells defined by the provider for @type.
+ */
+static TEE_Result add_phandle_deps(struct probe_graph *g, size_t consumer,
+				   const char *prop_name,
+				   enum dt_driver_type type)
+{
+	int node = g->elts[consumer]->nodeoffset;
+	TEE_Result res = TEE_SUCCESS;
+	const fdt32_t *prop = NULL;
+	uint32_t phandle = 0;
+	int provider = 0;
+	int cells = 0;
+	int len = 0;
+	int n = 0;
+
+	prop = fdt_getprop(g->fdt, node, prop_name, &len);
+	if (!prop)
+		return TEE_SUCCESS;
+	len /= sizeof(*prop);
+
+	while (n < len) {
+		phandle = fdt32_to_cpu(prop[n]);
+		n++;
+		if (!phandle)
+			continue;
+
+		provider = fdt_node_offset_by_phandle(g->fdt, phandle);
+		if (provider < 0)
+			break;
+
+		res = add_node_deps(g, consumer, provider,
+				    dt_driver_use_parent_controller(type));
+		if (res)
+			return res;
+
+		if (type == DT_DRIVER_NOTYPE)
+			continue;
+		cells = fdt_get_dt_driver_cells(g->fdt, provider, type);
+		if (cells < 0)
+			break;
+		n += cells;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result add_supply_deps(struct probe_graph *g, size_t consumer)
+{
+	int node = g->elts[consumer]->nodeoffset;
+	const char *suffix = "-supply";
+	TEE_Result res = TEE_SUCCESS;
+	const char *name = NULL;
+	size_t name_len = 0;
+	int prop = 0;
+
+	fdt_for_each_property_offset(prop, g->fdt, node) {
+		if (!fdt_getprop_by_offset(g->fdt, prop, &name, NULL))
+			continue;
+		name_len = strlen(name);
+		if (name_len <= strlen(suffix) ||
+		    strcmp(name + name_len - strlen(suffix), suffix))
+			continue;
+
+		res = add_phandle_deps(g, consumer, name, DT_DRIVER_NOTYPE);
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result add_interrupt_deps(struct probe_graph *g, size_t consumer)
+{
+	int node = g->elts[consumer]->nodeoffset;
+	const fdt32_t *prop = NULL;
+	int provider = 0;
+
+	if (!fdt_getprop(g->fdt, node, "interrupts", NULL))
+		return add_phandle_deps(g, consumer, "interrupts-extended",
+					DT_DRIVER_INTERRUPT);
+
+	/* "interrupt-parent" is inherited from the parent nodes */
+	while (node >= 0) {
+		prop = fdt_getprop(g->fdt, node, "interrupt-parent", NULL);
+		if (prop)
+			break;
+		node = fdt_parent_offset(g->fdt, node);
+	}
+	if (!prop)
+		return TEE_SUCCESS;
+
+	provider = fdt_node_offset_by_phandle(g->fdt, fdt32_to_cpu(*prop));
+	if (provider < 0)
+		return TEE_SUCCESS;
+
+	return add_node_deps(g, consumer, provider, false);
+}
+
+static TEE_Result add_element_deps(struct probe_graph *g, size_t consumer)
+{
+	TEE_Result res = TEE_SUCCESS;
+	char name[16] = { };
+	unsigned int n = 0;
+
+	res = add_phandle_deps(g, consumer, "clocks", DT_DRIVER_CLK);
+	if (!res)
+		res = add_phandle_deps(g, consumer, "resets",
+				       DT_DRIVER_RSTCTRL);
+	if (!res)
+		res = add_interrupt_deps(g, consumer);
+	if (!res)
+		res = add_supply_deps(g, consumer);
+
+	for (n = 0; !res; n++) {
+		snprintf(name, sizeof(name), "pinctrl-%u", n);
+		if (!fdt_getprop(g->fdt, g->elts[consumer]->nodeoffset, name,
+				 NULL))
+			break;
+		res = add_phandle_deps(g, consumer, name, DT_DRIVER_PINCTRL);
+	}
+
+	return res;
+}
+
+/*
+ * Sort @order, the indexes of the elements of @g, so that providers come
+ * before their consumers, otherwise keeping the probe order. Elements in a
+ * dependency cycle are left last, deferral resolves them if it can.
+ */
+static TEE_Result sort_probe_graph(struct probe_graph *g, size_t *order)
+{
+	size_t *first_dep = NULL;
+	size_t *indegree = NULL;
+	struct probe_dep *deps = NULL;
+	size_t head = 0;
+	size_t tail = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	first_dep = calloc(g->count + 1, sizeof(*first_dep));
+	indegree = calloc(g->count, sizeof(*indegree));
+	deps = calloc(g->dep_count, sizeof(*deps));
+	if (!first_dep || !indegree || (g->dep_count && !deps)) {
+		free(first_dep);
+		free(indegree);
+		free(deps);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* Group the dependencies by provider */
+	for (n = 0; n < g->dep_count; n++) {
+		first_dep[g->deps[n].provider + 1]++;
+		indegree[g->deps[n].consumer]++;
+	}
+	for (n = 0; n < g->count; n++)
+		first_dep[n + 1] += first_dep[n];
+	for (n = 0; n < g->dep_count; n++)
+		deps[first_dep[g->deps[n].provider]++] = g->deps[n];
+	for (n = g->count; n > 0; n--)
+		first_dep[n] = first_dep[n - 1];
+	first_dep[0] = 0;
+
+	for (n = 0; n < g->count; n++)
+		if (!indegree[n])
+			order[tail++] = n;
+
+	while (head < tail) {
+		n = order[head++];
+		for (m = first_dep[n]; m < first_dep[n + 1]; m++)
+			if (!--indegree[deps[m].consumer])
+				order[tail++] = deps[m].consumer;
+	}
+
+	for (n = 0; n < g->count && tail < g->count; n++)
+		if (indegree[n])
+			order[tail++] = n;
+
+	free(first_dep);
+	free(indegree);
+	free(deps);
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Reorder the probe list so that the providers of clocks, resets,
+ * interrupts, regulators and pin configurations referenced in the FDT are
+ * probed before their consumers. This only saves deferral rounds: when it
+ * fails for lack of memory the probe list is left unchanged.
+ */
+static void order_probe_list(const void *fdt)
+{
+	struct dt_driver_probe *elt = NULL;
+	struct probe_graph g = { .fdt = fdt };
+	TEE_Result res = TEE_SUCCESS;
+	size_t *order = NULL;
+	size_t n = 0;
+
+	TAILQ_FOREACH(elt, &dt_driver_probe_list, link)
+		g.count++;
+	if (g.count < 2)
+		return;
+
+	g.elts = calloc(g.count, sizeof(*g.elts));
+	g.nodes = calloc(g.count, sizeof(*g.nodes));
+	order = calloc(g.count, sizeof(*order));
+	if (!g.elts || !g.nodes || !order)
+		goto out;
+
+	/* The probe list is processed from its tail */
+	TAILQ_FOREACH_REVERSE(elt, &dt_driver_probe_list, dt_driver_probe_head,
+			      link) {
+		g.elts[n] = elt;
+		g.nodes[n].nodeoffset = elt->nodeoffset;
+		g.nodes[n].idx = n;
+		n++;
+	}
+	qsort(g.nodes, g.count, sizeof(*g.nodes), cmp_probe_node);
+
+	for (n = 0; n < g.count && !res; n++)
+		res = add_element_deps(&g, n);
+	if (!res)
+		res = sort_probe_graph(&g, order);
+	if (res)
+		goto out;
+
+	FMSG("Probe list ordered on %zu dependencies", g.dep_count);
+
+	TAILQ_INIT(&dt_driver_probe_list);
+	for (n = 0; n < g.count; n++)
+		TAILQ_INSERT_HEAD(&dt_driver_probe_list, g.elts[order[n]],
+				  link);
+
+out:
+	free(order);
+	free(g.deps);
+	free(g.nodes);
+	free(g.elts);
+}
+
 static TEE_Result process_probe_list(const void *fdt)
 {
 	struct dt_driver_probe *elt = NULL;
@@ -630,6 +1013,8 @@ static TEE_Result process_probe_list(const void *fdt)
 		one_probed_ok = false;
 		added_node = false;
 
+		order_probe_list(fdt);
+
 		TAILQ_FOREACH_REVERSE_SAFE(elt, &dt_driver_probe_list,
 					   dt_driver_probe_head, link, prev) {
 			TAILQ_REMOVE(&dt_driver_probe_list, elt, link);
@@ -717,6 +1102,102 @@ static TEE_Result add_node_to_probe(const void *fdt, int node,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result add_probe_node_by_driver(const void *fdt, int node,
+					   const struct dt_driver *dt_drv,
+					   const struct dt_device_match *dm,
+					   uint32_t *found_types)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	assert(dt_drv->type < 32);
+
+	res = add_node_to_probe(fdt, node, dt_drv, dm);
+	if (res)
+		return res;
+
+	if (*found_types & BIT(dt_drv->type)) {
+		EMSG("Driver %s multi hit on type %u",
+		     dt_drv->name, dt_drv->type);
+		panic();
+	}
+	*found_types |= BIT(dt_drv->type);
+
+	return TEE_SUCCESS;
+}
+
+static int cmp_compat_entry(const void *a, const void *b)
+{
+	const struct dt_compat_entry *ea = a;
+	const struct dt_compat_entry *eb = b;
+	int rc = strcmp(ea->compat, eb->compat);
+
+	if (rc)
+		return rc;
+	rc = CMP_TRILEAN((vaddr_t)ea->dt_drv, (vaddr_t)eb->dt_drv);
+	if (rc)
+		return rc;
+	return CMP_TRILEAN((vaddr_t)ea->dm, (vaddr_t)eb->dm);
+}
+
+/*
+ * The index is only an accelerator, add_probe_node_by_compat() scans the
+ * match tables when it couldn't be allocated.
+ */
+static void init_compat_index(void)
+{
+	const struct dt_driver *dt_drv = NULL;
+	const struct dt_device_match *dm = NULL;
+	struct dt_compat_entry *index = NULL;
+	size_t count = 0;
+
+	for_each_dt_driver(dt_drv)
+		for (dm = dt_drv->match_table; dm && dm->compatible; dm++)
+			count++;
+	if (!count)
+		return;
+
+	index = calloc(count, sizeof(*index));
+	if (!index)
+		return;
+
+	count = 0;
+	for_each_dt_driver(dt_drv) {
+		for (dm = dt_drv->match_table; dm && dm->compatible; dm++) {
+			index[count] = (struct dt_compat_entry){
+				.compat = dm->compatible,
+				.dt_drv = dt_drv,
+				.dm = dm,
+			};
+			count++;
+		}
+	}
+	qsort(index, count, sizeof(*index), cmp_compat_entry);
+
+	dt_compat_index = index;
+	dt_compat_count = count;
+}
+
+/* Return the first entry of @dt_compat_index for @compat or NULL */
+static struct dt_compat_entry *find_compat_entry(const char *compat)
+{
+	size_t hi = dt_compat_count;
+	size_t lo = 0;
+	size_t n = 0;
+
+	while (lo < hi) {
+		n = lo + (hi - lo) / 2;
+		if (strcmp(dt_compat_index[n].compat, compat) < 0)
+			lo = n + 1;
+		else
+			hi = n;
+	}
+
+	if (lo < dt_compat_count && !strcmp(dt_compat_index[lo].compat, compat))
+		return dt_compat_index + lo;
+
+	return NULL;
+}
+
 /*
  * Add a node to the probe list if a dt_driver matches target compatible.
  *
@@ -733,24 +1214,40 @@ static TEE_Result add_probe_node_by_compat(const void *fdt, int node,
 	TEE_Result res = TEE_ERROR_ITEM_NOT_FOUND;
 	const struct dt_driver *dt_drv = NULL;
 	const struct dt_device_match *dm = NULL;
+	struct dt_compat_entry *entry = NULL;
+	struct dt_compat_entry *end = NULL;
 	uint32_t found_types = 0;
 
+	if (dt_compat_index) {
+		entry = find_compat_entry(compat);
+		if (!entry)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+
+		end = dt_compat_index + dt_compat_count;
+		for (; entry < end && !strcmp(entry->compat, compat); entry++) {
+			/* Only the first match of a driver is considered */
+			if (entry->dt_drv == dt_drv)
+				continue;
+			dt_drv = entry->dt_drv;
+
+			res = add_probe_node_by_driver(fdt, node, dt_drv,
+						       entry->dm, &found_types);
+			if (res)
+				return res;
+		}
+
+		return res;
+	}
+
 	for_each_dt_driver(dt_drv) {
 		for (dm = dt_drv->match_table; dm && dm->compatible; dm++) {
 			if (strcmp(dm->compatible, compat) == 0) {
-				assert(dt_drv->type < 32);
-
-				res = add_node_to_probe(fdt, node, dt_drv, dm);
+				res = add_probe_node_by_driver(fdt, node,
+							       dt_drv, dm,
+							       &found_types);
 				if (res)
 					return res;
 
-				if (found_types & BIT(dt_drv->type)) {
-					EMSG("Driver %s multi hit on type %u",
-					     dt_drv->name, dt_drv->type);
-					panic();
-				}
-				found_types |= BIT(dt_drv->type);
-
 				/* Matching found for this driver, try next */
 				break;
 			}
@@ -833,6 +1330,7 @@ static TEE_Result probe_dt_drivers_early(void)
 	if (!fdt)
 		return TEE_SUCCESS;
 
+	init_compat_index();
 	parse_node(fdt, fdt_path_offset(fdt, "/"));
 
 	res = process_probe_list(fdt);
@@ -890,6 +1388,10 @@ static TEE_Result release_probe_lists(void)
 	SLIST_FOREACH_SAFE(prov, &dt_driver_provider_list, link, next_prov)
 	       free(prov);
 
+	free(dt_compat_index);
+	dt_compat_index = NULL;
+	dt_compat_count = 0;
+
 	return TEE_SUCCESS;
 }
 
@@ -11,17 +11,56 @@
 #include <kernel/user_ta.h>
 #include <stdio.h>
 #include <string.h>
+#include <tee/uuid.h>
 #include <trace.h>
 #include <utee_defines.h>
 #include <util.h>
 
+/*
+ * Set by early_ta_init() when the early TAs are sorted on their UUID as
+ * arranged by ts_bin_to_c.py, allowing a binary search.
+ */
+static bool early_tas_sorted;
+
+/* Compares in the order of the UUID string representation */
+static int early_ta_uuid_cmp(const TEE_UUID *a, const TEE_UUID *b)
+{
+	uint8_t oa[sizeof(TEE_UUID)] = { };
+	uint8_t ob[sizeof(TEE_UUID)] = { };
+
+	tee_uuid_to_octets(oa, a);
+	tee_uuid_to_octets(ob, b);
+
+	return memcmp(oa, ob, sizeof(oa));
+}
+
 static const struct embedded_ts *find_early_ta(const TEE_UUID *uuid)
 {
 	const struct embedded_ts *ta = NULL;
+	const struct embedded_ts *lo = NULL;
+	const struct embedded_ts *hi = NULL;
+	int cmp = 0;
+
+	if (!early_tas_sorted) {
+		for_each_early_ta(ta)
+			if (!memcmp(&ta->uuid, uuid, sizeof(*uuid)))
+				return ta;
+
+		return NULL;
+	}
 
-	for_each_early_ta(ta)
-		if (!memcmp(&ta->uuid, uuid, sizeof(*uuid)))
+	lo = SCATTERED_ARRAY_BEGIN(early_tas, struct embedded_ts);
+	hi = SCATTERED_ARRAY_END(early_tas, struct embedded_ts);
+	while (lo < hi) {
+		ta = lo + (hi - lo) / 2;
+		cmp = early_ta_uuid_cmp(uuid, &ta->uuid);
+		if (!cmp)
 			return ta;
+		if (cmp < 0)
+			hi = ta;
+		else
+			lo = ta + 1;
+	}
 
 	return NULL;
 }
@@ -43,10 +82,16 @@ REGISTER_TA_STORE(2) = {
 
 static TEE_Result early_ta_init(void)
 {
+	const struct embedded_ts *prev = NULL;
 	const struct embedded_ts *ta = NULL;
 	char __maybe_unused msg[60] = { '\0', };
 
+	early_tas_sorted = true;
 	for_each_early_ta(ta) {
+		if (prev && early_ta_uuid_cmp(&prev->uuid, &ta->uuid) >= 0)
+			early_tas_sorted = false;
+		prev = ta;
+
 		if (ta->uncompressed_size)
 			snprintf(msg, sizeof(msg),
 				 " (compressed, uncompressed %u)",
@@ -8,6 +8,7 @@
 #include <kernel/embedded_ts.h>
 #include <kernel/ts_store.h>
 #include <kernel/user_access.h>
+#include <limits.h>
 #include <mempool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -146,20 +147,34 @@ static TEE_Result read_compressed(struct ts_store_handle *h, void *data_core,
 	z_stream *strm = &h->strm;
 	size_t total = 0;
 	uint8_t *bb = NULL;
+	uint8_t *dst = NULL;
+	size_t dst_len = 0;
 	size_t bb_len = 0;
 	size_t out = 0;
 	int st = Z_OK;
 
-	/* Inflate into a 1kB bounce buffer */
-	bb_len = MIN(len, 1024U);
-	bb = bb_alloc(bb_len);
-	if (!bb) {
-		EMSG("Out of memory");
-		return TEE_ERROR_OUT_OF_MEMORY;
+	if (data_core) {
+		/*
+		 * Inflate straight into the destination. A large output
+		 * buffer keeps inflate() in its fast loop instead of
+		 * returning and updating its window every 1kB.
+		 */
+		dst = data_core;
+		dst_len = MIN(len, (size_t)UINT_MAX);
+	} else {
+		/* Inflate into a 1kB bounce buffer */
+		bb_len = MIN(len, 1024U);
+		bb = bb_alloc(bb_len);
+		if (!bb) {
+			EMSG("Out of memory");
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+		dst = bb;
+		dst_len = bb_len;
 	}
 
-	strm->avail_out = bb_len;
-	strm->next_out = bb;
+	strm->avail_out = dst_len;
+	strm->next_out = dst;
 
 	/*
 	 * Loop until we get as many bytes as requested, or an error occurs.
@@ -176,21 +191,23 @@ static TEE_Result read_compressed(struct ts_store_handle *h, void *data_core,
 		st = inflate(strm, Z_SYNC_FLUSH);
 		out = strm->total_out - out;
 		FMSG("%zu bytes", out);
-		if (data_core)
-			memcpy((uint8_t *)data_core + total, bb, out);
 		if (data_user) {
-			res = copy_to_user((uint8_t *)data_user + total, bb,
-					   out);
+			res = copy_to_user((uint8_t *)data_user + total,
+					   strm->next_out - out, out);
 			if (res)
 				goto out;
 		}
 		total += out;
-		/*
-		 * Reset the pointer since we've just copied out the last
-		 * data.
-		 */
-		strm->next_out = bb;
-		strm->avail_out = MIN(len - total, bb_len);
+		if (bb) {
+			/*
+			 * Reset the pointer since we've just copied out the
+			 * last data.
+			 */
+			strm->next_out = bb;
+			strm->avail_out = MIN(len - total, bb_len);
+		} else if (!strm->avail_out) {
+			strm->avail_out = MIN(len - total, (size_t)UINT_MAX);
+		}
 	} while ((st == Z_OK || st == Z_BUF_ERROR) && (total != len));
 
 	if (st != Z_OK && st != Z_STREAM_END) {
@@ -200,7 +217,8 @@ static TEE_Result read_compressed(struct ts_store_handle *h, void *data_core,
 	}
 	res = TEE_SUCCESS;
 out:
-	bb_free(bb, bb_len);
+	if (bb)
+		bb_free(bb, bb_len);
 
 	return res;
 }
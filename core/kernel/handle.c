@@ -3,9 +3,10 @@
  * Copyright (c) 2014, Linaro Limited
  * Copyright (c) 2020, Arm Limited
  */
+#include <kernel/handle.h>
 #include <stdlib.h>
 #include <string.h>
-#include <kernel/handle.h>
+#include <util.h>
 
 /*
  * Define the initial capacity of the database. It should be a low number
@@ -15,6 +16,40 @@
  */
 #define HANDLE_DB_INITIAL_MAX_PTRS	4
 
+/*
+ * A handle is a positive int with the slot index in the low bits and the
+ * generation of the slot in the bits above.
+ */
+#define HANDLE_IDX_BITS			20
+#define HANDLE_IDX_MASK			(BIT32(HANDLE_IDX_BITS) - 1)
+#define HANDLE_GEN_MASK			(BIT32(31 - HANDLE_IDX_BITS) - 1)
+#define HANDLE_DB_MAX_PTRS		BIT32(HANDLE_IDX_BITS)
+
+static int idx_to_handle(struct handle_db *db, size_t idx)
+{
+	return (db->slots[idx].gen << HANDLE_IDX_BITS) | idx;
+}
+
+static struct handle_db_slot *handle_to_slot(struct handle_db *db,
+					     int handle)
+{
+	struct handle_db_slot *slot = NULL;
+	size_t idx = 0;
+
+	if (!db || handle < 0)
+		return NULL;
+
+	idx = handle & HANDLE_IDX_MASK;
+	if (idx >= db->max_ptrs)
+		return NULL;
+
+	slot = db->slots + idx;
+	if (!slot->ptr || slot->gen != ((uint32_t)handle >> HANDLE_IDX_BITS))
+		return NULL;
+
+	return slot;
+}
+
 void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 {
 	if (db) {
@@ -22,79 +57,95 @@ void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 			size_t n = 0;
 
 			for (n = 0; n < db->max_ptrs; n++)
-				if (db->ptrs[n])
-					ptr_destructor(db->ptrs[n]);
+				if (db->slots[n].ptr)
+					ptr_destructor(db->slots[n].ptr);
 		}
-		free(db->ptrs);
-		db->ptrs = NULL;
+		free(db->slots);
+		db->slots = NULL;
 		db->max_ptrs = 0;
+		db->num_ptrs = 0;
+		db->first_free = 0;
 	}
 }
 
 bool handle_db_is_empty(struct handle_db *db)
 {
+	return !db || !db->num_ptrs;
+}
+
+static bool grow_db(struct handle_db *db)
+{
+	size_t new_max_ptrs = 0;
 	size_t n = 0;
+	void *p = NULL;
+
+	if (db->max_ptrs)
+		new_max_ptrs = db->max_ptrs * 2;
+	else
+		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+	new_max_ptrs = MIN(new_max_ptrs, (size_t)HANDLE_DB_MAX_PTRS);
+	if (new_max_ptrs == db->max_ptrs)
+		return false;
+
+	p = realloc(db->slots, new_max_ptrs * sizeof(*db->slots));
+	if (!p)
+		return false;
+	db->slots = p;
+	memset(db->slots + db->max_ptrs, 0,
+	       (new_max_ptrs - db->max_ptrs) * sizeof(*db->slots));
+
+	/* Link the new slots in order, the free list is empty */
+	for (n = db->max_ptrs; n < new_max_ptrs - 1; n++)
+		db->slots[n].next_free = n + 2;
+	db->first_free = db->max_ptrs + 1;
+	db->max_ptrs = new_max_ptrs;
 
-	if (db) {
-		for (n = 0; n < db->max_ptrs; n++) {
-			if (db->ptrs[n])
-				return false;
-		}
-	}
 	return true;
 }
 
 int handle_get(struct handle_db *db, void *ptr)
 {
-	size_t n;
-	void *p;
-	size_t new_max_ptrs;
+	size_t idx = 0;
 
 	if (!db || !ptr)
 		return -1;
 
-	/* Try to find an empty location */
-	for (n = 0; n < db->max_ptrs; n++) {
-		if (!db->ptrs[n]) {
-			db->ptrs[n] = ptr;
-			return n;
-		}
-	}
-
-	/* No location available, grow the ptrs array */
-	if (db->max_ptrs)
-		new_max_ptrs = db->max_ptrs * 2;
-	else
-		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
-	p = realloc(db->ptrs, new_max_ptrs * sizeof(void *));
-	if (!p)
+	if (!db->first_free && !grow_db(db))
 		return -1;
-	db->ptrs = p;
-	memset(db->ptrs + db->max_ptrs, 0,
-	       (new_max_ptrs - db->max_ptrs) * sizeof(void *));
-	db->max_ptrs = new_max_ptrs;
 
-	/* Since n stopped at db->max_ptrs there is an empty location there */
-	db->ptrs[n] = ptr;
-	return n;
+	idx = db->first_free - 1;
+	db->first_free = db->slots[idx].next_free;
+	db->slots[idx].next_free = 0;
+	db->slots[idx].ptr = ptr;
+	db->num_ptrs++;
+
+	return idx_to_handle(db, idx);
 }
 
 void *handle_put(struct handle_db *db, int handle)
 {
-	void *p;
+	struct handle_db_slot *slot = handle_to_slot(db, handle);
+	void *p = NULL;
 
-	if (!db || handle < 0 || (size_t)handle >= db->max_ptrs)
+	if (!slot)
 		return NULL;
 
-	p = db->ptrs[handle];
-	db->ptrs[handle] = NULL;
+	p = slot->ptr;
+	slot->ptr = NULL;
+	slot->gen = (slot->gen + 1) & HANDLE_GEN_MASK;
+	slot->next_free = db->first_free;
+	db->first_free = slot - db->slots + 1;
+	db->num_ptrs--;
+
 	return p;
 }
 
 void *handle_lookup(struct handle_db *db, int handle)
 {
-	if (!db || handle < 0 || (size_t)handle >= db->max_ptrs)
+	struct handle_db_slot *slot = handle_to_slot(db, handle);
+
+	if (!slot)
 		return NULL;
 
-	return db->ptrs[handle];
+	return slot->ptr;
 }
@@ -5,11 +5,50 @@
 
 #include <config.h>
 #include <crypto/crypto.h>
+#include <initcall.h>
+#include <keep.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/mutex.h>
+#include <kernel/pm.h>
 #include <kernel/tee_common_otp.h>
+#include <string.h>
 #include <string_ext.h>
 #include <tee/tee_fs_key_manager.h>
 
+/* Subkeys with more constant data than this aren't cached */
+#define HUK_SUBKEY_CACHE_DATA_LEN	64
+#define HUK_SUBKEY_CACHE_ENTRIES	8
+
+/*
+ * struct huk_subkey_cache_entry - a derived subkey
+ * @usage:		Usage the subkey was derived for
+ * @const_data:		Constant data the subkey was derived with
+ * @const_data_len:	Length of @const_data
+ * @subkey:		Subkey of maximum length, shorter subkeys are a
+ *			prefix of it as the HMAC is just truncated
+ * @valid:		True if the entry is in use
+ */
+struct huk_subkey_cache_entry {
+	enum huk_subkey_usage usage;
+	uint8_t const_data[HUK_SUBKEY_CACHE_DATA_LEN];
+	size_t const_data_len;
+	uint8_t subkey[HUK_SUBKEY_MAX_LEN];
+	bool valid;
+};
+
+/*
+ * With CFG_CORE_HUK_SUBKEY_CACHE the HUK and the last derived subkeys are
+ * kept in secure memory to avoid reading OTPs and computing HMACs again.
+ * Everything is wiped on suspend.
+ */
+static struct {
+	struct tee_hw_unique_key huk;
+	bool huk_valid;
+	struct huk_subkey_cache_entry entries[HUK_SUBKEY_CACHE_ENTRIES];
+	unsigned int next;
+} huk_cache;
+static struct mutex huk_cache_mu = MUTEX_INITIALIZER;
+
 static TEE_Result mac_usage(void *ctx, uint32_t usage)
 {
 	return crypto_mac_update(ctx, (const void *)&usage, sizeof(usage));
@@ -58,24 +97,37 @@ static TEE_Result huk_compat(void *ctx, enum huk_subkey_usage usage)
 }
 #endif /*CFG_CORE_HUK_SUBKEY_COMPAT*/
 
-TEE_Result __huk_subkey_derive(enum huk_subkey_usage usage,
-			       const void *const_data, size_t const_data_len,
-			       uint8_t *subkey, size_t subkey_len)
+static TEE_Result get_huk(struct tee_hw_unique_key *huk)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!IS_ENABLED(CFG_CORE_HUK_SUBKEY_CACHE))
+		return tee_otp_get_hw_unique_key(huk);
+
+	if (!huk_cache.huk_valid) {
+		res = tee_otp_get_hw_unique_key(&huk_cache.huk);
+		if (res)
+			return res;
+		huk_cache.huk_valid = true;
+	}
+	*huk = huk_cache.huk;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result derive(enum huk_subkey_usage usage,
+			 const void *const_data, size_t const_data_len,
+			 uint8_t *subkey, size_t subkey_len)
 {
 	void *ctx = NULL;
 	struct tee_hw_unique_key huk = { };
 	TEE_Result res = TEE_SUCCESS;
 
-	if (subkey_len > HUK_SUBKEY_MAX_LEN)
-		return TEE_ERROR_BAD_PARAMETERS;
-	if (!const_data && const_data_len)
-		return TEE_ERROR_BAD_PARAMETERS;
-
 	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
 	if (res)
 		return res;
 
-	res = tee_otp_get_hw_unique_key(&huk);
+	res = get_huk(&huk);
 	if (res)
 		goto out;
 
@@ -106,7 +158,95 @@ out:
 	return res;
 }
 
+static struct huk_subkey_cache_entry *
+cache_lookup(enum huk_subkey_usage usage, const void *const_data,
+	     size_t const_data_len)
+{
+	struct huk_subkey_cache_entry *e = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(huk_cache.entries); n++) {
+		e = huk_cache.entries + n;
+		if (e->valid && e->usage == usage &&
+		    e->const_data_len == const_data_len &&
+		    !memcmp(e->const_data, const_data, const_data_len))
+			return e;
+	}
+
+	return NULL;
+}
+
+static TEE_Result derive_cached(enum huk_subkey_usage usage,
+				const void *const_data, size_t const_data_len,
+				uint8_t *subkey, size_t subkey_len)
+{
+	struct huk_subkey_cache_entry *e = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&huk_cache_mu);
+
+	e = cache_lookup(usage, const_data, const_data_len);
+	if (!e) {
+		e = huk_cache.entries + huk_cache.next;
+		e->valid = false;
+		res = derive(usage, const_data, const_data_len, e->subkey,
+			     sizeof(e->subkey));
+		if (res)
+			goto out;
+
+		e->usage = usage;
+		memcpy(e->const_data, const_data, const_data_len);
+		e->const_data_len = const_data_len;
+		e->valid = true;
+		huk_cache.next = (huk_cache.next + 1) %
+				 ARRAY_SIZE(huk_cache.entries);
+	}
+	memcpy(subkey, e->subkey, subkey_len);
+out:
+	mutex_unlock(&huk_cache_mu);
+
+	return res;
+}
+
+TEE_Result __huk_subkey_derive(enum huk_subkey_usage usage,
+			       const void *const_data, size_t const_data_len,
+			       uint8_t *subkey, size_t subkey_len)
+{
+	if (subkey_len > HUK_SUBKEY_MAX_LEN)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!const_data && const_data_len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (IS_ENABLED(CFG_CORE_HUK_SUBKEY_CACHE) &&
+	    const_data_len <= HUK_SUBKEY_CACHE_DATA_LEN)
+		return derive_cached(usage, const_data, const_data_len,
+				     subkey, subkey_len);
+
+	return derive(usage, const_data, const_data_len, subkey, subkey_len);
+}
+
 TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 			     const void *const_data, size_t const_data_len,
 			     uint8_t *subkey, size_t subkey_len)
 __weak __alias("__huk_subkey_derive");
+
+#ifdef CFG_CORE_HUK_SUBKEY_CACHE
+static TEE_Result huk_cache_pm(enum pm_op op, uint32_t pm_hint __unused,
+			       const struct pm_callback_handle *h __unused)
+{
+	/* Nothing else runs while the core suspends, no locking needed */
+	if (op == PM_OP_SUSPEND)
+		memzero_explicit(&huk_cache, sizeof(huk_cache));
+
+	return TEE_SUCCESS;
+}
+DECLARE_KEEP_PAGER(huk_cache_pm);
+
+static TEE_Result huk_cache_init(void)
+{
+	register_pm_core_service_cb(huk_cache_pm, NULL, "huk_subkey_cache");
+
+	return TEE_SUCCESS;
+}
+service_init(huk_cache_init);
+#endif
@@ -5,19 +5,123 @@
  */
 
 #include <initcall.h>
-#include <trace.h>
+#include <kernel/delay.h>
 #include <kernel/linker.h>
+#include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <pta_stats.h>
+#include <string.h>
+#include <string_ext.h>
+#include <trace.h>
+#include <util.h>
+
+#ifdef CFG_CORE_INITCALL_STATS
+struct initcall_stat {
+	const struct initcall *call;
+	uint64_t ticks;
+	TEE_Result ret;
+	uint8_t stage;
+};
+
+/*
+ * Init-calls are done in the nexus and, with virtualization, in each
+ * partition so the records are kept in the nexus.
+ */
+static struct initcall_stat initcall_stats[CFG_CORE_INITCALL_STATS_ENTRIES]
+	__nex_bss;
+static size_t initcall_stats_count __nex_bss;
+static unsigned int initcall_stats_lock __nex_bss = SPINLOCK_UNLOCK;
+
+static void record_init_call(unsigned int stage, const struct initcall *call,
+			     uint64_t ticks, TEE_Result ret)
+{
+	uint32_t exceptions = 0;
+
+	DMSG("initcall %s(): %"PRIu64" us%s", call->func_name,
+	     ticks * 1000000 / delay_cnt_freq(), ret ? " (failed)" : "");
+
+	exceptions = cpu_spin_lock_xsave(&initcall_stats_lock);
+	if (initcall_stats_count < ARRAY_SIZE(initcall_stats)) {
+		initcall_stats[initcall_stats_count] = (struct initcall_stat){
+			.call = call,
+			.ticks = ticks,
+			.ret = ret,
+			.stage = stage,
+		};
+		initcall_stats_count++;
+	}
+	cpu_spin_unlock_xrestore(&initcall_stats_lock, exceptions);
+}
+
+TEE_Result initcall_stats_get(void *buf, size_t *buf_size)
+{
+	struct pta_stats_initcall *stats = buf;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&initcall_stats_lock);
+
+	sz = initcall_stats_count * sizeof(*stats);
+	if (!buf || *buf_size < sz) {
+		res = TEE_ERROR_SHORT_BUFFER;
+	} else {
+		memset(buf, 0, sz);
+		for (n = 0; n < initcall_stats_count; n++) {
+			stats[n].duration_us = initcall_stats[n].ticks *
+					       1000000 / delay_cnt_freq();
+			stats[n].stage = initcall_stats[n].stage;
+			stats[n].level = initcall_stats[n].call->level;
+			stats[n].result = initcall_stats[n].ret;
+			strlcpy(stats[n].name, initcall_stats[n].call->func_name,
+				sizeof(stats[n].name));
+		}
+	}
+	*buf_size = sz;
+
+	cpu_spin_unlock_xrestore(&initcall_stats_lock, exceptions);
+
+	return res;
+}
+
+static uint64_t init_call_start(void)
+{
+	return delay_cnt_read();
+}
+
+static void init_call_end(unsigned int stage, const struct initcall *call,
+			  uint64_t start, TEE_Result ret)
+{
+	record_init_call(stage, call, delay_cnt_read() - start, ret);
+}
+#else
+static uint64_t init_call_start(void)
+{
+	return 0;
+}
+
+static void init_call_end(unsigned int stage __unused,
+			  const struct initcall *call __unused,
+			  uint64_t start __unused, TEE_Result ret __unused)
+{
+}
+#endif
 
 static void do_init_calls(const char *type __maybe_unused,
+			  unsigned int stage,
 			  const struct initcall *begin,
 			  const struct initcall *end)
 {
 	const struct initcall *call = NULL;
 	TEE_Result ret = TEE_SUCCESS;
+	uint64_t start = 0;
 
 	for (call = begin; call < end; call++) {
 		DMSG("%s level %d %s()", type, call->level, call->func_name);
+		start = init_call_start();
 		ret = call->func();
+		init_call_end(stage, call, start, ret);
 		if (ret) {
 			EMSG("%s __text_start + 0x%08"PRIxVA" failed",
 			     type, (vaddr_t)call - VCORE_START_VA);
@@ -25,8 +129,8 @@ static void do_init_calls(const char *type __maybe_unused,
 	}
 }
 
-#define DO_INIT_CALLS(name) \
-	do_init_calls(#name, name##_begin, name##_end)
+#define DO_INIT_CALLS(name, stage) \
+	do_init_calls(#name, (stage), name##_begin, name##_end)
 
 /*
  * Note: this function is weak just to make it possible to exclude it from
@@ -34,7 +138,7 @@ static void do_init_calls(const char *type __maybe_unused,
  */
 void __weak call_preinitcalls(void)
 {
-	DO_INIT_CALLS(preinitcall);
+	DO_INIT_CALLS(preinitcall, STATS_INITCALL_STAGE_PREINIT);
 }
 
 /*
@@ -43,7 +147,7 @@ void __weak call_preinitcalls(void)
  */
 void __weak call_early_initcalls(void)
 {
-	DO_INIT_CALLS(early_initcall);
+	DO_INIT_CALLS(early_initcall, STATS_INITCALL_STAGE_EARLY);
 }
 
 /*
@@ -52,7 +156,7 @@ void __weak call_early_initcalls(void)
  */
 void __weak call_service_initcalls(void)
 {
-	DO_INIT_CALLS(service_initcall);
+	DO_INIT_CALLS(service_initcall, STATS_INITCALL_STAGE_SERVICE);
 }
 
 /*
@@ -61,7 +165,7 @@ void __weak call_service_initcalls(void)
  */
 void __weak call_driver_initcalls(void)
 {
-	DO_INIT_CALLS(driver_initcall);
+	DO_INIT_CALLS(driver_initcall, STATS_INITCALL_STAGE_DRIVER);
 }
 
 /*
@@ -81,5 +185,24 @@ void __weak call_initcalls(void)
  */
 void __weak call_finalcalls(void)
 {
-	DO_INIT_CALLS(finalcall);
+	DO_INIT_CALLS(finalcall, STATS_INITCALL_STAGE_FINAL);
+}
+
+#ifdef CFG_CORE_DEFERRED_INITCALLS
+static struct mutex deferred_mu = MUTEX_INITIALIZER;
+static bool deferred_done;
+
+void call_deferred_initcalls(void)
+{
+	/* Pairs with the release store below */
+	if (__atomic_load_n(&deferred_done, __ATOMIC_ACQUIRE))
+		return;
+
+	mutex_lock(&deferred_mu);
+	if (!deferred_done) {
+		DO_INIT_CALLS(deferredcall, STATS_INITCALL_STAGE_DEFERRED);
+		__atomic_store_n(&deferred_done, true, __ATOMIC_RELEASE);
+	}
+	mutex_unlock(&deferred_mu);
 }
+#endif
@@ -5,7 +5,9 @@
 
 #include <kernel/dt.h>
 #include <kernel/interrupt.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
+#include <kernel/thread.h>
 #include <libfdt.h>
 #include <mm/core_memprot.h>
 #include <stdlib.h>
@@ -22,12 +24,24 @@
 
 static struct itr_chip *itr_main_chip __nex_bss;
 
+static_assert(IS_POWER_OF_TWO(ITR_HANDLER_BUCKETS));
+
+/* List of the handlers of @chip which may be registered for @itr_num */
+static struct itr_handler_head *itr_handlers(struct itr_chip *chip,
+					     size_t itr_num)
+{
+	return chip->handlers + (itr_num & (ITR_HANDLER_BUCKETS - 1));
+}
+
 TEE_Result itr_chip_init(struct itr_chip *chip)
 {
+	size_t n = 0;
+
 	if (!itr_chip_is_valid(chip))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	SLIST_INIT(&chip->handlers);
+	for (n = 0; n < ARRAY_SIZE(chip->handlers); n++)
+		SLIST_INIT(chip->handlers + n);
 
 	return TEE_SUCCESS;
 }
@@ -51,6 +65,22 @@ struct itr_chip *interrupt_get_main_chip_may_fail(void)
 	return itr_main_chip;
 }
 
+void interrupt_route_to_this_cpu(struct itr_chip *chip, size_t itr_num)
+{
+	uint32_t exceptions = 0;
+	size_t pos = 0;
+
+	if (!interrupt_can_set_affinity(chip))
+		return;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	pos = get_core_pos();
+	/* The CPU mask of the controller API is limited to 8 cores */
+	if (pos < 8)
+		interrupt_set_affinity(chip, itr_num, BIT(pos));
+	thread_unmask_exceptions(exceptions);
+}
+
 #ifdef CFG_DT
 int dt_get_irq_type_prio(const void *fdt, int node, uint32_t *type,
 			 uint32_t *prio)
@@ -87,7 +117,7 @@ void interrupt_call_handlers(struct itr_chip *chip, size_t itr_num)
 
 	assert(chip);
 
-	SLIST_FOREACH(h, &chip->handlers, link) {
+	SLIST_FOREACH(h, itr_handlers(chip, itr_num), link) {
 		if (h->it == itr_num) {
 			if (h->handler(h) == ITRR_HANDLED)
 				was_handled = true;
@@ -119,7 +149,7 @@ static TEE_Result add_configure_handler(struct itr_handler *hdl,
 	assert(hdl && hdl->chip->ops && is_unpaged(hdl) &&
 	       hdl->handler && is_unpaged(hdl->handler));
 
-	SLIST_FOREACH(h, &hdl->chip->handlers, link) {
+	SLIST_FOREACH(h, itr_handlers(hdl->chip, hdl->it), link) {
 		if (h->it == hdl->it &&
 		    (!(hdl->flags & ITRF_SHARED) ||
 		     !(h->flags & ITRF_SHARED))) {
@@ -132,7 +162,7 @@ static TEE_Result add_configure_handler(struct itr_handler *hdl,
 	if (configure)
 		interrupt_configure(hdl->chip, hdl->it, type, prio);
 
-	SLIST_INSERT_HEAD(&hdl->chip->handlers, hdl, link);
+	SLIST_INSERT_HEAD(itr_handlers(hdl->chip, hdl->it), hdl, link);
 
 	return TEE_SUCCESS;
 }
@@ -183,7 +213,7 @@ void interrupt_remove_handler(struct itr_handler *hdl)
 	if (!hdl)
 		return;
 
-	SLIST_FOREACH(h, &hdl->chip->handlers, link)
+	SLIST_FOREACH(h, itr_handlers(hdl->chip, hdl->it), link)
 		if (h == hdl)
 			break;
 	if (!h) {
@@ -193,7 +223,7 @@ void interrupt_remove_handler(struct itr_handler *hdl)
 	}
 
 	if (hdl->flags & ITRF_SHARED) {
-		SLIST_FOREACH(h, &hdl->chip->handlers, link) {
+		SLIST_FOREACH(h, itr_handlers(hdl->chip, hdl->it), link) {
 			if (h != hdl && h->it == hdl->it) {
 				disable_itr = false;
 				break;
@@ -204,7 +234,7 @@ void interrupt_remove_handler(struct itr_handler *hdl)
 	if (disable_itr)
 		interrupt_disable(hdl->chip, hdl->it);
 
-	SLIST_REMOVE(&hdl->chip->handlers, hdl, itr_handler, link);
+	SLIST_REMOVE(itr_handlers(hdl->chip, hdl->it), hdl, itr_handler, link);
 }
 
 TEE_Result interrupt_alloc_add_conf_handler(struct itr_chip *chip,
@@ -165,6 +165,15 @@ TEE_Result ldelf_init_with_ldelf(struct ts_session *sess,
 		if (arg_bbuf->flags & ~TA_FLAGS_MASK)
 			return TEE_ERROR_BAD_FORMAT;
 
+		/*
+		 * A user TA has a single stack and libutee keeps global
+		 * state, concurrent entry would corrupt both.
+		 */
+		if (arg_bbuf->flags & TA_FLAG_CONCURRENT) {
+			EMSG("TA_FLAG_CONCURRENT is for pseudo TAs only");
+			return TEE_ERROR_BAD_FORMAT;
+		}
+
 		to_user_ta_ctx(uctx->ts_ctx)->ta_ctx.flags = arg_bbuf->flags;
 	}
 
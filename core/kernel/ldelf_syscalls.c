@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <kernel/ldelf_syscalls.h>
+#include <kernel/spinlock.h>
 #include <kernel/user_access.h>
 #include <kernel/user_mode_ctx.h>
 #include <ldelf.h>
@@ -27,6 +28,114 @@ struct bin_handle {
 	size_t size_bytes;
 };
 
+/*
+ * Number of TAs for which the TA store they were last loaded from is
+ * remembered, see open_ta_bin().
+ */
+#define TA_STORE_CACHE_SIZE	8
+
+struct ta_store_cache_entry {
+	TEE_UUID uuid;
+	const struct ts_store_ops *op;
+};
+
+static struct ta_store_cache_entry ta_store_cache[TA_STORE_CACHE_SIZE];
+static unsigned int ta_store_cache_next;
+static unsigned int ta_store_cache_lock = SPINLOCK_UNLOCK;
+
+static const struct ts_store_ops *ta_store_cache_get(const TEE_UUID *uuid)
+{
+	const struct ts_store_ops *op = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&ta_store_cache_lock);
+	for (n = 0; n < ARRAY_SIZE(ta_store_cache); n++) {
+		if (ta_store_cache[n].op &&
+		    !memcmp(&ta_store_cache[n].uuid, uuid, sizeof(*uuid))) {
+			op = ta_store_cache[n].op;
+			break;
+		}
+	}
+	cpu_spin_unlock_xrestore(&ta_store_cache_lock, exceptions);
+
+	return op;
+}
+
+static void ta_store_cache_put(const TEE_UUID *uuid,
+			       const struct ts_store_ops *op)
+{
+	struct ta_store_cache_entry *e = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&ta_store_cache_lock);
+	for (n = 0; n < ARRAY_SIZE(ta_store_cache); n++) {
+		if (ta_store_cache[n].op &&
+		    !memcmp(&ta_store_cache[n].uuid, uuid, sizeof(*uuid))) {
+			e = ta_store_cache + n;
+			break;
+		}
+	}
+	if (!e) {
+		e = ta_store_cache + ta_store_cache_next;
+		ta_store_cache_next = (ta_store_cache_next + 1) %
+				      ARRAY_SIZE(ta_store_cache);
+	}
+	e->uuid = *uuid;
+	e->op = op;
+	cpu_spin_unlock_xrestore(&ta_store_cache_lock, exceptions);
+}
+
+void ts_store_flush_ta_cache(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&ta_store_cache_lock);
+
+	memset(ta_store_cache, 0, sizeof(ta_store_cache));
+	cpu_spin_unlock_xrestore(&ta_store_cache_lock, exceptions);
+}
+
+/*
+ * The TA store the TA was last loaded from is tried first. The stores
+ * are otherwise tried in order of priority until the TA is found.
+ *
+ * A store with higher priority than the remembered one didn't hold the
+ * TA when it was loaded. Early TAs are fixed and installing a TA in
+ * secure storage flushes the cache, so the remembered store is still the
+ * one a full lookup would pick. If the TA can't be opened from the
+ * remembered store anymore the full lookup is done.
+ */
+static TEE_Result open_ta_bin(const TEE_UUID *uuid, struct bin_handle *binh)
+{
+	TEE_Result res = TEE_ERROR_ITEM_NOT_FOUND;
+
+	binh->op = ta_store_cache_get(uuid);
+	if (binh->op) {
+		DMSG("Lookup user TA ELF %pUl (%s, cached)",
+		     (void *)uuid, binh->op->description);
+		res = binh->op->open(uuid, &binh->h);
+		DMSG("res=%#"PRIx32, res);
+		if (!res)
+			return TEE_SUCCESS;
+	}
+
+	SCATTERED_ARRAY_FOREACH(binh->op, ta_stores, struct ts_store_ops) {
+		DMSG("Lookup user TA ELF %pUl (%s)",
+		     (void *)uuid, binh->op->description);
+
+		res = binh->op->open(uuid, &binh->h);
+		DMSG("res=%#"PRIx32, res);
+		if (res != TEE_ERROR_ITEM_NOT_FOUND &&
+		    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+			break;
+	}
+
+	if (!res)
+		ta_store_cache_put(uuid, binh->op);
+
+	return res;
+}
+
 static void unmap_or_panic(struct user_mode_ctx *uctx, vaddr_t va,
 			   size_t byte_count)
 {
@@ -158,17 +267,7 @@ TEE_Result ldelf_syscall_open_bin(const TEE_UUID *uuid, size_t uuid_size,
 		return TEE_ERROR_OUT_OF_MEMORY;
 
 	if (is_user_ta_ctx(sess->ctx) || is_stmm_ctx(sess->ctx)) {
-		SCATTERED_ARRAY_FOREACH(binh->op, ta_stores,
-					struct ts_store_ops) {
-			DMSG("Lookup user TA ELF %pUl (%s)",
-			     (void *)bb_uuid, binh->op->description);
-
-			res = binh->op->open(bb_uuid, &binh->h);
-			DMSG("res=%#"PRIx32, res);
-			if (res != TEE_ERROR_ITEM_NOT_FOUND &&
-			    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
-				break;
-		}
+		res = open_ta_bin(bb_uuid, binh);
 	} else if (is_sp_ctx(sess->ctx)) {
 		SCATTERED_ARRAY_FOREACH(binh->op, sp_stores,
 					struct ts_store_ops) {
@@ -234,6 +333,13 @@ TEE_Result ldelf_syscall_close_bin(unsigned long handle)
 		res = binh->op->read(binh->h, NULL, NULL,
 				     binh->size_bytes - binh->offs_bytes);
 
+	/*
+	 * The whole binary has been read and thus verified, keep the
+	 * shareable slices around for the next context loading it.
+	 */
+	if (!res)
+		file_keep(binh->f);
+
 	bin_close(binh);
 	if (handle_db_is_empty(&sys_ctx->db)) {
 		handle_db_destroy(&sys_ctx->db, bin_close);
@@ -397,6 +503,10 @@ TEE_Result ldelf_syscall_map_bin(vaddr_t *va, size_t num_bytes,
 		struct file *file = NULL;
 		uint32_t vm_flags = 0;
 
+		if (!f) {
+			file_release_kept();
+			f = fobj_ta_mem_alloc(num_pages);
+		}
 		if (!f) {
 			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto err;
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/delay.h>
+#include <kernel/lock_stats.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <pta_stats.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * Lock contention statistics, one entry per contended lock. Entries are
+ * assigned in the order locks are first found contended and never
+ * released, waits on locks which don't fit in the table are only
+ * accounted in @lock_stats_dropped.
+ *
+ * The table is protected by a raw spinlock which is taken with
+ * __cpu_spin_lock() to not account itself.
+ */
+struct lock_stats_entry {
+	vaddr_t lock;
+	enum lock_stats_type type;
+	uint64_t wait_count;
+	uint64_t wait_cycles;
+	uint64_t max_wait_cycles;
+};
+
+static struct lock_stats_entry
+	lock_stats[CFG_LOCK_CONTENTION_STATS_ENTRIES] __nex_bss;
+static size_t lock_stats_count __nex_bss;
+static uint64_t lock_stats_dropped __nex_bss;
+static unsigned int lock_stats_lock __nex_bss = SPINLOCK_UNLOCK;
+
+uint64_t lock_stats_wait_begin(void)
+{
+	return delay_cnt_read();
+}
+
+static struct lock_stats_entry *find_entry(vaddr_t lock,
+					   enum lock_stats_type type)
+{
+	size_t n = 0;
+
+	for (n = 0; n < lock_stats_count; n++)
+		if (lock_stats[n].lock == lock && lock_stats[n].type == type)
+			return lock_stats + n;
+
+	if (lock_stats_count == ARRAY_SIZE(lock_stats))
+		return NULL;
+
+	lock_stats[n].lock = lock;
+	lock_stats[n].type = type;
+	lock_stats_count++;
+
+	return lock_stats + n;
+}
+
+void lock_stats_wait_end(const void *lock, enum lock_stats_type type,
+			 uint64_t begin)
+{
+	uint64_t cycles = delay_cnt_read() - begin;
+	struct lock_stats_entry *e = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	__cpu_spin_lock(&lock_stats_lock);
+
+	e = find_entry((vaddr_t)lock, type);
+	if (e) {
+		e->wait_count++;
+		e->wait_cycles += cycles;
+		e->max_wait_cycles = MAX(e->max_wait_cycles, cycles);
+	} else {
+		lock_stats_dropped++;
+	}
+
+	__cpu_spin_unlock(&lock_stats_lock);
+	thread_unmask_exceptions(exceptions);
+}
+
+TEE_Result lock_stats_get(void *buf, size_t *buf_size)
+{
+	struct pta_stats_lock *stats = buf;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (!buf_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	__cpu_spin_lock(&lock_stats_lock);
+
+	/* The last entry reports the waits which could not be assigned */
+	sz = sizeof(*stats) * (lock_stats_count + 1);
+	if (!lock_stats_count) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+	} else if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		res = TEE_ERROR_SHORT_BUFFER;
+	} else if (!IS_ALIGNED_WITH_TYPE(buf, uint64_t)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+	} else {
+		for (n = 0; n < lock_stats_count; n++) {
+			stats[n] = (struct pta_stats_lock){
+				.lock_va = lock_stats[n].lock,
+				.type = lock_stats[n].type,
+				.wait_count = lock_stats[n].wait_count,
+				.wait_cycles = lock_stats[n].wait_cycles,
+				.max_wait_cycles =
+					lock_stats[n].max_wait_cycles,
+			};
+		}
+		stats[n] = (struct pta_stats_lock){
+			.type = STATS_LOCK_TYPE_DROPPED,
+			.wait_count = lock_stats_dropped,
+		};
+		*buf_size = sz;
+	}
+
+	__cpu_spin_unlock(&lock_stats_lock);
+	thread_unmask_exceptions(exceptions);
+
+	return res;
+}
@@ -13,11 +13,26 @@
 #include <util.h>
 
 /* lockdep_node::flags values */
-/* Flags used for depth-first topological sorting */
-#define LOCKDEP_NODE_TEMP_MARK		BIT(0)
-#define LOCKDEP_NODE_PERM_MARK		BIT(1)
 /* Flag used during breadth-first search (print shortest cycle) */
-#define LOCKDEP_NODE_BFS_VISITED	BIT(2)
+#define LOCKDEP_NODE_BFS_VISITED	BIT(0)
+
+static size_t lockdep_hash(uintptr_t key)
+{
+	/* Fibonacci hashing, the low bits of lock addresses are alike */
+	return (uint32_t)(key * 0x9e3779b1U) >> (32 - LOCKDEP_HASH_BITS);
+}
+
+static struct lockdep_node *lockdep_find_node(struct lockdep_node_head *graph,
+					      uintptr_t lock_id)
+{
+	struct lockdep_node *node = NULL;
+
+	LIST_FOREACH(node, &graph->node_hash[lockdep_hash(lock_id)], hash_link)
+		if (node->lock_id == lock_id)
+			return node;
+
+	return NULL;
+}
 
 /* Find node in graph or add it */
 static struct lockdep_node *lockdep_add_to_graph(
@@ -27,21 +42,45 @@ static struct lockdep_node *lockdep_add_to_graph(
 	struct lockdep_node *node = NULL;
 
 	assert(graph);
-	TAILQ_FOREACH(node, graph, link)
-		if (node->lock_id == lock_id)
-			return node;
+	node = lockdep_find_node(graph, lock_id);
+	if (node)
+		return node;
 
 	node = calloc(1, sizeof(*node));
 	if (!node)
 		return NULL;
 
 	node->lock_id = lock_id;
-	STAILQ_INIT(&node->edges);
-	TAILQ_INSERT_TAIL(graph, node, link);
+	LIST_INIT(&node->edges);
+	LIST_INIT(&node->in_edges);
+	TAILQ_INSERT_TAIL(&graph->nodes, node, link);
+	LIST_INSERT_HEAD(&graph->node_hash[lockdep_hash(lock_id)], node,
+			 hash_link);
 
 	return node;
 }
 
+static struct lockdep_edge_head *
+lockdep_edge_bucket(struct lockdep_node_head *graph, struct lockdep_node *from,
+		    struct lockdep_node *to)
+{
+	return graph->edge_hash + lockdep_hash((uintptr_t)from * 31 +
+					       (uintptr_t)to);
+}
+
+static struct lockdep_edge *lockdep_get_edge(struct lockdep_node_head *graph,
+					     struct lockdep_node *from,
+					     struct lockdep_node *to)
+{
+	struct lockdep_edge *edge = NULL;
+
+	LIST_FOREACH(edge, lockdep_edge_bucket(graph, from, to), hash_link)
+		if (edge->from == from && edge->to == to)
+			return edge;
+
+	return NULL;
+}
+
 static vaddr_t *dup_call_stack(vaddr_t *stack)
 {
 	vaddr_t *nstack = NULL;
@@ -74,26 +113,35 @@ static void lockdep_print_call_stack(vaddr_t *stack)
 		EMSG_RAW(" %#" PRIxPTR, *p);
 }
 
-static TEE_Result lockdep_add_edge(struct lockdep_node *from,
+/*
+ * Add the edge @from -> @to if it isn't in @graph yet. @added is set if the
+ * edge is new, an edge already present has been checked when it was added.
+ */
+static TEE_Result lockdep_add_edge(struct lockdep_node_head *graph,
+				   struct lockdep_node *from,
 				   struct lockdep_node *to,
 				   vaddr_t *call_stack_from,
 				   vaddr_t *call_stack_to,
-				   uintptr_t thread_id)
+				   uintptr_t thread_id, bool *added)
 {
 	struct lockdep_edge *edge = NULL;
 
-	STAILQ_FOREACH(edge, &from->edges, link)
-		if (edge->to == to)
-			return TEE_SUCCESS;
+	*added = false;
+	if (lockdep_get_edge(graph, from, to))
+		return TEE_SUCCESS;
 
 	edge = calloc(1, sizeof(*edge));
 	if (!edge)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	edge->from = from;
 	edge->to = to;
 	edge->call_stack_from = dup_call_stack(call_stack_from);
 	edge->call_stack_to = dup_call_stack(call_stack_to);
 	edge->thread_id = thread_id;
-	STAILQ_INSERT_TAIL(&from->edges, edge, link);
+	LIST_INSERT_HEAD(&from->edges, edge, link);
+	LIST_INSERT_HEAD(&to->in_edges, edge, in_link);
+	LIST_INSERT_HEAD(lockdep_edge_bucket(graph, from, to), edge, hash_link);
+	*added = true;
 
 	return TEE_SUCCESS;
 }
@@ -153,7 +201,7 @@ static uintptr_t *lockdep_graph_get_shortest_cycle(struct lockdep_node *node)
 		n = qe->node;
 		TAILQ_REMOVE(&queue, qe, link);
 
-		STAILQ_FOREACH(e, &n->edges, link) {
+		LIST_FOREACH(e, &n->edges, link) {
 			if (e->to->lock_id == node->lock_id) {
 				uintptr_t *tmp = NULL;
 				size_t nlen = qe->pathlen + 1;
@@ -208,45 +256,47 @@ out:
 	return ret;
 }
 
-static TEE_Result lockdep_visit(struct lockdep_node *node)
+/* Depth-first search of a path from @node to @target */
+static bool lockdep_visit(struct lockdep_node_head *graph,
+			  struct lockdep_node *node,
+			  struct lockdep_node *target)
 {
 	struct lockdep_edge *e = NULL;
 
-	if (node->flags & LOCKDEP_NODE_PERM_MARK)
-		return TEE_SUCCESS;
+	if (node == target)
+		return true;
 
-	if (node->flags & LOCKDEP_NODE_TEMP_MARK)
-		return TEE_ERROR_BAD_STATE;	/* Not a DAG! */
+	if (node->visit_gen == graph->visit_gen)
+		return false;
+	node->visit_gen = graph->visit_gen;
 
-	node->flags |= LOCKDEP_NODE_TEMP_MARK;
+	LIST_FOREACH(e, &node->edges, link)
+		if (lockdep_visit(graph, e->to, target))
+			return true;
 
-	STAILQ_FOREACH(e, &node->edges, link) {
-		TEE_Result res = lockdep_visit(e->to);
-
-		if (res)
-			return res;
-	}
-
-	node->flags |= LOCKDEP_NODE_PERM_MARK;
-	return TEE_SUCCESS;
+	return false;
 }
 
-static TEE_Result lockdep_graph_sort(struct lockdep_node_head *graph)
+/*
+ * The graph is acyclic before the edge @from -> @to is added, so there's
+ * a cycle only if @from can be reached from @to.
+ */
+static TEE_Result lockdep_check_edge(struct lockdep_node_head *graph,
+				     struct lockdep_node *from,
+				     struct lockdep_node *to)
 {
 	struct lockdep_node *node = NULL;
 
-	TAILQ_FOREACH(node, graph, link) {
-		if (!node->flags) {
-			/* Unmarked node */
-			TEE_Result res = lockdep_visit(node);
-
-			if (res)
-				return res;
-		}
+	graph->visit_gen++;
+	if (!graph->visit_gen) {
+		/* Wrapped, a stale mark could be taken as current */
+		TAILQ_FOREACH(node, &graph->nodes, link)
+			node->visit_gen = 0;
+		graph->visit_gen++;
 	}
 
-	TAILQ_FOREACH(node, graph, link)
-		node->flags = 0;
+	if (lockdep_visit(graph, to, from))
+		return TEE_ERROR_BAD_STATE;	/* Not a DAG! */
 
 	return TEE_SUCCESS;
 }
@@ -254,15 +304,12 @@ static TEE_Result lockdep_graph_sort(struct lockdep_node_head *graph)
 static struct lockdep_edge *lockdep_find_edge(struct lockdep_node_head *graph,
 					      uintptr_t from, uintptr_t to)
 {
-	struct lockdep_node *node = NULL;
-	struct lockdep_edge *edge = NULL;
+	struct lockdep_node *from_node = lockdep_find_node(graph, from);
+	struct lockdep_node *to_node = lockdep_find_node(graph, to);
 
-	TAILQ_FOREACH(node, graph, link)
-		if (node->lock_id == from)
-			STAILQ_FOREACH(edge, &node->edges, link)
-				if (edge->to->lock_id == to)
-					return edge;
-	return NULL;
+	if (!from_node || !to_node)
+		return NULL;
+	return lockdep_get_edge(graph, from_node, to_node);
 }
 
 static void lockdep_print_edge_info(uintptr_t from __maybe_unused,
@@ -331,6 +378,22 @@ static vaddr_t *lockdep_get_kernel_stack(void)
 	return NULL;
 }
 
+static TEE_Result lockdep_push(struct lockdep_lock_head *owned,
+			       struct lockdep_node *node, vaddr_t *acq_stack)
+{
+	if (owned->count == LOCKDEP_MAX_HELD) {
+		EMSG_RAW("Thread %p holds too many locks", (void *)owned);
+		free(acq_stack);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	owned->locks[owned->count].node = node;
+	owned->locks[owned->count].call_stack = acq_stack;
+	owned->count++;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result __lockdep_lock_acquire(struct lockdep_node_head *graph,
 				  struct lockdep_lock_head *owned,
 				  uintptr_t id)
@@ -339,36 +402,33 @@ TEE_Result __lockdep_lock_acquire(struct lockdep_node_head *graph,
 	struct lockdep_lock *lock = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	vaddr_t *acq_stack = NULL;
+	bool added = false;
+	size_t n = 0;
 
 	if (!node)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
 	acq_stack = lockdep_get_kernel_stack();
 
-	TAILQ_FOREACH(lock, owned, link) {
-		res = lockdep_add_edge(lock->node, node, lock->call_stack,
-				       acq_stack, (uintptr_t)owned);
-		if (res)
+	for (n = 0; n < owned->count; n++) {
+		lock = owned->locks + n;
+		res = lockdep_add_edge(graph, lock->node, node,
+				       lock->call_stack, acq_stack,
+				       (uintptr_t)owned, &added);
+		if (!res && added)
+			res = lockdep_check_edge(graph, lock->node, node);
+		if (res == TEE_ERROR_BAD_STATE) {
+			EMSG_RAW("Potential deadlock detected!");
+			EMSG_RAW("When trying to acquire lock %#" PRIxPTR, id);
+			lockdep_print_cycle_info(graph, node);
+		}
+		if (res) {
+			free(acq_stack);
 			return res;
+		}
 	}
 
-	res = lockdep_graph_sort(graph);
-	if (res) {
-		EMSG_RAW("Potential deadlock detected!");
-		EMSG_RAW("When trying to acquire lock %#" PRIxPTR, id);
-		lockdep_print_cycle_info(graph, node);
-		return res;
-	}
-
-	lock = calloc(1, sizeof(*lock));
-	if (!lock)
-		return TEE_ERROR_OUT_OF_MEMORY;
-
-	lock->node = node;
-	lock->call_stack = acq_stack;
-	TAILQ_INSERT_TAIL(owned, lock, link);
-
-	return TEE_SUCCESS;
+	return lockdep_push(owned, node, acq_stack);
 }
 
 /*
@@ -381,34 +441,24 @@ TEE_Result __lockdep_lock_tryacquire(struct lockdep_node_head *graph,
 				     uintptr_t id)
 {
 	struct lockdep_node *node = lockdep_add_to_graph(graph, id);
-	struct lockdep_lock *lock = NULL;
-	vaddr_t *acq_stack = NULL;
 
 	if (!node)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	acq_stack = lockdep_get_kernel_stack();
-
-	lock = calloc(1, sizeof(*lock));
-	if (!lock)
-		return TEE_ERROR_OUT_OF_MEMORY;
-
-	lock->node = node;
-	lock->call_stack = acq_stack;
-	TAILQ_INSERT_TAIL(owned, lock, link);
-
-	return TEE_SUCCESS;
+	return lockdep_push(owned, node, lockdep_get_kernel_stack());
 }
 
 TEE_Result __lockdep_lock_release(struct lockdep_lock_head *owned, uintptr_t id)
 {
-	struct lockdep_lock *lock = NULL;
-
-	TAILQ_FOREACH_REVERSE(lock, owned, lockdep_lock_head, link) {
-		if (lock->node->lock_id == id) {
-			TAILQ_REMOVE(owned, lock, link);
-			free(lock->call_stack);
-			free(lock);
+	size_t n = owned->count;
+
+	while (n) {
+		n--;
+		if (owned->locks[n].node->lock_id == id) {
+			free(owned->locks[n].call_stack);
+			owned->count--;
+			memmove(owned->locks + n, owned->locks + n + 1,
+				(owned->count - n) * sizeof(*owned->locks));
 			return TEE_SUCCESS;
 		}
 	}
@@ -429,7 +479,7 @@ static void lockdep_node_delete(struct lockdep_node *node)
 	struct lockdep_edge *edge = NULL;
 	struct lockdep_edge *next = NULL;
 
-	STAILQ_FOREACH_SAFE(edge, &node->edges, link, next)
+	LIST_FOREACH_SAFE(edge, &node->edges, link, next)
 		lockdep_free_edge(edge);
 
 	free(node);
@@ -440,21 +490,28 @@ void lockdep_graph_delete(struct lockdep_node_head *graph)
 	struct lockdep_node *node = NULL;
 	struct lockdep_node *next = NULL;
 
-	TAILQ_FOREACH_SAFE(node, graph, link, next) {
-		TAILQ_REMOVE(graph, node, link);
+	TAILQ_FOREACH_SAFE(node, &graph->nodes, link, next) {
+		TAILQ_REMOVE(&graph->nodes, node, link);
 		lockdep_node_delete(node);
 	}
+	lockdep_graph_init(graph);
 }
 
 void lockdep_queue_delete(struct lockdep_lock_head *owned)
 {
-	struct lockdep_lock *lock = NULL;
-	struct lockdep_lock *next = NULL;
+	size_t n = 0;
 
-	TAILQ_FOREACH_SAFE(lock, owned, link, next) {
-		TAILQ_REMOVE(owned, lock, link);
-		free(lock);
-	}
+	for (n = 0; n < owned->count; n++)
+		free(owned->locks[n].call_stack);
+	owned->count = 0;
+}
+
+static void lockdep_unlink_edge(struct lockdep_edge *edge)
+{
+	LIST_REMOVE(edge, link);
+	LIST_REMOVE(edge, in_link);
+	LIST_REMOVE(edge, hash_link);
+	lockdep_free_edge(edge);
 }
 
 static void lockdep_node_destroy(struct lockdep_node_head *graph,
@@ -462,39 +519,14 @@ static void lockdep_node_destroy(struct lockdep_node_head *graph,
 {
 	struct lockdep_edge *edge = NULL;
 	struct lockdep_edge *next = NULL;
-	struct lockdep_node *from = NULL;
-
-	TAILQ_REMOVE(graph, node, link);
-
-	/*
-	 * Loop over all nodes in the graph to remove all edges with the
-	 * node to remove in the "to" field.
-	 */
-	TAILQ_FOREACH(from, graph, link) {
-		edge = STAILQ_FIRST(&from->edges);
-		while (edge && edge->to == node) {
-			STAILQ_REMOVE_HEAD(&from->edges, link);
-			lockdep_free_edge(edge);
-			edge = STAILQ_FIRST(&from->edges);
-		}
-
-		if (!edge)
-			continue;
 
-		next = STAILQ_NEXT(edge, link);
-		while (next) {
-			if (next->to == node) {
-				STAILQ_REMOVE_AFTER(&from->edges, edge, link);
-				lockdep_free_edge(next);
-			} else {
-				edge = next;
-			}
-			next = STAILQ_NEXT(edge, link);
-		}
-	}
+	TAILQ_REMOVE(&graph->nodes, node, link);
+	LIST_REMOVE(node, hash_link);
 
-	STAILQ_FOREACH_SAFE(edge, &node->edges, link, next)
-		lockdep_free_edge(edge);
+	LIST_FOREACH_SAFE(edge, &node->in_edges, in_link, next)
+		lockdep_unlink_edge(edge);
+	LIST_FOREACH_SAFE(edge, &node->edges, link, next)
+		lockdep_unlink_edge(edge);
 
 	free(node);
 }
@@ -504,10 +536,7 @@ void lockdep_lock_destroy(struct lockdep_node_head *graph, uintptr_t lock_id)
 	struct lockdep_node *node = NULL;
 
 	assert(graph);
-	TAILQ_FOREACH(node, graph, link) {
-		if (node->lock_id == lock_id) {
-			lockdep_node_destroy(graph, node);
-			break;
-		}
-	}
+	node = lockdep_find_node(graph, lock_id);
+	if (node)
+		lockdep_node_destroy(graph, node);
 }
@@ -26,10 +26,12 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <io.h>
 #include <kernel/msg_param.h>
 #include <mm/mobj.h>
 #include <optee_msg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <types_ext.h>
 #include <util.h>
 
@@ -147,3 +149,123 @@ out:
 	free(pages);
 	return mobj;
 }
+
+/* Runs in each page of an OPTEE_MSG_ATTR_EXTENTS list */
+#define MSG_PARAM_EXTENTS_PER_PAGE \
+	((OPTEE_MSG_NONCONTIG_PAGE_SIZE / sizeof(uint64_t) - 2) / 2)
+
+/**
+ * msg_param_extract_extents() - extract list of runs from
+ * OPTEE_MSG_ATTR_EXTENTS buffer.
+ *
+ * @buffer:	physical address of the first page of the list
+ * @num_pages:	number of pages the runs must add up to
+ * @num_ext:	output number of runs in the returned array
+ *
+ * return:
+ *	malloced array of runs on success, NULL otherwise
+ *
+ * The layout of the list is described with OPTEE_MSG_ATTR_EXTENTS. Each
+ * value is read only once since @buffer is shared with normal world, the
+ * runs are checked against secure memory when the mobj is created.
+ */
+static struct mobj_shm_extent *msg_param_extract_extents(paddr_t buffer,
+							 size_t num_pages,
+							 size_t *num_ext)
+{
+	struct mobj_shm_extent *ext = NULL;
+	struct mobj_shm_extent *e = NULL;
+	struct mobj *mobj = NULL;
+	size_t max_ext = 0;
+	uint64_t *va = NULL;
+	paddr_t page = 0;
+	uint64_t pa = 0;
+	uint64_t n = 0;
+	size_t cnt = 0;
+	size_t idx = 0;
+
+	if (buffer & SMALL_PAGE_MASK)
+		return NULL;
+
+	mobj = mobj_mapped_shm_alloc(&buffer, 1, 0, 0);
+	if (!mobj)
+		return NULL;
+
+	va = mobj_get_va(mobj, 0, SMALL_PAGE_SIZE);
+	assert(va);
+
+	while (num_pages) {
+		if (idx == MSG_PARAM_EXTENTS_PER_PAGE) {
+			/* Last entry of the page holds the next page */
+			page = READ_ONCE(va[SMALL_PAGE_SIZE /
+					    sizeof(uint64_t) - 1]);
+			if (page & SMALL_PAGE_MASK)
+				goto err;
+
+			mobj_put(mobj);
+			mobj = mobj_mapped_shm_alloc(&page, 1, 0, 0);
+			if (!mobj)
+				goto err;
+
+			va = mobj_get_va(mobj, 0, SMALL_PAGE_SIZE);
+			assert(va);
+			idx = 0;
+		}
+
+		pa = READ_ONCE(va[idx * 2]);
+		n = READ_ONCE(va[idx * 2 + 1]);
+		idx++;
+		if (!n || n > num_pages || (paddr_t)pa != pa)
+			goto err;
+
+		if (cnt == max_ext) {
+			max_ext = MAX(max_ext * 2, 8U);
+			e = realloc(ext, max_ext * sizeof(*ext));
+			if (!e)
+				goto err;
+			ext = e;
+		}
+		ext[cnt].pa = pa;
+		ext[cnt].num_pages = n;
+		cnt++;
+		num_pages -= n;
+	}
+
+	mobj_put(mobj);
+	*num_ext = cnt;
+	return ext;
+err:
+	mobj_put(mobj);
+	free(ext);
+	return NULL;
+}
+
+struct mobj *msg_param_mobj_from_extents(paddr_t buf_ptr, size_t size,
+					 uint64_t shm_ref, bool map_buffer)
+{
+	struct mobj_shm_extent *ext = NULL;
+	struct mobj *mobj = NULL;
+	paddr_t page_offset = 0;
+	size_t num_pages = 0;
+	size_t size_plus_offs = 0;
+	size_t num_ext = 0;
+
+	page_offset = buf_ptr & SMALL_PAGE_MASK;
+	if (ADD_OVERFLOW(size, page_offset, &size_plus_offs))
+		return NULL;
+	num_pages = (size_plus_offs - 1) / SMALL_PAGE_SIZE + 1;
+
+	ext = msg_param_extract_extents(buf_ptr & ~SMALL_PAGE_MASK, num_pages,
+					&num_ext);
+	if (!ext)
+		return NULL;
+
+	if (map_buffer)
+		mobj = mobj_mapped_shm_alloc_extents(ext, num_ext, page_offset,
+						     shm_ref);
+	else
+		mobj = mobj_reg_shm_alloc_extents(ext, num_ext, page_offset,
+						  shm_ref);
+	free(ext);
+	return mobj;
+}
@@ -3,6 +3,12 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#if defined(ARM32) || defined(ARM64)
+#include <arm.h>
+#endif
+#include <atomic.h>
+#include <kernel/delay.h>
+#include <kernel/lock_stats.h>
 #include <kernel/mutex.h>
 #include <kernel/mutex_pm_aware.h>
 #include <kernel/panic.h>
@@ -23,8 +29,54 @@ void mutex_init_recursive(struct recursive_mutex *m)
 	*m = (struct recursive_mutex)RECURSIVE_MUTEX_INITIALIZER;
 }
 
+/*
+ * With CFG_CORE_MUTEX_SPIN_US > 0 a thread finding the mutex locked first
+ * polls it for up to CFG_CORE_MUTEX_SPIN_US microseconds before sleeping
+ * in normal world. While there are such spinners the unlocking thread
+ * leaves the mutex to them instead of waking a sleeping thread, this
+ * saves the RPCs needed to sleep and wake a thread when the mutex is held
+ * for short periods. A spinner always tries to take the mutex once done
+ * spinning so a sleeping thread is woken by the next unlock.
+ */
+static void mutex_spin_wait(struct mutex *m __maybe_unused,
+			    bool read __maybe_unused)
+{
+#if CFG_CORE_MUTEX_SPIN_US
+	uint64_t timeout = timeout_init_us(CFG_CORE_MUTEX_SPIN_US);
+	short state = 0;
+
+	while (!timeout_elapsed(timeout)) {
+		state = atomic_load_short(&m->state);
+		if (read ? state != -1 : !state)
+			return;
+#if defined(ARM32) || defined(ARM64)
+		/* Woken by the sev() in mutex_wake() or an interrupt */
+		wfe();
+#endif
+	}
+#endif
+}
+
+static void mutex_wake(struct mutex *m, bool have_spinners, const char *fname,
+		       int lineno)
+{
+	if (!have_spinners) {
+		wq_wake_next(&m->wq, m, fname, lineno);
+		return;
+	}
+
+#if defined(ARM32) || defined(ARM64)
+	dsb_ishst();
+	sev();
+#endif
+}
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool may_spin = CFG_CORE_MUTEX_SPIN_US;
+	uint64_t begin = 0;
+	bool waited = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -48,6 +100,17 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 		can_lock = !m->state;
+		if (!can_lock && may_spin) {
+			m->spinners++;
+			cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
+
+			mutex_spin_wait(m, false /* read */);
+			may_spin = false;
+
+			old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
+			m->spinners--;
+			can_lock = !m->state;
+		}
 		if (!can_lock) {
 			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
 		} else {
@@ -61,9 +124,17 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			if (!waited) {
+				begin = lock_stats_wait_begin();
+				waited = true;
+			}
 			wq_wait_final(&m->wq, &wqe, 0, m, fname, lineno);
-		} else
+		} else {
+			if (waited)
+				lock_stats_wait_end(m, LOCK_STATS_MUTEX,
+						    begin);
 			return;
+		}
 	}
 }
 
@@ -91,6 +162,7 @@ static void __mutex_lock_recursive(struct recursive_mutex *m, const char *fname,
 static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
+	bool have_spinners = false;
 
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
@@ -103,10 +175,11 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 		panic();
 
 	m->state = 0;
+	have_spinners = m->spinners;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-	wq_wake_next(&m->wq, m, fname, lineno);
+	mutex_wake(m, have_spinners, fname, lineno);
 }
 
 static void __mutex_unlock_recursive(struct recursive_mutex *m,
@@ -151,6 +224,7 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
+	bool have_spinners = false;
 	short new_state;
 
 	assert_have_no_spinlock();
@@ -162,16 +236,21 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 		panic();
 	m->state--;
 	new_state = m->state;
+	have_spinners = m->spinners;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
 	/* Wake eventual waiters if the mutex was unlocked */
 	if (!new_state)
-		wq_wake_next(&m->wq, m, fname, lineno);
+		mutex_wake(m, have_spinners, fname, lineno);
 }
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool may_spin = CFG_CORE_MUTEX_SPIN_US;
+	uint64_t begin = 0;
+	bool waited = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -193,6 +272,17 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 		can_lock = m->state != -1;
+		if (!can_lock && may_spin) {
+			m->spinners++;
+			cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
+
+			mutex_spin_wait(m, true /* read */);
+			may_spin = false;
+
+			old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
+			m->spinners--;
+			can_lock = m->state != -1;
+		}
 		if (!can_lock) {
 			wq_wait_init(&m->wq, &wqe, true /* wait_read */);
 		} else {
@@ -206,9 +296,17 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			if (!waited) {
+				begin = lock_stats_wait_begin();
+				waited = true;
+			}
 			wq_wait_final(&m->wq, &wqe, 0, m, fname, lineno);
-		} else
+		} else {
+			if (waited)
+				lock_stats_wait_end(m, LOCK_STATS_MUTEX,
+						    begin);
 			return;
+		}
 	}
 }
 
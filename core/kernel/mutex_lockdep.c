@@ -13,13 +13,13 @@
 #include "mutex_lockdep.h"
 
 /* Global graph of all mutexes used in the code */
-static struct lockdep_node_head graph = TAILQ_HEAD_INITIALIZER(graph);
+static struct lockdep_node_head graph = LOCKDEP_GRAPH_INITIALIZER(graph);
 
 /* Protects @graph */
 static unsigned int graph_lock = SPINLOCK_UNLOCK;
 
 /*
- * One queue per thread, contains the mutexes the thread owns at any point in
+ * One stack per thread, contains the mutexes the thread owns at any point in
  * time (in aquire order)
  */
 static struct lockdep_lock_head owned[CFG_NUM_THREADS];
@@ -29,7 +29,7 @@ void mutex_lockdep_init(void)
 	int n = 0;
 
 	for (n = 0; n < CFG_NUM_THREADS; n++)
-		TAILQ_INIT(&owned[n]);
+		lockdep_queue_init(&owned[n]);
 
 	DMSG("lockdep is enabled for mutexes");
 }
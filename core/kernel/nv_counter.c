@@ -4,8 +4,18 @@
  */
 
 #include <compiler.h>
+#include <kernel/mutex.h>
 #include <kernel/nv_counter.h>
 
+/*
+ * Last known value of the REE FS counter, valid once @ree_fs_res isn't
+ * TEE_ERROR_NO_DATA. An error from the platform is cached too as it
+ * doesn't change at runtime.
+ */
+static uint32_t ree_fs_counter;
+static TEE_Result ree_fs_res = TEE_ERROR_NO_DATA;
+static struct mutex ree_fs_counter_mu = MUTEX_INITIALIZER;
+
 TEE_Result __weak nv_counter_get_ree_fs(uint32_t *value __unused)
 {
 	return TEE_ERROR_NOT_IMPLEMENTED;
@@ -15,3 +25,38 @@ TEE_Result __weak nv_counter_incr_ree_fs_to(uint32_t value __unused)
 {
 	return TEE_ERROR_NOT_IMPLEMENTED;
 }
+
+TEE_Result nv_counter_get_ree_fs_cached(uint32_t *value)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_counter_mu);
+	if (ree_fs_res == TEE_ERROR_NO_DATA)
+		ree_fs_res = nv_counter_get_ree_fs(&ree_fs_counter);
+	res = ree_fs_res;
+	if (!res)
+		*value = ree_fs_counter;
+	mutex_unlock(&ree_fs_counter_mu);
+
+	return res;
+}
+
+TEE_Result nv_counter_incr_ree_fs_to_cached(uint32_t value)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_counter_mu);
+	if (ree_fs_res || value > ree_fs_counter) {
+		res = nv_counter_incr_ree_fs_to(value);
+		if (!res) {
+			ree_fs_counter = value;
+			ree_fs_res = TEE_SUCCESS;
+		} else if (!ree_fs_res) {
+			/* The counter is read again next time */
+			ree_fs_res = TEE_ERROR_NO_DATA;
+		}
+	}
+	mutex_unlock(&ree_fs_counter_mu);
+
+	return res;
+}
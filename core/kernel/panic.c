@@ -9,6 +9,7 @@
 #include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ring.h>
 #include <kernel/unwind.h>
 #include <trace.h>
 
@@ -68,6 +69,9 @@ void __do_panic(const char *file __maybe_unused,
 	/* disable preemption */
 	(void)thread_mask_exceptions(THREAD_EXCP_ALL);
 
+	/* Make sure buffered and following traces reach the console */
+	trace_ring_flush();
+
 	/* trace: Panic ['panic-string-message' ]at FILE:LINE [<FUNCTION>]" */
 	if (!file && !func && !msg)
 		EMSG_RAW("Panic");
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/linker.h>
+#include <kernel/pc_sample.h>
+#include <kernel/spinlock.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util.h>
+
+/* Protects hist, taken with exceptions masked */
+static unsigned int hist_lock = SPINLOCK_UNLOCK;
+
+static struct {
+	uint32_t *samples;
+	size_t nsamples;
+	unsigned int shift;
+	uint32_t count;
+	bool enabled;
+} hist;
+
+void core_pc_sample(vaddr_t pc)
+{
+	vaddr_t start = (vaddr_t)__text_start;
+	size_t idx = 0;
+
+	cpu_spin_lock(&hist_lock);
+	if (hist.enabled) {
+		hist.count++;
+		if (pc >= start) {
+			idx = (pc - start) >> hist.shift;
+			if (idx < hist.nsamples)
+				hist.samples[idx]++;
+		}
+	}
+	cpu_spin_unlock(&hist_lock);
+}
+
+TEE_Result core_pc_sample_start(unsigned int shift)
+{
+	size_t text_size = __text_end - __text_start;
+	uint32_t exceptions = 0;
+	uint32_t *old = NULL;
+	uint32_t *s = NULL;
+	size_t n = 0;
+
+	/* Instructions are at least 2 bytes, finer buckets are useless */
+	if (shift < 1 || shift >= 32)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	n = (text_size >> shift) + 1;
+	s = calloc(n, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	exceptions = cpu_spin_lock_xsave(&hist_lock);
+	old = hist.samples;
+	hist.samples = s;
+	hist.nsamples = n;
+	hist.shift = shift;
+	hist.count = 0;
+	hist.enabled = true;
+	cpu_spin_unlock_xrestore(&hist_lock, exceptions);
+
+	free(old);
+
+	return TEE_SUCCESS;
+}
+
+void core_pc_sample_stop(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&hist_lock);
+
+	hist.enabled = false;
+	cpu_spin_unlock_xrestore(&hist_lock, exceptions);
+}
+
+TEE_Result core_pc_sample_read(void *buf, size_t *len, unsigned int *shift,
+			       uint32_t *count)
+{
+	size_t l = 0;
+
+	/* Not enabled means not written to, no need to lock */
+	if (hist.enabled || !hist.samples)
+		return TEE_ERROR_BAD_STATE;
+
+	l = hist.nsamples * sizeof(*hist.samples);
+	if (*len < l) {
+		*len = l;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	memcpy(buf, hist.samples, l);
+	*len = l;
+	*shift = hist.shift;
+	*count = hist.count;
+
+	return TEE_SUCCESS;
+}
@@ -325,7 +325,7 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 	ctx->ts_ctx.ops = &pseudo_ta_ops;
 
 	s->ts_sess.ctx = &ctx->ts_ctx;
-	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	tee_ta_link_ctx(ctx);
 
 	DMSG("%s : %pUl", stc->pseudo_ta->name, (void *)&ctx->ts_ctx.uuid);
 
@@ -50,6 +50,7 @@
 #include <signed_hdr.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/tee_pobj.h>
 #include <tee/tee_ta_enc_manager.h>
 #include <tee/uuid.h>
@@ -79,15 +80,67 @@ struct ver_db_hdr {
 	uint32_t nb_entries;
 };
 
+/* Bytes decrypted and hashed in one go when reading into core memory */
+#define REE_FS_TA_CHUNK_SIZE	SMALL_PAGE_SIZE
+
+/* Version of an entry of a version database, as last read or written */
+struct ver_db_cache_entry {
+	const char *db_name;
+	struct ver_db_entry entry;
+	SLIST_ENTRY(ver_db_cache_entry) link;
+};
+
 static const char ta_ver_db[] = "ta_ver.db";
 static const char subkey_ver_db[] = "subkey_ver.db";
 static struct mutex ver_db_mutex = MUTEX_INITIALIZER;
+static SLIST_HEAD(, ver_db_cache_entry) ver_db_cache =
+	SLIST_HEAD_INITIALIZER(ver_db_cache);
+
+#ifdef CFG_REE_FS_TA_CACHE
+static void ta_cache_invalidate(const TEE_UUID *uuid, uint32_t version);
+#else
+static void ta_cache_invalidate(const TEE_UUID *uuid __unused,
+				uint32_t version __unused)
+{
+}
+#endif
+
+static struct ver_db_cache_entry *
+ver_db_cache_find(const char *db_name, const uint8_t uuid[sizeof(TEE_UUID)])
+{
+	struct ver_db_cache_entry *ce = NULL;
+
+	SLIST_FOREACH(ce, &ver_db_cache, link)
+		if (ce->db_name == db_name &&
+		    !memcmp(ce->entry.uuid, uuid, sizeof(TEE_UUID)))
+			return ce;
+
+	return NULL;
+}
+
+static void ver_db_cache_update(struct ver_db_cache_entry *ce,
+				const char *db_name,
+				const uint8_t uuid[sizeof(TEE_UUID)],
+				uint32_t version)
+{
+	if (!ce) {
+		/* Not caching only means reading the database next time */
+		ce = calloc(1, sizeof(*ce));
+		if (!ce)
+			return;
+		ce->db_name = db_name;
+		memcpy(ce->entry.uuid, uuid, sizeof(TEE_UUID));
+		SLIST_INSERT_HEAD(&ver_db_cache, ce, link);
+	}
+	ce->entry.version = version;
+}
 
 static TEE_Result check_update_version(const char *db_name,
 				       const uint8_t uuid[sizeof(TEE_UUID)],
 				       uint32_t version)
 {
 	struct ver_db_entry db_entry = { };
+	struct ver_db_cache_entry *ce = NULL;
 	const struct tee_file_operations *ops = NULL;
 	struct tee_file_handle *fh = NULL;
 	TEE_Result res = TEE_SUCCESS;
@@ -106,6 +159,15 @@ static TEE_Result check_update_version(const char *db_name,
 
 	mutex_lock(&ver_db_mutex);
 
+	/* The database only needs to be accessed to raise a version */
+	ce = ver_db_cache_find(db_name, uuid);
+	if (ce && ce->entry.version >= version) {
+		if (ce->entry.version > version)
+			res = TEE_ERROR_ACCESS_CONFLICT;
+		mutex_unlock(&ver_db_mutex);
+		goto out_cached;
+	}
+
 	res = ops->open(&pobj, NULL, &fh);
 	if (res != TEE_SUCCESS && res != TEE_ERROR_ITEM_NOT_FOUND)
 		goto out;
@@ -179,7 +241,18 @@ static TEE_Result check_update_version(const char *db_name,
 
 out:
 	ops->close(&fh);
+	if (!res)
+		ver_db_cache_update(ce, db_name, uuid, version);
 	mutex_unlock(&ver_db_mutex);
+
+out_cached:
+	if (!res && db_name == ta_ver_db) {
+		TEE_UUID ta_uuid = { };
+
+		tee_uuid_from_octets(&ta_uuid, uuid);
+		ta_cache_invalidate(&ta_uuid, version);
+	}
+
 	return res;
 }
 
@@ -553,7 +626,7 @@ static TEE_Result ree_fs_ta_read(struct ts_store_handle *h, void *data_core,
 	TEE_Result res = TEE_SUCCESS;
 	size_t num_bytes = 0;
 	size_t dst_len = 0;
-	void *dst = NULL;
+	uint8_t *dst = NULL;
 	void *bb = NULL;
 
 
@@ -562,8 +635,13 @@ static TEE_Result ree_fs_ta_read(struct ts_store_handle *h, void *data_core,
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	if (data_core) {
-		dst = data_core;
-		dst_len = len;
+		/*
+		 * Decrypt or copy into the destination one small chunk at
+		 * a time and hash each chunk right away, while it's still
+		 * in the data cache. Doing each step over the whole of a
+		 * large segment would stream it through memory twice.
+		 */
+		dst_len = MIN(REE_FS_TA_CHUNK_SIZE, len);
 	} else {
 		bb = bb_alloc(bb_len);
 		if (!bb)
@@ -573,13 +651,15 @@ static TEE_Result ree_fs_ta_read(struct ts_store_handle *h, void *data_core,
 	}
 
 	/*
-	 * This loop will only run once if data_core is non-NULL, but as
-	 * many times as needed if the bounce buffer bb is used. That's why
-	 * dst doesn't need to be updated in the loop.
+	 * If the bounce buffer bb is used, dst stays the same for each
+	 * round of the loop.
 	 */
 	while (num_bytes < len) {
 		size_t n = MIN(dst_len, len - num_bytes);
 
+		if (data_core)
+			dst = (uint8_t *)data_core + num_bytes;
+
 		if (handle->shdr->img_type == SHDR_ENCRYPTED_TA) {
 			res = tee_ta_decrypt_update(handle->enc_ctx, dst,
 						    src + num_bytes, n);
@@ -681,8 +761,214 @@ struct buf_ree_fs_ta_handle {
 	size_t offs;
 	uint8_t *tag;
 	unsigned int tag_len;
+	struct ta_cache_entry *ce; /* Owner of @mm and @tag if non-NULL */
 };
 
+#ifdef CFG_REE_FS_TA_CACHE
+
+/*
+ * A bounded cache of verified TA binaries, kept in the same secure memory
+ * as the temporary buffer of the store. Opening a cached TA skips the RPC
+ * transfer, the signature verification and the hashing of the binary.
+ *
+ * Entries are keyed by UUID and TA version. A TA can only be cached
+ * after check_update_version() has accepted its version, and any entry
+ * older than a version accepted later is invalidated, so the cache never
+ * serves a binary that the rollback protection would refuse.
+ */
+
+/*
+ * struct ta_cache_entry - a verified TA binary
+ * @uuid:	UUID of the TA
+ * @version:	TA version from the bootstrap header, 0 for a legacy TA
+ * @mm:		secure memory holding the binary
+ * @buf:	virtual address of the binary
+ * @size:	size of the binary
+ * @tag:	hash of the binary from the signed header
+ * @tag_len:	length of @tag
+ * @refc:	number of open handles using the entry
+ * @stale:	entry is removed from the cache, freed on last close
+ * @link:	link in ta_cache, most recently used first
+ */
+struct ta_cache_entry {
+	TEE_UUID uuid;
+	uint32_t version;
+	tee_mm_entry_t *mm;
+	uint8_t *buf;
+	size_t size;
+	uint8_t *tag;
+	unsigned int tag_len;
+	unsigned int refc;
+	bool stale;
+	TAILQ_ENTRY(ta_cache_entry) link;
+};
+
+static TAILQ_HEAD(ta_cache_head, ta_cache_entry) ta_cache =
+	TAILQ_HEAD_INITIALIZER(ta_cache);
+static size_t ta_cache_bytes;
+static struct mutex ta_cache_mu = MUTEX_INITIALIZER;
+
+static void ta_cache_free_entry(struct ta_cache_entry *ce)
+{
+	phys_mem_free(ce->mm);
+	free(ce->tag);
+	free(ce);
+}
+
+/* Must be called with ta_cache_mu held */
+static void ta_cache_remove(struct ta_cache_entry *ce)
+{
+	TAILQ_REMOVE(&ta_cache, ce, link);
+	ta_cache_bytes -= ce->size;
+	if (ce->refc)
+		ce->stale = true;
+	else
+		ta_cache_free_entry(ce);
+}
+
+/*
+ * Evict unused entries, least recently used first, until at most
+ * @max_bytes are cached. Must be called with ta_cache_mu held.
+ */
+static void ta_cache_shrink(size_t max_bytes)
+{
+	struct ta_cache_entry *ce = TAILQ_LAST(&ta_cache, ta_cache_head);
+	struct ta_cache_entry *prev = NULL;
+
+	while (ce && ta_cache_bytes > max_bytes) {
+		prev = TAILQ_PREV(ce, ta_cache_head, link);
+		if (!ce->refc)
+			ta_cache_remove(ce);
+		ce = prev;
+	}
+}
+
+static void ta_cache_invalidate(const TEE_UUID *uuid, uint32_t version)
+{
+	struct ta_cache_entry *next = NULL;
+	struct ta_cache_entry *ce = NULL;
+
+	mutex_lock(&ta_cache_mu);
+	TAILQ_FOREACH_SAFE(ce, &ta_cache, link, next) {
+		if (!memcmp(&ce->uuid, uuid, sizeof(*uuid)) &&
+		    ce->version < version)
+			ta_cache_remove(ce);
+	}
+	mutex_unlock(&ta_cache_mu);
+}
+
+/* Drop all unused entries to give their memory back to the TA pool */
+static void ta_cache_evict_all(void)
+{
+	mutex_lock(&ta_cache_mu);
+	ta_cache_shrink(0);
+	mutex_unlock(&ta_cache_mu);
+}
+
+static bool ta_cache_get(const TEE_UUID *uuid,
+			 struct buf_ree_fs_ta_handle *handle)
+{
+	struct ta_cache_entry *ce = NULL;
+
+	mutex_lock(&ta_cache_mu);
+	TAILQ_FOREACH(ce, &ta_cache, link) {
+		if (!memcmp(&ce->uuid, uuid, sizeof(*uuid))) {
+			ce->refc++;
+			TAILQ_REMOVE(&ta_cache, ce, link);
+			TAILQ_INSERT_HEAD(&ta_cache, ce, link);
+			break;
+		}
+	}
+	mutex_unlock(&ta_cache_mu);
+
+	if (!ce)
+		return false;
+
+	handle->ce = ce;
+	handle->ta_size = ce->size;
+	handle->mm = ce->mm;
+	handle->buf = ce->buf;
+	handle->tag = ce->tag;
+	handle->tag_len = ce->tag_len;
+	return true;
+}
+
+/*
+ * Hand the verified binary of @handle over to a new cache entry. On
+ * failure @handle keeps ownership and nothing is cached.
+ */
+static void ta_cache_add(const TEE_UUID *uuid,
+			 struct buf_ree_fs_ta_handle *handle)
+{
+	struct ree_fs_ta_handle *ree_h = (struct ree_fs_ta_handle *)handle->h;
+	struct ta_cache_entry *ce = NULL;
+
+	if (handle->ta_size > CFG_REE_FS_TA_CACHE_SIZE)
+		return;
+
+	ce = calloc(1, sizeof(*ce));
+	if (!ce)
+		return;
+
+	ce->uuid = *uuid;
+	if (ree_h->bs_hdr)
+		ce->version = ree_h->bs_hdr->ta_version;
+	ce->mm = handle->mm;
+	ce->buf = handle->buf;
+	ce->size = handle->ta_size;
+	ce->tag = handle->tag;
+	ce->tag_len = handle->tag_len;
+	ce->refc = 1;
+
+	mutex_lock(&ta_cache_mu);
+	ta_cache_shrink(CFG_REE_FS_TA_CACHE_SIZE - ce->size);
+	if (ta_cache_bytes + ce->size > CFG_REE_FS_TA_CACHE_SIZE) {
+		/* Everything left is in use */
+		mutex_unlock(&ta_cache_mu);
+		free(ce);
+		return;
+	}
+	TAILQ_INSERT_HEAD(&ta_cache, ce, link);
+	ta_cache_bytes += ce->size;
+	mutex_unlock(&ta_cache_mu);
+
+	handle->ce = ce;
+}
+
+static void ta_cache_put(struct ta_cache_entry *ce)
+{
+	bool do_free = false;
+
+	mutex_lock(&ta_cache_mu);
+	assert(ce->refc);
+	ce->refc--;
+	do_free = !ce->refc && ce->stale;
+	mutex_unlock(&ta_cache_mu);
+
+	if (do_free)
+		ta_cache_free_entry(ce);
+}
+#else
+static bool ta_cache_get(const TEE_UUID *uuid __unused,
+			 struct buf_ree_fs_ta_handle *handle __unused)
+{
+	return false;
+}
+
+static void ta_cache_add(const TEE_UUID *uuid __unused,
+			 struct buf_ree_fs_ta_handle *handle __unused)
+{
+}
+
+static void ta_cache_put(struct ta_cache_entry *ce __unused)
+{
+}
+
+static void ta_cache_evict_all(void)
+{
+}
+#endif /* CFG_REE_FS_TA_CACHE */
+
 static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 			      struct ts_store_handle **h)
 {
@@ -693,6 +979,12 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	handle = calloc(1, sizeof(*handle));
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
+
+	if (ta_cache_get(uuid, handle)) {
+		*h = (struct ts_store_handle *)handle;
+		return TEE_SUCCESS;
+	}
+
 	FTMN_PUSH_LINKED_CALL(&ftmn, FTMN_FUNC_HASH("ree_fs_ta_open"));
 	res = ree_fs_ta_open(uuid, &handle->h);
 	if (!res)
@@ -721,6 +1013,10 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 		goto err;
 
 	handle->mm = phys_mem_ta_alloc(handle->ta_size);
+	if (!handle->mm) {
+		ta_cache_evict_all();
+		handle->mm = phys_mem_ta_alloc(handle->ta_size);
+	}
 	if (!handle->mm) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
@@ -742,12 +1038,13 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	ftmn_checkpoint(&ftmn, FTMN_INCR1);
 
 	*h = (struct ts_store_handle *)handle;
+	ta_cache_add(uuid, handle);
 	ree_fs_ta_close(handle->h);
 	return ftmn_return_res(&ftmn, FTMN_STEP_COUNT(2, 2), TEE_SUCCESS);
 
 err:
 	ree_fs_ta_close(handle->h);
-	tee_mm_free(handle->mm);
+	phys_mem_free(handle->mm);
 	free(handle->tag);
 err_free_handle:
 	free(handle);
@@ -806,8 +1103,12 @@ static void buf_ta_close(struct ts_store_handle *h)
 
 	if (!handle)
 		return;
-	tee_mm_free(handle->mm);
-	free(handle->tag);
+	if (handle->ce) {
+		ta_cache_put(handle->ce);
+	} else {
+		phys_mem_free(handle->mm);
+		free(handle->tag);
+	}
 	free(handle);
 }
 
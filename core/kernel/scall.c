@@ -8,6 +8,7 @@
 #include <kernel/abort.h>
 #include <kernel/arch_scall.h>
 #include <kernel/ldelf_syscalls.h>
+#include <kernel/perf_stats.h>
 #include <kernel/scall.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
@@ -117,6 +118,8 @@ static const struct syscall_entry tee_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_cryp_update_vec),
+	SYSCALL_ENTRY(syscall_storage_transaction),
 };
 
 /*
@@ -208,6 +211,8 @@ bool scall_handle_user_ta(struct thread_scall_regs *regs)
 	size_t scn = 0;
 	size_t max_args = 0;
 	syscall_t scf = NULL;
+	struct perf_stats_snap snap = { };
+	uint64_t stamp = user_ta_acct_stamp();
 
 	bb_reset();
 	scall_get_max_args(regs, &scn, &max_args);
@@ -224,9 +229,12 @@ bool scall_handle_user_ta(struct thread_scall_regs *regs)
 
 	ftrace_syscall_enter(scn);
 
+	perf_stats_begin(&snap);
 	scall_set_retval(regs, scall_do_call(regs, scf));
+	perf_stats_end(PERF_STATS_SYSCALL, &snap);
 
 	ftrace_syscall_leave();
+	user_ta_acct_syscall(scn, stamp);
 
 	/*
 	 * Return true if we're to return to user mode,
@@ -20,6 +20,7 @@ ifneq ($(CFG_CORE_FFA),y)
 srcs-$(CFG_CORE_DYN_SHM) += msg_param.c
 endif
 srcs-y += panic.c
+srcs-$(CFG_CORE_PC_SAMPLING) += pc_sample.c
 srcs-y += trace_ext.c
 srcs-y += refcount.c
 srcs-y += delay.c
@@ -39,8 +40,10 @@ srcs-y += initcall.c
 srcs-$(CFG_WITH_USER_TA) += user_access.c
 srcs-y += mutex.c
 srcs-$(CFG_LOCKDEP) += mutex_lockdep.c
+srcs-$(CFG_LOCK_CONTENTION_STATS) += lock_stats.c
 srcs-y += wait_queue.c
 srcs-y += notif.c
+srcs-$(CFG_CORE_WORKQUEUE) += workqueue.c
 srcs-$(_CFG_CORE_ASYNC_NOTIF_DEFAULT_IMPL) += notif_default.c
 srcs-y += thread.c
 
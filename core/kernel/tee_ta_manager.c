@@ -5,9 +5,11 @@
  */
 
 #include <assert.h>
+#include <kernel/delay.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/spinlock.h>
 #include <kernel/stmm_sp.h>
 #include <kernel/tee_common.h>
 #include <kernel/tee_misc.h>
@@ -51,6 +53,28 @@ struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Open sessions and registered contexts are also hashed, by session ID and
+ * by UUID, so that the lookups done for each invoke, close or cancel don't
+ * have to walk all the sessions. Both indexes are protected by tee_ta_mutex.
+ */
+#define TEE_TA_SESS_BUCKETS	64
+#define TEE_TA_CTX_BUCKETS	16
+
+static_assert(IS_POWER_OF_TWO(TEE_TA_SESS_BUCKETS));
+static_assert(IS_POWER_OF_TWO(TEE_TA_CTX_BUCKETS));
+
+SLIST_HEAD(tee_ta_sess_bucket, tee_ta_session);
+SLIST_HEAD(tee_ta_ctx_bucket, tee_ta_ctx);
+
+static struct tee_ta_sess_bucket sess_index[TEE_TA_SESS_BUCKETS];
+static struct tee_ta_ctx_bucket ctx_index[TEE_TA_CTX_BUCKETS];
+
+#if defined(CFG_TA_RNG_QOS)
+/* Protects struct tee_ta_rng_acct of all contexts */
+static unsigned int tee_ta_rng_lock = SPINLOCK_UNLOCK;
+#endif
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
 static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
 static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
@@ -70,6 +94,21 @@ static bool has_single_instance_lock(void)
 {
 	return false;
 }
+
+/*
+ * Without the single-instance lock a TA calling back into an instance
+ * already busy further up the same call chain would wait for itself.
+ */
+static bool is_busy_in_this_thread(struct tee_ta_ctx *ctx)
+{
+	struct ts_session *s = NULL;
+
+	TAILQ_FOREACH(s, &thread_get_tsd()->sess_stack, link_tsd)
+		if (s->ctx == &ctx->ts_ctx)
+			return true;
+
+	return false;
+}
 #else
 static void lock_single_instance(void)
 {
@@ -104,6 +143,11 @@ static bool has_single_instance_lock(void)
 	/* Requires tee_ta_mutex to be held */
 	return tee_ta_single_instance_thread == thread_get_id();
 }
+
+static bool is_busy_in_this_thread(struct tee_ta_ctx *ctx __unused)
+{
+	return false;
+}
 #endif
 
 struct tee_ta_session *__noprof to_ta_session(struct ts_session *sess)
@@ -146,6 +190,8 @@ static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
 				unlock_single_instance();
 		}
+	} else if (ctx->busy && is_busy_in_this_thread(ctx)) {
+		rc = false;
 	} else {
 		/*
 		 * We're not holding the single-instance lock, we're free to
@@ -176,6 +222,10 @@ static void tee_ta_clear_busy(struct tee_ta_ctx *ctx)
 	mutex_lock(&tee_ta_mutex);
 
 	assert(ctx->busy);
+	if (ctx->flush_params) {
+		vm_flush_param(&to_user_ta_ctx(&ctx->ts_ctx)->uctx);
+		ctx->flush_params = false;
+	}
 	ctx->busy = false;
 	condvar_signal(&ctx->busy_cv);
 
@@ -206,20 +256,94 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	mutex_unlock(&tee_ta_mutex);
 }
 
+/* Session IDs are only unique within @open_sessions, both make the key */
+static struct tee_ta_sess_bucket *
+sess_bucket(uint32_t id, struct tee_ta_session_head *open_sessions)
+{
+	vaddr_t h = id + ((vaddr_t)open_sessions >> 4);
+
+	return sess_index + (h & (TEE_TA_SESS_BUCKETS - 1));
+}
+
+static struct tee_ta_ctx_bucket *ctx_bucket(const TEE_UUID *uuid)
+{
+	return ctx_index + (uuid->timeLow & (TEE_TA_CTX_BUCKETS - 1));
+}
+
+/* Requires tee_ta_mutex to be held */
+static void link_session(struct tee_ta_session *s,
+			 struct tee_ta_session_head *open_sessions)
+{
+	s->head = open_sessions;
+	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	SLIST_INSERT_HEAD(sess_bucket(s->id, open_sessions), s, id_link);
+}
+
+/* Requires tee_ta_mutex to be held */
+static void unlink_session(struct tee_ta_session *s,
+			   struct tee_ta_session_head *open_sessions)
+{
+	assert(s->head == open_sessions);
+	TAILQ_REMOVE(open_sessions, s, link);
+	SLIST_REMOVE(sess_bucket(s->id, open_sessions), s, tee_ta_session,
+		     id_link);
+	s->head = NULL;
+}
+
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx)
+{
+	struct tee_ta_ctx_bucket *b = ctx_bucket(&ctx->ts_ctx.uuid);
+	struct tee_ta_ctx *last = SLIST_FIRST(b);
+
+	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+
+	/*
+	 * Keep the order of tee_ctxes so that the oldest instance of a TA
+	 * is still the one found first.
+	 */
+	if (!last) {
+		SLIST_INSERT_HEAD(b, ctx, uuid_link);
+		return;
+	}
+	while (SLIST_NEXT(last, uuid_link))
+		last = SLIST_NEXT(last, uuid_link);
+	SLIST_INSERT_AFTER(last, ctx, uuid_link);
+}
+
+void tee_ta_unlink_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	SLIST_REMOVE(ctx_bucket(&ctx->ts_ctx.uuid), ctx, tee_ta_ctx,
+		     uuid_link);
+}
+
+void tee_ta_flush_param_mappings(void)
+{
+	struct tee_ta_ctx *ctx = NULL;
+
+	mutex_lock(&tee_ta_mutex);
+	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+		if (!is_user_ta_ctx(&ctx->ts_ctx))
+			continue;
+		/* The mappings of a busy context may be in use */
+		if (ctx->busy)
+			ctx->flush_params = true;
+		else
+			vm_flush_param(&to_user_ta_ctx(&ctx->ts_ctx)->uctx);
+	}
+	mutex_unlock(&tee_ta_mutex);
+}
+
 static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
-		}
-	}
+	SLIST_FOREACH(s, sess_bucket(id, open_sessions), id_link)
+		if (s->id == id && s->head == open_sessions)
+			return s;
 
-	return found;
+	return NULL;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -289,7 +413,7 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	while (s->ref_count != 1)
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	unlink_session(s, open_sessions);
 
 	mutex_unlock(&tee_ta_mutex);
 }
@@ -327,12 +451,11 @@ static void destroy_context(struct tee_ta_ctx *ctx)
  */
 static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 {
-	struct tee_ta_ctx *ctx;
+	struct tee_ta_ctx *ctx = NULL;
 
-	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
-		if (memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(TEE_UUID)) == 0)
+	SLIST_FOREACH(ctx, ctx_bucket(uuid), uuid_link)
+		if (!memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(TEE_UUID)))
 			return ctx;
-	}
 
 	return NULL;
 }
@@ -445,6 +568,34 @@ infinite:
 	sess->cancel_time.millis = UINT32_MAX;
 }
 
+/*
+ * Drop the reference a closed session had on @ctx. The context is
+ * destroyed with its last reference unless it is kept alive.
+ */
+static void put_ctx(struct tee_ta_ctx *ctx)
+{
+	bool keep_alive = false;
+
+	mutex_lock(&tee_ta_mutex);
+
+	if (ctx->ref_count <= 0)
+		panic();
+
+	ctx->ref_count--;
+	keep_alive = (ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
+			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
+	if (!ctx->ref_count && (ctx->panicked || !keep_alive)) {
+		if (!ctx->is_releasing) {
+			tee_ta_unlink_ctx(ctx);
+			ctx->is_releasing = true;
+		}
+		mutex_unlock(&tee_ta_mutex);
+
+		destroy_context(ctx);
+	} else
+		mutex_unlock(&tee_ta_mutex);
+}
+
 /*-----------------------------------------------------------------------------
  * Close a Trusted Application and free available resources
  *---------------------------------------------------------------------------*/
@@ -455,7 +606,6 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 	struct tee_ta_session *sess = NULL;
 	struct tee_ta_ctx *ctx = NULL;
 	struct ts_ctx *ts_ctx = NULL;
-	bool keep_alive = false;
 
 	DMSG("csess 0x%" PRIxVA " id %u",
 	     (vaddr_t)csess, csess ? csess->id : UINT_MAX);
@@ -495,24 +645,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 		tee_ta_clear_busy(ctx);
 	}
 
-	mutex_lock(&tee_ta_mutex);
-
-	if (ctx->ref_count <= 0)
-		panic();
-
-	ctx->ref_count--;
-	keep_alive = (ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
-			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
-	if (!ctx->ref_count && (ctx->panicked || !keep_alive)) {
-		if (!ctx->is_releasing) {
-			TAILQ_REMOVE(&tee_ctxes, ctx, link);
-			ctx->is_releasing = true;
-		}
-		mutex_unlock(&tee_ta_mutex);
-
-		destroy_context(ctx);
-	} else
-		mutex_unlock(&tee_ta_mutex);
+	put_ctx(ctx);
 
 	return TEE_SUCCESS;
 }
@@ -613,7 +746,7 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 		goto err_mutex_unlock;
 	}
 
-	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	link_session(s, open_sessions);
 
 	/* Look for already loaded TA */
 	res = tee_ta_init_session_with_context(s, uuid);
@@ -652,7 +785,7 @@ out:
 	}
 
 	mutex_lock(&tee_ta_mutex);
-	TAILQ_REMOVE(open_sessions, s, link);
+	unlink_session(s, open_sessions);
 err_mutex_unlock:
 	mutex_unlock(&tee_ta_mutex);
 	free(s);
@@ -668,7 +801,7 @@ static void release_ta_ctx(struct tee_ta_ctx *ctx)
 	ctx->is_releasing = true;
 	if (!was_releasing) {
 		DMSG("Releasing panicked TA ctx");
-		TAILQ_REMOVE(&tee_ctxes, ctx, link);
+		tee_ta_unlink_ctx(ctx);
 	}
 	mutex_unlock(&tee_ta_mutex);
 
@@ -747,6 +880,45 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	return res;
 }
 
+#if defined(CFG_TA_PRELOAD_PTA)
+TEE_Result tee_ta_preload(const TEE_UUID *uuid)
+{
+	struct tee_ta_session_head sessions = TAILQ_HEAD_INITIALIZER(sessions);
+	TEE_ErrorOrigin err = TEE_ORIGIN_TEE;
+	struct tee_ta_session *s = NULL;
+	struct tee_ta_ctx *ctx = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t id = 0;
+
+	/*
+	 * Loads the TA, or finds the already loaded instance. The TA
+	 * itself isn't entered, only its context is created.
+	 */
+	res = tee_ta_init_session(&err, &sessions, uuid, &s);
+	if (res)
+		return res;
+
+	ctx = ts_to_ta_ctx(s->ts_sess.ctx);
+	if (!is_user_ta_ctx(&ctx->ts_ctx) ||
+	    !(ctx->flags & TA_FLAG_SINGLE_INSTANCE) ||
+	    !(ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE))
+		res = TEE_ERROR_NOT_SUPPORTED;
+
+	/* Drop the session, it has never been opened in the TA */
+	id = s->id;
+	tee_ta_put_session(s);
+	s = tee_ta_get_session(id, true, &sessions);
+	assert(s);
+	destroy_session(s, &sessions);
+	put_ctx(ctx);
+
+	if (!res)
+		DMSG("Preloaded TA %pUl", (void *)uuid);
+
+	return res;
+}
+#endif
+
 TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 				 struct tee_ta_session *sess,
 				 const TEE_Identity *clnt_id,
@@ -921,6 +1093,10 @@ static TEE_Result dump_ta_stats(struct tee_ta_dump_ctx *dump_ctx,
 			stats->heap.num_alloc_fail = param.u[1].val.b;
 			stats->heap.biggest_alloc_fail = param.u[2].val.a;
 			stats->heap.biggest_alloc_fail_used = param.u[2].val.b;
+#if defined(CFG_TA_RESOURCE_STATS)
+			to_user_ta_ctx(sess->ts_sess.ctx)->acct.heap_max_allocated =
+				stats->heap.max_allocated;
+#endif
 		} else {
 			memset(&stats->heap, 0, sizeof(stats->heap));
 		}
@@ -987,6 +1163,185 @@ TEE_Result tee_ta_instance_stats(void *buf, size_t *buf_size)
 }
 #endif
 
+#if defined(CFG_TA_RNG_QOS)
+bool tee_ta_rng_throttle(struct tee_ta_ctx *ctx, uint64_t now_ms)
+{
+	struct tee_ta_rng_acct *acct = &ctx->rng_acct;
+	uint32_t exceptions = 0;
+	bool throttle = false;
+
+	exceptions = cpu_spin_lock_xsave(&tee_ta_rng_lock);
+
+	if (now_ms - acct->window_start >= CFG_TA_RNG_BUDGET_WINDOW_MS) {
+		acct->window_start = now_ms;
+		acct->window_bytes = 0;
+	}
+
+	if (CFG_TA_RNG_BUDGET &&
+	    acct->window_bytes >= (size_t)CFG_TA_RNG_BUDGET) {
+		acct->throttled++;
+		throttle = true;
+	}
+
+	cpu_spin_unlock_xrestore(&tee_ta_rng_lock, exceptions);
+
+	return throttle;
+}
+
+void tee_ta_rng_charge(struct tee_ta_ctx *ctx, size_t len)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&tee_ta_rng_lock);
+
+	ctx->rng_acct.window_bytes += len;
+	ctx->rng_acct.bytes += len;
+
+	cpu_spin_unlock_xrestore(&tee_ta_rng_lock, exceptions);
+}
+
+TEE_Result tee_ta_rng_stats(void *buf, size_t *buf_size)
+{
+	struct pta_stats_rng_ta *stats = buf;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_ctx *ctx = NULL;
+	uint32_t exceptions = 0;
+	size_t ta_count = 0;
+	size_t sz = 0;
+
+	if (!buf_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&tee_ta_mutex);
+
+	TAILQ_FOREACH(ctx, &tee_ctxes, link)
+		if (is_user_ta_ctx(&ctx->ts_ctx))
+			ta_count++;
+
+	sz = sizeof(*stats) * ta_count;
+	if (!sz) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+	} else if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		res = TEE_ERROR_SHORT_BUFFER;
+	} else if (!IS_ALIGNED_WITH_TYPE(buf, uint64_t)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+	} else {
+		exceptions = cpu_spin_lock_xsave(&tee_ta_rng_lock);
+		TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+			if (!is_user_ta_ctx(&ctx->ts_ctx))
+				continue;
+
+			stats->uuid = ctx->ts_ctx.uuid;
+			stats->bytes = ctx->rng_acct.bytes;
+			stats->throttled = ctx->rng_acct.throttled;
+			stats->window_bytes = ctx->rng_acct.window_bytes;
+			stats++;
+		}
+		cpu_spin_unlock_xrestore(&tee_ta_rng_lock, exceptions);
+		*buf_size = sz;
+	}
+
+	mutex_unlock(&tee_ta_mutex);
+
+	return res;
+}
+#endif
+
+#if defined(CFG_TA_RESOURCE_STATS)
+static uint64_t ticks_to_us(uint64_t ticks)
+{
+	uint64_t freq = delay_cnt_freq();
+
+	return (ticks / freq) * 1000000 + (ticks % freq) * 1000000 / freq;
+}
+
+static bool acct_is_active(struct user_ta_acct *acct, uint64_t since)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&acct->lock);
+	bool active = acct->running || acct->last_active >= since;
+
+	cpu_spin_unlock_xrestore(&acct->lock, exceptions);
+
+	return active;
+}
+
+static void get_resource_stats(struct user_ta_ctx *utc,
+			       struct pta_stats_ta_resources *stats)
+{
+	struct user_ta_acct *acct = &utc->acct;
+	uint32_t exceptions = 0;
+
+	COMPILE_TIME_ASSERT(ARRAY_SIZE(acct->syscalls) <=
+			    ARRAY_SIZE(stats->syscalls));
+
+	memset(stats, 0, sizeof(*stats));
+	stats->uuid = utc->ta_ctx.ts_ctx.uuid;
+	stats->panicked = utc->ta_ctx.panicked;
+
+	exceptions = cpu_spin_lock_xsave(&acct->lock);
+	stats->running = acct->running;
+	stats->user_us = ticks_to_us(acct->cpu_ticks - acct->kernel_ticks);
+	stats->kernel_us = ticks_to_us(acct->kernel_ticks);
+	stats->page_faults = acct->page_faults;
+	stats->rpcs = acct->rpcs;
+	stats->heap_max_allocated = acct->heap_max_allocated;
+	memcpy(stats->syscalls, acct->syscalls, sizeof(acct->syscalls));
+	cpu_spin_unlock_xrestore(&acct->lock, exceptions);
+}
+
+TEE_Result tee_ta_resource_stats(void *buf, size_t *buf_size,
+				 uint64_t *since)
+{
+	struct pta_stats_ta_resources *stats = buf;
+	uint64_t now = delay_cnt_read();
+	struct user_ta_ctx *utc = NULL;
+	struct tee_ta_ctx *ctx = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t ta_count = 0;
+	size_t sz = 0;
+
+	if (!buf_size || !since)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&tee_ta_mutex);
+
+	TAILQ_FOREACH(ctx, &tee_ctxes, link)
+		if (is_user_ta_ctx(&ctx->ts_ctx) &&
+		    acct_is_active(&to_user_ta_ctx(&ctx->ts_ctx)->acct, *since))
+			ta_count++;
+
+	sz = sizeof(*stats) * ta_count;
+	if (!sz) {
+		*buf_size = 0;
+	} else if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		res = TEE_ERROR_SHORT_BUFFER;
+	} else if (!IS_ALIGNED_WITH_TYPE(buf, uint64_t)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+	} else {
+		/* A TA entered meanwhile is left for the next call */
+		TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+			if (!is_user_ta_ctx(&ctx->ts_ctx))
+				continue;
+			utc = to_user_ta_ctx(&ctx->ts_ctx);
+			if (!acct_is_active(&utc->acct, *since) || !ta_count)
+				continue;
+
+			get_resource_stats(utc, stats);
+			stats++;
+			ta_count--;
+		}
+		*buf_size = sz - ta_count * sizeof(*stats);
+	}
+
+	mutex_unlock(&tee_ta_mutex);
+
+	if (!res)
+		*since = now;
+
+	return res;
+}
+#endif
+
 TEE_Result tee_ta_cancel_command(TEE_ErrorOrigin *err,
 				 struct tee_ta_session *sess,
 				 const TEE_Identity *clnt_id)
@@ -1122,6 +1477,7 @@ static void ftrace_update_times(bool suspend)
 	} else {
 		for (i = 0; i <= fbuf->ret_idx; i++)
 			fbuf->begin_time[i] += now - fbuf->suspend_time;
+		fbuf->suspended += now - fbuf->suspend_time;
 	}
 }
 
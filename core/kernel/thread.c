@@ -9,12 +9,14 @@
 #include <crypto/crypto.h>
 #include <kernel/asan.h>
 #include <kernel/boot.h>
+#include <kernel/delay.h>
 #include <kernel/lockdep.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
+#include <malloc.h>
 #include <mm/mobj.h>
 
 struct thread_ctx threads[CFG_NUM_THREADS];
@@ -52,7 +54,19 @@ DECLARE_STACK(stack_tmp, CFG_TEE_CORE_NB_CORE, STACK_TMP_SIZE,
 	      /* global linkage */);
 DECLARE_STACK(stack_abt, CFG_TEE_CORE_NB_CORE, STACK_ABT_SIZE, static);
 #ifndef CFG_WITH_PAGER
-DECLARE_STACK(stack_thread, CFG_NUM_THREADS, STACK_THREAD_SIZE, static);
+DECLARE_STACK(stack_thread, CFG_NUM_THREADS_STATIC, STACK_THREAD_SIZE,
+	      static);
+
+/*
+ * Threads from CFG_NUM_THREADS_STATIC and up get their stacks from the
+ * core heap the first time they are needed. Such a stack has the same
+ * layout as an element of stack_thread[] and is never freed.
+ */
+#define DYN_STACK_SIZE		sizeof(stack_thread[0])
+#define DYN_STACK_BASE(n)	((uint32_t *)(threads[(n)].stack_va_end + \
+					      STACK_CANARY_SIZE / 2 - \
+					      DYN_STACK_SIZE))
+#define DYN_STACK_WORDS		(DYN_STACK_SIZE / sizeof(uint32_t))
 #endif
 
 #define GET_STACK_TOP_HARD(stack, n) \
@@ -73,6 +87,18 @@ DECLARE_KEEP_PAGER(stack_tmp_stride);
 
 static unsigned int thread_global_lock __nex_bss = SPINLOCK_UNLOCK;
 
+/*
+ * Number of calls refused because no thread was available, protected by
+ * thread_global_lock
+ */
+static unsigned int thread_limit_hits;
+
+/* Threads allowed to be active at the same time, see thread_set_quota() */
+static size_t thread_quota = CFG_NUM_THREADS;
+
+/* Highest number of threads active at the same time */
+static unsigned int thread_active_peak;
+
 void thread_init_canaries(void)
 {
 #ifdef CFG_WITH_STACK_CANARIES
@@ -90,6 +116,13 @@ void thread_init_canaries(void)
 	INIT_CANARY(stack_abt);
 #if !defined(CFG_WITH_PAGER) && !defined(CFG_NS_VIRTUALIZATION)
 	INIT_CANARY(stack_thread);
+	for (n = CFG_NUM_THREADS_STATIC; n < CFG_NUM_THREADS; n++) {
+		if (threads[n].stack_va_end) {
+			DYN_STACK_BASE(n)[0] = start_canary_value;
+			DYN_STACK_BASE(n)[DYN_STACK_WORDS - 1] =
+				end_canary_value;
+		}
+	}
 #endif
 #endif/*CFG_WITH_STACK_CANARIES*/
 }
@@ -154,6 +187,17 @@ void thread_check_canaries(void)
 		if (*canary != end_canary_value)
 			CANARY_DIED(stack_thread, end, n, canary);
 	}
+
+	for (n = CFG_NUM_THREADS_STATIC; n < CFG_NUM_THREADS; n++) {
+		if (!threads[n].stack_va_end)
+			continue;
+		canary = DYN_STACK_BASE(n);
+		if (*canary != start_canary_value)
+			CANARY_DIED(dyn_stack_thread, start, n, canary);
+		canary = DYN_STACK_BASE(n) + DYN_STACK_WORDS - 1;
+		if (*canary != end_canary_value)
+			CANARY_DIED(dyn_stack_thread, end, n, canary);
+	}
 #endif
 #endif/*CFG_WITH_STACK_CANARIES*/
 }
@@ -168,6 +212,116 @@ void thread_unlock_global(void)
 	cpu_spin_unlock(&thread_global_lock);
 }
 
+#if !defined(CFG_WITH_PAGER)
+static bool alloc_thread_stack(size_t n)
+{
+	uint32_t *stack = NULL;
+
+	stack = memalign(STACK_ALIGNMENT, DYN_STACK_SIZE);
+	if (!stack)
+		return false;
+
+#ifdef CFG_WITH_STACK_CANARIES
+	stack[0] = start_canary_value;
+	stack[DYN_STACK_WORDS - 1] = end_canary_value;
+#endif
+	threads[n].stack_va_end = (vaddr_t)stack + DYN_STACK_SIZE -
+				  STACK_CANARY_SIZE / 2;
+	DMSG("thr [%zu] stack allocated at 0x%" PRIxVA, n,
+	     threads[n].stack_va_end);
+
+	return true;
+}
+#else
+static bool alloc_thread_stack(size_t n __unused)
+{
+	return false;
+}
+#endif
+
+void thread_set_quota(size_t quota)
+{
+	assert(quota && quota <= CFG_NUM_THREADS);
+
+	thread_lock_global();
+	thread_quota = quota;
+	thread_unlock_global();
+}
+
+bool thread_claim_free(size_t *thread_idx)
+{
+	bool found_thread = false;
+	size_t active = 0;
+	size_t n = 0;
+
+	thread_lock_global();
+
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		if (threads[n].state != THREAD_STATE_FREE)
+			active++;
+
+	/* Prefer a thread which already has a stack */
+	for (n = 0; n < CFG_NUM_THREADS && active < thread_quota; n++) {
+		if (threads[n].state == THREAD_STATE_FREE &&
+		    threads[n].stack_va_end) {
+			found_thread = true;
+			break;
+		}
+	}
+	if (!found_thread && active < thread_quota &&
+	    CFG_NUM_THREADS_STATIC < CFG_NUM_THREADS) {
+		for (n = 0; n < CFG_NUM_THREADS; n++) {
+			if (threads[n].state == THREAD_STATE_FREE) {
+				found_thread = true;
+				break;
+			}
+		}
+	}
+
+	if (found_thread) {
+		threads[n].state = THREAD_STATE_ACTIVE;
+		thread_active_peak = MAX(thread_active_peak, active + 1);
+	} else {
+		thread_limit_hits++;
+	}
+
+	thread_unlock_global();
+
+	/*
+	 * The stack is allocated outside of the global lock, the thread is
+	 * already marked active so no other core can claim it meanwhile.
+	 */
+	if (found_thread && !threads[n].stack_va_end &&
+	    !alloc_thread_stack(n)) {
+		thread_lock_global();
+		threads[n].state = THREAD_STATE_FREE;
+		thread_limit_hits++;
+		thread_unlock_global();
+		found_thread = false;
+	}
+
+	*thread_idx = n;
+	return found_thread;
+}
+
+void thread_get_pool_stats(unsigned int *limit_hits, unsigned int *stacks,
+			   unsigned int *quota, unsigned int *peak)
+{
+	unsigned int count = 0;
+	size_t n = 0;
+
+	thread_lock_global();
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		if (threads[n].stack_va_end)
+			count++;
+	*limit_hits = thread_limit_hits;
+	*quota = thread_quota;
+	*peak = thread_active_peak;
+	thread_unlock_global();
+
+	*stacks = count;
+}
+
 static struct thread_core_local * __nostackcheck
 get_core_local(unsigned int pos)
 {
@@ -208,6 +362,8 @@ static void print_stack_limits(void)
 	}
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		end = threads[n].stack_va_end;
+		if (!end)
+			continue;
 		start = end - STACK_THREAD_SIZE + STACK_CHECK_EXTRA;
 		DMSG("thr [%zu] 0x%" PRIxVA "..0x%" PRIxVA, n, start, end);
 	}
@@ -453,8 +609,14 @@ static void init_thread_stacks(void)
 {
 	size_t n;
 
-	/* Assign the thread stacks */
-	for (n = 0; n < CFG_NUM_THREADS; n++)
+	COMPILE_TIME_ASSERT(CFG_NUM_THREADS_STATIC > 0 &&
+			    CFG_NUM_THREADS_STATIC <= CFG_NUM_THREADS);
+
+	/*
+	 * Assign the static thread stacks, the remaining threads get their
+	 * stacks on demand in thread_claim_free().
+	 */
+	for (n = 0; n < CFG_NUM_THREADS_STATIC; n++)
 		threads[n].stack_va_end = GET_STACK_BOTTOM(stack_thread, n);
 }
 #endif /*CFG_WITH_PAGER*/
@@ -523,6 +685,30 @@ struct thread_specific_data * __noprof thread_get_tsd(void)
 	return &threads[thread_get_id()].tsd;
 }
 
+#if CFG_CORE_YIELD_INTERVAL_US
+void thread_yield_point(void)
+{
+	struct thread_specific_data *tsd = NULL;
+	uint64_t now = 0;
+
+	if (thread_foreign_intr_disabled() || !thread_is_in_normal_mode() ||
+	    thread_get_id_may_fail() == THREAD_ID_INVALID)
+		return;
+
+	tsd = thread_get_tsd();
+	now = delay_cnt_read();
+	if (!tsd->yield_stamp) {
+		tsd->yield_stamp = now;
+		return;
+	}
+	if (now - tsd->yield_stamp < delay_us2cnt(CFG_CORE_YIELD_INTERVAL_US))
+		return;
+
+	thread_rpc_yield();
+	/* Entering secure world again has cleared yield_stamp */
+}
+#endif
+
 struct thread_ctx_regs * __nostackcheck thread_get_ctx_regs(void)
 {
 	struct thread_core_local *l = thread_get_core_local();
@@ -690,3 +876,104 @@ void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache)
 		free(ce);
 	}
 }
+
+void thread_rpc_shm_cache_trim(struct thread_shm_cache *cache)
+{
+	struct thread_shm_cache_entry *ce = NULL;
+	struct thread_shm_cache_entry *next = NULL;
+
+	SLIST_FOREACH_SAFE(ce, cache, link, next) {
+		if (ce->type == THREAD_SHM_TYPE_KERNEL_PRIVATE && ce->mobj)
+			continue;
+		SLIST_REMOVE(cache, ce, thread_shm_cache_entry, link);
+		clear_shm_cache_entry(ce);
+		free(ce);
+	}
+}
+
+struct mobj *thread_rpc_shm_cache_pop_kernel(struct thread_shm_cache *cache)
+{
+	struct thread_shm_cache_entry *ce = NULL;
+	struct mobj *mobj = NULL;
+
+	SLIST_FOREACH(ce, cache, link)
+		if (ce->type == THREAD_SHM_TYPE_KERNEL_PRIVATE && ce->mobj)
+			break;
+	if (!ce)
+		return NULL;
+
+	SLIST_REMOVE(cache, ce, thread_shm_cache_entry, link);
+	mobj = ce->mobj;
+	free(ce);
+
+	return mobj;
+}
+
+#ifdef CFG_CORE_THREAD_TIME_STATS
+struct thread_core_time_stats {
+	uint64_t run_ticks;
+	uint64_t entries;
+};
+
+static struct thread_core_time_stats core_time_stats[CFG_TEE_CORE_NB_CORE];
+
+void thread_time_stats_enter(size_t thread_idx)
+{
+	struct thread_time_stats *s = &threads[thread_idx].time_stats;
+	uint64_t now = delay_cnt_read();
+
+	/* @stamp is cleared when the thread is freed */
+	if (s->stamp)
+		s->suspended_ticks += now - s->stamp;
+	s->stamp = now;
+	s->resumes++;
+	core_time_stats[get_core_pos()].entries++;
+}
+
+void thread_time_stats_exit(size_t thread_idx, bool freed)
+{
+	struct thread_time_stats *s = &threads[thread_idx].time_stats;
+	uint64_t now = delay_cnt_read();
+	uint64_t ticks = 0;
+
+	/* The boot thread isn't accounted when started */
+	if (s->stamp)
+		ticks = now - s->stamp;
+	s->run_ticks += ticks;
+	core_time_stats[get_core_pos()].run_ticks += ticks;
+
+	if (freed)
+		s->stamp = 0;
+	else
+		s->stamp = now;
+}
+
+void thread_time_stats_wait_begin(void)
+{
+	threads[thread_get_id()].time_stats.wait_stamp = delay_cnt_read();
+}
+
+void thread_time_stats_wait_end(void)
+{
+	struct thread_time_stats *s = &threads[thread_get_id()].time_stats;
+
+	s->wait_ticks += delay_cnt_read() - s->wait_stamp;
+}
+
+void thread_get_time_stats(size_t thread_idx, struct thread_time_stats *stats)
+{
+	assert(thread_idx < CFG_NUM_THREADS);
+
+	/* Updated locklessly by the CPU running the thread */
+	*stats = threads[thread_idx].time_stats;
+}
+
+void thread_get_core_time_stats(size_t core_pos, uint64_t *run_ticks,
+				uint64_t *entries)
+{
+	assert(core_pos < CFG_TEE_CORE_NB_CORE);
+
+	*run_ticks = core_time_stats[core_pos].run_ticks;
+	*entries = core_time_stats[core_pos].entries;
+}
+#endif /*CFG_CORE_THREAD_TIME_STATS*/
@@ -5,13 +5,47 @@
 
 #include <compiler.h>
 #include <kernel/dt.h>
+#include <kernel/mutex.h>
 #include <kernel/tpm.h>
 #include <libfdt.h>
 #include <mm/core_memprot.h>
+#include <stdlib.h>
 #include <string.h>
 
+/* Size of a TCG_PCR_EVENT header: PCR index, type, SHA1 digest, size */
+#define TPM_EVENT_HDR_SIZE	32
+/* Offset of the number of algorithms in a TCG_EfiSpecIDEvent */
+#define TPM_SPEC_ID_ALGS_OFFS	24
+#define TPM_SPEC_ID_SIGNATURE	"Spec ID Event03"
+#define TPM_EV_NO_ACTION	3
+#define TPM_MAX_ALGS		8
+
+struct tpm_alg {
+	uint16_t id;
+	uint16_t digest_size;
+};
+
 static void *tpm_log_addr;
+/* Bytes used by the events of the log */
 static size_t tpm_log_size;
+/* Bytes available for the log, events can be appended up to this size */
+static size_t tpm_log_max_size;
+/* Whether the whole log could be indexed and events can be appended */
+static bool tpm_log_appendable;
+
+/*
+ * Digest algorithms of a crypto agile log, as found in its first event.
+ * None for a log in the SHA1 format where all events are TCG_PCR_EVENT.
+ */
+static struct tpm_alg tpm_algs[TPM_MAX_ALGS];
+static size_t tpm_alg_count;
+
+/* Offset in the log of each event, plus the end of the last event */
+static uint32_t *tpm_log_index;
+static size_t tpm_event_count;
+static size_t tpm_index_size;
+
+static struct mutex tpm_log_mu = MUTEX_INITIALIZER;
 
 /*
  * Check whether the node at @offs contains TPM Event Log information or not.
@@ -103,50 +137,312 @@ static void get_tpm_phys_params(void *fdt __maybe_unused,
 #endif /* CFG_DT */
 }
 
+static uint32_t get_u32(const uint8_t *p)
+{
+	uint32_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+	uint16_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/*
+ * Return the size of the TCG_PCR_EVENT at @ev, or 0 if it doesn't fit in
+ * @len bytes.
+ */
+static size_t sha1_event_size(const uint8_t *ev, size_t len)
+{
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (len < TPM_EVENT_HDR_SIZE)
+		return 0;
+	/* A zeroed header is where the used part of the log area ends */
+	while (n < TPM_EVENT_HDR_SIZE && !ev[n])
+		n++;
+	if (n == TPM_EVENT_HDR_SIZE)
+		return 0;
+	sz = get_u32(ev + TPM_EVENT_HDR_SIZE - sizeof(uint32_t));
+	if (sz > len - TPM_EVENT_HDR_SIZE)
+		return 0;
+
+	return TPM_EVENT_HDR_SIZE + sz;
+}
+
+/*
+ * Return the size of the TCG_PCR_EVENT2 at @ev, or 0 if it doesn't fit in
+ * @len bytes or isn't valid. An event without digest is where the used
+ * part of a zero filled log area ends.
+ */
+static size_t event2_size(const uint8_t *ev, size_t len)
+{
+	size_t count = 0;
+	size_t offs = 0;
+	size_t sz = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	/* PCR index, event type and digest count */
+	offs = 3 * sizeof(uint32_t);
+	if (len < offs)
+		return 0;
+	count = get_u32(ev + 2 * sizeof(uint32_t));
+	if (!count || count > tpm_alg_count)
+		return 0;
+
+	for (n = 0; n < count; n++) {
+		if (len - offs < sizeof(uint16_t))
+			return 0;
+		for (m = 0; m < tpm_alg_count; m++)
+			if (tpm_algs[m].id == get_u16(ev + offs))
+				break;
+		if (m == tpm_alg_count)
+			return 0;
+		offs += sizeof(uint16_t);
+		if (len - offs < tpm_algs[m].digest_size)
+			return 0;
+		offs += tpm_algs[m].digest_size;
+	}
+
+	if (len - offs < sizeof(uint32_t))
+		return 0;
+	sz = get_u32(ev + offs);
+	offs += sizeof(uint32_t);
+	if (sz > len - offs)
+		return 0;
+
+	return offs + sz;
+}
+
+static size_t event_size(const uint8_t *ev, size_t len)
+{
+	if (tpm_alg_count)
+		return event2_size(ev, len);
+	return sha1_event_size(ev, len);
+}
+
+/* Read the digest algorithms from the Spec ID event of a crypto agile log */
+static void parse_spec_id_event(const uint8_t *ev, size_t len)
+{
+	const uint8_t *spec_id = ev + TPM_EVENT_HDR_SIZE;
+	const uint8_t *algs = spec_id + TPM_SPEC_ID_ALGS_OFFS +
+			      sizeof(uint32_t);
+	size_t n = 0;
+
+	if (algs > ev + len ||
+	    get_u32(ev + sizeof(uint32_t)) != TPM_EV_NO_ACTION ||
+	    memcmp(spec_id, TPM_SPEC_ID_SIGNATURE,
+		   sizeof(TPM_SPEC_ID_SIGNATURE)))
+		return;
+
+	n = get_u32(spec_id + TPM_SPEC_ID_ALGS_OFFS);
+	if (!n || n > TPM_MAX_ALGS ||
+	    (size_t)(ev + len - algs) < n * sizeof(struct tpm_alg))
+		return;
+
+	for (tpm_alg_count = 0; tpm_alg_count < n; tpm_alg_count++) {
+		tpm_algs[tpm_alg_count].id = get_u16(algs);
+		tpm_algs[tpm_alg_count].digest_size =
+			get_u16(algs + sizeof(uint16_t));
+		algs += sizeof(struct tpm_alg);
+	}
+}
+
+static TEE_Result index_event(size_t end)
+{
+	uint32_t *idx = NULL;
+	size_t sz = 0;
+
+	if (tpm_event_count + 1 >= tpm_index_size) {
+		sz = MAX(tpm_index_size * 2, (size_t)16);
+		idx = realloc(tpm_log_index, sz * sizeof(*idx));
+		if (!idx)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		tpm_log_index = idx;
+		tpm_index_size = sz;
+	}
+
+	tpm_event_count++;
+	tpm_log_index[tpm_event_count] = end;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Index the events of the log once. The first event is always in the
+ * SHA1 format, the next ones are in the crypto agile format if the first
+ * event is a Spec ID event.
+ */
+static void index_log(void)
+{
+	const uint8_t *log = tpm_log_addr;
+	size_t offs = 0;
+	size_t sz = 0;
+
+	sz = sha1_event_size(log, tpm_log_max_size);
+	if (!sz)
+		goto out;
+	parse_spec_id_event(log, sz);
+
+	tpm_log_index = calloc(1, sizeof(*tpm_log_index));
+	if (!tpm_log_index)
+		goto out;
+	tpm_index_size = 1;
+
+	do {
+		if (index_event(offs + sz))
+			break;
+		offs += sz;
+		sz = event_size(log + offs, tpm_log_max_size - offs);
+	} while (sz);
+
+out:
+	DMSG("TPM: %zu events in %zu bytes", tpm_event_count, offs);
+
+	/*
+	 * Anything but zeroes after the last event is left as is, the log is
+	 * then handed out whole and can't be appended to.
+	 */
+	for (sz = offs; sz < tpm_log_max_size; sz++)
+		if (log[sz])
+			break;
+	if (sz == tpm_log_max_size) {
+		tpm_log_size = offs;
+		tpm_log_appendable = tpm_log_index != NULL;
+	} else {
+		EMSG("TPM: Unparsed data at offset %zu", offs);
+		tpm_log_size = tpm_log_max_size;
+	}
+}
+
 TEE_Result tpm_get_event_log(void *buf, size_t *size)
 {
 	const size_t buf_size = *size;
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_read_lock(&tpm_log_mu);
 
 	*size = tpm_log_size;
 	if (!buf) {
 		EMSG("TPM: Invalid buffer");
-		return TEE_ERROR_BAD_PARAMETERS;
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
 	}
 
 	if (buf_size < tpm_log_size) {
 		EMSG("TPM: Not enough space for the log: %zu, %zu",
 		     buf_size, tpm_log_size);
-		return TEE_ERROR_SHORT_BUFFER;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
 	}
 
 	memcpy(buf, tpm_log_addr, tpm_log_size);
 
-	return TEE_SUCCESS;
+out:
+	mutex_read_unlock(&tpm_log_mu);
+
+	return res;
 }
 
 TEE_Result tpm_get_event_log_size(size_t *size)
 {
+	mutex_read_lock(&tpm_log_mu);
 	*size = tpm_log_size;
+	mutex_read_unlock(&tpm_log_mu);
 
 	return TEE_SUCCESS;
 }
 
+TEE_Result tpm_read_events(size_t first, void *buf, size_t *size,
+			   size_t *count, size_t *total)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t last = 0;
+
+	mutex_read_lock(&tpm_log_mu);
+
+	*total = tpm_event_count;
+	*count = 0;
+	if (first >= tpm_event_count) {
+		*size = 0;
+		goto out;
+	}
+
+	/* Whole events only, at least the first one */
+	for (last = first + 1; last < tpm_event_count; last++)
+		if (tpm_log_index[last + 1] - tpm_log_index[first] > *size)
+			break;
+	if (tpm_log_index[first + 1] - tpm_log_index[first] > *size) {
+		*size = tpm_log_index[first + 1] - tpm_log_index[first];
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	*size = tpm_log_index[last] - tpm_log_index[first];
+	*count = last - first;
+	memcpy(buf, (uint8_t *)tpm_log_addr + tpm_log_index[first], *size);
+
+out:
+	mutex_read_unlock(&tpm_log_mu);
+
+	return res;
+}
+
+TEE_Result tpm_append_event(const void *event, size_t size)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!tpm_log_appendable)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (event_size(event, size) != size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&tpm_log_mu);
+
+	if (size > tpm_log_max_size - tpm_log_size) {
+		res = TEE_ERROR_STORAGE_NO_SPACE;
+		goto out;
+	}
+
+	res = index_event(tpm_log_size + size);
+	if (res)
+		goto out;
+	memcpy((uint8_t *)tpm_log_addr + tpm_log_size, event, size);
+	tpm_log_size += size;
+
+out:
+	mutex_unlock(&tpm_log_mu);
+
+	return res;
+}
+
 void tpm_map_log_area(void *fdt)
 {
 	paddr_t log_addr = 0;
 	unsigned int rounded_size = 0;
 
-	get_tpm_phys_params(fdt, &log_addr, &tpm_log_size);
+	get_tpm_phys_params(fdt, &log_addr, &tpm_log_max_size);
 
 	DMSG("TPM Event log PA: %#" PRIxPA, log_addr);
-	DMSG("TPM Event log size: %zu Bytes", tpm_log_size);
+	DMSG("TPM Event log size: %zu Bytes", tpm_log_max_size);
 
-	rounded_size = ROUNDUP(tpm_log_size, SMALL_PAGE_SIZE);
+	rounded_size = ROUNDUP(tpm_log_max_size, SMALL_PAGE_SIZE);
 
 	tpm_log_addr = core_mmu_add_mapping(MEM_AREA_RAM_SEC, log_addr,
 					    rounded_size);
 	if (!tpm_log_addr) {
 		EMSG("TPM: Failed to map TPM log memory");
+		tpm_log_max_size = 0;
 		return;
 	}
+
+	index_log();
 }
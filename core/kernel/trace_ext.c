@@ -2,14 +2,20 @@
 /*
  * Copyright (c) 2014, Linaro Limited
  */
+#include <atomic.h>
 #include <stdbool.h>
 #include <trace.h>
 #include <console.h>
 #include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ring.h>
 #include <kernel/virtualization.h>
+#include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <pta_trace_ring.h>
+#include <string.h>
+#include <util.h>
 
 const char trace_ext_prefix[] = "TC";
 int trace_level __nex_data = TRACE_LEVEL;
@@ -19,6 +25,181 @@ void __weak plat_trace_ext_puts(const char *str __unused)
 {
 }
 
+#ifdef CFG_CORE_TRACE_RING
+/* Smallest ring per core accepted in non-secure memory */
+#define TRACE_RING_SHM_MIN	256
+
+/*
+ * Each core appends to its own ring, so the lock of a ring is only
+ * contended while trace_ring_read() copies from it. @head and @tail are
+ * running byte counts, @head - @tail bytes are buffered.
+ */
+struct trace_ring {
+	unsigned int lock;
+	size_t head;
+	size_t tail;
+	char buf[CFG_CORE_TRACE_RING_SIZE];
+};
+
+/*
+ * A ring in non-secure memory, registered by the normal world. It's
+ * written without lock, the normal world only reads it. The head is
+ * kept in secure memory too so the normal world can't redirect writes.
+ */
+struct trace_ring_shm {
+	struct pta_trace_ring_hdr *hdr;
+	char *data;
+	size_t size;
+	uint64_t head;
+};
+
+static struct trace_ring trace_rings[CFG_TEE_CORE_NB_CORE] __nex_bss;
+static struct trace_ring_shm trace_rings_shm[CFG_TEE_CORE_NB_CORE] __nex_bss;
+static bool trace_rings_shm_ready __nex_bss;
+/* Claimed by the trace_ring_set_shm() call setting up the rings */
+static unsigned int trace_rings_shm_claimed __nex_bss;
+static bool trace_ring_flushed __nex_bss;
+
+static void trace_ring_shm_puts(struct trace_ring_shm *r, const char *str)
+{
+	const char *p = NULL;
+
+	for (p = str; *p; p++) {
+		r->data[r->head % r->size] = *p;
+		r->head++;
+	}
+	/* Publish the head after the data it covers */
+	__atomic_store_n(&r->hdr->head, r->head, __ATOMIC_RELEASE);
+}
+
+static bool trace_ring_puts(const char *str)
+{
+	struct trace_ring *r = NULL;
+	const char *p = NULL;
+
+	/* Exceptions are masked by the caller */
+	if (!cpu_mmu_enabled() || trace_ring_flushed)
+		return false;
+
+	if (__atomic_load_n(&trace_rings_shm_ready, __ATOMIC_ACQUIRE)) {
+		trace_ring_shm_puts(trace_rings_shm + get_core_pos(), str);
+		return true;
+	}
+
+	r = trace_rings + get_core_pos();
+	cpu_spin_lock(&r->lock);
+	for (p = str; *p; p++) {
+		r->buf[r->head % sizeof(r->buf)] = *p;
+		r->head++;
+	}
+	if (r->head - r->tail > sizeof(r->buf))
+		r->tail = r->head - sizeof(r->buf);
+	cpu_spin_unlock(&r->lock);
+
+	return true;
+}
+
+static size_t trace_ring_copy(struct trace_ring *r, char *buf, size_t len)
+{
+	size_t offs = r->tail % sizeof(r->buf);
+	size_t n = 0;
+
+	len = MIN(len, r->head - r->tail);
+	n = MIN(len, sizeof(r->buf) - offs);
+	memcpy(buf, r->buf + offs, n);
+	memcpy(buf + n, r->buf, len - n);
+
+	return len;
+}
+
+size_t trace_ring_read(char *buf, size_t len)
+{
+	uint32_t exceptions = 0;
+	struct trace_ring *r = NULL;
+	size_t offs = 0;
+	size_t n = 0;
+	size_t l = 0;
+
+	for (n = 0; n < ARRAY_SIZE(trace_rings) && offs < len; n++) {
+		r = trace_rings + n;
+		exceptions = cpu_spin_lock_xsave(&r->lock);
+		l = trace_ring_copy(r, buf + offs, len - offs);
+		r->tail += l;
+		cpu_spin_unlock_xrestore(&r->lock, exceptions);
+		offs += l;
+	}
+
+	return offs;
+}
+
+TEE_Result trace_ring_set_shm(paddr_t pa, size_t len)
+{
+	struct trace_ring_shm *r = NULL;
+	unsigned int claimed = 0;
+	size_t core_len = 0;
+	size_t n = 0;
+	char *va = NULL;
+
+	core_len = ROUNDDOWN(len / ARRAY_SIZE(trace_rings_shm),
+			     sizeof(uint64_t));
+	if (core_len < sizeof(struct pta_trace_ring_hdr) + TRACE_RING_SHM_MIN ||
+	    !IS_ALIGNED(pa, sizeof(uint64_t)) ||
+	    !core_pbuf_is(CORE_MEM_NON_SEC, pa, len))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Concurrent calls must not set up the rings twice */
+	if (!atomic_cas_uint(&trace_rings_shm_claimed, &claimed, 1))
+		return TEE_ERROR_BAD_STATE;
+
+	va = core_mmu_add_mapping(MEM_AREA_NEX_NSEC_SHM, pa, len);
+	if (!va) {
+		atomic_store_uint(&trace_rings_shm_claimed, 0);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(trace_rings_shm); n++) {
+		r = trace_rings_shm + n;
+		r->hdr = (void *)(va + n * core_len);
+		r->data = (char *)(r->hdr + 1);
+		r->size = core_len - sizeof(*r->hdr);
+		r->head = 0;
+		r->hdr->head = 0;
+		r->hdr->size = r->size;
+		r->hdr->reserved = 0;
+	}
+
+	/*
+	 * Traces already buffered in the secure rings stay there and can
+	 * still be read with trace_ring_read().
+	 */
+	__atomic_store_n(&trace_rings_shm_ready, true, __ATOMIC_RELEASE);
+
+	return TEE_SUCCESS;
+}
+
+void trace_ring_flush(void)
+{
+	char buf[64] = { };
+	size_t n = 0;
+
+	/* Everything from now on goes straight to the console */
+	trace_ring_flushed = true;
+
+	while (true) {
+		n = trace_ring_read(buf, sizeof(buf) - 1);
+		if (!n)
+			break;
+		buf[n] = '\0';
+		trace_ext_puts(buf);
+	}
+}
+#else
+static bool trace_ring_puts(const char *str __unused)
+{
+	return false;
+}
+#endif
+
 void trace_ext_puts(const char *str)
 {
 	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
@@ -26,6 +207,11 @@ void trace_ext_puts(const char *str)
 	bool was_contended = false;
 	const char *p;
 
+	if (trace_ring_puts(str)) {
+		thread_unmask_exceptions(itr_status);
+		return;
+	}
+
 	if (mmu_enabled && !cpu_spin_trylock(&puts_lock)) {
 		was_contended = true;
 		cpu_spin_lock_no_dldetect(&puts_lock);
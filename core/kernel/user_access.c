@@ -108,20 +108,67 @@ TEE_Result copy_to_user_private(void *uaddr, const void *kaddr, size_t len)
 	return res;
 }
 
-static void *maybe_tag_bb(void *buf, size_t sz)
+#if defined(CFG_MEMTAG_BB_TAG_CACHE)
+/*
+ * Freed bounce buffer allocations keep their tags. An allocation of the
+ * same size at the same offset, the common case when a syscall is repeated,
+ * is given the cached tag back instead of tagging the region again.
+ */
+static void *tag_bb_cached(struct user_mode_ctx *uctx, size_t offs,
+			   size_t sz)
+{
+	struct bb_tag_entry *e = NULL;
+	void *buf = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < BB_TAG_CACHE_ENTRIES; n++) {
+		e = uctx->bbuf_tags + n;
+		if (e->len == sz && e->offs == offs)
+			return memtag_insert_tag(uctx->bbuf + offs, e->tag);
+	}
+
+	/* Regions overlapping the one tagged below lose their tags */
+	for (n = 0; n < BB_TAG_CACHE_ENTRIES; n++) {
+		e = uctx->bbuf_tags + n;
+		if (e->offs < offs + sz && offs < e->offs + e->len)
+			e->len = 0;
+	}
+
+	buf = memtag_set_random_tags(uctx->bbuf + offs, sz);
+
+	e = uctx->bbuf_tags + uctx->bbuf_tags_next;
+	e->offs = offs;
+	e->len = sz;
+	e->tag = memtag_get_tag(buf);
+	uctx->bbuf_tags_next = (uctx->bbuf_tags_next + 1) %
+			       BB_TAG_CACHE_ENTRIES;
+
+	return buf;
+}
+#endif
+
+static void *maybe_tag_bb(struct user_mode_ctx *uctx, size_t offs, size_t sz)
 {
+	void *buf = uctx->bbuf + offs;
+
 	static_assert(MEMTAG_GRANULE_SIZE <= BB_ALIGNMENT);
 
 	if (!MEMTAG_IS_ENABLED)
 		return buf;
 
 	assert(!((vaddr_t)buf % MEMTAG_GRANULE_SIZE));
-	return memtag_set_random_tags(buf, ROUNDUP(sz, MEMTAG_GRANULE_SIZE));
+	sz = ROUNDUP(sz, MEMTAG_GRANULE_SIZE);
+#if defined(CFG_MEMTAG_BB_TAG_CACHE)
+	return tag_bb_cached(uctx, offs, sz);
+#else
+	return memtag_set_random_tags(buf, sz);
+#endif
 }
 
 static void maybe_untag_bb(void *buf, size_t sz)
 {
-	if (MEMTAG_IS_ENABLED) {
+	/* With the tag cache, tags are only replaced on the next allocation */
+	if (MEMTAG_IS_ENABLED && !IS_ENABLED(CFG_MEMTAG_BB_TAG_CACHE)) {
 		assert(!((vaddr_t)buf % MEMTAG_GRANULE_SIZE));
 		memtag_set_tags(buf, ROUNDUP(sz, MEMTAG_GRANULE_SIZE), 0);
 	}
@@ -135,7 +182,7 @@ void *bb_alloc(size_t len)
 
 	if (uctx && !ADD_OVERFLOW(uctx->bbuf_offs, len, &offs) &&
 	    offs <= uctx->bbuf_size) {
-		bb = maybe_tag_bb(uctx->bbuf + uctx->bbuf_offs, len);
+		bb = maybe_tag_bb(uctx, uctx->bbuf_offs, len);
 		uctx->bbuf_offs = ROUNDUP(offs, BB_ALIGNMENT);
 	}
 	return bb;
@@ -178,7 +225,8 @@ void bb_reset(void)
 {
 	struct user_mode_ctx *uctx = get_current_uctx();
 
-	if (uctx) {
+	/* Most syscalls don't bounce anything, nothing to reset then */
+	if (uctx && uctx->bbuf_offs) {
 		/*
 		 * Only the part up to the offset have been allocated, so
 		 * no need to clear tags beyond that.
@@ -10,10 +10,12 @@
 #include <crypto/crypto.h>
 #include <initcall.h>
 #include <keep.h>
+#include <kernel/delay.h>
 #include <kernel/ldelf_loader.h>
 #include <kernel/linker.h>
 #include <kernel/panic.h>
 #include <kernel/scall.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/ts_store.h>
@@ -31,8 +33,10 @@
 #include <mm/vm.h>
 #include <optee_rpc_cmd.h>
 #include <printk.h>
+#include <pta_stats.h>
 #include <signed_hdr.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/tee_obj.h>
@@ -144,6 +148,193 @@ static void dec_recursion(void)
 	tsd->syscall_recursion--;
 }
 
+#if defined(CFG_TA_RESOURCE_STATS)
+uint64_t user_ta_acct_stamp(void)
+{
+	uint64_t stamp = delay_cnt_read();
+#if defined(CFG_CORE_THREAD_TIME_STATS)
+	struct thread_time_stats s = { };
+
+	thread_get_time_stats(thread_get_id(), &s);
+	stamp -= s.suspended_ticks;
+#endif
+
+	return stamp;
+}
+
+/* Returns the TA which user mapping is active on this thread, if any */
+static struct user_ta_ctx *current_utc(void)
+{
+	struct ts_ctx *ctx = thread_get_tsd()->ctx;
+
+	if (!ctx || !is_user_ta_ctx(ctx))
+		return NULL;
+	return to_user_ta_ctx(ctx);
+}
+
+/* Latency histograms of the syscalls of all user TAs */
+struct syscall_latency {
+	uint32_t count;
+	uint64_t total_ticks;
+	uint64_t max_ticks;
+	uint32_t buckets[STATS_SYSCALL_LAT_BUCKETS];
+};
+
+static struct syscall_latency syscall_lat[TEE_SCN_MAX + 1];
+static unsigned int syscall_lat_lock = SPINLOCK_UNLOCK;
+
+static uint64_t ticks_to_us(uint64_t ticks)
+{
+	uint64_t freq = delay_cnt_freq();
+
+	return (ticks / freq) * 1000000 + (ticks % freq) * 1000000 / freq;
+}
+
+static void syscall_lat_add(size_t scn, uint64_t ticks)
+{
+	uint64_t us = ticks_to_us(ticks);
+	struct syscall_latency *l = NULL;
+	uint32_t exceptions = 0;
+	size_t b = 0;
+
+	if (scn > TEE_SCN_MAX)
+		return;
+
+	/* Bucket 0 is below 1 us, bucket b is [2^(b-1), 2^b) us */
+	if (us)
+		b = MIN(64 - __builtin_clzll(us),
+			STATS_SYSCALL_LAT_BUCKETS - 1);
+
+	l = syscall_lat + scn;
+	exceptions = cpu_spin_lock_xsave(&syscall_lat_lock);
+	l->count++;
+	l->total_ticks += ticks;
+	l->max_ticks = MAX(l->max_ticks, ticks);
+	l->buckets[b]++;
+	cpu_spin_unlock_xrestore(&syscall_lat_lock, exceptions);
+}
+
+TEE_Result user_ta_syscall_latency_stats(void *buf, size_t *buf_size)
+{
+	struct pta_stats_syscall_latency *stats = buf;
+	struct syscall_latency l = { };
+	uint32_t exceptions = 0;
+	size_t count = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (!buf_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < ARRAY_SIZE(syscall_lat); n++)
+		if (syscall_lat[n].count)
+			count++;
+
+	sz = count * sizeof(*stats);
+	if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (!IS_ALIGNED_WITH_TYPE(buf, uint64_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Syscall numbers first called meanwhile are left for the next call */
+	for (n = 0; n < ARRAY_SIZE(syscall_lat) && count; n++) {
+		exceptions = cpu_spin_lock_xsave(&syscall_lat_lock);
+		l = syscall_lat[n];
+		cpu_spin_unlock_xrestore(&syscall_lat_lock, exceptions);
+		if (!l.count)
+			continue;
+
+		stats->scn = n;
+		stats->count = l.count;
+		stats->total_us = ticks_to_us(l.total_ticks);
+		stats->max_us = ticks_to_us(l.max_ticks);
+		memcpy(stats->buckets, l.buckets, sizeof(l.buckets));
+		stats++;
+		count--;
+	}
+	*buf_size = sz - count * sizeof(*stats);
+
+	return TEE_SUCCESS;
+}
+
+void user_ta_acct_syscall(size_t scn, uint64_t stamp)
+{
+	struct user_ta_ctx *utc = current_utc();
+	uint64_t ticks = user_ta_acct_stamp() - stamp;
+	uint32_t exceptions = 0;
+
+	syscall_lat_add(scn, ticks);
+
+	if (!utc)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&utc->acct.lock);
+	utc->acct.kernel_ticks += ticks;
+	if (scn <= TEE_SCN_MAX)
+		utc->acct.syscalls[scn]++;
+	cpu_spin_unlock_xrestore(&utc->acct.lock, exceptions);
+}
+
+void user_ta_acct_page_fault(void)
+{
+	struct user_ta_ctx *utc = current_utc();
+	uint32_t exceptions = 0;
+
+	if (!utc)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&utc->acct.lock);
+	utc->acct.page_faults++;
+	cpu_spin_unlock_xrestore(&utc->acct.lock, exceptions);
+}
+
+void user_ta_acct_rpc(void)
+{
+	struct user_ta_ctx *utc = current_utc();
+	uint32_t exceptions = 0;
+
+	if (!utc)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&utc->acct.lock);
+	utc->acct.rpcs++;
+	cpu_spin_unlock_xrestore(&utc->acct.lock, exceptions);
+}
+
+static void acct_enter(struct user_ta_ctx *utc, uint64_t *stamp)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&utc->acct.lock);
+
+	utc->acct.last_active = delay_cnt_read();
+	utc->acct.running++;
+	cpu_spin_unlock_xrestore(&utc->acct.lock, exceptions);
+	*stamp = user_ta_acct_stamp();
+}
+
+static void acct_exit(struct user_ta_ctx *utc, uint64_t stamp)
+{
+	uint64_t ticks = user_ta_acct_stamp() - stamp;
+	uint32_t exceptions = cpu_spin_lock_xsave(&utc->acct.lock);
+
+	utc->acct.cpu_ticks += ticks;
+	utc->acct.last_active = delay_cnt_read();
+	utc->acct.running--;
+	cpu_spin_unlock_xrestore(&utc->acct.lock, exceptions);
+}
+#else
+static void acct_enter(struct user_ta_ctx *utc __unused,
+		       uint64_t *stamp __unused)
+{
+}
+
+static void acct_exit(struct user_ta_ctx *utc __unused,
+		      uint64_t stamp __unused)
+{
+}
+#endif
+
 static TEE_Result user_ta_enter(struct ts_session *session,
 				enum utee_entry_func func, uint32_t cmd)
 {
@@ -154,12 +345,20 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	struct tee_ta_session *ta_sess = to_ta_session(session);
 	struct ts_session *ts_sess __maybe_unused = NULL;
 	void *param_va[TEE_NUM_PARAMS] = { NULL };
+	uint64_t stamp = 0;
 
 	if (!inc_recursion()) {
 		/* Using this error code since we've run out of resources. */
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto out_clr_cancel;
 	}
+
+	/* Kept parameter mappings are only reused by the same session */
+	if (utc->param_sess != session || !ta_sess->param) {
+		vm_flush_param(&utc->uctx);
+		utc->param_sess = session;
+	}
+
 	if (ta_sess->param) {
 		/* Map user space memory */
 		res = vm_map_param(&utc->uctx, ta_sess->param, param_va);
@@ -182,11 +381,13 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	if (res)
 		goto out_pop_session;
 
+	acct_enter(utc, &stamp);
 	res = thread_enter_user_mode(func, kaddr_to_uref(session),
 				     (vaddr_t)usr_params, cmd, usr_stack,
 				     utc->uctx.entry_func, utc->uctx.is_32bit,
 				     &utc->ta_ctx.panicked,
 				     &utc->ta_ctx.panic_code);
+	acct_exit(utc, stamp);
 
 	thread_user_clear_vfp(&utc->uctx);
 
@@ -212,7 +413,8 @@ out_pop_session:
 	if (ta_sess->param) {
 		/*
 		 * Clear out the parameter mappings added with
-		 * vm_clean_param() above.
+		 * vm_map_param() above, registered shared memory may be
+		 * kept for the next call.
 		 */
 		vm_clean_param(&utc->uctx);
 	}
@@ -220,6 +422,12 @@ out_pop_session:
 	assert(ts_sess == session);
 
 out:
+	/* The session is gone, its address may be reused by a new one */
+	if (func == UTEE_ENTRY_FUNC_CLOSE_SESSION ||
+	    (func == UTEE_ENTRY_FUNC_OPEN_SESSION && res)) {
+		vm_flush_param(&utc->uctx);
+		utc->param_sess = NULL;
+	}
 	dec_recursion();
 out_clr_cancel:
 	/*
@@ -382,6 +590,8 @@ static void release_utc_state(struct user_ta_ctx *utc)
 	tee_svc_cryp_free_states(utc);
 	/* Close cryp objects opened by this TA */
 	tee_obj_close_all(utc);
+	/* Discard the changes of an uncommitted storage transaction */
+	tee_svc_storage_abort_transaction(utc);
 	/* Free emums created by this TA */
 	tee_svc_storage_close_all_enum(utc);
 }
@@ -504,7 +714,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	 * until this context is fully initialized. This is needed to
 	 * handle single instance TAs.
 	 */
-	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ta_ctx, link);
+	tee_ta_link_ctx(&utc->ta_ctx);
 
 	return TEE_SUCCESS;
 }
@@ -532,7 +742,7 @@ TEE_Result tee_ta_complete_user_ta_session(struct tee_ta_session *s)
 		utc->ta_ctx.is_initializing = false;
 	} else {
 		s->ts_sess.ctx = NULL;
-		TAILQ_REMOVE(&tee_ctxes, &utc->ta_ctx, link);
+		tee_ta_unlink_ctx(&utc->ta_ctx);
 		condvar_destroy(&utc->ta_ctx.busy_cv);
 		free_utc(utc);
 	}
@@ -83,8 +83,10 @@ static TEE_Result wq_wait_final_helper(struct wait_queue *wq,
 {
 	uint32_t old_itr_status = 0;
 
+	thread_time_stats_wait_begin();
 	do_notif(true, wqe->handle, timeout_ms, "sleep", sync_obj, fname,
 		 lineno);
+	thread_time_stats_wait_end();
 
 	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 	SLIST_REMOVE(wq, wqe, wait_queue_elem, link);
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <atomic.h>
+#include <initcall.h>
+#include <kernel/misc.h>
+#include <kernel/notif.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/workqueue.h>
+#include <util.h>
+
+#define WORK_STATE_IDLE		0
+#define WORK_STATE_QUEUED	1
+
+struct work_cpu_queue {
+	unsigned int lock;
+	TAILQ_HEAD(, work) head;
+};
+
+static struct work_cpu_queue work_queues[CFG_TEE_CORE_NB_CORE];
+static unsigned int worker_lock = SPINLOCK_UNLOCK;
+static unsigned int worker_count;
+
+void work_queue(struct work *w, void (*fn)(struct work *w))
+{
+	unsigned int state = WORK_STATE_IDLE;
+	struct work_cpu_queue *q = NULL;
+	uint32_t exceptions = 0;
+
+	if (!atomic_cas_uint(&w->state, &state, WORK_STATE_QUEUED))
+		return;
+
+	w->fn = fn;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	q = work_queues + get_core_pos();
+	cpu_spin_lock(&q->lock);
+	TAILQ_INSERT_TAIL(&q->head, w, link);
+	cpu_spin_unlock(&q->lock);
+	thread_unmask_exceptions(exceptions);
+
+	notif_send_async(NOTIF_VALUE_DO_BOTTOM_HALF, 0);
+}
+
+static struct work *pop_work_from(struct work_cpu_queue *q)
+{
+	struct work *w = NULL;
+
+	cpu_spin_lock(&q->lock);
+	w = TAILQ_FIRST(&q->head);
+	if (w)
+		TAILQ_REMOVE(&q->head, w, link);
+	cpu_spin_unlock(&q->lock);
+
+	return w;
+}
+
+/* Take work from the current CPU's queue first, then from the others */
+static struct work *pop_work(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	size_t pos = get_core_pos();
+	struct work *w = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(work_queues) && !w; n++)
+		w = pop_work_from(work_queues +
+				  (pos + n) % ARRAY_SIZE(work_queues));
+
+	thread_unmask_exceptions(exceptions);
+
+	return w;
+}
+
+static bool work_pending(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(work_queues); n++)
+		if (!TAILQ_EMPTY(&work_queues[n].head))
+			return true;
+
+	return false;
+}
+
+static bool claim_worker(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&worker_lock);
+	bool ret = false;
+
+	if (worker_count < CFG_CORE_WORKQUEUE_WORKERS) {
+		worker_count++;
+		ret = true;
+	}
+
+	cpu_spin_unlock_xrestore(&worker_lock, exceptions);
+
+	return ret;
+}
+
+static void release_worker(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&worker_lock);
+
+	assert(worker_count);
+	worker_count--;
+
+	cpu_spin_unlock_xrestore(&worker_lock, exceptions);
+}
+
+void workqueue_run(void)
+{
+	void (*fn)(struct work *w) = NULL;
+	struct work *w = NULL;
+
+	/*
+	 * The bottom half call requested for work queued after the last
+	 * pop_work() may have found all workers busy and returned, so
+	 * check again once released.
+	 */
+	do {
+		if (!claim_worker())
+			return;
+
+		while ((w = pop_work())) {
+			/* @w may be queued again as soon as it's idle */
+			fn = w->fn;
+			atomic_store_uint(&w->state, WORK_STATE_IDLE);
+			fn(w);
+		}
+
+		release_worker();
+	} while (work_pending());
+}
+
+static TEE_Result workqueue_init(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(work_queues); n++)
+		TAILQ_INIT(&work_queues[n].head);
+
+	return TEE_SUCCESS;
+}
+early_init(workqueue_init);
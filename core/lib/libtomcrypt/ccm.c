@@ -5,12 +5,14 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <crypto/crypto_accel.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
+#include <utee_defines.h>
 #include <util.h>
 
 #define TEE_CCM_KEY_MAX_LENGTH		32
@@ -121,6 +123,54 @@ static TEE_Result crypto_aes_ccm_update_aad(struct crypto_authenc_ctx *aectx,
 	return TEE_SUCCESS;
 }
 
+#ifdef _CFG_CORE_LTC_AES_ACCEL
+/*
+ * Processes the whole blocks at the start of @pt or @ct with the
+ * accelerated CCM routine and returns the number of bytes processed. The
+ * state is left as ccm_process() would have left it, apart from the
+ * CBC-MAC of the last block being computed already.
+ */
+static size_t ccm_process_accel(ccm_state *ccm, unsigned char *pt,
+				size_t len, unsigned char *ct, int dir)
+{
+	size_t block_count = len / TEE_AES_BLOCK_SIZE;
+	symmetric_key *skey = &ccm->K;
+
+	/* Errors are left to ccm_process() */
+	if (!block_count || ccm->aadlen != ccm->current_aadlen ||
+	    ccm->ptlen < ccm->current_ptlen + len)
+		return 0;
+
+	/* Only at a block boundary of the payload */
+	if (ccm->CTRlen != TEE_AES_BLOCK_SIZE)
+		return 0;
+	if (ccm->x == TEE_AES_BLOCK_SIZE) {
+		crypto_accel_aes_ecb_enc(ccm->PAD, ccm->PAD, skey->rijndael.eK,
+					 skey->rijndael.Nr, 1);
+		ccm->x = 0;
+	}
+
+	if (dir == CCM_ENCRYPT)
+		crypto_accel_aes_ccm_enc(ct, pt, skey->rijndael.eK,
+					 skey->rijndael.Nr, block_count,
+					 ccm->ctr, ccm->PAD);
+	else
+		crypto_accel_aes_ccm_dec(pt, ct, skey->rijndael.eK,
+					 skey->rijndael.Nr, block_count,
+					 ccm->ctr, ccm->PAD);
+	ccm->current_ptlen += block_count * TEE_AES_BLOCK_SIZE;
+
+	return block_count * TEE_AES_BLOCK_SIZE;
+}
+#else
+static size_t ccm_process_accel(ccm_state *ccm __unused,
+				unsigned char *pt __unused, size_t len __unused,
+				unsigned char *ct __unused, int dir __unused)
+{
+	return 0;
+}
+#endif
+
 static TEE_Result
 crypto_aes_ccm_update_payload(struct crypto_authenc_ctx *aectx,
 			      TEE_OperationMode mode, const uint8_t *src_data,
@@ -131,6 +181,8 @@ crypto_aes_ccm_update_payload(struct crypto_authenc_ctx *aectx,
 	struct tee_ccm_state *ccm = to_tee_ccm_state(aectx);
 	unsigned char *pt = NULL;
 	unsigned char *ct = NULL;
+	size_t head = 0;
+	size_t n = 0;
 
 	if (mode == TEE_MODE_ENCRYPT) {
 		pt = (unsigned char *)src_data;
@@ -141,7 +193,18 @@ crypto_aes_ccm_update_payload(struct crypto_authenc_ctx *aectx,
 		ct = (unsigned char *)src_data;
 		dir = CCM_DECRYPT;
 	}
-	ltc_res = ccm_process(&ccm->ctx, pt, len, ct, dir);
+
+	/* Complete a block started by a previous update first */
+	head = (TEE_AES_BLOCK_SIZE - ccm->ctx.CTRlen) % TEE_AES_BLOCK_SIZE;
+	head = MIN(head, len);
+	ltc_res = ccm_process(&ccm->ctx, pt, head, ct, dir);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	n = head + ccm_process_accel(&ccm->ctx, pt + head, len - head,
+				     ct + head, dir);
+
+	ltc_res = ccm_process(&ccm->ctx, pt + n, len - n, ct + n, dir);
 	if (ltc_res != CRYPT_OK)
 		return TEE_ERROR_BAD_STATE;
 
@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <mbedtls/bignum.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tomcrypt_private.h>
+#include <util.h>
+
+/*
+ * Fixed-base point multiplication for the NIST P-256 and P-384 generators
+ * using the comb method, the same way mbedtls_ecp_mul() does: a scalar of
+ * n bits costs n / COMB_W doublings and additions instead of one doubling
+ * and one addition per bit with ltc_ecc_mulmod().
+ *
+ * A comb table is computed the first time the generator of a curve is
+ * multiplied and kept until reboot. The table is always scanned in full
+ * and the scalar is recoded with signed odd digits so that neither the
+ * memory access pattern nor the sequence of point operations depends on
+ * the scalar.
+ *
+ * Any other point, or a scalar outside [1, order - 1], is handed over to
+ * ltc_ecc_mulmod().
+ */
+
+/* Comb width, a table holds 2^(COMB_W - 1) points */
+#define COMB_W			5
+#define COMB_POINTS		BIT(COMB_W - 1)
+/* Number of comb columns for the largest supported curve order */
+#define COMB_MAX_D		DIV_ROUND_UP(384, COMB_W)
+
+struct comb_table {
+	const char *name;
+	bool loaded;
+	bool ready;
+	size_t d;
+	/*
+	 * The curve parameters and the table are allocated from the heap,
+	 * mpis handed out by the libtomcrypt descriptor live in the mpi
+	 * memory pool which is only meant for temporaries.
+	 */
+	mbedtls_mpi prime;
+	mbedtls_mpi order;
+	mbedtls_mpi gx;
+	mbedtls_mpi gy;
+	/* Montgomery form of 1 */
+	mbedtls_mpi one;
+	/* Affine coordinates of the table points in Montgomery form */
+	mbedtls_mpi x[COMB_POINTS];
+	mbedtls_mpi y[COMB_POINTS];
+};
+
+static struct comb_table comb_tables[] = {
+	{ .name = "SECP256R1" },
+	{ .name = "SECP384R1" },
+};
+
+static struct mutex comb_mutex = MUTEX_INITIALIZER;
+
+static int comb_load(struct comb_table *ct)
+{
+	const ltc_ecc_curve *cu = NULL;
+	size_t n = 0;
+
+	if (ecc_find_curve(ct->name, &cu) != CRYPT_OK)
+		return CRYPT_ERROR;
+
+	mbedtls_mpi_init(&ct->prime);
+	mbedtls_mpi_init(&ct->order);
+	mbedtls_mpi_init(&ct->gx);
+	mbedtls_mpi_init(&ct->gy);
+	mbedtls_mpi_init(&ct->one);
+	for (n = 0; n < COMB_POINTS; n++) {
+		mbedtls_mpi_init(ct->x + n);
+		mbedtls_mpi_init(ct->y + n);
+	}
+
+	if (mbedtls_mpi_read_string(&ct->prime, 16, cu->prime) ||
+	    mbedtls_mpi_read_string(&ct->order, 16, cu->order) ||
+	    mbedtls_mpi_read_string(&ct->gx, 16, cu->Gx) ||
+	    mbedtls_mpi_read_string(&ct->gy, 16, cu->Gy))
+		return CRYPT_MEM;
+
+	ct->d = DIV_ROUND_UP(mbedtls_mpi_bitlen(&ct->order), COMB_W);
+	if (ct->d > COMB_MAX_D)
+		return CRYPT_ERROR;
+
+	ct->loaded = true;
+
+	return CRYPT_OK;
+}
+
+static int comb_build(struct comb_table *ct, const ecc_point *G, void *ma,
+		      void *modulus, void *mp, void *mu)
+{
+	ecc_point *base[COMB_W] = { };
+	ecc_point *t[COMB_POINTS] = { };
+	size_t i = 0;
+	size_t j = 0;
+	int err = CRYPT_MEM;
+
+	for (i = 0; i < COMB_W; i++) {
+		base[i] = ltc_ecc_new_point();
+		if (!base[i])
+			goto out;
+	}
+	for (i = 0; i < COMB_POINTS; i++) {
+		t[i] = ltc_ecc_new_point();
+		if (!t[i])
+			goto out;
+	}
+
+	/* base[j] = 2^(j * d) * G in Montgomery form */
+	if ((err = mp_mulmod(G->x, mu, modulus, base[0]->x)) ||
+	    (err = mp_mulmod(G->y, mu, modulus, base[0]->y)) ||
+	    (err = mp_copy(mu, base[0]->z)))
+		goto out;
+	for (j = 1; j < COMB_W; j++) {
+		if ((err = ltc_ecc_copy_point(base[j - 1], base[j])))
+			goto out;
+		for (i = 0; i < ct->d; i++) {
+			err = ltc_ecc_projective_dbl_point(base[j], base[j],
+							   ma, modulus, mp);
+			if (err)
+				goto out;
+		}
+	}
+
+	/* t[i] = G + sum of base[j + 1] for each bit j set in i */
+	if ((err = ltc_ecc_copy_point(base[0], t[0])))
+		goto out;
+	for (i = 1; i < COMB_POINTS; i++) {
+		for (j = COMB_W - 2; !(i & BIT(j)); j--)
+			;
+		err = ltc_ecc_projective_add_point(t[i & ~BIT(j)], base[j + 1],
+						   t[i], ma, modulus, mp);
+		if (err)
+			goto out;
+	}
+
+	for (i = 0; i < COMB_POINTS; i++) {
+		/* ltc_ecc_map() leaves the point out of Montgomery form */
+		if ((err = ltc_ecc_map(t[i], modulus, mp)) ||
+		    (err = mp_mulmod(t[i]->x, mu, modulus, t[i]->x)) ||
+		    (err = mp_mulmod(t[i]->y, mu, modulus, t[i]->y)))
+			goto out;
+		if (mbedtls_mpi_copy(ct->x + i, t[i]->x) ||
+		    mbedtls_mpi_copy(ct->y + i, t[i]->y)) {
+			err = CRYPT_MEM;
+			goto out;
+		}
+	}
+	if (mbedtls_mpi_copy(&ct->one, mu)) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	ct->ready = true;
+	err = CRYPT_OK;
+out:
+	for (i = 0; i < COMB_W; i++)
+		if (base[i])
+			ltc_ecc_del_point(base[i]);
+	for (i = 0; i < COMB_POINTS; i++)
+		if (t[i])
+			ltc_ecc_del_point(t[i]);
+
+	return err;
+}
+
+static struct comb_table *comb_get_table(const ecc_point *G, void *ma,
+					 void *modulus, void *mp, void *mu)
+{
+	struct comb_table *ct = NULL;
+	size_t n = 0;
+
+	mutex_lock(&comb_mutex);
+	for (n = 0; n < ARRAY_SIZE(comb_tables); n++) {
+		ct = comb_tables + n;
+		if (!ct->loaded && comb_load(ct))
+			continue;
+		if (mbedtls_mpi_cmp_mpi(modulus, &ct->prime) ||
+		    mbedtls_mpi_cmp_mpi(G->x, &ct->gx) ||
+		    mbedtls_mpi_cmp_mpi(G->y, &ct->gy) ||
+		    mbedtls_mpi_cmp_int(G->z, 1))
+			continue;
+		if (!ct->ready && comb_build(ct, G, ma, modulus, mp, mu))
+			break;
+		mutex_unlock(&comb_mutex);
+		return ct;
+	}
+	mutex_unlock(&comb_mutex);
+
+	return NULL;
+}
+
+/*
+ * Recode the odd scalar @m into d + 1 signed odd digits, see
+ * ecp_comb_recode_core() in mbedtls. Bits 0-6 of x[i] hold the absolute
+ * value of the digit, bit 7 is set when it is negative.
+ */
+static void comb_recode(uint8_t *x, size_t d, const mbedtls_mpi *m)
+{
+	uint8_t c = 0;
+	uint8_t cc = 0;
+	uint8_t adjust = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	memset(x, 0, d + 1);
+
+	for (i = 0; i < d; i++)
+		for (j = 0; j < COMB_W; j++)
+			x[i] |= mbedtls_mpi_get_bit(m, i + d * j) << j;
+
+	for (i = 1; i <= d; i++) {
+		/* Add carry and update it */
+		cc = x[i] & c;
+		x[i] = x[i] ^ c;
+		c = cc;
+
+		/* Adjust if needed, avoiding branches */
+		adjust = 1 - (x[i] & 0x01);
+		c |= x[i] & (x[i - 1] * adjust);
+		x[i] = x[i] ^ (x[i - 1] * adjust);
+		x[i - 1] |= adjust << 7;
+	}
+}
+
+/* Q = x * G, reading every table entry whatever the value of x */
+static int comb_select(struct comb_table *ct, ecc_point *Q, uint8_t x,
+		       void *tmp, void *modulus)
+{
+	size_t idx = (x & 0x7f) >> 1;
+	size_t i = 0;
+
+	for (i = 0; i < COMB_POINTS; i++) {
+		if (mbedtls_mpi_safe_cond_assign(Q->x, ct->x + i, i == idx) ||
+		    mbedtls_mpi_safe_cond_assign(Q->y, ct->y + i, i == idx))
+			return CRYPT_MEM;
+	}
+
+	if (mbedtls_mpi_sub_mpi(tmp, modulus, Q->y) ||
+	    mbedtls_mpi_safe_cond_assign(Q->y, tmp, x >> 7))
+		return CRYPT_MEM;
+
+	return CRYPT_OK;
+}
+
+int ltc_ecc_fixed_base_mulmod(void *k, const ecc_point *G, ecc_point *R,
+			      void *a, void *modulus, int map)
+{
+	struct comb_table *ct = NULL;
+	uint8_t x[COMB_MAX_D + 1] = { };
+	ecc_point *acc = NULL;
+	ecc_point *Q = NULL;
+	void *a_plus3 = NULL;
+	void *tmp = NULL;
+	void *mp = NULL;
+	void *mu = NULL;
+	void *ma = NULL;
+	void *m = NULL;
+	uint8_t neg = 0;
+	size_t i = 0;
+	int err = CRYPT_OK;
+
+	LTC_ARGCHK(k);
+	LTC_ARGCHK(G);
+	LTC_ARGCHK(R);
+	LTC_ARGCHK(modulus);
+
+	if ((err = mp_montgomery_setup(modulus, &mp)) ||
+	    (err = mp_init_multi(&mu, &a_plus3, &tmp, &m, LTC_NULL)) ||
+	    (err = mp_montgomery_normalization(mu, modulus)))
+		goto out;
+
+	/* For curves with a == -3 keep ma == NULL */
+	if ((err = mp_add_d(a, 3, a_plus3)))
+		goto out;
+	if (mp_cmp(a_plus3, modulus) != LTC_MP_EQ) {
+		if ((err = mp_init(&ma)) ||
+		    (err = mp_mulmod(a, mu, modulus, ma)))
+			goto out;
+	}
+
+	ct = comb_get_table(G, ma, modulus, mp, mu);
+	if (!ct || mbedtls_mpi_cmp_int(k, 0) <= 0 ||
+	    mbedtls_mpi_cmp_mpi(k, &ct->order) >= 0) {
+		err = ltc_ecc_mulmod(k, G, R, a, modulus, map);
+		goto out;
+	}
+
+	/*
+	 * The recoding needs an odd scalar, for an even k use order - k
+	 * instead and negate the result.
+	 */
+	neg = !mbedtls_mpi_get_bit(k, 0);
+	if (mbedtls_mpi_sub_mpi(tmp, &ct->order, k) ||
+	    mbedtls_mpi_copy(m, k) ||
+	    mbedtls_mpi_safe_cond_assign(m, tmp, neg)) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	comb_recode(x, ct->d, m);
+
+	acc = ltc_ecc_new_point();
+	Q = ltc_ecc_new_point();
+	if (!acc || !Q) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	if ((err = mp_copy(&ct->one, Q->z)) ||
+	    (err = comb_select(ct, Q, x[ct->d], tmp, modulus)) ||
+	    (err = ltc_ecc_copy_point(Q, acc)))
+		goto out;
+
+	for (i = ct->d; i > 0; i--) {
+		if ((err = ltc_ecc_projective_dbl_point(acc, acc, ma, modulus,
+							mp)) ||
+		    (err = comb_select(ct, Q, x[i - 1], tmp, modulus)) ||
+		    (err = ltc_ecc_projective_add_point(acc, Q, acc, ma,
+							modulus, mp)))
+			goto out;
+	}
+
+	if (mbedtls_mpi_sub_mpi(tmp, modulus, acc->y) ||
+	    mbedtls_mpi_safe_cond_assign(acc->y, tmp, neg)) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	if ((err = ltc_ecc_copy_point(acc, R)))
+		goto out;
+	if (map)
+		err = ltc_ecc_map(R, modulus, mp);
+	else
+		err = CRYPT_OK;
+out:
+	if (acc)
+		ltc_ecc_del_point(acc);
+	if (Q)
+		ltc_ecc_del_point(Q);
+	if (ma)
+		mp_clear(ma);
+	mp_clear_multi(mu, a_plus3, tmp, m, LTC_NULL);
+	if (mp)
+		mp_montgomery_free(mp);
+	memzero_explicit(x, sizeof(x));
+
+	return err;
+}
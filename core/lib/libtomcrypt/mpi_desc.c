@@ -5,6 +5,7 @@
 
 #include <crypto/crypto.h>
 #include <kernel/panic.h>
+#include <kernel/thread.h>
 #include <mbedtls/bignum.h>
 #include <mempool.h>
 #include <stdlib.h>
@@ -26,6 +27,25 @@
 #define biL		(ciL << 3)			/* bits  in limb  */
 #define BITS_TO_LIMBS(i)	((i) / biL + ((i) % biL != 0))
 
+#if defined(CFG_CORE_MPI_POOL_PER_THREAD)
+/* One scratch pool per thread and one for use outside thread context */
+#define MPI_MEMPOOL_COUNT	(CFG_NUM_THREADS + 1)
+#else
+#define MPI_MEMPOOL_COUNT	1
+#endif
+
+static struct mempool *alloc_mp_pool(void *data, size_t size,
+				     void (*release_mem)(void *ptr,
+							 size_t size))
+{
+	if (MPI_MEMPOOL_COUNT > 1)
+		return mempool_alloc_pool_per_thread(data, size,
+						     MPI_MEMPOOL_COUNT - 1,
+						     release_mem);
+
+	return mempool_alloc_pool(data, size, release_mem);
+}
+
 #if defined(_CFG_CORE_LTC_PAGER)
 /* allocate pageable_zi vmem for mp scratch memory pool */
 static struct mempool *get_mp_scratch_memory_pool(void)
@@ -34,18 +54,19 @@ static struct mempool *get_mp_scratch_memory_pool(void)
 	void *data;
 
 	size = ROUNDUP(MPI_MEMPOOL_SIZE, SMALL_PAGE_SIZE);
-	data = tee_pager_alloc(size);
+	data = tee_pager_alloc(size * MPI_MEMPOOL_COUNT);
 	if (!data)
 		panic();
 
-	return mempool_alloc_pool(data, size, tee_pager_release_phys);
+	return alloc_mp_pool(data, size, tee_pager_release_phys);
 }
 #else /* _CFG_CORE_LTC_PAGER */
 static struct mempool *get_mp_scratch_memory_pool(void)
 {
-	static uint8_t data[MPI_MEMPOOL_SIZE] __aligned(MEMPOOL_ALIGN);
+	static uint8_t data[MPI_MEMPOOL_COUNT][MPI_MEMPOOL_SIZE]
+		__aligned(MEMPOOL_ALIGN);
 
-	return mempool_alloc_pool(data, sizeof(data), NULL);
+	return alloc_mp_pool(data, sizeof(data[0]), NULL);
 }
 #endif
 
@@ -603,7 +624,12 @@ static int rng_read(void *ignored __unused, unsigned char *buf, size_t blen)
 
 static int isprime(void *a, int b, int *c)
 {
-	int res = mbedtls_mpi_is_prime_ext(a, b, rng_read, NULL);
+	int res = 0;
+
+	/* Called for each candidate while generating primes */
+	thread_yield_point();
+
+	res = mbedtls_mpi_is_prime_ext(a, b, rng_read, NULL);
 
 	if (res == MBEDTLS_ERR_MPI_ALLOC_FAILED)
 		return CRYPT_MEM;
@@ -678,8 +704,10 @@ ltc_math_descriptor ltc_mp = {
 	.isprime = isprime,
 
 #ifdef LTC_MECC
-#ifdef LTC_MECC_FP
+#if defined(LTC_MECC_FP)
 	.ecc_ptmul = ltc_ecc_fp_mulmod,
+#elif defined(_CFG_CORE_LTC_ECC_FIXED_BASE)
+	.ecc_ptmul = ltc_ecc_fixed_base_mulmod,
 #else
 	.ecc_ptmul = ltc_ecc_mulmod,
 #endif /* LTC_MECC_FP */
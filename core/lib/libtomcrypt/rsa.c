@@ -173,6 +173,11 @@ void sw_crypto_acipher_free_rsa_keypair(struct rsa_keypair *s)
 	crypto_bignum_free(&s->dq);
 }
 
+void crypto_acipher_rsa_keypair_changed(struct rsa_keypair *s __unused)
+{
+	/* The bignums of the key are used in place, nothing is cached */
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key,
 				      size_t key_size)
 __weak __alias("sw_crypto_acipher_gen_rsa_key");
@@ -11,10 +11,32 @@ typedef unsigned char u8;
 typedef ulong32 u32;
 typedef ulong64 u64;
 typedef long64 i64;
-typedef i64 gf[16];
 
 static const u8
   nine[32] = {9};
+
+#ifdef LTC_CURVE25519_FE51
+/*
+ * Field elements in radix 2^51, five limbs of 51 bits held in 64-bit words.
+ * The products of two limbs are accumulated in 128-bit integers.
+ */
+typedef unsigned __int128 u128;
+typedef u64 gf[5];
+
+#define FE51_MASK ((1ULL << 51) - 1)
+
+static const gf
+  gf0,
+  gf1 = {1},
+  gf121665 = {121665},
+  D = {0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff},
+  D2 = {0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff},
+  X = {0x62d608f25d51a, 0x412a4b4f6592a, 0x75b7171a4b31d, 0x1ff60527118fe, 0x216936d3cd6e5},
+  Y = {0x6666666666658, 0x4cccccccccccc, 0x1999999999999, 0x3333333333333, 0x6666666666666},
+  I = {0x61b274a0ea0b0, 0x0d5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d};
+#else
+typedef i64 gf[16];
+
 static const gf
   gf0,
   gf1 = {1},
@@ -24,6 +46,7 @@ static const gf
   X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
   Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
   I = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+#endif
 
 static int vn(const u8 *x,const u8 *y,int n)
 {
@@ -38,6 +61,61 @@ static int tweetnacl_crypto_verify_32(const u8 *x,const u8 *y)
   return vn(x,y,32);
 }
 
+#ifdef LTC_CURVE25519_FE51
+sv set25519(gf r, const gf a)
+{
+  int i;
+  FOR(i,5) r[i]=a[i];
+}
+
+sv car25519(gf o)
+{
+  u64 c;
+  c=o[0]>>51; o[0]&=FE51_MASK; o[1]+=c;
+  c=o[1]>>51; o[1]&=FE51_MASK; o[2]+=c;
+  c=o[2]>>51; o[2]&=FE51_MASK; o[3]+=c;
+  c=o[3]>>51; o[3]&=FE51_MASK; o[4]+=c;
+  c=o[4]>>51; o[4]&=FE51_MASK; o[0]+=19*c;
+}
+
+sv sel25519(gf p,gf q,int b)
+{
+  u64 t,c=0-(u64)b;
+  int i;
+  FOR(i,5) {
+    t= c&(p[i]^q[i]);
+    p[i]^=t;
+    q[i]^=t;
+  }
+}
+
+sv pack25519(u8 *o,const gf n)
+{
+  u64 q,w[4];
+  gf t;
+  int i;
+  set25519(t,n);
+  car25519(t);
+  car25519(t);
+  /* t < 2p, q is 1 if t >= p, that is if t + 19 >= 2^255 */
+  q=(t[0]+19)>>51;
+  q=(t[1]+q)>>51;
+  q=(t[2]+q)>>51;
+  q=(t[3]+q)>>51;
+  q=(t[4]+q)>>51;
+  t[0]+=19*q;
+  t[1]+=t[0]>>51; t[0]&=FE51_MASK;
+  t[2]+=t[1]>>51; t[1]&=FE51_MASK;
+  t[3]+=t[2]>>51; t[2]&=FE51_MASK;
+  t[4]+=t[3]>>51; t[3]&=FE51_MASK;
+  t[4]&=FE51_MASK;
+  w[0]=t[0]|(t[1]<<51);
+  w[1]=(t[1]>>13)|(t[2]<<38);
+  w[2]=(t[2]>>26)|(t[3]<<25);
+  w[3]=(t[3]>>39)|(t[4]<<12);
+  FOR(i,32) o[i]=w[i/8]>>(8*(i%8));
+}
+#else
 sv set25519(gf r, const gf a)
 {
   int i;
@@ -91,6 +169,8 @@ sv pack25519(u8 *o,const gf n)
   }
 }
 
+#endif
+
 static int neq25519(const gf a, const gf b)
 {
   u8 c[32],d[32];
@@ -106,6 +186,78 @@ static u8 par25519(const gf a)
   return d[0]&1;
 }
 
+#ifdef LTC_CURVE25519_FE51
+sv unpack25519(gf o, const u8 *n)
+{
+  u64 w[4]={0};
+  int i;
+  FOR(i,32) w[i/8]|=(u64)n[i]<<(8*(i%8));
+  o[0]=w[0]&FE51_MASK;
+  o[1]=((w[0]>>51)|(w[1]<<13))&FE51_MASK;
+  o[2]=((w[1]>>38)|(w[2]<<26))&FE51_MASK;
+  o[3]=((w[2]>>25)|(w[3]<<39))&FE51_MASK;
+  o[4]=(w[3]>>12)&FE51_MASK;
+}
+
+sv A(gf o,const gf a,const gf b)
+{
+  int i;
+  FOR(i,5) o[i]=a[i]+b[i];
+}
+
+/* 4p is added so that limbs of b up to 2^53 don't underflow */
+sv Z(gf o,const gf a,const gf b)
+{
+  o[0]=a[0]+0x1FFFFFFFFFFFB4ULL-b[0];
+  o[1]=a[1]+0x1FFFFFFFFFFFFCULL-b[1];
+  o[2]=a[2]+0x1FFFFFFFFFFFFCULL-b[2];
+  o[3]=a[3]+0x1FFFFFFFFFFFFCULL-b[3];
+  o[4]=a[4]+0x1FFFFFFFFFFFFCULL-b[4];
+  car25519(o);
+}
+
+/* Reduces the 5 accumulated 2^102-radix products into o */
+sv fe51_reduce(gf o,u128 t0,u128 t1,u128 t2,u128 t3,u128 t4)
+{
+  u64 c;
+  t1+=(u64)(t0>>51);
+  t2+=(u64)(t1>>51);
+  t3+=(u64)(t2>>51);
+  t4+=(u64)(t3>>51);
+  c=(u64)(t4>>51);
+  o[0]=((u64)t0&FE51_MASK)+19*c;
+  o[1]=((u64)t1&FE51_MASK)+(o[0]>>51);
+  o[0]&=FE51_MASK;
+  o[2]=(u64)t2&FE51_MASK;
+  o[3]=(u64)t3&FE51_MASK;
+  o[4]=(u64)t4&FE51_MASK;
+}
+
+sv M(gf o,const gf a,const gf b)
+{
+  u64 b1=19*b[1],b2=19*b[2],b3=19*b[3],b4=19*b[4];
+  u128 t0,t1,t2,t3,t4;
+  t0=(u128)a[0]*b[0]+(u128)a[1]*b4+(u128)a[2]*b3+(u128)a[3]*b2+(u128)a[4]*b1;
+  t1=(u128)a[0]*b[1]+(u128)a[1]*b[0]+(u128)a[2]*b4+(u128)a[3]*b3+(u128)a[4]*b2;
+  t2=(u128)a[0]*b[2]+(u128)a[1]*b[1]+(u128)a[2]*b[0]+(u128)a[3]*b4+(u128)a[4]*b3;
+  t3=(u128)a[0]*b[3]+(u128)a[1]*b[2]+(u128)a[2]*b[1]+(u128)a[3]*b[0]+(u128)a[4]*b4;
+  t4=(u128)a[0]*b[4]+(u128)a[1]*b[3]+(u128)a[2]*b[2]+(u128)a[3]*b[1]+(u128)a[4]*b[0];
+  fe51_reduce(o,t0,t1,t2,t3,t4);
+}
+
+sv S(gf o,const gf a)
+{
+  u64 a0_2=2*a[0],a1_2=2*a[1],a1_38=38*a[1],a2_38=38*a[2],a3_38=38*a[3];
+  u64 a3_19=19*a[3],a4_19=19*a[4];
+  u128 t0,t1,t2,t3,t4;
+  t0=(u128)a[0]*a[0]+(u128)a1_38*a[4]+(u128)a2_38*a[3];
+  t1=(u128)a0_2*a[1]+(u128)a2_38*a[4]+(u128)a3_19*a[3];
+  t2=(u128)a0_2*a[2]+(u128)a[1]*a[1]+(u128)a3_38*a[4];
+  t3=(u128)a0_2*a[3]+(u128)a1_2*a[2]+(u128)a4_19*a[4];
+  t4=(u128)a0_2*a[4]+(u128)a1_2*a[3]+(u128)a[2]*a[2];
+  fe51_reduce(o,t0,t1,t2,t3,t4);
+}
+#else
 sv unpack25519(gf o, const u8 *n)
 {
   int i;
@@ -141,44 +293,45 @@ sv S(gf o,const gf a)
   M(o,a,a);
 }
 
+#endif
+
 sv inv25519(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=253;a>=0;a--) {
     S(c,c);
     if(a!=2&&a!=4) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
 sv pow2523(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=250;a>=0;a--) {
     S(c,c);
     if(a!=1) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
 int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
 {
   u8 z[32];
-  i64 x[80],r,i;
-  gf a,b,c,d,e,f;
+  i64 r,i;
+  gf x,a,b,c,d,e,f;
   FOR(i,31) z[i]=n[i];
   z[31]=(n[31]&127)|64;
   z[0]&=248;
   unpack25519(x,p);
-  FOR(i,16) {
-    b[i]=x[i];
-    d[i]=a[i]=c[i]=0;
-  }
-  a[0]=d[0]=1;
+  set25519(b,x);
+  set25519(a,gf1);
+  set25519(c,gf0);
+  set25519(d,gf1);
   for(i=254;i>=0;--i) {
     r=(z[i>>3]>>(i&7))&1;
     sel25519(a,b,r);
@@ -204,15 +357,9 @@ int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
     sel25519(a,b,r);
     sel25519(c,d,r);
   }
-  FOR(i,16) {
-    x[i+16]=a[i];
-    x[i+32]=c[i];
-    x[i+48]=b[i];
-    x[i+64]=d[i];
-  }
-  inv25519(x+32,x+32);
-  M(x+16,x+16,x+32);
-  pack25519(q,x+16);
+  inv25519(c,c);
+  M(a,a,c);
+  pack25519(q,a);
   return 0;
 }
 
@@ -319,6 +319,7 @@ cppflags-lib-$(_CFG_CORE_LTC_ECC) += -DLTC_CURVE25519
 # ECC 521 bits is the max supported key size
 cppflags-lib-$(_CFG_CORE_LTC_ECC) += -DLTC_MAX_ECC=521
 srcs-$(_CFG_CORE_LTC_ECC) += ecc.c
+srcs-$(_CFG_CORE_LTC_ECC_FIXED_BASE) += ecc_fixed_base.c
 srcs-$(_CFG_CORE_LTC_ECC) += src/pk/ecc/ecc.c
 srcs-$(_CFG_CORE_LTC_ECC) += src/pk/ecc/ecc_find_curve.c
 srcs-$(_CFG_CORE_LTC_ECC) += src/pk/ecc/ecc_free.c
@@ -348,6 +349,7 @@ srcs-$(_CFG_CORE_LTC_SM2_PKE) += sm2-pke.c
 srcs-$(_CFG_CORE_LTC_SM2_KEP) += sm2-kep.c
 
 cppflags-lib-$(_CFG_CORE_LTC_EC25519) += -DLTC_CURVE25519
+cppflags-lib-$(_CFG_CORE_LTC_CURVE25519_FE51) += -DLTC_CURVE25519_FE51
 srcs-$(_CFG_CORE_LTC_EC25519) += src/pk/ec25519/ec25519_crypto_ctx.c
 srcs-$(_CFG_CORE_LTC_EC25519) += src/pk/ec25519/ec25519_export.c
 srcs-$(_CFG_CORE_LTC_EC25519) += src/pk/ec25519/tweetnacl.c
@@ -45,6 +45,9 @@ struct boot_mem_padding {
  * @mem_end: Boot memory free space end address
  * @reloc: Boot memory pointers requiring relocation
  * @padding: Linked list of unused memory between allocated blocks
+ * @tmp_free: Linked list of released temporary allocations not yet
+ *	      reclaimed
+ * @tmp_released: Number of bytes released with boot_mem_free_tmp()
  */
 struct boot_mem_desc {
 	vaddr_t orig_mem_start;
@@ -53,6 +56,8 @@ struct boot_mem_desc {
 	vaddr_t mem_end;
 	struct boot_mem_reloc *reloc;
 	struct boot_mem_padding *padding;
+	struct boot_mem_padding *tmp_free;
+	size_t tmp_released;
 };
 
 static struct boot_mem_desc *boot_mem_desc;
@@ -72,6 +77,64 @@ static void *mem_alloc_tmp(struct boot_mem_desc *desc, size_t len, size_t align)
 	return (void *)va;
 }
 
+/*
+ * Reclaims the released temporary allocations which are now at the top of
+ * the temporary allocations.
+ */
+static void reclaim_tmp(struct boot_mem_desc *desc)
+{
+	struct boot_mem_padding **prev = &desc->tmp_free;
+	struct boot_mem_padding *pad = NULL;
+
+	while (*prev) {
+		pad = *prev;
+		if (pad->start == desc->mem_end) {
+			desc->mem_end += pad->len;
+			*prev = pad->next;
+			/* Start over, the list isn't sorted */
+			prev = &desc->tmp_free;
+		} else {
+			prev = &pad->next;
+		}
+	}
+}
+
+static void mem_free_tmp(struct boot_mem_desc *desc, void *ptr, size_t len)
+{
+	struct boot_mem_padding *pad = NULL;
+	vaddr_t va = (vaddr_t)ptr;
+
+	assert(desc && va >= desc->mem_end &&
+	       va + len <= desc->orig_mem_end);
+	desc->tmp_released += len;
+
+	/*
+	 * Once boot_mem_release_unused() has stopped further allocations
+	 * the memory is reclaimed by boot_mem_release_tmp_alloc().
+	 */
+	if (desc->mem_start == desc->mem_end)
+		return;
+
+	if (va == desc->mem_end) {
+		desc->mem_end = va + len;
+		reclaim_tmp(desc);
+		return;
+	}
+
+	/*
+	 * Keep track of the released allocation until the allocations
+	 * below it are released too. An allocation too small to keep
+	 * track of is reclaimed by boot_mem_release_tmp_alloc().
+	 */
+	if (len >= sizeof(*pad) && IS_ALIGNED(va, alignof(*pad))) {
+		pad = ptr;
+		pad->start = va;
+		pad->len = len;
+		pad->next = desc->tmp_free;
+		desc->tmp_free = pad;
+	}
+}
+
 static void add_padding(struct boot_mem_desc *desc, vaddr_t va)
 {
 	struct boot_mem_padding *pad = NULL;
@@ -189,6 +252,19 @@ void boot_mem_relocate(size_t offs)
 			pad = pad->next;
 		}
 	}
+
+	if (boot_mem_desc->tmp_free) {
+		boot_mem_desc->tmp_free = add_offs(boot_mem_desc->tmp_free,
+						   offs);
+		pad = boot_mem_desc->tmp_free;
+		while (true) {
+			pad->start += offs;
+			if (!pad->next)
+				break;
+			pad->next = add_offs(pad->next, offs);
+			pad = pad->next;
+		}
+	}
 }
 
 void *boot_mem_alloc(size_t len, size_t align)
@@ -201,6 +277,11 @@ void *boot_mem_alloc_tmp(size_t len, size_t align)
 	return mem_alloc_tmp(boot_mem_desc, len, align);
 }
 
+void boot_mem_free_tmp(void *ptr, size_t len)
+{
+	mem_free_tmp(boot_mem_desc, ptr, len);
+}
+
 /*
  * Calls the supplied @func() for each padding and removes the paddings
  * where @func() returns true.
@@ -249,9 +330,9 @@ vaddr_t boot_mem_release_unused(void)
 	     n, boot_mem_desc->orig_mem_start,
 	     vaddr_to_phys(boot_mem_desc->orig_mem_start));
 
-	DMSG("Tempalloc %zu bytes at va %#"PRIxVA,
+	DMSG("Tempalloc %zu bytes at va %#"PRIxVA", %zu bytes released",
 	     (size_t)(boot_mem_desc->orig_mem_end - boot_mem_desc->mem_end),
-	     boot_mem_desc->mem_end);
+	     boot_mem_desc->mem_end, boot_mem_desc->tmp_released);
 
 	if (IS_ENABLED(CFG_WITH_PAGER))
 		goto out;
@@ -318,11 +399,12 @@ void boot_mem_release_tmp_alloc(void)
 	assert(pa == tee_mm_get_smem(mm));
 	n = tee_mm_get_bytes(mm);
 
+	DMSG("Releasing %zu bytes from va %#"PRIxVA", %zu bytes released early",
+	     n, va, boot_mem_desc->tmp_released);
+
 	/* Boot memory allocation is now done */
 	boot_mem_desc = NULL;
 
-	DMSG("Releasing %zu bytes from va %#"PRIxVA, n, va);
-
 	/* Unmap the now unused pages */
 	core_mmu_unmap_pages(va, n / SMALL_PAGE_SIZE);
 }
@@ -155,6 +155,7 @@ static void boot_mem_realloc_memory_map(struct memory_map *mem_map)
 
 	m = boot_mem_alloc_tmp(sz, alignof(*m));
 	memcpy(m, old, old_sz);
+	boot_mem_free_tmp(old, old_sz);
 	mem_map->map = m;
 	mem_map->alloc_count *= 2;
 }
@@ -1634,6 +1635,8 @@ void core_mmu_save_mem_map(void)
 			panic();
 		memcpy(p, static_memory_map.map,
 		       static_memory_map.count * elem_sz);
+		boot_mem_free_tmp(static_memory_map.map,
+				  static_memory_map.alloc_count * elem_sz);
 		static_memory_map.map = p;
 		static_memory_map.alloc_count = alloc_count;
 		memory_map_realloc_func = heap_realloc_memory_map;
@@ -1786,6 +1789,37 @@ void core_mmu_get_entry(struct core_mmu_table_info *tbl_info, unsigned int idx,
 				     idx, pa, attr);
 }
 
+void core_mmu_set_user_entries(struct core_mmu_table_info *tbl_info,
+			       vaddr_t va, paddr_t pa, size_t size,
+			       uint32_t attr)
+{
+	unsigned int end = core_mmu_va2idx(tbl_info, va + size);
+	unsigned int idx = core_mmu_va2idx(tbl_info, va);
+	unsigned int num = 0;
+	unsigned int n = 0;
+	uint32_t a = 0;
+
+	while (idx < end) {
+		num = 1;
+		a = attr;
+		if (IS_ENABLED(CFG_CORE_MMU_CONTIG_HINT) &&
+		    (attr & TEE_MATTR_VALID_BLOCK) &&
+		    tbl_info->shift == SMALL_PAGE_SHIFT &&
+		    !(idx % CORE_MMU_CONTIG_ENTRIES) &&
+		    end - idx >= CORE_MMU_CONTIG_ENTRIES &&
+		    IS_ALIGNED(pa, CORE_MMU_CONTIG_SIZE)) {
+			num = CORE_MMU_CONTIG_ENTRIES;
+			a |= TEE_MATTR_CONTIG;
+		}
+
+		for (n = 0; n < num; n++) {
+			core_mmu_set_entry(tbl_info, idx, pa, a);
+			idx++;
+			pa += BIT64(tbl_info->shift);
+		}
+	}
+}
+
 static void clear_region(struct core_mmu_table_info *tbl_info,
 			 struct tee_mmap_region *region)
 {
@@ -1887,7 +1921,8 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 			if (mobj_get_pa(region->mobj, offset, granule,
 					&r.pa) != TEE_SUCCESS)
 				panic("Failed to get PA of unpaged mobj");
-			set_region(pg_info, &r);
+			core_mmu_set_user_entries(pg_info, r.va, r.pa, r.size,
+						  r.attr);
 		}
 		r.va += r.size;
 	}
@@ -2235,6 +2270,7 @@ void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 	 * Allocate all page tables in advance.
 	 */
 	pgt_get_all(uctx);
+	pgt_reuse_ro_tables(uctx);
 	pgt = SLIST_FIRST(pgt_cache);
 
 	core_mmu_set_info_table(&pg_info, dir_info->next_level, 0, NULL);
@@ -176,6 +176,58 @@ void file_put(struct file *f)
 
 }
 
+#if CFG_FILE_KEEP_COUNT
+/* Files held by file_keep(), most recently kept first */
+static struct file *kept_files[CFG_FILE_KEEP_COUNT];
+static struct mutex kept_files_mu = MUTEX_INITIALIZER;
+
+void file_keep(struct file *f)
+{
+	struct file *old = NULL;
+	size_t n = 0;
+
+	mutex_lock(&kept_files_mu);
+	for (n = 0; n < CFG_FILE_KEEP_COUNT - 1; n++)
+		if (kept_files[n] == f)
+			break;
+	if (kept_files[n] == f) {
+		/* Already kept, only move it first */
+		memmove(kept_files + 1, kept_files, n * sizeof(f));
+	} else {
+		old = kept_files[n];
+		memmove(kept_files + 1, kept_files, n * sizeof(f));
+		file_get(f);
+	}
+	kept_files[0] = f;
+	mutex_unlock(&kept_files_mu);
+
+	/* file_put() may need file_mu, don't hold kept_files_mu */
+	file_put(old);
+}
+
+void file_release_kept(void)
+{
+	struct file *files[CFG_FILE_KEEP_COUNT] = { };
+	size_t n = 0;
+
+	mutex_lock(&kept_files_mu);
+	memcpy(files, kept_files, sizeof(files));
+	memset(kept_files, 0, sizeof(kept_files));
+	mutex_unlock(&kept_files_mu);
+
+	for (n = 0; n < CFG_FILE_KEEP_COUNT; n++)
+		file_put(files[n]);
+}
+#else
+void file_keep(struct file *f __unused)
+{
+}
+
+void file_release_kept(void)
+{
+}
+#endif
+
 struct file_slice *file_find_slice(struct file *f, unsigned int page_offset)
 {
 	struct file_slice_elem *fse = NULL;
@@ -5,19 +5,24 @@
 
 #include <config.h>
 #include <crypto/crypto.h>
+#include <bitstring.h>
 #include <crypto/internal_aes-gcm.h>
 #include <initcall.h>
 #include <kernel/boot.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <memtag.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/fobj.h>
+#include <mm/page_lz.h>
 #include <mm/phys_mem.h>
 #include <mm/tee_mm.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
+#include <trace.h>
 #include <types_ext.h>
 #include <util.h>
 
@@ -60,7 +65,8 @@ struct fobj_rwp_paged_iv {
 const struct fobj_ops ops_rwp_paged_iv;
 const struct fobj_ops ops_rwp_unpaged_iv;
 
-static struct internal_aes_gcm_key rwp_ae_key;
+/* Precomputing the GHASH key saves deriving it for each page */
+static struct internal_aes_gcm_prekey rwp_ae_key;
 
 static struct rwp_state_padded *rwp_state_base;
 static uint8_t *rwp_store_base;
@@ -81,7 +87,7 @@ static void fobj_uninit(struct fobj *fobj)
 	tee_pager_invalidate_fobj(fobj);
 }
 
-static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
+static TEE_Result rwp_load_page(void *va, size_t len, struct rwp_state *state,
 				const uint8_t *src)
 {
 	struct rwp_aes_gcm_iv iv = {
@@ -93,17 +99,17 @@ static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
 		 * IV still zero which means that this is previously unused
 		 * page.
 		 */
-		memset(va, 0, SMALL_PAGE_SIZE);
+		memset(va, 0, len);
 		return TEE_SUCCESS;
 	}
 
-	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, src, SMALL_PAGE_SIZE, va,
-				    state->tag, sizeof(state->tag));
+	return internal_aes_gcm_prekey_dec(&rwp_ae_key, &iv, sizeof(iv),
+					   NULL, 0, src, len, va,
+					   state->tag, sizeof(state->tag));
 }
 
-static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
-				uint8_t *dst)
+static TEE_Result rwp_save_page(const void *va, size_t len,
+				struct rwp_state *state, uint8_t *dst)
 {
 	size_t tag_len = sizeof(state->tag);
 	struct rwp_aes_gcm_iv iv = { };
@@ -122,9 +128,9 @@ static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
 	iv.iv[1] = state->iv >> 32;
 	iv.iv[2] = state->iv;
 
-	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
-				    state->tag, &tag_len);
+	return internal_aes_gcm_prekey_enc(&rwp_ae_key, &iv, sizeof(iv),
+					   NULL, 0, va, len, dst,
+					   state->tag, &tag_len);
 }
 
 static struct rwp_state_padded *idx_to_state_padded(size_t idx)
@@ -189,7 +195,7 @@ static TEE_Result rwp_paged_iv_load_page(struct fobj *fobj,
 	assert(refcount_val(&fobj->refc));
 	assert(page_idx < fobj->num_pages);
 
-	return rwp_load_page(va, &st->state, src);
+	return rwp_load_page(va, SMALL_PAGE_SIZE, &st->state, src);
 }
 DECLARE_KEEP_PAGER(rwp_paged_iv_load_page);
 
@@ -211,7 +217,7 @@ static TEE_Result rwp_paged_iv_save_page(struct fobj *fobj,
 		return TEE_SUCCESS;
 	}
 
-	return rwp_save_page(va, &st->state, dst);
+	return rwp_save_page(va, SMALL_PAGE_SIZE, &st->state, dst);
 }
 DECLARE_KEEP_PAGER(rwp_paged_iv_save_page);
 
@@ -301,7 +307,8 @@ static TEE_Result rwp_unpaged_iv_load_page(struct fobj *fobj,
 	assert(refcount_val(&fobj->refc));
 	assert(page_idx < fobj->num_pages);
 
-	return rwp_load_page(va, rwp->state + page_idx, src);
+	return rwp_load_page(va, SMALL_PAGE_SIZE, rwp->state + page_idx,
+			     src);
 }
 DECLARE_KEEP_PAGER(rwp_unpaged_iv_load_page);
 
@@ -323,7 +330,8 @@ static TEE_Result rwp_unpaged_iv_save_page(struct fobj *fobj,
 		return TEE_SUCCESS;
 	}
 
-	return rwp_save_page(va, rwp->state + page_idx, dst);
+	return rwp_save_page(va, SMALL_PAGE_SIZE, rwp->state + page_idx,
+			     dst);
 }
 DECLARE_KEEP_PAGER(rwp_unpaged_iv_save_page);
 
@@ -357,6 +365,257 @@ __weak __relrodata_unpaged("ops_rwp_unpaged_iv") = {
 	.save_page = rwp_unpaged_iv_save_page,
 };
 
+#ifdef CFG_PAGER_RW_COMPRESS
+/*
+ * Compressed read/write paged storage. Saved pages are compressed and
+ * then encrypted into blobs allocated from a pool carved out of the TA
+ * RAM when the pager is initialized. The pool is shared by all such
+ * fobjs and may be overcommitted by CFG_PAGER_RW_COMPRESS_OVERCOMMIT
+ * percent. Once the pool is fully committed fobj_rw_paged_alloc()
+ * falls back to uncompressed storage, but pages compressing worse than
+ * expected can still exhaust a full pool, which causes a panic when a
+ * page is saved.
+ */
+
+#define RWZ_GRANULE_SIZE	64
+#define RWZ_NUM_GRANULES	(CFG_PAGER_RW_COMPRESS_POOL_SIZE / \
+				 RWZ_GRANULE_SIZE)
+#define RWZ_MAX_PAGES		(CFG_PAGER_RW_COMPRESS_POOL_SIZE / \
+				 SMALL_PAGE_SIZE * \
+				 CFG_PAGER_RW_COMPRESS_OVERCOMMIT / 100)
+
+/*
+ * struct rwz_page - state of a saved page
+ * @state:	IV and tag of the blob
+ * @blob:	First granule of the blob in the pool
+ * @len:	Length of the blob, SMALL_PAGE_SIZE if not compressed or 0
+ *		if there's no blob
+ */
+struct rwz_page {
+	struct rwp_state state;
+	uint32_t blob;
+	uint32_t len;
+};
+
+struct fobj_rwz {
+	struct rwz_page *pages;
+	struct fobj fobj;
+};
+
+const struct fobj_ops ops_rwz;
+
+static unsigned int rwz_lock = SPINLOCK_UNLOCK;
+static bitstr_t bit_decl(rwz_pool_map, RWZ_NUM_GRANULES);
+static uint8_t *rwz_pool_base;
+static size_t rwz_num_pages;
+/* Compression buffer and work area, protected by rwz_lock */
+static uint8_t rwz_buf[SMALL_PAGE_SIZE];
+static struct page_lz_work rwz_work;
+
+static size_t rwz_len_to_granules(size_t len)
+{
+	return ROUNDUP_DIV(len, RWZ_GRANULE_SIZE);
+}
+
+static bool rwz_pool_alloc(struct rwz_page *page, size_t len)
+{
+	size_t n = rwz_len_to_granules(len);
+	size_t i = 0;
+	size_t j = 0;
+
+	while (i + n <= RWZ_NUM_GRANULES) {
+		for (j = i; j < i + n; j++)
+			if (bit_test(rwz_pool_map, j))
+				break;
+		if (j == i + n) {
+			bit_nset(rwz_pool_map, i, j - 1);
+			page->blob = i;
+			page->len = len;
+			return true;
+		}
+		i = j + 1;
+	}
+
+	return false;
+}
+
+static void rwz_pool_free(struct rwz_page *page)
+{
+	if (page->len) {
+		bit_nclear(rwz_pool_map, page->blob,
+			   page->blob + rwz_len_to_granules(page->len) - 1);
+		page->len = 0;
+	}
+}
+
+static uint8_t *rwz_blob_va(struct rwz_page *page)
+{
+	return rwz_pool_base + page->blob * RWZ_GRANULE_SIZE;
+}
+
+static void rwz_pool_init(void)
+{
+	size_t size = CFG_PAGER_RW_COMPRESS_POOL_SIZE;
+	tee_mm_entry_t *mm = NULL;
+
+	mm = nex_phys_mem_ta_alloc(size);
+	if (!mm) {
+		EMSG("Can't allocate compressed page pool of %zu bytes", size);
+		return;
+	}
+	rwz_pool_base = phys_to_virt(tee_mm_get_smem(mm),
+				     MEM_AREA_SEC_RAM_OVERALL, size);
+	assert(rwz_pool_base);
+}
+
+static struct fobj *rwz_alloc(unsigned int num_pages)
+{
+	struct fobj_rwz *rwz = NULL;
+	uint32_t exceptions = 0;
+	bool committed = false;
+
+	rwz = calloc(1, sizeof(*rwz));
+	if (!rwz)
+		return NULL;
+
+	rwz->pages = calloc(num_pages, sizeof(*rwz->pages));
+	if (!rwz->pages)
+		goto err;
+
+	exceptions = cpu_spin_lock_xsave(&rwz_lock);
+	if (rwz_pool_base && num_pages <= RWZ_MAX_PAGES - rwz_num_pages) {
+		rwz_num_pages += num_pages;
+		committed = true;
+	}
+	cpu_spin_unlock_xrestore(&rwz_lock, exceptions);
+	if (!committed)
+		goto err;
+
+	fobj_init(&rwz->fobj, &ops_rwz, num_pages);
+
+	return &rwz->fobj;
+err:
+	free(rwz->pages);
+	free(rwz);
+
+	return NULL;
+}
+
+static struct fobj_rwz *to_rwz(struct fobj *fobj)
+{
+	assert(fobj->ops == &ops_rwz);
+
+	return container_of(fobj, struct fobj_rwz, fobj);
+}
+
+static TEE_Result rwz_load_page(struct fobj *fobj, unsigned int page_idx,
+				void *va)
+{
+	struct fobj_rwz *rwz = to_rwz(fobj);
+	struct rwz_page *page = rwz->pages + page_idx;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+
+	assert(refcount_val(&fobj->refc));
+	assert(page_idx < fobj->num_pages);
+
+	if (!page->state.iv || page->len == SMALL_PAGE_SIZE)
+		return rwp_load_page(va, SMALL_PAGE_SIZE, &page->state,
+				     rwz_blob_va(page));
+
+	exceptions = cpu_spin_lock_xsave(&rwz_lock);
+	res = rwp_load_page(rwz_buf, page->len, &page->state,
+			    rwz_blob_va(page));
+	if (!res)
+		res = page_lz_decompress(rwz_buf, page->len, va,
+					 SMALL_PAGE_SIZE);
+	cpu_spin_unlock_xrestore(&rwz_lock, exceptions);
+
+	return res;
+}
+DECLARE_KEEP_PAGER(rwz_load_page);
+
+static TEE_Result rwz_save_page(struct fobj *fobj, unsigned int page_idx,
+				const void *va)
+{
+	struct fobj_rwz *rwz = to_rwz(fobj);
+	struct rwz_page *page = rwz->pages + page_idx;
+	TEE_Result res = TEE_ERROR_OUT_OF_MEMORY;
+	uint32_t exceptions = 0;
+	const void *src = rwz_buf;
+	size_t len = 0;
+
+	assert(page_idx < fobj->num_pages);
+
+	if (!refcount_val(&fobj->refc)) {
+		/*
+		 * This fobj is being teared down, it just hasn't had the time
+		 * to call tee_pager_invalidate_fobj() yet.
+		 */
+		assert(TAILQ_EMPTY(&fobj->regions));
+		return TEE_SUCCESS;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&rwz_lock);
+
+	/* The previous blob is stale since the page has been modified */
+	rwz_pool_free(page);
+
+	/* Pages not saving at least a granule are stored uncompressed */
+	len = page_lz_compress(va, SMALL_PAGE_SIZE, rwz_buf,
+			       SMALL_PAGE_SIZE - RWZ_GRANULE_SIZE, &rwz_work);
+	if (!len) {
+		src = va;
+		len = SMALL_PAGE_SIZE;
+	}
+
+	if (rwz_pool_alloc(page, len))
+		res = rwp_save_page(src, len, &page->state, rwz_blob_va(page));
+
+	cpu_spin_unlock_xrestore(&rwz_lock, exceptions);
+
+	return res;
+}
+DECLARE_KEEP_PAGER(rwz_save_page);
+
+static void rwz_free(struct fobj *fobj)
+{
+	struct fobj_rwz *rwz = to_rwz(fobj);
+	uint32_t exceptions = 0;
+	unsigned int n = 0;
+
+	fobj_uninit(fobj);
+
+	exceptions = cpu_spin_lock_xsave(&rwz_lock);
+	for (n = 0; n < fobj->num_pages; n++)
+		rwz_pool_free(rwz->pages + n);
+	rwz_num_pages -= fobj->num_pages;
+	cpu_spin_unlock_xrestore(&rwz_lock, exceptions);
+
+	free(rwz->pages);
+	free(rwz);
+}
+
+/*
+ * Note: this variable is weak just to ease breaking its dependency chain
+ * when added to the unpaged area.
+ */
+const struct fobj_ops ops_rwz __weak __relrodata_unpaged("ops_rwz") = {
+	.free = rwz_free,
+	.load_page = rwz_load_page,
+	.save_page = rwz_save_page,
+};
+#else
+static void rwz_pool_init(void)
+{
+}
+
+static struct fobj *rwz_alloc(unsigned int num_pages __unused)
+{
+	return NULL;
+}
+#endif /*CFG_PAGER_RW_COMPRESS*/
+
 static TEE_Result rwp_init(void)
 {
 	paddr_size_t ta_size = nex_phys_mem_get_ta_size();
@@ -367,10 +626,19 @@ static TEE_Result rwp_init(void)
 
 	if (crypto_rng_read(key, sizeof(key)) != TEE_SUCCESS)
 		panic("failed to generate random");
-	if (crypto_aes_expand_enc_key(key, sizeof(key), rwp_ae_key.data,
-				      sizeof(rwp_ae_key.data),
-				      &rwp_ae_key.rounds))
+	if (crypto_aes_expand_enc_key(key, sizeof(key), rwp_ae_key.key.data,
+				      sizeof(rwp_ae_key.key.data),
+				      &rwp_ae_key.key.rounds))
 		panic("failed to expand key");
+#ifdef CFG_CRYPTO_AES_GCM_CE_RUNTIME
+	/* Use the AES and PMULL instructions if the CPU has them */
+	internal_aes_gcm_expand_ce_key(&rwp_ae_key.key, key, sizeof(key));
+#endif
+	internal_aes_gcm_prekey_init(&rwp_ae_key);
+	memzero_explicit(key, sizeof(key));
+
+	if (IS_ENABLED(CFG_PAGER_RW_COMPRESS))
+		rwz_pool_init();
 
 	if (!IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV))
 		return TEE_SUCCESS;
@@ -405,12 +673,20 @@ driver_init_late(rwp_init);
 
 struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 {
+	struct fobj *fobj = NULL;
+
 	assert(num_pages);
 
 	if (IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV))
 		return rwp_paged_iv_alloc(num_pages);
-	else
-		return rwp_unpaged_iv_alloc(num_pages);
+
+	if (IS_ENABLED(CFG_PAGER_RW_COMPRESS)) {
+		fobj = rwz_alloc(num_pages);
+		if (fobj)
+			return fobj;
+	}
+
+	return rwp_unpaged_iv_alloc(num_pages);
 }
 
 struct fobj_rop {
@@ -779,7 +1055,7 @@ struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
 
 	return &f->fobj;
 err:
-	tee_mm_free(f->mm);
+	phys_mem_free(f->mm);
 	free(f);
 
 	return NULL;
@@ -797,7 +1073,7 @@ static void sec_mem_free(struct fobj *fobj)
 	struct fobj_sec_mem *f = to_sec_mem(fobj);
 
 	assert(!refcount_val(&fobj->refc));
-	tee_mm_free(f->mm);
+	phys_mem_free(f->mm);
 	free(f);
 }
 
@@ -11,6 +11,7 @@
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
+#include <kernel/tee_ta_manager.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <mm/tee_pager.h>
@@ -30,7 +31,8 @@ static size_t shm_release_waiters;
 
 struct mobj_reg_shm {
 	struct mobj mobj;
-	SLIST_ENTRY(mobj_reg_shm) next;
+	LIST_ENTRY(mobj_reg_shm) next;
+	TAILQ_ENTRY(mobj_reg_shm) map_cache_link;
 	uint64_t cookie;
 	tee_mm_entry_t *mm;
 	paddr_t page_offset;
@@ -38,33 +40,97 @@ struct mobj_reg_shm {
 	bool guarded;
 	bool releasing;
 	bool release_frees;
-	paddr_t pages[];
+	bool map_cached;
+	size_t num_pages;
+	size_t num_runs;
+	/*
+	 * Physically contiguous runs of pages, in the order they appear in
+	 * the mobj. Run n spans the pages from runs[n].page_idx up to the
+	 * page_idx of the next run.
+	 */
+	struct reg_shm_run {
+		paddr_t pa;
+		size_t page_idx;
+	} runs[];
 };
 
-static size_t mobj_reg_shm_size(size_t nr_pages)
+static size_t mobj_reg_shm_size(size_t nr_runs)
 {
 	size_t s = 0;
 
-	if (MUL_OVERFLOW(sizeof(paddr_t), nr_pages, &s))
+	if (MUL_OVERFLOW(sizeof(struct reg_shm_run), nr_runs, &s))
 		return 0;
 	if (ADD_OVERFLOW(sizeof(struct mobj_reg_shm), s, &s))
 		return 0;
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+/*
+ * Registered shared memory is looked up by cookie each time a TA is
+ * invoked with such memory as parameter, so it's kept in a hash table
+ * indexed by cookie rather than in a list.
+ */
+#define REG_SHM_HASH_BITS	6
+#define REG_SHM_HASH_SIZE	BIT(REG_SHM_HASH_BITS)
+
+static LIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_hash[REG_SHM_HASH_SIZE];
+static size_t reg_shm_count;
+static size_t reg_shm_max_count;
 
 static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
 
+/*
+ * Mapped objects with a zero mapcount, least recently used first.
+ * Protected by reg_shm_map_lock.
+ */
+static TAILQ_HEAD(, mobj_reg_shm) reg_shm_map_cache =
+	TAILQ_HEAD_INITIALIZER(reg_shm_map_cache);
+static size_t reg_shm_map_cache_count;
+
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
+static struct reg_shm_head *cookie_to_head(uint64_t cookie)
+{
+	uint32_t h = cookie ^ (cookie >> 32);
+
+	return reg_shm_hash + ((h * 2654435761U) >> (32 - REG_SHM_HASH_BITS));
+}
+
+/* Returns the run holding page @page_idx of the mobj */
+static const struct reg_shm_run *find_run(struct mobj_reg_shm *r,
+					  size_t page_idx)
+{
+	size_t lo = 0;
+	size_t hi = r->num_runs;
+	size_t n = 0;
+
+	while (hi - lo > 1) {
+		n = lo + (hi - lo) / 2;
+		if (r->runs[n].page_idx <= page_idx)
+			lo = n;
+		else
+			hi = n;
+	}
+
+	return r->runs + lo;
+}
+DECLARE_KEEP_PAGER(find_run);
+
+static size_t run_num_pages(struct mobj_reg_shm *r, size_t n)
+{
+	if (n + 1 < r->num_runs)
+		return r->runs[n + 1].page_idx - r->runs[n].page_idx;
+	return r->num_pages - r->runs[n].page_idx;
+}
+
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
 				      size_t granule, paddr_t *pa)
 {
 	struct mobj_reg_shm *mobj_reg_shm = to_mobj_reg_shm(mobj);
+	const struct reg_shm_run *run = NULL;
 	size_t full_offset = 0;
+	size_t page_idx = 0;
 	paddr_t p = 0;
 
 	if (!pa)
@@ -74,13 +140,15 @@ static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
 		return TEE_ERROR_GENERIC;
 
 	full_offset = offst + mobj_reg_shm->page_offset;
+	page_idx = full_offset / SMALL_PAGE_SIZE;
+	run = find_run(mobj_reg_shm, page_idx);
+	p = run->pa + (page_idx - run->page_idx) * SMALL_PAGE_SIZE;
+
 	switch (granule) {
 	case 0:
-		p = mobj_reg_shm->pages[full_offset / SMALL_PAGE_SIZE] +
-			(full_offset & SMALL_PAGE_MASK);
+		p += full_offset & SMALL_PAGE_MASK;
 		break;
 	case SMALL_PAGE_SIZE:
-		p = mobj_reg_shm->pages[full_offset / SMALL_PAGE_SIZE];
 		break;
 	default:
 		return TEE_ERROR_GENERIC;
@@ -109,15 +177,48 @@ static void *mobj_reg_shm_get_va(struct mobj *mobj, size_t offst, size_t len)
 				 mrs->page_offset);
 }
 
+static void map_cache_remove(struct mobj_reg_shm *r)
+{
+	if (r->map_cached) {
+		TAILQ_REMOVE(&reg_shm_map_cache, r, map_cache_link);
+		r->map_cached = false;
+		assert(reg_shm_map_cache_count);
+		reg_shm_map_cache_count--;
+	}
+}
+
 static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
 {
 	assert(r->mm);
+	map_cache_remove(r);
 	assert(r->mm->pool->shift == SMALL_PAGE_SHIFT);
 	core_mmu_unmap_pages(tee_mm_get_smem(r->mm), r->mm->size);
 	tee_mm_free(r->mm);
 	r->mm = NULL;
 }
 
+static bool map_cache_evict(void)
+{
+	struct mobj_reg_shm *r = TAILQ_FIRST(&reg_shm_map_cache);
+
+	if (!r)
+		return false;
+
+	reg_shm_unmap_helper(r);
+	return true;
+}
+
+static void map_cache_add(struct mobj_reg_shm *r)
+{
+	assert(!r->map_cached);
+	TAILQ_INSERT_TAIL(&reg_shm_map_cache, r, map_cache_link);
+	r->map_cached = true;
+	reg_shm_map_cache_count++;
+
+	while (reg_shm_map_cache_count > CFG_CORE_DYN_SHM_MAP_CACHE)
+		map_cache_evict();
+}
+
 static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
@@ -127,7 +228,9 @@ static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
+	LIST_REMOVE(mobj_reg_shm, next);
+	assert(reg_shm_count);
+	reg_shm_count--;
 	free(mobj_reg_shm);
 }
 
@@ -179,7 +282,9 @@ static TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj)
 	TEE_Result res = TEE_SUCCESS;
 	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
 	uint32_t exceptions = 0;
+	vaddr_t va = 0;
 	size_t sz = 0;
+	size_t n = 0;
 
 	while (true) {
 		if (refcount_inc(&r->mapcount))
@@ -200,18 +305,32 @@ static TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj)
 	 * If we have beaten another thread calling mobj_reg_shm_dec_map()
 	 * to get the lock we need only to reinitialize mapcount to 1.
 	 */
-	if (!r->mm) {
+	if (r->mm) {
+		/* Still mapped since last used, keep the mapping */
+		map_cache_remove(r);
+	} else {
 		sz = ROUNDUP(mobj->size + r->page_offset, SMALL_PAGE_SIZE);
 		r->mm = tee_mm_alloc(&core_virt_shm_pool, sz);
+		/* Make room by unmapping unused objects if needed */
+		while (!r->mm && map_cache_evict())
+			r->mm = tee_mm_alloc(&core_virt_shm_pool, sz);
 		if (!r->mm) {
 			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto out;
 		}
 
-		res = core_mmu_map_pages(tee_mm_get_smem(r->mm), r->pages,
-					 sz / SMALL_PAGE_SIZE,
-					 MEM_AREA_NSEC_SHM);
+		va = tee_mm_get_smem(r->mm);
+		assert(sz / SMALL_PAGE_SIZE == r->num_pages);
+		for (n = 0; n < r->num_runs; n++) {
+			res = core_mmu_map_contiguous_pages(va +
+					r->runs[n].page_idx * SMALL_PAGE_SIZE,
+					r->runs[n].pa, run_num_pages(r, n),
+					MEM_AREA_NSEC_SHM);
+			if (res)
+				break;
+		}
 		if (res) {
+			core_mmu_unmap_pages(va, sz / SMALL_PAGE_SIZE);
 			tee_mm_free(r->mm);
 			r->mm = NULL;
 			goto out;
@@ -242,8 +361,12 @@ static TEE_Result mobj_reg_shm_dec_map(struct mobj *mobj)
 	 *   NULL
 	 * before we acquired the spinlock
 	 */
-	if (!refcount_val(&r->mapcount) && r->mm)
-		reg_shm_unmap_helper(r);
+	if (!refcount_val(&r->mapcount) && r->mm) {
+		if (CFG_CORE_DYN_SHM_MAP_CACHE)
+			map_cache_add(r);
+		else
+			reg_shm_unmap_helper(r);
+	}
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
@@ -297,52 +420,148 @@ static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj)
 	return container_of(mobj, struct mobj_reg_shm, mobj);
 }
 
-struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
-				paddr_t page_offset, uint64_t cookie)
+static bool run_is_nsec(paddr_t pa, size_t num_pages)
 {
-	struct mobj_reg_shm *mobj_reg_shm = NULL;
-	size_t i = 0;
-	uint32_t exceptions = 0;
+	size_t len = 0;
+
+	if (!num_pages || (pa & SMALL_PAGE_MASK))
+		return false;
+	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &len))
+		return false;
+
+	/* Only Non-secure memory can be mapped there */
+	return core_pbuf_is(CORE_MEM_NON_SEC, pa, len);
+}
+
+static struct mobj_reg_shm *reg_shm_new(size_t num_runs, size_t num_pages,
+					paddr_t page_offset, uint64_t cookie)
+{
+	struct mobj_reg_shm *r = NULL;
 	size_t s = 0;
 
-	if (!num_pages || page_offset >= SMALL_PAGE_SIZE)
+	if (!num_runs || page_offset >= SMALL_PAGE_SIZE)
+		return NULL;
+	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &s))
 		return NULL;
 
-	s = mobj_reg_shm_size(num_pages);
+	s = mobj_reg_shm_size(num_runs);
 	if (!s)
 		return NULL;
-	mobj_reg_shm = calloc(1, s);
-	if (!mobj_reg_shm)
+	r = calloc(1, s);
+	if (!r)
+		return NULL;
+
+	r->mobj.ops = &mobj_reg_shm_ops;
+	r->mobj.size = num_pages * SMALL_PAGE_SIZE - page_offset;
+	/*
+	 * Physically contiguous memory has a zero physical granule. This
+	 * lets users of the mobj translate and map the whole range at once.
+	 */
+	if (num_runs > 1)
+		r->mobj.phys_granule = SMALL_PAGE_SIZE;
+	refcount_set(&r->mobj.refc, 1);
+	r->cookie = cookie;
+	r->guarded = true;
+	r->page_offset = page_offset;
+	r->num_pages = num_pages;
+	r->num_runs = num_runs;
+
+	return r;
+}
+
+static struct mobj *reg_shm_publish(struct mobj_reg_shm *r)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+
+	LIST_INSERT_HEAD(cookie_to_head(r->cookie), r, next);
+	reg_shm_count++;
+	reg_shm_max_count = MAX(reg_shm_max_count, reg_shm_count);
+	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+
+	return &r->mobj;
+}
+
+/* Tells if @ext starts a new run rather than extending the previous one */
+static bool extent_starts_run(const struct mobj_shm_extent *ext, size_t n)
+{
+	return !n || ext[n].pa != ext[n - 1].pa +
+				  ext[n - 1].num_pages * SMALL_PAGE_SIZE;
+}
+
+struct mobj *mobj_reg_shm_alloc_extents(const struct mobj_shm_extent *ext,
+					size_t num_ext, paddr_t page_offset,
+					uint64_t cookie)
+{
+	struct mobj_reg_shm *r = NULL;
+	size_t num_pages = 0;
+	size_t num_runs = 0;
+	size_t n = 0;
+
+	/* Each extent is checked once as a whole */
+	for (n = 0; n < num_ext; n++) {
+		if (!run_is_nsec(ext[n].pa, ext[n].num_pages))
+			return NULL;
+		if (ADD_OVERFLOW(num_pages, ext[n].num_pages, &num_pages))
+			return NULL;
+		if (extent_starts_run(ext, n))
+			num_runs++;
+	}
+
+	r = reg_shm_new(num_runs, num_pages, page_offset, cookie);
+	if (!r)
 		return NULL;
 
-	mobj_reg_shm->mobj.ops = &mobj_reg_shm_ops;
-	mobj_reg_shm->mobj.size = num_pages * SMALL_PAGE_SIZE - page_offset;
-	mobj_reg_shm->mobj.phys_granule = SMALL_PAGE_SIZE;
-	refcount_set(&mobj_reg_shm->mobj.refc, 1);
-	mobj_reg_shm->cookie = cookie;
-	mobj_reg_shm->guarded = true;
-	mobj_reg_shm->page_offset = page_offset;
-	memcpy(mobj_reg_shm->pages, pages, sizeof(*pages) * num_pages);
+	/* Adjacent extents are merged into the same run */
+	num_pages = 0;
+	num_runs = 0;
+	for (n = 0; n < num_ext; n++) {
+		if (extent_starts_run(ext, n)) {
+			r->runs[num_runs].pa = ext[n].pa;
+			r->runs[num_runs].page_idx = num_pages;
+			num_runs++;
+		}
+		num_pages += ext[n].num_pages;
+	}
+
+	return reg_shm_publish(r);
+}
+
+struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
+				paddr_t page_offset, uint64_t cookie)
+{
+	struct mobj_reg_shm *r = NULL;
+	size_t num_runs = 0;
+	size_t first = 0;
+	size_t n = 0;
 
 	/* Ensure loaded references match format and security constraints */
-	for (i = 0; i < num_pages; i++) {
-		if (mobj_reg_shm->pages[i] & SMALL_PAGE_MASK)
-			goto err;
-
-		/* Only Non-secure memory can be mapped there */
-		if (!core_pbuf_is(CORE_MEM_NON_SEC, mobj_reg_shm->pages[i],
-				  SMALL_PAGE_SIZE))
-			goto err;
+	for (n = 0; n < num_pages; n++) {
+		if (pages[n] & SMALL_PAGE_MASK)
+			return NULL;
+		if (n && pages[n] == pages[n - 1] + SMALL_PAGE_SIZE)
+			continue;
+		if (n && !run_is_nsec(pages[first], n - first))
+			return NULL;
+		first = n;
+		num_runs++;
 	}
+	if (num_pages && !run_is_nsec(pages[first], num_pages - first))
+		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	r = reg_shm_new(num_runs, num_pages, page_offset, cookie);
+	if (!r)
+		return NULL;
 
-	return &mobj_reg_shm->mobj;
-err:
-	free(mobj_reg_shm);
-	return NULL;
+	num_runs = 0;
+	for (n = 0; n < num_pages; n++) {
+		if (!n || pages[n] != pages[n - 1] + SMALL_PAGE_SIZE) {
+			r->runs[num_runs].pa = pages[n];
+			r->runs[num_runs].page_idx = n;
+			num_runs++;
+		}
+	}
+
+	return reg_shm_publish(r);
 }
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
@@ -353,17 +572,43 @@ void mobj_reg_shm_unguard(struct mobj *mobj)
 	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
 }
 
+bool mobj_is_registered_shm(struct mobj *mobj)
+{
+	struct mobj_reg_shm *r = NULL;
+	uint32_t exceptions = 0;
+	bool ret = false;
+
+	if (mobj->ops != &mobj_reg_shm_ops)
+		return false;
+
+	r = to_mobj_reg_shm(mobj);
+	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	ret = !r->guarded && !r->releasing;
+	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+
+	return ret;
+}
+
 static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	LIST_FOREACH(mobj_reg_shm, cookie_to_head(cookie), next)
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
 
 	return NULL;
 }
 
+void mobj_reg_shm_get_stats(size_t *count, size_t *max_count)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+
+	*count = reg_shm_count;
+	*max_count = reg_shm_max_count;
+	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+}
+
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
 	struct mobj_reg_shm *r = NULL;
@@ -404,6 +649,10 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 
 	mobj_put(&r->mobj);
 
+	/* Idle TAs may keep the buffer mapped since a previous call */
+	if (IS_ENABLED(CFG_TA_PARAM_MAP_CACHE))
+		tee_ta_flush_param_mappings();
+
 	/*
 	 * We've established that this function can release the cookie.
 	 * Now we wait until mobj_reg_shm_free() is called by the last
@@ -437,12 +686,8 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	return TEE_SUCCESS;
 }
 
-struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
-				  paddr_t page_offset, uint64_t cookie)
+static struct mobj *map_reg_shm(struct mobj *mobj)
 {
-	struct mobj *mobj = mobj_reg_shm_alloc(pages, num_pages,
-					       page_offset, cookie);
-
 	if (!mobj)
 		return NULL;
 
@@ -454,6 +699,22 @@ struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 	return mobj;
 }
 
+struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
+				  paddr_t page_offset, uint64_t cookie)
+{
+	return map_reg_shm(mobj_reg_shm_alloc(pages, num_pages, page_offset,
+					      cookie));
+}
+
+struct mobj *
+mobj_mapped_shm_alloc_extents(const struct mobj_shm_extent *ext,
+			      size_t num_ext, paddr_t page_offset,
+			      uint64_t cookie)
+{
+	return map_reg_shm(mobj_reg_shm_alloc_extents(ext, num_ext,
+						      page_offset, cookie));
+}
+
 static TEE_Result mobj_mapped_shm_init(void)
 {
 	vaddr_t pool_start = 0;
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <io.h>
+#include <mm/page_lz.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * The compressed data is a sequence of:
+ * - a token byte, the upper nibble is the number of literals and the
+ *   lower nibble is the match length minus PAGE_LZ_MIN_MATCH, a nibble
+ *   with value 15 is followed by extension bytes added to it where each
+ *   byte of value 255 is followed by another
+ * - the literals
+ * - the little endian 16-bit offset of the match
+ *
+ * The last sequence ends after its literals and has no match.
+ */
+
+#define PAGE_LZ_MIN_MATCH	4
+#define PAGE_LZ_NIBBLE_MAX	15
+#define PAGE_LZ_MAX_OFFS	UINT16_MAX
+
+static unsigned int hash(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - PAGE_LZ_HASH_BITS);
+}
+
+static bool put_len(uint8_t *dst, size_t dst_len, size_t *op, size_t len)
+{
+	while (len >= 255) {
+		if (*op >= dst_len)
+			return false;
+		dst[(*op)++] = 255;
+		len -= 255;
+	}
+	if (*op >= dst_len)
+		return false;
+	dst[(*op)++] = len;
+
+	return true;
+}
+
+static bool put_seq(uint8_t *dst, size_t dst_len, size_t *op,
+		    const uint8_t *lit, size_t lit_len, size_t offs,
+		    size_t match_len)
+{
+	size_t mlen = 0;
+
+	if (offs)
+		mlen = match_len - PAGE_LZ_MIN_MATCH;
+
+	if (*op >= dst_len)
+		return false;
+	dst[(*op)++] = (MIN(lit_len, PAGE_LZ_NIBBLE_MAX) << 4) |
+		       MIN(mlen, PAGE_LZ_NIBBLE_MAX);
+
+	if (lit_len >= PAGE_LZ_NIBBLE_MAX &&
+	    !put_len(dst, dst_len, op, lit_len - PAGE_LZ_NIBBLE_MAX))
+		return false;
+	if (lit_len > dst_len - *op)
+		return false;
+	memcpy(dst + *op, lit, lit_len);
+	*op += lit_len;
+
+	if (!offs)
+		return true;
+
+	if (dst_len - *op < 2)
+		return false;
+	dst[(*op)++] = offs;
+	dst[(*op)++] = offs >> 8;
+	if (mlen >= PAGE_LZ_NIBBLE_MAX &&
+	    !put_len(dst, dst_len, op, mlen - PAGE_LZ_NIBBLE_MAX))
+		return false;
+
+	return true;
+}
+
+size_t page_lz_compress(const uint8_t *src, size_t src_len, uint8_t *dst,
+			size_t dst_len, struct page_lz_work *work)
+{
+	size_t anchor = 0;
+	size_t ip = 0;
+	size_t op = 0;
+
+	assert(src_len <= PAGE_LZ_MAX_OFFS + 1);
+
+	memset(work->htab, 0, sizeof(work->htab));
+
+	while (ip + PAGE_LZ_MIN_MATCH <= src_len) {
+		uint32_t v = get_unaligned_le32(src + ip);
+		unsigned int h = hash(v);
+		size_t ref = work->htab[h];
+		size_t mlen = PAGE_LZ_MIN_MATCH;
+
+		work->htab[h] = ip + 1;
+		if (!ref-- || get_unaligned_le32(src + ref) != v) {
+			ip++;
+			continue;
+		}
+
+		while (ip + mlen < src_len && src[ref + mlen] == src[ip + mlen])
+			mlen++;
+
+		if (!put_seq(dst, dst_len, &op, src + anchor, ip - anchor,
+			     ip - ref, mlen))
+			return 0;
+		ip += mlen;
+		anchor = ip;
+	}
+
+	if (!put_seq(dst, dst_len, &op, src + anchor, src_len - anchor, 0, 0))
+		return 0;
+
+	return op;
+}
+
+static bool get_len(const uint8_t *src, size_t src_len, size_t *ip,
+		    size_t *len)
+{
+	uint8_t b = 0;
+
+	do {
+		if (*ip >= src_len)
+			return false;
+		b = src[(*ip)++];
+		*len += b;
+	} while (b == 255);
+
+	return true;
+}
+
+TEE_Result page_lz_decompress(const uint8_t *src, size_t src_len,
+			      uint8_t *dst, size_t dst_len)
+{
+	size_t ip = 0;
+	size_t op = 0;
+
+	while (ip < src_len) {
+		uint8_t token = src[ip++];
+		size_t lit_len = token >> 4;
+		size_t mlen = token & PAGE_LZ_NIBBLE_MAX;
+		size_t offs = 0;
+		size_t n = 0;
+
+		if (lit_len == PAGE_LZ_NIBBLE_MAX &&
+		    !get_len(src, src_len, &ip, &lit_len))
+			return TEE_ERROR_CORRUPT_OBJECT;
+		if (lit_len > src_len - ip || lit_len > dst_len - op)
+			return TEE_ERROR_CORRUPT_OBJECT;
+		memcpy(dst + op, src + ip, lit_len);
+		ip += lit_len;
+		op += lit_len;
+
+		if (ip == src_len)
+			break;
+
+		if (src_len - ip < 2)
+			return TEE_ERROR_CORRUPT_OBJECT;
+		offs = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+		if (mlen == PAGE_LZ_NIBBLE_MAX &&
+		    !get_len(src, src_len, &ip, &mlen))
+			return TEE_ERROR_CORRUPT_OBJECT;
+		mlen += PAGE_LZ_MIN_MATCH;
+		if (!offs || offs > op || mlen > dst_len - op)
+			return TEE_ERROR_CORRUPT_OBJECT;
+
+		/* The match may overlap the output, copy byte by byte */
+		for (n = 0; n < mlen; n++)
+			dst[op + n] = dst[op + n - offs];
+		op += mlen;
+	}
+
+	if (op != dst_len)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+}
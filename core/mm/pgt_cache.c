@@ -10,6 +10,7 @@
 #include <kernel/user_mode_ctx.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <mm/mobj.h>
 #include <mm/pgt_cache.h>
 #include <mm/phys_mem.h>
 #include <mm/tee_pager.h>
@@ -84,7 +85,7 @@ static void free_pgt(struct pgt *pgt)
 		 * can free this.
 		 */
 		SLIST_REMOVE(&parent_list, parent, pgt_parent, link);
-		tee_mm_free(parent->mm);
+		phys_mem_free(parent->mm);
 		free(parent);
 	} else {
 		SLIST_INSERT_HEAD(&parent->pgt_cache, pgt, link);
@@ -443,6 +444,7 @@ static struct pgt *pop_from_free_list(void)
 
 static void push_to_free_list(struct pgt *p)
 {
+	pgt_forget_ro_maps(p);
 	SLIST_INSERT_HEAD(&pgt_free_list, p, link);
 #if defined(CFG_WITH_PAGER)
 	tee_pager_release_phys(p->tbl, PGT_SIZE);
@@ -473,6 +475,7 @@ static struct pgt *pop_from_free_list(void)
 
 static void push_to_free_list(struct pgt *p)
 {
+	pgt_forget_ro_maps(p);
 	SLIST_INSERT_HEAD(&p->parent->pgt_cache, p, link);
 	assert(p->parent->num_used > 0);
 	p->parent->num_used--;
@@ -599,6 +602,7 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 		if (!p)
 			return NULL;
 		tee_pager_pgt_save_and_release_entries(p);
+		pgt_forget_ro_maps(p);
 		memset(p->tbl, 0, PGT_SIZE);
 		p->populated = false;
 	}
@@ -607,6 +611,112 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 	return p;
 }
 
+#if defined(CFG_PGT_CACHE_REUSE_RO)
+void pgt_forget_ro_maps(struct pgt *pgt)
+{
+	size_t n = 0;
+
+	for (n = 0; n < pgt->num_ro_maps; n++) {
+		mobj_put(pgt->ro_maps[n].mobj);
+		pgt->ro_maps[n] = (struct pgt_ro_map){ };
+	}
+	pgt->num_ro_maps = 0;
+}
+
+/*
+ * Collects the mappings of @vm_info inside the CORE_MMU_PGDIR_SIZE range
+ * starting at @vabase. Returns the number of mappings found or 0 if the
+ * range holds a mapping which can't be reused by another context.
+ */
+static size_t get_ro_maps(struct vm_info *vm_info, vaddr_t vabase,
+			  struct pgt_ro_map *maps)
+{
+	vaddr_t end = vabase + CORE_MMU_PGDIR_SIZE;
+	struct vm_region *r = NULL;
+	size_t count = 0;
+
+	TAILQ_FOREACH(r, &vm_info->regions, link) {
+		if (r->va + r->size <= vabase)
+			continue;
+		if (r->va >= end)
+			break;
+		if (count == PGT_RO_MAP_COUNT || mobj_is_paged(r->mobj) ||
+		    (r->attr & (TEE_MATTR_UW | TEE_MATTR_PW)))
+			return 0;
+		maps[count] = (struct pgt_ro_map){
+			.mobj = r->mobj,
+			.va = r->va,
+			.size = r->size,
+			.offset = r->offset,
+			.attr = r->attr,
+		};
+		count++;
+	}
+
+	return count;
+}
+
+static bool ro_maps_match(struct pgt *pgt, struct pgt_ro_map *maps,
+			  size_t count)
+{
+	size_t n = 0;
+
+	if (pgt->num_ro_maps != count)
+		return false;
+
+	for (n = 0; n < count; n++) {
+		if (pgt->ro_maps[n].mobj != maps[n].mobj ||
+		    pgt->ro_maps[n].va != maps[n].va ||
+		    pgt->ro_maps[n].size != maps[n].size ||
+		    pgt->ro_maps[n].offset != maps[n].offset ||
+		    pgt->ro_maps[n].attr != maps[n].attr)
+			return false;
+	}
+
+	return true;
+}
+
+void pgt_reuse_ro_tables(struct user_mode_ctx *uctx)
+{
+	struct pgt_ro_map maps[PGT_RO_MAP_COUNT] = { };
+	struct pgt *src = NULL;
+	struct pgt *p = NULL;
+	size_t count = 0;
+	size_t n = 0;
+
+	mutex_lock(&pgt_mu);
+
+	SLIST_FOREACH(p, &uctx->pgt_cache, link) {
+		if (p->populated || p->num_ro_maps)
+			continue;
+		count = get_ro_maps(&uctx->vm_info, p->vabase, maps);
+		if (!count)
+			continue;
+
+		SLIST_FOREACH(src, &pgt_cache_list, link) {
+			if (src->populated && src->vabase == p->vabase &&
+			    ro_maps_match(src, maps, count)) {
+				memcpy(p->tbl, src->tbl, PGT_SIZE);
+				p->populated = true;
+				break;
+			}
+		}
+
+		/*
+		 * If the table wasn't copied it's about to be populated
+		 * from these mappings.
+		 */
+		for (n = 0; n < count; n++) {
+			p->ro_maps[n] = maps[n];
+			mobj_get(maps[n].mobj);
+		}
+		p->num_ro_maps = count;
+	}
+
+	mutex_unlock(&pgt_mu);
+}
+#endif /*CFG_PGT_CACHE_REUSE_RO*/
+
 void pgt_flush(struct user_mode_ctx *uctx)
 {
 	struct ts_ctx *ctx = uctx->ts_ctx;
@@ -750,6 +860,7 @@ static void clear_ctx_range_from_list(struct pgt_cache *pgt_cache,
 		if (b >= e)
 			continue;
 
+		pgt_forget_ro_maps(p);
 		tbl = p->tbl;
 		idx = (b - p->vabase) / SMALL_PAGE_SIZE;
 		n = (e - b) / SMALL_PAGE_SIZE;
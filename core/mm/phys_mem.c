@@ -3,8 +3,10 @@
  * Copyright (c) 2024, Linaro Limited
  */
 
+#include <config.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
+#include <kernel/virtualization.h>
 #include <mm/core_mmu.h>
 #include <mm/phys_mem.h>
 #include <mm/tee_mm.h>
@@ -204,7 +206,21 @@ tee_mm_entry_t *phys_mem_core_alloc(size_t size)
 
 tee_mm_entry_t *phys_mem_ta_alloc(size_t size)
 {
-	return mm_alloc(ta_pool, core_pool, size);
+	tee_mm_entry_t *mm = mm_alloc(ta_pool, core_pool, size);
+
+	if (!mm && IS_ENABLED(CFG_VIRT_GUEST_TA_RAM_ON_DEMAND))
+		mm = virt_ta_mem_alloc(size);
+
+	return mm;
+}
+
+void phys_mem_free(tee_mm_entry_t *mm)
+{
+	if (IS_ENABLED(CFG_VIRT_GUEST_TA_RAM_ON_DEMAND) && mm &&
+	    mm->pool != core_pool && mm->pool != ta_pool)
+		virt_ta_mem_free(mm);
+	else
+		tee_mm_free(mm);
 }
 
 tee_mm_entry_t *phys_mem_alloc2(paddr_t base, size_t size)
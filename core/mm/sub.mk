@@ -1,5 +1,6 @@
 srcs-y += mobj.c
 srcs-y += fobj.c
+srcs-$(CFG_PAGER_RW_COMPRESS) += page_lz.c
 cflags-fobj.c-$(CFG_CORE_PAGE_TAG_AND_IV) := -Wno-missing-noreturn
 srcs-y += file.c
 srcs-y += vm.c
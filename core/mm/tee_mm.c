@@ -20,14 +20,6 @@ static void *pmalloc(tee_mm_pool_t *pool, size_t size)
 		return malloc(size);
 }
 
-static void *pcalloc(tee_mm_pool_t *pool, size_t num_el, size_t size)
-{
-	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
-		return nex_calloc(num_el, size);
-	else
-		return calloc(num_el, size);
-}
-
 static void pfree(tee_mm_pool_t *pool, void *ptr)
 {
 	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
@@ -56,57 +48,295 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_size_t size,
 		.size = size,
 		.shift = shift,
 		.flags = flags,
+		.initialized = true,
+		.lock = SPINLOCK_UNLOCK,
 	};
 
-	pool->entry = pcalloc(pool, 1, sizeof(tee_mm_entry_t));
-	if (pool->entry == NULL)
-		return false;
-
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		pool->entry->offset = ((size - 1) >> shift) + 1;
-
-	pool->entry->pool = pool;
-	pool->lock = SPINLOCK_UNLOCK;
-
 	return true;
 }
 
 void tee_mm_final(tee_mm_pool_t *pool)
 {
-	if (pool == NULL || pool->entry == NULL)
+	if (pool == NULL || !pool->initialized)
 		return;
 
-	while (pool->entry->next != NULL)
-		tee_mm_free(pool->entry->next);
-	pfree(pool, pool->entry);
-	pool->entry = NULL;
+	while (pool->root)
+		tee_mm_free(pool->root);
+	pool->initialized = false;
 }
 
-static void tee_mm_add(tee_mm_entry_t *p, tee_mm_entry_t *nn)
+static uint32_t pool_units(const tee_mm_pool_t *pool)
 {
-	/* add to list */
-	nn->next = p->next;
-	p->next = nn;
+	return pool->size >> pool->shift;
 }
 
-#ifdef CFG_WITH_STATS
-static size_t tee_mm_stats_allocated(tee_mm_pool_t *pool)
+/*
+ * The tree is ordered by the start of the entries counted from the low
+ * end of the pool, or from the high end with TEE_MM_POOL_HI_ALLOC. That
+ * way the allocation order is the same in both cases.
+ */
+static uint32_t entry_start(const tee_mm_pool_t *pool,
+			    const tee_mm_entry_t *e)
 {
-	tee_mm_entry_t *entry;
-	uint32_t sz = 0;
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
+		return pool_units(pool) - e->offset - e->size;
+	return e->offset;
+}
 
-	if (!pool)
+static uint32_t entry_end(const tee_mm_pool_t *pool, const tee_mm_entry_t *e)
+{
+	return entry_start(pool, e) + e->size;
+}
+
+static void entry_set_start(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+			    uint32_t start, uint32_t size)
+{
+	e->pool = pool;
+	e->size = size;
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
+		e->offset = pool_units(pool) - start - size;
+	else
+		e->offset = start;
+}
+
+/* Entries of zero size at the same start are ordered by address */
+static bool entry_is_before(const tee_mm_pool_t *pool,
+			    const tee_mm_entry_t *a, const tee_mm_entry_t *b)
+{
+	uint32_t sa = entry_start(pool, a);
+	uint32_t sb = entry_start(pool, b);
+
+	if (sa != sb)
+		return sa < sb;
+	if (a->size != b->size)
+		return a->size < b->size;
+	return (vaddr_t)a < (vaddr_t)b;
+}
+
+static uint8_t node_height(const tee_mm_entry_t *e)
+{
+	if (!e)
 		return 0;
+	return e->height;
+}
 
-	entry = pool->entry;
-	while (entry) {
-		sz += entry->size;
-		entry = entry->next;
+static uint32_t node_max_gap(const tee_mm_entry_t *e)
+{
+	if (!e)
+		return 0;
+	return e->max_gap;
+}
+
+static void node_update(tee_mm_entry_t *e)
+{
+	uint32_t child_gap = MAX(node_max_gap(e->left), node_max_gap(e->right));
+
+	e->height = MAX(node_height(e->left), node_height(e->right)) + 1;
+	e->max_gap = MAX(e->gap, child_gap);
+}
+
+static tee_mm_entry_t *rotate_left(tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *r = e->right;
+
+	e->right = r->left;
+	r->left = e;
+	node_update(e);
+	node_update(r);
+
+	return r;
+}
+
+static tee_mm_entry_t *rotate_right(tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *l = e->left;
+
+	e->left = l->right;
+	l->right = e;
+	node_update(e);
+	node_update(l);
+
+	return l;
+}
+
+static tee_mm_entry_t *node_balance(tee_mm_entry_t *e)
+{
+	int bal = node_height(e->left) - node_height(e->right);
+
+	node_update(e);
+
+	if (bal > 1) {
+		if (node_height(e->left->left) < node_height(e->left->right))
+			e->left = rotate_left(e->left);
+		return rotate_right(e);
+	}
+	if (bal < -1) {
+		if (node_height(e->right->right) < node_height(e->right->left))
+			e->right = rotate_right(e->right);
+		return rotate_left(e);
+	}
+
+	return e;
+}
+
+static tee_mm_entry_t *node_insert(tee_mm_pool_t *pool, tee_mm_entry_t *node,
+				   tee_mm_entry_t *e)
+{
+	if (!node) {
+		e->left = NULL;
+		e->right = NULL;
+		node_update(e);
+		return e;
+	}
+
+	if (entry_is_before(pool, e, node))
+		node->left = node_insert(pool, node->left, e);
+	else
+		node->right = node_insert(pool, node->right, e);
+
+	return node_balance(node);
+}
+
+static tee_mm_entry_t *node_remove_min(tee_mm_entry_t *node,
+				       tee_mm_entry_t **min)
+{
+	if (!node->left) {
+		*min = node;
+		return node->right;
+	}
+
+	node->left = node_remove_min(node->left, min);
+
+	return node_balance(node);
+}
+
+static tee_mm_entry_t *node_remove(tee_mm_pool_t *pool, tee_mm_entry_t *node,
+				   tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *min = NULL;
+
+	if (!node)
+		panic("invalid mm_entry");
+
+	if (node != e) {
+		if (entry_is_before(pool, e, node))
+			node->left = node_remove(pool, node->left, e);
+		else
+			node->right = node_remove(pool, node->right, e);
+		return node_balance(node);
+	}
+
+	if (!e->right)
+		return e->left;
+
+	/*
+	 * Replace by the successor, this also updates the nodes between
+	 * the successor and here as the gap of the successor has changed.
+	 */
+	e->right = node_remove_min(e->right, &min);
+	min->left = e->left;
+	min->right = e->right;
+
+	return node_balance(min);
+}
+
+/* Returns the closest entries before and after @e, which may be in the tree */
+static void find_neighbours(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+			    tee_mm_entry_t **prev, tee_mm_entry_t **next)
+{
+	tee_mm_entry_t *node = pool->root;
+
+	*prev = NULL;
+	*next = NULL;
+	while (node) {
+		if (node == e) {
+			node = e->left;
+			while (node) {
+				*prev = node;
+				node = node->right;
+			}
+			node = e->right;
+			while (node) {
+				*next = node;
+				node = node->left;
+			}
+			return;
+		}
+		if (entry_is_before(pool, e, node)) {
+			*next = node;
+			node = node->left;
+		} else {
+			*prev = node;
+			node = node->right;
+		}
+	}
+}
+
+static void tee_mm_add(tee_mm_pool_t *pool, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *prev = NULL;
+	tee_mm_entry_t *next = NULL;
+	uint32_t start = entry_start(pool, e);
+
+	find_neighbours(pool, e, &prev, &next);
+	if (prev)
+		e->gap = start - entry_end(pool, prev);
+	else
+		e->gap = start;
+	/*
+	 * The next entry is on the path to where @e is inserted so its
+	 * subtree is updated by node_insert().
+	 */
+	if (next)
+		next->gap = entry_start(pool, next) - start - e->size;
+
+	pool->root = node_insert(pool, pool->root, e);
+}
+
+static void tee_mm_remove(tee_mm_pool_t *pool, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *prev = NULL;
+	tee_mm_entry_t *next = NULL;
+
+	/*
+	 * The next entry is either an ancestor of @e or the entry
+	 * replacing it so its subtree is updated by node_remove().
+	 */
+	find_neighbours(pool, e, &prev, &next);
+	if (next)
+		next->gap += e->gap + e->size;
+
+	pool->root = node_remove(pool, pool->root, e);
+}
+
+/* Returns the first entry preceded by at least @psize free units */
+static tee_mm_entry_t *find_gap(tee_mm_entry_t *node, uint32_t psize)
+{
+	while (node && node->max_gap >= psize) {
+		if (node_max_gap(node->left) >= psize)
+			node = node->left;
+		else if (node->gap >= psize)
+			return node;
+		else
+			node = node->right;
 	}
 
-	return sz << pool->shift;
+	return NULL;
 }
 
+static uint32_t tail_start(tee_mm_pool_t *pool)
+{
+	tee_mm_entry_t *node = pool->root;
+
+	if (!node)
+		return 0;
+	while (node->right)
+		node = node->right;
+
+	return entry_end(pool, node);
+}
+
+#ifdef CFG_WITH_STATS
 void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 			   bool reset)
 {
@@ -121,22 +351,55 @@ void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 
 	stats->size = pool->size;
 	stats->max_allocated = pool->max_allocated;
-	stats->allocated = tee_mm_stats_allocated(pool);
-
-	if (reset)
+	stats->allocated = pool->allocated;
+	/*
+	 * Failing while the pool has more free space than requested
+	 * indicates fragmentation.
+	 */
+	stats->num_alloc_fail = pool->num_alloc_fail;
+	stats->biggest_alloc_fail = pool->biggest_alloc_fail;
+	stats->biggest_alloc_fail_used = pool->biggest_alloc_fail_used;
+
+	if (reset) {
 		pool->max_allocated = 0;
+		pool->num_alloc_fail = 0;
+		pool->biggest_alloc_fail = 0;
+		pool->biggest_alloc_fail_used = 0;
+	}
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 }
 
-static void update_max_allocated(tee_mm_pool_t *pool)
+static void update_allocated(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+			     bool alloc)
 {
-	size_t sz = tee_mm_stats_allocated(pool);
+	size_t sz = (size_t)e->size << pool->shift;
 
-	if (sz > pool->max_allocated)
-		pool->max_allocated = sz;
+	if (alloc) {
+		pool->allocated += sz;
+		if (pool->allocated > pool->max_allocated)
+			pool->max_allocated = pool->allocated;
+	} else {
+		pool->allocated -= sz;
+	}
+}
+
+static void update_alloc_fail(tee_mm_pool_t *pool, size_t size)
+{
+	pool->num_alloc_fail++;
+	if (size > pool->biggest_alloc_fail) {
+		pool->biggest_alloc_fail = size;
+		pool->biggest_alloc_fail_used = pool->allocated;
+	}
 }
 #else /* CFG_WITH_STATS */
-static inline void update_max_allocated(tee_mm_pool_t *pool __unused)
+static inline void update_allocated(tee_mm_pool_t *pool __unused,
+				    tee_mm_entry_t *e __unused,
+				    bool alloc __unused)
+{
+}
+
+static inline void update_alloc_fail(tee_mm_pool_t *pool __unused,
+				     size_t size __unused)
 {
 }
 #endif /* CFG_WITH_STATS */
@@ -146,155 +409,116 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 	size_t psize;
 	tee_mm_entry_t *entry;
 	tee_mm_entry_t *nn;
-	size_t remaining;
+	uint32_t start;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool || !pool->initialized)
 		return NULL;
 
-	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
-	if (!nn)
-		return NULL;
-
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
 	if (!size)
 		psize = 0;
 	else
 		psize = ((size - 1) >> pool->shift) + 1;
 
-	/* find free slot */
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL && psize >
-		       (entry->offset - entry->next->offset -
-			entry->next->size))
-			entry = entry->next;
-	} else {
-		while (entry->next != NULL && psize >
-		       (entry->next->offset - entry->size - entry->offset))
-			entry = entry->next;
-	}
-
-	/* check if we have enough memory */
-	if (entry->next == NULL) {
-		if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-			/*
-			 * entry->offset is a "block count" offset from
-			 * pool->lo. The byte offset is
-			 * (entry->offset << pool->shift).
-			 * In the HI_ALLOC allocation scheme the memory is
-			 * allocated from the end of the segment, thus to
-			 * validate there is sufficient memory validate that
-			 * (entry->offset << pool->shift) > size.
-			 */
-			if ((entry->offset << pool->shift) < size) {
-				/* out of memory */
-				goto err;
-			}
-		} else {
-			if (!pool->size)
-				panic("invalid pool");
+	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
+	if (!nn)
+		return NULL;
 
-			remaining = pool->size;
-			remaining -= ((entry->offset + entry->size) <<
-				      pool->shift);
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
-			if (remaining < size) {
-				/* out of memory */
-				goto err;
-			}
-		}
+	/* find free slot, the first one large enough */
+	if (psize > pool_units(pool))
+		goto err;
+	entry = find_gap(pool->root, psize);
+	if (entry) {
+		start = entry_start(pool, entry) - entry->gap;
+	} else {
+		start = tail_start(pool);
+		/* check if we have enough memory */
+		if (pool_units(pool) - start < psize)
+			goto err;
 	}
 
-	tee_mm_add(entry, nn);
-
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		nn->offset = entry->offset - psize;
-	else
-		nn->offset = entry->offset + entry->size;
-	nn->size = psize;
-	nn->pool = pool;
+	entry_set_start(pool, nn, start, psize);
+	tee_mm_add(pool, nn);
 
-	update_max_allocated(pool);
+	update_allocated(pool, nn, true);
 
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return nn;
 err:
+	update_alloc_fail(pool, size);
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	pfree(pool, nn);
 	return NULL;
 }
 
-static inline bool fit_in_gap(tee_mm_pool_t *pool, tee_mm_entry_t *e,
-			      paddr_t offslo, paddr_t offshi)
+/*
+ * Returns true if no entry overlaps with the units from @start up to
+ * @end. Entries of zero size count as one unit, as they did when the
+ * entries were kept in a sorted list.
+ */
+static bool fit_in_gap(tee_mm_pool_t *pool, uint32_t start, uint32_t end)
 {
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		if (offshi > e->offset ||
-		    (e->next != NULL &&
-		     (offslo < e->next->offset + e->next->size)) ||
-		    (offshi << pool->shift) - 1 > pool->size)
-			/* memory not available */
-			return false;
-	} else {
-		if (offslo < (e->offset + e->size) ||
-		    (e->next != NULL && (offshi > e->next->offset)) ||
-		    (offshi << pool->shift) > pool->size)
-			/* memory not available */
-			return false;
+	tee_mm_entry_t *node = pool->root;
+	tee_mm_entry_t *prev = NULL;
+
+	if (end > pool_units(pool))
+		/* memory not available */
+		return false;
+
+	/* Find the last entry starting before @end */
+	while (node) {
+		if (entry_start(pool, node) < end) {
+			prev = node;
+			node = node->right;
+		} else {
+			node = node->left;
+		}
 	}
 
-	return true;
+	return !prev ||
+	       entry_start(pool, prev) + MAX(prev->size, 1U) <= start;
 }
 
 tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 {
-	tee_mm_entry_t *entry;
 	paddr_t offslo;
 	paddr_t offshi;
 	tee_mm_entry_t *mm;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool || !pool->initialized)
 		return NULL;
 
 	/* Wrapping and sanity check */
 	if ((base + size) < base || base < pool->lo)
 		return NULL;
 
+	offslo = (base - pool->lo) >> pool->shift;
+	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
+	if (offshi > pool_units(pool))
+		return NULL;
+
 	mm = pmalloc(pool, sizeof(tee_mm_entry_t));
 	if (!mm)
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
-	offslo = (base - pool->lo) >> pool->shift;
-	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
+	mm->pool = pool;
+	mm->offset = offslo;
+	mm->size = offshi - offslo;
 
-	/* find slot */
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL &&
-		       offshi < entry->next->offset + entry->next->size)
-			entry = entry->next;
-	} else {
-		while (entry->next != NULL && offslo > entry->next->offset)
-			entry = entry->next;
-	}
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
 	/* Check that memory is available */
-	if (!fit_in_gap(pool, entry, offslo, offshi))
+	if (!fit_in_gap(pool, entry_start(pool, mm), entry_end(pool, mm)))
 		goto err;
 
-	tee_mm_add(entry, mm);
-
-	mm->offset = offslo;
-	mm->size = offshi - offslo;
-	mm->pool = pool;
+	tee_mm_add(pool, mm);
 
-	update_max_allocated(pool);
+	update_allocated(pool, mm, true);
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return mm;
 err:
@@ -305,23 +529,14 @@ err:
 
 void tee_mm_free(tee_mm_entry_t *p)
 {
-	tee_mm_entry_t *entry;
 	uint32_t exceptions;
 
 	if (!p || !p->pool)
 		return;
 
 	exceptions = cpu_spin_lock_xsave(&p->pool->lock);
-	entry = p->pool->entry;
-
-	/* remove entry from list */
-	while (entry->next != NULL && entry->next != p)
-		entry = entry->next;
-
-	if (!entry->next)
-		panic("invalid mm_entry");
-
-	entry->next = entry->next->next;
+	tee_mm_remove(p->pool, p);
+	update_allocated(p->pool, p, false);
 	cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
 
 	pfree(p->pool, p);
@@ -346,11 +561,11 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 	bool ret;
 	uint32_t exceptions;
 
-	if (pool == NULL || pool->entry == NULL)
+	if (pool == NULL || !pool->initialized)
 		return true;
 
 	exceptions = cpu_spin_lock_xsave(&pool->lock);
-	ret = pool->entry == NULL || pool->entry->next == NULL;
+	ret = !pool->root;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 
 	return ret;
@@ -358,28 +573,33 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 
 tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 {
-	tee_mm_entry_t *entry = pool->entry;
-	uint16_t offset = (addr - pool->lo) >> pool->shift;
+	tee_mm_entry_t *entry = NULL;
+	uint32_t offset = 0;
+	uint32_t start = 0;
 	uint32_t exceptions;
 
 	if (!tee_mm_addr_is_within_range(pool, addr))
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
+	offset = (addr - pool->lo) >> pool->shift;
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
+		offset = pool_units(pool) - 1 - offset;
 
-	while (entry->next != NULL) {
-		entry = entry->next;
+	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
 
-		if ((offset >= entry->offset) &&
-		    (offset < (entry->offset + entry->size))) {
-			cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock,
-						 exceptions);
-			return entry;
-		}
+	entry = pool->root;
+	while (entry) {
+		start = entry_start(pool, entry);
+		if (offset < start)
+			entry = entry->left;
+		else if (offset < start + entry->size)
+			break;
+		else
+			entry = entry->right;
 	}
 
 	cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock, exceptions);
-	return NULL;
+	return entry;
 }
 
 uintptr_t tee_mm_get_smem(const tee_mm_entry_t *mm)
@@ -6,6 +6,7 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <config.h>
 #include <initcall.h>
 #include <kernel/panic.h>
@@ -166,26 +167,14 @@ static void rem_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 		pgt_flush_range(uctx, begin, last);
 }
 
-static void set_pa_range(struct core_mmu_table_info *ti, vaddr_t va,
-			 paddr_t pa, size_t size, uint32_t attr)
-{
-	unsigned int end = core_mmu_va2idx(ti, va + size);
-	unsigned int idx = core_mmu_va2idx(ti, va);
-
-	while (idx < end) {
-		core_mmu_set_entry(ti, idx, pa, attr);
-		idx++;
-		pa += BIT64(ti->shift);
-	}
-}
-
 static void set_reg_in_table(struct core_mmu_table_info *ti,
 			     struct vm_region *r)
 {
 	vaddr_t va = MAX(r->va, ti->va_base);
 	vaddr_t end = MIN(r->va + r->size, ti->va_base + CORE_MMU_PGDIR_SIZE);
-	size_t sz = MIN(end - va, mobj_get_phys_granule(r->mobj));
 	size_t granule = BIT(ti->shift);
+	size_t sz = MIN(end - va, ROUNDUP(mobj_get_phys_granule(r->mobj),
+					  granule));
 	size_t offset = 0;
 	paddr_t pa = 0;
 
@@ -193,7 +182,7 @@ static void set_reg_in_table(struct core_mmu_table_info *ti,
 		offset = va - r->va + r->offset;
 		if (mobj_get_pa(r->mobj, offset, granule, &pa))
 			panic("Failed to get PA");
-		set_pa_range(ti, va, pa, sz, r->attr);
+		core_mmu_set_user_entries(ti, va, pa, sz, r->attr);
 		va += sz;
 	}
 }
@@ -212,6 +201,10 @@ static void set_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 		do {
 			ti.va_base = p->vabase;
 			ti.table = p->tbl;
+			if (core_is_buffer_intersect(p->vabase,
+						     CORE_MMU_PGDIR_SIZE,
+						     r->va, r->size))
+				pgt_forget_ro_maps(p);
 			set_reg_in_table(&ti, r);
 			p = SLIST_NEXT(p, link);
 		} while (p);
@@ -227,12 +220,62 @@ static void set_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 			if (!p)
 				continue;
 			ti.table = p->tbl;
+			pgt_forget_ro_maps(p);
 			set_reg_in_table(&ti, r);
 			pgt_push_to_cache_list(p);
 		}
 	}
 }
 
+/* Source of the values of struct vm_info::gen */
+static uint32_t vm_info_gen_source;
+
+/*
+ * Assigns a new generation to @vmi when the layout of its non-ephemeral
+ * regions changes. Parameters are mapped and unmapped with each
+ * invocation, they are left out to keep the generation stable.
+ */
+static void vm_info_update_gen(struct vm_info *vmi, struct vm_region *reg)
+{
+	if (!(reg->flags & VM_FLAG_EPHEMERAL))
+		vmi->gen = atomic_inc32(&vm_info_gen_source);
+}
+
+static void umap_unlink_region(struct vm_info *vmi, struct vm_region *reg)
+{
+	vm_info_update_gen(vmi, reg);
+	if (vmi->last_region == reg)
+		vmi->last_region = NULL;
+	TAILQ_REMOVE(&vmi->regions, reg, link);
+}
+
+/*
+ * Returns the region mapping @va. The same buffers tend to be looked up
+ * repeatedly, for instance when checking syscall arguments, so the region
+ * found is remembered in @vm_info->last_region. This is done for lookups
+ * through a const pointer too, the struct vm_info itself is never const.
+ */
+static struct vm_region *lookup_vm_region(const struct vm_info *vm_info,
+					  vaddr_t va)
+{
+	struct vm_info *vmi = (struct vm_info *)vm_info;
+	struct vm_region *r = vmi->last_region;
+
+	if (r && va >= r->va && va - r->va < r->size)
+		return r;
+
+	TAILQ_FOREACH(r, &vmi->regions, link) {
+		if (va < r->va)
+			break;
+		if (va - r->va < r->size) {
+			vmi->last_region = r;
+			return r;
+		}
+	}
+
+	return NULL;
+}
+
 static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 				  size_t pad_begin, size_t pad_end,
 				  size_t align)
@@ -272,6 +315,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 		if (va) {
 			reg->va = va;
 			TAILQ_INSERT_BEFORE(r, reg, link);
+			vm_info_update_gen(vmi, reg);
 			return TEE_SUCCESS;
 		}
 		prev_r = r;
@@ -285,6 +329,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (va) {
 		reg->va = va;
 		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+		vm_info_update_gen(vmi, reg);
 		return TEE_SUCCESS;
 	}
 
@@ -362,7 +407,7 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 	return TEE_SUCCESS;
 
 err_rem_reg:
-	TAILQ_REMOVE(&uctx->vm_info.regions, reg, link);
+	umap_unlink_region(&uctx->vm_info, reg);
 err_put_mobj:
 	mobj_put(reg->mobj);
 err_free_reg:
@@ -372,13 +417,7 @@ err_free_reg:
 
 static struct vm_region *find_vm_region(struct vm_info *vm_info, vaddr_t va)
 {
-	struct vm_region *r = NULL;
-
-	TAILQ_FOREACH(r, &vm_info->regions, link)
-		if (va >= r->va && va < r->va + r->size)
-			return r;
-
-	return NULL;
+	return lookup_vm_region(vm_info, va);
 }
 
 static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
@@ -409,6 +448,25 @@ static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 	}
 }
 
+/*
+ * The entries of a block tagged with TEE_MATTR_CONTIG must be changed
+ * together. When a region is split inside such a block, the block is
+ * unmapped and then mapped again without the tag, so the two halves can
+ * be changed independently afterwards.
+ */
+static void split_contig_block(struct user_mode_ctx *uctx,
+			       struct vm_region *r, struct vm_region *r2)
+{
+	vaddr_t b = MAX(ROUNDDOWN(r2->va, CORE_MMU_CONTIG_SIZE), r->va);
+	vaddr_t e = MIN(ROUNDUP(r2->va, CORE_MMU_CONTIG_SIZE),
+			r2->va + r2->size);
+
+	pgt_clear_range(uctx, b, e);
+	tlbi_va_range_asid(b, e - b, SMALL_PAGE_SIZE, uctx->vm_info.asid);
+	set_um_region(uctx, r);
+	set_um_region(uctx, r2);
+}
+
 static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 				  struct vm_region *r, vaddr_t va)
 {
@@ -440,6 +498,11 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 	r->size = diff;
 
 	TAILQ_INSERT_AFTER(&uctx->vm_info.regions, r, r2, link);
+	vm_info_update_gen(&uctx->vm_info, r2);
+
+	if (IS_ENABLED(CFG_CORE_MMU_CONTIG_HINT) && !mobj_is_paged(r->mobj) &&
+	    !IS_ALIGNED(va, CORE_MMU_CONTIG_SIZE))
+		split_contig_block(uctx, r, r2);
 
 	return TEE_SUCCESS;
 }
@@ -530,7 +593,7 @@ static void merge_vm_range(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
 		if (r->offset + r->size != r_next->offset)
 			continue;
 
-		TAILQ_REMOVE(&uctx->vm_info.regions, r_next, link);
+		umap_unlink_region(&uctx->vm_info, r_next);
 		r->size += r_next->size;
 		mobj_put(r_next->mobj);
 		free(r_next);
@@ -586,7 +649,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 			break;
 		r_next = TAILQ_NEXT(r, link);
 		rem_um_region(uctx, r);
-		TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
+		umap_unlink_region(&uctx->vm_info, r);
 		TAILQ_INSERT_TAIL(&regs, r, link);
 	}
 
@@ -640,7 +703,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 				r_stop = TAILQ_NEXT(r_last, link);
 			for (r = r_first; r != r_stop; r = r_next) {
 				r_next = TAILQ_NEXT(r, link);
-				TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
+				umap_unlink_region(&uctx->vm_info, r);
 				if (r_tmp)
 					TAILQ_INSERT_AFTER(&regs, r_tmp, r,
 							   link);
@@ -768,6 +831,17 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 		if (!mobj_is_paged(r->mobj)) {
 			need_sync = true;
+			if (IS_ENABLED(CFG_CORE_MMU_CONTIG_HINT)) {
+				/*
+				 * Entries tagged with TEE_MATTR_CONTIG
+				 * can't be updated in place, break before
+				 * make.
+				 */
+				pgt_clear_range(uctx, r->va, r->va + r->size);
+				tlbi_va_range_asid(r->va, r->size,
+						   SMALL_PAGE_SIZE,
+						   uctx->vm_info.asid);
+			}
 			set_um_region(uctx, r);
 			/*
 			 * Normally when set_um_region() is called we
@@ -805,7 +879,7 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 {
-	TAILQ_REMOVE(&vmi->regions, reg, link);
+	umap_unlink_region(vmi, reg);
 	mobj_put(reg->mobj);
 	free(reg);
 }
@@ -889,6 +963,7 @@ TEE_Result vm_info_init(struct user_mode_ctx *uctx, struct ts_ctx *ts_ctx)
 	TAILQ_INIT(&uctx->vm_info.regions);
 	SLIST_INIT(&uctx->pgt_cache);
 	uctx->vm_info.asid = asid;
+	uctx->vm_info.gen = atomic_inc32(&vm_info_gen_source);
 	uctx->ts_ctx = ts_ctx;
 
 	res = map_kinit(uctx);
@@ -897,25 +972,70 @@ TEE_Result vm_info_init(struct user_mode_ctx *uctx, struct ts_ctx *ts_ctx)
 	return res;
 }
 
-void vm_clean_param(struct user_mode_ctx *uctx)
+static void clean_param(struct user_mode_ctx *uctx, bool keep_reg_shm)
 {
 	struct vm_region *next_r;
 	struct vm_region *r;
 
 	TAILQ_FOREACH_SAFE(r, &uctx->vm_info.regions, link, next_r) {
-		if (r->flags & VM_FLAG_EPHEMERAL) {
-			rem_um_region(uctx, r);
-			umap_remove_region(&uctx->vm_info, r);
-		}
+		if (!(r->flags & VM_FLAG_EPHEMERAL))
+			continue;
+		if (keep_reg_shm && mobj_is_registered_shm(r->mobj))
+			continue;
+		rem_um_region(uctx, r);
+		umap_remove_region(&uctx->vm_info, r);
 	}
 }
 
-static void check_param_map_empty(struct user_mode_ctx *uctx __maybe_unused)
+void vm_clean_param(struct user_mode_ctx *uctx)
+{
+	clean_param(uctx, IS_ENABLED(CFG_TA_PARAM_MAP_CACHE));
+}
+
+void vm_flush_param(struct user_mode_ctx *uctx)
+{
+	clean_param(uctx, false);
+}
+
+/*
+ * Drop from @mem the entries covered by a mapping kept from a previous
+ * call and remove the mappings not used by this call, the TA must only
+ * reach the memory of the current parameters. Returns the number of
+ * entries left to map.
+ */
+static size_t reuse_param_mappings(struct user_mode_ctx *uctx,
+				   struct param_mem *mem, size_t count)
 {
+	struct vm_region *next_r = NULL;
 	struct vm_region *r = NULL;
+	bool used = false;
+	size_t n = 0;
+
+	TAILQ_FOREACH_SAFE(r, &uctx->vm_info.regions, link, next_r) {
+		if (!(r->flags & VM_FLAG_EPHEMERAL))
+			continue;
+
+		used = false;
+		n = 0;
+		while (n < count) {
+			if (mem[n].mobj == r->mobj &&
+			    mem[n].offs >= r->offset &&
+			    mem[n].offs + mem[n].size <= r->offset + r->size) {
+				used = true;
+				count--;
+				mem[n] = mem[count];
+				continue;
+			}
+			n++;
+		}
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link)
-		assert(!(r->flags & VM_FLAG_EPHEMERAL));
+		if (!used) {
+			rem_um_region(uctx, r);
+			umap_remove_region(&uctx->vm_info, r);
+		}
+	}
+
+	return count;
 }
 
 static TEE_Result param_mem_to_user_va(struct user_mode_ctx *uctx,
@@ -1038,7 +1158,7 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 	if (mem[0].mobj)
 		m++;
 
-	check_param_map_empty(uctx);
+	m = reuse_param_mappings(uctx, mem, m);
 
 	for (n = 0; n < m; n++) {
 		vaddr_t va = 0;
@@ -1070,7 +1190,7 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 	res = alloc_pgt(uctx);
 out:
 	if (res)
-		vm_clean_param(uctx);
+		vm_flush_param(uctx);
 
 	return res;
 }
@@ -1083,9 +1203,6 @@ void vm_info_final(struct user_mode_ctx *uctx)
 	pgt_flush(uctx);
 	tee_pager_rem_um_regions(uctx);
 
-	/* clear MMU entries to avoid clash when asid is reused */
-	tlbi_asid(uctx->vm_info.asid);
-
 	asid_free(uctx->vm_info.asid);
 	uctx->vm_info.asid = 0;
 
@@ -1098,14 +1215,12 @@ void vm_info_final(struct user_mode_ctx *uctx)
 bool vm_buf_is_inside_um_private(const struct user_mode_ctx *uctx,
 				 const void *va, size_t size)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = lookup_vm_region(&uctx->vm_info, (vaddr_t)va);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (r->flags & VM_FLAGS_NONPRIV)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
-			return true;
-	}
+	/* Regions don't overlap so only the region mapping va can match */
+	if (r && !(r->flags & VM_FLAGS_NONPRIV) &&
+	    core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
+		return true;
 
 	return false;
 }
@@ -1152,47 +1267,42 @@ TEE_Result vm_buf_to_mboj_offs(const struct user_mode_ctx *uctx,
 static TEE_Result tee_mmu_user_va2pa_attr(const struct user_mode_ctx *uctx,
 					  void *ua, paddr_t *pa, uint32_t *attr)
 {
-	struct vm_region *region = NULL;
-
-	TAILQ_FOREACH(region, &uctx->vm_info.regions, link) {
-		if (!core_is_buffer_inside((vaddr_t)ua, 1, region->va,
-					   region->size))
-			continue;
+	struct vm_region *region = lookup_vm_region(&uctx->vm_info,
+						    (vaddr_t)ua);
 
-		if (pa) {
-			TEE_Result res;
-			paddr_t p;
-			size_t offset;
-			size_t granule;
+	if (!region)
+		return TEE_ERROR_ACCESS_DENIED;
 
-			/*
-			 * mobj and input user address may each include
-			 * a specific offset-in-granule position.
-			 * Drop both to get target physical page base
-			 * address then apply only user address
-			 * offset-in-granule.
-			 * Mapping lowest granule is the small page.
-			 */
-			granule = MAX(region->mobj->phys_granule,
-				      (size_t)SMALL_PAGE_SIZE);
-			assert(!granule || IS_POWER_OF_TWO(granule));
+	if (pa) {
+		TEE_Result res;
+		paddr_t p;
+		size_t offset;
+		size_t granule;
 
-			offset = region->offset +
-				 ROUNDDOWN2((vaddr_t)ua - region->va, granule);
+		/*
+		 * mobj and input user address may each include a specific
+		 * offset-in-granule position. Drop both to get target
+		 * physical page base address then apply only user address
+		 * offset-in-granule. Mapping lowest granule is the small
+		 * page.
+		 */
+		granule = MAX(region->mobj->phys_granule,
+			      (size_t)SMALL_PAGE_SIZE);
+		assert(!granule || IS_POWER_OF_TWO(granule));
 
-			res = mobj_get_pa(region->mobj, offset, granule, &p);
-			if (res != TEE_SUCCESS)
-				return res;
+		offset = region->offset +
+			 ROUNDDOWN2((vaddr_t)ua - region->va, granule);
 
-			*pa = p | ((vaddr_t)ua & (granule - 1));
-		}
-		if (attr)
-			*attr = region->attr;
+		res = mobj_get_pa(region->mobj, offset, granule, &p);
+		if (res != TEE_SUCCESS)
+			return res;
 
-		return TEE_SUCCESS;
+		*pa = p | ((vaddr_t)ua & (granule - 1));
 	}
+	if (attr)
+		*attr = region->attr;
 
-	return TEE_ERROR_ACCESS_DENIED;
+	return TEE_SUCCESS;
 }
 
 TEE_Result vm_va2pa(const struct user_mode_ctx *uctx, void *ua, paddr_t *pa)
@@ -30,6 +30,25 @@ static struct rsa_keypair *key;
 
 static const uint8_t key_file_name[] = "key";
 
+/* Number of TA memory digests remembered by cmd_hash_ta_memory() */
+#define TA_HASH_CACHE_SIZE	8
+
+struct ta_hash_cache_entry {
+	struct user_mode_ctx *uctx;
+	uint32_t gen;
+	uint8_t hash[TEE_SHA256_HASH_SIZE];
+};
+
+/*
+ * Measurements are cached, the evidence is signed for each request since
+ * the signature covers the nonce. This pseudo TA doesn't have
+ * TA_FLAG_CONCURRENT, accesses are serialized.
+ */
+static struct ta_hash_cache_entry ta_hash_cache[TA_HASH_CACHE_SIZE];
+static unsigned int ta_hash_cache_next;
+static uint8_t tee_hash[TEE_SHA256_HASH_SIZE];
+static bool tee_hash_valid;
+
 static TEE_Result allocate_key(void)
 {
 	assert(!key);
@@ -580,6 +599,40 @@ out:
 	return res;
 }
 
+/*
+ * Only read-only regions are hashed so the digest of a TA memory stays
+ * valid as long as the set of regions is unchanged, that is as long as
+ * struct vm_info::gen is unchanged. Generations are never reused so an
+ * entry can't match a context created later at the same address.
+ */
+static bool ta_hash_cache_lookup(struct user_mode_ctx *uctx, uint8_t *hash)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(ta_hash_cache); n++) {
+		if (ta_hash_cache[n].uctx == uctx &&
+		    ta_hash_cache[n].gen == uctx->vm_info.gen) {
+			memcpy(hash, ta_hash_cache[n].hash,
+			       TEE_SHA256_HASH_SIZE);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void ta_hash_cache_add(struct user_mode_ctx *uctx,
+			      const uint8_t *hash)
+{
+	struct ta_hash_cache_entry *e = ta_hash_cache + ta_hash_cache_next;
+
+	e->uctx = uctx;
+	e->gen = uctx->vm_info.gen;
+	memcpy(e->hash, hash, TEE_SHA256_HASH_SIZE);
+	ta_hash_cache_next = (ta_hash_cache_next + 1) %
+			     ARRAY_SIZE(ta_hash_cache);
+}
+
 static TEE_Result cmd_get_ta_shdr_digest(uint32_t param_types,
 					 TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -665,48 +718,23 @@ static TEE_Result cmd_hash_ta_memory(uint32_t param_types,
 		return TEE_ERROR_SHORT_BUFFER;
 	out_sz = min_out_sz;
 
-	s = ts_pop_current_session();
-	res = hash_regions(&uctx->vm_info, out);
-	ts_push_current_session(s);
-	if (res)
-		return res;
+	if (!ta_hash_cache_lookup(uctx, out)) {
+		s = ts_pop_current_session();
+		res = hash_regions(&uctx->vm_info, out);
+		ts_push_current_session(s);
+		if (res)
+			return res;
+		ta_hash_cache_add(uctx, out);
+	}
 
 	return sign_buffer(out, out_sz, nonce, nonce_sz);
 }
 
-static TEE_Result cmd_hash_tee_memory(uint32_t param_types,
-				      TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result hash_tee_memory(uint8_t *hash)
 {
-	uint8_t *nonce = params[0].memref.buffer;
-	size_t nonce_sz = params[0].memref.size;
-	uint8_t *out = params[1].memref.buffer;
-	size_t out_sz = params[1].memref.size;
 	TEE_Result res = TEE_SUCCESS;
-	size_t min_out_sz = 0;
 	void *ctx = NULL;
 
-	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
-					   TEE_PARAM_TYPE_MEMREF_OUTPUT,
-					   TEE_PARAM_TYPE_NONE,
-					   TEE_PARAM_TYPE_NONE))
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	if (!nonce || !nonce_sz)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	if (!out && out_sz)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	res = init_key();
-	if (res)
-		return res;
-
-	min_out_sz = TEE_SHA256_HASH_SIZE + crypto_bignum_num_bytes(key->n);
-	params[1].memref.size = min_out_sz;
-	if (out_sz < min_out_sz)
-		return TEE_ERROR_SHORT_BUFFER;
-	out_sz = min_out_sz;
-
 	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
 	if (res)
 		return res;
@@ -748,18 +776,57 @@ static TEE_Result cmd_hash_tee_memory(uint32_t param_types,
 		if (res)
 			goto out;
 	}
-	res = crypto_hash_final(ctx, out, TEE_SHA256_HASH_SIZE);
-	if (res)
-		goto out;
-
-	DHEXDUMP(out, TEE_SHA256_HASH_SIZE);
-
-	res = sign_buffer(out, out_sz, nonce, nonce_sz);
+	res = crypto_hash_final(ctx, hash, TEE_SHA256_HASH_SIZE);
 out:
 	crypto_hash_free_ctx(ctx);
 	return res;
 }
 
+static TEE_Result cmd_hash_tee_memory(uint32_t param_types,
+				      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint8_t *nonce = params[0].memref.buffer;
+	size_t nonce_sz = params[0].memref.size;
+	uint8_t *out = params[1].memref.buffer;
+	size_t out_sz = params[1].memref.size;
+	TEE_Result res = TEE_SUCCESS;
+	size_t min_out_sz = 0;
+
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					   TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!nonce || !nonce_sz)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!out && out_sz)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = init_key();
+	if (res)
+		return res;
+
+	min_out_sz = TEE_SHA256_HASH_SIZE + crypto_bignum_num_bytes(key->n);
+	params[1].memref.size = min_out_sz;
+	if (out_sz < min_out_sz)
+		return TEE_ERROR_SHORT_BUFFER;
+	out_sz = min_out_sz;
+
+	/* The hashed sections are read-only, they're hashed only once */
+	if (!tee_hash_valid) {
+		res = hash_tee_memory(tee_hash);
+		if (res)
+			return res;
+		tee_hash_valid = true;
+		DHEXDUMP(tee_hash, TEE_SHA256_HASH_SIZE);
+	}
+	memcpy(out, tee_hash, TEE_SHA256_HASH_SIZE);
+
+	return sign_buffer(out, out_sz, nonce, nonce_sz);
+}
+
 static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 				 uint32_t param_types,
 				 TEE_Param params[TEE_NUM_PARAMS])
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/pc_sample.h>
+#include <kernel/pseudo_ta.h>
+#include <kernel/ts_manager.h>
+#include <pta_core_prof.h>
+#include <tee_api_types.h>
+
+#define PTA_NAME "core_prof.pta"
+
+static TEE_Result start(uint32_t param_types,
+			TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return core_pc_sample_start(params[0].value.a);
+}
+
+static TEE_Result stop(uint32_t param_types,
+		       TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	core_pc_sample_stop();
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_hist(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						TEE_PARAM_TYPE_VALUE_OUTPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int shift = 0;
+	uint32_t count = 0;
+	size_t len = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	len = params[0].memref.size;
+	if (!params[0].memref.buffer)
+		len = 0;
+
+	res = core_pc_sample_read(params[0].memref.buffer, &len, &shift,
+				  &count);
+	params[0].memref.size = len;
+	if (res)
+		return res;
+
+	params[1].value.a = shift;
+	params[1].value.b = count;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx __unused)
+{
+	/* Only the normal world may profile the core */
+	if (ts_get_calling_session())
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd_id) {
+	case PTA_CORE_PROF_CMD_START:
+		return start(param_types, params);
+	case PTA_CORE_PROF_CMD_STOP:
+		return stop(param_types, params);
+	case PTA_CORE_PROF_CMD_READ:
+		return read_hist(param_types, params);
+	default:
+		break;
+	}
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_CORE_PROF_UUID, .name = PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .open_session_entry_point = open_session,
+		   .invoke_command_entry_point = invoke_command);
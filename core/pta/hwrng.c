@@ -10,15 +10,86 @@
 #include <assert.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <kernel/callout.h>
+#include <kernel/delay.h>
+#include <kernel/mutex.h>
+#include <kernel/notif.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/spinlock.h>
+#include <kernel/ts_manager.h>
+#include <kernel/virtualization.h>
+#include <kernel/workqueue.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
 #include <pta_rng.h>
 #include <rng_support.h>
 
 #define PTA_NAME "rng.pta"
 
+/* Requests served by PTA_CMD_GET_ENTROPY_BULK are generated by chunks */
+#define RNG_BULK_CHUNK_SIZE	(16 * 1024)
+/* Smaller requests are not accounted, they may be served from a cache */
+#define RNG_RATE_MIN_LEN	1024
+/* Accounting is halved once this many bytes are recorded */
+#define RNG_RATE_MAX_BYTES	(1ULL << 32)
+
+/*
+ * Measured throughput of crypto_rng_read(), @bytes generated in @cnt
+ * ticks of the delay counter
+ */
+static struct {
+	uint64_t bytes;
+	uint64_t cnt;
+	unsigned int lock;
+} rng_rate = { .lock = SPINLOCK_UNLOCK };
+
 /* This PTA only works with hardware random number generators */
 static_assert(!IS_ENABLED(CFG_WITH_SOFTWARE_PRNG));
 
+static void rate_record(size_t len, uint64_t cnt)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&rng_rate.lock);
+
+	rng_rate.bytes += len;
+	rng_rate.cnt += cnt;
+	/* Keep the product with the counter frequency within 64 bits */
+	if (rng_rate.bytes >= RNG_RATE_MAX_BYTES) {
+		rng_rate.bytes /= 2;
+		rng_rate.cnt /= 2;
+	}
+
+	cpu_spin_unlock_xrestore(&rng_rate.lock, exceptions);
+}
+
+static uint32_t rate_get(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&rng_rate.lock);
+	uint64_t rate = CFG_HWRNG_RATE;
+
+	if (rng_rate.cnt)
+		rate = rng_rate.bytes * delay_cnt_freq() / rng_rate.cnt;
+
+	cpu_spin_unlock_xrestore(&rng_rate.lock, exceptions);
+
+	return MIN(rate, (uint64_t)UINT32_MAX);
+}
+
+static TEE_Result rng_read(void *buf, size_t len)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint64_t start = 0;
+
+	if (!IS_ENABLED(CFG_HWRNG_RATE_MEASURED) || len < RNG_RATE_MIN_LEN)
+		return crypto_rng_read(buf, len);
+
+	start = delay_cnt_read();
+	res = crypto_rng_read(buf, len);
+	if (!res)
+		rate_record(len, delay_cnt_read() - start);
+
+	return res;
+}
+
 static TEE_Result rng_get_entropy(uint32_t types,
 				  TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -36,7 +107,53 @@ static TEE_Result rng_get_entropy(uint32_t types,
 	if (!e)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	return crypto_rng_read(e, params[0].memref.size);
+	return rng_read(e, params[0].memref.size);
+}
+
+static TEE_Result rng_get_entropy_bulk(uint32_t types,
+				       TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t tref = 0;
+	uint8_t *e = NULL;
+	size_t size = 0;
+	size_t offs = 0;
+	size_t n = 0;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE)) {
+		DMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	e = (uint8_t *)params[0].memref.buffer;
+	size = params[0].memref.size;
+	if (!e || !size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/*
+	 * Fill as much of the buffer as possible within the time budget,
+	 * at least one chunk is always generated.
+	 */
+	tref = timeout_init_us(CFG_HWRNG_BULK_BUDGET_US);
+	do {
+		n = MIN(size - offs, (size_t)RNG_BULK_CHUNK_SIZE);
+		res = rng_read(e + offs, n);
+		if (res)
+			break;
+		offs += n;
+	} while (offs < size && !timeout_elapsed(tref));
+
+	/* Report what was produced before an eventual failure */
+	params[1].value.a = offs;
+	params[1].value.b = 0;
+
+	if (res && offs)
+		return TEE_SUCCESS;
+
+	return res;
 }
 
 static TEE_Result rng_get_info(uint32_t types,
@@ -50,12 +167,131 @@ static TEE_Result rng_get_info(uint32_t types,
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
-	params[0].value.a = CFG_HWRNG_RATE;
+	params[0].value.a = rate_get();
 	params[0].value.b = CFG_HWRNG_QUALITY;
 
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_HWRNG_PUSH
+/*
+ * Buffer registered by the normal world with PTA_CMD_SET_PUSH_SHM. The
+ * callout checks if it has been consumed and queues the refill, which
+ * can't be done in interrupt context.
+ */
+static struct {
+	struct pta_rng_push_hdr *hdr;
+	uint8_t *data;
+	size_t size;
+	uint32_t value;
+	uint16_t guest_id;
+	struct callout callout;
+	struct work work;
+} rng_push;
+
+/* Serializes the registrations */
+static struct mutex rng_push_mu = MUTEX_INITIALIZER;
+
+static void push_fill(struct work *w __unused)
+{
+	struct pta_rng_push_hdr *hdr = rng_push.hdr;
+
+	if (__atomic_load_n(&hdr->state, __ATOMIC_ACQUIRE) !=
+	    PTA_RNG_PUSH_EMPTY)
+		return;
+
+	/* Tried again on the next period */
+	if (rng_read(rng_push.data, rng_push.size))
+		return;
+
+	__atomic_store_n(&hdr->state, PTA_RNG_PUSH_FULL, __ATOMIC_RELEASE);
+	notif_send_async(rng_push.value, rng_push.guest_id);
+}
+
+static bool push_cb(struct callout *co __unused)
+{
+	if (__atomic_load_n(&rng_push.hdr->state, __ATOMIC_RELAXED) ==
+	    PTA_RNG_PUSH_EMPTY)
+		work_queue(&rng_push.work, push_fill);
+
+	return true;
+}
+
+static TEE_Result rng_set_push_shm(uint32_t types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint16_t guest_id = virt_get_current_guest_id();
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t value = 0;
+	uint64_t pa = 0;
+	size_t len = 0;
+	void *va = NULL;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE)) {
+		DMSG("bad parameters types: 0x%" PRIx32, types);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	/* Only the normal world driver may register a buffer */
+	if (ts_get_calling_session())
+		return TEE_ERROR_ACCESS_DENIED;
+	if (!notif_async_is_started(guest_id))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	pa = reg_pair_to_64(params[0].value.a, params[0].value.b);
+	len = params[1].value.a;
+	if (pa != (paddr_t)pa || len <= sizeof(*rng_push.hdr) ||
+	    !IS_ALIGNED(pa, sizeof(uint32_t)) ||
+	    !core_pbuf_is(CORE_MEM_NON_SEC, pa, len))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&rng_push_mu);
+
+	if (rng_push.hdr) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+
+	res = notif_alloc_async_value(&value);
+	if (res)
+		goto out;
+
+	va = core_mmu_add_mapping(MEM_AREA_NEX_NSEC_SHM, pa, len);
+	if (!va) {
+		notif_free_async_value(value);
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	rng_push.hdr = va;
+	rng_push.data = (uint8_t *)(rng_push.hdr + 1);
+	rng_push.size = len - sizeof(*rng_push.hdr);
+	rng_push.value = value;
+	rng_push.guest_id = guest_id;
+	rng_push.hdr->size = rng_push.size;
+	__atomic_store_n(&rng_push.hdr->state, PTA_RNG_PUSH_EMPTY,
+			 __ATOMIC_RELEASE);
+
+	callout_add(&rng_push.callout, push_cb, CFG_HWRNG_PUSH_MS);
+
+	params[2].value.a = value;
+	params[2].value.b = 0;
+out:
+	mutex_unlock(&rng_push_mu);
+
+	return res;
+}
+#else
+static TEE_Result rng_set_push_shm(uint32_t types __unused,
+				   TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif /*CFG_HWRNG_PUSH*/
+
 static TEE_Result invoke_command(void *session __unused,
 				 uint32_t cmd, uint32_t ptypes,
 				 TEE_Param params[TEE_NUM_PARAMS])
@@ -67,6 +303,10 @@ static TEE_Result invoke_command(void *session __unused,
 		return rng_get_entropy(ptypes, params);
 	case PTA_CMD_GET_RNG_INFO:
 		return rng_get_info(ptypes, params);
+	case PTA_CMD_GET_ENTROPY_BULK:
+		return rng_get_entropy_bulk(ptypes, params);
+	case PTA_CMD_SET_PUSH_SHM:
+		return rng_set_push_shm(ptypes, params);
 	default:
 		break;
 	}
@@ -3,11 +3,21 @@
  * Copyright (c) 2015, Linaro Limited
  */
 #include <compiler.h>
+#include <config.h>
+#include <crypto/crypto.h>
+#include <crypto/rng_stats.h>
 #include <drivers/clk.h>
 #include <drivers/regulator.h>
+#include <initcall.h>
+#include <kernel/delay.h>
+#include <kernel/lock_stats.h>
+#include <kernel/perf_stats.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
+#include <kernel/user_ta.h>
 #include <malloc.h>
+#include <mm/mobj.h>
 #include <mm/phys_mem.h>
 #include <mm/tee_mm.h>
 #include <mm/tee_pager.h>
@@ -15,6 +25,7 @@
 #include <string.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
+#include <tee/tee_cryp_ctx_pool.h>
 #include <tee/tee_fs.h>
 #include <trace.h>
 
@@ -99,6 +110,15 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 				strlcpy(stats->desc, "RPMB secure storage",
 					sizeof(stats->desc));
 			break;
+		case ALLOC_ID_HEAP_CACHE:
+			malloc_get_cache_stats(stats);
+			if (IS_ENABLED(CFG_CORE_HEAP_MAGAZINE))
+				strlcpy(stats->desc, "Heap cache",
+					sizeof(stats->desc));
+			else
+				strlcpy(stats->desc, "Heap cache (disabled)",
+					sizeof(stats->desc));
+			break;
 		default:
 			EMSG("Wrong pool id");
 			break;
@@ -113,12 +133,16 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct tee_pager_stats stats = { };
+	uint32_t t = type & ~TEE_PARAM_TYPE_SET(0xf, 3);
 
+	/* The 4th value with the read-ahead statistics is optional */
 	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_NONE) != type) {
-		EMSG("expect 3 output values as argument");
+			    TEE_PARAM_TYPE_NONE) != t ||
+	    (TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_NONE &&
+	     TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_VALUE_OUTPUT)) {
+		EMSG("expect 3 or 4 output values as argument");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
@@ -129,6 +153,28 @@ static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	p[1].value.b = stats.rw_hits;
 	p[2].value.a = stats.hidden_hits;
 	p[2].value.b = stats.zi_released;
+	if (TEE_PARAM_TYPE_GET(type, 3) == TEE_PARAM_TYPE_VALUE_OUTPUT) {
+		p[3].value.a = stats.read_ahead_pages;
+		p[3].value.b = stats.read_ahead_hits;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pager_evict_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pager_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	tee_pager_get_stats(&stats);
+	p[0].value.a = stats.evictions;
+	p[0].value.b = stats.refaults;
 
 	return TEE_SUCCESS;
 }
@@ -168,6 +214,87 @@ static TEE_Result get_user_ta_stats(uint32_t type,
 	return res;
 }
 
+static TEE_Result get_ta_resource_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS] __maybe_unused)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t since __maybe_unused = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+#if defined(CFG_TA_RESOURCE_STATS)
+	since = reg_pair_to_64(p[0].value.a, p[0].value.b);
+	res = tee_ta_resource_stats(p[1].memref.buffer, &p[1].memref.size,
+				    &since);
+	if (res == TEE_SUCCESS)
+		reg_pair_from_64(since, &p[0].value.a, &p[0].value.b);
+	else
+		DMSG("tee_ta_resource_stats return: 0x%"PRIx32, res);
+#else
+	res = TEE_ERROR_NOT_SUPPORTED;
+#endif
+	return res;
+}
+
+static TEE_Result get_syscall_latency(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS] __maybe_unused)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+#if defined(CFG_TA_RESOURCE_STATS)
+	res = user_ta_syscall_latency_stats(p[0].memref.buffer,
+					    &p[0].memref.size);
+	if (res != TEE_SUCCESS)
+		DMSG("user_ta_syscall_latency_stats return: 0x%"PRIx32, res);
+#else
+	res = TEE_ERROR_NOT_SUPPORTED;
+#endif
+	return res;
+}
+
+static TEE_Result get_malloc_sampling(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS] __maybe_unused)
+{
+	bool clear __maybe_unused = false;
+	size_t count __maybe_unused = 0;
+	size_t n __maybe_unused = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+#if defined(CFG_CORE_MALLOC_SAMPLING)
+	if (p[0].value.a != STATS_MALLOC_KEEP_PERIOD)
+		malloc_sampling_set_period(p[0].value.a);
+	clear = p[0].value.b;
+
+	n = p[1].memref.size / sizeof(struct pta_stats_malloc_site);
+	count = malloc_sampling_get_sites(p[1].memref.buffer, n,
+					  &p[0].value.b);
+	p[1].memref.size = count * sizeof(struct pta_stats_malloc_site);
+	p[0].value.a = malloc_sampling_get_period();
+	if (count > n)
+		return TEE_ERROR_SHORT_BUFFER;
+	if (clear)
+		malloc_sampling_clear();
+	return TEE_SUCCESS;
+#else
+	return TEE_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 static TEE_Result get_system_time(uint32_t type,
 				  TEE_Param p[TEE_NUM_PARAMS])
 {
@@ -219,10 +346,280 @@ static TEE_Result print_driver_info(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_SUCCESS;
 }
 
+static TEE_Result get_rng_event_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	uint64_t consumed = 0;
+	uint64_t dropped = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	crypto_rng_get_event_stats(&consumed, &dropped);
+
+	reg_pair_from_64(consumed, &p[0].value.a, &p[0].value.b);
+	reg_pair_from_64(dropped, &p[1].value.a, &p[1].value.b);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_rng_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pta_stats_rng *out = NULL;
+	struct rng_stats st = { };
+	uint64_t good_calls = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_RNG_STATS))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (p[0].memref.size < sizeof(*out)) {
+		p[0].memref.size = sizeof(*out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = sizeof(*out);
+	out = p[0].memref.buffer;
+	memset(out, 0, sizeof(*out));
+
+	rng_stats_get(&st);
+	good_calls = st.calls - st.failures;
+
+	out->calls = st.calls;
+	out->bytes = st.bytes;
+	out->failures = st.failures;
+	if (good_calls)
+		out->avg_latency_us = st.total_latency_us / good_calls;
+	out->max_latency_us = st.max_latency_us;
+	out->reseeds = st.reseeds;
+	out->health_failures = st.health_failures;
+	out->busy_wait_us = st.busy_wait_us;
+	out->seed_bytes = st.seed_bytes;
+	out->seed_requests = st.seed_requests;
+	crypto_rng_get_event_stats(&out->events_consumed,
+				   &out->events_dropped);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_rng_ta_stats(uint32_t type,
+				   TEE_Param p[TEE_NUM_PARAMS] __maybe_unused)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+#if defined(CFG_TA_RNG_QOS)
+	res = tee_ta_rng_stats(p[0].memref.buffer, &p[0].memref.size);
+	if (res != TEE_SUCCESS)
+		DMSG("tee_ta_rng_stats return: 0x%"PRIx32, res);
+#else
+	res = TEE_ERROR_NOT_SUPPORTED;
+#endif
+	return res;
+}
+
+static TEE_Result get_cryp_pool_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CRYPTO_CTX_POOL))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	tee_cryp_ctx_pool_get_stats(&hits, &misses);
+
+	reg_pair_from_64(hits, &p[0].value.a, &p[0].value.b);
+	reg_pair_from_64(misses, &p[1].value.a, &p[1].value.b);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_thread_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	unsigned int limit_hits = 0;
+	unsigned int stacks = 0;
+	unsigned int quota = 0;
+	unsigned int peak = 0;
+
+	/* value[2] was added later and is optional */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type &&
+	    TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	thread_get_pool_stats(&limit_hits, &stacks, &quota, &peak);
+
+	p[0].value.a = limit_hits;
+	p[0].value.b = stacks;
+	p[1].value.a = CFG_NUM_THREADS_STATIC;
+	p[1].value.b = CFG_NUM_THREADS;
+	if (TEE_PARAM_TYPE_GET(type, 2) == TEE_PARAM_TYPE_VALUE_OUTPUT) {
+		p[2].value.a = quota;
+		p[2].value.b = peak;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_lock_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = lock_stats_get(p[0].memref.buffer, &p[0].memref.size);
+	if (res != TEE_SUCCESS)
+		DMSG("lock_stats_get return: 0x%"PRIx32, res);
+
+	return res;
+}
+
+static TEE_Result get_perf_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = perf_stats_get(p[0].memref.buffer, &p[0].memref.size);
+	if (res != TEE_SUCCESS)
+		DMSG("perf_stats_get return: 0x%"PRIx32, res);
+
+	return res;
+}
+
+static TEE_Result get_initcall_stats(uint32_t type,
+				     TEE_Param p[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = initcall_stats_get(p[0].memref.buffer, &p[0].memref.size);
+	if (res != TEE_SUCCESS)
+		DMSG("initcall_stats_get return: 0x%"PRIx32, res);
+
+	return res;
+}
+
+static TEE_Result get_thread_time_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pta_stats_thread_time *thr = NULL;
+	struct pta_stats_core_time *core = NULL;
+	size_t thr_size = CFG_NUM_THREADS * sizeof(*thr);
+	size_t core_size = CFG_TEE_CORE_NB_CORE * sizeof(*core);
+	size_t n __maybe_unused = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_THREAD_TIME_STATS))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	thr = p[0].memref.buffer;
+	core = p[1].memref.buffer;
+	if (!thr || p[0].memref.size < thr_size ||
+	    !core || p[1].memref.size < core_size) {
+		p[0].memref.size = thr_size;
+		p[1].memref.size = core_size;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (!IS_ALIGNED_WITH_TYPE(thr, uint64_t) ||
+	    !IS_ALIGNED_WITH_TYPE(core, uint64_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+#ifdef CFG_CORE_THREAD_TIME_STATS
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		struct thread_time_stats s = { };
+
+		thread_get_time_stats(n, &s);
+		thr[n] = (struct pta_stats_thread_time){
+			.run_ticks = s.run_ticks,
+			.suspended_ticks = s.suspended_ticks,
+			.wait_ticks = s.wait_ticks,
+			.resumes = s.resumes,
+		};
+	}
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+		thread_get_core_time_stats(n, &core[n].run_ticks,
+					   &core[n].entries);
+
+	p[2].value.a = delay_cnt_freq();
+#endif
+
+	p[0].memref.size = thr_size;
+	p[1].memref.size = core_size;
+
+	return TEE_SUCCESS;
+}
+
 /*
  * Trusted Application Entry Points
  */
 
+static TEE_Result get_reg_shm_stats(uint32_t type,
+				    TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t max_count = 0;
+	size_t count = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_DYN_SHM) || IS_ENABLED(CFG_CORE_FFA))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	mobj_reg_shm_get_stats(&count, &max_count);
+
+	p[0].value.a = count;
+	p[0].value.b = max_count;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result invoke_command(void *psess __unused,
 				 uint32_t cmd, uint32_t ptypes,
 				 TEE_Param params[TEE_NUM_PARAMS])
@@ -240,6 +637,34 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_system_time(ptypes, params);
 	case STATS_CMD_PRINT_DRIVER_INFO:
 		return print_driver_info(ptypes, params);
+	case STATS_CMD_RNG_EVENT_STATS:
+		return get_rng_event_stats(ptypes, params);
+	case STATS_CMD_RNG_STATS:
+		return get_rng_stats(ptypes, params);
+	case STATS_CMD_RNG_TA_STATS:
+		return get_rng_ta_stats(ptypes, params);
+	case STATS_CMD_CRYP_POOL_STATS:
+		return get_cryp_pool_stats(ptypes, params);
+	case STATS_CMD_THREAD_STATS:
+		return get_thread_stats(ptypes, params);
+	case STATS_CMD_LOCK_STATS:
+		return get_lock_stats(ptypes, params);
+	case STATS_CMD_THREAD_TIME_STATS:
+		return get_thread_time_stats(ptypes, params);
+	case STATS_CMD_PAGER_EVICT_STATS:
+		return get_pager_evict_stats(ptypes, params);
+	case STATS_CMD_REG_SHM_STATS:
+		return get_reg_shm_stats(ptypes, params);
+	case STATS_CMD_PERF_STATS:
+		return get_perf_stats(ptypes, params);
+	case STATS_CMD_INITCALL_STATS:
+		return get_initcall_stats(ptypes, params);
+	case STATS_CMD_TA_RESOURCE_STATS:
+		return get_ta_resource_stats(ptypes, params);
+	case STATS_CMD_MALLOC_SAMPLING:
+		return get_malloc_sampling(ptypes, params);
+	case STATS_CMD_SYSCALL_LATENCY:
+		return get_syscall_latency(ptypes, params);
 	default:
 		break;
 	}
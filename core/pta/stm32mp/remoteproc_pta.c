@@ -5,6 +5,7 @@
 
 #include <crypto/crypto.h>
 #include <drivers/clk.h>
+#include <drivers/dma.h>
 #include <drivers/rstctrl.h>
 #include <drivers/stm32_remoteproc.h>
 #include <drivers/stm32mp_dt_bindings.h>
@@ -12,13 +13,18 @@
 #include <initcall.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/user_ta.h>
+#include <mm/core_mmu.h>
 #include <remoteproc_pta.h>
 #include <string.h>
+#include <string_ext.h>
 
 #include "rproc_pub_key.h"
 
 #define PTA_NAME	"remoteproc.pta"
 
+/* Segments are copied and hashed by chunks of this size */
+#define RPROC_LOAD_CHUNK_SIZE	SMALL_PAGE_SIZE
+
 /*
  * UUID of the remoteproc Trusted application authorized to communicate with
  * the remoteproc pseudo TA. The UID should match the one defined in the
@@ -68,6 +74,43 @@ static TEE_Result rproc_pta_capabilities(uint32_t pt,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Copy the segment to the remote processor memory and verify it, chunk by
+ * chunk so that each chunk is hashed right after its copy, while still in
+ * the cache when the copy isn't done by a DMA channel. What is
+ * hashed is the copy, the source is non-secure memory which could be
+ * modified in between.
+ */
+static TEE_Result copy_and_hash(uint8_t *dst, const uint8_t *src,
+				size_t size, const uint8_t *hash)
+{
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctx = NULL;
+	size_t len = 0;
+	size_t n = 0;
+
+	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+
+	res = crypto_hash_init(ctx);
+	for (n = 0; !res && n < size; n += len) {
+		len = MIN(size - n, (size_t)RPROC_LOAD_CHUNK_SIZE);
+		res = dma_memcpy(dst + n, src + n, len);
+		if (!res)
+			res = crypto_hash_update(ctx, dst + n, len);
+	}
+	if (!res)
+		res = crypto_hash_final(ctx, digest, sizeof(digest));
+	if (!res && consttime_memcmp(digest, hash, sizeof(digest)))
+		res = TEE_ERROR_SECURITY;
+
+	crypto_hash_free_ctx(ctx);
+
+	return res;
+}
+
 static TEE_Result rproc_pta_load_segment(uint32_t pt,
 					 TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -103,11 +146,7 @@ static TEE_Result rproc_pta_load_segment(uint32_t pt,
 		return TEE_ERROR_GENERIC;
 	}
 
-	/* Copy the segment to the remote processor memory */
-	memcpy(dst, src, size);
-
-	/* Verify that loaded segment is valid */
-	res = hash_sha256_check(hash, dst, size);
+	res = copy_and_hash(dst, src, size, hash);
 	if (res)
 		memset(dst, 0, size);
 
@@ -5,6 +5,7 @@ srcs-$(CFG_DEVICE_ENUM_PTA) += device.c
 srcs-$(CFG_TA_GPROF_SUPPORT) += gprof.c
 ifeq ($(CFG_WITH_USER_TA),y)
 srcs-$(CFG_SECSTOR_TA_MGMT_PTA) += secstor_ta_mgmt.c
+srcs-$(CFG_TA_PRELOAD_PTA) += ta_preload.c
 endif
 srcs-$(CFG_WITH_STATS) += stats.c
 srcs-$(CFG_SYSTEM_PTA) += system.c
@@ -14,6 +15,8 @@ srcs-$(CFG_SCMI_PTA) += scmi.c
 srcs-$(CFG_HWRNG_PTA) += hwrng.c
 srcs-$(CFG_RTC_PTA) += rtc.c
 srcs-$(CFG_WIDEVINE_PTA) += widevine.c
+srcs-$(CFG_CORE_TRACE_RING) += trace_ring.c
+srcs-$(CFG_CORE_PC_SAMPLING) += core_prof.c
 
 subdirs-y += bcm
 subdirs-y += stm32mp
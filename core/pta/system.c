@@ -313,6 +313,31 @@ static TEE_Result system_get_tpm_event_log(uint32_t param_types,
 	return res;
 }
 
+static TEE_Result system_get_tpm_events(uint32_t param_types,
+					TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	size_t total = 0;
+	size_t count = 0;
+	size_t size = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	size = params[1].memref.size;
+	res = tpm_read_events(params[0].value.a, params[1].memref.buffer,
+			      &size, &count, &total);
+	params[1].memref.size = size;
+	params[2].value.a = count;
+	params[2].value.b = total;
+
+	return res;
+}
+
 static TEE_Result system_supp_plugin_invoke(uint32_t param_types,
 					    TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -386,6 +411,8 @@ static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 		return system_get_tpm_event_log(param_types, params);
 	case PTA_SYSTEM_SUPP_PLUGIN_INVOKE:
 		return system_supp_plugin_invoke(param_types, params);
+	case PTA_SYSTEM_GET_TPM_EVENTS:
+		return system_get_tpm_events(param_types, params);
 	default:
 		break;
 	}
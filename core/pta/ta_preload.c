@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * This pseudo TA lets the normal world load keep-alive TAs ahead of time,
+ * for instance from an init script once tee-supplicant is running, so the
+ * first session open to them is as cheap as the following ones.
+ */
+
+#include <kernel/pseudo_ta.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/ts_manager.h>
+#include <pta_ta_preload.h>
+#include <tee/uuid.h>
+#include <tee_api_types.h>
+#include <trace.h>
+
+#define PTA_NAME "ta_preload.pta"
+
+static TEE_Result preload(uint32_t param_types,
+			  TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_VALUE_OUTPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	const uint8_t *buf = NULL;
+	TEE_UUID uuid = { };
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	buf = params[0].memref.buffer;
+	if ((!buf && params[0].memref.size) ||
+	    params[0].memref.size % sizeof(TEE_UUID))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	params[1].value.a = 0;
+	for (n = 0; n < params[0].memref.size / sizeof(TEE_UUID); n++) {
+		tee_uuid_from_octets(&uuid, buf + n * sizeof(TEE_UUID));
+		res = tee_ta_preload(&uuid);
+		if (res) {
+			EMSG(PTA_NAME ": can't preload TA %pUl: %#"PRIx32,
+			     (void *)&uuid, res);
+			return res;
+		}
+		params[1].value.a++;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx __unused)
+{
+	/* Only the normal world may preload TAs */
+	if (ts_get_calling_session())
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd_id) {
+	case PTA_TA_PRELOAD_CMD_LOAD:
+		return preload(param_types, params);
+	default:
+		break;
+	}
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_TA_PRELOAD_UUID, .name = PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .open_session_entry_point = open_session,
+		   .invoke_command_entry_point = invoke_command);
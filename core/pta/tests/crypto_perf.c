@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <config.h>
+#include <crypto/crypto.h>
+#include <kernel/delay.h>
+#include <malloc.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/tee_cryp_hkdf.h>
+#include <tee/tee_cryp_pbkdf2.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <utee_defines.h>
+
+#include "misc.h"
+
+/* Upper bound of the number of latency samples kept for the percentiles */
+#define CRYPTO_PERF_MAX_REPS	4096
+/* Large enough for the signature of a 4096-bit RSA key */
+#define CRYPTO_PERF_OUT_SIZE	512
+
+struct crypto_perf {
+	uint32_t algo;
+	uint32_t arg;
+	const uint8_t *in;
+	size_t in_len;
+	void *ctx;
+	uint8_t key[64];
+	struct rsa_keypair rsa;
+	struct ecc_keypair ecc;
+	struct ecc_public_key ecc_pub;
+	size_t sig_len;
+	uint8_t sig[CRYPTO_PERF_OUT_SIZE];
+	uint8_t out[CRYPTO_PERF_OUT_SIZE];
+};
+
+static TEE_Result hash_op(struct crypto_perf *p)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_hash_init(p->ctx);
+	if (!res)
+		res = crypto_hash_update(p->ctx, p->in, p->in_len);
+	if (!res)
+		res = crypto_hash_final(p->ctx, p->out,
+					TEE_ALG_GET_DIGEST_SIZE(p->algo));
+	return res;
+}
+
+static TEE_Result mac_op(struct crypto_perf *p)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_mac_init(p->ctx, p->key, p->arg / 8);
+	if (!res)
+		res = crypto_mac_update(p->ctx, p->in, p->in_len);
+	if (!res)
+		res = crypto_mac_final(p->ctx, p->out,
+				       TEE_ALG_GET_DIGEST_SIZE(p->algo));
+	return res;
+}
+
+static TEE_Result hkdf_op(struct crypto_perf *p)
+{
+	if (!IS_ENABLED(CFG_CRYPTO_HKDF))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return tee_cryp_hkdf(TEE_ALG_GET_MAIN_ALG(p->algo), p->in, p->in_len,
+			     NULL, 0, NULL, 0, p->out,
+			     TEE_ALG_GET_DIGEST_SIZE(p->algo));
+}
+
+static TEE_Result pbkdf2_op(struct crypto_perf *p)
+{
+	if (!IS_ENABLED(CFG_CRYPTO_PBKDF2))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return tee_cryp_pbkdf2(TEE_ALG_GET_MAIN_ALG(p->algo), p->in,
+			       p->in_len, p->key, sizeof(p->key), p->arg,
+			       p->out, TEE_ALG_GET_DIGEST_SIZE(p->algo));
+}
+
+static bool is_rsa(struct crypto_perf *p)
+{
+	return TEE_ALG_GET_MAIN_ALG(p->algo) == TEE_MAIN_ALGO_RSA;
+}
+
+static TEE_Result sign_op(struct crypto_perf *p)
+{
+	p->sig_len = sizeof(p->sig);
+	if (is_rsa(p))
+		return crypto_acipher_rsassa_sign(p->algo, &p->rsa, -1, p->in,
+						  p->in_len, p->sig,
+						  &p->sig_len);
+	return crypto_acipher_ecc_sign(p->algo, &p->ecc, p->in, p->in_len,
+				       p->sig, &p->sig_len);
+}
+
+static TEE_Result verify_op(struct crypto_perf *p)
+{
+	struct rsa_public_key rsa_pub = { .e = p->rsa.e, .n = p->rsa.n };
+
+	if (is_rsa(p))
+		return crypto_acipher_rsassa_verify(p->algo, &rsa_pub, -1,
+						    p->in, p->in_len, p->sig,
+						    p->sig_len);
+	return crypto_acipher_ecc_verify(p->algo, &p->ecc_pub, p->in,
+					 p->in_len, p->sig, p->sig_len);
+}
+
+static uint32_t ecc_curve(size_t key_size)
+{
+	switch (key_size) {
+	case 192:
+		return TEE_ECC_CURVE_NIST_P192;
+	case 224:
+		return TEE_ECC_CURVE_NIST_P224;
+	case 256:
+		return TEE_ECC_CURVE_NIST_P256;
+	case 384:
+		return TEE_ECC_CURVE_NIST_P384;
+	case 521:
+		return TEE_ECC_CURVE_NIST_P521;
+	default:
+		return 0;
+	}
+}
+
+static TEE_Result gen_key(struct crypto_perf *p)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (TEE_ALG_GET_DIGEST_SIZE(TEE_DIGEST_HASH_TO_ALGO(p->algo)) !=
+	    p->in_len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (is_rsa(p)) {
+		if (p->arg > CRYPTO_PERF_OUT_SIZE * 8)
+			return TEE_ERROR_BAD_PARAMETERS;
+		res = crypto_acipher_alloc_rsa_keypair(&p->rsa, p->arg);
+		if (res)
+			return res;
+		return crypto_acipher_gen_rsa_key(&p->rsa, p->arg);
+	}
+
+	if (TEE_ALG_GET_MAIN_ALG(p->algo) != TEE_MAIN_ALGO_ECDSA ||
+	    !ecc_curve(p->arg))
+		return TEE_ERROR_BAD_PARAMETERS;
+	res = crypto_acipher_alloc_ecc_keypair(&p->ecc, TEE_TYPE_ECDSA_KEYPAIR,
+					       p->arg);
+	if (res)
+		return res;
+	p->ecc.curve = ecc_curve(p->arg);
+	res = crypto_acipher_gen_ecc_key(&p->ecc, p->arg);
+	if (res)
+		return res;
+
+	res = crypto_acipher_alloc_ecc_public_key(&p->ecc_pub,
+						  TEE_TYPE_ECDSA_PUBLIC_KEY,
+						  p->arg);
+	if (res)
+		return res;
+	p->ecc_pub.curve = p->ecc.curve;
+	crypto_bignum_copy(p->ecc_pub.x, p->ecc.x);
+	crypto_bignum_copy(p->ecc_pub.y, p->ecc.y);
+
+	return TEE_SUCCESS;
+}
+
+static void free_key(struct crypto_perf *p)
+{
+	if (is_rsa(p)) {
+		crypto_acipher_free_rsa_keypair(&p->rsa);
+	} else {
+		crypto_bignum_free(&p->ecc.d);
+		crypto_bignum_free(&p->ecc.x);
+		crypto_bignum_free(&p->ecc.y);
+		if (p->ecc_pub.ops)
+			crypto_acipher_free_ecc_public_key(&p->ecc_pub);
+	}
+}
+
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_OUTPUT);
+	TEE_Result (*op_func)(struct crypto_perf *p) = NULL;
+	struct pta_invoke_tests_perf *res_out = NULL;
+	uint32_t op = params[0].value.a;
+	struct crypto_perf *p = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int rep_count = 0;
+	uint64_t *samples = NULL;
+	uint64_t start = 0;
+	unsigned int n = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	rep_count = params[1].value.a;
+	if (!rep_count || rep_count > CRYPTO_PERF_MAX_REPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (params[3].memref.size < sizeof(*res_out)) {
+		params[3].memref.size = sizeof(*res_out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	params[3].memref.size = sizeof(*res_out);
+	res_out = params[3].memref.buffer;
+
+	p = calloc(1, sizeof(*p));
+	samples = calloc(rep_count, sizeof(*samples));
+	if (!p || !samples) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	p->algo = params[0].value.b;
+	p->arg = params[1].value.b;
+	p->in = params[2].memref.buffer;
+	p->in_len = params[2].memref.size;
+	memset(p->key, 0xa5, sizeof(p->key));
+
+	switch (op) {
+	case PTA_INVOKE_TESTS_CRYPTO_HASH:
+		op_func = hash_op;
+		res = crypto_hash_alloc_ctx(&p->ctx, p->algo);
+		break;
+	case PTA_INVOKE_TESTS_CRYPTO_MAC:
+		op_func = mac_op;
+		if (!p->arg || p->arg % 8 || p->arg / 8 > sizeof(p->key))
+			res = TEE_ERROR_BAD_PARAMETERS;
+		else
+			res = crypto_mac_alloc_ctx(&p->ctx, p->algo);
+		break;
+	case PTA_INVOKE_TESTS_CRYPTO_HKDF:
+	case PTA_INVOKE_TESTS_CRYPTO_PBKDF2:
+		if (op == PTA_INVOKE_TESTS_CRYPTO_HKDF)
+			op_func = hkdf_op;
+		else
+			op_func = pbkdf2_op;
+		if (TEE_ALG_GET_CLASS(p->algo) != TEE_OPERATION_DIGEST ||
+		    !TEE_ALG_GET_DIGEST_SIZE(p->algo))
+			res = TEE_ERROR_BAD_PARAMETERS;
+		break;
+	case PTA_INVOKE_TESTS_CRYPTO_SIGN:
+	case PTA_INVOKE_TESTS_CRYPTO_VERIFY:
+		res = gen_key(p);
+		if (op == PTA_INVOKE_TESTS_CRYPTO_SIGN) {
+			op_func = sign_op;
+		} else {
+			op_func = verify_op;
+			/* The signature to verify */
+			if (!res)
+				res = sign_op(p);
+		}
+		break;
+	default:
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+	if (res)
+		goto out_free;
+
+	for (n = 0; n < rep_count; n++) {
+		start = delay_cnt_read();
+		res = op_func(p);
+		samples[n] = delay_cnt_read() - start;
+		if (res)
+			goto out_free;
+	}
+
+	perf_report(samples, rep_count, p->in_len, res_out);
+
+out_free:
+	if (op == PTA_INVOKE_TESTS_CRYPTO_HASH)
+		crypto_hash_free_ctx(p->ctx);
+	else if (op == PTA_INVOKE_TESTS_CRYPTO_MAC)
+		crypto_mac_free_ctx(p->ctx);
+	else if (op == PTA_INVOKE_TESTS_CRYPTO_SIGN ||
+		 op == PTA_INVOKE_TESTS_CRYPTO_VERIFY)
+		free_key(p);
+out:
+	free(samples);
+	free(p);
+	return res;
+}
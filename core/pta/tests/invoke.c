@@ -433,6 +433,16 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_aes_perf_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS:
 		return core_dt_driver_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_RNG_PERF:
+		return core_rng_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_CRYPTO_PERF:
+		return core_crypto_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_STORAGE_PERF:
+		return core_storage_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_LATENCY_PERF:
+		return core_latency_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_RNG_TESTS:
+		return core_rng_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <kernel/delay.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/tee_time.h>
+#include <kernel/thread.h>
+#include <mm/core_mmu.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+/* Upper bound of the number of latency samples kept for the percentiles */
+#define LATENCY_PERF_MAX_REPS	4096
+
+struct latency_perf {
+	TEE_UUID uuid;
+	TEE_Identity clnt_id;
+	struct tee_ta_session_head sessions;
+	struct tee_ta_session *sess;
+};
+
+static TEE_Result rpc_op(struct latency_perf *p __unused)
+{
+	TEE_Time t = { };
+
+	return tee_time_get_ree_time(&t);
+}
+
+static TEE_Result shm_op(struct latency_perf *p __unused)
+{
+	struct mobj *mobj = thread_rpc_alloc_payload(SMALL_PAGE_SIZE);
+
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	thread_rpc_free_payload(mobj);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result open_session(struct latency_perf *p)
+{
+	TEE_ErrorOrigin err = TEE_ORIGIN_TEE;
+	struct tee_ta_param param = { };
+
+	return tee_ta_open_session(&err, &p->sess, &p->sessions, &p->uuid,
+				   &p->clnt_id, TEE_TIMEOUT_INFINITE, &param);
+}
+
+static void close_session(struct latency_perf *p)
+{
+	tee_ta_close_session(p->sess, &p->sessions, &p->clnt_id);
+	p->sess = NULL;
+}
+
+static TEE_Result session_op(struct latency_perf *p)
+{
+	TEE_Result res = open_session(p);
+
+	if (!res)
+		close_session(p);
+	return res;
+}
+
+static TEE_Result invoke_op(struct latency_perf *p)
+{
+	TEE_ErrorOrigin err = TEE_ORIGIN_TEE;
+	struct tee_ta_param param = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = tee_ta_invoke_command(&err, p->sess, &p->clnt_id,
+				    TEE_TIMEOUT_INFINITE, 0, &param);
+	/* Only the round trip matters, not what the TA makes of command 0 */
+	if (err != TEE_ORIGIN_TRUSTED_APP)
+		return res;
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_latency_perf_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	/* Counter value as close as possible to the dispatch of the call */
+	uint64_t entry = delay_cnt_read();
+	TEE_Result (*op_func)(struct latency_perf *p) = NULL;
+	struct pta_invoke_tests_perf *res_out = NULL;
+	struct latency_perf p = {
+		.clnt_id = {
+			.login = TEE_LOGIN_TRUSTED_APP,
+			.uuid = PTA_INVOKE_TESTS_UUID,
+		},
+		.sessions = TAILQ_HEAD_INITIALIZER(p.sessions),
+	};
+	uint32_t op = params[0].value.a;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int rep_count = 0;
+	uint64_t *samples = NULL;
+	uint64_t start = 0;
+	unsigned int n = 0;
+
+	if (TEE_PARAM_TYPE_GET(param_types, 0) != TEE_PARAM_TYPE_VALUE_INPUT ||
+	    TEE_PARAM_TYPE_GET(param_types, 1) != TEE_PARAM_TYPE_VALUE_OUTPUT ||
+	    (TEE_PARAM_TYPE_GET(param_types, 2) != TEE_PARAM_TYPE_NONE &&
+	     TEE_PARAM_TYPE_GET(param_types, 2) !=
+	     TEE_PARAM_TYPE_MEMREF_INPUT) ||
+	    TEE_PARAM_TYPE_GET(param_types, 3) != TEE_PARAM_TYPE_MEMREF_OUTPUT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	params[1].value.a = entry >> 32;
+	params[1].value.b = entry;
+
+	if (params[3].memref.size < sizeof(*res_out)) {
+		params[3].memref.size = sizeof(*res_out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	params[3].memref.size = sizeof(*res_out);
+	res_out = params[3].memref.buffer;
+	memset(res_out, 0, sizeof(*res_out));
+
+	switch (op) {
+	case PTA_INVOKE_TESTS_LATENCY_ENTRY:
+		return TEE_SUCCESS;
+	case PTA_INVOKE_TESTS_LATENCY_RPC:
+		op_func = rpc_op;
+		break;
+	case PTA_INVOKE_TESTS_LATENCY_SHM:
+		op_func = shm_op;
+		break;
+	case PTA_INVOKE_TESTS_LATENCY_SESSION:
+	case PTA_INVOKE_TESTS_LATENCY_INVOKE:
+		if (TEE_PARAM_TYPE_GET(param_types, 2) !=
+		    TEE_PARAM_TYPE_MEMREF_INPUT ||
+		    params[2].memref.size != sizeof(p.uuid))
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(&p.uuid, params[2].memref.buffer, sizeof(p.uuid));
+		if (op == PTA_INVOKE_TESTS_LATENCY_SESSION)
+			op_func = session_op;
+		else
+			op_func = invoke_op;
+		break;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	rep_count = params[0].value.b;
+	if (!rep_count || rep_count > LATENCY_PERF_MAX_REPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	samples = calloc(rep_count, sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/* The session the commands are invoked on isn't measured */
+	if (op == PTA_INVOKE_TESTS_LATENCY_INVOKE) {
+		res = open_session(&p);
+		if (res)
+			goto out;
+	}
+
+	for (n = 0; n < rep_count; n++) {
+		start = delay_cnt_read();
+		res = op_func(&p);
+		samples[n] = delay_cnt_read() - start;
+		if (res)
+			goto out_close;
+	}
+
+	perf_report(samples, rep_count, 0, res_out);
+
+out_close:
+	if (p.sess)
+		close_session(&p);
+out:
+	free(samples);
+	return res;
+}
@@ -21,8 +21,8 @@ static int self_test_lockdep1(void)
 
 	DMSG("");
 
-	TAILQ_INIT(&thread1);
-	TAILQ_INIT(&graph);
+	lockdep_queue_init(&thread1);
+	lockdep_graph_init(&graph);
 
 	/* Not locked, expect failure */
 	res = __lockdep_lock_release(&thread1, 1);
@@ -82,10 +82,10 @@ static int self_test_lockdep2(void)
 
 	DMSG("");
 
-	TAILQ_INIT(&thread1);
-	TAILQ_INIT(&thread2);
-	TAILQ_INIT(&thread3);
-	TAILQ_INIT(&graph);
+	lockdep_queue_init(&thread1);
+	lockdep_queue_init(&thread2);
+	lockdep_queue_init(&thread3);
+	lockdep_graph_init(&graph);
 
 	res = __lockdep_lock_acquire(&graph, &thread1, 1);
 	if (res)
@@ -135,9 +135,9 @@ static int self_test_lockdep3(void)
 
 	DMSG("");
 
-	TAILQ_INIT(&thread1);
-	TAILQ_INIT(&thread2);
-	TAILQ_INIT(&graph);
+	lockdep_queue_init(&thread1);
+	lockdep_queue_init(&thread2);
+	lockdep_graph_init(&graph);
 
 	res = __lockdep_lock_tryacquire(&graph, &thread1, 1);
 	if (res)
@@ -5,12 +5,15 @@
  */
 #include <assert.h>
 #include <config.h>
+#include <crypto/ctr_drbg.h>
+#include <crypto/rng_health.h>
 #include <kernel/dt_driver.h>
 #include <kernel/linker.h>
 #include <kernel/panic.h>
 #include <malloc.h>
 #include <mm/core_memprot.h>
 #include <stdbool.h>
+#include <string.h>
 #include <trace.h>
 #include <util.h>
 
@@ -657,6 +660,104 @@ static int self_test_va2pa(void)
 	return ret;
 }
 
+static int self_test_rng_health(void)
+{
+	struct rng_health h = { };
+	uint32_t n = 0;
+
+	LOG("rng health tests:");
+
+	/* 8 bits per sample: RCT cutoff is 4, APT cutoff is 13 */
+	rng_health_init(&h, 8);
+	for (n = 0; n < RNG_HEALTH_APT_WINDOW * 2; n++)
+		if (rng_health_feed(&h, n))
+			goto fail;
+
+	/* Repetition count test trips on the 4th identical sample */
+	for (n = 0; n < 3; n++)
+		if (rng_health_feed(&h, 0xdead))
+			goto fail;
+	if (!rng_health_feed(&h, 0xdead) || !rng_health_failed(&h))
+		goto fail;
+	/* Failure is sticky */
+	if (!rng_health_feed(&h, 1))
+		goto fail;
+
+	/* Adaptive proportion test trips on the 13th first sample in a window */
+	rng_health_init(&h, 8);
+	for (n = 0; n < 12; n++)
+		if (rng_health_feed(&h, 0xa5) || rng_health_feed(&h, n))
+			goto fail;
+	if (!rng_health_feed(&h, 0xa5))
+		goto fail;
+
+	LOG("  => test ok");
+	return 0;
+
+fail:
+	LOG("  => test FAILED");
+	return -1;
+}
+
+#ifdef CFG_CORE_CTR_DRBG
+/*
+ * NIST CAVP drbgvectors_no_reseed, CTR_DRBG AES-256 no df,
+ * PredictionResistance = False, COUNT = 0: instantiate then generate 512
+ * bits twice, the second output is the returned bits.
+ */
+static const uint8_t ctr_drbg_kat_entropy[CTR_DRBG_SEED_LEN] = {
+	0xdf, 0x5d, 0x73, 0xfa, 0xa4, 0x68, 0x64, 0x9e,
+	0xdd, 0xa3, 0x3b, 0x5c, 0xca, 0x79, 0xb0, 0xb0,
+	0x56, 0x00, 0x41, 0x9c, 0xcb, 0x7a, 0x87, 0x9d,
+	0xdf, 0xec, 0x9d, 0xb3, 0x2e, 0xe4, 0x94, 0xe5,
+	0x53, 0x1b, 0x51, 0xde, 0x16, 0xa3, 0x0f, 0x76,
+	0x92, 0x62, 0x47, 0x4c, 0x73, 0xbe, 0xc0, 0x10,
+};
+
+static const uint8_t ctr_drbg_kat_returned[64] = {
+	0xd1, 0xc0, 0x7c, 0xd9, 0x5a, 0xf8, 0xa7, 0xf1,
+	0x10, 0x12, 0xc8, 0x4c, 0xe4, 0x8b, 0xb8, 0xcb,
+	0x87, 0x18, 0x9e, 0x99, 0xd4, 0x0f, 0xcc, 0xb1,
+	0x77, 0x1c, 0x61, 0x9b, 0xdf, 0x82, 0xab, 0x22,
+	0x80, 0xb1, 0xdc, 0x2f, 0x25, 0x81, 0xf3, 0x91,
+	0x64, 0xf7, 0xac, 0x0c, 0x51, 0x04, 0x94, 0xb3,
+	0xa4, 0x3c, 0x41, 0xb7, 0xdb, 0x17, 0x51, 0x4c,
+	0x87, 0xb1, 0x07, 0xae, 0x79, 0x3e, 0x01, 0xc5,
+};
+
+static int self_test_ctr_drbg(void)
+{
+	uint8_t out[sizeof(ctr_drbg_kat_returned)] = { };
+	struct ctr_drbg drbg = { };
+	int ret = -1;
+
+	LOG("ctr_drbg known answer test:");
+
+	if (ctr_drbg_instantiate(&drbg, ctr_drbg_kat_entropy))
+		goto out;
+	if (ctr_drbg_generate(&drbg, out, sizeof(out)) ||
+	    ctr_drbg_generate(&drbg, out, sizeof(out)))
+		goto uninstantiate;
+	if (memcmp(out, ctr_drbg_kat_returned, sizeof(out)))
+		goto uninstantiate;
+
+	ret = 0;
+uninstantiate:
+	ctr_drbg_uninstantiate(&drbg);
+out:
+	if (ret)
+		LOG("  => test FAILED");
+	else
+		LOG("  => test ok");
+	return ret;
+}
+#else
+static int self_test_ctr_drbg(void)
+{
+	return 0;
+}
+#endif
+
 /* exported entry points for some basic test */
 TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 		TEE_Param pParams[TEE_NUM_PARAMS] __unused)
@@ -664,7 +765,8 @@ TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 	if (self_test_mul_signed_overflow() || self_test_add_overflow() ||
 	    self_test_sub_overflow() || self_test_mul_unsigned_overflow() ||
 	    self_test_division() || self_test_malloc() ||
-	    self_test_nex_malloc() || self_test_va2pa()) {
+	    self_test_nex_malloc() || self_test_va2pa() ||
+	    self_test_rng_health() || self_test_ctr_drbg()) {
 		EMSG("some self_test_xxx failed! you should enable local LOG");
 		return TEE_ERROR_GENERIC;
 	}
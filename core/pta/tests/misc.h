@@ -37,4 +37,83 @@ TEE_Result core_aes_perf_tests(uint32_t param_types,
 TEE_Result core_dt_driver_tests(uint32_t param_types,
 				TEE_Param params[TEE_NUM_PARAMS]);
 
+typedef TEE_Result (*rng_read_func_t)(void *buf, size_t len);
+
+/* Returns the read function of PTA_INVOKE_TESTS_RNG_* @source or NULL */
+rng_read_func_t rng_test_read_func(uint32_t source);
+
+TEE_Result core_rng_tests(uint32_t param_types,
+			  TEE_Param params[TEE_NUM_PARAMS]);
+
+struct pta_invoke_tests_perf;
+
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+/*
+ * Fills @res from the @count latencies in @samples, in counter ticks, of
+ * operations on @unit_size bytes each. @samples is sorted in place.
+ */
+void perf_report(uint64_t *samples, unsigned int count, size_t unit_size,
+		 struct pta_invoke_tests_perf *res);
+
+/* Converts @cnt counter ticks to microseconds */
+uint64_t perf_cnt_to_us(uint64_t cnt);
+
+/*
+ * Fills @perf from @rep_count reads of @unit_size bytes into @buf with
+ * @read_func
+ */
+TEE_Result rng_perf_measure(rng_read_func_t read_func, void *buf,
+			    size_t unit_size, unsigned int rep_count,
+			    struct pta_invoke_tests_perf *perf);
+
+TEE_Result core_rng_perf_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS]);
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS]);
+TEE_Result core_latency_perf_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result
+rng_perf_measure(rng_read_func_t read_func __unused, void *buf __unused,
+		 size_t unit_size __unused, unsigned int rep_count __unused,
+		 struct pta_invoke_tests_perf *perf __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result core_rng_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result core_crypto_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result core_latency_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#if defined(CFG_CORE_HAS_GENERIC_TIMER) && \
+	(defined(CFG_REE_FS) || defined(CFG_RPMB_FS))
+TEE_Result core_storage_perf_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_storage_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 #endif /*CORE_PTA_TESTS_MISC_H*/
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/delay.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+static int cmp_u64(const void *a, const void *b)
+{
+	const uint64_t *ua = a;
+	const uint64_t *ub = b;
+
+	return CMP_TRILEAN(*ua, *ub);
+}
+
+uint64_t perf_cnt_to_us(uint64_t cnt)
+{
+	uint64_t freq = delay_cnt_freq();
+
+	return (cnt / freq) * 1000000 + (cnt % freq) * 1000000 / freq;
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, unsigned int p)
+{
+	return perf_cnt_to_us(sorted[(n - 1) * p / 100]);
+}
+
+void perf_report(uint64_t *samples, unsigned int count, size_t unit_size,
+		 struct pta_invoke_tests_perf *res)
+{
+	uint64_t total = 0;
+	unsigned int n = 0;
+
+	for (n = 0; n < count; n++)
+		total += samples[n];
+
+	qsort(samples, count, sizeof(*samples), cmp_u64);
+
+	memset(res, 0, sizeof(*res));
+	res->total_us = perf_cnt_to_us(total);
+	res->min_us = perf_cnt_to_us(samples[0]);
+	res->p50_us = percentile(samples, count, 50);
+	res->p90_us = percentile(samples, count, 90);
+	res->p99_us = percentile(samples, count, 99);
+	res->max_us = perf_cnt_to_us(samples[count - 1]);
+	if (total)
+		res->bytes_per_sec = (uint64_t)unit_size * count *
+				     delay_cnt_freq() / total;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <kernel/delay.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+/* Upper bound of the number of latency samples kept for the percentiles */
+#define RNG_PERF_MAX_REPS	4096
+
+TEE_Result rng_perf_measure(rng_read_func_t read_func, void *buf,
+			    size_t unit_size, unsigned int rep_count,
+			    struct pta_invoke_tests_perf *perf)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t *samples = NULL;
+	uint64_t start = 0;
+	unsigned int n = 0;
+
+	samples = calloc(rep_count, sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < rep_count; n++) {
+		start = delay_cnt_read();
+		res = read_func(buf, unit_size);
+		samples[n] = delay_cnt_read() - start;
+		if (res)
+			goto out;
+	}
+
+	perf_report(samples, rep_count, unit_size, perf);
+
+out:
+	free(samples);
+	return res;
+}
+
+TEE_Result core_rng_perf_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						   TEE_PARAM_TYPE_MEMREF_OUTPUT);
+	struct pta_invoke_tests_perf *res_out = NULL;
+	rng_read_func_t read_func = NULL;
+	unsigned int rep_count = 0;
+	size_t unit_size = 0;
+	uint8_t *buf = NULL;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	read_func = rng_test_read_func(params[0].value.a);
+	if (!read_func)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	unit_size = params[0].value.b;
+	rep_count = params[1].value.a;
+	buf = params[2].memref.buffer;
+
+	if (!unit_size || unit_size > params[2].memref.size || !rep_count ||
+	    rep_count > RNG_PERF_MAX_REPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (params[3].memref.size < sizeof(*res_out)) {
+		params[3].memref.size = sizeof(*res_out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	params[3].memref.size = sizeof(*res_out);
+	res_out = params[3].memref.buffer;
+
+	return rng_perf_measure(read_func, buf, unit_size, rep_count, res_out);
+}
@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <config.h>
+#include <crypto/crypto.h>
+#include <pta_invoke_tests.h>
+#include <rng_support.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+/* Upper bounds of the parameters of the performance measurement */
+#define RNG_TESTS_MAX_REPS	4096
+#define RNG_TESTS_MAX_SIZE	4096
+
+/* Requests of the LENGTHS check, placed between guard bytes */
+#define RNG_TESTS_MAX_LEN	40
+#define RNG_TESTS_MAX_OFFS	8
+#define RNG_TESTS_GUARD		8
+#define RNG_TESTS_FILL		0xa5
+
+/* FIPS 140-2 section 4.9: 20000 bit sample read 16 bytes at a time */
+#define RNG_TESTS_BLOCK		16
+#define RNG_TESTS_SAMPLE	2500
+#define RNG_TESTS_NUM_BLOCKS	\
+	DIV_ROUND_UP(RNG_TESTS_SAMPLE, RNG_TESTS_BLOCK)
+
+/* Runs of 6 bits and more are counted together */
+#define RNG_TESTS_MAX_RUN	6U
+#define RNG_TESTS_LONG_RUN	26
+
+static const struct {
+	uint16_t min;
+	uint16_t max;
+} runs_bounds[RNG_TESTS_MAX_RUN] = {
+	{ 2343, 2657 }, { 1135, 1365 }, { 542, 708 },
+	{ 251, 373 }, { 111, 201 }, { 111, 201 },
+};
+
+static TEE_Result hw_read(void *buf __maybe_unused,
+			  size_t len __maybe_unused)
+{
+#ifdef CFG_WITH_SOFTWARE_PRNG
+	/* hw_get_random_bytes() is not mandatory with a software PRNG */
+	return TEE_ERROR_NOT_SUPPORTED;
+#else
+	return hw_get_random_bytes(buf, len);
+#endif
+}
+
+rng_read_func_t rng_test_read_func(uint32_t source)
+{
+	switch (source) {
+	case PTA_INVOKE_TESTS_RNG_CRYPTO:
+		return crypto_rng_read;
+	case PTA_INVOKE_TESTS_RNG_HW:
+		return hw_read;
+	default:
+		return NULL;
+	}
+}
+
+static bool is_filled(const uint8_t *b, size_t len)
+{
+	size_t n = 0;
+
+	for (n = 0; n < len; n++)
+		if (b[n] != RNG_TESTS_FILL)
+			return false;
+
+	return true;
+}
+
+static TEE_Result check_lengths(rng_read_func_t read_func,
+				struct pta_invoke_tests_rng_result *r)
+{
+	uint8_t b[2 * RNG_TESTS_GUARD + RNG_TESTS_MAX_OFFS +
+		  RNG_TESTS_MAX_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs = 0;
+	size_t len = 0;
+	size_t end = 0;
+
+	for (len = 1; len <= RNG_TESTS_MAX_LEN; len++) {
+		for (offs = 0; offs < RNG_TESTS_MAX_OFFS; offs++) {
+			memset(b, RNG_TESTS_FILL, sizeof(b));
+			res = read_func(b + RNG_TESTS_GUARD + offs, len);
+			if (res)
+				return res;
+
+			end = RNG_TESTS_GUARD + offs + len;
+			/* 8 random bytes all equal to the fill are unlikely */
+			if (!is_filled(b, RNG_TESTS_GUARD + offs) ||
+			    !is_filled(b + end, sizeof(b) - end) ||
+			    (len >= 8 &&
+			     is_filled(b + RNG_TESTS_GUARD + offs, len))) {
+				r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_LENGTHS;
+				return TEE_SUCCESS;
+			}
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_sample(rng_read_func_t read_func, uint8_t *sample,
+			      struct pta_invoke_tests_rng_result *r)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *b = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < RNG_TESTS_NUM_BLOCKS; n++) {
+		b = sample + n * RNG_TESTS_BLOCK;
+		res = read_func(b, RNG_TESTS_BLOCK);
+		if (res)
+			return res;
+		if (n && !memcmp(b - RNG_TESTS_BLOCK, b, RNG_TESTS_BLOCK))
+			r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_REPEAT;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void add_run(unsigned int *runs, unsigned int run_len,
+		    struct pta_invoke_tests_rng_result *r)
+{
+	runs[MIN(run_len, RNG_TESTS_MAX_RUN) - 1]++;
+	r->longest_run = MAX(r->longest_run, run_len);
+}
+
+static void check_sample(const uint8_t *sample,
+			 struct pta_invoke_tests_rng_result *r)
+{
+	unsigned int runs[2][RNG_TESTS_MAX_RUN] = { };
+	unsigned int nibbles[16] = { };
+	unsigned int run_len = 0;
+	unsigned int prev = 0;
+	unsigned int bit = 0;
+	uint64_t sum = 0;
+	size_t n = 0;
+	int i = 0;
+
+	for (n = 0; n < RNG_TESTS_SAMPLE; n++) {
+		nibbles[sample[n] >> 4]++;
+		nibbles[sample[n] & 0xf]++;
+
+		for (i = 7; i >= 0; i--) {
+			bit = (sample[n] >> i) & 1;
+			r->ones += bit;
+			if (run_len && bit == prev) {
+				run_len++;
+				continue;
+			}
+			if (run_len)
+				add_run(runs[prev], run_len, r);
+			prev = bit;
+			run_len = 1;
+		}
+	}
+	add_run(runs[prev], run_len, r);
+
+	if (r->ones <= 9725 || r->ones >= 10275)
+		r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_MONOBIT;
+
+	/*
+	 * X = 16 / 5000 * sum(f(i)^2) - 5000 with 5000 nibbles, which can't
+	 * be negative.
+	 */
+	for (n = 0; n < ARRAY_SIZE(nibbles); n++)
+		sum += nibbles[n] * nibbles[n];
+	r->poker_x100 = (16 * sum - 5000 * 5000) / 50;
+	if (r->poker_x100 <= 216 || r->poker_x100 >= 4617)
+		r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_POKER;
+
+	for (n = 0; n < RNG_TESTS_MAX_RUN; n++) {
+		for (bit = 0; bit < 2; bit++) {
+			if (runs[bit][n] < runs_bounds[n].min ||
+			    runs[bit][n] > runs_bounds[n].max)
+				r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_RUNS;
+		}
+	}
+
+	if (r->longest_run >= RNG_TESTS_LONG_RUN)
+		r->failed |= PTA_INVOKE_TESTS_RNG_CHECK_LONG_RUN;
+}
+
+static TEE_Result measure(rng_read_func_t read_func, size_t unit_size,
+			  unsigned int rep_count,
+			  struct pta_invoke_tests_rng_result *r)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *buf = NULL;
+
+	if (!unit_size || unit_size > RNG_TESTS_MAX_SIZE ||
+	    rep_count > RNG_TESTS_MAX_REPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	buf = malloc(unit_size);
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = rng_perf_measure(read_func, buf, unit_size, rep_count, &r->perf);
+
+	free(buf);
+	return res;
+}
+
+TEE_Result core_rng_tests(uint32_t param_types,
+			  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_NONE,
+						   TEE_PARAM_TYPE_MEMREF_OUTPUT);
+	struct pta_invoke_tests_rng_result r = { };
+	rng_read_func_t read_func = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int rep_count = 0;
+	uint8_t *sample = NULL;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	read_func = rng_test_read_func(params[0].value.a);
+	if (!read_func)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (params[3].memref.size < sizeof(r)) {
+		params[3].memref.size = sizeof(r);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	sample = malloc(RNG_TESTS_NUM_BLOCKS * RNG_TESTS_BLOCK);
+	if (!sample)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = check_lengths(read_func, &r);
+	if (res)
+		goto out;
+
+	res = read_sample(read_func, sample, &r);
+	if (res)
+		goto out;
+	check_sample(sample, &r);
+
+	rep_count = params[1].value.a;
+	if (rep_count) {
+		res = measure(read_func, params[0].value.b, rep_count, &r);
+		if (res)
+			goto out;
+	}
+
+	params[3].memref.size = sizeof(r);
+	memcpy(params[3].memref.buffer, &r, sizeof(r));
+
+out:
+	free(sample);
+	return res;
+}
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <kernel/delay.h>
+#include <kernel/thread.h>
+#include <malloc.h>
+#include <pta_invoke_tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/tee_fs.h>
+#include <tee/tee_fs_key_manager.h>
+#include <tee/tee_pobj.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define STORAGE_PERF_MAX_OBJS	256
+#define STORAGE_PERF_OBJ_FLAGS	(TEE_DATA_FLAG_ACCESS_READ | \
+				 TEE_DATA_FLAG_ACCESS_WRITE | \
+				 TEE_DATA_FLAG_ACCESS_WRITE_META)
+
+struct storage_perf {
+	const struct tee_file_operations *fops;
+	uint32_t op;
+	unsigned int count;
+	size_t size;
+	uint8_t *buf;
+	struct tee_pobj **po;
+	uint64_t *samples;
+	uint64_t rpc_ticks;
+	uint64_t crypto_ticks;
+	uint64_t start;
+	uint64_t rpc_start;
+	uint64_t crypto_start;
+};
+
+static TEE_UUID storage_perf_uuid = PTA_INVOKE_TESTS_UUID;
+
+static uint64_t thread_rpc_ticks(void)
+{
+#ifdef CFG_CORE_THREAD_TIME_STATS
+	struct thread_time_stats s = { };
+
+	thread_get_time_stats(thread_get_id(), &s);
+	return s.suspended_ticks;
+#else
+	return 0;
+#endif
+}
+
+static void sample_begin(struct storage_perf *p)
+{
+	p->rpc_start = thread_rpc_ticks();
+	p->crypto_start = tee_fs_crypto_ticks();
+	p->start = delay_cnt_read();
+}
+
+static void sample_end(struct storage_perf *p, unsigned int n)
+{
+	p->samples[n] = delay_cnt_read() - p->start;
+	p->crypto_ticks += tee_fs_crypto_ticks() - p->crypto_start;
+	p->rpc_ticks += thread_rpc_ticks() - p->rpc_start;
+}
+
+static TEE_Result get_pobj(struct storage_perf *p, unsigned int n,
+			   bool renamed, enum tee_pobj_usage usage,
+			   struct tee_pobj **po)
+{
+	char id[16] = { };
+	int len = 0;
+
+	len = snprintf(id, sizeof(id), "perf-%u%s", n, renamed ? "-r" : "");
+	return tee_pobj_get(&storage_perf_uuid, id, len,
+			    STORAGE_PERF_OBJ_FLAGS, usage, p->fops, po);
+}
+
+static TEE_Result create_obj(struct storage_perf *p, unsigned int n,
+			     size_t size)
+{
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = get_pobj(p, n, false, TEE_POBJ_USAGE_CREATE, p->po + n);
+	if (res)
+		return res;
+
+	res = p->fops->create(p->po[n], true, NULL, 0, NULL, 0, p->buf, NULL,
+			      size, &fh);
+	if (res) {
+		tee_pobj_release(p->po[n]);
+		p->po[n] = NULL;
+		return res;
+	}
+	p->fops->close(&fh);
+	tee_pobj_create_final(p->po[n]);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result open_obj(struct storage_perf *p, unsigned int n,
+			   struct tee_file_handle **fh)
+{
+	size_t size = 0;
+
+	return p->fops->open(p->po[n], &size, fh);
+}
+
+static TEE_Result rename_obj(struct storage_perf *p, unsigned int n)
+{
+	struct tee_pobj *po = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = get_pobj(p, n, true, TEE_POBJ_USAGE_RENAME, &po);
+	if (res)
+		return res;
+
+	res = p->fops->rename(p->po[n], po, false);
+	if (res) {
+		tee_pobj_release(po);
+		return res;
+	}
+	tee_pobj_release(p->po[n]);
+	p->po[n] = po;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result timed_op(struct storage_perf *p, unsigned int n)
+{
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t len = p->size;
+
+	/* The object is opened outside of the measurement */
+	if (p->op == PTA_INVOKE_TESTS_STORAGE_READ ||
+	    p->op == PTA_INVOKE_TESTS_STORAGE_WRITE ||
+	    p->op == PTA_INVOKE_TESTS_STORAGE_TRUNCATE) {
+		res = open_obj(p, n, &fh);
+		if (res)
+			return res;
+	}
+
+	sample_begin(p);
+	switch (p->op) {
+	case PTA_INVOKE_TESTS_STORAGE_CREATE:
+		res = create_obj(p, n, p->size);
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_OPEN:
+		res = open_obj(p, n, &fh);
+		if (!res)
+			p->fops->close(&fh);
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_READ:
+		res = p->fops->read(fh, 0, p->buf, NULL, &len);
+		if (!res && len != p->size)
+			res = TEE_ERROR_CORRUPT_OBJECT;
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_WRITE:
+		res = p->fops->write(fh, 0, p->buf, NULL, p->size);
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_TRUNCATE:
+		res = p->fops->truncate(fh, p->size / 2);
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_RENAME:
+		res = rename_obj(p, n);
+		break;
+	case PTA_INVOKE_TESTS_STORAGE_REMOVE:
+		res = p->fops->remove(p->po[n]);
+		if (!res) {
+			tee_pobj_release(p->po[n]);
+			p->po[n] = NULL;
+		}
+		break;
+	default:
+		res = TEE_ERROR_BAD_PARAMETERS;
+		break;
+	}
+	sample_end(p, n);
+
+	if (fh)
+		p->fops->close(&fh);
+
+	return res;
+}
+
+static TEE_Result enumerate(struct storage_perf *p)
+{
+	struct tee_fs_dirent *ent = NULL;
+	struct tee_fs_dir *d = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int n = 0;
+
+	res = p->fops->opendir(&storage_perf_uuid, &d);
+	if (res)
+		return res;
+
+	for (n = 0; n < p->count; n++) {
+		sample_begin(p);
+		res = p->fops->readdir(d, &ent);
+		sample_end(p, n);
+		if (res)
+			break;
+	}
+
+	p->fops->closedir(d);
+	return res;
+}
+
+static void remove_objs(struct storage_perf *p)
+{
+	unsigned int n = 0;
+
+	for (n = 0; n < p->count; n++) {
+		if (!p->po[n])
+			continue;
+		if (p->fops->remove(p->po[n]))
+			EMSG("Can't remove object %u", n);
+		tee_pobj_release(p->po[n]);
+	}
+}
+
+static TEE_Result run(struct storage_perf *p)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t size = p->size;
+	unsigned int n = 0;
+
+	if (p->op != PTA_INVOKE_TESTS_STORAGE_CREATE) {
+		/* Objects to write are created empty */
+		if (p->op == PTA_INVOKE_TESTS_STORAGE_WRITE)
+			size = 0;
+		for (n = 0; n < p->count; n++) {
+			res = create_obj(p, n, size);
+			if (res)
+				return res;
+		}
+	}
+
+	if (p->op == PTA_INVOKE_TESTS_STORAGE_ENUMERATE)
+		return enumerate(p);
+
+	for (n = 0; n < p->count; n++) {
+		res = timed_op(p, n);
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_storage_perf_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_NONE,
+						   TEE_PARAM_TYPE_MEMREF_OUTPUT);
+	struct pta_invoke_tests_storage_perf *res_out = NULL;
+	struct storage_perf p = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t unit_size = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p.fops = tee_svc_storage_file_ops(params[0].value.a);
+	if (!p.fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	p.op = params[0].value.b;
+	if (p.op > PTA_INVOKE_TESTS_STORAGE_REMOVE)
+		return TEE_ERROR_BAD_PARAMETERS;
+	p.count = params[1].value.a;
+	if (!p.count || p.count > STORAGE_PERF_MAX_OBJS)
+		return TEE_ERROR_BAD_PARAMETERS;
+	p.size = params[1].value.b;
+
+	if (params[3].memref.size < sizeof(*res_out)) {
+		params[3].memref.size = sizeof(*res_out);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	params[3].memref.size = sizeof(*res_out);
+	res_out = params[3].memref.buffer;
+
+	p.buf = malloc(MAX(p.size, 1U));
+	p.po = calloc(p.count, sizeof(*p.po));
+	p.samples = calloc(p.count, sizeof(*p.samples));
+	if (!p.buf || !p.po || !p.samples) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	memset(p.buf, 0xa5, p.size);
+
+	res = run(&p);
+	if (!res) {
+		/* Throughput is only meaningful for operations on the data */
+		if (p.op == PTA_INVOKE_TESTS_STORAGE_CREATE ||
+		    p.op == PTA_INVOKE_TESTS_STORAGE_READ ||
+		    p.op == PTA_INVOKE_TESTS_STORAGE_WRITE)
+			unit_size = p.size;
+		perf_report(p.samples, p.count, unit_size, &res_out->perf);
+		res_out->rpc_us = perf_cnt_to_us(p.rpc_ticks);
+		res_out->crypto_us = perf_cnt_to_us(p.crypto_ticks);
+	}
+
+	remove_objs(&p);
+out:
+	free(p.samples);
+	free(p.po);
+	free(p.buf);
+	return res;
+}
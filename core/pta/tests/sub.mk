@@ -5,4 +5,11 @@ srcs-y += misc.c
 cflags-misc.c-y += -fno-builtin
 srcs-y += mutex.c
 srcs-y += aes_perf.c
+srcs-$(CFG_CORE_HAS_GENERIC_TIMER) += perf.c
+srcs-$(CFG_CORE_HAS_GENERIC_TIMER) += rng_perf.c
+srcs-y += rng_tests.c
+srcs-$(CFG_CORE_HAS_GENERIC_TIMER) += crypto_perf.c
+srcs-$(CFG_CORE_HAS_GENERIC_TIMER) += latency_perf.c
+srcs-$(call cfg-all-enabled,CFG_CORE_HAS_GENERIC_TIMER _CFG_WITH_SECURE_STORAGE) += \
+	storage_perf.c
 srcs-$(CFG_DT_DRIVER_EMBEDDED_TEST) += dt_driver_test.c
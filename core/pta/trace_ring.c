@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * This pseudo TA lets the normal world read the trace output of the
+ * core when it's buffered instead of written to the console, or have it
+ * written to a non-secure buffer to read without calling into the TEE.
+ */
+
+#include <kernel/pseudo_ta.h>
+#include <kernel/trace_ring.h>
+#include <kernel/ts_manager.h>
+#include <pta_trace_ring.h>
+#include <tee_api_types.h>
+#include <util.h>
+
+#define PTA_NAME "trace_ring.pta"
+
+static TEE_Result read_ring(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+
+	if (param_types != exp_pt || !params[0].memref.buffer)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	params[0].memref.size = trace_ring_read(params[0].memref.buffer,
+						params[0].memref.size);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result set_shm(uint32_t param_types,
+			  TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	uint64_t pa = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pa = reg_pair_to_64(params[0].value.a, params[0].value.b);
+	if (pa != (paddr_t)pa)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return trace_ring_set_shm(pa, params[1].value.a);
+}
+
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx __unused)
+{
+	/* Only the normal world may read the trace output */
+	if (ts_get_calling_session())
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd_id) {
+	case PTA_TRACE_RING_CMD_READ:
+		return read_ring(param_types, params);
+	case PTA_TRACE_RING_CMD_SET_SHM:
+		return set_shm(param_types, params);
+	default:
+		break;
+	}
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_TRACE_RING_UUID, .name = PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .open_session_entry_point = open_session,
+		   .invoke_command_entry_point = invoke_command);
@@ -1 +1,2 @@
 srcs-$(CFG_VERSAL_FPGA_LOADER_PTA) += fpga_pta.c
+srcs-$(CFG_VERSAL_TRNG_PTA) += trng_pta.c
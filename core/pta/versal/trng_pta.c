@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/ctr_drbg.h>
+#include <kernel/pseudo_ta.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/user_ta.h>
+#include <malloc.h>
+#include <pta_versal_trng.h>
+#include <rng_support.h>
+#include <string.h>
+#include <string_ext.h>
+#include <util.h>
+
+#define TRNG_PTA_NAME "versal_trng.pta"
+
+static_assert(PTA_VERSAL_TRNG_PERS_MAX_LEN <= CTR_DRBG_SEED_LEN);
+
+/*
+ * struct trng_stream - Random stream of a session
+ * @drbg:	DRBG serving the reads
+ * @pers:	Personalization string, zero padded
+ * @reseed_bytes: Number of bytes generated between two reseeds
+ * @gen_bytes:	Number of bytes generated since the last reseed
+ * @ready:	@drbg is instantiated
+ */
+struct trng_stream {
+	struct ctr_drbg drbg;
+	uint8_t pers[CTR_DRBG_SEED_LEN];
+	size_t reseed_bytes;
+	size_t gen_bytes;
+	bool ready;
+};
+
+/*
+ * Without a derivation function the personalization string is XORed into
+ * the seed material, NIST SP 800-90A section 10.2.1.3.1.
+ */
+static TEE_Result get_seed(struct trng_stream *s, uint8_t *seed)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	res = hw_get_random_bytes(seed, CTR_DRBG_SEED_LEN);
+	if (res)
+		return res;
+
+	for (n = 0; n < CTR_DRBG_SEED_LEN; n++)
+		seed[n] ^= s->pers[n];
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result reseed(struct trng_stream *s)
+{
+	uint8_t seed[CTR_DRBG_SEED_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = get_seed(s, seed);
+	if (!res)
+		res = ctr_drbg_reseed(&s->drbg, seed);
+	memzero_explicit(seed, sizeof(seed));
+	if (!res)
+		s->gen_bytes = 0;
+
+	return res;
+}
+
+static TEE_Result stream_open(struct trng_stream *s, uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	uint8_t seed[CTR_DRBG_SEED_LEN] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t pers_len = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (s->ready)
+		return TEE_ERROR_BAD_STATE;
+
+	pers_len = params[1].memref.size;
+	if (pers_len > PTA_VERSAL_TRNG_PERS_MAX_LEN)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (pers_len)
+		memcpy(s->pers, params[1].memref.buffer, pers_len);
+
+	s->reseed_bytes = params[0].value.a;
+	if (!s->reseed_bytes)
+		s->reseed_bytes = CFG_VERSAL_TRNG_PTA_RESEED_BYTES;
+
+	res = get_seed(s, seed);
+	if (!res)
+		res = ctr_drbg_instantiate(&s->drbg, seed);
+	memzero_explicit(seed, sizeof(seed));
+	if (res)
+		return res;
+
+	s->gen_bytes = 0;
+	s->ready = true;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result stream_read(struct trng_stream *s, uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	uint8_t *buf = params[0].memref.buffer;
+	size_t len = params[0].memref.size;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!s->ready)
+		return TEE_ERROR_BAD_STATE;
+
+	while (len) {
+		if (s->gen_bytes >= s->reseed_bytes) {
+			res = reseed(s);
+			if (res)
+				return res;
+		}
+
+		n = MIN(len, s->reseed_bytes - s->gen_bytes);
+		res = ctr_drbg_generate(&s->drbg, buf, n);
+		if (res)
+			return res;
+
+		s->gen_bytes += n;
+		buf += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx)
+{
+	struct ts_session *ts = ts_get_calling_session();
+	struct trng_stream *s = NULL;
+
+	/* Streams are only handed out to user TAs */
+	if (!ts || !is_user_ta_ctx(ts->ctx))
+		return TEE_ERROR_ACCESS_DENIED;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	*sess_ctx = s;
+
+	return TEE_SUCCESS;
+}
+
+static void close_session(void *sess_ctx)
+{
+	struct trng_stream *s = sess_ctx;
+
+	if (s->ready)
+		ctr_drbg_uninstantiate(&s->drbg);
+	memzero_explicit(s, sizeof(*s));
+	free(s);
+}
+
+static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd_id) {
+	case PTA_VERSAL_TRNG_OPEN:
+		return stream_open(sess_ctx, param_types, params);
+	case PTA_VERSAL_TRNG_READ:
+		return stream_read(sess_ctx, param_types, params);
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
+/*
+ * The state of a stream is private to its session, sessions don't need
+ * to wait for each other.
+ */
+pseudo_ta_register(.uuid = PTA_VERSAL_TRNG_UUID, .name = TRNG_PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
+		   .open_session_entry_point = open_session,
+		   .close_session_entry_point = close_session,
+		   .invoke_command_entry_point = invoke_command);
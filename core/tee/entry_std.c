@@ -10,9 +10,13 @@
 #include <io.h>
 #include <kernel/linker.h>
 #include <kernel/msg_param.h>
+#include <kernel/mutex.h>
 #include <kernel/notif.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
+#include <kernel/virtualization.h>
+#include <kernel/workqueue.h>
+#include <malloc.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
@@ -20,6 +24,7 @@
 #include <string.h>
 #include <tee/entry_std.h>
 #include <tee/tee_cryp_utl.h>
+#include <sys/queue.h>
 #include <tee/uuid.h>
 #include <util.h>
 
@@ -31,6 +36,34 @@
 static struct tee_ta_session_head tee_open_sessions =
 TAILQ_HEAD_INITIALIZER(tee_open_sessions);
 
+#ifdef CFG_CORE_ASYNC_INVOKE
+enum async_invoke_state {
+	ASYNC_INVOKE_PENDING,
+	ASYNC_INVOKE_RUNNING,
+	ASYNC_INVOKE_DONE,
+};
+
+/*
+ * struct async_invoke - An invoke submitted with OPTEE_MSG_CMD_INVOKE_ASYNC
+ * @arg:	Secure copy of the invoke command, updated with the result
+ * @value:	Asynchronous notification value signalled on completion
+ * @guest_id:	Guest which submitted the invoke
+ * @state:	Progress of the invoke, protected by async_invoke_mu
+ * @link:	Link in async_invokes
+ */
+struct async_invoke {
+	struct optee_msg_arg *arg;
+	uint32_t value;
+	uint16_t guest_id;
+	enum async_invoke_state state;
+	TAILQ_ENTRY(async_invoke) link;
+};
+
+static TAILQ_HEAD(, async_invoke) async_invokes =
+	TAILQ_HEAD_INITIALIZER(async_invokes);
+static struct mutex async_invoke_mu = MUTEX_INITIALIZER;
+#endif
+
 #ifdef CFG_CORE_RESERVED_SHM
 static struct mobj *shm_mobj;
 #endif
@@ -115,8 +148,13 @@ static TEE_Result set_tmem_param(const struct optee_msg_param_tmem *tmem,
 	if (attr & OPTEE_MSG_ATTR_NONCONTIG) {
 		uint64_t shm_ref = READ_ONCE(tmem->shm_ref);
 
-		mem->mobj = msg_param_mobj_from_noncontig(pa, sz, shm_ref,
-							  false);
+		if (attr & OPTEE_MSG_ATTR_EXTENTS)
+			mem->mobj = msg_param_mobj_from_extents(pa, sz, shm_ref,
+								false);
+		else
+			mem->mobj = msg_param_mobj_from_noncontig(pa, sz,
+								  shm_ref,
+								  false);
 		if (!mem->mobj)
 			return TEE_ERROR_BAD_PARAMETERS;
 		mem->offs = 0;
@@ -448,6 +486,215 @@ out:
 	arg->ret_origin = err_orig;
 }
 
+#ifdef CFG_CORE_INVOKE_BATCH
+static TEE_Result invoke_batch(vaddr_t va, size_t size)
+{
+	struct optee_msg_arg *entry = NULL;
+	uint32_t num_params = 0;
+	size_t entry_size = 0;
+
+	if (!IS_ALIGNED_WITH_TYPE(va, struct optee_msg_arg))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	while (size) {
+		if (size < sizeof(*entry))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		entry = (struct optee_msg_arg *)va;
+		num_params = READ_ONCE(entry->num_params);
+		if (num_params > TEE_NUM_PARAMS ||
+		    READ_ONCE(entry->cmd) != OPTEE_MSG_CMD_INVOKE_COMMAND)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		entry_size = OPTEE_MSG_GET_ARG_SIZE(num_params);
+		if (size < entry_size)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		entry_invoke_command(entry, num_params);
+
+		va += entry_size;
+		size -= entry_size;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void entry_invoke_batch(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct tee_ta_param param = { 0 };
+	uint64_t saved_attr[TEE_NUM_PARAMS] = { 0 };
+	struct param_mem *mem = &param.u[0].mem;
+	void *va = NULL;
+
+	if (num_params != 1)
+		goto out;
+
+	res = copy_in_params(arg->params, num_params, &param, saved_attr);
+	if (res)
+		goto out;
+
+	if (TEE_PARAM_TYPE_GET(param.types, 0) != TEE_PARAM_TYPE_MEMREF_INOUT ||
+	    !mem->mobj) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = mobj_inc_map(mem->mobj);
+	if (res)
+		goto out;
+
+	va = mobj_get_va(mem->mobj, mem->offs, mem->size);
+	if (va)
+		res = invoke_batch((vaddr_t)va, mem->size);
+	else
+		res = TEE_ERROR_BAD_PARAMETERS;
+
+	if (mobj_dec_map(mem->mobj))
+		panic();
+
+out:
+	cleanup_shm_refs(saved_attr, &param, num_params);
+
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+#endif /*CFG_CORE_INVOKE_BATCH*/
+
+#ifdef CFG_CORE_ASYNC_INVOKE
+static void entry_invoke_async(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	uint16_t guest_id = virt_get_current_guest_id();
+	struct async_invoke *ai = NULL;
+	size_t n = 0;
+
+	if (!num_params || num_params - 1 > TEE_NUM_PARAMS ||
+	    READ_ONCE(arg->params[0].attr) !=
+	    (OPTEE_MSG_ATTR_TYPE_VALUE_OUTPUT | OPTEE_MSG_ATTR_META))
+		goto out;
+	n = num_params - 1;
+
+	if (!notif_async_is_started(guest_id)) {
+		res = TEE_ERROR_NOT_SUPPORTED;
+		goto out;
+	}
+
+	ai = calloc(1, sizeof(*ai));
+	if (!ai) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	ai->arg = malloc(OPTEE_MSG_GET_ARG_SIZE(n));
+	if (!ai->arg) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err;
+	}
+
+	/*
+	 * The parameters are copied as is, they're checked by
+	 * copy_in_params() once the command is executed.
+	 */
+	ai->arg->cmd = OPTEE_MSG_CMD_INVOKE_COMMAND;
+	ai->arg->func = READ_ONCE(arg->func);
+	ai->arg->session = READ_ONCE(arg->session);
+	ai->arg->cancel_id = READ_ONCE(arg->cancel_id);
+	ai->arg->num_params = n;
+	memcpy(ai->arg->params, arg->params + 1, n * sizeof(arg->params[0]));
+	ai->guest_id = guest_id;
+
+	res = notif_alloc_async_value(&ai->value);
+	if (res)
+		goto err;
+
+	mutex_lock(&async_invoke_mu);
+	TAILQ_INSERT_TAIL(&async_invokes, ai, link);
+	mutex_unlock(&async_invoke_mu);
+
+	arg->params[0].u.value.a = ai->value;
+	arg->params[0].u.value.b = 0;
+	arg->params[0].u.value.c = 0;
+
+	/* The command is executed by the next OPTEE_MSG_CMD_DO_BOTTOM_HALF */
+	notif_send_async(NOTIF_VALUE_DO_BOTTOM_HALF, guest_id);
+	goto out;
+err:
+	free(ai->arg);
+	free(ai);
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+
+static void run_async_invokes(void)
+{
+	struct async_invoke *ai = NULL;
+
+	while (true) {
+		mutex_lock(&async_invoke_mu);
+		TAILQ_FOREACH(ai, &async_invokes, link)
+			if (ai->state == ASYNC_INVOKE_PENDING)
+				break;
+		if (ai)
+			ai->state = ASYNC_INVOKE_RUNNING;
+		mutex_unlock(&async_invoke_mu);
+
+		if (!ai)
+			break;
+
+		entry_invoke_command(ai->arg, ai->arg->num_params);
+
+		mutex_lock(&async_invoke_mu);
+		ai->state = ASYNC_INVOKE_DONE;
+		mutex_unlock(&async_invoke_mu);
+
+		notif_send_async(ai->value, ai->guest_id);
+	}
+}
+
+static void entry_invoke_async_result(struct optee_msg_arg *arg,
+				      uint32_t num_params)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct async_invoke *ai = NULL;
+	uint32_t value = 0;
+
+	if (!num_params ||
+	    READ_ONCE(arg->params[0].attr) !=
+	    (OPTEE_MSG_ATTR_TYPE_VALUE_INPUT | OPTEE_MSG_ATTR_META))
+		goto out;
+	value = READ_ONCE(arg->params[0].u.value.a);
+
+	mutex_lock(&async_invoke_mu);
+	TAILQ_FOREACH(ai, &async_invokes, link)
+		if (ai->value == value)
+			break;
+	if (ai && ai->state != ASYNC_INVOKE_DONE)
+		res = TEE_ERROR_BUSY;
+	else if (ai && ai->arg->num_params == num_params - 1)
+		TAILQ_REMOVE(&async_invokes, ai, link);
+	else
+		ai = NULL;
+	mutex_unlock(&async_invoke_mu);
+
+	if (!ai || res == TEE_ERROR_BUSY)
+		goto out;
+
+	memcpy(arg->params + 1, ai->arg->params,
+	       ai->arg->num_params * sizeof(arg->params[0]));
+	arg->ret = ai->arg->ret;
+	arg->ret_origin = ai->arg->ret_origin;
+
+	notif_free_async_value(ai->value);
+	free(ai->arg);
+	free(ai);
+	return;
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+#endif /*CFG_CORE_ASYNC_INVOKE*/
+
 static void entry_cancel(struct optee_msg_arg *arg, uint32_t num_params)
 {
 	TEE_Result res;
@@ -477,19 +724,25 @@ out:
 #ifdef CFG_CORE_DYN_SHM
 static void register_shm(struct optee_msg_arg *arg, uint32_t num_params)
 {
+	const uint64_t attr_pages = OPTEE_MSG_ATTR_TYPE_TMEM_OUTPUT |
+				    OPTEE_MSG_ATTR_NONCONTIG;
 	struct optee_msg_param_tmem *tmem = NULL;
 	struct mobj *mobj = NULL;
+	uint64_t attr = 0;
 
 	arg->ret = TEE_ERROR_BAD_PARAMETERS;
 
-	if (num_params != 1 ||
-	    (arg->params[0].attr !=
-	     (OPTEE_MSG_ATTR_TYPE_TMEM_OUTPUT | OPTEE_MSG_ATTR_NONCONTIG)))
+	if (num_params != 1)
 		return;
 
+	attr = READ_ONCE(arg->params[0].attr);
 	tmem = &arg->params[0].u.tmem;
-	mobj = msg_param_mobj_from_noncontig(tmem->buf_ptr, tmem->size,
-					     tmem->shm_ref, false);
+	if (attr == attr_pages)
+		mobj = msg_param_mobj_from_noncontig(tmem->buf_ptr, tmem->size,
+						     tmem->shm_ref, false);
+	else if (attr == (attr_pages | OPTEE_MSG_ATTR_EXTENTS))
+		mobj = msg_param_mobj_from_extents(tmem->buf_ptr, tmem->size,
+						   tmem->shm_ref, false);
 
 	if (!mobj)
 		return;
@@ -536,6 +789,7 @@ TEE_Result __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 
 	/* Enable foreign interrupts for STD calls */
 	thread_set_foreign_intr(true);
+	call_deferred_initcalls();
 	switch (arg->cmd) {
 	case OPTEE_MSG_CMD_OPEN_SESSION:
 		entry_open_session(arg, num_params);
@@ -546,6 +800,19 @@ TEE_Result __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 	case OPTEE_MSG_CMD_INVOKE_COMMAND:
 		entry_invoke_command(arg, num_params);
 		break;
+#ifdef CFG_CORE_INVOKE_BATCH
+	case OPTEE_MSG_CMD_INVOKE_BATCH:
+		entry_invoke_batch(arg, num_params);
+		break;
+#endif
+#ifdef CFG_CORE_ASYNC_INVOKE
+	case OPTEE_MSG_CMD_INVOKE_ASYNC:
+		entry_invoke_async(arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_INVOKE_ASYNC_RESULT:
+		entry_invoke_async_result(arg, num_params);
+		break;
+#endif
 	case OPTEE_MSG_CMD_CANCEL:
 		entry_cancel(arg, num_params);
 		break;
@@ -565,6 +832,10 @@ TEE_Result __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 			notif_deliver_event(NOTIF_EVENT_DO_BOTTOM_HALF);
 		else
 			goto err;
+#ifdef CFG_CORE_ASYNC_INVOKE
+		run_async_invokes();
+#endif
+		workqueue_run();
 		break;
 	case OPTEE_MSG_CMD_STOP_ASYNC_NOTIF:
 		if (IS_ENABLED(CFG_CORE_ASYNC_NOTIF))
@@ -10,13 +10,23 @@
 #include <string.h>
 #include <tee/fs_dirfile.h>
 #include <types_ext.h>
+#include <util.h>
 
+/*
+ * @dents and @dent_hashes index the entries of the dirfile, they're built
+ * when it's opened and kept in sync by write_dent(). A bit is set in
+ * @dents for each used entry and @dent_hashes holds a hash of its UUID and
+ * object ID, only entries with a matching hash are read by lookups.
+ */
 struct tee_fs_dirfile_dirh {
 	const struct tee_fs_dirfile_operations *fops;
 	struct tee_file_handle *fh;
 	int nbits;
 	bitstr_t *files;
 	size_t ndents;
+	int ndent_bits;
+	bitstr_t *dents;
+	uint32_t *dent_hashes;
 };
 
 struct dirfile_entry {
@@ -93,6 +103,73 @@ static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 	return false;
 }
 
+/* FNV-1a of the UUID and object ID */
+static uint32_t dent_hash(const TEE_UUID *uuid, const void *oid,
+			  size_t oidlen)
+{
+	const uint8_t *b = (const uint8_t *)uuid;
+	uint32_t h = 2166136261;
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(*uuid); n++)
+		h = (h ^ b[n]) * 16777619;
+	b = oid;
+	for (n = 0; n < oidlen; n++)
+		h = (h ^ b[n]) * 16777619;
+
+	return h;
+}
+
+static TEE_Result maybe_grow_dents(struct tee_fs_dirfile_dirh *dirh, int idx)
+{
+	size_t cnt = 0;
+	void *p = NULL;
+
+	if (idx < dirh->ndent_bits)
+		return TEE_SUCCESS;
+
+	/* Grown by at least half to amortize the reallocations */
+	cnt = MAX(idx + 1, dirh->ndent_bits + dirh->ndent_bits / 2);
+
+	p = realloc(dirh->dent_hashes, cnt * sizeof(*dirh->dent_hashes));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->dent_hashes = p;
+
+	p = realloc(dirh->dents, bitstr_size(cnt));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->dents = p;
+
+	bit_nclear(dirh->dents, dirh->ndent_bits, cnt - 1);
+	dirh->ndent_bits = cnt;
+
+	return TEE_SUCCESS;
+}
+
+/* The index must have room for @idx, see maybe_grow_dents() */
+static void index_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
+		       struct dirfile_entry *dent)
+{
+	assert(idx < dirh->ndent_bits);
+
+	if (is_free(dent)) {
+		bit_clear(dirh->dents, idx);
+	} else {
+		bit_set(dirh->dents, idx);
+		dirh->dent_hashes[idx] = dent_hash(&dent->uuid, dent->oid,
+						   dent->oidlen);
+	}
+}
+
+static bool test_dent(struct tee_fs_dirfile_dirh *dirh, int idx)
+{
+	if (idx < dirh->ndent_bits)
+		return bit_test(dirh->dents, idx);
+
+	return false;
+}
+
 static TEE_Result read_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
 			    struct dirfile_entry *dent)
 {
@@ -113,12 +190,20 @@ static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
 {
 	TEE_Result res;
 
+	res = maybe_grow_dents(dirh, n);
+	if (res)
+		return res;
+
 	res = dirh->fops->write(dirh->fh, sizeof(*dent) * n, dent,
 				sizeof(*dent));
-	if (!res && n >= dirh->ndents)
+	if (res)
+		return res;
+
+	if (n >= dirh->ndents)
 		dirh->ndents = n + 1;
+	index_dent(dirh, n, dent);
 
-	return res;
+	return TEE_SUCCESS;
 }
 
 TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash, uint32_t min_counter,
@@ -147,6 +232,11 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash, uint32_t min_counter,
 			goto out;
 		}
 
+		/* Free entries are covered too, see find_empty_idx() */
+		res = maybe_grow_dents(dirh, n);
+		if (res)
+			goto out;
+
 		if (is_free(&dent))
 			continue;
 
@@ -163,6 +253,7 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash, uint32_t min_counter,
 		res = set_file(dirh, dent.file_number);
 		if (res != TEE_SUCCESS)
 			goto out;
+		index_dent(dirh, n, &dent);
 	}
 out:
 	if (!res) {
@@ -179,6 +270,8 @@ void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 	if (dirh) {
 		dirh->fops->close(dirh->fh);
 		free(dirh->files);
+		free(dirh->dents);
+		free(dirh->dent_hashes);
 		free(dirh);
 	}
 }
@@ -212,11 +305,17 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 			       const TEE_UUID *uuid, const void *oid,
 			       size_t oidlen, struct tee_fs_dirfile_fileh *dfh)
 {
+	uint32_t h = dent_hash(uuid, oid, oidlen);
 	TEE_Result res = TEE_SUCCESS;
 	struct dirfile_entry dent = { };
 	int n = 0;
 
 	for (n = 0;; n++) {
+		if ((size_t)n >= dirh->ndents)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		if (!test_dent(dirh, n) || dirh->dent_hashes[n] != h)
+			continue;
+
 		res = read_dent(dirh, n, &dent);
 		if (res)
 			return res;
@@ -244,19 +343,14 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 
 static TEE_Result find_empty_idx(struct tee_fs_dirfile_dirh *dh, int *idx)
 {
-	struct dirfile_entry dent = { };
-	TEE_Result res = TEE_SUCCESS;
-	int n = 0;
+	/* The bitstring macros work with int bit counts */
+	int ndents = dh->ndents;
+	int n = -1;
 
-	for (n = 0;; n++) {
-		res = read_dent(dh, n, &dent);
-		if (res == TEE_ERROR_ITEM_NOT_FOUND)
-			break;
-		if (res)
-			return res;
-		if (is_free(&dent))
-			break;
-	}
+	if (ndents)
+		bit_ffc(dh->dents, ndents, &n);
+	if (n == -1)
+		n = ndents;
 
 	*idx = n;
 	return TEE_SUCCESS;
@@ -375,6 +469,10 @@ TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 		i = 0;
 
 	for (;; i++) {
+		if ((size_t)i >= dirh->ndents)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		if (!test_dent(dirh, i))
+			continue;
 		res = read_dent(dirh, i, &dent);
 		if (res)
 			return res;
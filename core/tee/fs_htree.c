@@ -4,12 +4,17 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <kernel/mutex.h>
+#include <kernel/perf_stats.h>
 #include <kernel/tee_common_otp.h>
+#include <kernel/thread.h>
 #include <stdlib.h>
 #include <string_ext.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/fs_htree.h>
 #include <tee/tee_fs_key_manager.h>
 #include <tee/tee_fs_rpc.h>
@@ -76,10 +81,18 @@
 /* n is 0 or 1 */
 #define HTREE_NODE_COMMITTED_CHILD(n)	BIT32(1 + (n))
 
+/*
+ * A node is verified once its children are in memory and its hash has been
+ * checked against them. With CFG_REE_FS_HTREE_LAZY_VERIFY only the nodes
+ * on the path to a block accessed so far are loaded and verified, else the
+ * whole tree is verified when opened. The hash of a node in memory is
+ * always covered by a verified parent, or by the head for the root node.
+ */
 struct htree_node {
 	size_t id;
 	bool dirty;
 	bool block_updated;
+	bool verified;
 	struct tee_fs_htree_node_image node;
 	struct htree_node *parent;
 	struct htree_node *child[2];
@@ -94,6 +107,8 @@ struct tee_fs_htree {
 	const TEE_UUID *uuid;
 	const struct tee_fs_htree_storage *stor;
 	void *stor_aux;
+	struct tee_fs_rpc_batch *batch;
+	struct tee_fs_rpc_batch block_batch;
 };
 
 struct traverse_arg;
@@ -170,8 +185,21 @@ static TEE_Result rpc_write_node(struct tee_fs_htree *ht, size_t node_id,
 				 size_t vers,
 				 const struct tee_fs_htree_node_image *node)
 {
-	return rpc_write(ht, TEE_FS_HTREE_TYPE_NODE, node_id - 1, vers,
-			 node, sizeof(*node));
+	TEE_Result res = TEE_SUCCESS;
+	void *p = NULL;
+
+	if (!ht->batch)
+		return rpc_write(ht, TEE_FS_HTREE_TYPE_NODE, node_id - 1, vers,
+				 node, sizeof(*node));
+
+	res = ht->stor->rpc_batch_add(ht->stor_aux, ht->batch,
+				      TEE_FS_HTREE_TYPE_NODE, node_id - 1,
+				      vers, &p);
+	if (res)
+		return res;
+
+	memcpy(p, node, sizeof(*node));
+	return TEE_SUCCESS;
 }
 
 static TEE_Result traverse_post_order(struct traverse_arg *targ,
@@ -251,16 +279,28 @@ static struct htree_node *find_node(struct tee_fs_htree *ht, size_t node_id)
 	return NULL;
 }
 
+static TEE_Result load_path(struct tee_fs_htree *ht, size_t node_id,
+			    struct htree_node **node_ret);
+
 static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 			   size_t node_id, struct htree_node **node_ret)
 {
+	TEE_Result res = TEE_SUCCESS;
 	struct htree_node *node;
 	struct htree_node *nc;
 	size_t n;
 
-	node = find_closest_node(ht, node_id);
-	if (!node)
-		return TEE_ERROR_GENERIC;
+	if (IS_ENABLED(CFG_REE_FS_HTREE_LAZY_VERIFY) &&
+	    ht->imeta.max_node_id) {
+		res = load_path(ht, MIN(node_id, ht->imeta.max_node_id),
+				&node);
+		if (res != TEE_SUCCESS)
+			return res;
+	} else {
+		node = find_closest_node(ht, node_id);
+		if (!node)
+			return TEE_ERROR_GENERIC;
+	}
 	if (node->id == node_id)
 		goto ret_node;
 
@@ -276,6 +316,13 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 	 * processed the range all nodes up to node_id will be in the tree.
 	 */
 	for (n = node->id + 1; n <= node_id; n++) {
+		/* The parent must be verified before it gets a new child */
+		if (IS_ENABLED(CFG_REE_FS_HTREE_LAZY_VERIFY) &&
+		    (n >> 1) <= ht->imeta.max_node_id) {
+			res = load_path(ht, n >> 1, &node);
+			if (res != TEE_SUCCESS)
+				return res;
+		}
 		node = find_closest_node(ht, n);
 		if (node->id == n)
 			continue;
@@ -287,6 +334,7 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 		if (!nc)
 			return TEE_ERROR_OUT_OF_MEMORY;
 		nc->id = n;
+		nc->verified = true;
 		nc->parent = node;
 		node->child[n & 1] = nc;
 		node = nc;
@@ -396,52 +444,191 @@ static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 		node_id++;
 	}
 
+	/* verify_tree() is called next, the tree is closed if it fails */
+	ht->root.verified = true;
+
 	return TEE_SUCCESS;
 }
 
-static TEE_Result calc_node_hash(struct htree_node *node,
-				 struct tee_fs_htree_meta *meta, void *ctx,
-				 uint8_t *digest)
+/* Maximum number of fragments hashed by calc_node_hash() */
+#define NODE_HASH_MAX_FRAGS	4
+
+static size_t node_hash_frags(struct htree_node *node,
+			      struct tee_fs_htree_meta *meta,
+			      struct crypto_hash_frag *frags)
 {
-	TEE_Result res;
 	uint8_t *ndata = (uint8_t *)&node->node + sizeof(node->node.hash);
 	size_t nsize = sizeof(node->node) - sizeof(node->node.hash);
+	size_t n = 0;
 
-	res = crypto_hash_init(ctx);
-	if (res != TEE_SUCCESS)
-		return res;
+	frags[n++] = (struct crypto_hash_frag){ ndata, nsize };
+
+	if (meta)
+		frags[n++] = (struct crypto_hash_frag){ meta, sizeof(*meta) };
+
+	if (node->child[0])
+		frags[n++] = (struct crypto_hash_frag){
+			.data = node->child[0]->node.hash,
+			.len = sizeof(node->child[0]->node.hash),
+		};
 
-	res = crypto_hash_update(ctx, ndata, nsize);
+	if (node->child[1])
+		frags[n++] = (struct crypto_hash_frag){
+			.data = node->child[1]->node.hash,
+			.len = sizeof(node->child[1]->node.hash),
+		};
+
+	return n;
+}
+
+static TEE_Result hash_frags(void *ctx, struct crypto_hash_frag *frags,
+			     size_t num_frags, uint8_t *digest)
+{
+	TEE_Result res;
+	size_t n;
+
+	res = crypto_hash_init(ctx);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (meta) {
-		res = crypto_hash_update(ctx, (void *)meta, sizeof(*meta));
+	for (n = 0; n < num_frags; n++) {
+		res = crypto_hash_update(ctx, frags[n].data, frags[n].len);
 		if (res != TEE_SUCCESS)
 			return res;
 	}
 
-	if (node->child[0]) {
-		res = crypto_hash_update(ctx, node->child[0]->node.hash,
-					 sizeof(node->child[0]->node.hash));
+	return crypto_hash_final(ctx, digest, TEE_FS_HTREE_HASH_SIZE);
+}
+
+static TEE_Result calc_node_hash(struct htree_node *node,
+				 struct tee_fs_htree_meta *meta, void *ctx,
+				 uint8_t *digest)
+{
+	struct crypto_hash_frag frags[NODE_HASH_MAX_FRAGS] = { };
+	size_t num_frags = node_hash_frags(node, meta, frags);
+	uint64_t begin = tee_fs_crypto_time_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = hash_frags(ctx, frags, num_frags, digest);
+	tee_fs_crypto_time_end(begin);
+
+	return res;
+}
+
+/*
+ * Reads the committed versions of the children of @node from storage and
+ * verifies the hash of @node. *@ctx is a hash context allocated on first
+ * use, to be freed by the caller.
+ */
+static TEE_Result load_children(struct tee_fs_htree *ht,
+				struct htree_node *node, void **ctx)
+{
+	struct tee_fs_htree_meta *meta = NULL;
+	uint8_t digest[TEE_FS_HTREE_HASH_SIZE] = { };
+	struct htree_node *nc = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t child_id = 0;
+	size_t vers = 0;
+	size_t n = 0;
+
+	for (n = 0; n < 2; n++) {
+		child_id = node->id * 2 + n;
+		if (node->child[n] || child_id > ht->imeta.max_node_id)
+			continue;
+
+		nc = calloc(1, sizeof(*nc));
+		if (!nc)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		nc->id = child_id;
+		nc->parent = node;
+		vers = !!(node->node.flags & HTREE_NODE_COMMITTED_CHILD(n));
+		res = rpc_read_node(ht, child_id, vers, &nc->node);
+		if (res != TEE_SUCCESS) {
+			free(nc);
+			return res;
+		}
+		node->child[n] = nc;
+	}
+
+	if (!*ctx) {
+		res = crypto_hash_alloc_ctx(ctx, TEE_FS_HTREE_HASH_ALG);
 		if (res != TEE_SUCCESS)
 			return res;
 	}
 
-	if (node->child[1]) {
-		res = crypto_hash_update(ctx, node->child[1]->node.hash,
-					 sizeof(node->child[1]->node.hash));
+	if (!node->parent)
+		meta = &ht->imeta.meta;
+	res = calc_node_hash(node, meta, *ctx, digest);
+	if (res != TEE_SUCCESS)
+		return res;
+	if (consttime_memcmp(digest, node->node.hash, sizeof(digest)))
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	node->verified = true;
+	return TEE_SUCCESS;
+}
+
+/*
+ * Loads and verifies the nodes from the root down to and including
+ * @node_id, which must not be larger than ht->imeta.max_node_id.
+ */
+static TEE_Result load_path(struct tee_fs_htree *ht, size_t node_id,
+			    struct htree_node **node_ret)
+{
+	size_t level = node_id_to_level(node_id);
+	struct htree_node *node = &ht->root;
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+	size_t n = 0;
+
+	/* n = 1 because root node is level 1 */
+	for (n = 1;; n++) {
+		if (!node->verified) {
+			res = load_children(ht, node, &ctx);
+			if (res != TEE_SUCCESS)
+				goto out;
+		}
+		if (n == level)
+			break;
+		node = node->child[(node_id >> (level - n - 1)) & 1];
+		if (!node) {
+			res = TEE_ERROR_GENERIC;
+			goto out;
+		}
+	}
+
+	*node_ret = node;
+out:
+	crypto_hash_free_ctx(ctx);
+	return res;
+}
+
+static TEE_Result load_subtree(struct tee_fs_htree *ht,
+			       struct htree_node *node, void **ctx)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Recursing at most Log(N) deep, like traverse_post_order() */
+	if (!node)
+		return TEE_SUCCESS;
+
+	if (!node->verified) {
+		res = load_children(ht, node, ctx);
 		if (res != TEE_SUCCESS)
 			return res;
 	}
 
-	return crypto_hash_final(ctx, digest, TEE_FS_HTREE_HASH_SIZE);
+	res = load_subtree(ht, node->child[0], ctx);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return load_subtree(ht, node->child[1], ctx);
 }
 
-static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
-			       struct tee_fs_htree *ht,
-			       struct tee_fs_htree_node_image *ni,
-			       size_t payload_len)
+static TEE_Result do_authenc_init(void **ctx_ret, TEE_OperationMode mode,
+				  struct tee_fs_htree *ht,
+				  struct tee_fs_htree_node_image *ni,
+				  size_t payload_len)
 {
 	TEE_Result res = TEE_SUCCESS;
 	const uint32_t alg = TEE_FS_HTREE_AUTH_ENC_ALG;
@@ -457,7 +644,7 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 	}
 
 	if (mode == TEE_MODE_ENCRYPT) {
-		res = crypto_rng_read(iv, TEE_FS_HTREE_IV_SIZE);
+		res = crypto_nonce_read(iv, TEE_FS_HTREE_IV_SIZE);
 		if (res != TEE_SUCCESS)
 			return res;
 	}
@@ -504,10 +691,25 @@ err_free:
 	return res;
 }
 
+static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
+			       struct tee_fs_htree *ht,
+			       struct tee_fs_htree_node_image *ni,
+			       size_t payload_len)
+{
+	uint64_t begin = tee_fs_crypto_time_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = do_authenc_init(ctx_ret, mode, ht, ni, payload_len);
+	tee_fs_crypto_time_end(begin);
+
+	return res;
+}
+
 static TEE_Result authenc_decrypt_final(void *ctx, const uint8_t *tag,
 					const void *crypt, size_t len,
 					void *plain)
 {
+	uint64_t begin = tee_fs_crypto_time_begin();
 	TEE_Result res;
 	size_t out_size = len;
 
@@ -515,6 +717,7 @@ static TEE_Result authenc_decrypt_final(void *ctx, const uint8_t *tag,
 				       TEE_FS_HTREE_TAG_SIZE);
 	crypto_authenc_final(ctx);
 	crypto_authenc_free_ctx(ctx);
+	tee_fs_crypto_time_end(begin);
 
 	if (res == TEE_SUCCESS && out_size != len)
 		return TEE_ERROR_GENERIC;
@@ -528,6 +731,7 @@ static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
 					const void *plain, size_t len,
 					void *crypt)
 {
+	uint64_t begin = tee_fs_crypto_time_begin();
 	TEE_Result res;
 	size_t out_size = len;
 	size_t out_tag_size = TEE_FS_HTREE_TAG_SIZE;
@@ -536,6 +740,7 @@ static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
 				       &out_tag_size);
 	crypto_authenc_final(ctx);
 	crypto_authenc_free_ctx(ctx);
+	tee_fs_crypto_time_end(begin);
 
 	if (res == TEE_SUCCESS &&
 	    (out_size != len || out_tag_size != TEE_FS_HTREE_TAG_SIZE))
@@ -562,35 +767,85 @@ static TEE_Result verify_root(struct tee_fs_htree *ht)
 				     sizeof(ht->imeta), &ht->imeta);
 }
 
+/*
+ * The hash of a node covers the stored hashes of its children, not
+ * recomputed ones, so all nodes can be verified independently of each
+ * other. verify_tree() collects them in batches of this size to let
+ * crypto_sha256_multi() hash several nodes at a time.
+ */
+#define VERIFY_BATCH_SIZE	8
+
+struct verify_batch {
+	size_t count;
+	struct htree_node *node[VERIFY_BATCH_SIZE];
+	struct crypto_hash_msg msg[VERIFY_BATCH_SIZE];
+	struct crypto_hash_frag frags[VERIFY_BATCH_SIZE][NODE_HASH_MAX_FRAGS];
+	uint8_t digest[VERIFY_BATCH_SIZE][TEE_FS_HTREE_HASH_SIZE];
+};
+
+static TEE_Result verify_batch(struct verify_batch *b)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t begin = 0;
+	size_t n = 0;
+
+	if (!b->count)
+		return TEE_SUCCESS;
+
+	begin = tee_fs_crypto_time_begin();
+	res = crypto_sha256_multi(b->msg, b->count);
+	tee_fs_crypto_time_end(begin);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; n < b->count; n++)
+		if (consttime_memcmp(b->digest[n], b->node[n]->node.hash,
+				     TEE_FS_HTREE_HASH_SIZE))
+			return TEE_ERROR_CORRUPT_OBJECT;
+
+	b->count = 0;
+	return TEE_SUCCESS;
+}
+
 static TEE_Result verify_node(struct traverse_arg *targ,
 			      struct htree_node *node)
 {
-	void *ctx = targ->arg;
-	TEE_Result res;
-	uint8_t digest[TEE_FS_HTREE_HASH_SIZE];
+	struct tee_fs_htree_meta *meta = NULL;
+	struct verify_batch *b = targ->arg;
+	size_t n = b->count;
 
-	if (node->parent)
-		res = calc_node_hash(node, NULL, ctx, digest);
-	else
-		res = calc_node_hash(node, &targ->ht->imeta.meta, ctx, digest);
-	if (res == TEE_SUCCESS &&
-	    consttime_memcmp(digest, node->node.hash, sizeof(digest)))
-		return TEE_ERROR_CORRUPT_OBJECT;
+	thread_yield_point();
 
-	return res;
+	if (!node->parent)
+		meta = &targ->ht->imeta.meta;
+
+	b->node[n] = node;
+	b->msg[n].frags = b->frags[n];
+	b->msg[n].num_frags = node_hash_frags(node, meta, b->frags[n]);
+	b->msg[n].digest = b->digest[n];
+	b->count++;
+
+	if (b->count < VERIFY_BATCH_SIZE)
+		return TEE_SUCCESS;
+
+	return verify_batch(b);
 }
 
 static TEE_Result verify_tree(struct tee_fs_htree *ht)
 {
+	struct verify_batch *b = NULL;
 	TEE_Result res;
-	void *ctx;
 
-	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
-	if (res != TEE_SUCCESS)
-		return res;
+	static_assert(TEE_FS_HTREE_HASH_ALG == TEE_ALG_SHA256);
 
-	res = htree_traverse_post_order(ht, verify_node, ctx);
-	crypto_hash_free_ctx(ctx);
+	b = calloc(1, sizeof(*b));
+	if (!b)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = htree_traverse_post_order(ht, verify_node, b);
+	if (res == TEE_SUCCESS)
+		res = verify_batch(b);
+	free(b);
 
 	return res;
 }
@@ -606,6 +861,7 @@ static TEE_Result init_root_node(struct tee_fs_htree *ht)
 
 	ht->root.id = 1;
 	ht->root.dirty = true;
+	ht->root.verified = true;
 
 	res = calc_node_hash(&ht->root, &ht->imeta.meta, ctx,
 			     ht->root.node.hash);
@@ -661,6 +917,14 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, uint32_t min_counter,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		if (IS_ENABLED(CFG_REE_FS_HTREE_LAZY_VERIFY)) {
+			struct htree_node *root = NULL;
+
+			/* The rest is verified as blocks are accessed */
+			res = load_path(ht, 1, &root);
+			goto out;
+		}
+
 		res = init_tree_from_data(ht);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -765,11 +1029,16 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 {
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
+	struct tee_fs_rpc_batch batch = { };
 	void *ctx;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
+	res = tee_fs_htree_flush_writes(ht_arg);
+	if (res != TEE_SUCCESS)
+		return res;
+
 	if (!ht->dirty)
 		return TEE_SUCCESS;
 
@@ -777,7 +1046,19 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		return res;
 
+	/*
+	 * Queue the node writes in a batch if the storage supports it,
+	 * the batch is flushed before the head is written below.
+	 */
+	if (ht->stor->rpc_batch_init) {
+		ht->stor->rpc_batch_init(ht->stor_aux, &batch);
+		ht->batch = &batch;
+	}
+
 	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, ctx);
+	ht->batch = NULL;
+	if (res == TEE_SUCCESS && ht->stor->rpc_batch_init)
+		res = ht->stor->rpc_batch_flush(&batch);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -802,6 +1083,140 @@ out:
 	return res;
 }
 
+#if CFG_REE_FS_BLOCK_CACHE
+/*
+ * struct block_cache_entry - a decrypted and authenticated data block
+ * @enc_fek:	encrypted file encryption key of the file
+ * @iv:		IV the block was encrypted with
+ * @tag:	authentication tag of the block
+ * @block_num:	block number in the file
+ * @block_size:	size of @data
+ * @data:	the decrypted block
+ * @link:	link in block_cache, most recently used first
+ *
+ * A new IV is used each time a block is encrypted so @enc_fek, @iv and
+ * @tag identify the content of the block. A block node in an
+ * authenticated hash tree with matching values is served from the cache
+ * instead of being read and decrypted again. Entries of old versions of
+ * a block are never matched again and are simply evicted in due time.
+ */
+struct block_cache_entry {
+	uint8_t enc_fek[TEE_FS_HTREE_FEK_SIZE];
+	uint8_t iv[TEE_FS_HTREE_IV_SIZE];
+	uint8_t tag[TEE_FS_HTREE_TAG_SIZE];
+	size_t block_num;
+	size_t block_size;
+	void *data;
+	TAILQ_ENTRY(block_cache_entry) link;
+};
+
+static TAILQ_HEAD(block_cache_head, block_cache_entry) block_cache =
+	TAILQ_HEAD_INITIALIZER(block_cache);
+static size_t block_cache_count;
+static struct mutex block_cache_mu = MUTEX_INITIALIZER;
+
+static bool block_cache_match(struct block_cache_entry *e,
+			      struct tee_fs_htree *ht, struct htree_node *node,
+			      size_t block_num)
+{
+	return e->block_num == block_num &&
+	       e->block_size == ht->stor->block_size &&
+	       !memcmp(e->tag, node->node.tag, sizeof(e->tag)) &&
+	       !memcmp(e->iv, node->node.iv, sizeof(e->iv)) &&
+	       !memcmp(e->enc_fek, ht->head.enc_fek, sizeof(e->enc_fek));
+}
+
+static bool block_cache_get(struct tee_fs_htree *ht, struct htree_node *node,
+			    size_t block_num, void *block)
+{
+	struct block_cache_entry *e = NULL;
+
+	mutex_lock(&block_cache_mu);
+	TAILQ_FOREACH(e, &block_cache, link) {
+		if (block_cache_match(e, ht, node, block_num)) {
+			memcpy(block, e->data, e->block_size);
+			TAILQ_REMOVE(&block_cache, e, link);
+			TAILQ_INSERT_HEAD(&block_cache, e, link);
+			break;
+		}
+	}
+	mutex_unlock(&block_cache_mu);
+
+	return e;
+}
+
+static struct block_cache_entry *block_cache_alloc(size_t block_size)
+{
+	struct block_cache_entry *e = calloc(1, sizeof(*e));
+
+	if (!e)
+		return NULL;
+	e->data = malloc(block_size);
+	if (!e->data) {
+		free(e);
+		return NULL;
+	}
+	e->block_size = block_size;
+
+	return e;
+}
+
+static void block_cache_put(struct tee_fs_htree *ht, struct htree_node *node,
+			    size_t block_num, const void *block)
+{
+	size_t block_size = ht->stor->block_size;
+	struct block_cache_entry *e = NULL;
+
+	mutex_lock(&block_cache_mu);
+
+	/* Replace a previous version of the block if there's one */
+	TAILQ_FOREACH(e, &block_cache, link)
+		if (e->block_num == block_num &&
+		    e->block_size == block_size &&
+		    !memcmp(e->enc_fek, ht->head.enc_fek, sizeof(e->enc_fek)))
+			break;
+
+	if (!e && block_cache_count < CFG_REE_FS_BLOCK_CACHE) {
+		e = block_cache_alloc(block_size);
+		if (e) {
+			TAILQ_INSERT_HEAD(&block_cache, e, link);
+			block_cache_count++;
+		}
+	}
+
+	/* Evict the least recently used entry */
+	if (!e) {
+		e = TAILQ_LAST(&block_cache, block_cache_head);
+		if (!e || e->block_size != block_size)
+			goto out;
+	}
+
+	memcpy(e->enc_fek, ht->head.enc_fek, sizeof(e->enc_fek));
+	memcpy(e->iv, node->node.iv, sizeof(e->iv));
+	memcpy(e->tag, node->node.tag, sizeof(e->tag));
+	e->block_num = block_num;
+	memcpy(e->data, block, block_size);
+	TAILQ_REMOVE(&block_cache, e, link);
+	TAILQ_INSERT_HEAD(&block_cache, e, link);
+out:
+	mutex_unlock(&block_cache_mu);
+}
+#else
+static bool block_cache_get(struct tee_fs_htree *ht __unused,
+			    struct htree_node *node __unused,
+			    size_t block_num __unused, void *block __unused)
+{
+	return false;
+}
+
+static void block_cache_put(struct tee_fs_htree *ht __unused,
+			    struct htree_node *node __unused,
+			    size_t block_num __unused,
+			    const void *block __unused)
+{
+}
+#endif /*CFG_REE_FS_BLOCK_CACHE*/
+
 static TEE_Result get_block_node(struct tee_fs_htree *ht, bool create,
 				 size_t block_num, struct htree_node **node)
 {
@@ -815,7 +1230,33 @@ static TEE_Result get_block_node(struct tee_fs_htree *ht, bool create,
 	return res;
 }
 
-TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
+void tee_fs_htree_batch_writes(struct tee_fs_htree *ht)
+{
+	if (!ht || ht->batch || !ht->stor->rpc_batch_init)
+		return;
+
+	ht->stor->rpc_batch_init(ht->stor_aux, &ht->block_batch);
+	ht->batch = &ht->block_batch;
+}
+
+TEE_Result tee_fs_htree_flush_writes(struct tee_fs_htree **ht_arg)
+{
+	struct tee_fs_htree *ht = *ht_arg;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!ht)
+		return TEE_ERROR_CORRUPT_OBJECT;
+	if (!ht->batch)
+		return TEE_SUCCESS;
+
+	ht->batch = NULL;
+	res = ht->stor->rpc_batch_flush(&ht->block_batch);
+	if (res != TEE_SUCCESS)
+		tee_fs_htree_close(ht_arg);
+	return res;
+}
+
+static TEE_Result htree_write_block(struct tee_fs_htree **ht_arg,
 				    size_t block_num, const void *block)
 {
 	struct tee_fs_htree *ht = *ht_arg;
@@ -837,9 +1278,16 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 		node->node.flags ^= HTREE_NODE_COMMITTED_BLOCK;
 
 	block_vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
-	res = ht->stor->rpc_write_init(ht->stor_aux, &op,
-				       TEE_FS_HTREE_TYPE_BLOCK, block_num,
-				       block_vers, &enc_block);
+	if (ht->batch)
+		res = ht->stor->rpc_batch_add(ht->stor_aux, ht->batch,
+					      TEE_FS_HTREE_TYPE_BLOCK,
+					      block_num, block_vers,
+					      &enc_block);
+	else
+		res = ht->stor->rpc_write_init(ht->stor_aux, &op,
+					       TEE_FS_HTREE_TYPE_BLOCK,
+					       block_num, block_vers,
+					       &enc_block);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -852,10 +1300,13 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = ht->stor->rpc_write_final(&op);
-	if (res != TEE_SUCCESS)
-		goto out;
+	if (!ht->batch) {
+		res = ht->stor->rpc_write_final(&op);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
 
+	block_cache_put(ht, node, block_num, block);
 	node->block_updated = true;
 	node->dirty = true;
 	ht->dirty = true;
@@ -865,7 +1316,20 @@ out:
 	return res;
 }
 
-TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
+TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
+				    size_t block_num, const void *block)
+{
+	struct perf_stats_snap snap = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	perf_stats_begin(&snap);
+	res = htree_write_block(ht_arg, block_num, block);
+	perf_stats_end(PERF_STATS_FS_HTREE_IO, &snap);
+
+	return res;
+}
+
+static TEE_Result htree_read_block(struct tee_fs_htree **ht_arg,
 				   size_t block_num, void *block)
 {
 	struct tee_fs_htree *ht = *ht_arg;
@@ -880,10 +1344,18 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
+	/* Queued writes must reach storage before anything is read back */
+	res = tee_fs_htree_flush_writes(ht_arg);
+	if (res != TEE_SUCCESS)
+		return res;
+
 	res = get_block_node(ht, false, block_num, &node);
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	if (block_cache_get(ht, node, block_num, block))
+		return TEE_SUCCESS;
+
 	block_vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
 	res = ht->stor->rpc_read_init(ht->stor_aux, &op,
 				      TEE_FS_HTREE_TYPE_BLOCK, block_num,
@@ -906,21 +1378,49 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 
 	res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
 				    ht->stor->block_size, block);
+	if (res == TEE_SUCCESS)
+		block_cache_put(ht, node, block_num, block);
 out:
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
 	return res;
 }
 
+TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
+				   size_t block_num, void *block)
+{
+	struct perf_stats_snap snap = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	perf_stats_begin(&snap);
+	res = htree_read_block(ht_arg, block_num, block);
+	perf_stats_end(PERF_STATS_FS_HTREE_IO, &snap);
+
+	return res;
+}
+
 TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 {
 	struct tee_fs_htree *ht = *ht_arg;
 	size_t node_id = BLOCK_NUM_TO_NODE_ID(block_num);
 	struct htree_node *node;
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
+	/* The nodes to remove and their parents must all be in memory */
+	if (IS_ENABLED(CFG_REE_FS_HTREE_LAZY_VERIFY) &&
+	    node_id < ht->imeta.max_node_id) {
+		res = load_subtree(ht, &ht->root, &ctx);
+		crypto_hash_free_ctx(ctx);
+		if (res != TEE_SUCCESS) {
+			tee_fs_htree_close(ht_arg);
+			return res;
+		}
+	}
+
 	while (node_id < ht->imeta.max_node_id) {
 		node = find_closest_node(ht, ht->imeta.max_node_id);
 		assert(node && node->id == ht->imeta.max_node_id);
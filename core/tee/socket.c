@@ -5,19 +5,90 @@
 
 #include <assert.h>
 #include <mm/mobj.h>
+#include <mm/vm.h>
+#include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/user_access.h>
+#include <kernel/user_mode_ctx.h>
 #include <optee_rpc_cmd.h>
 #include <pta_socket.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/tee_fs_rpc.h>
 
+/* Largest data area of a socket ring */
+#define SOCKET_RING_MAX_SIZE	(256 * 1024)
+
+/*
+ * struct socket_ring - Shared memory ring of a socket
+ * @handle:	socket handle
+ * @mobj:	non-secure shared memory of the ring
+ * @va:		address of the ring in the TA
+ * @len:	mapped size of the ring
+ * @link:	link in the rings of the session
+ */
+struct socket_ring {
+	uint32_t handle;
+	struct mobj *mobj;
+	vaddr_t va;
+	size_t len;
+	SLIST_ENTRY(socket_ring) link;
+};
+
+/*
+ * struct socket_session - Session of a TA with the socket PTA
+ * @instance_id:	TA instance id known by tee-supplicant
+ * @uctx:		the TA, its mappings outlive the session
+ * @rings:		socket rings set up by the TA
+ */
+struct socket_session {
+	uint32_t instance_id;
+	struct user_mode_ctx *uctx;
+	SLIST_HEAD(, socket_ring) rings;
+};
+
 static uint32_t get_instance_id(struct ts_session *sess)
 {
 	return sess->ctx->ops->get_instance_id(sess->ctx);
 }
 
-static TEE_Result socket_open(uint32_t instance_id, uint32_t param_types,
+static void free_ring(struct socket_session *ss, struct socket_ring *r)
+{
+	/* Unmap before the shared memory is handed back to normal world */
+	if (vm_unmap(ss->uctx, r->va, r->len))
+		panic("Can't unmap socket ring");
+	thread_rpc_free_global_payload(r->mobj);
+	free(r);
+}
+
+static void release_ring(struct socket_session *ss, uint32_t handle)
+{
+	struct socket_ring *r = NULL;
+
+	SLIST_FOREACH(r, &ss->rings, link) {
+		if (r->handle == handle) {
+			SLIST_REMOVE(&ss->rings, r, socket_ring, link);
+			free_ring(ss, r);
+			return;
+		}
+	}
+}
+
+static struct socket_ring *find_ring(struct socket_session *ss,
+				     uint32_t handle)
+{
+	struct socket_ring *r = NULL;
+
+	SLIST_FOREACH(r, &ss->rings, link)
+		if (r->handle == handle)
+			return r;
+
+	return NULL;
+}
+
+static TEE_Result socket_open(struct socket_session *ss,
+			      uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct thread_param tpm[4] = { };
@@ -46,7 +117,8 @@ static TEE_Result socket_open(uint32_t instance_id, uint32_t param_types,
 	if (res)
 		return res;
 
-	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_OPEN, instance_id, 0);
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_OPEN,
+				    ss->instance_id, 0);
 	tpm[1] = THREAD_PARAM_VALUE(IN,
 				    params[0].value.b, /* server port number */
 				    params[2].value.a, /* protocol */
@@ -61,10 +133,12 @@ static TEE_Result socket_open(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
-static TEE_Result socket_close(uint32_t instance_id, uint32_t param_types,
+static TEE_Result socket_close(struct socket_session *ss,
+			       uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct thread_param tpm = { };
+	TEE_Result res = TEE_SUCCESS;
 	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
 					  TEE_PARAM_TYPE_NONE,
 					  TEE_PARAM_TYPE_NONE,
@@ -76,13 +150,18 @@ static TEE_Result socket_close(uint32_t instance_id, uint32_t param_types,
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
-	tpm = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_CLOSE, instance_id,
+	tpm = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_CLOSE, ss->instance_id,
 				 params[0].value.a);
 
-	return thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 1, &tpm);
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 1, &tpm);
+	/* tee-supplicant doesn't use the ring once the socket is closed */
+	release_ring(ss, params[0].value.a);
+
+	return res;
 }
 
-static TEE_Result socket_send(uint32_t instance_id, uint32_t param_types,
+static TEE_Result socket_send(struct socket_session *ss,
+			      uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct thread_param tpm[3] = { };
@@ -111,7 +190,8 @@ static TEE_Result socket_send(uint32_t instance_id, uint32_t param_types,
 	if (res)
 		return res;
 
-	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_SEND, instance_id,
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_SEND,
+				    ss->instance_id,
 				    params[0].value.a /* handle */);
 	tpm[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, params[1].memref.size);
 	tpm[2] = THREAD_PARAM_VALUE(INOUT, params[0].value.b, /* timeout */
@@ -123,7 +203,8 @@ static TEE_Result socket_send(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
-static TEE_Result socket_recv(uint32_t instance_id, uint32_t param_types,
+static TEE_Result socket_recv(struct socket_session *ss,
+			      uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct thread_param tpm[3] = { };
@@ -149,7 +230,8 @@ static TEE_Result socket_recv(uint32_t instance_id, uint32_t param_types,
 			return TEE_ERROR_OUT_OF_MEMORY;
 	}
 
-	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_RECV, instance_id,
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_RECV,
+				    ss->instance_id,
 				    params[0].value.a /* handle */);
 	tpm[1] = THREAD_PARAM_MEMREF(OUT, mobj, 0, params[1].memref.size);
 	tpm[2] = THREAD_PARAM_VALUE(IN, params[0].value.b /* timeout */, 0, 0);
@@ -170,7 +252,8 @@ static TEE_Result socket_recv(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
-static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
+static TEE_Result socket_ioctl(struct socket_session *ss,
+			       uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct thread_param tpm[3] = { };
@@ -199,7 +282,8 @@ static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
 	if (res)
 		return res;
 
-	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_IOCTL, instance_id,
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_IOCTL,
+				    ss->instance_id,
 				    params[0].value.a /* handle */);
 	tpm[1] = THREAD_PARAM_MEMREF(INOUT, mobj, 0, params[1].memref.size);
 	tpm[2] = THREAD_PARAM_VALUE(IN, params[0].value.b /* ioctl command */,
@@ -220,7 +304,112 @@ static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
-typedef TEE_Result (*ta_func)(uint32_t instance_id, uint32_t param_types,
+static TEE_Result socket_ring_setup(struct socket_session *ss,
+				    uint32_t param_types,
+				    TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_PRW;
+	struct pta_socket_ring *hdr = NULL;
+	uint32_t handle = params[0].value.a;
+	uint32_t size = params[0].value.b;
+	struct thread_param tpm[2] = { };
+	struct socket_ring *r = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!IS_POWER_OF_TWO(size) || size > SOCKET_RING_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (find_ring(ss, handle))
+		return TEE_ERROR_BAD_STATE;
+
+	r = calloc(1, sizeof(*r));
+	if (!r)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	r->handle = handle;
+	r->len = ROUNDUP(sizeof(*hdr) + 2 * size, SMALL_PAGE_SIZE);
+
+	r->mobj = thread_rpc_alloc_global_payload(r->len);
+	if (!r->mobj) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err_free;
+	}
+	hdr = mobj_get_va(r->mobj, 0, r->len);
+	if (!hdr) {
+		res = TEE_ERROR_GENERIC;
+		goto err_free_shm;
+	}
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->size = size;
+
+	res = vm_map(ss->uctx, &r->va, r->len, prot, 0, r->mobj, 0);
+	if (res)
+		goto err_free_shm;
+
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_RING_SETUP,
+				    ss->instance_id, handle);
+	tpm[1] = THREAD_PARAM_MEMREF(IN, r->mobj, 0, r->len);
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 2, tpm);
+	if (res) {
+		free_ring(ss, r);
+		return res;
+	}
+
+	SLIST_INSERT_HEAD(&ss->rings, r, link);
+	reg_pair_from_64(r->va, &params[1].value.a, &params[1].value.b);
+
+	return TEE_SUCCESS;
+
+err_free_shm:
+	thread_rpc_free_global_payload(r->mobj);
+err_free:
+	free(r);
+	return res;
+}
+
+static TEE_Result socket_ring_kick(struct socket_session *ss,
+				   uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct thread_param tpm[2] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!find_ring(ss, params[0].value.a))
+		return TEE_ERROR_BAD_STATE;
+
+	/* All data queued in the ring is moved with a single RPC */
+	tpm[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_RING_KICK,
+				    ss->instance_id,
+				    params[0].value.a /* handle */);
+	tpm[1] = THREAD_PARAM_VALUE(INOUT, params[0].value.b, /* timeout */
+				    0, 0);
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 2, tpm);
+	params[1].value.a = tpm[1].u.value.b; /* readiness events */
+
+	return res;
+}
+
+typedef TEE_Result (*ta_func)(struct socket_session *ss,
+			      uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS]);
 
 static const ta_func ta_funcs[] = {
@@ -229,6 +418,8 @@ static const ta_func ta_funcs[] = {
 	[PTA_SOCKET_SEND] = socket_send,
 	[PTA_SOCKET_RECV] = socket_recv,
 	[PTA_SOCKET_IOCTL] = socket_ioctl,
+	[PTA_SOCKET_RING_SETUP] = socket_ring_setup,
+	[PTA_SOCKET_RING_KICK] = socket_ring_kick,
 };
 
 /*
@@ -240,35 +431,51 @@ static TEE_Result pta_socket_open_session(uint32_t param_types __unused,
 			void **sess_ctx)
 {
 	struct ts_session *s = ts_get_calling_session();
+	struct socket_session *ss = NULL;
 
 	/* Check that we're called from a TA */
 	if (!s || !is_user_ta_ctx(s->ctx))
 		return TEE_ERROR_ACCESS_DENIED;
 
-	*sess_ctx = (void *)(vaddr_t)get_instance_id(s);
+	ss = calloc(1, sizeof(*ss));
+	if (!ss)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	ss->instance_id = get_instance_id(s);
+	ss->uctx = to_user_mode_ctx(s->ctx);
+	SLIST_INIT(&ss->rings);
+
+	*sess_ctx = ss;
 
 	return TEE_SUCCESS;
 }
 
 static void pta_socket_close_session(void *sess_ctx)
 {
+	struct socket_session *ss = sess_ctx;
+	struct socket_ring *r = NULL;
 	TEE_Result res;
 	struct thread_param tpm = {
 		.attr = THREAD_PARAM_ATTR_VALUE_IN, .u.value = {
-			.a = OPTEE_RPC_SOCKET_CLOSE_ALL, .b = (vaddr_t)sess_ctx,
+			.a = OPTEE_RPC_SOCKET_CLOSE_ALL, .b = ss->instance_id,
 		},
 	};
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 1, &tpm);
 	if (res != TEE_SUCCESS)
 		DMSG("OPTEE_RPC_SOCKET_CLOSE_ALL failed: %#" PRIx32, res);
+
+	while ((r = SLIST_FIRST(&ss->rings))) {
+		SLIST_REMOVE_HEAD(&ss->rings, link);
+		free_ring(ss, r);
+	}
+	free(ss);
 }
 
 static TEE_Result pta_socket_invoke_command(void *sess_ctx, uint32_t cmd_id,
 			uint32_t param_types, TEE_Param params[TEE_NUM_PARAMS])
 {
 	if (cmd_id < ARRAY_SIZE(ta_funcs) && ta_funcs[cmd_id])
-		return ta_funcs[cmd_id]((vaddr_t)sess_ctx, param_types, params);
+		return ta_funcs[cmd_id](sess_ctx, param_types, params);
 
 	return TEE_ERROR_NOT_IMPLEMENTED;
 }
@@ -29,6 +29,7 @@ ifeq ($(CFG_WITH_USER_TA),y)
 srcs-y += tee_obj.c
 srcs-y += tee_svc.c
 srcs-y += tee_svc_cryp.c
+srcs-$(CFG_CRYPTO_CTX_POOL) += tee_cryp_ctx_pool.c
 srcs-y += tee_svc_storage.c
 cppflags-tee_svc.c-y += -DTEE_IMPL_VERSION=$(TEE_IMPL_VERSION)
 srcs-y += tee_time_generic.c
@@ -8,11 +8,13 @@
 #include <crypto/crypto.h>
 #include <kernel/mutex.h>
 #include <kernel/thread.h>
+#include <kernel/ts_store.h>
 #include <kernel/user_access.h>
 #include <mm/mobj.h>
 #include <optee_rpc_cmd.h>
 #include <stdio.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee_api_defines_extensions.h>
 #include <tee/tadb.h>
 #include <tee/tee_fs.h>
@@ -78,6 +80,15 @@ static struct tee_tadb_dir *tadb_db;
 static unsigned int tadb_db_refc;
 static struct mutex tadb_mutex = MUTEX_INITIALIZER;
 
+/*
+ * UUID of each entry of the TA database, built on first lookup and kept
+ * up to date by write_ent() so a lookup reads a single entry. It outlives
+ * @tadb_db since ta.db is only written from here.
+ */
+static TEE_UUID *tadb_index;
+static size_t tadb_index_count;
+static bool tadb_indexed;
+
 static void file_num_to_str(char *buf, size_t blen, uint32_t file_number)
 {
 	int rc __maybe_unused = 0;
@@ -202,12 +213,66 @@ static TEE_Result read_ent(struct tee_tadb_dir *db, size_t idx,
 	return res;
 }
 
+static void drop_index(void)
+{
+	free(tadb_index);
+	tadb_index = NULL;
+	tadb_index_count = 0;
+	tadb_indexed = false;
+}
+
+static TEE_Result index_ent(size_t idx, const TEE_UUID *uuid)
+{
+	TEE_UUID *p = NULL;
+
+	if (idx >= tadb_index_count) {
+		p = realloc(tadb_index, (idx + 1) * sizeof(*p));
+		if (!p)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		memset(p + tadb_index_count, 0,
+		       (idx + 1 - tadb_index_count) * sizeof(*p));
+		tadb_index = p;
+		tadb_index_count = idx + 1;
+	}
+	tadb_index[idx] = *uuid;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result write_ent(struct tee_tadb_dir *db, size_t idx,
 			    const struct tadb_entry *entry)
 {
 	const size_t l = sizeof(*entry);
+	TEE_Result res = db->ops->write(db->fh, idx * l, entry, NULL, l);
+
+	if (tadb_indexed && (res || index_ent(idx, &entry->prop.uuid)))
+		drop_index();
 
-	return db->ops->write(db->fh, idx * l, entry, NULL, l);
+	return res;
+}
+
+static TEE_Result build_index(struct tee_tadb_dir *db)
+{
+	struct tadb_entry entry = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t idx = 0;
+
+	for (idx = 0;; idx++) {
+		res = read_ent(db, idx, &entry);
+		if (!res)
+			res = index_ent(idx, &entry.prop.uuid);
+		if (res)
+			break;
+	}
+	memzero_explicit(&entry, sizeof(entry));
+
+	if (res != TEE_ERROR_ITEM_NOT_FOUND) {
+		drop_index();
+		return res;
+	}
+
+	tadb_indexed = true;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tadb_open(struct tee_tadb_dir **db_ret)
@@ -492,12 +557,51 @@ void tee_tadb_ta_close_and_delete(struct tee_tadb_ta_write *ta)
 	free(ta);
 }
 
+/* Look up @uuid in the index, return false if it can't be trusted */
+static bool find_indexed_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
+			     size_t *idx_ret, struct tadb_entry *entry_ret,
+			     TEE_Result *res)
+{
+	struct tadb_entry entry = { };
+	size_t idx = 0;
+
+	if (!tadb_indexed && build_index(db))
+		return false;
+
+	for (idx = 0; idx < tadb_index_count; idx++)
+		if (!memcmp(tadb_index + idx, uuid, sizeof(*uuid)))
+			break;
+
+	*idx_ret = idx;
+	if (idx == tadb_index_count) {
+		*res = TEE_ERROR_ITEM_NOT_FOUND;
+		return true;
+	}
+
+	/* The entry must still be what the index says */
+	*res = read_ent(db, idx, &entry);
+	if (*res || memcmp(&entry.prop.uuid, uuid, sizeof(*uuid))) {
+		memzero_explicit(&entry, sizeof(entry));
+		drop_index();
+		return false;
+	}
+
+	if (entry_ret)
+		*entry_ret = entry;
+	memzero_explicit(&entry, sizeof(entry));
+
+	return true;
+}
+
 static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 			   size_t *idx_ret, struct tadb_entry *entry_ret)
 {
 	TEE_Result res;
 	size_t idx;
 
+	if (find_indexed_ent(db, uuid, idx_ret, entry_ret, &res))
+		return res;
+
 	/*
 	 * Search for the provided uuid, if it's found return the index it
 	 * has together with TEE_SUCCESS.
@@ -579,6 +683,8 @@ TEE_Result tee_tadb_ta_close_and_commit(struct tee_tadb_ta_write *ta)
 		clear_file(ta->db, old_ent.file_number);
 	mutex_unlock(&tadb_mutex);
 
+	ts_store_flush_ta_cache();
+
 	crypto_authenc_final(ta->ctx);
 	crypto_authenc_free_ctx(ta->ctx);
 	tadb_put(ta->db);
@@ -647,9 +753,10 @@ TEE_Result tee_tadb_ta_open(const TEE_UUID *uuid,
 	if (res)
 		goto err_free; /* Mustn't call tadb_put() */
 
-	mutex_read_lock(&tadb_mutex);
+	/* Not a read lock, the lookup may build the index */
+	mutex_lock(&tadb_mutex);
 	res = find_ent(ta->db, uuid, &idx, &ta->entry);
-	mutex_read_unlock(&tadb_mutex);
+	mutex_unlock(&tadb_mutex);
 	if (res)
 		goto err;
 
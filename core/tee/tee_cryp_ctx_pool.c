@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <kernel/mutex.h>
+#include <tee/tee_cryp_ctx_pool.h>
+#include <tee_api_defines.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+/*
+ * Contexts released by cryp_state_free() are kept in small per
+ * algorithm pools instead of going back to the heap, TAs doing
+ * TEE_AllocateOperation()/TEE_FreeOperation() for each message would
+ * otherwise allocate and free the same context over and over.
+ *
+ * Before a context is cached its state is overwritten through
+ * copy_state() from a pristine, never initialized, context of the same
+ * algorithm. That keeps key material from lingering in the pool. Even
+ * if an implementation doesn't reset everything that way a reused context
+ * can't leak anything: the syscalls refuse any operation on a state
+ * until it has been initialized with the key of the new owner.
+ */
+
+struct ctx_pool {
+	uint32_t algo;
+	void *pristine;
+	size_t count;
+	void *ctx[CFG_CRYPTO_CTX_POOL_DEPTH];
+};
+
+static struct ctx_pool pools[CFG_CRYPTO_CTX_POOL_ALGOS];
+static struct mutex pool_mu = MUTEX_INITIALIZER;
+static uint64_t pool_hits;
+static uint64_t pool_misses;
+
+static bool algo_is_pooled(uint32_t algo)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_CIPHER:
+	case TEE_OPERATION_AE:
+	case TEE_OPERATION_MAC:
+	case TEE_OPERATION_DIGEST:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static TEE_Result ctx_alloc(uint32_t algo, void **ctx)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_CIPHER:
+		return crypto_cipher_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_AE:
+		return crypto_authenc_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_MAC:
+		return crypto_mac_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_DIGEST:
+		return crypto_hash_alloc_ctx(ctx, algo);
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
+static void ctx_reset(uint32_t algo, void *ctx, void *pristine)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_CIPHER:
+		crypto_cipher_copy_state(ctx, pristine);
+		break;
+	case TEE_OPERATION_AE:
+		crypto_authenc_copy_state(ctx, pristine);
+		break;
+	case TEE_OPERATION_MAC:
+		crypto_mac_copy_state(ctx, pristine);
+		break;
+	case TEE_OPERATION_DIGEST:
+		crypto_hash_copy_state(ctx, pristine);
+		break;
+	default:
+		break;
+	}
+}
+
+static struct ctx_pool *find_pool(uint32_t algo)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(pools); n++)
+		if (pools[n].pristine && pools[n].algo == algo)
+			return pools + n;
+
+	return NULL;
+}
+
+/* Returns the pool of @algo, claiming a free slot for it if needed */
+static struct ctx_pool *claim_pool(uint32_t algo)
+{
+	struct ctx_pool *pool = find_pool(algo);
+	size_t n = 0;
+
+	if (pool)
+		return pool;
+
+	for (n = 0; n < ARRAY_SIZE(pools); n++) {
+		if (pools[n].pristine)
+			continue;
+		if (ctx_alloc(algo, &pools[n].pristine))
+			return NULL;
+		pools[n].algo = algo;
+		return pools + n;
+	}
+
+	return NULL;
+}
+
+void *tee_cryp_ctx_pool_get(uint32_t algo)
+{
+	struct ctx_pool *pool = NULL;
+	void *ctx = NULL;
+
+	if (!algo_is_pooled(algo))
+		return NULL;
+
+	mutex_lock(&pool_mu);
+
+	pool = find_pool(algo);
+	if (pool && pool->count) {
+		pool->count--;
+		ctx = pool->ctx[pool->count];
+		pool->ctx[pool->count] = NULL;
+		pool_hits++;
+	} else {
+		pool_misses++;
+	}
+
+	mutex_unlock(&pool_mu);
+
+	return ctx;
+}
+
+bool tee_cryp_ctx_pool_put(uint32_t algo, void *ctx)
+{
+	struct ctx_pool *pool = NULL;
+	bool taken = false;
+
+	if (!ctx || !algo_is_pooled(algo))
+		return false;
+
+	mutex_lock(&pool_mu);
+
+	pool = claim_pool(algo);
+	if (pool && pool->count < ARRAY_SIZE(pool->ctx)) {
+		ctx_reset(algo, ctx, pool->pristine);
+		pool->ctx[pool->count] = ctx;
+		pool->count++;
+		taken = true;
+	}
+
+	mutex_unlock(&pool_mu);
+
+	return taken;
+}
+
+void tee_cryp_ctx_pool_get_stats(uint64_t *hits, uint64_t *misses)
+{
+	mutex_lock(&pool_mu);
+	*hits = pool_hits;
+	*misses = pool_misses;
+	mutex_unlock(&pool_mu);
+}
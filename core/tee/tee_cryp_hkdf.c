@@ -70,6 +70,7 @@ static TEE_Result hkdf_expand(uint32_t hash_id, const uint8_t *prk,
 	size_t tn_len, hash_len, i, n, where;
 	TEE_Result res = TEE_SUCCESS;
 	void *ctx = NULL;
+	void *keyed_ctx = NULL;
 	uint32_t hash_algo = TEE_ALG_HASH_ALGO(hash_id);
 	uint32_t hmac_algo = TEE_ALG_HMAC_ALGO(hash_id);
 
@@ -89,6 +90,17 @@ static TEE_Result hkdf_expand(uint32_t hash_id, const uint8_t *prk,
 	if (res)
 		goto out;
 
+	/*
+	 * All blocks are keyed with PRK, the keyed state is saved once and
+	 * restored for each block.
+	 */
+	res = crypto_mac_alloc_ctx(&keyed_ctx, hmac_algo);
+	if (res)
+		goto out;
+	res = crypto_mac_init(keyed_ctx, prk, prk_len);
+	if (res != TEE_SUCCESS)
+		goto out;
+
 	/* N = ceil(L/HashLen) */
 	n = okm_len / hash_len;
 	if ((okm_len % hash_len) != 0)
@@ -115,9 +127,7 @@ static TEE_Result hkdf_expand(uint32_t hash_id, const uint8_t *prk,
 	for (i = 1; i <= n; i++) {
 		uint8_t c = i;
 
-		res = crypto_mac_init(ctx, prk, prk_len);
-		if (res != TEE_SUCCESS)
-			goto out;
+		crypto_mac_copy_state(ctx, keyed_ctx);
 		res = crypto_mac_update(ctx, tn, tn_len);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -137,6 +147,7 @@ static TEE_Result hkdf_expand(uint32_t hash_id, const uint8_t *prk,
 	}
 
 out:
+	crypto_mac_free_ctx(keyed_ctx);
 	crypto_mac_free_ctx(ctx);
 	return res;
 }
@@ -4,16 +4,23 @@
  */
 
 #include <crypto/crypto.h>
+#include <kernel/thread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <tee/tee_cryp_pbkdf2.h>
 #include <tee/tee_cryp_utl.h>
 #include <utee_defines.h>
 
+/*
+ * @keyed_ctx holds the state of HMAC right after it was initialized with
+ * the password, it's copied into @ctx instead of deriving the padded keys
+ * again for each iteration.
+ */
 struct hmac_parms {
 	uint32_t algo;
 	size_t hash_len;
 	void *ctx;
+	void *keyed_ctx;
 };
 
 struct pbkdf2_parms {
@@ -34,9 +41,8 @@ static TEE_Result pbkdf2_f(uint8_t *out, size_t len, uint32_t idx,
 
 	memset(out, 0, len);
 	for (i = 1; i <= p->iteration_count; i++) {
-		res = crypto_mac_init(h->ctx, p->password, p->password_len);
-		if (res != TEE_SUCCESS)
-			return res;
+		thread_yield_point();
+		crypto_mac_copy_state(h->ctx, h->keyed_ctx);
 
 		if (i == 1) {
 			if (p->salt && p->salt_len) {
@@ -88,6 +94,12 @@ TEE_Result tee_cryp_pbkdf2(uint32_t hash_id, const uint8_t *password,
 	res = crypto_mac_alloc_ctx(&hmac_parms.ctx, hmac_parms.algo);
 	if (res != TEE_SUCCESS)
 		return res;
+	res = crypto_mac_alloc_ctx(&hmac_parms.keyed_ctx, hmac_parms.algo);
+	if (res != TEE_SUCCESS)
+		goto out;
+	res = crypto_mac_init(hmac_parms.keyed_ctx, password, password_len);
+	if (res != TEE_SUCCESS)
+		goto out;
 
 	pbkdf2_parms.password = password;
 	pbkdf2_parms.password_len = password_len;
@@ -109,6 +121,7 @@ TEE_Result tee_cryp_pbkdf2(uint32_t hash_id, const uint8_t *password,
 		res = pbkdf2_f(out, r, i, &hmac_parms, &pbkdf2_parms);
 
 out:
+	crypto_mac_free_ctx(hmac_parms.keyed_ctx);
 	crypto_mac_free_ctx(hmac_parms.ctx);
 	return res;
 }
@@ -19,12 +19,16 @@
 #include <compiler.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <kernel/delay.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/mutex.h>
 #include <kernel/tee_common_otp.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_ext.h>
+#include <sys/queue.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/tee_fs_key_manager.h>
 #include <trace.h>
@@ -37,6 +41,26 @@ struct tee_fs_ssk {
 
 static struct tee_fs_ssk tee_fs_ssk;
 
+#ifdef CFG_CORE_THREAD_TIME_STATS
+/* Only updated by the thread itself */
+static uint64_t fs_crypto_ticks[CFG_NUM_THREADS];
+
+uint64_t tee_fs_crypto_time_begin(void)
+{
+	return delay_cnt_read();
+}
+
+void tee_fs_crypto_time_end(uint64_t begin)
+{
+	fs_crypto_ticks[thread_get_id()] += delay_cnt_read() - begin;
+}
+
+uint64_t tee_fs_crypto_ticks(void)
+{
+	return fs_crypto_ticks[thread_get_id()];
+}
+#endif
+
 static TEE_Result do_hmac(void *out_key, size_t out_key_size,
 			  const void *in_key, size_t in_key_size,
 			  const void *message, size_t message_size)
@@ -70,6 +94,215 @@ exit:
 	return res;
 }
 
+#if CFG_TEE_FS_KEY_CACHE
+/*
+ * struct key_cache_entry - a derived or unwrapped key
+ * @uuid:	UUID of the TA owning the key
+ * @has_uuid:	false for the key used when no UUID is supplied
+ * @enc_fek:	encrypted file encryption key, unused for a TSK entry
+ * @key:		the TSK, or the plain file encryption key matching @enc_fek
+ * @link:	link in a key cache, most recently used first
+ *
+ * The SSK never changes once derived so the TSK of a TA and the plain
+ * FEK of an encrypted FEK are the same for the lifetime of the TEE.
+ * Entries are only wiped when evicted.
+ */
+struct key_cache_entry {
+	TEE_UUID uuid;
+	bool has_uuid;
+	uint8_t enc_fek[TEE_FS_KM_FEK_SIZE];
+	uint8_t key[TEE_FS_KM_TSK_SIZE];
+	TAILQ_ENTRY(key_cache_entry) link;
+};
+
+TAILQ_HEAD(key_cache_head, key_cache_entry);
+
+struct key_cache {
+	struct key_cache_head entries;
+	size_t count;
+};
+
+static struct key_cache tsk_cache = {
+	.entries = TAILQ_HEAD_INITIALIZER(tsk_cache.entries),
+};
+static struct key_cache fek_cache = {
+	.entries = TAILQ_HEAD_INITIALIZER(fek_cache.entries),
+};
+static struct mutex key_cache_mu = MUTEX_INITIALIZER;
+
+static bool key_cache_uuid_match(struct key_cache_entry *e,
+				 const TEE_UUID *uuid)
+{
+	if (!uuid)
+		return !e->has_uuid;
+	return e->has_uuid && !memcmp(&e->uuid, uuid, sizeof(*uuid));
+}
+
+/* Must be called with key_cache_mu held */
+static struct key_cache_entry *key_cache_new(struct key_cache *kc,
+					     const TEE_UUID *uuid)
+{
+	struct key_cache_entry *e = NULL;
+
+	if (kc->count < CFG_TEE_FS_KEY_CACHE) {
+		e = calloc(1, sizeof(*e));
+		if (e)
+			kc->count++;
+	}
+	if (!e) {
+		/* Recycle the least recently used entry */
+		e = TAILQ_LAST(&kc->entries, key_cache_head);
+		if (!e)
+			return NULL;
+		TAILQ_REMOVE(&kc->entries, e, link);
+		memzero_explicit(e, sizeof(*e));
+	}
+
+	if (uuid) {
+		e->uuid = *uuid;
+		e->has_uuid = true;
+	}
+	TAILQ_INSERT_HEAD(&kc->entries, e, link);
+
+	return e;
+}
+
+static bool tsk_cache_get(const TEE_UUID *uuid, uint8_t *tsk)
+{
+	struct key_cache_entry *e = NULL;
+
+	mutex_lock(&key_cache_mu);
+	TAILQ_FOREACH(e, &tsk_cache.entries, link) {
+		if (key_cache_uuid_match(e, uuid)) {
+			memcpy(tsk, e->key, TEE_FS_KM_TSK_SIZE);
+			TAILQ_REMOVE(&tsk_cache.entries, e, link);
+			TAILQ_INSERT_HEAD(&tsk_cache.entries, e, link);
+			break;
+		}
+	}
+	mutex_unlock(&key_cache_mu);
+
+	return e;
+}
+
+static void tsk_cache_put(const TEE_UUID *uuid, const uint8_t *tsk)
+{
+	struct key_cache_entry *e = NULL;
+
+	mutex_lock(&key_cache_mu);
+	e = key_cache_new(&tsk_cache, uuid);
+	if (e)
+		memcpy(e->key, tsk, TEE_FS_KM_TSK_SIZE);
+	mutex_unlock(&key_cache_mu);
+}
+
+/*
+ * The FEK is wrapped with AES ECB so an entry holding both the encrypted
+ * and the plain FEK serves both directions.
+ */
+static bool fek_cache_get(const TEE_UUID *uuid, TEE_OperationMode mode,
+			  const uint8_t *in_key, uint8_t *out_key)
+{
+	struct key_cache_entry *e = NULL;
+	const uint8_t *in = NULL;
+	const uint8_t *out = NULL;
+
+	mutex_lock(&key_cache_mu);
+	TAILQ_FOREACH(e, &fek_cache.entries, link) {
+		if (mode == TEE_MODE_DECRYPT) {
+			in = e->enc_fek;
+			out = e->key;
+		} else {
+			in = e->key;
+			out = e->enc_fek;
+		}
+		if (key_cache_uuid_match(e, uuid) &&
+		    !consttime_memcmp(in, in_key, TEE_FS_KM_FEK_SIZE)) {
+			memcpy(out_key, out, TEE_FS_KM_FEK_SIZE);
+			TAILQ_REMOVE(&fek_cache.entries, e, link);
+			TAILQ_INSERT_HEAD(&fek_cache.entries, e, link);
+			break;
+		}
+	}
+	mutex_unlock(&key_cache_mu);
+
+	return e;
+}
+
+static void fek_cache_put(const TEE_UUID *uuid, TEE_OperationMode mode,
+			  const uint8_t *in_key, const uint8_t *out_key)
+{
+	struct key_cache_entry *e = NULL;
+
+	COMPILE_TIME_ASSERT(TEE_FS_KM_FEK_SIZE <= sizeof(e->key));
+
+	mutex_lock(&key_cache_mu);
+	e = key_cache_new(&fek_cache, uuid);
+	if (e) {
+		if (mode == TEE_MODE_DECRYPT) {
+			memcpy(e->enc_fek, in_key, TEE_FS_KM_FEK_SIZE);
+			memcpy(e->key, out_key, TEE_FS_KM_FEK_SIZE);
+		} else {
+			memcpy(e->key, in_key, TEE_FS_KM_FEK_SIZE);
+			memcpy(e->enc_fek, out_key, TEE_FS_KM_FEK_SIZE);
+		}
+	}
+	mutex_unlock(&key_cache_mu);
+}
+#else
+static bool tsk_cache_get(const TEE_UUID *uuid __unused,
+			  uint8_t *tsk __unused)
+{
+	return false;
+}
+
+static void tsk_cache_put(const TEE_UUID *uuid __unused,
+			  const uint8_t *tsk __unused)
+{
+}
+
+static bool fek_cache_get(const TEE_UUID *uuid __unused,
+			  TEE_OperationMode mode __unused,
+			  const uint8_t *in_key __unused,
+			  uint8_t *out_key __unused)
+{
+	return false;
+}
+
+static void fek_cache_put(const TEE_UUID *uuid __unused,
+			  TEE_OperationMode mode __unused,
+			  const uint8_t *in_key __unused,
+			  const uint8_t *out_key __unused)
+{
+}
+#endif /*CFG_TEE_FS_KEY_CACHE*/
+
+static TEE_Result derive_tsk(const TEE_UUID *uuid, uint8_t *tsk)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (tsk_cache_get(uuid, tsk))
+		return TEE_SUCCESS;
+
+	if (uuid) {
+		res = do_hmac(tsk, TEE_FS_KM_TSK_SIZE, tee_fs_ssk.key,
+			      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
+	} else {
+		/*
+		 * Pick something of a different size than TEE_UUID to
+		 * guarantee that there's never a conflict.
+		 */
+		uint8_t dummy[1] = { 0 };
+
+		res = do_hmac(tsk, TEE_FS_KM_TSK_SIZE, tee_fs_ssk.key,
+			      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
+	}
+	if (!res)
+		tsk_cache_put(uuid, tsk);
+
+	return res;
+}
+
 TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 			    const uint8_t *in_key, size_t size,
 			    uint8_t *out_key)
@@ -88,27 +321,16 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 	if (tee_fs_ssk.is_init == 0)
 		return TEE_ERROR_GENERIC;
 
-	if (uuid) {
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
-		if (res != TEE_SUCCESS)
-			return res;
-	} else {
-		/*
-		 * Pick something of a different size than TEE_UUID to
-		 * guarantee that there's never a conflict.
-		 */
-		uint8_t dummy[1] = { 0 };
+	if (fek_cache_get(uuid, mode, in_key, out_key))
+		return TEE_SUCCESS;
 
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
+	res = derive_tsk(uuid, tsk);
+	if (res != TEE_SUCCESS)
+		goto exit;
 
 	res = crypto_cipher_alloc_ctx(&ctx, TEE_FS_KM_ENC_FEK_ALG);
 	if (res != TEE_SUCCESS)
-		return res;
+		goto exit;
 
 	res = crypto_cipher_init(ctx, mode, tsk, sizeof(tsk), NULL, 0, NULL, 0);
 	if (res != TEE_SUCCESS)
@@ -120,6 +342,7 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 
 	crypto_cipher_final(ctx);
 
+	fek_cache_put(uuid, mode, in_key, dst_key);
 	memcpy(out_key, dst_key, sizeof(dst_key));
 
 exit:
@@ -226,9 +449,9 @@ static TEE_Result essiv(uint8_t iv[TEE_AES_BLOCK_SIZE],
 /*
  * Encryption/decryption of RPMB FS file data. This is AES CBC with ESSIV.
  */
-TEE_Result tee_fs_crypt_block(const TEE_UUID *uuid, uint8_t *out,
-			      const uint8_t *in, size_t size,
-			      uint16_t blk_idx, const uint8_t *encrypted_fek,
+static TEE_Result crypt_block(const TEE_UUID *uuid, uint8_t *out,
+			      const uint8_t *in, size_t size, uint16_t blk_idx,
+			      const uint8_t *encrypted_fek,
 			      TEE_OperationMode mode)
 {
 	TEE_Result res;
@@ -273,4 +496,18 @@ wipe:
 	return res;
 }
 
+TEE_Result tee_fs_crypt_block(const TEE_UUID *uuid, uint8_t *out,
+			      const uint8_t *in, size_t size,
+			      uint16_t blk_idx, const uint8_t *encrypted_fek,
+			      TEE_OperationMode mode)
+{
+	uint64_t begin = tee_fs_crypto_time_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypt_block(uuid, out, in, size, blk_idx, encrypted_fek, mode);
+	tee_fs_crypto_time_end(begin);
+
+	return res;
+}
+
 service_init_late(tee_fs_init_key_manager);
@@ -9,6 +9,7 @@
 #include <mm/core_memprot.h>
 #include <optee_rpc_cmd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tee/fs_dirfile.h>
 #include <tee/tee_fs.h>
 #include <tee/tee_fs_rpc.h>
@@ -177,6 +178,127 @@ TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op)
 	return operation_commit(op);
 }
 
+#ifdef CFG_REE_FS_RPC_BATCH
+/* Room for 8 REE FS data blocks with their headers */
+#define BATCH_SIZE	(8 * BIT(CFG_REE_FS_BLOCK_SHIFT) + SMALL_PAGE_SIZE)
+
+struct batch_hdr {
+	uint64_t offset;
+	uint32_t len;
+	uint32_t pad;
+};
+
+/* Cleared the first time normal world rejects OPTEE_RPC_FS_WRITEV */
+static bool writev_supported = true;
+
+void tee_fs_rpc_batch_init(struct tee_fs_rpc_batch *b, uint32_t id, int fd)
+{
+	*b = (struct tee_fs_rpc_batch){ .id = id, .fd = fd };
+}
+
+static TEE_Result batch_flush_one_by_one(struct tee_fs_rpc_batch *b)
+{
+	struct tee_fs_rpc_operation op = { };
+	TEE_Result res = TEE_SUCCESS;
+	struct batch_hdr hdr = { };
+	size_t pos = 0;
+	size_t n = 0;
+	void *data = NULL;
+
+	for (n = 0; n < b->count; n++) {
+		memcpy(&hdr, b->buf + pos, sizeof(hdr));
+		pos += sizeof(hdr);
+
+		/* Uses a different shared memory cache entry than b->buf */
+		res = tee_fs_rpc_write_init(&op, b->id, b->fd, hdr.offset,
+					    hdr.len, &data);
+		if (res)
+			return res;
+		memcpy(data, b->buf + pos, hdr.len);
+		res = tee_fs_rpc_write_final(&op);
+		if (res)
+			return res;
+
+		pos += ROUNDUP(hdr.len, sizeof(uint64_t));
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_fs_rpc_batch_flush(struct tee_fs_rpc_batch *b)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_fs_rpc_operation op = { };
+
+	if (!b->count)
+		return TEE_SUCCESS;
+
+	if (writev_supported) {
+		op = (struct tee_fs_rpc_operation){
+			.id = b->id, .num_params = 2, .params = {
+				[0] = THREAD_PARAM_VALUE(IN,
+							 OPTEE_RPC_FS_WRITEV,
+							 b->fd, b->count),
+				[1] = THREAD_PARAM_MEMREF(IN, b->mobj, 0,
+							  b->used),
+			},
+		};
+		res = operation_commit(&op);
+		if (res == TEE_ERROR_NOT_SUPPORTED ||
+		    res == TEE_ERROR_NOT_IMPLEMENTED ||
+		    res == TEE_ERROR_BAD_PARAMETERS) {
+			DMSG("OPTEE_RPC_FS_WRITEV not supported: %#"PRIx32,
+			     res);
+			writev_supported = false;
+		}
+	}
+	if (!writev_supported)
+		res = batch_flush_one_by_one(b);
+
+	b->used = 0;
+	b->count = 0;
+
+	return res;
+}
+
+TEE_Result tee_fs_rpc_batch_add(struct tee_fs_rpc_batch *b,
+				tee_fs_off_t offset, size_t data_len,
+				void **data)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct batch_hdr hdr = { .offset = offset, .len = data_len };
+	size_t sz = sizeof(hdr) + ROUNDUP(data_len, sizeof(uint64_t));
+	uint8_t *va = NULL;
+
+	if (offset < 0 || sz > BATCH_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!b->buf) {
+		va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_FS_BATCH,
+						THREAD_SHM_TYPE_APPLICATION,
+						BATCH_SIZE, &b->mobj);
+		if (!va)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		b->buf = va;
+	}
+
+	if (b->used + sz > BATCH_SIZE) {
+		res = tee_fs_rpc_batch_flush(b);
+		if (res)
+			return res;
+	}
+
+	va = b->buf + b->used;
+	memcpy(va, &hdr, sizeof(hdr));
+	memset(va + sizeof(hdr) + data_len, 0, sz - sizeof(hdr) - data_len);
+	*data = va + sizeof(hdr);
+	b->used += sz;
+	b->count++;
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_REE_FS_RPC_BATCH*/
+
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len)
 {
 	struct tee_fs_rpc_operation op = {
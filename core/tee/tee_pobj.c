@@ -8,11 +8,64 @@
 #include <string.h>
 #include <tee/tee_pobj.h>
 
-static TAILQ_HEAD(tee_pobjs, tee_pobj) tee_pobjs =
-		TAILQ_HEAD_INITIALIZER(tee_pobjs);
-static struct mutex pobjs_mutex = MUTEX_INITIALIZER;
+/* Number of hash buckets of the open persistent objects, a power of 2 */
+#define POBJ_BUCKET_COUNT	32
+
+/*
+ * Open persistent objects are hashed on TA UUID and object ID. Each
+ * bucket has its own mutex which protects the list and the fields of the
+ * objects in it that can't be changed without it.
+ */
+struct pobj_bucket {
+	struct mutex mu;
+	LIST_HEAD(, tee_pobj) pobjs;
+};
+
+static struct pobj_bucket pobj_buckets[POBJ_BUCKET_COUNT] = {
+	[0 ... POBJ_BUCKET_COUNT - 1] = { .mu = MUTEX_INITIALIZER },
+};
 static struct mutex pobjs_usage_mutex = MUTEX_INITIALIZER;
 
+/* FNV-1a */
+static uint32_t hash_bytes(uint32_t h, const void *buf, size_t len)
+{
+	const uint8_t *b = buf;
+	size_t n = 0;
+
+	for (n = 0; n < len; n++)
+		h = (h ^ b[n]) * 16777619;
+
+	return h;
+}
+
+static unsigned int pobj_bucket_idx(const TEE_UUID *uuid, const void *obj_id,
+				    uint32_t obj_id_len)
+{
+	uint32_t h = 2166136261;
+
+	h = hash_bytes(h, uuid, sizeof(*uuid));
+	h = hash_bytes(h, obj_id, obj_id_len);
+
+	return h & (POBJ_BUCKET_COUNT - 1);
+}
+
+/*
+ * Locks and returns the bucket of @obj. The bucket can only change with
+ * tee_pobj_rename(), which is checked for once the mutex is held.
+ */
+static struct pobj_bucket *lock_pobj_bucket(struct tee_pobj *obj)
+{
+	struct pobj_bucket *b = NULL;
+
+	while (true) {
+		b = pobj_buckets + obj->bucket_idx;
+		mutex_lock(&b->mu);
+		if (b == pobj_buckets + obj->bucket_idx)
+			return b;
+		mutex_unlock(&b->mu);
+	}
+}
+
 static bool pobj_need_usage_lock(struct tee_pobj *obj)
 {
 	/* Only lock if we don't have exclusive access to the object */
@@ -81,19 +134,22 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 			const struct tee_file_operations *fops,
 			struct tee_pobj **obj)
 {
+	unsigned int idx = pobj_bucket_idx(uuid, obj_id, obj_id_len);
+	struct pobj_bucket *b = pobj_buckets + idx;
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_pobj *o = NULL;
 
 	*obj = NULL;
 
-	mutex_lock(&pobjs_mutex);
+	mutex_lock(&b->mu);
 	/* Check if file is open */
-	TAILQ_FOREACH(o, &tee_pobjs, link) {
+	LIST_FOREACH(o, &b->pobjs, link) {
 		if ((obj_id_len == o->obj_id_len) &&
 		    (memcmp(obj_id, o->obj_id, obj_id_len) == 0) &&
 		    (memcmp(uuid, &o->uuid, sizeof(TEE_UUID)) == 0) &&
 		    (fops == o->fops)) {
 			*obj = o;
+			break;
 		}
 	}
 
@@ -138,39 +194,43 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 	}
 	memcpy(o->obj_id, obj_id, obj_id_len);
 	o->obj_id_len = obj_id_len;
+	o->bucket_idx = idx;
 
-	TAILQ_INSERT_TAIL(&tee_pobjs, o, link);
+	LIST_INSERT_HEAD(&b->pobjs, o, link);
 	*obj = o;
 
 	res = TEE_SUCCESS;
 out:
 	if (res != TEE_SUCCESS)
 		*obj = NULL;
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&b->mu);
 	return res;
 }
 
 void tee_pobj_create_final(struct tee_pobj *po)
 {
-	mutex_lock(&pobjs_mutex);
+	struct pobj_bucket *b = lock_pobj_bucket(po);
+
 	po->temporary = false;
 	po->creating = false;
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&b->mu);
 }
 
 TEE_Result tee_pobj_release(struct tee_pobj *obj)
 {
+	struct pobj_bucket *b = NULL;
+
 	if (obj == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
+	b = lock_pobj_bucket(obj);
 	obj->refcnt--;
 	if (obj->refcnt == 0) {
-		TAILQ_REMOVE(&tee_pobjs, obj, link);
+		LIST_REMOVE(obj, link);
 		free(obj->obj_id);
 		free(obj);
 	}
-	mutex_unlock(&pobjs_mutex);
+	mutex_unlock(&b->mu);
 
 	return TEE_SUCCESS;
 }
@@ -178,33 +238,57 @@ TEE_Result tee_pobj_release(struct tee_pobj *obj)
 TEE_Result tee_pobj_rename(struct tee_pobj *obj, void *obj_id,
 			   uint32_t obj_id_len)
 {
+	struct pobj_bucket *old_b = NULL;
+	struct pobj_bucket *new_b = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	void *new_obj_id = NULL;
+	unsigned int idx = 0;
 
 	if (obj == NULL || obj_id == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
-	if (obj->refcnt != 1) {
-		res = TEE_ERROR_BAD_STATE;
-		goto exit;
+	new_obj_id = malloc(obj_id_len);
+	if (new_obj_id == NULL)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memcpy(new_obj_id, obj_id, obj_id_len);
+
+	/*
+	 * The object may move to another bucket. Both mutexes are held to
+	 * move it, taken in bucket order to avoid deadlocks. The caller has
+	 * the only reference so the current bucket can't change meanwhile.
+	 */
+	idx = pobj_bucket_idx(&obj->uuid, obj_id, obj_id_len);
+	old_b = pobj_buckets + obj->bucket_idx;
+	new_b = pobj_buckets + idx;
+	if (old_b <= new_b) {
+		mutex_lock(&old_b->mu);
+		if (new_b != old_b)
+			mutex_lock(&new_b->mu);
+	} else {
+		mutex_lock(&new_b->mu);
+		mutex_lock(&old_b->mu);
 	}
 
-	new_obj_id = malloc(obj_id_len);
-	if (new_obj_id == NULL) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
+	if (obj->refcnt != 1) {
+		res = TEE_ERROR_BAD_STATE;
 		goto exit;
 	}
-	memcpy(new_obj_id, obj_id, obj_id_len);
 
 	/* update internal data */
 	free(obj->obj_id);
 	obj->obj_id = new_obj_id;
 	obj->obj_id_len = obj_id_len;
 	new_obj_id = NULL;
+	if (new_b != old_b) {
+		LIST_REMOVE(obj, link);
+		LIST_INSERT_HEAD(&new_b->pobjs, obj, link);
+		obj->bucket_idx = idx;
+	}
 
 exit:
-	mutex_unlock(&pobjs_mutex);
+	if (new_b != old_b)
+		mutex_unlock(&new_b->mu);
+	mutex_unlock(&old_b->mu);
 	free(new_obj_id);
 	return res;
 }
@@ -26,15 +26,34 @@
 #include <utee_defines.h>
 #include <util.h>
 
-#define BLOCK_SHIFT	12
+#if CFG_REE_FS_BLOCK_SHIFT < 12 || CFG_REE_FS_BLOCK_SHIFT > 16
+#error CFG_REE_FS_BLOCK_SHIFT out of range
+#endif
+
+#define BLOCK_SHIFT	CFG_REE_FS_BLOCK_SHIFT
 
 #define BLOCK_SIZE	(1 << BLOCK_SHIFT)
 
+/*
+ * struct tee_fs_fd - an open REE FS file
+ * @ht:			hash tree of the file
+ * @fd:			file descriptor in normal world
+ * @dfh:		dirfile handle of the file
+ * @uuid:		UUID of the TA owning the file
+ * @trans_owner:	owner of the transaction the file has joined
+ * @trans_closed:	closed while in a transaction
+ * @trans_removed:	removed from the dirfile while in a transaction
+ * @trans_link:		link in ree_fs_trans_fds
+ */
 struct tee_fs_fd {
 	struct tee_fs_htree *ht;
 	int fd;
 	struct tee_fs_dirfile_fileh dfh;
 	const TEE_UUID *uuid;
+	const void *trans_owner;
+	bool trans_closed;
+	bool trans_removed;
+	TAILQ_ENTRY(tee_fs_fd) trans_link;
 };
 
 struct tee_fs_dir {
@@ -86,36 +105,53 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	if (!block)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	tee_fs_htree_batch_writes(fdp->ht);
+
 	while (start_block_num <= end_block_num) {
 		size_t offset = pos % BLOCK_SIZE;
 		size_t size_to_write = MIN(remain_bytes, (size_t)BLOCK_SIZE);
 
+		const void *src = block;
+
 		if (size_to_write + offset > BLOCK_SIZE)
 			size_to_write = BLOCK_SIZE - offset;
 
-		if (start_block_num * BLOCK_SIZE <
+		/*
+		 * Only partially written blocks need the old content, a
+		 * read would also flush the writes queued so far.
+		 */
+		if (size_to_write < BLOCK_SIZE &&
+		    start_block_num * BLOCK_SIZE <
 		    ROUNDUP(meta->length, BLOCK_SIZE)) {
 			res = tee_fs_htree_read_block(&fdp->ht,
 						      start_block_num, block);
 			if (res != TEE_SUCCESS)
 				goto exit;
-		} else {
+		} else if (size_to_write < BLOCK_SIZE) {
 			memset(block, 0, BLOCK_SIZE);
 		}
 
 		if (data_core_ptr) {
-			memcpy(block + offset, data_core_ptr, size_to_write);
+			/*
+			 * A fully written block is encrypted straight from
+			 * the buffer of the caller.
+			 */
+			if (size_to_write == BLOCK_SIZE)
+				src = data_core_ptr;
+			else
+				memcpy(block + offset, data_core_ptr,
+				       size_to_write);
 		} else if (data_user_ptr) {
 			res = copy_from_user(block + offset, data_user_ptr,
 					     size_to_write);
 			if (res)
-				return res;
+				goto exit;
 		} else {
 			memset(block + offset, 0, size_to_write);
 		}
 
 		res = tee_fs_htree_write_block(&fdp->ht, start_block_num,
-					       block);
+					       src);
 		if (res != TEE_SUCCESS)
 			goto exit;
 
@@ -128,6 +164,10 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 		pos += size_to_write;
 	}
 
+	res = tee_fs_htree_flush_writes(&fdp->ht);
+	if (res != TEE_SUCCESS)
+		goto exit;
+
 	if (pos > meta->length) {
 		meta->length = pos;
 		tee_fs_htree_meta_set_dirty(fdp->ht);
@@ -152,7 +192,7 @@ static TEE_Result get_offs_size(enum tee_fs_htree_type type, size_t idx,
 	/*
 	 * File layout
 	 * [demo with input:
-	 * BLOCK_SIZE = 4096,
+	 * BLOCK_SIZE = 4096 (CFG_REE_FS_BLOCK_SHIFT = 12),
 	 * node_size = 66,
 	 * block_nodes = 4096/(66*2) = 31 ]
 	 *
@@ -258,12 +298,43 @@ static TEE_Result ree_fs_rpc_write_init(void *aux,
 				     offs, size, data);
 }
 
+#ifdef CFG_REE_FS_RPC_BATCH
+static void ree_fs_rpc_batch_init(void *aux, struct tee_fs_rpc_batch *b)
+{
+	struct tee_fs_fd *fdp = aux;
+
+	tee_fs_rpc_batch_init(b, OPTEE_RPC_CMD_FS, fdp->fd);
+}
+
+static TEE_Result ree_fs_rpc_batch_add(void *aux, struct tee_fs_rpc_batch *b,
+				       enum tee_fs_htree_type type, size_t idx,
+				       uint8_t vers, void **data)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs = 0;
+	size_t size = 0;
+
+	assert(((struct tee_fs_fd *)aux)->fd == b->fd);
+
+	res = get_offs_size(type, idx, vers, &offs, &size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return tee_fs_rpc_batch_add(b, offs, size, data);
+}
+#endif
+
 static const struct tee_fs_htree_storage ree_fs_storage_ops = {
 	.block_size = BLOCK_SIZE,
 	.rpc_read_init = ree_fs_rpc_read_init,
 	.rpc_read_final = tee_fs_rpc_read_final,
 	.rpc_write_init = ree_fs_rpc_write_init,
 	.rpc_write_final = tee_fs_rpc_write_final,
+#ifdef CFG_REE_FS_RPC_BATCH
+	.rpc_batch_init = ree_fs_rpc_batch_init,
+	.rpc_batch_add = ree_fs_rpc_batch_add,
+	.rpc_batch_flush = tee_fs_rpc_batch_flush,
+#endif
 };
 
 static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
@@ -521,6 +592,10 @@ static const struct tee_fs_dirfile_operations ree_dirf_ops = {
 static struct tee_fs_dirfile_dirh *ree_fs_dirh;
 static size_t ree_fs_dirh_refcount;
 
+/* Files with changes pending in a transaction, protected by ree_fs_mutex */
+static TAILQ_HEAD(, tee_fs_fd) ree_fs_trans_fds =
+	TAILQ_HEAD_INITIALIZER(ree_fs_trans_fds);
+
 #ifdef CFG_REE_FS_INTEGRITY_RPMB
 static struct tee_file_handle *ree_fs_rpmb_fh;
 
@@ -599,7 +674,7 @@ static TEE_Result open_dirh(struct tee_fs_dirfile_dirh **dirh)
 	TEE_Result res = TEE_SUCCESS;
 	uint32_t min_counter = 0;
 
-	res = nv_counter_get_ree_fs(&min_counter);
+	res = nv_counter_get_ree_fs_cached(&min_counter);
 	if (res) {
 		static bool once;
 
@@ -638,7 +713,7 @@ static TEE_Result commit_dirh_writes(struct tee_fs_dirfile_dirh *dirh)
 	res = tee_fs_dirfile_commit_writes(dirh, NULL, &counter);
 	if (res)
 		return res;
-	res = nv_counter_incr_ree_fs_to(counter);
+	res = nv_counter_incr_ree_fs_to_cached(counter);
 	if (res == TEE_ERROR_NOT_IMPLEMENTED && IS_ENABLED(CFG_INSECURE)) {
 		static bool once;
 
@@ -743,6 +818,19 @@ out:
 	return res;
 }
 
+/*
+ * Called with ree_fs_mutex held when a file is removed from the dirfile,
+ * a pending file of a transaction must then not be committed.
+ */
+static void trans_forget_file(const struct tee_fs_dirfile_fileh *dfh)
+{
+	struct tee_fs_fd *fdp = NULL;
+
+	TAILQ_FOREACH(fdp, &ree_fs_trans_fds, trans_link)
+		if (fdp->dfh.file_number == dfh->file_number)
+			fdp->trans_removed = true;
+}
+
 static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 			   struct tee_fs_fd *fdp, struct tee_pobj *po,
 			   bool overwrite)
@@ -774,18 +862,27 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 	if (res)
 		return res;
 
-	if (have_old_dfh)
+	if (have_old_dfh) {
+		trans_forget_file(&old_dfh);
 		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &old_dfh);
+	}
 
 	return TEE_SUCCESS;
 }
 
 static void ree_fs_close(struct tee_file_handle **fh)
 {
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)*fh;
+
 	if (*fh) {
 		mutex_lock(&ree_fs_mutex);
-		put_dirh_primitive(false);
-		ree_fs_close_primitive(*fh);
+		if (fdp->trans_owner) {
+			/* Closed when the transaction ends */
+			fdp->trans_closed = true;
+		} else {
+			put_dirh_primitive(false);
+			ree_fs_close_primitive(*fh);
+		}
 		*fh = NULL;
 		mutex_unlock(&ree_fs_mutex);
 
@@ -881,7 +978,7 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 		goto out;
 
 	res = ree_fs_write_primitive(fh, pos, buf_core, buf_user, len);
-	if (res)
+	if (res || fdp->trans_owner)
 		goto out;
 
 	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash, NULL);
@@ -942,8 +1039,10 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 	if (res)
 		goto out;
 
-	if (remove_dfh.idx != -1)
+	if (remove_dfh.idx != -1) {
+		trans_forget_file(&remove_dfh);
 		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &remove_dfh);
+	}
 
 out:
 	put_dirh(dirh, res);
@@ -977,6 +1076,7 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	if (res)
 		goto out;
 
+	trans_forget_file(&dfh);
 	tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &dfh);
 
 	assert(tee_fs_dirfile_find(dirh, &po->uuid, po->obj_id, po->obj_id_len,
@@ -1001,7 +1101,7 @@ static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 		goto out;
 
 	res = ree_fs_ftruncate_internal(fdp, len);
-	if (res)
+	if (res || fdp->trans_owner)
 		goto out;
 
 	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash, NULL);
@@ -1095,6 +1195,93 @@ out:
 	return res;
 }
 
+static void ree_fs_join_transaction(struct tee_file_handle *fh,
+				    const void *owner)
+{
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+
+	mutex_lock(&ree_fs_mutex);
+	if (!fdp->trans_owner) {
+		fdp->trans_owner = owner;
+		TAILQ_INSERT_TAIL(&ree_fs_trans_fds, fdp, trans_link);
+	}
+	assert(fdp->trans_owner == owner);
+	mutex_unlock(&ree_fs_mutex);
+}
+
+/* Called with ree_fs_mutex held */
+static void trans_release(const void *owner)
+{
+	struct tee_fs_fd *next = TAILQ_FIRST(&ree_fs_trans_fds);
+	struct tee_fs_fd *fdp = NULL;
+
+	while (next) {
+		fdp = next;
+		next = TAILQ_NEXT(fdp, trans_link);
+		if (fdp->trans_owner != owner)
+			continue;
+
+		TAILQ_REMOVE(&ree_fs_trans_fds, fdp, trans_link);
+		fdp->trans_owner = NULL;
+		fdp->trans_removed = false;
+		if (fdp->trans_closed) {
+			put_dirh_primitive(false);
+			ree_fs_close_primitive((struct tee_file_handle *)fdp);
+		}
+	}
+}
+
+/*
+ * The hash trees of the pending files are synced first, each to its
+ * uncommitted version. The dirfile is then committed once, pointing at
+ * all the new versions in one step.
+ */
+static TEE_Result ree_fs_commit_transaction(const void *owner)
+{
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+	struct tee_fs_fd *fdp = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+
+	res = get_dirh(&dirh);
+	if (res)
+		goto out;
+
+	TAILQ_FOREACH(fdp, &ree_fs_trans_fds, trans_link) {
+		if (fdp->trans_owner != owner || fdp->trans_removed)
+			continue;
+
+		res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash,
+						   NULL);
+		if (res)
+			goto out;
+		res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+		if (res)
+			goto out;
+	}
+
+	res = commit_dirh_writes(dirh);
+out:
+	put_dirh(dirh, res);
+	trans_release(owner);
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+/*
+ * Changes of closed files are discarded. The hash tree of a file that is
+ * still open keeps its changes, they are committed by the next write or
+ * truncation of the file.
+ */
+static void ree_fs_abort_transaction(const void *owner)
+{
+	mutex_lock(&ree_fs_mutex);
+	trans_release(owner);
+	mutex_unlock(&ree_fs_mutex);
+}
+
 const struct tee_file_operations ree_fs_ops = {
 	.open = ree_fs_open,
 	.create = ree_fs_create,
@@ -1107,4 +1294,7 @@ const struct tee_file_operations ree_fs_ops = {
 	.opendir = ree_fs_opendir_rpc,
 	.closedir = ree_fs_closedir_rpc,
 	.readdir = ree_fs_readdir_rpc,
+	.join_transaction = ree_fs_join_transaction,
+	.commit_transaction = ree_fs_commit_transaction,
+	.abort_transaction = ree_fs_abort_transaction,
 };
@@ -1127,10 +1127,16 @@ static TEE_Result rpmb_set_dev_info(const struct rpmb_dev_info *dev_info)
 
 	memcpy(rpmb_ctx->cid, dev_info->cid, RPMB_EMMC_CID_SIZE);
 
-	if (IS_ENABLED(RPMB_DRIVER_MULTIPLE_WRITE_FIXED))
+	/*
+	 * The Reliable Write Sector Count is in units of 512 bytes, that is
+	 * two 256 byte RPMB data frames.
+	 */
+	if (IS_ENABLED(CFG_RPMB_FS_MULTI_BLOCK_WRITE) && dev_info->rel_wr_sec_c)
 		rpmb_ctx->rel_wr_blkcnt = dev_info->rel_wr_sec_c * 2;
 	else
 		rpmb_ctx->rel_wr_blkcnt = 1;
+	DMSG("RPMB: Using %"PRIu16" blocks per reliable write",
+	     rpmb_ctx->rel_wr_blkcnt);
 
 	return TEE_SUCCESS;
 }
@@ -1921,6 +1927,203 @@ post_read_in:
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_RPMB_FS_NAME_INDEX
+/*
+ * In-memory index of the active FAT entries, hashed on the filename. It
+ * is built on the first lookup by a full traversal of the FAT and kept
+ * in sync by write_fat_entry(). A lookup then only reads the FAT entries
+ * with a matching hash instead of scanning the FAT from its start.
+ * Entries in a bucket are sorted on their FAT address so the first match
+ * is the same as the one found by a traversal.
+ */
+#define RPMB_NAME_INDEX_BUCKETS		64
+
+struct rpmb_name_index_entry {
+	uint32_t fat_address;
+	uint32_t hash;
+	SLIST_ENTRY(rpmb_name_index_entry) link;
+};
+
+SLIST_HEAD(rpmb_name_index_head, rpmb_name_index_entry);
+
+static struct rpmb_name_index_head *name_index;
+
+static uint32_t name_index_hash(const char *name)
+{
+	uint32_t h = 2166136261U;
+
+	while (*name) {
+		h ^= (uint8_t)*name++;
+		h *= 16777619U;
+	}
+
+	return h;
+}
+
+static void name_index_free(void)
+{
+	struct rpmb_name_index_entry *e = NULL;
+	size_t n = 0;
+
+	if (!name_index)
+		return;
+
+	for (n = 0; n < RPMB_NAME_INDEX_BUCKETS; n++) {
+		while ((e = SLIST_FIRST(name_index + n))) {
+			SLIST_REMOVE_HEAD(name_index + n, link);
+			free(e);
+		}
+	}
+	free(name_index);
+	name_index = NULL;
+}
+
+static void name_index_remove(uint32_t fat_address)
+{
+	struct rpmb_name_index_entry *e = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < RPMB_NAME_INDEX_BUCKETS; n++) {
+		SLIST_FOREACH(e, name_index + n, link) {
+			if (e->fat_address == fat_address) {
+				SLIST_REMOVE(name_index + n, e,
+					     rpmb_name_index_entry, link);
+				free(e);
+				return;
+			}
+		}
+	}
+}
+
+static TEE_Result name_index_add(const char *name, uint32_t fat_address)
+{
+	uint32_t h = name_index_hash(name);
+	struct rpmb_name_index_head *head = NULL;
+	struct rpmb_name_index_entry *prev = NULL;
+	struct rpmb_name_index_entry *e = NULL;
+
+	head = name_index + (h % RPMB_NAME_INDEX_BUCKETS);
+	SLIST_FOREACH(e, head, link) {
+		if (e->fat_address > fat_address)
+			break;
+		prev = e;
+	}
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	e->fat_address = fat_address;
+	e->hash = h;
+
+	if (prev)
+		SLIST_INSERT_AFTER(prev, e, link);
+	else
+		SLIST_INSERT_HEAD(head, e, link);
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Called each time fe has been written at fat_address. If the index
+ * can't be updated it's dropped and rebuilt on the next lookup.
+ */
+static void name_index_update(struct rpmb_fat_entry *fe, uint32_t fat_address)
+{
+	if (!name_index)
+		return;
+
+	name_index_remove(fat_address);
+	if ((fe->flags & FILE_IS_ACTIVE) &&
+	    name_index_add(fe->filename, fat_address))
+		name_index_free();
+}
+
+static TEE_Result name_index_build(void)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct rpmb_fat_entry *fe = NULL;
+	uint32_t fat_address = 0;
+
+	name_index = calloc(RPMB_NAME_INDEX_BUCKETS, sizeof(*name_index));
+	if (!name_index)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = fat_entry_dir_init();
+	if (res)
+		goto out;
+
+	while (true) {
+		res = fat_entry_dir_get_next(&fe, &fat_address);
+		if (res || !fe)
+			break;
+
+		if (fe->flags & FILE_IS_ACTIVE) {
+			res = name_index_add(fe->filename, fat_address);
+			if (res)
+				break;
+		}
+	}
+
+out:
+	fat_entry_dir_deinit();
+	if (res)
+		name_index_free();
+	return res;
+}
+
+/*
+ * Looks up the active FAT entry of fh->filename. Returns
+ * TEE_ERROR_NOT_SUPPORTED if the index isn't available, the caller is
+ * expected to traverse the FAT instead.
+ */
+static TEE_Result name_index_lookup(struct rpmb_file_handle *fh)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t h = name_index_hash(fh->filename);
+	struct rpmb_name_index_entry *e = NULL;
+	struct rpmb_fat_entry *fe = NULL;
+
+	if (!name_index && name_index_build())
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	fe = malloc(sizeof(*fe));
+	if (!fe)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = TEE_ERROR_ITEM_NOT_FOUND;
+	SLIST_FOREACH(e, name_index + (h % RPMB_NAME_INDEX_BUCKETS), link) {
+		if (e->hash != h)
+			continue;
+
+		res = tee_rpmb_read(e->fat_address, (uint8_t *)fe,
+				    sizeof(*fe), NULL, NULL);
+		if (res)
+			break;
+
+		if ((fe->flags & FILE_IS_ACTIVE) &&
+		    !strcmp(fh->filename, fe->filename)) {
+			fh->rpmb_fat_address = e->fat_address;
+			memcpy(&fh->fat_entry, fe, sizeof(*fe));
+			break;
+		}
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+	}
+
+	free(fe);
+	return res;
+}
+#else
+static void name_index_update(struct rpmb_fat_entry *fe __unused,
+			      uint32_t fat_address __unused)
+{
+}
+
+static TEE_Result name_index_lookup(struct rpmb_file_handle *fh __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif /*CFG_RPMB_FS_NAME_INDEX*/
+
 #if (TRACE_LEVEL >= TRACE_FLOW)
 static void dump_fat(void)
 {
@@ -2054,6 +2257,9 @@ static TEE_Result write_fat_entry(struct rpmb_file_handle *fh)
 		res = fat_entry_dir_update(&fh->fat_entry,
 					   fh->rpmb_fat_address);
 
+	if (!res)
+		name_index_update(&fh->fat_entry, fh->rpmb_fat_address);
+
 out:
 	return res;
 }
@@ -2210,6 +2416,12 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 
 	DMSG("fat_address %d", fh->rpmb_fat_address);
 
+	if (!p) {
+		res = name_index_lookup(fh);
+		if (res != TEE_ERROR_NOT_SUPPORTED)
+			return res;
+	}
+
 	res = fat_entry_dir_init();
 	if (res)
 		goto out;
@@ -10,7 +10,10 @@
 #include <compiler.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <initcall.h>
+#include <kernel/panic.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/tee_time.h>
 #include <kernel/user_access.h>
 #include <memtag.h>
 #include <mm/vm.h>
@@ -20,6 +23,7 @@
 #include <sys/queue.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
+#include <tee/tee_cryp_ctx_pool.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/tee_obj.h>
 #include <tee/tee_pobj.h>
@@ -823,17 +827,24 @@ static void op_attr_secret_value_clear(void *attr)
 static TEE_Result op_attr_bignum_from_user(void *attr, const void *buffer,
 					   size_t size)
 {
+	uint32_t flags = TEE_MEMORY_ACCESS_READ | TEE_MEMORY_ACCESS_ANY_OWNER;
 	TEE_Result res = TEE_SUCCESS;
 	struct bignum **bn = attr;
-	void *bbuf = NULL;
 
-	res = bb_memdup_user(buffer, size, &bbuf);
+	/*
+	 * The bignum is converted straight from user memory, each byte is
+	 * read once so there's no need for a private copy first. This
+	 * saves a bounce buffer and a copy per attribute when importing
+	 * large keys.
+	 */
+	buffer = memtag_strip_tag_const(buffer);
+	res = check_user_access(flags, buffer, size);
 	if (res)
 		return res;
 
-	res = crypto_bignum_bin2bn(bbuf, size, *bn);
-
-	bb_free(bbuf, size);
+	enter_user_access();
+	res = crypto_bignum_bin2bn(buffer, size, *bn);
+	exit_user_access();
 
 	return res;
 }
@@ -1229,27 +1240,110 @@ TEE_Result syscall_cryp_obj_restrict_usage(unsigned long obj,
 	return res;
 }
 
+/*
+ * Hash tables indexing tee_cryp_obj_props[] by object type and the
+ * attributes of each type by attribute ID, filled at boot. Both are
+ * looked up on each object allocation, populate and attribute access.
+ * An entry holds the index + 1 of the found element, 0 means empty.
+ */
+#define TYPE_PROPS_HASH_BITS	7
+#define TYPE_ATTR_HASH_BITS	9
+
+struct type_attr_hash_entry {
+	uint32_t attr_id;
+	uint8_t props_idx;
+	uint8_t attr_idx;
+};
+
+static uint8_t type_props_hash[BIT(TYPE_PROPS_HASH_BITS)];
+static struct type_attr_hash_entry type_attr_hash[BIT(TYPE_ATTR_HASH_BITS)];
+
+static size_t id_hash(uint32_t id, unsigned int bits)
+{
+	return (uint32_t)(id * 0x9e3779b1U) >> (32 - bits);
+}
+
+static size_t type_attr_hash_idx(uint32_t attr_id, size_t props_idx)
+{
+	return id_hash(attr_id ^ (props_idx * 0x01000193U),
+		       TYPE_ATTR_HASH_BITS);
+}
+
+static TEE_Result init_type_props_hash(void)
+{
+	const size_t props_mask = ARRAY_SIZE(type_props_hash) - 1;
+	const size_t attr_mask = ARRAY_SIZE(type_attr_hash) - 1;
+	const struct tee_cryp_obj_type_props *tp = NULL;
+	struct type_attr_hash_entry *e = NULL;
+	size_t num_attrs = 0;
+	size_t n = 0;
+	size_t m = 0;
+	size_t h = 0;
+
+	static_assert(ARRAY_SIZE(tee_cryp_obj_props) < UINT8_MAX);
+	static_assert(ARRAY_SIZE(tee_cryp_obj_props) <
+		      ARRAY_SIZE(type_props_hash) / 2);
+
+	for (n = 0; n < ARRAY_SIZE(tee_cryp_obj_props); n++) {
+		tp = tee_cryp_obj_props + n;
+
+		/* The first entry of a type is the one in effect */
+		h = id_hash(tp->obj_type, TYPE_PROPS_HASH_BITS);
+		while (type_props_hash[h] &&
+		       tee_cryp_obj_props[type_props_hash[h] - 1].obj_type !=
+		       tp->obj_type)
+			h = (h + 1) & props_mask;
+		if (type_props_hash[h])
+			continue;
+		type_props_hash[h] = n + 1;
+
+		for (m = 0; m < tp->num_type_attrs; m++) {
+			if (num_attrs >= ARRAY_SIZE(type_attr_hash) / 2)
+				panic("type_attr_hash too small");
+			h = type_attr_hash_idx(tp->type_attrs[m].attr_id, n);
+			while (type_attr_hash[h].props_idx)
+				h = (h + 1) & attr_mask;
+			e = type_attr_hash + h;
+			e->attr_id = tp->type_attrs[m].attr_id;
+			e->props_idx = n + 1;
+			e->attr_idx = m;
+			num_attrs++;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+service_init(init_type_props_hash);
+
 static int tee_svc_cryp_obj_find_type_attr_idx(
 		uint32_t attr_id,
 		const struct tee_cryp_obj_type_props *type_props)
 {
-	size_t n;
-
-	for (n = 0; n < type_props->num_type_attrs; n++) {
-		if (attr_id == type_props->type_attrs[n].attr_id)
-			return n;
+	size_t props_idx = type_props - tee_cryp_obj_props;
+	size_t h = type_attr_hash_idx(attr_id, props_idx);
+	struct type_attr_hash_entry *e = NULL;
+
+	while (true) {
+		e = type_attr_hash + h;
+		if (!e->props_idx)
+			return -1;
+		if (e->attr_id == attr_id && e->props_idx == props_idx + 1)
+			return e->attr_idx;
+		h = (h + 1) & (ARRAY_SIZE(type_attr_hash) - 1);
 	}
-	return -1;
 }
 
 static const struct tee_cryp_obj_type_props *tee_svc_find_type_props(
 		TEE_ObjectType obj_type)
 {
-	size_t n;
-
-	for (n = 0; n < ARRAY_SIZE(tee_cryp_obj_props); n++) {
-		if (tee_cryp_obj_props[n].obj_type == obj_type)
-			return tee_cryp_obj_props + n;
+	size_t h = id_hash(obj_type, TYPE_PROPS_HASH_BITS);
+	const struct tee_cryp_obj_type_props *tp = NULL;
+
+	while (type_props_hash[h]) {
+		tp = tee_cryp_obj_props + type_props_hash[h] - 1;
+		if (tp->obj_type == obj_type)
+			return tp;
+		h = (h + 1) & (ARRAY_SIZE(type_props_hash) - 1);
 	}
 
 	return NULL;
@@ -1327,6 +1421,16 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	return ops->to_user(attr, sess, buffer, size);
 }
 
+/*
+ * Drop what the crypto backend cached from the key of @o, called before
+ * the attributes of @o are modified or freed.
+ */
+static void tee_obj_attr_changed(struct tee_obj *o)
+{
+	if (o->attr && o->info.objectType == TEE_TYPE_RSA_KEYPAIR)
+		crypto_acipher_rsa_keypair_changed(o->attr);
+}
+
 void tee_obj_attr_free(struct tee_obj *o)
 {
 	const struct tee_cryp_obj_type_props *tp;
@@ -1334,6 +1438,7 @@ void tee_obj_attr_free(struct tee_obj *o)
 
 	if (!o->attr)
 		return;
+	tee_obj_attr_changed(o);
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return;
@@ -1352,6 +1457,7 @@ void tee_obj_attr_clear(struct tee_obj *o)
 
 	if (!o->attr)
 		return;
+	tee_obj_attr_changed(o);
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return;
@@ -1413,6 +1519,7 @@ TEE_Result tee_obj_attr_from_binary(struct tee_obj *o, const void *data,
 	if (!tp)
 		return TEE_ERROR_BAD_STATE;
 
+	tee_obj_attr_changed(o);
 	for (n = 0; n < tp->num_type_attrs; n++) {
 		const struct tee_cryp_obj_type_attrs *ta = tp->type_attrs + n;
 		void *attr = (uint8_t *)o->attr + ta->raw_offs;
@@ -1442,6 +1549,7 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 	if (!tp)
 		return TEE_ERROR_BAD_STATE;
 
+	tee_obj_attr_changed(o);
 	if (o->info.objectType == src->info.objectType) {
 		have_attrs = src->have_attrs;
 		for (n = 0; n < tp->num_type_attrs; n++) {
@@ -1904,6 +2012,7 @@ static TEE_Result tee_svc_cryp_obj_populate_type(
 	const struct attr_ops *ops = NULL;
 	void *attr = NULL;
 
+	tee_obj_attr_changed(o);
 	for (n = 0; n < attr_count; n++) {
 		idx = tee_svc_cryp_obj_find_type_attr_idx(
 							attrs[n].attributeID,
@@ -2604,6 +2713,9 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx);
 
+	if (tee_cryp_ctx_pool_put(cs->algo, cs->ctx))
+		cs->ctx = NULL;
+
 	switch (TEE_ALG_GET_CLASS(cs->algo)) {
 	case TEE_OPERATION_CIPHER:
 		crypto_cipher_free_ctx(cs->ctx);
@@ -2817,6 +2929,8 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	cs->algo = algo;
 	cs->mode = mode;
 	cs->state = CRYP_STATE_UNINITIALIZED;
+	/* Non-NULL only for algorithms with a context allocated below */
+	cs->ctx = tee_cryp_ctx_pool_get(algo);
 
 	switch (TEE_ALG_GET_CLASS(algo)) {
 	case TEE_OPERATION_CIPHER:
@@ -2825,7 +2939,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 		    (TEE_ALG_GET_CHAIN_MODE(algo) != TEE_CHAIN_MODE_XTS &&
 		    (key1 == 0 || key2 != 0))) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_cipher_alloc_ctx(&cs->ctx, algo);
 			if (res != TEE_SUCCESS)
 				break;
@@ -2834,7 +2948,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	case TEE_OPERATION_AE:
 		if (key1 == 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_authenc_alloc_ctx(&cs->ctx, algo);
 			if (res != TEE_SUCCESS)
 				break;
@@ -2843,7 +2957,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	case TEE_OPERATION_MAC:
 		if (key1 == 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_mac_alloc_ctx(&cs->ctx, algo);
 			if (res != TEE_SUCCESS)
 				break;
@@ -2852,7 +2966,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	case TEE_OPERATION_DIGEST:
 		if (key1 != 0 || key2 != 0) {
 			res = TEE_ERROR_BAD_PARAMETERS;
-		} else {
+		} else if (!cs->ctx) {
 			res = crypto_hash_alloc_ctx(&cs->ctx, algo);
 			if (res != TEE_SUCCESS)
 				break;
@@ -4063,20 +4177,106 @@ out:
 	return res;
 }
 
+/*
+ * Random numbers are generated in a bounce buffer of at most this size and
+ * copied out piecewise, the bounce buffer area of a user context is only a
+ * few KiB so the full request can't be staged there at once.
+ */
+#define RNG_GENERATE_CHUNK_SIZE	1024U
+
+/*
+ * A TA over its CFG_TA_RNG_BUDGET is served in chunks of this size with a
+ * sleep of RNG_THROTTLE_DELAY_MS in between, each crypto_rng_read() then
+ * holds the RNG for a short time only so that requests from the core and
+ * other TAs are served first.
+ */
+#define RNG_THROTTLE_CHUNK_SIZE	64U
+#define RNG_THROTTLE_DELAY_MS	1U
+
+#if defined(CFG_TA_RNG_QOS)
+static struct tee_ta_ctx *rng_qos_ctx(void)
+{
+	struct ts_session *sess = ts_get_current_session();
+
+	if (!is_user_ta_ctx(sess->ctx))
+		return NULL;
+
+	return to_ta_ctx(sess->ctx);
+}
+
+static size_t rng_qos_chunk(struct tee_ta_ctx *ctx, size_t len)
+{
+	TEE_Time t = { };
+
+	if (!ctx || tee_time_get_sys_time(&t))
+		return len;
+
+	if (!tee_ta_rng_throttle(ctx, (uint64_t)t.seconds * 1000 + t.millis))
+		return len;
+
+	tee_time_wait(RNG_THROTTLE_DELAY_MS);
+
+	return MIN(len, (size_t)RNG_THROTTLE_CHUNK_SIZE);
+}
+
+static void rng_qos_charge(struct tee_ta_ctx *ctx, size_t len)
+{
+	if (ctx)
+		tee_ta_rng_charge(ctx, len);
+}
+#else
+static struct tee_ta_ctx *rng_qos_ctx(void)
+{
+	return NULL;
+}
+
+static size_t rng_qos_chunk(struct tee_ta_ctx *ctx __unused, size_t len)
+{
+	return len;
+}
+
+static void rng_qos_charge(struct tee_ta_ctx *ctx __unused,
+			   size_t len __unused)
+{
+}
+#endif
+
 TEE_Result syscall_cryp_random_number_generate(void *buf, size_t blen)
 {
+	size_t bb_len = MIN(blen, (size_t)RNG_GENERATE_CHUNK_SIZE);
+	struct tee_ta_ctx *ctx = rng_qos_ctx();
 	TEE_Result res = TEE_SUCCESS;
+	uint8_t *ubuf = buf;
 	void *bbuf = NULL;
+	size_t n = 0;
+
+	/* Validate the whole destination before generating anything */
+	res = copy_to_user(buf, NULL, blen);
+	if (res != TEE_SUCCESS || !blen)
+		return res;
 
-	bbuf = bb_alloc(blen);
+	bbuf = bb_alloc(bb_len);
 	if (!bbuf)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	res = crypto_rng_read(bbuf, blen);
-	if (res != TEE_SUCCESS)
-		return res;
+	while (blen) {
+		n = rng_qos_chunk(ctx, MIN(blen, bb_len));
+
+		res = crypto_rng_read(bbuf, n);
+		if (res != TEE_SUCCESS)
+			break;
+		rng_qos_charge(ctx, n);
+
+		res = copy_to_user(ubuf, bbuf, n);
+		if (res != TEE_SUCCESS)
+			break;
+
+		ubuf += n;
+		blen -= n;
+	}
+
+	bb_free_wipe(bbuf, bb_len);
 
-	res = copy_to_user(buf, bbuf, blen);
 	return res;
 }
 
@@ -4217,6 +4417,127 @@ out:
 	return res;
 }
 
+static TEE_Result check_update_vec(struct user_mode_ctx *uctx,
+				   struct utee_cryp_vec *v)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t slen = 0;
+	size_t dlen = 0;
+
+	v->src = (vaddr_t)memtag_strip_tag_const((void *)(vaddr_t)v->src);
+	v->dst = (vaddr_t)memtag_strip_tag((void *)(vaddr_t)v->dst);
+
+	/* Lengths must fit in a size_t on 32-bit systems as well */
+	if (ADD_OVERFLOW(0, v->src_len, &slen) ||
+	    ADD_OVERFLOW(0, v->dst_len, &dlen))
+		return TEE_ERROR_OVERFLOW;
+
+	res = vm_check_access_rights(uctx, TEE_MEMORY_ACCESS_READ |
+					   TEE_MEMORY_ACCESS_ANY_OWNER,
+				     v->src, slen);
+	if (res)
+		return res;
+
+	return vm_check_access_rights(uctx, TEE_MEMORY_ACCESS_READ |
+					    TEE_MEMORY_ACCESS_WRITE |
+					    TEE_MEMORY_ACCESS_ANY_OWNER,
+				      v->dst, dlen);
+}
+
+/*
+ * Feeds several non-final segments to an initialized cipher or AE
+ * operation in a single user/kernel crossing. Either all segments are
+ * processed or, if any destination is too small, none of them is and
+ * each dst_len is updated with the size required for its segment.
+ */
+TEE_Result syscall_cryp_update_vec(unsigned long state,
+				   struct utee_cryp_vec *usr_vec,
+				   size_t num_vec)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct tee_cryp_state *cs = NULL;
+	struct utee_cryp_vec *vec = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Result res2 = TEE_SUCCESS;
+	bool short_buf = false;
+	void *tmp = NULL;
+	uint32_t class = 0;
+	size_t vec_size = 0;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	class = TEE_ALG_GET_CLASS(cs->algo);
+	if (class != TEE_OPERATION_CIPHER && class != TEE_OPERATION_AE)
+		return TEE_ERROR_BAD_STATE;
+
+	if (!num_vec)
+		return TEE_SUCCESS;
+	if (num_vec > UTEE_CRYP_UPDATE_VEC_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	vec_size = num_vec * sizeof(*vec);
+	res = bb_memdup_user(usr_vec, vec_size, &tmp);
+	if (res)
+		return res;
+	vec = tmp;
+
+	for (n = 0; n < num_vec; n++) {
+		res = check_update_vec(uctx, vec + n);
+		if (res)
+			goto out;
+		if (vec[n].dst_len < vec[n].src_len)
+			short_buf = true;
+	}
+
+	if (short_buf) {
+		for (n = 0; n < num_vec; n++)
+			vec[n].dst_len = vec[n].src_len;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out_copy;
+	}
+
+	enter_user_access();
+	for (n = 0; n < num_vec && !res; n++) {
+		const void *src = (const void *)(vaddr_t)vec[n].src;
+		void *dst = (void *)(vaddr_t)vec[n].dst;
+
+		dlen = vec[n].src_len;
+		if (!dlen)
+			continue;
+
+		if (class == TEE_OPERATION_CIPHER) {
+			res = tee_do_cipher_update(cs->ctx, cs->algo, cs->mode,
+						   false, src, dlen, dst);
+		} else {
+			dlen = vec[n].dst_len;
+			res = crypto_authenc_update_payload(cs->ctx, cs->mode,
+							    src, vec[n].src_len,
+							    dst, &dlen);
+		}
+		vec[n].dst_len = dlen;
+	}
+	exit_user_access();
+	if (res)
+		goto out;
+
+out_copy:
+	res2 = copy_to_user(usr_vec, vec, vec_size);
+	if (res2)
+		res = res2;
+out:
+	bb_free(vec, vec_size);
+
+	return res;
+}
+
 TEE_Result syscall_authenc_enc_final(unsigned long state, const void *src_data,
 				     size_t src_len, void *dst_data,
 				     uint64_t *dst_len, void *tag,
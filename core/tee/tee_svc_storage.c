@@ -73,9 +73,163 @@ static TEE_Result tee_svc_close_enum(struct user_ta_ctx *utc,
 	return TEE_SUCCESS;
 }
 
+#if CFG_TEE_OBJ_INFO_CACHE
+/*
+ * struct obj_info_entry - object information of a persistent object
+ * @fops:	filesystem of the object
+ * @uuid:	UUID of the TA owning the object
+ * @obj_id:	object ID
+ * @obj_id_len:	length of @obj_id
+ * @info:	object information as returned by syscall_storage_next_enum()
+ * @link:	link in obj_info_cache, most recently used first
+ *
+ * Enumerating persistent objects would otherwise open each object and
+ * read its head. An entry is removed each time the object is modified.
+ * obj_info_gen is increased at the same time, so information read from an
+ * object while it was being modified is never added.
+ */
+struct obj_info_entry {
+	const struct tee_file_operations *fops;
+	TEE_UUID uuid;
+	uint8_t obj_id[TEE_OBJECT_ID_MAX_LEN];
+	uint32_t obj_id_len;
+	struct utee_object_info info;
+	TAILQ_ENTRY(obj_info_entry) link;
+};
+
+static TAILQ_HEAD(obj_info_head, obj_info_entry) obj_info_cache =
+	TAILQ_HEAD_INITIALIZER(obj_info_cache);
+static size_t obj_info_count;
+static unsigned int obj_info_gen;
+static struct mutex obj_info_mu = MUTEX_INITIALIZER;
+
+static struct obj_info_entry *obj_info_find(struct tee_pobj *po)
+{
+	struct obj_info_entry *e = NULL;
+
+	TAILQ_FOREACH(e, &obj_info_cache, link)
+		if (e->fops == po->fops && e->obj_id_len == po->obj_id_len &&
+		    !memcmp(e->obj_id, po->obj_id, po->obj_id_len) &&
+		    !memcmp(&e->uuid, &po->uuid, sizeof(e->uuid)))
+			return e;
+
+	return NULL;
+}
+
+static bool obj_info_get(struct tee_pobj *po, struct utee_object_info *info,
+			 unsigned int *gen)
+{
+	struct obj_info_entry *e = NULL;
+
+	mutex_lock(&obj_info_mu);
+	e = obj_info_find(po);
+	if (e) {
+		*info = e->info;
+		TAILQ_REMOVE(&obj_info_cache, e, link);
+		TAILQ_INSERT_HEAD(&obj_info_cache, e, link);
+	}
+	*gen = obj_info_gen;
+	mutex_unlock(&obj_info_mu);
+
+	return e;
+}
+
+static void obj_info_put(struct tee_pobj *po,
+			 const struct utee_object_info *info, unsigned int gen)
+{
+	struct obj_info_entry *e = NULL;
+
+	if (po->obj_id_len > TEE_OBJECT_ID_MAX_LEN)
+		return;
+
+	mutex_lock(&obj_info_mu);
+	if (gen != obj_info_gen || obj_info_find(po))
+		goto out;
+
+	if (obj_info_count < CFG_TEE_OBJ_INFO_CACHE) {
+		e = calloc(1, sizeof(*e));
+		if (!e)
+			goto out;
+		obj_info_count++;
+	} else {
+		e = TAILQ_LAST(&obj_info_cache, obj_info_head);
+		TAILQ_REMOVE(&obj_info_cache, e, link);
+	}
+
+	e->fops = po->fops;
+	e->uuid = po->uuid;
+	memcpy(e->obj_id, po->obj_id, po->obj_id_len);
+	e->obj_id_len = po->obj_id_len;
+	e->info = *info;
+	TAILQ_INSERT_HEAD(&obj_info_cache, e, link);
+out:
+	mutex_unlock(&obj_info_mu);
+}
+
+static void obj_info_flush(void)
+{
+	struct obj_info_entry *e = NULL;
+
+	mutex_lock(&obj_info_mu);
+	obj_info_gen++;
+	while (!TAILQ_EMPTY(&obj_info_cache)) {
+		e = TAILQ_FIRST(&obj_info_cache);
+		TAILQ_REMOVE(&obj_info_cache, e, link);
+		free(e);
+	}
+	obj_info_count = 0;
+	mutex_unlock(&obj_info_mu);
+}
+
+/* Must be called after each modification of a persistent object */
+static void obj_info_drop(struct tee_pobj *po)
+{
+	struct obj_info_entry *e = NULL;
+
+	mutex_lock(&obj_info_mu);
+	obj_info_gen++;
+	e = obj_info_find(po);
+	if (e) {
+		TAILQ_REMOVE(&obj_info_cache, e, link);
+		obj_info_count--;
+		free(e);
+	}
+	mutex_unlock(&obj_info_mu);
+}
+#else
+static bool obj_info_get(struct tee_pobj *po __unused,
+			 struct utee_object_info *info __unused,
+			 unsigned int *gen __unused)
+{
+	return false;
+}
+
+static void obj_info_put(struct tee_pobj *po __unused,
+			 const struct utee_object_info *info __unused,
+			 unsigned int gen __unused)
+{
+}
+
+static void obj_info_flush(void)
+{
+}
+
+static void obj_info_drop(struct tee_pobj *po __unused)
+{
+}
+#endif /*CFG_TEE_OBJ_INFO_CACHE*/
+
+/* Writes through @o are kept pending if the TA has begun a transaction */
+static void join_transaction(struct user_ta_ctx *utc, struct tee_obj *o)
+{
+	if (utc->storage_trans_fops && utc->storage_trans_fops == o->pobj->fops)
+		o->pobj->fops->join_transaction(o->fh, utc);
+}
+
 static void remove_corrupt_obj(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	o->pobj->fops->remove(o->pobj);
+	obj_info_drop(o->pobj);
 	if (!(utc->ta_ctx.flags & TA_FLAG_DONT_CLOSE_HANDLE_ON_CORRUPT_OBJECT))
 		tee_obj_close(utc, o);
 }
@@ -296,6 +450,7 @@ static TEE_Result tee_svc_storage_init_file(struct tee_obj *o, bool overwrite,
 
 	res = fops->create(o->pobj, overwrite, &head, sizeof(head), attr,
 			   attr_size, NULL, data, len, &o->fh);
+	obj_info_drop(o->pobj);
 
 	if (res)
 		o->ds_pos = 0;
@@ -430,8 +585,10 @@ oclose:
 err:
 	if (res == TEE_ERROR_NO_DATA || res == TEE_ERROR_BAD_FORMAT)
 		res = TEE_ERROR_CORRUPT_OBJECT;
-	if (res == TEE_ERROR_CORRUPT_OBJECT && po)
+	if (res == TEE_ERROR_CORRUPT_OBJECT && po) {
 		fops->remove(po);
+		obj_info_drop(po);
+	}
 	if (o) {
 		fops->close(&o->fh);
 		tee_obj_free(o);
@@ -467,6 +624,7 @@ TEE_Result syscall_storage_obj_del(unsigned long obj)
 	}
 
 	res = o->pobj->fops->remove(o->pobj);
+	obj_info_drop(o->pobj);
 	tee_obj_close(utc, o);
 
 	return res;
@@ -522,6 +680,8 @@ TEE_Result syscall_storage_obj_rename(unsigned long obj, void *object_id,
 
 	/* move */
 	res = fops->rename(o->pobj, po, false /* no overwrite */);
+	obj_info_drop(o->pobj);
+	obj_info_drop(po);
 	if (res)
 		goto exit;
 
@@ -631,6 +791,7 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	struct tee_obj *o = NULL;
 	uint64_t l = 0;
 	struct utee_object_info bbuf = { };
+	unsigned int gen = 0;
 
 	res = tee_svc_storage_get_enum(utc, uref_to_vaddr(obj_enum), &e);
 	if (res != TEE_SUCCESS)
@@ -673,20 +834,25 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	o->info.handleFlags = o->pobj->flags | TEE_HANDLE_FLAG_PERSISTENT |
 			      TEE_HANDLE_FLAG_INITIALIZED;
 
-	tee_pobj_lock_usage(o->pobj);
-	res = tee_svc_storage_read_head(o);
-	bbuf = (struct utee_object_info){
-		.obj_type = o->info.objectType,
-		.obj_size = o->info.objectSize,
-		.max_obj_size = o->info.maxObjectSize,
-		.obj_usage = o->pobj->obj_info_usage,
-		.data_size = o->info.dataSize,
-		.data_pos = o->info.dataPosition,
-		.handle_flags = o->info.handleFlags,
-	};
-	tee_pobj_unlock_usage(o->pobj);
-	if (res != TEE_SUCCESS)
-		goto exit;
+	if (obj_info_get(o->pobj, &bbuf, &gen)) {
+		bbuf.handle_flags = o->info.handleFlags;
+	} else {
+		tee_pobj_lock_usage(o->pobj);
+		res = tee_svc_storage_read_head(o);
+		bbuf = (struct utee_object_info){
+			.obj_type = o->info.objectType,
+			.obj_size = o->info.objectSize,
+			.max_obj_size = o->info.maxObjectSize,
+			.obj_usage = o->pobj->obj_info_usage,
+			.data_size = o->info.dataSize,
+			.data_pos = o->info.dataPosition,
+			.handle_flags = o->info.handleFlags,
+		};
+		tee_pobj_unlock_usage(o->pobj);
+		if (res != TEE_SUCCESS)
+			goto exit;
+		obj_info_put(o->pobj, &bbuf, gen);
+	}
 
 	res = copy_to_user(info, &bbuf, sizeof(bbuf));
 	if (res)
@@ -800,7 +966,9 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 		res = TEE_ERROR_ACCESS_CONFLICT;
 		goto exit;
 	}
+	join_transaction(utc, o);
 	res = o->pobj->fops->write(o->fh, pos_tmp, NULL, data, len);
+	obj_info_drop(o->pobj);
 	if (res != TEE_SUCCESS) {
 		if (res == TEE_ERROR_CORRUPT_OBJECT) {
 			EMSG("Object corrupt");
@@ -820,8 +988,12 @@ exit:
 TEE_Result tee_svc_storage_write_usage(struct tee_obj *o, uint32_t usage)
 {
 	const size_t pos = offsetof(struct tee_svc_storage_head, objectUsage);
+	TEE_Result res = TEE_SUCCESS;
 
-	return o->pobj->fops->write(o->fh, pos, &usage, NULL, sizeof(usage));
+	res = o->pobj->fops->write(o->fh, pos, &usage, NULL, sizeof(usage));
+	obj_info_drop(o->pobj);
+
+	return res;
 }
 
 TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
@@ -859,7 +1031,9 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 		res = TEE_ERROR_OVERFLOW;
 		goto exit;
 	}
+	join_transaction(to_user_ta_ctx(sess->ctx), o);
 	res = o->pobj->fops->truncate(o->fh, off);
+	obj_info_drop(o->pobj);
 	switch (res) {
 	case TEE_SUCCESS:
 		o->info.dataSize = len;
@@ -921,6 +1095,47 @@ TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 	return TEE_SUCCESS;
 }
 
+TEE_Result syscall_storage_transaction(unsigned long storage_id,
+				       unsigned long op)
+{
+	const struct tee_file_operations *fops =
+			tee_svc_storage_file_ops(storage_id);
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (!fops->commit_transaction)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	switch (op) {
+	case UTEE_STORAGE_TRANSACTION_BEGIN:
+		if (utc->storage_trans_fops)
+			return TEE_ERROR_BAD_STATE;
+		utc->storage_trans_fops = fops;
+		return TEE_SUCCESS;
+	case UTEE_STORAGE_TRANSACTION_COMMIT:
+		if (utc->storage_trans_fops != fops)
+			return TEE_ERROR_BAD_STATE;
+		utc->storage_trans_fops = NULL;
+		res = fops->commit_transaction(utc);
+		/* The pending changes weren't visible to the cache before */
+		obj_info_flush();
+		return res;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+void tee_svc_storage_abort_transaction(struct user_ta_ctx *utc)
+{
+	if (utc->storage_trans_fops) {
+		utc->storage_trans_fops->abort_transaction(utc);
+		utc->storage_trans_fops = NULL;
+	}
+}
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc)
 {
 	struct tee_storage_enum_head *eh = &utc->storage_enums;
@@ -4,6 +4,11 @@
  */
 
 #include <assert.h>
+#if defined(ARM32) || defined(ARM64)
+#include <arm_user_sysreg.h>
+#elif defined(RV32) || defined(RV64)
+#include <riscv_user_sysreg.h>
+#endif
 #include <printk.h>
 #include <string.h>
 #include <sys/queue.h>
@@ -29,7 +34,8 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	size_t fbuf_size = 0;
 	size_t pad = 0;
 	char *p = NULL;
-	char magic[] = { 'F', 'T', 'R', 'A', 'C', 'E', 0x00, 0x01 };
+	char magic[] = { 'F', 'T', 'R', 'A', 'C', 'E', 0x00, 0x02 };
+	uint64_t freq = read_cntfrq();
 
 	res = ta_elf_resolve_sym("__ftrace_info", &val, NULL, NULL);
 	if (res)
@@ -61,6 +67,7 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	fbuf->ret_idx = 0;
 	fbuf->lr_idx = 0;
 	fbuf->suspend_time = 0;
+	fbuf->suspended = 0;
 	fbuf->buf_off = fbuf->head_off + count;
 	/* For proper alignment of uint64_t values in the ftrace buffer  */
 	pad = 8 - (vaddr_t)p % 8;
@@ -73,8 +80,13 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	}
 	/* Delimiter for easier decoding */
 	memcpy(p, magic, sizeof(magic));
+	p += sizeof(magic);
 	fbuf->buf_off += sizeof(magic);
 	count += sizeof(magic);
+	/* Frequency of the counter used for the times in the buffer */
+	memcpy(p, &freq, sizeof(freq));
+	fbuf->buf_off += sizeof(freq);
+	count += sizeof(freq);
 	fbuf->curr_idx = 0;
 	fbuf->max_size = fbuf_size - sizeof(struct ftrace_buf) - count;
 	fbuf->syscall_trace_enabled = false;
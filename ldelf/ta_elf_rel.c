@@ -277,17 +277,59 @@ static void e32_get_sym_name(const Elf32_Sym *sym_tab, size_t num_syms,
 		*weak_undef = false;
 }
 
+/*
+ * Direct mapped cache of symbols resolved for relocations, indexed by the
+ * GNU hash of the name. The same symbol is typically imported by several
+ * relocations and several modules, and each miss walks the hash tables of
+ * all modules.
+ *
+ * Modules are only ever appended to main_elf_queue, so the first module
+ * defining a symbol never changes once the symbol has been found. Names
+ * point into the string table of the relocated module, which stays
+ * mapped.
+ */
+#define SYM_CACHE_SIZE	128
+
+struct sym_cache_entry {
+	const char *name;
+	uint32_t hash;
+	vaddr_t val;
+	struct ta_elf *elf;
+};
+
+static struct sym_cache_entry sym_cache[SYM_CACHE_SIZE];
+
 static void resolve_sym(const char *name, vaddr_t *val, struct ta_elf **mod,
 			bool err_if_not_found)
 {
-	TEE_Result res = ta_elf_resolve_sym(name, val, mod, NULL);
-
-	if (res) {
-		if (err_if_not_found)
-			err(res, "Symbol %s not found", name);
-		else if (val)
-			*val = 0;
+	uint32_t hash = gnu_hash(name);
+	struct sym_cache_entry *e = sym_cache + hash % SYM_CACHE_SIZE;
+	struct ta_elf *found_elf = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t found_val = 0;
+
+	if (e->name && e->hash == hash && !strcmp(e->name, name)) {
+		found_val = e->val;
+		found_elf = e->elf;
+	} else {
+		res = ta_elf_resolve_sym(name, &found_val, &found_elf, NULL);
+		if (res) {
+			if (err_if_not_found)
+				err(res, "Symbol %s not found", name);
+			else if (val)
+				*val = 0;
+			return;
+		}
+		e->name = name;
+		e->hash = hash;
+		e->val = found_val;
+		e->elf = found_elf;
 	}
+
+	if (val)
+		*val = found_val;
+	if (mod)
+		*mod = found_elf;
 }
 
 static void e32_process_dyn_rel(const Elf32_Sym *sym_tab, size_t num_syms,
@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
+#include <kernel/mutex.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/pk.h>
@@ -177,16 +178,83 @@ static void mbd_rsa_free(mbedtls_rsa_context *rsa, struct rsa_keypair *key)
 	mbedtls_rsa_free(rsa);
 }
 
-static void mbd_pk_free(mbedtls_pk_context *ctx, struct rsa_keypair *key)
+/*
+ * Private key operations use a completed copy of the key kept in
+ * key->priv. The primes and CRT parameters deduced when missing from the
+ * key, the Montgomery constants RN, RP and RQ and the blinding values are
+ * then computed once per key instead of once per operation.
+ */
+struct rsa_cache {
+	struct mutex lock;
+	mbedtls_rsa_context rsa;
+};
+
+/* Serializes the creation of key->priv */
+static struct mutex rsa_cache_mu = MUTEX_INITIALIZER;
+
+/*
+ * Return in @rsa the cached context of @key, creating it if needed. The
+ * context is locked until released with rsa_cache_put().
+ */
+static TEE_Result rsa_cache_get(struct rsa_keypair *key,
+				mbedtls_rsa_context **rsa)
+{
+	TEE_Result res = TEE_SUCCESS;
+	mbedtls_rsa_context tmp = { };
+	struct rsa_cache *c = NULL;
+
+	mutex_lock(&rsa_cache_mu);
+	c = key->priv;
+	if (!c) {
+		c = calloc(1, sizeof(*c));
+		if (!c) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+		mutex_init(&c->lock);
+		mbedtls_rsa_init(&c->rsa);
+
+		res = rsa_init_and_complete_from_key_pair(&tmp, key);
+		if (!res) {
+			if (mbedtls_rsa_copy(&c->rsa, &tmp))
+				res = TEE_ERROR_OUT_OF_MEMORY;
+			mbd_rsa_free(&tmp, key);
+		}
+		if (res) {
+			mbedtls_rsa_free(&c->rsa);
+			free(c);
+			goto out;
+		}
+		key->priv = c;
+	}
+out:
+	mutex_unlock(&rsa_cache_mu);
+	if (res)
+		return res;
+
+	mutex_lock(&c->lock);
+	*rsa = &c->rsa;
+
+	return TEE_SUCCESS;
+}
+
+static void rsa_cache_put(struct rsa_keypair *key)
 {
-	mbedtls_rsa_context *rsa = ctx->pk_ctx;
+	struct rsa_cache *c = key->priv;
 
-	/*
-	 * Executing mbedtls_rsa_free twice is fine, as it does nothing if its
-	 * argument is NULL.
-	 */
-	mbd_rsa_free(rsa, key);
-	mbedtls_pk_free(ctx);
+	mutex_unlock(&c->lock);
+}
+
+void crypto_acipher_rsa_keypair_changed(struct rsa_keypair *s)
+{
+	struct rsa_cache *c = s->priv;
+
+	if (!c)
+		return;
+
+	s->priv = NULL;
+	mbedtls_rsa_free(&c->rsa);
+	free(c);
 }
 
 TEE_Result crypto_acipher_alloc_rsa_keypair(struct rsa_keypair *s,
@@ -266,6 +334,7 @@ void sw_crypto_acipher_free_rsa_keypair(struct rsa_keypair *s)
 {
 	if (!s)
 		return;
+	crypto_acipher_rsa_keypair_changed(s);
 	crypto_bignum_free(&s->e);
 	crypto_bignum_free(&s->d);
 	crypto_bignum_free(&s->n);
@@ -405,13 +474,13 @@ TEE_Result sw_crypto_acipher_rsanopad_decrypt(struct rsa_keypair *key,
 					      size_t *dst_len)
 {
 	TEE_Result res = TEE_SUCCESS;
-	mbedtls_rsa_context rsa = { };
+	mbedtls_rsa_context *rsa = NULL;
 	int lmd_res = 0;
 	uint8_t *buf = NULL;
 	unsigned long blen = 0;
 	unsigned long offset = 0;
 
-	res = rsa_init_and_complete_from_key_pair(&rsa, key);
+	res = rsa_cache_get(key, &rsa);
 	if (res)
 		return res;
 
@@ -423,9 +492,9 @@ TEE_Result sw_crypto_acipher_rsanopad_decrypt(struct rsa_keypair *key,
 	}
 
 	memset(buf, 0, blen);
-	memcpy(buf + rsa.len - src_len, src, src_len);
+	memcpy(buf + rsa->len - src_len, src, src_len);
 
-	lmd_res = mbedtls_rsa_private(&rsa, mbd_rand, NULL, buf, buf);
+	lmd_res = mbedtls_rsa_private(rsa, mbd_rand, NULL, buf, buf);
 	if (lmd_res != 0) {
 		FMSG("mbedtls_rsa_private() returned 0x%x", -lmd_res);
 		res = get_tee_result(lmd_res);
@@ -434,20 +503,20 @@ TEE_Result sw_crypto_acipher_rsanopad_decrypt(struct rsa_keypair *key,
 
 	/* Remove the zero-padding (leave one zero if buff is all zeroes) */
 	offset = 0;
-	while ((offset < rsa.len - 1) && (buf[offset] == 0))
+	while ((offset < rsa->len - 1) && (buf[offset] == 0))
 		offset++;
 
-	if (*dst_len < rsa.len - offset) {
-		*dst_len = rsa.len - offset;
+	if (*dst_len < rsa->len - offset) {
+		*dst_len = rsa->len - offset;
 		res = TEE_ERROR_SHORT_BUFFER;
 		goto out;
 	}
-	*dst_len = rsa.len - offset;
+	*dst_len = rsa->len - offset;
 	memcpy(dst, (char *)buf + offset, *dst_len);
 out:
 	if (buf)
 		free(buf);
-	mbd_rsa_free(&rsa, key);
+	rsa_cache_put(key);
 	return res;
 }
 
@@ -484,16 +553,12 @@ TEE_Result sw_crypto_acipher_rsaes_decrypt(uint32_t algo,
 		return TEE_ERROR_NOT_SUPPORTED;
 	}
 
-	mbedtls_pk_init(&ctx);
-	res = mbedtls_pk_setup(&ctx, pk_info);
-	if (res != 0) {
-		goto out;
-	}
-
-	rsa = ctx.pk_ctx;
-	res = rsa_complete_from_key_pair(rsa, key);
+	res = rsa_cache_get(key, &rsa);
 	if (res)
 		return res;
+	/* The context is owned by the cache, mbedtls_pk_setup() isn't used */
+	ctx.pk_info = pk_info;
+	ctx.pk_ctx = rsa;
 
 	/*
 	 * Use a temporary buffer since we don't know exactly how large
@@ -555,7 +620,7 @@ TEE_Result sw_crypto_acipher_rsaes_decrypt(uint32_t algo,
 out:
 	if (buf)
 		free(buf);
-	mbd_pk_free(&ctx, key);
+	rsa_cache_put(key);
 	return res;
 }
 
@@ -677,16 +742,12 @@ TEE_Result sw_crypto_acipher_rsassa_sign(uint32_t algo, struct rsa_keypair *key,
 		return TEE_ERROR_NOT_SUPPORTED;
 	}
 
-	mbedtls_pk_init(&ctx);
-	res = mbedtls_pk_setup(&ctx, pk_info);
-	if (res != 0) {
-		goto err;
-	}
-
-	rsa = ctx.pk_ctx;
-	res = rsa_complete_from_key_pair(rsa, key);
+	res = rsa_cache_get(key, &rsa);
 	if (res)
 		return res;
+	/* The context is owned by the cache, mbedtls_pk_setup() isn't used */
+	ctx.pk_info = pk_info;
+	ctx.pk_ctx = rsa;
 
 	switch (algo) {
 	case TEE_ALG_RSASSA_PKCS1_V1_5_MD5:
@@ -746,7 +807,7 @@ TEE_Result sw_crypto_acipher_rsassa_sign(uint32_t algo, struct rsa_keypair *key,
 	}
 	res = TEE_SUCCESS;
 err:
-	mbd_pk_free(&ctx, key);
+	rsa_cache_put(key);
 	return res;
 }
 
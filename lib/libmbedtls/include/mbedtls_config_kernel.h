@@ -11,6 +11,10 @@
 #endif
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_GENPRIME
+#if defined(CFG_CORE_MBEDTLS_MPI_ASM)
+/* Arm assembly for the constant-time bignum core and Montgomery kernels */
+#define MBEDTLS_HAVE_ASM
+#endif
 
 /* Test if Mbedtls is the primary crypto lib */
 #ifdef CFG_CRYPTOLIB_NAME_mbedtls
@@ -124,6 +128,10 @@
 #define MBEDTLS_ECDSA_C
 #define MBEDTLS_ECDH_C
 #define MBEDTLS_ECDH_LEGACY_CONTEXT
+#if !defined(CFG_CRYPTO_ECC_FIXED_BASE)
+/* Drop the static comb tables of the fixed base point multiplication */
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM	0
+#endif
 #if defined(CFG_CRYPTO_DSA) || defined(CFG_CRYPTO_SM2_PKE) || \
 	defined(CFG_CRYPTO_SM2_KEP)
 #define MBEDTLS_ECP_DP_SM2_ENABLED
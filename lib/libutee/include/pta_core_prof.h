@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Profile where the core spends its time, CFG_CORE_PC_SAMPLING=y.
+ *
+ * The program counter of the core is sampled each time a thread running
+ * in the core is preempted by a normal world interrupt. The samples are
+ * accumulated in a histogram over the text of the core, which the
+ * normal world resolves to symbols with tee.elf.
+ */
+
+#ifndef __PTA_CORE_PROF_H
+#define __PTA_CORE_PROF_H
+
+#define PTA_CORE_PROF_UUID { 0x9d063dab, 0x5816, 0x457e, \
+		{ 0x9f, 0x0c, 0xd9, 0xcf, 0x22, 0x2f, 0x10, 0x83 } }
+
+/*
+ * Start sampling, discarding any previous histogram
+ *
+ * [in]		value[0].a: Log2 of the number of bytes covered by each
+ *			    bucket of the histogram, at least 1
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_OUT_OF_MEMORY - Not enough memory for the histogram
+ */
+#define PTA_CORE_PROF_CMD_START		0
+
+/*
+ * Stop sampling
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ */
+#define PTA_CORE_PROF_CMD_STOP		1
+
+/*
+ * Read the histogram of a stopped sampling
+ *
+ * Bucket n, a uint32_t, counts the samples in the 2^shift bytes of text
+ * starting at __text_start + (n << shift), with __text_start as linked
+ * in tee.elf.
+ *
+ * [out]	memref[0]: The histogram
+ * [out]	value[1].a: Shift given when starting
+ * [out]	value[1].b: Total number of samples, including those outside
+ *			    of the text of the core
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_BAD_STATE - Sampling isn't stopped or never started
+ * TEE_ERROR_SHORT_BUFFER - memref[0] is too small, its size is updated
+ */
+#define PTA_CORE_PROF_CMD_READ		2
+
+#endif /* __PTA_CORE_PROF_H */
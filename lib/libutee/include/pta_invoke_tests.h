@@ -6,6 +6,8 @@
 #ifndef __PTA_INVOKE_TESTS_H
 #define __PTA_INVOKE_TESTS_H
 
+#include <stdint.h>
+
 #define PTA_INVOKE_TESTS_UUID \
 		{ 0xd96a5b40, 0xc3e5, 0x21e3, \
 			{ 0x87, 0x94, 0x10, 0x02, 0xa5, 0xd5, 0xc6, 0x1b } }
@@ -108,5 +110,188 @@
  */
 #define PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS	11
 
+#define PTA_INVOKE_TESTS_RNG_CRYPTO		0
+#define PTA_INVOKE_TESTS_RNG_HW			1
+
+/* Results of the performance tests, latencies are per operation */
+struct pta_invoke_tests_perf {
+	uint64_t total_us;
+	uint64_t min_us;
+	uint64_t p50_us;
+	uint64_t p90_us;
+	uint64_t p99_us;
+	uint64_t max_us;
+	uint64_t bytes_per_sec;
+};
+
+/*
+ * RNG performance tests
+ *
+ * [in]     value[0].a	Source, one of PTA_INVOKE_TESTS_RNG_{CRYPTO,HW},
+ *			crypto_rng_read() or hw_get_random_bytes()
+ * [in]     value[0].b	Request size in bytes
+ * [in]     value[1].a	Repetition count, at most 4096
+ * [out]    memref[2]	Output buffer, at least the request size
+ * [out]    memref[3]	struct pta_invoke_tests_perf
+ *
+ * The PTA is concurrent, invoking the command from several threads at
+ * once measures the contention on the RNG.
+ */
+#define PTA_INVOKE_TESTS_CMD_RNG_PERF		12
+
+#define PTA_INVOKE_TESTS_CRYPTO_HASH		0
+#define PTA_INVOKE_TESTS_CRYPTO_MAC		1
+#define PTA_INVOKE_TESTS_CRYPTO_HKDF		2
+#define PTA_INVOKE_TESTS_CRYPTO_PBKDF2		3
+#define PTA_INVOKE_TESTS_CRYPTO_SIGN		4
+#define PTA_INVOKE_TESTS_CRYPTO_VERIFY		5
+
+/*
+ * Crypto performance tests
+ *
+ * [in]     value[0].a	Operation, one of PTA_INVOKE_TESTS_CRYPTO_*
+ * [in]     value[0].b	Algorithm: TEE_ALG_* hash for HASH, HKDF and
+ *			PBKDF2, TEE_ALG_HMAC_* or TEE_ALG_AES_CMAC for MAC,
+ *			TEE_ALG_RSASSA_* or TEE_ALG_ECDSA_* for SIGN and
+ *			VERIFY
+ * [in]     value[1].a	Repetition count, at most 4096
+ * [in]     value[1].b	Key size in bits for MAC, SIGN and VERIFY,
+ *			iteration count for PBKDF2
+ * [in]     memref[2]	Input: data to hash or MAC, input key material
+ *			of HKDF, password of PBKDF2 or, for SIGN and VERIFY,
+ *			digest to sign of the size of the hash of the
+ *			algorithm
+ * [out]    memref[3]	struct pta_invoke_tests_perf, bytes_per_sec is
+ *			relative to the size of memref[2]
+ *
+ * The key of SIGN and VERIFY is generated first and isn't included in
+ * the results. The implementation measured is the one the core uses,
+ * that is a crypto driver when one is registered for the algorithm.
+ */
+#define PTA_INVOKE_TESTS_CMD_CRYPTO_PERF	13
+
+#define PTA_INVOKE_TESTS_STORAGE_CREATE		0
+#define PTA_INVOKE_TESTS_STORAGE_OPEN		1
+#define PTA_INVOKE_TESTS_STORAGE_READ		2
+#define PTA_INVOKE_TESTS_STORAGE_WRITE		3
+#define PTA_INVOKE_TESTS_STORAGE_TRUNCATE	4
+#define PTA_INVOKE_TESTS_STORAGE_RENAME		5
+#define PTA_INVOKE_TESTS_STORAGE_ENUMERATE	6
+#define PTA_INVOKE_TESTS_STORAGE_REMOVE		7
+
+/*
+ * Results of the secure storage performance tests. @rpc_us and
+ * @crypto_us are the parts of @perf.total_us spent in RPC to normal
+ * world and in the encryption and hashing of the data, the rest is
+ * spent in the management of the hash tree and of the file system.
+ */
+struct pta_invoke_tests_storage_perf {
+	struct pta_invoke_tests_perf perf;
+	uint64_t rpc_us;
+	uint64_t crypto_us;
+};
+
+/*
+ * Secure storage performance tests
+ *
+ * [in]     value[0].a	Storage, TEE_STORAGE_PRIVATE_REE or
+ *			TEE_STORAGE_PRIVATE_RPMB
+ * [in]     value[0].b	Operation, one of PTA_INVOKE_TESTS_STORAGE_*
+ * [in]     value[1].a	Object count, at most 256
+ * [in]     value[1].b	Object data size in bytes
+ * [out]    memref[3]	struct pta_invoke_tests_storage_perf
+ *
+ * Each object is the target of one timed operation: CREATE creates it
+ * with value[1].b bytes of data, WRITE writes that many bytes to an
+ * empty object, READ reads them back, TRUNCATE halves the object and
+ * OPEN opens and closes it. ENUMERATE times each entry of one
+ * enumeration of all the objects. The objects are created before and
+ * removed after the timed operations, in the namespace of this PTA.
+ *
+ * @rpc_us and @crypto_us are only reported with
+ * CFG_CORE_THREAD_TIME_STATS=y. @rpc_us also includes the time the
+ * thread is suspended by foreign interrupts.
+ */
+#define PTA_INVOKE_TESTS_CMD_STORAGE_PERF	14
+
+#define PTA_INVOKE_TESTS_LATENCY_ENTRY		0
+#define PTA_INVOKE_TESTS_LATENCY_RPC		1
+#define PTA_INVOKE_TESTS_LATENCY_SHM		2
+#define PTA_INVOKE_TESTS_LATENCY_SESSION	3
+#define PTA_INVOKE_TESTS_LATENCY_INVOKE		4
+
+/*
+ * Fixed cost latency tests, a baseline for changes to the threading and
+ * MMU code
+ *
+ * [in]     value[0].a	Operation, one of PTA_INVOKE_TESTS_LATENCY_*
+ * [in]     value[0].b	Repetition count, at most 4096
+ * [out]    value[1].a	Counter value when the command was dispatched,
+ *			upper 32 bits
+ * [out]    value[1].b	Counter value when the command was dispatched,
+ *			lower 32 bits
+ * [in]     memref[2]	UUID of a user TA for SESSION and INVOKE,
+ *			may be omitted otherwise
+ * [out]    memref[3]	struct pta_invoke_tests_perf
+ *
+ * ENTRY only reports the counter value, the generic timer is shared with
+ * normal world which compares it with its own readings before and after
+ * the call to measure the world switch and thread dispatch. RPC does an
+ * OPTEE_RPC_CMD_GET_TIME round trip to normal world, SHM allocates and
+ * frees one page of shared memory with RPC, SESSION opens and closes a
+ * session to the user TA and INVOKE invokes command 0 on a session to it,
+ * which enters user mode and returns through the syscall path. The
+ * result of command 0 in the TA itself is ignored.
+ */
+#define PTA_INVOKE_TESTS_CMD_LATENCY_PERF	15
+
+/* Checks of struct pta_invoke_tests_rng_result::failed */
+#define PTA_INVOKE_TESTS_RNG_CHECK_LENGTHS	0x01
+#define PTA_INVOKE_TESTS_RNG_CHECK_REPEAT	0x02
+#define PTA_INVOKE_TESTS_RNG_CHECK_MONOBIT	0x04
+#define PTA_INVOKE_TESTS_RNG_CHECK_POKER	0x08
+#define PTA_INVOKE_TESTS_RNG_CHECK_RUNS		0x10
+#define PTA_INVOKE_TESTS_RNG_CHECK_LONG_RUN	0x20
+
+/*
+ * Results of the RNG conformance tests. @failed is a mask of the
+ * PTA_INVOKE_TESTS_RNG_CHECK_* that failed, zero if all passed. @ones,
+ * @poker_x100 (the poker statistic times 100) and @longest_run are the
+ * statistics of the 20000 bit sample. @perf is only filled in when a
+ * repetition count is supplied.
+ */
+struct pta_invoke_tests_rng_result {
+	uint32_t failed;
+	uint32_t ones;
+	uint32_t poker_x100;
+	uint32_t longest_run;
+	struct pta_invoke_tests_perf perf;
+};
+
+/*
+ * RNG conformance tests
+ *
+ * [in]     value[0].a	Source, one of PTA_INVOKE_TESTS_RNG_{CRYPTO,HW}
+ * [in]     value[0].b	Request size in bytes for @perf, at most 4096
+ * [in]     value[1].a	Repetition count for @perf, at most 4096, 0 to
+ *			skip the measurement
+ * [out]    memref[3]	struct pta_invoke_tests_rng_result
+ *
+ * The checks apply to any provider of the source:
+ * LENGTHS  requests of 1 to 40 bytes at every alignment fill the buffer
+ *          and don't write outside of it
+ * REPEAT   no two successive 16 byte requests return the same data, the
+ *          continuous RNG test of FIPS 140-2 section 4.9.2
+ * MONOBIT, POKER, RUNS, LONG_RUN
+ *          the statistical tests of FIPS 140-2 section 4.9.1 on a 20000
+ *          bit sample made of those 16 byte requests
+ *
+ * Known answer tests need a deterministic source and are left to the
+ * drivers. The command succeeds when the checks could be run, whether
+ * they passed or not is reported in @failed. @perf is measured as with
+ * PTA_INVOKE_TESTS_CMD_RNG_PERF and needs CFG_CORE_HAS_GENERIC_TIMER=y.
+ */
+#define PTA_INVOKE_TESTS_CMD_RNG_TESTS		16
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
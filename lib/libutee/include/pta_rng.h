@@ -6,6 +6,8 @@
 #ifndef __PTA_RNG_H
 #define __PTA_RNG_H
 
+#include <stdint.h>
+
 #define PTA_RNG_UUID { 0xab7a617c, 0xb8e7, 0x4d8f, \
 		{ 0x83, 0x01, 0xd0, 0x9b, 0x61, 0x03, 0x6b, 0x64 } }
 
@@ -42,4 +44,65 @@
  */
 #define PTA_CMD_GET_RNG_INFO		0x1
 
+/*
+ * PTA_CMD_GET_ENTROPY_BULK - Fill a large buffer with entropy
+ *
+ * [in/out]   memref[0] - Entropy buffer memory reference
+ * [out]      value[1].a - Number of bytes written at the start of memref[0]
+ * param[2] unused
+ * param[3] unused
+ *
+ * The buffer is filled in one invocation as long as this takes no more
+ * than a platform defined time budget, otherwise the call returns early
+ * with the buffer partially filled.
+ *
+ * Result:
+ * TEE_SUCCESS - Invoke command success, at least one byte was written
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ */
+#define PTA_CMD_GET_ENTROPY_BULK	0x2
+
+/*
+ * Header at the start of the buffer registered with PTA_CMD_SET_PUSH_SHM,
+ * followed by @size bytes of entropy.
+ *
+ * The secure world fills the data while @state is PTA_RNG_PUSH_EMPTY,
+ * then sets @state to PTA_RNG_PUSH_FULL and sends the asynchronous
+ * notification returned by PTA_CMD_SET_PUSH_SHM. @state is written after
+ * the data it covers, so a reader should load it with acquire semantics.
+ * Once the normal world has consumed the data it sets @state back to
+ * PTA_RNG_PUSH_EMPTY and must not access the data until the next
+ * notification. The secure world checks @state periodically.
+ */
+struct pta_rng_push_hdr {
+	uint32_t state;
+	uint32_t size;
+};
+
+#define PTA_RNG_PUSH_EMPTY		0
+#define PTA_RNG_PUSH_FULL		1
+
+/*
+ * PTA_CMD_SET_PUSH_SHM - Register a buffer to receive entropy
+ *
+ * [in]       value[0].a - Physical address of the buffer, upper 32 bits
+ * [in]       value[0].b - Physical address of the buffer, lower 32 bits
+ * [in]       value[1].a - Size of the buffer
+ * [out]      value[2].a - Asynchronous notification value sent each time
+ *			   the buffer has been filled
+ * param[3] unused
+ *
+ * See struct pta_rng_push_hdr. The buffer is filled for the first time
+ * shortly after registration. Can only be done once.
+ *
+ * Result:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param, or the buffer is too
+ *			      small or not non-secure memory
+ * TEE_ERROR_BAD_STATE - A buffer is already registered
+ * TEE_ERROR_NOT_SUPPORTED - Asynchronous notifications aren't available
+ * TEE_ERROR_OUT_OF_MEMORY - The buffer can't be mapped
+ */
+#define PTA_CMD_SET_PUSH_SHM		0x3
+
 #endif /* __PTA_RNG_H */
@@ -6,6 +6,9 @@
 #ifndef __PTA_SOCKET
 #define __PTA_SOCKET
 
+#include <stdint.h>
+#include <util.h>
+
 #define PTA_SOCKET_UUID { 0x3b996a7d, 0x2c2b, 0x4a49, { \
 			  0xa8, 0x96, 0xe1, 0xfb, 0x57, 0x66, 0xd2, 0xf4 } }
 
@@ -48,4 +51,55 @@
  */
 #define PTA_SOCKET_IOCTL	5
 
+/*
+ * Sets up a ring of non-secure shared memory for a socket, mapped in the
+ * calling TA and shared with tee-supplicant. The TA queues data to send
+ * and consumes received data directly in the ring, tee-supplicant moves
+ * data between the ring and the socket when kicked with
+ * PTA_SOCKET_RING_KICK. The ring is released when the socket is closed.
+ * Data in the ring is visible to the normal world.
+ *
+ * [in]		value[0].a	socket handle
+ * [in]		value[0].b	size of each data area, a power of 2
+ * [out]	value[1].a	upper 32 bits of the ring address
+ * [out]	value[1].b	lower 32 bits of the ring address
+ */
+#define PTA_SOCKET_RING_SETUP	6
+
+/*
+ * Sends the data queued in the ring and receives into its free space,
+ * waiting until data can be received or all queued data is sent.
+ *
+ * [in]		value[0].a	socket handle
+ * [in]		value[0].b	timeout ms or TEE_TIMEOUT_INFINITE
+ * [out]	value[1].a	PTA_SOCKET_RING_* readiness events
+ */
+#define PTA_SOCKET_RING_KICK	7
+
+/* Readiness events of a socket ring */
+#define PTA_SOCKET_RING_READABLE	BIT32(0)
+#define PTA_SOCKET_RING_WRITABLE	BIT32(1)
+#define PTA_SOCKET_RING_HUP		BIT32(2)
+
+/*
+ * struct pta_socket_ring - Header of a socket ring
+ * @tx_head:	Bytes queued for sending, advanced by the TA
+ * @tx_tail:	Bytes sent, advanced by tee-supplicant
+ * @rx_head:	Bytes received, advanced by tee-supplicant
+ * @rx_tail:	Bytes consumed, advanced by the TA
+ * @size:	Size of each data area
+ *
+ * The header is followed by the send data area and then the receive data
+ * area. The counters are free running, the data of a counter value @c is
+ * at offset @c & (@size - 1) in its data area.
+ */
+struct pta_socket_ring {
+	uint32_t tx_head;
+	uint32_t tx_tail;
+	uint32_t rx_head;
+	uint32_t rx_tail;
+	uint32_t size;
+	uint32_t reserved[3];
+};
+
 #endif /*__PTA_SOCKET*/
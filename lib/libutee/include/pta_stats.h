@@ -22,6 +22,8 @@
  * [out]    value[1].b        R/W faults since last stats dump
  * [out]    value[2].a        Hidden faults since last stats dump
  * [out]    value[2].b        Zi pages released since last stats dump
+ * [out]    value[3].a        Optional, pages read ahead since last stats dump
+ * [out]    value[3].b        Optional, read-ahead pages used since last dump
  */
 #define STATS_CMD_PAGER_STATS		0
 
@@ -30,6 +32,11 @@
  *
  * [in]     value[0].a       ID of allocator(s) to get stats from (ALLOC_ID_*)
  * [out]    memref[0]        Array of struct pta_stats_alloc instances
+ *
+ * For ALLOC_ID_HEAP_CACHE, allocated is the size of the free buffers held
+ * by the caches, which the core heap counts as allocated, size is the
+ * most the caches can hold and num_alloc_fail counts the allocations the
+ * caches couldn't serve.
  */
 #define STATS_CMD_ALLOC_STATS		1
 
@@ -39,7 +46,8 @@
 #define ALLOC_ID_TA_RAM		3	/* TA_RAM allocator */
 #define ALLOC_ID_NEXUS_HEAP	4	/* Nexus heap allocator */
 #define ALLOC_ID_RPMB		5	/* RPMB secure storage */
-#define STATS_NB_POOLS		5
+#define ALLOC_ID_HEAP_CACHE	6	/* Small buffer caches of core heap */
+#define STATS_NB_POOLS		6
 
 #define TEE_ALLOCATOR_DESC_LENGTH 32
 
@@ -92,4 +100,323 @@ struct pta_stats_ta {
 #define STATS_DRIVER_TYPE_CLOCK		0
 #define STATS_DRIVER_TYPE_REGULATOR	1
 
+/*
+ * STATS_CMD_RNG_EVENT_STATS - Get accounting of RNG entropy events
+ *
+ * [out]    value[0].a        Events added to the pools, high 32 bits
+ * [out]    value[0].b        Events added to the pools, low 32 bits
+ * [out]    value[1].a        Events dropped, high 32 bits
+ * [out]    value[1].b        Events dropped, low 32 bits
+ */
+#define STATS_CMD_RNG_EVENT_STATS	6
+
+/*
+ * STATS_CMD_RNG_STATS - Get runtime statistics of the core RNG
+ *
+ * [out]    memref[0]        Struct pta_stats_rng
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_RNG_STATS is enabled.
+ */
+#define STATS_CMD_RNG_STATS		7
+
+struct pta_stats_rng {
+	uint64_t calls;			/* crypto_rng_read() calls */
+	uint64_t bytes;			/* Bytes served */
+	uint64_t failures;		/* Failed calls */
+	uint64_t avg_latency_us;	/* Average latency of successful calls */
+	uint64_t max_latency_us;	/* Maximum latency of a call */
+	uint64_t reseeds;		/* DRBG or hardware reseeds */
+	uint64_t health_failures;	/* Failed entropy health tests */
+	uint64_t busy_wait_us;		/* Time drivers spent polling */
+	uint64_t seed_bytes;		/* Bytes since last reseed, if known */
+	uint64_t seed_requests;		/* Requests since last reseed, if known */
+	uint64_t events_consumed;	/* Entropy events added to the pools */
+	uint64_t events_dropped;	/* Entropy events dropped */
+};
+
+/*
+ * STATS_CMD_RNG_TA_STATS - Get random number usage of loaded user TAs
+ *
+ * [out]    memref[0]        Array of struct pta_stats_rng_ta, one per TA
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_TA_RNG_QOS is enabled,
+ * TEE_ERROR_ITEM_NOT_FOUND if no user TA is loaded and
+ * TEE_ERROR_SHORT_BUFFER with the required size in memref[0].size if the
+ * buffer is too small.
+ */
+#define STATS_CMD_RNG_TA_STATS		8
+
+struct pta_stats_rng_ta {
+	TEE_UUID uuid;
+	uint64_t bytes;			/* Bytes generated for the TA */
+	uint64_t throttled;		/* Chunks served at throttled rate */
+	uint64_t window_bytes;		/* Bytes in current budget window */
+};
+
+/*
+ * STATS_CMD_CRYP_POOL_STATS - Get accounting of the crypto context pool
+ *
+ * [out]    value[0].a        Contexts served from the pool, high 32 bits
+ * [out]    value[0].b        Contexts served from the pool, low 32 bits
+ * [out]    value[1].a        Contexts newly allocated, high 32 bits
+ * [out]    value[1].b        Contexts newly allocated, low 32 bits
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CRYPTO_CTX_POOL is enabled.
+ */
+#define STATS_CMD_CRYP_POOL_STATS	9
+
+/*
+ * STATS_CMD_THREAD_STATS - Get statistics on the core thread pool
+ *
+ * [out]    value[0].a        Calls refused because all threads were busy
+ * [out]    value[0].b        Threads which have a stack
+ * [out]    value[1].a        Threads with a statically reserved stack
+ * [out]    value[1].b        Maximum number of threads (CFG_NUM_THREADS)
+ * [out]    value[2].a        Threads allowed to be active at the same time
+ * [out]    value[2].b        Highest number of threads active at the same
+ *                            time
+ *
+ * value[2] is optional. With CFG_NS_VIRTUALIZATION the statistics are
+ * those of the calling guest.
+ */
+#define STATS_CMD_THREAD_STATS		10
+
+/*
+ * STATS_CMD_LOCK_STATS - Get contention statistics on core locks
+ *
+ * [out]    memref[0]        Array of struct pta_stats_lock, one per
+ *                           contended lock followed by one entry of type
+ *                           STATS_LOCK_TYPE_DROPPED
+ *
+ * Wait times are expressed in ticks of the generic timer counter.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_LOCK_CONTENTION_STATS is
+ * enabled, TEE_ERROR_ITEM_NOT_FOUND if no lock has been contended yet and
+ * TEE_ERROR_SHORT_BUFFER with the required size in memref[0].size if the
+ * buffer is too small.
+ */
+#define STATS_CMD_LOCK_STATS		11
+
+#define STATS_LOCK_TYPE_MUTEX		0
+#define STATS_LOCK_TYPE_SPINLOCK	1
+/* Waits on locks which could not be tracked individually */
+#define STATS_LOCK_TYPE_DROPPED		2
+
+struct pta_stats_lock {
+	uint64_t lock_va;		/* Core virtual address of the lock */
+	uint64_t wait_count;		/* Contended acquisitions */
+	uint64_t wait_cycles;		/* Cumulated wait time */
+	uint64_t max_wait_cycles;	/* Longest wait */
+	uint32_t type;			/* STATS_LOCK_TYPE_* */
+	uint32_t pad;
+};
+
+/*
+ * STATS_CMD_THREAD_TIME_STATS - Get time accounting of threads and CPUs
+ *
+ * [out]    memref[0]        Array of struct pta_stats_thread_time, one per
+ *                           thread
+ * [out]    memref[1]        Array of struct pta_stats_core_time, one per CPU
+ * [out]    value[2].a       Generic timer counter frequency in Hz
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_THREAD_TIME_STATS is
+ * enabled and TEE_ERROR_SHORT_BUFFER with the required sizes in
+ * memref[0].size and memref[1].size if a buffer is too small.
+ */
+#define STATS_CMD_THREAD_TIME_STATS	12
+
+/*
+ * STATS_CMD_PAGER_EVICT_STATS - Get page replacement statistics of pager
+ *
+ * [out]    value[0].a        Pages evicted since last pager stats dump
+ * [out]    value[0].b        Evicted pages loaded again shortly after,
+ *                            since last pager stats dump
+ *
+ * Reading these statistics also resets those of STATS_CMD_PAGER_STATS,
+ * and the other way around.
+ */
+#define STATS_CMD_PAGER_EVICT_STATS	13
+
+/*
+ * STATS_CMD_REG_SHM_STATS - Get statistics on registered shared memory
+ *
+ * [out]    value[0].a        Currently registered shared memory objects
+ * [out]    value[0].b        Highest number of registered objects seen
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_DYN_SHM is enabled and
+ * CFG_CORE_FFA is disabled.
+ */
+#define STATS_CMD_REG_SHM_STATS		14
+
+/*
+ * STATS_CMD_PERF_STATS - Get hardware performance counts of core hot paths
+ *
+ * [out]    memref[0]        Array of struct pta_stats_perf, one per
+ *                           STATS_PERF_POINT_*
+ *
+ * Counts are cumulated over all CPUs. Regions which ended on another CPU
+ * than they started on are only counted in @migrated.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_PERF_STATS is enabled
+ * and TEE_ERROR_SHORT_BUFFER with the required size in memref[0].size if
+ * the buffer is too small.
+ */
+#define STATS_CMD_PERF_STATS		15
+
+#define STATS_PERF_POINT_STD_SMC	0	/* Standard SMC calls */
+#define STATS_PERF_POINT_SYSCALL	1	/* TA syscalls */
+#define STATS_PERF_POINT_RNG_READ	2	/* crypto_rng_read() */
+#define STATS_PERF_POINT_FS_HTREE_IO	3	/* Secure storage block I/O */
+
+struct pta_stats_perf {
+	uint32_t point;			/* STATS_PERF_POINT_* */
+	uint32_t pad;
+	uint64_t count;			/* Measured regions */
+	uint64_t migrated;		/* Regions not measured */
+	/*
+	 * Cycles, instructions, L1 data cache refills, L2 data cache
+	 * refills and L1 data TLB refills, counted in the secure state
+	 */
+	uint64_t ctr[5];
+};
+
+/*
+ * STATS_CMD_INITCALL_STATS - Get the durations of the boot init-calls
+ *
+ * [out]    memref[0]        Array of struct pta_stats_initcall, one per
+ *                           init-call done so far in call order
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_INITCALL_STATS is
+ * enabled and TEE_ERROR_SHORT_BUFFER with the required size in
+ * memref[0].size if the buffer is too small.
+ */
+#define STATS_CMD_INITCALL_STATS	16
+
+#define STATS_INITCALL_STAGE_PREINIT	0
+#define STATS_INITCALL_STAGE_EARLY	1
+#define STATS_INITCALL_STAGE_SERVICE	2
+#define STATS_INITCALL_STAGE_DRIVER	3
+#define STATS_INITCALL_STAGE_FINAL	4
+/* driver_init_deferred(), called on the first yielding call */
+#define STATS_INITCALL_STAGE_DEFERRED	5
+
+struct pta_stats_initcall {
+	uint64_t duration_us;
+	uint32_t stage;			/* STATS_INITCALL_STAGE_* */
+	uint32_t level;			/* Level within the stage */
+	uint32_t result;		/* TEE_Result returned */
+	char name[36];			/* Function name, possibly truncated */
+};
+
+/*
+ * STATS_CMD_TA_RESOURCE_STATS - Get resource usage of loaded user TAs
+ *
+ * [in/out] value[0].a       In: value[0].a of the previous call, 0 to get
+ *                           all TAs. Out: high 32 bits of a timestamp to
+ *                           pass to the next call
+ * [in/out] value[0].b       Same, low 32 bits
+ * [out]    memref[1]        Array of struct pta_stats_ta_resources, one
+ *                           per TA entered since the timestamp passed in
+ *                           value[0] or still running
+ *
+ * Polling with the timestamp of the previous call only returns the TAs
+ * whose counters may have changed in between. The counters are not
+ * reset by the call.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_TA_RESOURCE_STATS is enabled
+ * and TEE_ERROR_SHORT_BUFFER with the required size in memref[1].size if
+ * the buffer is too small.
+ */
+#define STATS_CMD_TA_RESOURCE_STATS	17
+
+#define STATS_TA_MAX_SYSCALLS		80
+
+struct pta_stats_ta_resources {
+	TEE_UUID uuid;
+	uint32_t panicked;		/* True if TA has panicked */
+	uint32_t running;		/* Threads currently running the TA */
+	uint64_t user_us;		/* CPU time in user mode */
+	uint64_t kernel_us;		/* CPU time in syscalls */
+	uint64_t page_faults;		/* Page faults resolved by the pager */
+	uint64_t rpcs;			/* RPCs to normal world for the TA */
+	/* Heap high-water mark as of the last STATS_CMD_TA_STATS, or 0 */
+	uint64_t heap_max_allocated;
+	/* Number of syscalls by syscall number */
+	uint32_t syscalls[STATS_TA_MAX_SYSCALLS];
+};
+
+/*
+ * STATS_CMD_MALLOC_SAMPLING - Control and read the sampling heap profiler
+ *
+ * [in/out] value[0].a       In: sampling period, 1 out of value[0].a
+ *                           allocations has its call stack recorded, 0
+ *                           disables sampling and STATS_MALLOC_KEEP_PERIOD
+ *                           keeps the current period. Out: the period
+ * [in/out] value[0].b       In: non-zero to clear the allocation counts
+ *                           and the sites without live allocations after
+ *                           reading. Out: number of samples dropped since
+ *                           the last clear due to full tables
+ * [out]    memref[1]        Array of struct pta_stats_malloc_site, one per
+ *                           call site with sampled allocations
+ *
+ * Sampled allocations are tracked until freed so the live bytes of a call
+ * site multiplied by the period estimate what the site holds on the heap.
+ * A site whose live bytes keep growing is likely leaking.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_CORE_MALLOC_SAMPLING is
+ * enabled and TEE_ERROR_SHORT_BUFFER with the required size in
+ * memref[1].size if the buffer is too small, the period is updated in
+ * both cases.
+ */
+#define STATS_CMD_MALLOC_SAMPLING	18
+
+#define STATS_MALLOC_KEEP_PERIOD	0xffffffff
+#define STATS_MALLOC_STACK_DEPTH	8
+
+struct pta_stats_malloc_site {
+	uint64_t live_bytes;		/* Bytes of live sampled allocations */
+	uint32_t live_count;		/* Number of live sampled allocations */
+	uint32_t total_count;		/* Number of sampled allocations */
+	/* Return addresses, innermost first, terminated by 0 if not full */
+	uint64_t stack[STATS_MALLOC_STACK_DEPTH];
+};
+
+/*
+ * STATS_CMD_SYSCALL_LATENCY - Get the latency histograms of TA syscalls
+ *
+ * [out]    memref[0]        Array of struct pta_stats_syscall_latency, one
+ *                           per syscall number called by a user TA
+ *
+ * The latency is the CPU time spent in the syscall, as for kernel_us of
+ * struct pta_stats_ta_resources. Bucket 0 counts the syscalls below 1 us,
+ * bucket n those in [2^(n-1), 2^n) us and the last bucket all above.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless CFG_TA_RESOURCE_STATS is enabled
+ * and TEE_ERROR_SHORT_BUFFER with the required size in memref[0].size if
+ * the buffer is too small.
+ */
+#define STATS_CMD_SYSCALL_LATENCY	19
+
+#define STATS_SYSCALL_LAT_BUCKETS	16
+
+struct pta_stats_syscall_latency {
+	uint32_t scn;			/* Syscall number, TEE_SCN_* */
+	uint32_t count;			/* Number of calls */
+	uint64_t total_us;		/* Sum of the latencies */
+	uint64_t max_us;		/* Highest latency */
+	uint32_t buckets[STATS_SYSCALL_LAT_BUCKETS];
+};
+
+struct pta_stats_thread_time {
+	uint64_t run_ticks;		/* Time executing in secure world */
+	uint64_t suspended_ticks;	/* Time suspended in RPC or preempted */
+	uint64_t wait_ticks;		/* Time waiting on mutexes, condvars */
+	uint64_t resumes;		/* Starts and resumes of the thread */
+};
+
+struct pta_stats_core_time {
+	uint64_t run_ticks;		/* Time executing threads */
+	uint64_t entries;		/* Threads started or resumed */
+};
+
 #endif /*__PTA_STATS_H*/
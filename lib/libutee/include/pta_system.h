@@ -201,4 +201,17 @@
  */
 #define PTA_SYSTEM_SUPP_PLUGIN_INVOKE	13
 
+/*
+ * Retrieves whole events of the TPM Event log held in secure memory,
+ * without copying the rest of the log.
+ *
+ * [in]     value[0].a: index of the first event to retrieve
+ * [out]    memref[1]: Pointer to the buffer where to store the events,
+ *                     the size needed for the first event on
+ *                     TEE_ERROR_SHORT_BUFFER
+ * [out]    value[2].a: number of events retrieved
+ * [out]    value[2].b: number of events in the log
+ */
+#define PTA_SYSTEM_GET_TPM_EVENTS	14
+
 #endif /* __PTA_SYSTEM_H */
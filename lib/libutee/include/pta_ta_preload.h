@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Load keep-alive TAs ahead of their first session open.
+ */
+
+#ifndef __PTA_TA_PRELOAD_H
+#define __PTA_TA_PRELOAD_H
+
+#define PTA_TA_PRELOAD_UUID { 0xd76b77e0, 0xdf0b, 0x4d9a, \
+		{ 0xb4, 0x10, 0xd9, 0x17, 0x28, 0xcc, 0x84, 0x78 } }
+
+/*
+ * Preload TAs
+ *
+ * Each TA must be a user TA with TA_FLAG_SINGLE_INSTANCE and
+ * TA_FLAG_INSTANCE_KEEP_ALIVE. Its instance is created, but no session
+ * is opened. TAs already loaded are left as is. Stops at the first TA
+ * that fails to load.
+ *
+ * [in]		memref[0]: Array of TA UUIDs, as octets (RFC4122)
+ * [out]	value[1].a: Number of TAs loaded
+ *
+ * Return codes:
+ * TEE_SUCCESS - All TAs are loaded
+ * TEE_ERROR_NOT_SUPPORTED - A TA isn't a keep-alive user TA
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * Other error codes from loading a TA
+ */
+#define PTA_TA_PRELOAD_CMD_LOAD		0
+
+#endif /* __PTA_TA_PRELOAD_H */
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Read the trace output buffered by the core, CFG_CORE_TRACE_RING=y,
+ * or have it written to a non-secure buffer.
+ */
+
+#ifndef __PTA_TRACE_RING_H
+#define __PTA_TRACE_RING_H
+
+#include <stdint.h>
+
+#define PTA_TRACE_RING_UUID { 0xac875fd9, 0x89b0, 0x4b88, \
+		{ 0xb1, 0xd4, 0xbd, 0x4e, 0xe8, 0x8a, 0xb1, 0x4e } }
+
+/*
+ * Read buffered trace output
+ *
+ * The output is consumed, it's not returned again by the next read.
+ * The output of each core is returned in turn, so lines from different
+ * cores aren't in time order.
+ *
+ * [out]	memref[0]: Trace output, not zero terminated. The size is
+ *			   updated with the number of bytes returned, 0 if
+ *			   there's nothing buffered.
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ */
+#define PTA_TRACE_RING_CMD_READ		0
+
+/*
+ * Header of each per-core ring in the non-secure buffer registered with
+ * PTA_TRACE_RING_CMD_SET_SHM, followed by @size bytes of data.
+ *
+ * @head is the number of bytes written so far to the ring, the byte at
+ * offset n of the output is at data[n % size]. The secure world updates
+ * @head after the data it covers, so a reader should load @head with
+ * acquire semantics. If @head has moved more than @size bytes past the
+ * reader's position, output was lost.
+ */
+struct pta_trace_ring_hdr {
+	uint64_t head;
+	uint32_t size;
+	uint32_t reserved;
+};
+
+/*
+ * Write trace output to a non-secure buffer
+ *
+ * The buffer is split in one ring per core, see struct
+ * pta_trace_ring_hdr. From this on, trace output of the core is
+ * written there instead of being buffered in secure memory. Can only be
+ * done once.
+ *
+ * [in]		value[0].a: Physical address of the buffer, upper 32 bits
+ * [in]		value[0].b: Physical address of the buffer, lower 32 bits
+ * [in]		value[1].a: Size of the buffer
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param, or the buffer is
+ *			      too small or not non-secure memory
+ * TEE_ERROR_BAD_STATE - A buffer is already registered
+ * TEE_ERROR_OUT_OF_MEMORY - The buffer can't be mapped
+ */
+#define PTA_TRACE_RING_CMD_SET_SHM	1
+
+#endif /* __PTA_TRACE_RING_H */
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __PTA_VERSAL_TRNG_H
+#define __PTA_VERSAL_TRNG_H
+
+#define PTA_VERSAL_TRNG_UUID { 0x0d1c0c86, 0xa15d, 0x46e3, \
+	{ 0xb5, 0x92, 0x14, 0x79, 0x31, 0x10, 0x5a, 0x02 } }
+
+/*
+ * Each session of a TA with this PTA owns a random stream: a CTR_DRBG
+ * seeded from the TRNG with its own personalization string and reseed
+ * interval. Reading from the stream only touches the TRNG when it is
+ * reseeded, the bulk of the output is generated on the calling core, so
+ * it doesn't compete with the other consumers of the TRNG.
+ *
+ * Only user TAs can open a session.
+ */
+
+/* Maximum size of the personalization string of a stream */
+#define PTA_VERSAL_TRNG_PERS_MAX_LEN	48
+
+/**
+ * Instantiate the random stream of the session
+ *
+ * [in]		value[0].a	Reseed interval in bytes, 0 for the default
+ * [in]		memref[1]	Personalization string, optional, at most
+ *				PTA_VERSAL_TRNG_PERS_MAX_LEN bytes
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_BAD_STATE - The stream is already instantiated
+ */
+#define PTA_VERSAL_TRNG_OPEN		0x0
+
+/**
+ * Read random bytes from the stream of the session
+ *
+ * [out]	memref[0]	Buffer to fill with random bytes
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_BAD_STATE - The stream isn't instantiated
+ */
+#define PTA_VERSAL_TRNG_READ		0x1
+
+#endif /* __PTA_VERSAL_TRNG_H */
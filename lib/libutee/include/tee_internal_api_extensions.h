@@ -35,6 +35,58 @@ TEE_Result TEE_CacheClean(char *buf, size_t len);
 TEE_Result TEE_CacheFlush(char *buf, size_t len);
 TEE_Result TEE_CacheInvalidate(char *buf, size_t len);
 
+/*
+ * struct tee_cryp_segment - One segment of a vectored cipher or AE update
+ * @src:	Source data
+ * @src_len:	Length of @src
+ * @dst:	Destination buffer
+ * @dst_len:	[in] size of @dst, [out] number of bytes written to @dst,
+ *		or required on TEE_ERROR_SHORT_BUFFER
+ */
+struct tee_cryp_segment {
+	const void *src;
+	size_t src_len;
+	void *dst;
+	size_t dst_len;
+};
+
+/*
+ * tee_cipher_update_vec() - TEE_CipherUpdate() on several segments
+ * tee_ae_update_vec() - TEE_AEUpdate() on several segments
+ * @operation:	Cipher or AE operation handle
+ * @seg:	Segments, processed in order as if they were contiguous input
+ * @num_seg:	Number of segments in @seg
+ *
+ * Segments are passed to the TEE core in batches when no partial block
+ * is buffered, saving one user/kernel crossing per segment. If any
+ * destination buffer is too small no data is consumed, the required
+ * sizes are returned in dst_len and TEE_ERROR_SHORT_BUFFER is returned.
+ * Other errors panic the TA as for TEE_CipherUpdate().
+ */
+TEE_Result tee_cipher_update_vec(TEE_OperationHandle operation,
+				 struct tee_cryp_segment *seg, size_t num_seg);
+TEE_Result tee_ae_update_vec(TEE_OperationHandle operation,
+			     struct tee_cryp_segment *seg, size_t num_seg);
+
+/*
+ * tee_storage_begin_transaction() - Begin a transaction on a storage
+ * tee_storage_commit_transaction() - Commit the transaction
+ * @storageID:	Storage, for instance TEE_STORAGE_PRIVATE
+ *
+ * Until the transaction is committed, writes and truncations of
+ * persistent objects of @storageID through handles of the TA are kept
+ * pending. They are then committed together, saving one commit of the
+ * storage per write. Creating, renaming and deleting objects takes effect
+ * immediately. Changes still pending when the TA instance is destroyed
+ * are discarded, as are pending changes of objects deleted in between.
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED if the storage doesn't support
+ * transactions and TEE_ERROR_BAD_STATE if a transaction is already begun,
+ * or not begun on @storageID when committing.
+ */
+TEE_Result tee_storage_begin_transaction(uint32_t storageID);
+TEE_Result tee_storage_commit_transaction(uint32_t storageID);
+
 /*
  * tee_map_zi() - Map zero initialized memory
  * @len:	Number of bytes
@@ -52,8 +52,13 @@
 					BIT32(11)
 #define TA_FLAG_DEVICE_ENUM_TEE_STORAGE_PRIVATE	\
 					BIT32(12) /* with TEE_STORAGE_PRIVATE */
+	/*
+	 * Cache small heap buffers in front of the TA heap, requires
+	 * CFG_TA_HEAP_MAGAZINE=y or it's ignored
+	 */
+#define TA_FLAG_HEAP_CACHE		BIT32(13)
 
-#define TA_FLAGS_MASK			GENMASK_32(12, 0)
+#define TA_FLAGS_MASK			GENMASK_32(13, 0)
 
 struct ta_head {
 	TEE_UUID uuid;
@@ -64,6 +69,11 @@ struct ta_head {
 
 #if defined(CFG_FTRACE_SUPPORT)
 #define FTRACE_RETFUNC_DEPTH		50
+/*
+ * Topmost byte of the ftrace buffer element holding the counter timestamp
+ * of the function entry preceding it
+ */
+#define FTRACE_TIMESTAMP_LEVEL		0xff
 union compat_ptr {
 	uint64_t ptr64;
 	struct {
@@ -85,6 +95,7 @@ struct ftrace_buf {
 	uint32_t lr_idx;	/* lr index used for stack unwinding */
 	uint64_t begin_time[FTRACE_RETFUNC_DEPTH]; /* Timestamp */
 	uint64_t suspend_time;	/* Suspend timestamp */
+	uint64_t suspended;	/* Total time suspended */
 	uint32_t curr_idx;	/* Current entry in the (circular) buffer */
 	uint32_t max_size;	/* Max allowed size of ftrace buffer */
 	uint32_t head_off;	/* Ftrace buffer header offset */
@@ -223,6 +223,14 @@ TEE_Result _utee_storage_obj_seek(unsigned long obj, int32_t offset,
 /* op is of type enum _utee_cache_operation */
 TEE_Result _utee_cache_operation(void *va, size_t l, unsigned long op);
 
+/* state is of type TEE_OperationHandle */
+TEE_Result _utee_cryp_update_vec(unsigned long state,
+				 struct utee_cryp_vec *vec, size_t num_vec);
+
+/* op is of type enum utee_storage_transaction_op */
+TEE_Result _utee_storage_transaction(unsigned long storage_id,
+				     unsigned long op);
+
 TEE_Result _utee_gprof_send(void *buf, size_t size, uint32_t *id);
 
 #endif /* UTEE_SYSCALLS_H */
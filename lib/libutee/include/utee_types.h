@@ -42,6 +42,11 @@ enum utee_cache_operation {
 	TEE_CACHEINVALIDATE,
 };
 
+enum utee_storage_transaction_op {
+	UTEE_STORAGE_TRANSACTION_BEGIN = 0,
+	UTEE_STORAGE_TRANSACTION_COMMIT,
+};
+
 struct utee_params {
 	uint64_t types;
 	/* vals[n * 2]	   corresponds to either value.a or memref.buffer
@@ -57,6 +62,21 @@ struct utee_attribute {
 	uint32_t attribute_id;
 };
 
+/*
+ * One segment of a vectored cipher or authenc payload update, on return
+ * dst_len holds the number of bytes written to dst (or needed on short
+ * buffer). At most UTEE_CRYP_UPDATE_VEC_MAX segments are accepted per
+ * call.
+ */
+#define UTEE_CRYP_UPDATE_VEC_MAX	16
+
+struct utee_cryp_vec {
+	uint64_t src;		/* pointer to source data */
+	uint64_t src_len;
+	uint64_t dst;		/* pointer to destination buffer */
+	uint64_t dst_len;
+};
+
 struct utee_object_info {
 	uint32_t obj_type;
 	uint32_t obj_size;
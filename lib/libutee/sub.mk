@@ -8,6 +8,7 @@ srcs-y += trace_ext.c
 ifneq ($(sm),ldelf)
 srcs-y += tee_api.c
 srcs-y += tee_api_arith_mpi.c
+srcs-$(CFG_TA_DRBG) += tee_api_drbg.c
 cppflags-tee_api_arith_mpi.c-y += -DMBEDTLS_ALLOW_PRIVATE_ACCESS
 srcs-y += tee_api_objects.c
 srcs-y += tee_api_operations.c
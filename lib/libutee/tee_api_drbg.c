@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Per TA instance CTR_DRBG serving small TEE_GenerateRandom() requests
+ * without a system call. It's seeded and reseeded from the random number
+ * generator of the OP-TEE core, when opening a session so that clients
+ * don't share DRBG state and after CFG_TA_DRBG_RESEED_BYTES bytes of
+ * output.
+ */
+
+#include <config.h>
+#include <mbedtls/ctr_drbg.h>
+#include <stdbool.h>
+#include <tee_api.h>
+#include <utee_syscalls.h>
+
+#include "tee_api_private.h"
+
+#if CFG_TA_DRBG_MAX_REQ > MBEDTLS_CTR_DRBG_MAX_REQUEST
+#error CFG_TA_DRBG_MAX_REQ is larger than a single CTR_DRBG request
+#endif
+
+static mbedtls_ctr_drbg_context drbg_ctx;
+static bool drbg_seeded;
+/* Bytes generated since the last (re)seed */
+static size_t drbg_bytes;
+
+static int drbg_entropy(void *data __unused, unsigned char *buf, size_t len)
+{
+	if (_utee_cryp_random_number_generate(buf, len))
+		return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+
+	return 0;
+}
+
+static TEE_Result drbg_seed(void)
+{
+	mbedtls_ctr_drbg_init(&drbg_ctx);
+	if (mbedtls_ctr_drbg_seed(&drbg_ctx, drbg_entropy, NULL, NULL, 0)) {
+		mbedtls_ctr_drbg_free(&drbg_ctx);
+		return TEE_ERROR_GENERIC;
+	}
+
+	drbg_seeded = true;
+	drbg_bytes = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result drbg_reseed(void)
+{
+	if (mbedtls_ctr_drbg_reseed(&drbg_ctx, NULL, 0)) {
+		mbedtls_ctr_drbg_free(&drbg_ctx);
+		drbg_seeded = false;
+		return TEE_ERROR_GENERIC;
+	}
+
+	drbg_bytes = 0;
+
+	return TEE_SUCCESS;
+}
+
+void __utee_drbg_reseed(void)
+{
+	/*
+	 * Seeding is otherwise done on first use, a failure here leaves the
+	 * DRBG unseeded and the next request seeds it again.
+	 */
+	if (drbg_seeded)
+		drbg_reseed();
+}
+
+TEE_Result __utee_drbg_generate(void *buf, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Large requests gain nothing from the DRBG */
+	if (len > CFG_TA_DRBG_MAX_REQ)
+		return _utee_cryp_random_number_generate(buf, len);
+
+	if (!drbg_seeded)
+		res = drbg_seed();
+	else if (drbg_bytes + len > CFG_TA_DRBG_RESEED_BYTES)
+		res = drbg_reseed();
+	if (res)
+		return res;
+
+	if (mbedtls_ctr_drbg_random(&drbg_ctx, buf, len))
+		return TEE_ERROR_GENERIC;
+	drbg_bytes += len;
+
+	return TEE_SUCCESS;
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <tee_api.h>
+#include <tee_internal_api_extensions.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -1052,3 +1053,15 @@ TEE_Result __GP11_TEE_SeekObjectData(TEE_ObjectHandle object, int32_t offset,
 {
 	return TEE_SeekObjectData(object, offset, whence);
 }
+
+TEE_Result tee_storage_begin_transaction(uint32_t storageID)
+{
+	return _utee_storage_transaction(storageID,
+					 UTEE_STORAGE_TRANSACTION_BEGIN);
+}
+
+TEE_Result tee_storage_commit_transaction(uint32_t storageID)
+{
+	return _utee_storage_transaction(storageID,
+					 UTEE_STORAGE_TRANSACTION_COMMIT);
+}
@@ -1758,6 +1758,180 @@ out:
 	return res;
 }
 
+/* Output produced by feeding @len bytes with @offs bytes already buffered */
+static size_t update_req_dlen(TEE_OperationHandle op, size_t offs, size_t len)
+{
+	size_t bs = op->block_size;
+
+	if (bs <= 1)
+		return len;
+
+	if (op->buffer_two_blocks) {
+		if (offs + len <= bs * 2)
+			return 0;
+		return ROUNDUP2(offs + len - bs * 2, bs);
+	}
+
+	return ROUNDDOWN2(offs + len, bs);
+}
+
+/*
+ * Checks all destination sizes up front since nothing can be undone once
+ * data has been fed to the algorithm. @direct is set if the segments can
+ * bypass the partial block buffer and be handed to the TEE core as is.
+ */
+static TEE_Result check_update_vec(TEE_OperationHandle op,
+				   struct tee_cryp_segment *seg,
+				   size_t num_seg, bool *direct)
+{
+	bool short_buf = false;
+	size_t offs = op->buffer_offs;
+	size_t req = 0;
+	size_t n = 0;
+
+	*direct = op->block_size <= 1 ||
+		  (!op->buffer_two_blocks && !op->buffer_offs);
+
+	for (n = 0; n < num_seg; n++) {
+		if (!seg[n].src && seg[n].src_len)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (op->block_size > 1 && seg[n].src_len % op->block_size)
+			*direct = false;
+
+		req = update_req_dlen(op, offs, seg[n].src_len);
+		offs += seg[n].src_len - req;
+		if (seg[n].dst_len < req)
+			short_buf = true;
+	}
+
+	if (short_buf) {
+		/* Report the required size of every segment */
+		offs = op->buffer_offs;
+		for (n = 0; n < num_seg; n++) {
+			req = update_req_dlen(op, offs, seg[n].src_len);
+			offs += seg[n].src_len - req;
+			seg[n].dst_len = req;
+		}
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result update_vec_direct(TEE_OperationHandle op,
+				    struct tee_cryp_segment *seg,
+				    size_t num_seg)
+{
+	struct utee_cryp_vec vec[UTEE_CRYP_UPDATE_VEC_MAX] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t cnt = 0;
+	size_t n = 0;
+
+	while (num_seg) {
+		cnt = MIN(num_seg, ARRAY_SIZE(vec));
+		for (n = 0; n < cnt; n++) {
+			vec[n].src = (uintptr_t)seg[n].src;
+			vec[n].src_len = seg[n].src_len;
+			vec[n].dst = (uintptr_t)seg[n].dst;
+			vec[n].dst_len = seg[n].dst_len;
+		}
+
+		res = _utee_cryp_update_vec(op->state, vec, cnt);
+		if (res)
+			return res;
+
+		for (n = 0; n < cnt; n++)
+			seg[n].dst_len = vec[n].dst_len;
+		seg += cnt;
+		num_seg -= cnt;
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_cipher_update_vec(TEE_OperationHandle operation,
+				 struct tee_cryp_segment *seg, size_t num_seg)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool direct = false;
+	size_t n = 0;
+
+	if (operation == TEE_HANDLE_NULL || (!seg && num_seg)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+	__utee_check_inout_annotation(seg, sizeof(*seg) * num_seg);
+
+	if (operation->info.operationClass != TEE_OPERATION_CIPHER ||
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) ||
+	    operation->operationState != TEE_OPERATION_STATE_ACTIVE) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = check_update_vec(operation, seg, num_seg, &direct);
+	if (res)
+		goto out;
+
+	if (direct) {
+		res = update_vec_direct(operation, seg, num_seg);
+		goto out;
+	}
+
+	for (n = 0; n < num_seg && !res; n++)
+		res = TEE_CipherUpdate(operation, seg[n].src, seg[n].src_len,
+				       seg[n].dst, &seg[n].dst_len);
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_SHORT_BUFFER)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result tee_ae_update_vec(TEE_OperationHandle operation,
+			     struct tee_cryp_segment *seg, size_t num_seg)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool direct = false;
+	size_t n = 0;
+
+	if (operation == TEE_HANDLE_NULL || (!seg && num_seg)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+	__utee_check_inout_annotation(seg, sizeof(*seg) * num_seg);
+
+	if (operation->info.operationClass != TEE_OPERATION_AE ||
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = check_update_vec(operation, seg, num_seg, &direct);
+	if (res)
+		goto out;
+
+	if (direct) {
+		res = update_vec_direct(operation, seg, num_seg);
+		if (!res && num_seg)
+			operation->operationState = TEE_OPERATION_STATE_ACTIVE;
+		goto out;
+	}
+
+	for (n = 0; n < num_seg && !res; n++)
+		res = TEE_AEUpdate(operation, seg[n].src, seg[n].src_len,
+				   seg[n].dst, &seg[n].dst_len);
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_SHORT_BUFFER)
+		TEE_Panic(res);
+
+	return res;
+}
+
 TEE_Result __GP11_TEE_AEUpdate(TEE_OperationHandle operation,
 			       const void *srcData, uint32_t srcLen,
 			       void *destData, uint32_t *destLen)
@@ -2398,7 +2572,7 @@ void TEE_GenerateRandom(void *randomBuffer, size_t randomBufferLen)
 {
 	TEE_Result res;
 
-	res = _utee_cryp_random_number_generate(randomBuffer, randomBufferLen);
+	res = __utee_drbg_generate(randomBuffer, randomBufferLen);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
@@ -6,6 +6,7 @@
 #define TEE_API_PRIVATE
 
 #include <tee_api_types.h>
+#include <utee_syscalls.h>
 #include <utee_types.h>
 
 
@@ -26,6 +27,17 @@ void __utee_gprof_fini(void);
 static inline void __utee_gprof_init(void) {}
 static inline void __utee_gprof_fini(void) {}
 #endif
+#if defined(CFG_TA_DRBG)
+TEE_Result __utee_drbg_generate(void *buf, size_t len);
+void __utee_drbg_reseed(void);
+#else
+static inline TEE_Result __utee_drbg_generate(void *buf, size_t len)
+{
+	return _utee_cryp_random_number_generate(buf, len);
+}
+
+static inline void __utee_drbg_reseed(void) {}
+#endif
 
 /*
  * The functions help checking that the pointers comply with the parameters
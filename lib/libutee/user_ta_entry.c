@@ -170,6 +170,8 @@ static TEE_Result init_instance(void)
 	trace_set_level(tahead_get_trace_level());
 	__utee_gprof_init();
 	malloc_add_pool(ta_heap, ta_heap_size);
+	if (ta_head.flags & TA_FLAG_HEAP_CACHE)
+		malloc_enable_cache();
 	if (__ta_no_share_heap_size) {
 		__ta_no_share_malloc_ctx = malloc(raw_malloc_get_ctx_size());
 		if (__ta_no_share_malloc_ctx) {
@@ -339,6 +341,9 @@ static TEE_Result entry_open_session(unsigned long session_id,
 	if (!session)
 		return TEE_ERROR_BAD_STATE;
 
+	/* Don't let a new client continue the DRBG output of a previous one */
+	__utee_drbg_reseed();
+
 	from_utee_params(params, &param_types, up);
 	ta_header_save_params(param_types, params);
 
@@ -7,7 +7,6 @@
 #include <assert.h>
 #include <config.h>
 #include <memtag.h>
-#include <string.h>
 
 #if MEMTAG_IS_ENABLED
 
@@ -43,6 +42,24 @@ static vaddr_t stg_and_advance(vaddr_t va)
 	return va;
 }
 
+static vaddr_t st2g_and_advance(vaddr_t va)
+{
+	asm volatile("st2g %0, [%0], #32" : "+r"(va) : : "memory");
+	return va;
+}
+
+static vaddr_t stzg_and_advance(vaddr_t va)
+{
+	asm volatile("stzg %0, [%0], #16" : "+r"(va) : : "memory");
+	return va;
+}
+
+static vaddr_t stz2g_and_advance(vaddr_t va)
+{
+	asm volatile("stz2g %0, [%0], #32" : "+r"(va) : : "memory");
+	return va;
+}
+
 static void *insert_random_tag(void *addr)
 {
 	asm volatile("irg %0, %0" : "+r"(addr) : : );
@@ -81,7 +98,10 @@ static void *set_tags_helper(void *addr, size_t size)
 	assert(!(va & MEMTAG_GRANULE_MASK));
 	assert(!(size & MEMTAG_GRANULE_MASK));
 
-	while (va < end)
+	/* Two granules per store, the odd one last */
+	while (end - va >= 2 * MEMTAG_GRANULE_SIZE)
+		va = st2g_and_advance(va);
+	if (va < end)
 		va = stg_and_advance(va);
 
 	return addr;
@@ -132,10 +152,19 @@ static void *set_random_tags(void *addr, size_t size)
 	return set_tags_helper(insert_random_tag(addr), size);
 }
 
-static void clear_mem(void *va, size_t size)
+static void clear_mem(void *addr, size_t size)
 {
-	set_tags(va, size, 0);
-	memset(memtag_strip_tag(va), 0, size);
+	vaddr_t va = (vaddr_t)memtag_insert_tag(addr, 0);
+	vaddr_t end = va + size;
+
+	assert(!(va & MEMTAG_GRANULE_MASK));
+	assert(!(size & MEMTAG_GRANULE_MASK));
+
+	/* Tags and data are cleared by the same stores */
+	while (end - va >= 2 * MEMTAG_GRANULE_SIZE)
+		va = stz2g_and_advance(va);
+	if (va < end)
+		va = stzg_and_advance(va);
 }
 
 static void clear_mem_dc(void *addr, size_t size)
@@ -13,6 +13,7 @@
 #include <assert.h>
 #include <types_ext.h>
 #include <user_ta_header.h>
+#include <util.h>
 #if defined(__KERNEL__)
 #if defined(ARM32) || defined(ARM64)
 #include <arm.h>
@@ -97,6 +98,9 @@ void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 		return;
 
 	add_elem(fbuf, fbuf->ret_idx + 1, pc);
+	/* Time spent suspended is left out, as in the durations */
+	add_elem(fbuf, FTRACE_TIMESTAMP_LEVEL,
+		 (now - fbuf->suspended) & GENMASK_64(55, 0));
 
 	if (fbuf->ret_idx < FTRACE_RETFUNC_DEPTH) {
 		fbuf->ret_stack[fbuf->ret_idx] = *lr;
@@ -122,7 +126,6 @@ unsigned long __noprof ftrace_return(void)
 	uint64_t now = barrier_read_counter_timer();
 	struct ftrace_buf *fbuf = get_fbuf();
 	uint64_t start = 0;
-	uint64_t elapsed = 0;
 
 	/* Check for valid return index */
 	if (!fbuf || !fbuf->ret_idx || fbuf->ret_idx > FTRACE_RETFUNC_DEPTH)
@@ -130,8 +133,8 @@ unsigned long __noprof ftrace_return(void)
 
 	fbuf->ret_idx--;
 	start = fbuf->begin_time[fbuf->ret_idx];
-	elapsed = (now - start) * 1000000000 / read_cntfrq();
-	add_elem(fbuf, 0, elapsed);
+	/* In counter ticks, converted when the buffer is decoded */
+	add_elem(fbuf, 0, now - start);
 
 	return fbuf->ret_stack[fbuf->ret_idx];
 }
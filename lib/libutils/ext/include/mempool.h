@@ -49,6 +49,28 @@ extern struct mempool *mempool_default;
 struct mempool *mempool_alloc_pool(void *data, size_t size,
 				   void (*release_mem)(void *ptr, size_t size));
 
+#if defined(__KERNEL__)
+/*
+ * mempool_alloc_pool_per_thread() - Allocate a memory pool with one
+ *				     sub-pool per thread
+ * @data:		a block of (@num_threads + 1) * @size bytes of memory,
+ *			must have an alignment of MEMPOOL_ALIGN.
+ * @size:		size of each sub-pool, a multiple of MEMPOOL_ALIGN
+ * @num_threads:	number of threads, normally CFG_NUM_THREADS
+ * @release_mem:	function to call when a sub-pool has been emptied,
+ *			ignored if NULL.
+ *
+ * Threads allocate from their own sub-pool and never wait on each other,
+ * allocations outside a thread context use the last sub-pool which is
+ * shared just as a pool from mempool_alloc_pool(). Items must be freed by
+ * the thread which allocated them.
+ * returns a pointer to a valid pool on success or NULL on failure.
+ */
+struct mempool *
+mempool_alloc_pool_per_thread(void *data, size_t size, size_t num_threads,
+			      void (*release_mem)(void *ptr, size_t size));
+#endif
+
 /*
  * mempool_alloc() - Allocate an item from a memory pool
  * @pool:		A memory pool created with mempool_alloc_pool()
@@ -16,6 +16,7 @@
 #if defined(__KERNEL__)
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
+#include <kernel/thread.h>
 #endif
 
 /*
@@ -63,6 +64,18 @@ struct mempool {
 #if defined(__KERNEL__)
 	void (*release_mem)(void *ptr, size_t size);
 	struct recursive_mutex mu;
+	/*
+	 * Sub-pools of a pool created with mempool_alloc_pool_per_thread(),
+	 * one per thread followed by a shared one.
+	 */
+	struct mempool *sub_pools;
+	size_t num_threads;
+	/*
+	 * A thread sub-pool is only used by its own thread, it's kept
+	 * reserved by counting the allocations instead of with @mu.
+	 */
+	bool is_thread_pool;
+	size_t refcount;
 #endif
 };
 
@@ -88,10 +101,58 @@ static void init_mpool(struct mempool *pool)
 	raw_malloc_add_pool(pool->mctx, (void *)pool->data, v - pool->data);
 }
 
+#if defined(__KERNEL__)
+/* Returns the pool to allocate from when asked to allocate from @pool */
+static struct mempool *select_pool(struct mempool *pool)
+{
+	short int id = 0;
+
+	if (!pool->sub_pools)
+		return pool;
+
+	id = thread_get_id_may_fail();
+	if (id < 0 || (size_t)id >= pool->num_threads)
+		return pool->sub_pools + pool->num_threads;
+
+	return pool->sub_pools + id;
+}
+
+/* Returns the pool @ptr, allocated from @pool, was carved out from */
+static struct mempool *find_pool(struct mempool *pool, void *ptr)
+{
+	struct mempool *p = NULL;
+	size_t n = 0;
+
+	if (!pool->sub_pools)
+		return pool;
+
+	for (n = 0; n <= pool->num_threads; n++) {
+		p = pool->sub_pools + n;
+		if ((vaddr_t)ptr >= p->data && (vaddr_t)ptr < p->data + p->size)
+			return p;
+	}
+
+	panic();
+}
+#else
+static struct mempool *select_pool(struct mempool *pool)
+{
+	return pool;
+}
+
+static struct mempool *find_pool(struct mempool *pool, void *ptr __unused)
+{
+	return pool;
+}
+#endif
+
 static void get_pool(struct mempool *pool __maybe_unused)
 {
 #if defined(__KERNEL__)
-	mutex_lock_recursive(&pool->mu);
+	if (pool->is_thread_pool)
+		pool->refcount++;
+	else
+		mutex_lock_recursive(&pool->mu);
 	if (!pool->mctx)
 		init_mpool(pool);
 
@@ -101,7 +162,16 @@ static void get_pool(struct mempool *pool __maybe_unused)
 static void put_pool(struct mempool *pool __maybe_unused)
 {
 #if defined(__KERNEL__)
-	if (mutex_get_recursive_lock_depth(&pool->mu) == 1) {
+	bool last = false;
+
+	if (pool->is_thread_pool) {
+		assert(pool->refcount);
+		last = pool->refcount == 1;
+	} else {
+		last = mutex_get_recursive_lock_depth(&pool->mu) == 1;
+	}
+
+	if (last) {
 		/*
 		 * As the refcount is about to become 0 there should be no items
 		 * left
@@ -111,7 +181,11 @@ static void put_pool(struct mempool *pool __maybe_unused)
 			pool->release_mem((void *)pool->data, pool->size);
 		}
 	}
-	mutex_unlock_recursive(&pool->mu);
+
+	if (pool->is_thread_pool)
+		pool->refcount--;
+	else
+		mutex_unlock_recursive(&pool->mu);
 #endif
 }
 
@@ -138,10 +212,46 @@ mempool_alloc_pool(void *data, size_t size,
 	return pool;
 }
 
+#if defined(__KERNEL__)
+struct mempool *
+mempool_alloc_pool_per_thread(void *data, size_t size, size_t num_threads,
+			      void (*release_mem)(void *ptr, size_t size))
+{
+	struct mempool *pool = NULL;
+	struct mempool *p = NULL;
+	size_t n = 0;
+
+	assert(!((vaddr_t)data & (MEMPOOL_ALIGN - 1)));
+	assert(!(size & (MEMPOOL_ALIGN - 1)));
+
+	pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+	pool->sub_pools = calloc(num_threads + 1, sizeof(*pool->sub_pools));
+	if (!pool->sub_pools) {
+		free(pool);
+		return NULL;
+	}
+	pool->num_threads = num_threads;
+
+	for (n = 0; n <= num_threads; n++) {
+		p = pool->sub_pools + n;
+		p->size = size;
+		p->data = (vaddr_t)data + n * size;
+		p->release_mem = release_mem;
+		p->is_thread_pool = n < num_threads;
+		mutex_init_recursive(&p->mu);
+	}
+
+	return pool;
+}
+#endif
+
 void *mempool_alloc(struct mempool *pool, size_t size)
 {
 	void *p = NULL;
 
+	pool = select_pool(pool);
 	get_pool(pool);
 
 	p = raw_malloc(0, 0, size, pool->mctx);
@@ -182,6 +292,7 @@ void *mempool_calloc(struct mempool *pool, size_t nmemb, size_t size)
 void mempool_free(struct mempool *pool, void *ptr)
 {
 	if (ptr) {
+		pool = find_pool(pool, ptr);
 		raw_free(ptr, pool->mctx, false /*!wipe*/);
 		put_pool(pool);
 	}
@@ -6,18 +6,127 @@
 #include <stdlib.h>
 #include <util.h>
 
-#define QSORT_HELPER(name, type)				\
-static int cmp_ ## name(const void *a, const void *b)		\
-{								\
-	const type *ia = a;					\
-	const type *ib = b;					\
-								\
-	return CMP_TRILEAN(*ia, *ib);				\
-}								\
-								\
-void qsort_ ## name(type *aa, size_t n)				\
-{								\
-	qsort(aa, n, sizeof(*aa), cmp_ ## name);		\
+/*
+ * The helpers sort with a typed introsort instead of calling qsort():
+ * elements are compared and moved directly instead of through the
+ * comparison callback and the generic swap code. Partitions are split
+ * around a median of three until they're small enough for insertion
+ * sort. If the partitioning goes too deep heapsort takes over, so the
+ * worst case stays O(n log n).
+ */
+#define QSORT_INSERTION_MAX	16
+
+#define QSORT_HELPER(name, type)					\
+static void isort_ ## name(type *a, size_t n)				\
+{									\
+	size_t i = 0;							\
+	size_t j = 0;							\
+	type t = 0;							\
+									\
+	for (i = 1; i < n; i++) {					\
+		t = a[i];						\
+		for (j = i; j && t < a[j - 1]; j--)			\
+			a[j] = a[j - 1];				\
+		a[j] = t;						\
+	}								\
+}									\
+									\
+static void sift_down_ ## name(type *a, size_t root, size_t n)		\
+{									\
+	size_t child = 0;						\
+	type t = a[root];						\
+									\
+	while (root * 2 + 1 < n) {					\
+		child = root * 2 + 1;					\
+		if (child + 1 < n && a[child] < a[child + 1])		\
+			child++;					\
+		if (!(t < a[child]))					\
+			break;						\
+		a[root] = a[child];					\
+		root = child;						\
+	}								\
+	a[root] = t;							\
+}									\
+									\
+static void hsort_ ## name(type *a, size_t n)				\
+{									\
+	size_t i = 0;							\
+	type t = 0;							\
+									\
+	for (i = n / 2; i > 0; i--)					\
+		sift_down_ ## name(a, i - 1, n);			\
+	for (i = n - 1; i > 0; i--) {					\
+		t = a[0];						\
+		a[0] = a[i];						\
+		a[i] = t;						\
+		sift_down_ ## name(a, 0, i);				\
+	}								\
+}									\
+									\
+static void swap_ ## name(type *a, type *b)				\
+{									\
+	type t = *a;							\
+									\
+	*a = *b;							\
+	*b = t;								\
+}									\
+									\
+static void introsort_ ## name(type *a, size_t n, unsigned int depth)	\
+{									\
+	size_t i = 0;							\
+	size_t j = 0;							\
+	type p = 0;							\
+									\
+	while (n > QSORT_INSERTION_MAX) {				\
+		if (!depth--) {						\
+			hsort_ ## name(a, n);				\
+			return;						\
+		}							\
+									\
+		/* Median of three ends up in a[n / 2] */		\
+		if (a[n / 2] < a[0])					\
+			swap_ ## name(a + n / 2, a);			\
+		if (a[n - 1] < a[n / 2]) {				\
+			swap_ ## name(a + n - 1, a + n / 2);		\
+			if (a[n / 2] < a[0])				\
+				swap_ ## name(a + n / 2, a);		\
+		}							\
+		p = a[n / 2];						\
+									\
+		/* Hoare partition, a[0] and a[n - 1] are sentinels */	\
+		i = 0;							\
+		j = n - 1;						\
+		while (true) {						\
+			while (a[++i] < p)				\
+				;					\
+			while (p < a[--j])				\
+				;					\
+			if (i >= j)					\
+				break;					\
+			swap_ ## name(a + i, a + j);			\
+		}							\
+									\
+		/* Recurse into the smaller part, loop on the other */	\
+		if (j + 1 < n - j - 1) {				\
+			introsort_ ## name(a, j + 1, depth);		\
+			a += j + 1;					\
+			n -= j + 1;					\
+		} else {						\
+			introsort_ ## name(a + j + 1, n - j - 1, depth); \
+			n = j + 1;					\
+		}							\
+	}								\
+	isort_ ## name(a, n);						\
+}									\
+									\
+void qsort_ ## name(type *aa, size_t n)					\
+{									\
+	unsigned int depth = 0;						\
+	size_t l = 0;							\
+									\
+	for (l = n; l > 1; l >>= 1)					\
+		depth += 2;						\
+	introsort_ ## name(aa, n, depth);				\
 }
 
 QSORT_HELPER(int, int);
@@ -18,6 +18,11 @@ cflags-remove-arm32_aeabi_shift.c-y += -pg
 srcs-$(CFG_ARM32_$(sm)) += setjmp_a32.S
 srcs-$(CFG_ARM64_$(sm)) += setjmp_a64.S
 
+ifneq ($(sm),core)
+srcs-$(call cfg-all-enabled,CFG_TA_ARM64_STRING_ASM CFG_ARM64_$(sm)) += \
+	string_a64.S
+endif
+
 ifeq ($(CFG_TA_FLOAT_SUPPORT),y)
 # Floating point is only supported for user TAs
 ifneq ($(sm),core)
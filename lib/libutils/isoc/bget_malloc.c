@@ -94,7 +94,9 @@
 #if defined(__KERNEL__)
 /* Compiling for TEE Core */
 #include <kernel/asan.h>
+#include <kernel/misc.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <kernel/unwind.h>
 
 static void *memset_unchecked(void *s, int c, size_t n)
@@ -598,6 +600,505 @@ static struct malloc_ctx *get_ctx(uint32_t flags __maybe_unused)
 	return &malloc_ctx;
 }
 
+#if defined(__KERNEL__) && defined(CFG_CORE_HEAP_MAGAZINE) && \
+	!defined(ENABLE_MDBG)
+#define MAG_ENTRIES		CFG_CORE_HEAP_MAGAZINE_SIZE
+#define MAG_NUM_MAGAZINES	CFG_TEE_CORE_NB_CORE
+#define HEAP_MAGAZINE
+#elif !defined(__KERNEL__) && !defined(__LDELF__) && \
+	defined(CFG_TA_HEAP_MAGAZINE) && !defined(ENABLE_MDBG)
+#define MAG_ENTRIES		CFG_TA_HEAP_MAGAZINE_SIZE
+#define MAG_NUM_MAGAZINES	1
+#define HEAP_MAGAZINE
+#endif
+
+#ifdef HEAP_MAGAZINE
+/*
+ * Caches, or magazines, of free small buffers of the heap. The buffers
+ * are still allocated as far as bget is concerned. A buffer is cached in
+ * the size class of the largest request it can serve, so allocating or
+ * freeing a cached buffer doesn't search the bget free list.
+ *
+ * The core has one magazine per CPU, each with its own lock, which is
+ * only contended when the caches are drained. A TA is single threaded
+ * so it has a single magazine without lock, used only once the TA has
+ * opted in with malloc_enable_cache().
+ */
+#define MAG_MAX_SIZE		256
+#define MAG_NUM_CLASSES		(MAG_MAX_SIZE / SizeQuant)
+
+struct magazine {
+	unsigned int lock;
+	size_t count[MAG_NUM_CLASSES];
+	void *bufs[MAG_NUM_CLASSES][MAG_ENTRIES];
+	size_t cached_bytes;
+	size_t misses;
+};
+
+static struct magazine magazines[MAG_NUM_MAGAZINES];
+
+#ifdef __KERNEL__
+static bool mag_is_enabled(void)
+{
+	return true;
+}
+
+static void mag_lock_one(struct magazine *mag, uint32_t *exceptions)
+{
+	*exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	cpu_spin_lock(&mag->lock);
+}
+
+static struct magazine *mag_lock(uint32_t *exceptions)
+{
+	struct magazine *mag = NULL;
+
+	*exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	mag = magazines + get_core_pos();
+	cpu_spin_lock(&mag->lock);
+
+	return mag;
+}
+
+static void mag_unlock(struct magazine *mag, uint32_t exceptions)
+{
+	cpu_spin_unlock(&mag->lock);
+	thread_unmask_exceptions(exceptions);
+}
+#else /*__KERNEL__*/
+static bool mag_enabled;
+
+void malloc_enable_cache(void)
+{
+	mag_enabled = true;
+}
+
+static bool mag_is_enabled(void)
+{
+	return mag_enabled;
+}
+
+static void mag_lock_one(struct magazine *mag __unused,
+			 uint32_t *exceptions __unused)
+{
+}
+
+static struct magazine *mag_lock(uint32_t *exceptions __unused)
+{
+	return magazines;
+}
+
+static void mag_unlock(struct magazine *mag __unused,
+		       uint32_t exceptions __unused)
+{
+}
+#endif /*__KERNEL__*/
+
+static void mag_release(void **bufs, size_t count)
+{
+	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	size_t n = 0;
+
+	for (n = 0; n < count; n++)
+		brel(bufs[n], &malloc_ctx.poolset, false /*!wipe*/);
+	malloc_unlock(&malloc_ctx, exceptions);
+}
+
+static void *mag_alloc(uint32_t flags, void *ptr, size_t alignment,
+		       size_t nmemb, size_t size)
+{
+	struct magazine *mag = NULL;
+	uint32_t exceptions = 0;
+	void *buf = NULL;
+	size_t class = 0;
+	size_t s = 0;
+
+	if (!mag_is_enabled() || (flags & ~MAF_ZERO_INIT) || ptr ||
+	    alignment > SizeQuant || MUL_OVERFLOW(nmemb, size, &s) ||
+	    s > MAG_MAX_SIZE)
+		return NULL;
+
+	if (s)
+		class = (s - 1) / SizeQuant;
+
+	mag = mag_lock(&exceptions);
+	if (mag->count[class]) {
+		mag->count[class]--;
+		buf = mag->bufs[class][mag->count[class]];
+		mag->cached_bytes -= bget_buf_size(buf);
+	} else {
+		mag->misses++;
+	}
+	mag_unlock(mag, exceptions);
+
+	if (!buf)
+		return NULL;
+
+	if (flags & MAF_ZERO_INIT)
+		memset_unchecked(buf, 0, bget_buf_size(buf));
+
+	return maybe_tag_buf(buf, 0, MAX(SizeQuant, s));
+}
+
+static bool mag_free(uint32_t flags, void *ptr)
+{
+	void *flush[(MAG_ENTRIES + 1) / 2] = { };
+	struct magazine *mag = NULL;
+	uint32_t exceptions = 0;
+	size_t class = 0;
+	size_t sz = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	if (!mag_is_enabled() || flags || !ptr)
+		return false;
+
+	sz = bget_buf_size(strip_tag(ptr));
+	if (sz > MAG_MAX_SIZE)
+		return false;
+	class = sz / SizeQuant - 1;
+
+	ptr = maybe_untag_buf(ptr);
+
+	mag = mag_lock(&exceptions);
+	if (mag->count[class] == MAG_ENTRIES) {
+		/* Return the oldest half to the heap */
+		n = ARRAY_SIZE(flush);
+		memcpy(flush, mag->bufs[class], n * sizeof(void *));
+		memmove(mag->bufs[class], mag->bufs[class] + n,
+			(MAG_ENTRIES - n) * sizeof(void *));
+		mag->count[class] -= n;
+		for (i = 0; i < n; i++)
+			mag->cached_bytes -= bget_buf_size(flush[i]);
+	}
+	mag->bufs[class][mag->count[class]] = ptr;
+	mag->count[class]++;
+	mag->cached_bytes += sz;
+	mag_unlock(mag, exceptions);
+
+	if (n)
+		mag_release(flush, n);
+
+	return true;
+}
+
+/* Returns true if any buffer was returned to the heap */
+static bool mag_drain(void)
+{
+	void *bufs[MAG_ENTRIES] = { };
+	struct magazine *mag = NULL;
+	uint32_t exceptions = 0;
+	bool drained = false;
+	size_t class = 0;
+	size_t count = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	for (n = 0; n < ARRAY_SIZE(magazines); n++) {
+		mag = magazines + n;
+		for (class = 0; class < MAG_NUM_CLASSES; class++) {
+			mag_lock_one(mag, &exceptions);
+			count = mag->count[class];
+			memcpy(bufs, mag->bufs[class], count * sizeof(void *));
+			mag->count[class] = 0;
+			for (i = 0; i < count; i++)
+				mag->cached_bytes -= bget_buf_size(bufs[i]);
+			mag_unlock(mag, exceptions);
+
+			if (count) {
+				mag_release(bufs, count);
+				drained = true;
+			}
+		}
+	}
+
+	return drained;
+}
+
+#ifdef CFG_WITH_STATS
+void malloc_get_cache_stats(struct pta_stats_alloc *stats)
+{
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	for (n = 0; n < ARRAY_SIZE(magazines); n++) {
+		mag_lock_one(magazines + n, &exceptions);
+		stats->allocated += magazines[n].cached_bytes;
+		stats->num_alloc_fail += magazines[n].misses;
+		mag_unlock(magazines + n, exceptions);
+	}
+	for (n = 0; n < MAG_NUM_CLASSES; n++)
+		stats->size += (n + 1) * SizeQuant * MAG_ENTRIES *
+			       ARRAY_SIZE(magazines);
+}
+#endif /*CFG_WITH_STATS*/
+#else /*HEAP_MAGAZINE*/
+static void *mag_alloc(uint32_t flags __unused, void *ptr __unused,
+		       size_t alignment __unused, size_t nmemb __unused,
+		       size_t size __unused)
+{
+	return NULL;
+}
+
+static bool mag_free(uint32_t flags __unused, void *ptr __unused)
+{
+	return false;
+}
+
+static bool mag_drain(void)
+{
+	return false;
+}
+
+#if !defined(__KERNEL__) && !defined(__LDELF__)
+void malloc_enable_cache(void)
+{
+}
+#endif
+
+#ifdef CFG_WITH_STATS
+void malloc_get_cache_stats(struct pta_stats_alloc *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+#endif
+#endif /*HEAP_MAGAZINE*/
+
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_SAMPLING)
+/*
+ * Sampling heap profiler. The allocations are counted down from the
+ * sampling period without a lock, losing a count in a race only moves the
+ * next sample. The stack of a sampled allocation is recorded in a call
+ * site and the allocation is kept in a hash table with linear probing
+ * until freed. Freeing costs nothing more than a load while no sampled
+ * allocation is live.
+ */
+#define SAMPLE_NUM_SITES	CFG_CORE_MALLOC_SAMPLING_SITES
+#define SAMPLE_NUM_LIVE		CFG_CORE_MALLOC_SAMPLING_LIVE
+#define SAMPLE_STACK_DEPTH	STATS_MALLOC_STACK_DEPTH
+
+struct sample_site {
+	uint64_t live_bytes;
+	uint32_t live_count;
+	uint32_t total_count;
+	vaddr_t stack[SAMPLE_STACK_DEPTH];
+};
+
+struct sample_live {
+	void *ptr;
+	size_t size;
+	struct sample_site *site;
+};
+
+static unsigned int sample_lock = SPINLOCK_UNLOCK;
+static uint32_t sample_period;
+static uint32_t sample_countdown;
+static uint32_t sample_dropped;
+static size_t sample_live_count;
+static struct sample_site sample_sites[SAMPLE_NUM_SITES];
+static struct sample_live sample_live[SAMPLE_NUM_LIVE];
+
+void malloc_sampling_set_period(uint32_t period)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sample_lock);
+
+	sample_period = period;
+	sample_countdown = period;
+	cpu_spin_unlock_xrestore(&sample_lock, exceptions);
+}
+
+uint32_t malloc_sampling_get_period(void)
+{
+	return sample_period;
+}
+
+static size_t sample_live_idx(void *ptr)
+{
+	return ((vaddr_t)strip_tag(ptr) / SizeQuant) % SAMPLE_NUM_LIVE;
+}
+
+static struct sample_site *sample_get_site(const vaddr_t *stack)
+{
+	struct sample_site *free_site = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < SAMPLE_NUM_SITES; n++) {
+		if (!sample_sites[n].stack[0]) {
+			if (!free_site)
+				free_site = sample_sites + n;
+		} else if (!memcmp(sample_sites[n].stack, stack,
+				   sizeof(sample_sites[n].stack))) {
+			return sample_sites + n;
+		}
+	}
+
+	if (free_site)
+		memcpy(free_site->stack, stack, sizeof(free_site->stack));
+	return free_site;
+}
+
+static void __noinline sample_record(void *ptr, size_t size)
+{
+	/* One more frame for this function */
+	vaddr_t stack[SAMPLE_STACK_DEPTH + 1] = { };
+	struct sample_site *site = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	unw_fill_kernel_stack(stack, ARRAY_SIZE(stack));
+
+	exceptions = cpu_spin_lock_xsave(&sample_lock);
+	/* An empty stack would look like an unused site */
+	if (stack[1])
+		site = sample_get_site(stack + 1);
+	if (!site || sample_live_count == SAMPLE_NUM_LIVE) {
+		sample_dropped++;
+		goto out;
+	}
+
+	n = sample_live_idx(ptr);
+	while (sample_live[n].ptr)
+		n = (n + 1) % SAMPLE_NUM_LIVE;
+	sample_live[n].ptr = ptr;
+	sample_live[n].size = size;
+	sample_live[n].site = site;
+	sample_live_count++;
+
+	site->live_bytes += size;
+	site->live_count++;
+	site->total_count++;
+out:
+	cpu_spin_unlock_xrestore(&sample_lock, exceptions);
+}
+
+static void sample_forget(void *ptr)
+{
+	struct sample_site *site = NULL;
+	uint32_t exceptions = 0;
+	size_t empty = 0;
+	size_t idx = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&sample_lock);
+
+	n = sample_live_idx(ptr);
+	while (sample_live[n].ptr != ptr) {
+		if (!sample_live[n].ptr)
+			goto out;
+		n = (n + 1) % SAMPLE_NUM_LIVE;
+	}
+
+	site = sample_live[n].site;
+	site->live_bytes -= sample_live[n].size;
+	site->live_count--;
+	sample_live_count--;
+
+	/* Move back the entries which would no longer be found */
+	empty = n;
+	while (true) {
+		n = (n + 1) % SAMPLE_NUM_LIVE;
+		if (!sample_live[n].ptr)
+			break;
+		idx = sample_live_idx(sample_live[n].ptr);
+		if ((n > empty && (idx <= empty || idx > n)) ||
+		    (n < empty && idx <= empty && idx > n)) {
+			sample_live[empty] = sample_live[n];
+			empty = n;
+		}
+	}
+	sample_live[empty] = (struct sample_live){ };
+out:
+	cpu_spin_unlock_xrestore(&sample_lock, exceptions);
+}
+
+static bool sample_tick(void)
+{
+	uint32_t countdown = sample_countdown;
+
+	if (!sample_period)
+		return false;
+	if (countdown > 1) {
+		sample_countdown = countdown - 1;
+		return false;
+	}
+	sample_countdown = sample_period;
+	return true;
+}
+
+static void sample_alloc(void *old_ptr, void *ptr, size_t size)
+{
+	if (!ptr)
+		return;
+	if (old_ptr && sample_live_count)
+		sample_forget(old_ptr);
+	if (sample_tick())
+		sample_record(ptr, size);
+}
+
+static void sample_free(void *ptr)
+{
+	if (ptr && sample_live_count)
+		sample_forget(ptr);
+}
+
+size_t malloc_sampling_get_sites(struct pta_stats_malloc_site *sites,
+				 size_t count, uint32_t *dropped)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sample_lock);
+	struct sample_site *site = NULL;
+	size_t num_sites = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	for (n = 0; n < SAMPLE_NUM_SITES; n++) {
+		site = sample_sites + n;
+		if (!site->stack[0])
+			continue;
+		if (num_sites < count) {
+			sites[num_sites] = (struct pta_stats_malloc_site){
+				.live_bytes = site->live_bytes,
+				.live_count = site->live_count,
+				.total_count = site->total_count,
+			};
+			for (m = 0; m < SAMPLE_STACK_DEPTH; m++)
+				sites[num_sites].stack[m] = site->stack[m];
+		}
+		num_sites++;
+	}
+	*dropped = sample_dropped;
+
+	cpu_spin_unlock_xrestore(&sample_lock, exceptions);
+
+	return num_sites;
+}
+
+void malloc_sampling_clear(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sample_lock);
+	size_t n = 0;
+
+	for (n = 0; n < SAMPLE_NUM_SITES; n++) {
+		if (!sample_sites[n].live_count)
+			sample_sites[n] = (struct sample_site){ };
+		else
+			sample_sites[n].total_count = 0;
+	}
+	sample_dropped = 0;
+
+	cpu_spin_unlock_xrestore(&sample_lock, exceptions);
+}
+#else
+static void sample_alloc(void *old_ptr __unused, void *ptr __unused,
+			 size_t size __unused)
+{
+}
+
+static void sample_free(void *ptr __unused)
+{
+}
+#endif
+
 static void *mem_alloc(uint32_t flags, void *ptr, size_t alignment,
 		       size_t nmemb, size_t size, const char *fname, int lineno)
 {
@@ -605,11 +1106,26 @@ static void *mem_alloc(uint32_t flags, void *ptr, size_t alignment,
 	uint32_t exceptions = 0;
 	void *p = NULL;
 
+	p = mag_alloc(flags, ptr, alignment, nmemb, size);
+	if (p)
+		goto out;
+
 	exceptions = malloc_lock(ctx);
 	p = mem_alloc_unlocked(flags, ptr, alignment, nmemb, size, fname,
 			       lineno, ctx);
 	malloc_unlock(ctx, exceptions);
 
+	/* Retry once with the memory held in the caches returned */
+	if (!p && ctx == &malloc_ctx && mag_drain()) {
+		exceptions = malloc_lock(ctx);
+		p = mem_alloc_unlocked(flags, ptr, alignment, nmemb, size,
+				       fname, lineno, ctx);
+		malloc_unlock(ctx, exceptions);
+	}
+
+out:
+	if (ctx == &malloc_ctx)
+		sample_alloc(ptr, p, nmemb * size);
 	return p;
 }
 
@@ -618,6 +1134,12 @@ void free_flags(uint32_t flags, void *ptr)
 	struct malloc_ctx *ctx = get_ctx(flags);
 	uint32_t exceptions = 0;
 
+	if (ctx == &malloc_ctx)
+		sample_free(ptr);
+
+	if (mag_free(flags, ptr))
+		return;
+
 	exceptions = malloc_lock(ctx);
 
 	if (IS_ENABLED2(ENABLE_MDBG) && ptr) {
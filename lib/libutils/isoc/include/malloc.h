@@ -80,12 +80,45 @@ bool malloc_buffer_overlaps_heap(void *buf, size_t len);
  */
 void malloc_add_pool(void *buf, size_t len);
 
+#if !defined(__KERNEL__) && !defined(__LDELF__)
+/*
+ * Enables the cache of small buffers in front of the heap of a TA,
+ * CFG_TA_HEAP_MAGAZINE. Does nothing if the cache isn't compiled in.
+ *
+ * Used internally by TAs
+ */
+void malloc_enable_cache(void);
+#endif
+
 #ifdef CFG_WITH_STATS
 /* Get/reset allocation statistics */
 void malloc_get_stats(struct pta_stats_alloc *stats);
 void malloc_reset_stats(void);
+/*
+ * Get statistics of the small buffer caches, CFG_CORE_HEAP_MAGAZINE or
+ * CFG_TA_HEAP_MAGAZINE
+ */
+void malloc_get_cache_stats(struct pta_stats_alloc *stats);
 #endif /* CFG_WITH_STATS */
 
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_SAMPLING)
+/*
+ * Sampling heap profiler, CFG_CORE_MALLOC_SAMPLING. One out of @period
+ * allocations has its call stack recorded and is tracked until freed,
+ * @period 0 disables sampling.
+ */
+void malloc_sampling_set_period(uint32_t period);
+uint32_t malloc_sampling_get_period(void);
+/*
+ * Copies at most @count call sites to @sites and returns the number of
+ * call sites. @dropped receives the number of samples lost to full tables.
+ */
+size_t malloc_sampling_get_sites(struct pta_stats_malloc_site *sites,
+				 size_t count, uint32_t *dropped);
+/* Clears the counts and forgets the sites without live allocations */
+void malloc_sampling_clear(void);
+#endif
+
 #ifdef CFG_NS_VIRTUALIZATION
 #ifdef ENABLE_MDBG
 
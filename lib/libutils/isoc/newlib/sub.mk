@@ -5,6 +5,9 @@ cflags-remove-y += -Wcast-align
 srcs-y += abs.c
 srcs-y += bcmp.c
 srcs-y += memchr.c
+# Replaced by arch/arm/string_a64.S for user mode AArch64 with
+# CFG_TA_ARM64_STRING_ASM=y
+ifneq (y-y-,$(CFG_TA_ARM64_STRING_ASM)-$(CFG_ARM64_$(sm))-$(filter core,$(sm)))
 srcs-y += memcmp.c
 srcs-y += memcpy.c
 ifeq (s,$(CFG_CC_OPT_LEVEL))
@@ -15,6 +18,7 @@ srcs-y += memmove.c
 cflags-memmove.c-y += $(call cc-option,-fno-tree-loop-distribute-patterns)
 srcs-y += memset.c
 cflags-memset.c-y += $(call cc-option,-fno-tree-loop-distribute-patterns)
+endif
 srcs-y += strchr.c
 srcs-y += strcmp.c
 srcs-y += strcpy.c
@@ -86,6 +86,17 @@ CFG_TEE_TA_LOG_LEVEL ?= 1
 # CFG_TEE_TA_LOG_LEVEL. Otherwise, they are not output at all
 CFG_TEE_CORE_TA_TRACE ?= y
 
+# CFG_CORE_TRACE_RING, when enabled, appends the trace output of the core
+# to a per-core ring buffer of CFG_CORE_TRACE_RING_SIZE bytes instead of
+# writing it to the console, once the MMU is enabled. Traces then cost a
+# copy instead of a wait for the UART. The normal world reads the
+# buffered output with the trace ring pseudo TA, or registers a
+# non-secure buffer with it that the core then writes to, lock-free, one
+# ring per core. The oldest output is overwritten when a ring is full. On
+# panic, the rings are flushed to the console.
+CFG_CORE_TRACE_RING ?= n
+CFG_CORE_TRACE_RING_SIZE ?= 4096
+
 # If y, enable the memory leak detection feature in the bget memory allocator.
 # When this feature is enabled, calling mdbg_check(1) will print a list of all
 # the currently allocated buffers and the location of the allocation (file and
@@ -112,6 +123,15 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
+# Number of threads with a statically reserved stack. When lower than
+# CFG_NUM_THREADS, the stacks of the remaining threads are allocated from
+# the core heap the first time each of these threads is needed and kept
+# from then on. CFG_NUM_THREADS then acts as an upper bound for bursts of
+# concurrent calls instead of a fixed memory cost. Calls refused because
+# all threads are busy are reported by stats.pta (STATS_CMD_THREAD_STATS).
+# Not supported with CFG_WITH_PAGER or CFG_NS_VIRTUALIZATION.
+CFG_NUM_THREADS_STATIC ?= $(CFG_NUM_THREADS)
+
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
 
@@ -152,11 +172,59 @@ CFG_REE_FS ?= y
 # RPMB file system support
 CFG_RPMB_FS ?= n
 
+# Size of the REE FS data blocks as a power of two, 12 (4 KiB) to 16
+# (64 KiB). Each data block has its own node in the hash tree of a file,
+# so larger blocks mean fewer nodes to update and authenticate for large
+# objects, at the cost of rewriting a whole block on small writes and of
+# larger temporary buffers. Objects stored with one block size can't be
+# read with another.
+CFG_REE_FS_BLOCK_SHIFT ?= 12
+
 # Enable roll-back protection of REE file system using RPMB.
 # Roll-back protection only works if CFG_RPMB_FS = y.
 CFG_REE_FS_INTEGRITY_RPMB ?= $(CFG_RPMB_FS)
 $(eval $(call cfg-depends-all,CFG_REE_FS_INTEGRITY_RPMB,CFG_RPMB_FS))
 
+# CFG_REE_FS_RPC_BATCH, when enabled, writes the hash tree nodes of a REE
+# FS file with as few OPTEE_RPC_FS_WRITEV requests as possible when the
+# file is synced, instead of one OPTEE_RPC_FS_WRITE per node. Consecutive
+# data blocks written by one write request are batched the same way. This
+# requires a tee-supplicant supporting OPTEE_RPC_FS_WRITEV, else the
+# writes fall back to one request each.
+CFG_REE_FS_RPC_BATCH ?= n
+$(eval $(call cfg-depends-all,CFG_REE_FS_RPC_BATCH,CFG_REE_FS))
+
+# CFG_REE_FS_BLOCK_CACHE sets the number of decrypted and authenticated
+# REE FS data blocks kept in secure memory, most recently used first. A
+# block read again is then served from the cache instead of being fetched
+# from normal world and decrypted again. Heap memory is allocated as the
+# cache fills up, one block is 2^CFG_REE_FS_BLOCK_SHIFT bytes. 0 disables
+# the cache.
+CFG_REE_FS_BLOCK_CACHE ?= 0
+
+# CFG_REE_FS_HTREE_LAZY_VERIFY, when enabled, only reads and verifies the
+# root of the hash tree of a REE FS file when it's opened. The nodes on the
+# path to a data block are read and verified the first time the block is
+# accessed and are kept in memory after that. Opening a large object
+# doesn't read the whole tree then, but corruption of a node is only
+# detected once a block below it is accessed.
+CFG_REE_FS_HTREE_LAZY_VERIFY ?= n
+$(eval $(call cfg-depends-all,CFG_REE_FS_HTREE_LAZY_VERIFY,CFG_REE_FS))
+
+# CFG_TEE_OBJ_INFO_CACHE sets the number of persistent objects for which
+# the object information returned when enumerating objects is kept in
+# memory. Enumerating cached objects doesn't open them and read their
+# head. An entry is dropped whenever its object is modified. 0 disables
+# the cache.
+CFG_TEE_OBJ_INFO_CACHE ?= 0
+
+# CFG_TEE_FS_KEY_CACHE sets the number of TA storage keys and of unwrapped
+# file encryption keys kept in secure memory, most recently used first.
+# Opening an object, or an RPMB FS block being encrypted or decrypted,
+# then doesn't derive the TA storage key and unwrap the file encryption
+# key again. Evicted entries are wiped. 0 disables the cache.
+CFG_TEE_FS_KEY_CACHE ?= 0
+
 # Device identifier used when CFG_RPMB_FS = y.
 # The exact meaning of this value is platform-dependent. On Linux, the
 # tee-supplicant process will open /dev/mmcblk<id>rpmb
@@ -195,6 +263,21 @@ CFG_RPMB_FS_RD_ENTRIES ?= 8
 # in case the cache is too small to hold all elements when traversing.
 CFG_RPMB_FS_CACHE_ENTRIES ?= 0
 
+# Use the Reliable Write Sector Count reported by the eMMC device to write
+# several RPMB data frames in a single authenticated write request instead
+# of one frame per request. Only enable this when the normal world RPMB
+# path (tee-supplicant or the kernel RPMB subsystem) handles multi-frame
+# reliable writes correctly.
+CFG_RPMB_FS_MULTI_BLOCK_WRITE ?= n
+$(eval $(call cfg-depends-all,CFG_RPMB_FS_MULTI_BLOCK_WRITE,CFG_RPMB_FS))
+
+# Keep an in-memory index of the RPMB FS FAT entries hashed on the filename.
+# Opening, renaming or removing a file then reads only the FAT entries with
+# a matching hash instead of scanning the FAT from its start. The index
+# costs one small heap allocation per file plus a table of 64 buckets.
+CFG_RPMB_FS_NAME_INDEX ?= n
+$(eval $(call cfg-depends-all,CFG_RPMB_FS_NAME_INDEX,CFG_RPMB_FS))
+
 # Print RPMB data frames sent to and received from the RPMB device
 CFG_RPMB_FS_DEBUG_DATA ?= n
 
@@ -222,6 +305,14 @@ CFG_RPMB_WRITE_KEY ?= n
 # how the RPMB commands are routed to simplify testing.
 CFG_RPMB_ANNOUNCE_PROBE_CAP ?= y
 
+# CFG_CORE_INVOKE_BATCH, when enabled, supports OPTEE_MSG_CMD_INVOKE_BATCH
+# where normal world passes several invoke commands in one shared memory
+# buffer, executed in sequence by the same thread, to save the world
+# switches of one standard call per command. Announced to normal world
+# with the OPTEE_SMC_SEC_CAP_INVOKE_BATCH or OPTEE_FFA_SEC_CAP_INVOKE_BATCH
+# capability.
+CFG_CORE_INVOKE_BATCH ?= y
+
 _CFG_WITH_SECURE_STORAGE := $(call cfg-one-enabled,CFG_REE_FS CFG_RPMB_FS)
 
 # Signing key for OP-TEE TA's
@@ -363,6 +454,24 @@ CFG_REE_FS_TA ?= y
 CFG_REE_FS_TA_BUFFERED ?= n
 $(eval $(call cfg-depends-all,CFG_REE_FS_TA_BUFFERED,CFG_REE_FS_TA))
 
+# CFG_REE_FS_TA_CACHE keeps TA binaries verified by the buffered REE FS TA
+# store in secure memory, up to CFG_REE_FS_TA_CACHE_SIZE bytes, least
+# recently used first. Opening a session to a cached TA then doesn't load
+# it from tee-supplicant nor verify its signature again. Entries older
+# than a newly accepted TA version are invalidated, and unused entries are
+# dropped when the TA memory pool runs out. Note that an updated TA binary
+# in the REE FS isn't seen until its cached entry is evicted.
+CFG_REE_FS_TA_CACHE ?= n
+CFG_REE_FS_TA_CACHE_SIZE ?= 0x100000
+$(eval $(call cfg-depends-all,CFG_REE_FS_TA_CACHE,CFG_REE_FS_TA_BUFFERED))
+
+# CFG_FILE_KEEP_COUNT sets the number of fully verified TA and shared
+# library binaries whose read-only segments are kept in secure memory
+# after the last TA using them is gone. A TA or library loaded again then
+# maps the kept pages instead of copying the segments anew. Kept binaries
+# are released when TA memory runs out. 0 disables this.
+CFG_FILE_KEEP_COUNT ?= 0
+
 # When CFG_REE_FS=y:
 # Allow secure storage in the REE FS to be entirely deleted without causing
 # anti-rollback errors. That is, rm /data/tee/dirf.db or rm -rf /data/tee (or
@@ -432,13 +541,46 @@ CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 # TAG and IV in order to reduce heap usage.
 CFG_CORE_PAGE_TAG_AND_IV ?= $(CFG_PAGED_USER_TA)
 
+# CFG_PAGER_READ_AHEAD_PAGES, when > 0 with CFG_WITH_PAGER=y, is the number
+# of pages loaded ahead when the pager handles a fault on the page following
+# the previously faulting page. Pages loaded ahead are kept unmapped until
+# used, like hidden pages, so they are cheap to map on first access.
+CFG_PAGER_READ_AHEAD_PAGES ?= 0
+
+# CFG_PAGER_FREQ_REPLACEMENT, when enabled with CFG_WITH_PAGER=y, replaces the
+# least recently used page eviction of the pager with a CLOCK like scan
+# where pages keep a count of the accesses seen when they were hidden.
+# Pages used often then survive while pages used once are evicted first.
+# Compare the evictions and refaults of struct tee_pager_stats to tune.
+CFG_PAGER_FREQ_REPLACEMENT ?= n
+
+# CFG_PAGER_RW_COMPRESS, when enabled with CFG_WITH_PAGER=y, compresses
+# paged out read/write pages before they are encrypted. The encrypted
+# blobs are kept in a pool of CFG_PAGER_RW_COMPRESS_POOL_SIZE bytes taken
+# from the TA RAM which may back CFG_PAGER_RW_COMPRESS_OVERCOMMIT percent
+# of its size in pages. Paged memory allocated beyond that uses regular
+# uncompressed storage. The pool must be large enough for the actual
+# compressed size of the pages or the pager panics when saving a page.
+# Requires CFG_CORE_PAGE_TAG_AND_IV=n.
+CFG_PAGER_RW_COMPRESS ?= n
+CFG_PAGER_RW_COMPRESS_POOL_SIZE ?= 0x100000
+CFG_PAGER_RW_COMPRESS_OVERCOMMIT ?= 200
+ifeq ($(CFG_PAGER_RW_COMPRESS),y)
+$(eval $(call cfg-depends-all,CFG_PAGER_RW_COMPRESS,CFG_WITH_PAGER))
+ifeq ($(CFG_CORE_PAGE_TAG_AND_IV),y)
+$(error CFG_PAGER_RW_COMPRESS requires CFG_CORE_PAGE_TAG_AND_IV=n)
+endif
+endif
+
 # Runtime lock dependency checker: ensures that a proper locking hierarchy is
 # used in the TEE core when acquiring and releasing mutexes. Any violation will
 # cause a panic as soon as the invalid locking condition is detected. If
 # CFG_UNWIND and CFG_LOCKDEP_RECORD_STACK are both enabled, the algorithm
 # records the call stacks when locks are taken, and prints them when a
 # potential deadlock is found.
-# Expect a significant performance impact when enabling this.
+# The graph is only searched when a new lock order is seen, the cost of
+# each acquisition is then mostly that of recording the call stack. Disable
+# CFG_LOCKDEP_RECORD_STACK for long test runs.
 CFG_LOCKDEP ?= n
 CFG_LOCKDEP_RECORD_STACK ?= y
 
@@ -591,6 +733,36 @@ CFG_BOOT_SECONDARY_REQUEST ?= n
 # Default heap size for Core, 64 kB
 CFG_CORE_HEAP_SIZE ?= 65536
 
+# CFG_CORE_HEAP_MAGAZINE, when enabled, adds per-CPU caches of recently
+# freed small buffers, up to 256 bytes, in front of the core heap.
+# Allocations served from the cache don't take the heap lock. Each CPU
+# caches up to CFG_CORE_HEAP_MAGAZINE_SIZE buffers per size class. The
+# caches are flushed back to the heap when an allocation fails. Ignored
+# with CFG_TEE_CORE_MALLOC_DEBUG=y.
+CFG_CORE_HEAP_MAGAZINE ?= n
+CFG_CORE_HEAP_MAGAZINE_SIZE ?= 8
+
+# CFG_TA_HEAP_MAGAZINE, when enabled, compiles the same cache of small
+# buffers into the heap of user TAs. A TA opts in with TA_FLAG_HEAP_CACHE
+# in TA_FLAGS. Since a TA is single threaded it has one cache, holding up
+# to CFG_TA_HEAP_MAGAZINE_SIZE buffers per size class. Ignored for ldelf
+# and with CFG_TEE_TA_MALLOC_DEBUG=y.
+CFG_TA_HEAP_MAGAZINE ?= n
+CFG_TA_HEAP_MAGAZINE_SIZE ?= 8
+
+# CFG_CORE_MALLOC_SAMPLING, when enabled, adds a sampling heap profiler to
+# the core heap which is cheap enough for release builds. Once a sampling
+# period N is set with STATS_CMD_MALLOC_SAMPLING, one out of N
+# allocations has its call stack recorded and the bytes still allocated
+# are accounted per call site, which points at leaks without
+# CFG_TEE_CORE_MALLOC_DEBUG. Up to CFG_CORE_MALLOC_SAMPLING_SITES call
+# sites and CFG_CORE_MALLOC_SAMPLING_LIVE live sampled allocations are
+# tracked.
+CFG_CORE_MALLOC_SAMPLING ?= n
+CFG_CORE_MALLOC_SAMPLING_SITES ?= 128
+CFG_CORE_MALLOC_SAMPLING_LIVE ?= 1024
+$(eval $(call cfg-depends-all,CFG_CORE_MALLOC_SAMPLING,CFG_UNWIND CFG_WITH_STATS))
+
 # Default size of nexus heap. 16 kB. Used only if CFG_NS_VIRTUALIZATION
 # is enabled
 CFG_CORE_NEX_HEAP_SIZE ?= 16384
@@ -607,11 +779,22 @@ CFG_CORE_NEX_HEAP_SIZE ?= 16384
 # the TA is linked statically.
 CFG_TA_GPROF_SUPPORT ?= n
 
+# Core profiling.
+# When this option is enabled, the program counter of the core is sampled
+# each time a thread executing in the core is preempted by a normal world
+# interrupt. The samples are accumulated in a histogram over the core text
+# that the normal world controls and reads with the core profiling pseudo
+# TA, see lib/libutee/include/pta_core_prof.h.
+CFG_CORE_PC_SAMPLING ?= n
+
 # TA function tracing.
 # When this option is enabled, OP-TEE can execute Trusted Applications
 # instrumented with GCC's -pg flag and will output function tracing
 # information for all functions compiled with -pg to
 # /tmp/ftrace-<ta_uuid>.out (path is defined in tee-supplicant).
+# scripts/ftrace_format.py converts it to text or, with --chrome, to JSON
+# trace events. Instrumentation can be restricted to some source files of a
+# TA with cppflags-remove-<file>-y += -pg in its sub.mk.
 CFG_FTRACE_SUPPORT ?= n
 
 # Core syscall function tracing.
@@ -675,6 +858,21 @@ $(eval $(call cfg-depends-all,CFG_SYSTEM_PTA,CFG_WITH_USER_TA))
 # world OS.
 CFG_DEVICE_ENUM_PTA ?= y
 
+# CFG_CONCURRENT_SINGLE_INSTANCE_TA, when enabled, lets different
+# single-instance TAs run concurrently on different threads. By default
+# only one thread at a time may run any single-instance TA, which
+# serializes otherwise independent TAs. Each TA instance is still
+# entered by one thread at a time. A TA calling back into an instance
+# busy earlier in the same call chain gets TEE_ERROR_BUSY, but TAs
+# invoking each other from different threads can dead-lock, so only
+# enable this if the TAs don't form such cycles.
+CFG_CONCURRENT_SINGLE_INSTANCE_TA ?= n
+
+# Enable the pseudo TA that lets the normal world preload keep-alive TAs,
+# so that the first session open to them doesn't load and relocate them.
+CFG_TA_PRELOAD_PTA ?= n
+$(eval $(call cfg-depends-all,CFG_TA_PRELOAD_PTA,CFG_WITH_USER_TA))
+
 # The attestation pseudo TA provides an interface to request measurements of
 # a TA or the TEE binary.
 CFG_ATTESTATION_PTA ?= n
@@ -705,6 +903,24 @@ CFG_CORE_THREAD_SHIFT ?= 0
 # non-secure memory).
 CFG_CORE_DYN_SHM ?= y
 
+# CFG_CORE_DYN_SHM_MAP_CACHE is the number of registered shared memory
+# objects kept mapped in the core virtual memory once they aren't used
+# any longer. The least recently used ones are unmapped first, when the
+# limit is reached or when the address space for shared memory runs out.
+# This avoids mapping and unmapping, with the TLB maintenance involved,
+# each time normal world invokes a TA using the same buffers. 0 unmaps the
+# objects as soon as they are unused.
+CFG_CORE_DYN_SHM_MAP_CACHE ?= 0
+
+# CFG_TA_PARAM_MAP_CACHE keeps the user TA mappings of registered shared
+# memory parameters after a call returns. The next call of the same session
+# with the same buffers reuses them instead of mapping them again, mappings
+# not used by that call are removed before entering the TA. The mappings
+# are dropped when normal world unregisters the shared memory, which then
+# waits for a TA busy with another call to return.
+CFG_TA_PARAM_MAP_CACHE ?= n
+$(eval $(call cfg-depends-all,CFG_TA_PARAM_MAP_CACHE,CFG_CORE_DYN_SHM))
+
 # Enable support for reserved shared memory (shared memory in a carved out
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
@@ -728,6 +944,16 @@ $(call force,CFG_TA_MBEDTLS,y)
 # need to be called to test anything
 CFG_TA_MBEDTLS_SELF_TEST ?= y
 
+# CFG_TA_DRBG, when enabled, makes libutee serve TEE_GenerateRandom()
+# requests of at most CFG_TA_DRBG_MAX_REQ bytes from a per TA instance
+# CTR_DRBG instead of doing a system call for each of them. The DRBG is
+# seeded from the OP-TEE core random number generator and reseeded each
+# time a session is opened and after CFG_TA_DRBG_RESEED_BYTES bytes of
+# output.
+CFG_TA_DRBG ?= n
+CFG_TA_DRBG_MAX_REQ ?= 256
+CFG_TA_DRBG_RESEED_BYTES ?= 65536
+
 # By default use tomcrypt as the main crypto lib providing an implementation
 # for the API in <crypto/crypto.h>
 # CFG_CRYPTOLIB_NAME is used as libname and
@@ -743,6 +969,21 @@ CFG_CRYPTOLIB_DIR ?= core/lib/libtomcrypt
 # that would set = n.
 $(call force,CFG_CORE_MBEDTLS_MPI,y)
 
+# CFG_CORE_MBEDTLS_MPI_ASM, when enabled, builds the big number arithmetic
+# of the core with the Arm inline assembly multiply-accumulate loops from
+# mbedTLS (bn_mul.h) instead of the portable C ones. Montgomery
+# multiplication, and so RSA, DH and DSA private key operations, benefits
+# on platforms without a public key accelerator.
+CFG_CORE_MBEDTLS_MPI_ASM ?= y
+
+# CFG_CORE_MPI_POOL_PER_THREAD, when enabled, gives each thread its own
+# scratch memory pool for big number temporaries, and for other users of
+# the default memory pool, instead of a single pool that is reserved by
+# one thread at a time. Concurrent RSA or ECC operations on different
+# cores then run in parallel at the cost of CFG_NUM_THREADS extra pools
+# of 46 KiB each.
+CFG_CORE_MPI_POOL_PER_THREAD ?= n
+
 # When enabled, CFG_NS_VIRTUALIZATION embeds support for virtualization in
 # the non-secure world. OP-TEE will not work without a compatible hypervisor
 # in the non-secure world if this option is enabled.
@@ -765,6 +1006,19 @@ $(call force,CFG_CORE_RWDATA_NOEXEC,y)
 
 # Default number of virtual guests
 CFG_VIRT_GUEST_COUNT ?= 2
+
+# Number of threads out of CFG_NUM_THREADS a virtual guest can have active
+# at the same time, calls beyond it are refused with ETHREAD_LIMIT. It's
+# the default for all guests, platforms can give each guest its own quota
+# by overriding plat_virt_guest_thread_quota().
+CFG_VIRT_GUEST_THREAD_QUOTA ?= $(CFG_NUM_THREADS)
+
+# When enabled, guests don't get a fixed TA RAM carve-out at creation.
+# Instead TA memory is drawn from the shared secure pool as needed, up to
+# a per-guest limit given by plat_virt_guest_ta_ram_limit(), and returned
+# to the pool when freed. Idle guests use no TA RAM so more guests fit in
+# the same TZDRAM, especially when the limits overcommit the pool.
+CFG_VIRT_GUEST_TA_RAM_ON_DEMAND ?= n
 endif
 
 # Enables backwards compatible derivation of RPMB and SSK keys
@@ -774,6 +1028,11 @@ CFG_CORE_HUK_SUBKEY_COMPAT ?= y
 # This option depends on CFG_CORE_HUK_SUBKEY_COMPAT=y.
 CFG_CORE_HUK_SUBKEY_COMPAT_USE_OTP_DIE_ID ?= n
 
+# CFG_CORE_HUK_SUBKEY_CACHE, when enabled, keeps the hardware unique key
+# and the last few subkeys derived by huk_subkey_derive() in secure memory,
+# saving OTP reads and HMAC computations. The cache is wiped on suspend.
+CFG_CORE_HUK_SUBKEY_CACHE ?= n
+
 # Compress and encode conf.mk into the TEE core, and show the encoded string on
 # boot (with severity TRACE_INFO).
 CFG_SHOW_CONF_ON_BOOT ?= n
@@ -793,6 +1052,9 @@ CFG_CORE_TPM_EVENT_LOG ?= n
 # CFG_SCMI_MSG_SMT_FASTCALL_ENTRY embeds fastcall SMC entry with SMT memory
 # CFG_SCMI_MSG_SMT_INTERRUPT_ENTRY embeds interrupt entry with SMT memory
 # CFG_SCMI_MSG_SMT_THREAD_ENTRY embeds threaded entry with SMT memory
+# CFG_SCMI_MSG_SMT_BATCH makes each SMT entry process messages until the
+#   channel is empty, the agent may post a message right after reading
+#   the previous response without a new SMC or interrupt.
 # CFG_SCMI_MSG_SHM_MSG embeds a MSG header in cached shared memory buffer
 CFG_SCMI_MSG_DRIVERS ?= n
 ifeq ($(CFG_SCMI_MSG_DRIVERS),y)
@@ -803,11 +1065,13 @@ CFG_SCMI_MSG_SMT ?= n
 CFG_SCMI_MSG_SMT_FASTCALL_ENTRY ?= n
 CFG_SCMI_MSG_SMT_INTERRUPT_ENTRY ?= n
 CFG_SCMI_MSG_SMT_THREAD_ENTRY ?= n
+CFG_SCMI_MSG_SMT_BATCH ?= n
 CFG_SCMI_MSG_THREAD_ENTRY ?= n
 CFG_SCMI_MSG_VOLTAGE_DOMAIN ?= n
 $(eval $(call cfg-depends-all,CFG_SCMI_MSG_SMT_FASTCALL_ENTRY,CFG_SCMI_MSG_SMT))
 $(eval $(call cfg-depends-all,CFG_SCMI_MSG_SMT_INTERRUPT_ENTRY,CFG_SCMI_MSG_SMT))
 $(eval $(call cfg-depends-one,CFG_SCMI_MSG_SMT_THREAD_ENTRY,CFG_SCMI_MSG_SMT CFG_SCMI_MSG_SHM_MSG))
+$(eval $(call cfg-depends-all,CFG_SCMI_MSG_SMT_BATCH,CFG_SCMI_MSG_SMT))
 ifeq ($(CFG_SCMI_MSG_SMT),y)
 _CFG_SCMI_PTA_SMT_HEADER := y
 endif
@@ -878,15 +1142,29 @@ CFG_HWRNG_PTA ?= n
 ifeq ($(CFG_HWRNG_PTA),y)
 # Output rate of hw_get_random_bytes() in bytes per second, 0: not rate-limited
 CFG_HWRNG_RATE ?= 0
+# Report the output rate measured on large requests instead of CFG_HWRNG_RATE
+# once such a request has been served
+CFG_HWRNG_RATE_MEASURED ?= n
+# Maximum time in microseconds spent filling a PTA_CMD_GET_ENTROPY_BULK buffer
+CFG_HWRNG_BULK_BUDGET_US ?= 10000
 # Quality/entropy of hw_get_random_bytes() per 1024 bits of output data, in bits
 ifeq (,$(CFG_HWRNG_QUALITY))
 $(error CFG_HWRNG_QUALITY not defined)
 endif
+# Let the normal world register a buffer with PTA_CMD_SET_PUSH_SHM which is
+# refilled from the work queue once consumed, checked every
+# CFG_HWRNG_PUSH_MS milliseconds, with an asynchronous notification sent
+# when it's full again
+CFG_HWRNG_PUSH ?= n
+CFG_HWRNG_PUSH_MS ?= 10
+$(eval $(call cfg-depends-all,CFG_HWRNG_PUSH,CFG_CALLOUT CFG_CORE_WORKQUEUE))
 endif
 
 # CFG_PREALLOC_RPC_CACHE, when enabled, makes core to preallocate
 # shared memory for each secure thread. When disabled, RPC shared
 # memory is released once the secure thread has completed is execution.
+# Kernel private RPC payload buffers (as used by RPMB) are kept in the
+# same way while the cache is enabled by normal world.
 ifeq ($(CFG_WITH_PAGER),y)
 CFG_PREALLOC_RPC_CACHE ?= n
 endif
@@ -913,6 +1191,18 @@ $(eval $(call cfg-depends-all,CFG_DRIVERS_CLK_FIXED,CFG_DRIVERS_CLK_DT))
 # OP-TEE core to provide reset controls on subsystems of the devices.
 CFG_DRIVERS_RSTCTRL ?= n
 
+# When enabled, CFG_DRIVERS_DMA embeds a DMA framework in OP-TEE core for
+# memory to memory copies. dma_memcpy() falls back to the CPU when no DMA
+# channel is registered.
+CFG_DRIVERS_DMA ?= n
+
+# CFG_DMA_BUF_FULL_CACHE_THRESHOLD is the byte size from which a buffer
+# handed to a device with dma_buf_to_device() is cleaned with set/way
+# operations on the whole data cache instead of line by line. Only used
+# when CFG_TEE_CORE_NB_CORE is 1 since set/way operations don't reach the
+# caches of the other cores. 0 always does the maintenance by address.
+CFG_DMA_BUF_FULL_CACHE_THRESHOLD ?= 0
+
 # When enabled, CFG_DRIVERS_GPIO embeds a GPIO controller framework in
 # OP-TEE core to provide GPIO support for drivers.
 CFG_DRIVERS_GPIO ?= n
@@ -1017,6 +1307,14 @@ ifeq (y-y,$(CFG_WITH_PAGER)-$(CFG_MEMTAG))
 $(error CFG_WITH_PAGER and CFG_MEMTAG are not compatible)
 endif
 
+# With CFG_MEMTAG_BB_TAG_CACHE=y, freed bounce buffer allocations keep their
+# memory tags and an allocation of the same size at the same offset reuses
+# them instead of tagging the memory again. This saves tagging the bounce
+# buffers twice per syscall at the cost of not catching a use after free
+# of a bounce buffer until its region is tagged again.
+CFG_MEMTAG_BB_TAG_CACHE ?= n
+$(eval $(call cfg-depends-all,CFG_MEMTAG_BB_TAG_CACHE,CFG_MEMTAG))
+
 # Privileged Access Never (PAN, part of the ARMv8.1 Extensions) can be
 # used to restrict accesses to unprivileged memory from privileged mode.
 # For RISC-V architecture, CSR {m|s}status.SUM bit is used to implement PAN.
@@ -1041,6 +1339,50 @@ endif
 # Enable callout service
 CFG_CALLOUT ?= $(CFG_CORE_ASYNC_NOTIF)
 
+# CFG_CORE_ASYNC_INVOKE, when enabled, supports OPTEE_MSG_CMD_INVOKE_ASYNC
+# where normal world submits an invoke command without blocking the calling
+# thread. The command is executed in the next bottom half call and its
+# completion is signalled with an asynchronous notification, which lets one
+# normal world thread keep several commands in flight. At most
+# NOTIF_ASYNC_VALUE_MAX commands can be in flight at the same time.
+CFG_CORE_ASYNC_INVOKE ?= n
+$(eval $(call cfg-depends-all,CFG_CORE_ASYNC_INVOKE,CFG_CORE_ASYNC_NOTIF))
+
+# CFG_CORE_WORKQUEUE, when enabled, lets drivers defer work with
+# work_queue() to be done later in a yielding context. Queued work is
+# executed by the threads serving bottom half calls from normal world, at
+# most CFG_CORE_WORKQUEUE_WORKERS of them at once. Each CPU has its own
+# queue and idle workers steal work from the other CPUs' queues.
+CFG_CORE_WORKQUEUE ?= n
+CFG_CORE_WORKQUEUE_WORKERS ?= 2
+$(eval $(call cfg-depends-all,CFG_CORE_WORKQUEUE,CFG_CORE_ASYNC_NOTIF))
+ifeq ($(CFG_CORE_WORKQUEUE)-$(CFG_NS_VIRTUALIZATION),y-y)
+$(error CFG_CORE_WORKQUEUE is not supported with CFG_NS_VIRTUALIZATION)
+endif
+
+# CFG_ARM_SMCCC_TRNG_FEED, when enabled with CFG_WITH_SOFTWARE_PRNG=y, keeps
+# adding SMCCC TRNG output to the Fortuna pools every
+# CFG_ARM_SMCCC_TRNG_FEED_MS milliseconds instead of only seeding the PRNG
+# at boot. The SMCCC TRNG is then used as entropy input only.
+CFG_ARM_SMCCC_TRNG_FEED ?= n
+CFG_ARM_SMCCC_TRNG_FEED_MS ?= 100
+$(eval $(call cfg-depends-all,CFG_ARM_SMCCC_TRNG_FEED,CFG_ARM_SMCCC_TRNG \
+	 CFG_CALLOUT))
+
+# CFG_CRYPTO_RNG_BULK_SEED, with CFG_WITH_SOFTWARE_PRNG=y, lets the driver
+# of a hardware TRNG register it with crypto_rng_set_bulk_source().
+# CFG_CRYPTO_RNG_BULK_SEED_BYTES bytes are then read at once and spread over
+# all the Fortuna pools, at boot and with CFG_CRYPTO_RNG_BULK_SEED_REFRESH=y
+# every CFG_CRYPTO_RNG_BULK_SEED_MS milliseconds from the work queue. With
+# at least 64 bytes per pool the first batch is enough to reseed.
+CFG_CRYPTO_RNG_BULK_SEED ?= n
+CFG_CRYPTO_RNG_BULK_SEED_BYTES ?= 2048
+CFG_CRYPTO_RNG_BULK_SEED_REFRESH ?= n
+CFG_CRYPTO_RNG_BULK_SEED_MS ?= 60000
+$(eval $(call cfg-depends-all,CFG_CRYPTO_RNG_BULK_SEED,CFG_WITH_SOFTWARE_PRNG))
+$(eval $(call cfg-depends-all,CFG_CRYPTO_RNG_BULK_SEED_REFRESH, \
+	 CFG_CRYPTO_RNG_BULK_SEED CFG_CALLOUT CFG_CORE_WORKQUEUE))
+
 # Enable notification based test watchdog
 CFG_NOTIF_TEST_WD ?= $(call cfg-all-enabled,CFG_ENABLE_EMBEDDED_TESTS \
 		       CFG_CALLOUT CFG_CORE_ASYNC_NOTIF)
@@ -1103,6 +1445,53 @@ CFG_WDT_SM_HANDLER_ID ?= 0x82003D06
 # the platform code
 CFG_CORE_HAS_GENERIC_TIMER ?= y
 
+# CFG_LOCK_CONTENTION_STATS, when enabled, accounts the number of contended
+# acquisitions and the generic timer ticks spent waiting for each core mutex
+# and spinlock. At most CFG_LOCK_CONTENTION_STATS_ENTRIES distinct locks are
+# tracked. The statistics are reported by the stats PTA.
+CFG_LOCK_CONTENTION_STATS ?= n
+CFG_LOCK_CONTENTION_STATS_ENTRIES ?= 32
+$(eval $(call cfg-depends-all,CFG_LOCK_CONTENTION_STATS,CFG_CORE_HAS_GENERIC_TIMER))
+
+# CFG_CORE_INITCALL_STATS, when enabled, measures the duration of each
+# init-call and prints it. The first CFG_CORE_INITCALL_STATS_ENTRIES
+# durations are also reported by the stats PTA.
+CFG_CORE_INITCALL_STATS ?= n
+CFG_CORE_INITCALL_STATS_ENTRIES ?= 128
+$(eval $(call cfg-depends-all,CFG_CORE_INITCALL_STATS,CFG_CORE_HAS_GENERIC_TIMER))
+
+# CFG_CORE_DEFERRED_INITCALLS, when enabled, postpones the driver
+# initializations registered with driver_init_deferred() from boot to the
+# first yielding call. When disabled they're done at boot with the
+# driver_init_late() ones.
+CFG_CORE_DEFERRED_INITCALLS ?= n
+
+# CFG_CORE_MUTEX_SPIN_US, when > 0, is the time in microseconds a thread
+# polls a locked mutex before sleeping in normal world. Spinning threads
+# get the mutex directly when it's unlocked, saving the RPCs needed to
+# sleep and wake them when mutexes are only held for short periods.
+CFG_CORE_MUTEX_SPIN_US ?= 0
+ifneq ($(CFG_CORE_MUTEX_SPIN_US),0)
+$(eval $(call cfg-depends-all,CFG_CORE_MUTEX_SPIN_US,CFG_CORE_HAS_GENERIC_TIMER))
+endif
+
+# CFG_CORE_THREAD_TIME_STATS, when enabled, accounts for each thread the
+# time spent executing, suspended in normal world and waiting on mutexes or
+# condition variables, and for each CPU the time spent executing threads.
+# The statistics are reported by the stats PTA.
+CFG_CORE_THREAD_TIME_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_CORE_THREAD_TIME_STATS,CFG_CORE_HAS_GENERIC_TIMER))
+
+# CFG_CORE_YIELD_INTERVAL_US, when not 0, lets long running operations
+# such as prime generation, PBKDF2 or secure storage hash tree verification
+# return to normal world through a foreign interrupt RPC each time they
+# have run that many microseconds. Normal world may then schedule other
+# tasks on the core before resuming the operation. Not used with FF-A.
+CFG_CORE_YIELD_INTERVAL_US ?= 0
+ifneq ($(CFG_CORE_YIELD_INTERVAL_US),0)
+$(eval $(call cfg-depends-all,CFG_CORE_YIELD_INTERVAL_US,CFG_CORE_HAS_GENERIC_TIMER))
+endif
+
 # Enable RTC API
 CFG_DRIVERS_RTC ?= n
 
@@ -1139,6 +1528,21 @@ endif
 endif
 CFG_PGT_CACHE_ENTRIES ?= ($(CFG_NUM_THREADS) * 2)
 
+# CFG_PGT_CACHE_REUSE_RO, when enabled, lets a context copy a translation
+# table left in the page table cache by another context if the table only
+# holds identical read-only mappings, for instance the code and read-only
+# data of another instance of the same TA. This saves populating the
+# table from scratch when opening a session. Tables are only found
+# identical if the mappings are at the same virtual addresses so this is
+# most effective with CFG_TA_ASLR=n.
+CFG_PGT_CACHE_REUSE_RO ?= n
+ifeq (y-y,$(CFG_PGT_CACHE_REUSE_RO)-$(CFG_CORE_PREALLOC_EL0_TBLS))
+$(error "CFG_PGT_CACHE_REUSE_RO can't support CFG_CORE_PREALLOC_EL0_TBLS")
+endif
+ifeq (y-y,$(CFG_PGT_CACHE_REUSE_RO)-$(CFG_PAGED_USER_TA))
+$(error "CFG_PGT_CACHE_REUSE_RO can't support CFG_PAGED_USER_TA")
+endif
+
 # User TA runtime context dump.
 # When this option is enabled, OP-TEE provides a debug method for
 # developer to dump user TA's runtime context, including TA's heap stats.
@@ -1146,6 +1550,24 @@ CFG_PGT_CACHE_ENTRIES ?= ($(CFG_NUM_THREADS) * 2)
 # STATS_CMD_TA_STATS to get the context of loaded TAs.
 CFG_TA_STATS ?= n
 
+# When enabled, the CPU time in user mode and in syscalls, the syscalls by
+# number, the page faults and the RPCs of each user TA are accounted. They
+# can be polled incrementally through STATS_CMD_TA_RESOURCE_STATS of the
+# stats PTA. CPU time excludes the time threads are suspended only with
+# CFG_CORE_THREAD_TIME_STATS=y.
+CFG_TA_RESOURCE_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_TA_RESOURCE_STATS,CFG_WITH_USER_TA CFG_CORE_HAS_GENERIC_TIMER))
+
+# When enabled, random numbers generated for each user TA are accounted
+# and a TA which has consumed more than CFG_TA_RNG_BUDGET bytes within
+# CFG_TA_RNG_BUDGET_WINDOW_MS milliseconds is served in small chunks with
+# a short sleep in between so the core and other TAs are not starved. A
+# budget of 0 disables throttling but keeps the accounting. The counters
+# are available through STATS_CMD_RNG_TA_STATS of the stats PTA.
+CFG_TA_RNG_QOS ?= n
+CFG_TA_RNG_BUDGET ?= 65536
+CFG_TA_RNG_BUDGET_WINDOW_MS ?= 1000
+
 # Enables best effort mitigations against fault injected when the hardware
 # is tampered with. Details in lib/libutils/ext/include/fault_mitigation.h
 CFG_FAULT_MITIGATION ?= y
@@ -1264,6 +1686,12 @@ CFG_CORE_UNSAFE_MODEXP ?= n
 # exponentiation algorithm.
 CFG_TA_MEBDTLS_UNSAFE_MODEXP ?= n
 
+ifneq ($(CFG_NUM_THREADS_STATIC),$(CFG_NUM_THREADS))
+ifeq (y,$(call cfg-one-enabled,CFG_WITH_PAGER CFG_NS_VIRTUALIZATION))
+$(error CFG_NUM_THREADS_STATIC is not supported with CFG_WITH_PAGER or CFG_NS_VIRTUALIZATION)
+endif
+endif
+
 # CFG_BOOT_MEM, when enabled, adds stack like memory allocation during boot.
 ifeq ($(ARCH),arm)
 $(call force,CFG_BOOT_MEM,y)
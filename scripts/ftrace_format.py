@@ -7,13 +7,23 @@
 # format:
 #
 #  <ASCII text> <zero or more nul bytes> FTRACE\x00\x01 <binary data>...
+#  <ASCII text> <zero or more nul bytes> FTRACE\x00\x02 <freq> <binary data>...
 #
 # <binary data> is an array of 64-bit integers.
 # - When the topmost byte is 0, the entry indicates a function return and the
-# remaining bytes are a duration in nanoseconds.
-# - A non-zero value is a stack depth, indicating a function entry, and the
+# remaining bytes are a duration, in nanoseconds for version 1 and in counter
+# ticks for version 2.
+# - With version 2, a topmost byte of 0xff is the counter value when the
+# function entry just before was recorded, time spent suspended excluded.
+# - Any other value is a stack depth, indicating a function entry, and the
 # remaining bytes are the function's address.
+#
+# <freq> is a 64-bit integer, the frequency of the counter in Hz.
+#
+# With --chrome, version 2 files are instead converted to the JSON trace
+# event format which can be loaded in Perfetto or chrome://tracing.
 
+import json
 import sys
 
 
@@ -22,8 +32,9 @@ curr_depth = 0
 
 
 def usage():
-    print(f"Usage: {sys.argv[0]} ftrace.out")
+    print(f"Usage: {sys.argv[0]} [--chrome] ftrace.out")
     print("Converts a ftrace file to text. Output is written to stdout.")
+    print("--chrome: output JSON trace events instead")
     sys.exit(0)
 
 
@@ -60,22 +71,79 @@ def display(depth, val):
                       " " * curr_depth + "}")
 
 
+def elems(s):
+    for i in range(0, len(s) - 7, 8):
+        elem = int.from_bytes(s[i:i + 8], byteorder="little", signed=False)
+        yield elem >> 56, elem & 0xFFFFFFFFFFFFFF
+
+
+def to_text(s, ticks_to_ns):
+    for depth, val in elems(s):
+        if depth == 0xff:
+            continue
+        if depth == 0:
+            val = ticks_to_ns(val)
+        display(depth, val)
+
+
+def to_chrome(header, s, freq):
+    # Function entries waiting for their return, as [address, start in us]
+    stack = []
+    events = []
+    for depth, val in elems(s):
+        if depth == 0xff:
+            if stack:
+                stack[-1][1] = val * 1000000 / freq
+        elif depth != 0:
+            # A buffer which has wrapped may start in the middle of calls
+            del stack[depth - 1:]
+            stack.append([val, None])
+        elif stack:
+            addr, ts = stack.pop()
+            if ts is not None:
+                events.append({"name": f"0x{addr:x}", "ph": "X", "pid": 0,
+                               "tid": 0, "ts": ts,
+                               "dur": val * 1000000 / freq})
+    json.dump({"traceEvents": events, "otherData": {"header": header}},
+              sys.stdout)
+
+
 def main():
-    if len(sys.argv) < 2:
+    args = sys.argv[1:]
+    chrome = "--chrome" in args
+    if chrome:
+        args.remove("--chrome")
+    if len(args) < 1:
         usage()
-    with open(sys.argv[1], 'rb') as f:
+    with open(args[0], 'rb') as f:
         s = f.read()
-    magic = s.find(b'FTRACE\x00\x01')
-    if magic == -1:
+    magic = s.find(b'FTRACE\x00')
+    if magic == -1 or s[magic + 7] not in (1, 2):
         print("Magic not found", file=sys.stderr)
         sys.exit(1)
-    print(s[:magic].rstrip(b'\x00').decode())
+    version = s[magic + 7]
+    header = s[:magic].rstrip(b'\x00').decode()
     s = s[magic + 8:]
-    for i in range(0, len(s), 8):
-        elem = int.from_bytes(s[i:i + 8], byteorder="little", signed=False)
-        depth = elem >> 56
-        val = elem & 0xFFFFFFFFFFFFFF
-        display(depth, val)
+    if version == 1:
+        if chrome:
+            print("Version 1 files have no timestamps", file=sys.stderr)
+            sys.exit(1)
+        freq = None
+    else:
+        freq = int.from_bytes(s[:8], byteorder="little", signed=False)
+        s = s[8:]
+        if not freq:
+            print("Invalid counter frequency", file=sys.stderr)
+            sys.exit(1)
+
+    if chrome:
+        to_chrome(header, s, freq)
+    else:
+        print(header)
+        if freq:
+            to_text(s, lambda t: t * 1000000000 // freq)
+        else:
+            to_text(s, lambda t: t)
 
 
 if __name__ == "__main__":
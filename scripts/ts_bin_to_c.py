@@ -166,8 +166,10 @@ def main():
         f.write('. image = {')
         f.write('\t.flags = 0x{:04x},\n'.format(sp_get_flags(ts)))
     else:
-        f.write('SCATTERED_ARRAY_DEFINE_PG_ITEM(early_tas, struct \
-                embedded_ts) = {\n')
+        # Sorted on the UUID so that the TA can be found with a binary
+        # search, see find_early_ta()
+        f.write('SCATTERED_ARRAY_DEFINE_PG_ITEM_ORDERED(early_tas, 0' +
+                ts_uuid.hex + ', struct embedded_ts) = {\n')
         f.write('\t.flags = 0x{:04x},\n'.format(ta_get_flags(ts)))
     f.write('\t.uuid = {\n')
     f.write('\t\t.timeLow = 0x{:08x},\n'.format(ts_uuid.time_low))
@@ -6,6 +6,7 @@
 #include <tee_internal_api_extensions.h>
 
 #include <string.h>
+#include <util.h>
 
 #define DEFAULT_LOCK_STATE	0
 
@@ -69,6 +70,80 @@ static TEE_Result get_named_object_name(char *name_orig,
 	return TEE_SUCCESS;
 }
 
+/*
+ * The content of the rb_state object is cached for the lifetime of the TA
+ * instance, only the first request reads it from secure storage. Writes go
+ * through to the object at once, a rollback index must be stored before
+ * the bootloader relies on it.
+ */
+#define RB_STATE_SIZE	(sizeof(uint32_t) /* lock_state */ + \
+			 TA_AVB_MAX_ROLLBACK_LOCATIONS * sizeof(uint64_t))
+
+static struct {
+	TEE_ObjectHandle h;
+	size_t len;
+	uint8_t data[RB_STATE_SIZE];
+} rb_cache = { .h = TEE_HANDLE_NULL };
+
+static void drop_rb_cache(void)
+{
+	TEE_CloseObject(rb_cache.h);
+	rb_cache.h = TEE_HANDLE_NULL;
+}
+
+static TEE_Result load_rb_cache(uint32_t default_lock_state)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (rb_cache.h != TEE_HANDLE_NULL)
+		return TEE_SUCCESS;
+
+	res = open_rb_state(default_lock_state, &rb_cache.h);
+	if (res)
+		return res;
+
+	memset(rb_cache.data, 0, sizeof(rb_cache.data));
+	res = TEE_ReadObjectData(rb_cache.h, rb_cache.data,
+				 sizeof(rb_cache.data), &rb_cache.len);
+	if (res)
+		drop_rb_cache();
+
+	return res;
+}
+
+static TEE_Result write_rb_cache(size_t offset, const void *data, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = TEE_SeekObjectData(rb_cache.h, offset, TEE_DATA_SEEK_SET);
+	if (!res)
+		res = TEE_WriteObjectData(rb_cache.h, data, len);
+	if (res) {
+		/* The object may be partly updated, read it again next time */
+		drop_rb_cache();
+		return res;
+	}
+
+	/* A gap left by writing beyond the end reads as zeroes */
+	if (offset > rb_cache.len)
+		memset(rb_cache.data + rb_cache.len, 0, offset - rb_cache.len);
+	memcpy(rb_cache.data + offset, data, len);
+	rb_cache.len = MAX(rb_cache.len, offset + len);
+
+	return TEE_SUCCESS;
+}
+
+/* Not yet written slots are reported as 0 */
+static uint64_t get_cached_rb_idx(size_t slot_offset)
+{
+	uint64_t idx = 0;
+
+	if (rb_cache.len >= slot_offset + sizeof(idx))
+		memcpy(&idx, rb_cache.data + slot_offset, sizeof(idx));
+
+	return idx;
+}
+
 static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 {
 	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
@@ -77,9 +152,7 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_NONE);
 	size_t slot_offset;
 	uint64_t idx;
-	size_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -88,40 +161,26 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (res)
 		return res;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_cache(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
-
-	res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
-	if (res)
-		goto out;
-	if (count != sizeof(idx)) {
-		idx = 0; /* Not yet written slots are reported as 0 */
-
-		if (count) {
-			/*
-			 * Somehow the file didn't even hold a complete
-			 * slot index entry.  Write it as 0.
-			 */
-			res = TEE_SeekObjectData(h, slot_offset,
-						 TEE_DATA_SEEK_SET);
-			if (res)
-				goto out;
-			res = TEE_WriteObjectData(h, &idx, sizeof(idx));
-			if (res)
-				goto out;
-		}
+	idx = get_cached_rb_idx(slot_offset);
+	if (rb_cache.len > slot_offset &&
+	    rb_cache.len < slot_offset + sizeof(idx)) {
+		/*
+		 * Somehow the file didn't even hold a complete
+		 * slot index entry.  Write it as 0.
+		 */
+		res = write_rb_cache(slot_offset, &idx, sizeof(idx));
+		if (res)
+			return res;
 	}
 
 	params[1].value.a = idx >> 32;
 	params[1].value.b = idx;
-out:
-	TEE_CloseObject(h);
-	return res;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
@@ -133,9 +192,7 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	size_t slot_offset;
 	uint64_t widx;
 	uint64_t idx;
-	size_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -145,33 +202,19 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 		return res;
 	widx = ((uint64_t)params[1].value.a << 32) | params[1].value.b;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_cache(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
+	idx = get_cached_rb_idx(slot_offset);
+	if (widx < idx)
+		return TEE_ERROR_SECURITY;
 
-	res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
-	if (res)
-		goto out;
-	if (count != sizeof(idx))
-		idx = 0; /* Not yet written slots are reported as 0 */
-
-	if (widx < idx) {
-		res = TEE_ERROR_SECURITY;
-		goto out;
-	}
-
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
+	/* Nothing to store if the slot already holds this index */
+	if (widx == idx && rb_cache.len >= slot_offset + sizeof(idx))
+		return TEE_SUCCESS;
 
-	res = TEE_WriteObjectData(h, &widx, sizeof(widx));
-out:
-	TEE_CloseObject(h);
-	return res;
+	return write_rb_cache(slot_offset, &widx, sizeof(widx));
 }
 
 static TEE_Result read_lock_state(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
@@ -181,33 +224,27 @@ static TEE_Result read_lock_state(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
 	uint32_t lock_state;
-	size_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_cache(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res =  TEE_ReadObjectData(h, &lock_state, sizeof(lock_state), &count);
-	if (res)
-		goto out;
-	if (count != sizeof(lock_state)) {
+	if (rb_cache.len < sizeof(lock_state)) {
 		/*
 		 * Client need write the lock state to recover, this can
 		 * normally not happen.
 		 */
-		res = TEE_ERROR_CORRUPT_OBJECT;
-		goto out;
+		return TEE_ERROR_CORRUPT_OBJECT;
 	}
 
+	memcpy(&lock_state, rb_cache.data, sizeof(lock_state));
 	params[0].value.a = lock_state;
-out:
-	TEE_CloseObject(h);
-	return res;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_lock_state(uint32_t pt,
@@ -219,33 +256,22 @@ static TEE_Result write_lock_state(uint32_t pt,
 						TEE_PARAM_TYPE_NONE);
 	uint32_t wlock_state;
 	uint32_t lock_state;
-	size_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	wlock_state = params[0].value.a;
 
-	res = open_rb_state(wlock_state, &h);
+	res = load_rb_cache(wlock_state);
 	if (res)
 		return res;
 
-	res =  TEE_ReadObjectData(h, &lock_state, sizeof(lock_state), &count);
-	if (res)
-		goto out;
-	if (count == sizeof(lock_state) && lock_state == wlock_state)
-		goto out;
-
-	res = TEE_SeekObjectData(h, 0, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
+	memcpy(&lock_state, rb_cache.data, sizeof(lock_state));
+	if (rb_cache.len >= sizeof(lock_state) && lock_state == wlock_state)
+		return TEE_SUCCESS;
 
-	res = TEE_WriteObjectData(h, &wlock_state, sizeof(wlock_state));
-out:
-	TEE_CloseObject(h);
-	return res;
+	return write_rb_cache(0, &wlock_state, sizeof(wlock_state));
 }
 
 static TEE_Result write_persist_value(uint32_t pt,
@@ -364,6 +390,7 @@ TEE_Result TA_CreateEntryPoint(void)
 
 void TA_DestroyEntryPoint(void)
 {
+	drop_rb_cache();
 }
 
 TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
@@ -713,6 +713,23 @@ enum pkcs11_ta_cmd {
 	 * This command relates to the PKCS#11 API function C_UnwrapKey().
 	 */
 	PKCS11_CMD_UNWRAP_KEY = 52,
+
+	/*
+	 * PKCS11_CMD_DIGEST_UPDATE_FINAL - Update digest with data and
+	 *                                  finalize it
+	 *
+	 * [in]  memref[0] = 32bit session handle
+	 * [out] memref[0] = 32bit return code, enum pkcs11_rc
+	 * [in]  memref[1] = input data to be processed
+	 * [out] memref[2] = output digest
+	 *
+	 * This command is the same as a PKCS11_CMD_DIGEST_UPDATE followed by
+	 * a PKCS11_CMD_DIGEST_FINAL, in a single invocation. It allows a
+	 * client to batch the data of its last C_DigestUpdate() calls with
+	 * C_DigestFinal(). When PKCS11_CKR_BUFFER_TOO_SMALL is returned, the
+	 * input data is not consumed and the same command is to be retried.
+	 */
+	PKCS11_CMD_DIGEST_UPDATE_FINAL = 53,
 };
 
 /*
@@ -16,7 +16,174 @@
 
 #include "attributes.h"
 #include "pkcs11_helpers.h"
-#include "serializer.h"
+
+/*
+ * Lookup index of serialized attributes bound with attrs_index_bind().
+ * Entries are sorted by attribute ID, then by position in the serialized
+ * attributes. @capacity is the allocated size of the serialized attributes
+ * so that appends don't have to reallocate each time.
+ */
+struct attrs_index_entry {
+	uint32_t id;
+	uint32_t offset;
+};
+
+struct attrs_index {
+	struct obj_attrs *head;
+	size_t capacity;
+	size_t count;
+	size_t max_count;
+	struct attrs_index_entry *entries;
+};
+
+#define ATTRS_INDEX_SLOTS	2
+
+/* The TA is single threaded, no locking needed */
+static struct attrs_index attrs_indexes[ATTRS_INDEX_SLOTS];
+
+/* Return the index bound to @head or a free slot if @head is NULL */
+static struct attrs_index *attrs_index_find(struct obj_attrs *head)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(attrs_indexes); n++)
+		if (attrs_indexes[n].head == head)
+			return attrs_indexes + n;
+
+	return NULL;
+}
+
+static void attrs_index_release(struct attrs_index *idx)
+{
+	TEE_Free(idx->entries);
+	*idx = (struct attrs_index){ };
+}
+
+/* Return the position of the first entry with an ID greater than @id */
+static size_t attrs_index_upper_bound(struct attrs_index *idx, uint32_t id)
+{
+	size_t lo = 0;
+	size_t hi = idx->count;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (idx->entries[mid].id <= id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Return the position of the first entry with ID @id or greater */
+static size_t attrs_index_lower_bound(struct attrs_index *idx, uint32_t id)
+{
+	size_t lo = 0;
+	size_t hi = idx->count;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (idx->entries[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static bool attrs_index_add(struct attrs_index *idx, uint32_t id,
+			    uint32_t offset)
+{
+	size_t pos = 0;
+
+	if (idx->count == idx->max_count) {
+		size_t max_count = MAX(idx->max_count * 2, 16U);
+		void *entries = TEE_Realloc(idx->entries,
+					    max_count * sizeof(*idx->entries));
+
+		if (!entries)
+			return false;
+		idx->entries = entries;
+		idx->max_count = max_count;
+	}
+
+	/* Equal IDs are kept in the order of the serialized attributes */
+	pos = attrs_index_upper_bound(idx, id);
+	TEE_MemMove(idx->entries + pos + 1, idx->entries + pos,
+		    (idx->count - pos) * sizeof(*idx->entries));
+	idx->entries[pos].id = id;
+	idx->entries[pos].offset = offset;
+	idx->count++;
+
+	return true;
+}
+
+/* Update the index of @head if any for the removal of @len bytes at @offset */
+static void attrs_index_remove(struct obj_attrs *head, uint32_t offset,
+			       uint32_t len)
+{
+	struct attrs_index *idx = attrs_index_find(head);
+	size_t n = 0;
+	size_t m = 0;
+
+	if (!idx)
+		return;
+
+	for (n = 0; n < idx->count; n++) {
+		if (idx->entries[n].offset == offset)
+			continue;
+		idx->entries[m] = idx->entries[n];
+		if (idx->entries[m].offset > offset)
+			idx->entries[m].offset -= len;
+		m++;
+	}
+	idx->count = m;
+}
+
+void attrs_index_bind(struct obj_attrs *head)
+{
+	struct attrs_index *idx = attrs_index_find(NULL);
+	size_t next_off = 0;
+	char *cur = NULL;
+	char *end = NULL;
+
+	/* Lookups fall back to scanning the attributes */
+	if (!head || !idx || attrs_index_find(head))
+		return;
+
+	cur = (char *)head->attrs;
+	end = cur + head->attrs_size;
+	idx->head = head;
+	idx->capacity = sizeof(*head) + head->attrs_size;
+	for (; cur < end; cur += next_off) {
+		struct pkcs11_attribute_head pkcs11_ref = { };
+
+		TEE_MemMove(&pkcs11_ref, cur, sizeof(pkcs11_ref));
+		next_off = sizeof(pkcs11_ref) + pkcs11_ref.size;
+
+		if (!attrs_index_add(idx, pkcs11_ref.id,
+				     cur - (char *)head->attrs)) {
+			attrs_index_release(idx);
+			return;
+		}
+	}
+}
+
+void attrs_index_unbind(struct obj_attrs *head)
+{
+	struct attrs_index *idx = NULL;
+
+	if (!head)
+		return;
+
+	idx = attrs_index_find(head);
+	if (idx)
+		attrs_index_release(idx);
+}
 
 enum pkcs11_rc init_attributes_head(struct obj_attrs **head)
 {
@@ -30,31 +197,54 @@ enum pkcs11_rc init_attributes_head(struct obj_attrs **head)
 enum pkcs11_rc add_attribute(struct obj_attrs **head, uint32_t attribute,
 			     void *data, size_t size)
 {
+	struct attrs_index *idx = NULL;
 	size_t buf_len = sizeof(struct obj_attrs) + (*head)->attrs_size;
-	char **bstart = (void *)head;
-	enum pkcs11_rc rc = PKCS11_CKR_OK;
-	uint32_t data32 = 0;
+	struct pkcs11_attribute_head pkcs11_ref = {
+		.id = attribute,
+		.size = size,
+	};
+	size_t alloc_len = 0;
+	size_t new_len = 0;
+	char *buf = NULL;
+
+	if (*head)
+		idx = attrs_index_find(*head);
+
+	if (pkcs11_ref.size != size ||
+	    ADD_OVERFLOW(buf_len, sizeof(pkcs11_ref), &new_len) ||
+	    ADD_OVERFLOW(new_len, size, &new_len) ||
+	    new_len > UINT32_MAX)
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	/* A single reallocation, ahead of time if the attributes are bound */
+	if (!idx || new_len > idx->capacity) {
+		alloc_len = new_len;
+		if (idx)
+			alloc_len = MAX(new_len, idx->capacity * 2);
+
+		buf = TEE_Realloc(*head, alloc_len);
+		if (!buf)
+			return PKCS11_CKR_DEVICE_MEMORY;
+
+		/* Alloced buffer is always well aligned */
+		*head = (void *)buf;
+		if (idx) {
+			idx->head = *head;
+			idx->capacity = alloc_len;
+		}
+	}
 
-	data32 = attribute;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
+	buf = (char *)*head;
+	TEE_MemMove(buf + buf_len, &pkcs11_ref, sizeof(pkcs11_ref));
+	TEE_MemMove(buf + buf_len + sizeof(pkcs11_ref), data, size);
 
-	data32 = size;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
+	if (idx && !attrs_index_add(idx, attribute, (*head)->attrs_size))
+		attrs_index_release(idx);
 
-	rc = serialize(bstart, &buf_len, data, size);
-	if (rc)
-		return rc;
-
-	/* Alloced buffer is always well aligned */
-	head = (void *)bstart;
-	(*head)->attrs_size += 2 * sizeof(uint32_t) + size;
+	(*head)->attrs_size += sizeof(pkcs11_ref) + size;
 	(*head)->attrs_count++;
 
-	return rc;
+	return PKCS11_CKR_OK;
 }
 
 static enum pkcs11_rc _remove_attribute(struct obj_attrs **head,
@@ -80,6 +270,8 @@ static enum pkcs11_rc _remove_attribute(struct obj_attrs **head,
 		if (empty && pkcs11_ref.size)
 			return PKCS11_CKR_FUNCTION_FAILED;
 
+		attrs_index_remove(h, cur - (char *)h->attrs, next_off);
+
 		TEE_MemMove(cur, cur + next_off, end - (cur + next_off));
 
 		h->attrs_count--;
@@ -100,9 +292,44 @@ enum pkcs11_rc remove_empty_attribute(struct obj_attrs **head,
 	return _remove_attribute(head, attribute, true /* empty */);
 }
 
+static void get_indexed_attribute_ptrs(struct attrs_index *idx,
+				       uint32_t attribute, void **attr,
+				       uint32_t *attr_size, size_t *count)
+{
+	size_t pos = attrs_index_lower_bound(idx, attribute);
+	size_t max_found = *count;
+	size_t found = 0;
+
+	for (; pos < idx->count && idx->entries[pos].id == attribute; pos++) {
+		char *cur = (char *)idx->head->attrs + idx->entries[pos].offset;
+		struct pkcs11_attribute_head pkcs11_ref = { };
+
+		found++;
+		if (!max_found)
+			continue;	/* only count matching attributes */
+
+		TEE_MemMove(&pkcs11_ref, cur, sizeof(pkcs11_ref));
+		if (attr) {
+			if (pkcs11_ref.size)
+				*attr++ = cur + sizeof(pkcs11_ref);
+			else
+				*attr++ = NULL;
+		}
+
+		if (attr_size)
+			*attr_size++ = pkcs11_ref.size;
+
+		if (found == max_found)
+			break;
+	}
+
+	*count = found;
+}
+
 void get_attribute_ptrs(struct obj_attrs *head, uint32_t attribute,
 			void **attr, uint32_t *attr_size, size_t *count)
 {
+	struct attrs_index *idx = NULL;
 	char *cur = (char *)head + sizeof(struct obj_attrs);
 	char *end = cur + head->attrs_size;
 	size_t next_off = 0;
@@ -111,6 +338,14 @@ void get_attribute_ptrs(struct obj_attrs *head, uint32_t attribute,
 	void **attr_ptr = attr;
 	uint32_t *attr_size_ptr = attr_size;
 
+	if (head)
+		idx = attrs_index_find(head);
+	if (idx) {
+		get_indexed_attribute_ptrs(idx, attribute, attr, attr_size,
+					   count);
+		return;
+	}
+
 	for (; cur < end; cur += next_off) {
 		/* Structure aligned copy of the pkcs11_ref in the object */
 		struct pkcs11_attribute_head pkcs11_ref = { };
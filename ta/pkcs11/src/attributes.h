@@ -61,6 +61,27 @@ struct obj_attrs {
 	uint8_t attrs[];
 };
 
+/*
+ * attrs_index_bind() - Index serialized attributes for faster lookups
+ * @head:	Serialized attributes
+ *
+ * Until attrs_index_unbind() is called, get_attribute_ptrs() and the
+ * functions based on it find attributes of @head with a binary search
+ * instead of a scan, and add_attribute() reserves room ahead so that
+ * appending attributes doesn't reallocate each time.
+ *
+ * @head must not be freed or modified other than through the functions
+ * below while bound. A failure to bind, for instance when too many
+ * attributes are already bound, only means that lookups scan @head.
+ */
+void attrs_index_bind(struct obj_attrs *head);
+
+/*
+ * attrs_index_unbind() - Release the index of @head if any
+ * @head:	Serialized attributes, can be NULL
+ */
+void attrs_index_unbind(struct obj_attrs *head);
+
 /*
  * init_attributes_head() - Allocate a reference for serialized attributes
  * @head:	*@head holds the retrieved pointer
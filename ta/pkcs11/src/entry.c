@@ -346,6 +346,11 @@ TEE_Result TA_InvokeCommandEntryPoint(void *tee_session, uint32_t cmd,
 					   PKCS11_FUNCTION_DIGEST,
 					   PKCS11_FUNC_STEP_FINAL);
 		break;
+	case PKCS11_CMD_DIGEST_UPDATE_FINAL:
+		rc = entry_processing_step(client, ptypes, params,
+					   PKCS11_FUNCTION_DIGEST,
+					   PKCS11_FUNC_STEP_UPDATE_FINAL);
+		break;
 	case PKCS11_CMD_GENERATE_KEY_PAIR:
 		rc = entry_generate_key_pair(client, ptypes, params);
 		break;
@@ -5,6 +5,7 @@
 
 #include <stdlib.h>
 #include <tee_internal_api.h>
+#include <util.h>
 
 #include "handle.h"
 
@@ -16,6 +17,15 @@
  */
 #define HANDLE_DB_INITIAL_MAX_PTRS	4
 
+/*
+ * A handle has the slot index in the low bits and the generation of the
+ * slot in the bits above. Index 0 is reserved so a handle is never 0.
+ */
+#define HANDLE_IDX_BITS			20
+#define HANDLE_IDX_MASK			(BIT32(HANDLE_IDX_BITS) - 1)
+#define HANDLE_GEN_MASK			(BIT32(32 - HANDLE_IDX_BITS) - 1)
+#define HANDLE_DB_MAX_PTRS		BIT32(HANDLE_IDX_BITS)
+
 /* Specific pointer ~0 denotes a still allocated but invalid handle */
 #define INVALID_HANDLE_PTR	((void *)~0)
 
@@ -27,81 +37,129 @@ void handle_db_init(struct handle_db *db)
 void handle_db_destroy(struct handle_db *db)
 {
 	if (db) {
-		TEE_Free(db->ptrs);
-		db->ptrs = NULL;
+		TEE_Free(db->slots);
+		db->slots = NULL;
 		db->max_ptrs = 0;
+		db->first_free = 0;
 	}
 }
 
-uint32_t handle_get(struct handle_db *db, void *ptr)
+static uint32_t idx_to_handle(struct handle_db *db, uint32_t idx)
+{
+	return (db->slots[idx].gen << HANDLE_IDX_BITS) | idx;
+}
+
+static bool grow_db(struct handle_db *db)
 {
+	uint32_t new_max_ptrs = 0;
 	uint32_t n = 0;
 	void *p = NULL;
-	uint32_t new_max_ptrs = 0;
-
-	if (!db || !ptr || ptr == INVALID_HANDLE_PTR)
-		return 0;
 
-	/* Try to find an empty location (index 0 is reserved as invalid) */
-	for (n = 1; n < db->max_ptrs; n++) {
-		if (!db->ptrs[n]) {
-			db->ptrs[n] = ptr;
-			return n;
-		}
-	}
-
-	/* No location available, grow the ptrs array */
 	if (db->max_ptrs)
 		new_max_ptrs = db->max_ptrs * 2;
 	else
 		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+	new_max_ptrs = MIN(new_max_ptrs, HANDLE_DB_MAX_PTRS);
+	if (new_max_ptrs == db->max_ptrs)
+		return false;
 
-	p = TEE_Realloc(db->ptrs, new_max_ptrs * sizeof(void *));
+	p = TEE_Realloc(db->slots, new_max_ptrs * sizeof(*db->slots));
 	if (!p)
-		return 0;
-	db->ptrs = p;
-	TEE_MemFill(db->ptrs + db->max_ptrs, 0,
-		    (new_max_ptrs - db->max_ptrs) * sizeof(void *));
+		return false;
+	db->slots = p;
+	TEE_MemFill(db->slots + db->max_ptrs, 0,
+		    (new_max_ptrs - db->max_ptrs) * sizeof(*db->slots));
+
+	/*
+	 * Link the new slots in order, the free list is empty. Index 0 is
+	 * reserved as invalid.
+	 */
+	n = MAX(db->max_ptrs, 1U);
+	db->first_free = n;
+	for (; n < new_max_ptrs - 1; n++)
+		db->slots[n].next_free = n + 1;
 	db->max_ptrs = new_max_ptrs;
 
-	/* Since n stopped at db->max_ptrs there is an empty location there */
-	db->ptrs[n] = ptr;
-	return n;
+	return true;
+}
+
+uint32_t handle_get(struct handle_db *db, void *ptr)
+{
+	uint32_t idx = 0;
+
+	if (!db || !ptr || ptr == INVALID_HANDLE_PTR)
+		return 0;
+
+	if (!db->first_free && !grow_db(db))
+		return 0;
+
+	idx = db->first_free;
+	db->first_free = db->slots[idx].next_free;
+	db->slots[idx].next_free = 0;
+	db->slots[idx].ptr = ptr;
+
+	return idx_to_handle(db, idx);
 }
 
 static bool handle_is_valid(struct handle_db *db, uint32_t handle)
 {
-	return db && handle && handle < db->max_ptrs;
+	uint32_t idx = handle & HANDLE_IDX_MASK;
+
+	return db && idx && idx < db->max_ptrs;
+}
+
+static struct handle_db_slot *handle_to_slot(struct handle_db *db,
+					     uint32_t handle)
+{
+	struct handle_db_slot *slot = NULL;
+
+	if (!handle_is_valid(db, handle))
+		return NULL;
+
+	slot = db->slots + (handle & HANDLE_IDX_MASK);
+	if (!slot->ptr || slot->gen != handle >> HANDLE_IDX_BITS)
+		return NULL;
+
+	return slot;
 }
 
 void *handle_put(struct handle_db *db, uint32_t handle)
 {
+	struct handle_db_slot *slot = handle_to_slot(db, handle);
 	void *p = NULL;
 
-	if (!handle_is_valid(db, handle))
+	if (!slot)
 		return NULL;
 
-	p = db->ptrs[handle];
-	db->ptrs[handle] = NULL;
+	p = slot->ptr;
+	slot->ptr = NULL;
+	slot->gen = (slot->gen + 1) & HANDLE_GEN_MASK;
+	slot->next_free = db->first_free;
+	db->first_free = handle & HANDLE_IDX_MASK;
+
 	return p;
 }
 
 void *handle_lookup(struct handle_db *db, uint32_t handle)
 {
-	if (!handle_is_valid(db, handle) ||
-	    db->ptrs[handle] == INVALID_HANDLE_PTR)
+	struct handle_db_slot *slot = handle_to_slot(db, handle);
+
+	if (!slot || slot->ptr == INVALID_HANDLE_PTR)
 		return NULL;
 
-	return db->ptrs[handle];
+	return slot->ptr;
 }
 
 void handle_invalidate(struct handle_db *db, uint32_t handle)
 {
+	struct handle_db_slot *slot = NULL;
+
 	if (handle_is_valid(db, handle)) {
-		if (!db->ptrs[handle])
+		slot = handle_to_slot(db, handle);
+		if (!slot)
 			TEE_Panic(TEE_ERROR_GENERIC);
 
-		db->ptrs[handle] = INVALID_HANDLE_PTR;
+		slot->ptr = INVALID_HANDLE_PTR;
 	}
 }
 
@@ -111,8 +169,8 @@ uint32_t handle_lookup_handle(struct handle_db *db, void *ptr)
 
 	if (ptr && ptr != INVALID_HANDLE_PTR) {
 		for (n = 1; n < db->max_ptrs; n++)
-			if (db->ptrs[n] == ptr)
-				return n;
+			if (db->slots[n].ptr == ptr)
+				return idx_to_handle(db, n);
 	}
 
 	return 0;
@@ -7,10 +7,23 @@
 #define PKCS11_TA_HANDLE_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A handle is the index of a slot in the database combined with the
+ * generation of the slot, incremented each time the slot is released.
+ * Free slots are linked into a list through @next_free.
+ */
+struct handle_db_slot {
+	void *ptr;
+	uint32_t gen;
+	uint32_t next_free;	/* Index of next free slot, 0 for none */
+};
 
 struct handle_db {
-	void **ptrs;
+	struct handle_db_slot *slots;
 	uint32_t max_ptrs;
+	uint32_t first_free;	/* Index of first free slot, 0 for none */
 };
 
 /*
@@ -15,6 +15,7 @@
 #include "pkcs11_attributes.h"
 #include "pkcs11_helpers.h"
 #include "pkcs11_token.h"
+#include "processing.h"
 #include "sanitize_object.h"
 #include "serializer.h"
 
@@ -28,6 +29,9 @@
 LIST_HEAD(temp_obj_list, pkcs11_object) temporary_object_list =
 	LIST_HEAD_INITIALIZER(temp_obj_list);
 
+/* Serial number of the last object instance created or modified */
+static uint64_t last_object_serial;
+
 static struct ck_token *get_session_token(void *session);
 
 struct pkcs11_object *pkcs11_handle2object(uint32_t handle,
@@ -87,6 +91,8 @@ static void cleanup_volatile_obj_ref(struct pkcs11_object *obj)
 
 	LIST_REMOVE(obj, link);
 
+	op_cache_purge(NULL, obj->serial);
+
 	if (obj->key_handle != TEE_HANDLE_NULL)
 		TEE_FreeTransientObject(obj->key_handle);
 
@@ -169,6 +175,81 @@ void destroy_object(struct pkcs11_session *session, struct pkcs11_object *obj,
 	}
 }
 
+/* Attributes indexed in struct obj_index */
+static const uint32_t obj_index_attrs[OBJ_INDEX_ATTR_COUNT] = {
+	PKCS11_CKA_CLASS, PKCS11_CKA_KEY_TYPE, PKCS11_CKA_ID, PKCS11_CKA_LABEL,
+};
+
+static uint32_t obj_index_hash(const uint8_t *data, uint32_t size)
+{
+	uint32_t hash = 2166136261U;
+	uint32_t n = 0;
+
+	/* FNV-1a */
+	for (n = 0; n < size; n++)
+		hash = (hash ^ data[n]) * 16777619U;
+
+	return hash ^ size;
+}
+
+static void obj_index_init(struct obj_index *index, struct obj_attrs *head)
+{
+	void *value = NULL;
+	uint32_t size = 0;
+	size_t n = 0;
+
+	*index = (struct obj_index){ .flags = OBJ_INDEX_VALID };
+
+	for (n = 0; n < ARRAY_SIZE(obj_index_attrs); n++) {
+		if (get_attribute_ptr(head, obj_index_attrs[n], &value, &size))
+			continue;
+		index->flags |= OBJ_INDEX_HAS_ATTR(n);
+		index->hash[n] = obj_index_hash(value, size);
+	}
+}
+
+void object_index_update(struct pkcs11_object *obj)
+{
+	if (!obj->attributes) {
+		obj->index.flags = 0;
+		return;
+	}
+
+	obj_index_init(&obj->index, obj->attributes);
+	if (object_is_private(obj->attributes))
+		obj->index.flags |= OBJ_INDEX_PRIVATE;
+}
+
+/*
+ * Return false if the index of @obj shows that it can't match the index
+ * @ref of the searched attributes or can't be accessed from @session.
+ * A true result only means that the attributes have to be checked.
+ */
+static bool object_index_may_match(struct pkcs11_object *obj,
+				   struct obj_index *ref,
+				   struct pkcs11_session *session)
+{
+	size_t n = 0;
+
+	if (!(obj->index.flags & OBJ_INDEX_VALID))
+		return true;
+
+	if ((obj->index.flags & OBJ_INDEX_PRIVATE) &&
+	    (pkcs11_session_is_public(session) ||
+	     pkcs11_session_is_so(session)))
+		return false;
+
+	for (n = 0; n < ARRAY_SIZE(obj_index_attrs); n++) {
+		if (!(ref->flags & OBJ_INDEX_HAS_ATTR(n)))
+			continue;
+		if (!(obj->index.flags & OBJ_INDEX_HAS_ATTR(n)) ||
+		    obj->index.hash[n] != ref->hash[n])
+			return false;
+	}
+
+	return true;
+}
+
 static struct pkcs11_object *create_obj_instance(struct obj_attrs *head,
 						 struct ck_token *token)
 {
@@ -182,6 +263,8 @@ static struct pkcs11_object *create_obj_instance(struct obj_attrs *head,
 	obj->attribs_hdl = TEE_HANDLE_NULL;
 	obj->attributes = head;
 	obj->token = token;
+	obj->serial = ++last_object_serial;
+	object_index_update(obj);
 
 	return obj;
 }
@@ -509,6 +592,7 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 	struct pkcs11_object *obj = NULL;
 	struct pkcs11_find_objects *find_ctx = NULL;
 	struct handle_db *object_db = NULL;
+	struct obj_index ref_index = { };
 
 	if (!client || ptypes != exp_pt)
 		return PKCS11_CKR_ARGUMENTS_BAD;
@@ -575,8 +659,11 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 
 	/*
 	 * Scan all objects (sessions and persistent ones) and set a list of
-	 * candidates that match caller attributes.
+	 * candidates that match caller attributes. The index of the objects
+	 * avoids comparing, and for token objects loading, the attributes
+	 * of most objects which don't match.
 	 */
+	obj_index_init(&ref_index, req_attrs);
 
 	/* Scan all session objects first */
 	TAILQ_FOREACH(sess, get_session_list(session), link) {
@@ -589,7 +676,8 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 			if (obj->token)
 				continue;
 
-			if (!attributes_match_reference(obj->attributes,
+			if (!object_index_may_match(obj, &ref_index, session) ||
+			    !attributes_match_reference(obj->attributes,
 							req_attrs))
 				continue;
 
@@ -607,6 +695,9 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 		uint32_t handle = 0;
 		bool new_load = false;
 
+		if (!object_index_may_match(obj, &ref_index, session))
+			continue;
+
 		if (!obj->attributes) {
 			rc = load_persistent_object_attributes(obj);
 			if (rc) {
@@ -1099,6 +1190,11 @@ enum pkcs11_rc entry_set_attribute_value(struct pkcs11_client *client,
 			goto out;
 		}
 	}
+	object_index_update(obj);
+
+	/* TEE operations cached for the former attributes are dropped */
+	op_cache_purge(NULL, obj->serial);
+	obj->serial = ++last_object_serial;
 
 	TEE_Free(head_old);
 
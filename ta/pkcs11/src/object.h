@@ -9,12 +9,33 @@
 #include <pkcs11_ta.h>
 #include <sys/queue.h>
 #include <tee_internal_api.h>
+#include <util.h>
 
 struct ck_token;
 struct obj_attrs;
 struct pkcs11_client;
 struct pkcs11_session;
 
+/*
+ * Search index of an object, digests of the attributes most used to find
+ * objects. It stays valid when the attributes of a persistent object are
+ * released so that finding objects only loads the attributes of objects
+ * which may match.
+ *
+ * flags: OBJ_INDEX_* bits, OBJ_INDEX_VALID if the index was computed
+ * hash: digests of the indexed attributes, valid if the matching
+ * OBJ_INDEX_HAS_* bit is set
+ */
+#define OBJ_INDEX_VALID		BIT(0)
+#define OBJ_INDEX_PRIVATE	BIT(1)
+#define OBJ_INDEX_HAS_ATTR(n)	BIT(2 + (n))
+#define OBJ_INDEX_ATTR_COUNT	4
+
+struct obj_index {
+	uint32_t flags;
+	uint32_t hash[OBJ_INDEX_ATTR_COUNT];
+};
+
 /*
  * link: objects are referenced in a double-linked list
  * attributes: pointer to the serialized object attributes
@@ -23,6 +44,9 @@ struct pkcs11_session;
  * token: associated token for the object
  * uuid: object UUID in the persistent database if a persistent object, or NULL
  * attribs_hdl: GPD TEE attributes handles if persistent object
+ * index: search index, see struct obj_index
+ * serial: unique number of the object, renewed when its attributes change,
+ * identifies the object in the cache of TEE operations
  */
 struct pkcs11_object {
 	LIST_ENTRY(pkcs11_object) link;
@@ -32,6 +56,8 @@ struct pkcs11_object {
 	struct ck_token *token;
 	TEE_UUID *uuid;
 	TEE_ObjectHandle attribs_hdl;
+	struct obj_index index;
+	uint64_t serial;
 };
 
 LIST_HEAD(object_list, pkcs11_object);
@@ -49,6 +75,9 @@ struct pkcs11_object *create_token_object(struct obj_attrs *head,
 enum pkcs11_rc create_object(void *session, struct obj_attrs *attributes,
 			     uint32_t *handle);
 
+/* Compute the search index of @obj from its loaded attributes */
+void object_index_update(struct pkcs11_object *obj);
+
 void cleanup_persistent_object(struct pkcs11_object *obj,
 			       struct ck_token *token);
 
@@ -95,6 +95,89 @@ static enum pkcs11_rc do_hash(uint32_t user, const uint8_t *pin,
 	return PKCS11_CKR_OK;
 }
 
+/*
+ * PIN hashes derived with PBKDF2 fill the TEE_MAX_HASH_SIZE bytes of the
+ * token database as below. Other PIN hashes are a SHA-256 digest padded
+ * with zeros, they are told apart by @magic.
+ */
+struct pin_hash_pbkdf2 {
+	uint8_t key[TEE_SHA256_HASH_SIZE];
+	uint32_t magic;
+	uint32_t iterations;
+};
+
+#define PIN_HASH_PBKDF2_MAGIC	0x324b4250
+
+static_assert(sizeof(struct pin_hash_pbkdf2) <= TEE_MAX_HASH_SIZE);
+
+static enum pkcs11_rc do_pbkdf2(uint32_t user, const uint8_t *pin,
+				size_t pin_size, uint32_t salt,
+				uint32_t iterations,
+				uint8_t hash[TEE_MAX_HASH_SIZE])
+{
+	struct pin_hash_pbkdf2 *out = (void *)hash;
+	TEE_OperationHandle oh = TEE_HANDLE_NULL;
+	TEE_ObjectHandle password = TEE_HANDLE_NULL;
+	TEE_ObjectHandle key = TEE_HANDLE_NULL;
+	TEE_Attribute attrs[3] = { };
+	uint32_t pbkdf2_salt[2] = { user, salt };
+	size_t key_size = sizeof(out->key);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = TEE_AllocateOperation(&oh, TEE_ALG_PBKDF2_HMAC_SHA1_DERIVE_KEY,
+				    TEE_MODE_DERIVE,
+				    PKCS11_TOKEN_PIN_SIZE_MAX * 8);
+	if (res)
+		return tee2pkcs_error(res);
+
+	res = TEE_AllocateTransientObject(TEE_TYPE_PBKDF2_PASSWORD,
+					  PKCS11_TOKEN_PIN_SIZE_MAX * 8,
+					  &password);
+	if (res)
+		goto out;
+
+	TEE_InitRefAttribute(attrs, TEE_ATTR_PBKDF2_PASSWORD, pin, pin_size);
+	res = TEE_PopulateTransientObject(password, attrs, 1);
+	if (res)
+		goto out;
+
+	res = TEE_SetOperationKey(oh, password);
+	if (res)
+		goto out;
+
+	res = TEE_AllocateTransientObject(TEE_TYPE_GENERIC_SECRET,
+					  key_size * 8, &key);
+	if (res)
+		goto out;
+
+	TEE_InitRefAttribute(attrs, TEE_ATTR_PBKDF2_SALT, pbkdf2_salt,
+			     sizeof(pbkdf2_salt));
+	TEE_InitValueAttribute(attrs + 1, TEE_ATTR_PBKDF2_DKM_LENGTH,
+			       key_size, 0);
+	TEE_InitValueAttribute(attrs + 2, TEE_ATTR_PBKDF2_ITERATION_COUNT,
+			       iterations, 0);
+	TEE_DeriveKey(oh, attrs, ARRAY_SIZE(attrs), key);
+
+	memset(hash, 0, TEE_MAX_HASH_SIZE);
+	res = TEE_GetObjectBufferAttribute(key, TEE_ATTR_SECRET_VALUE,
+					   out->key, &key_size);
+	if (res)
+		goto out;
+
+	out->magic = PIN_HASH_PBKDF2_MAGIC;
+	out->iterations = iterations;
+
+out:
+	TEE_FreeTransientObject(key);
+	TEE_FreeTransientObject(password);
+	TEE_FreeOperation(oh);
+
+	if (res)
+		return PKCS11_CKR_GENERAL_ERROR;
+
+	return PKCS11_CKR_OK;
+}
+
 enum pkcs11_rc hash_pin(enum pkcs11_user_type user, const uint8_t *pin,
 			size_t pin_size, uint32_t *salt,
 			uint8_t hash[TEE_MAX_HASH_SIZE])
@@ -106,27 +189,109 @@ enum pkcs11_rc hash_pin(enum pkcs11_user_type user, const uint8_t *pin,
 	if (!s)
 		s++;
 
-	rc = do_hash(user, pin, pin_size, s, hash);
+	if (CFG_PKCS11_TA_PIN_PBKDF2_ITERATIONS)
+		rc = do_pbkdf2(user, pin, pin_size, s,
+			       CFG_PKCS11_TA_PIN_PBKDF2_ITERATIONS, hash);
+	else
+		rc = do_hash(user, pin, pin_size, s, hash);
 	if (!rc)
 		*salt = s;
 	return rc;
 }
 
+/*
+ * Cache of the PINs last verified against a PBKDF2 hash so that logging
+ * in again doesn't derive the PIN again. An entry holds a copy of the
+ * stored PIN hash it was verified against and a SHA-256 based digest of
+ * the PIN, with a salt of its own. A wrong PIN never matches an entry so
+ * the derivation cost of each failed attempt is unchanged, and setting a
+ * PIN changes its salt and hash which invalidates the entry.
+ */
+struct pin_cache_entry {
+	uint32_t user;
+	uint32_t salt;
+	uint8_t hash[TEE_MAX_HASH_SIZE];
+	uint32_t digest_salt;
+	uint8_t digest[TEE_MAX_HASH_SIZE];
+};
+
+static struct pin_cache_entry pin_cache[CFG_PKCS11_TA_TOKEN_COUNT *
+					PKCS11_MAX_USERS];
+static size_t pin_cache_next;
+
+static struct pin_cache_entry *pin_cache_find(uint32_t user, uint32_t salt,
+					      const uint8_t *hash)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(pin_cache); n++)
+		if (pin_cache[n].salt == salt && pin_cache[n].user == user &&
+		    !buf_compare_ct(pin_cache[n].hash, hash,
+				    TEE_MAX_HASH_SIZE))
+			return pin_cache + n;
+
+	return NULL;
+}
+
+static bool pin_cache_match(uint32_t user, const uint8_t *pin,
+			    size_t pin_size, uint32_t salt,
+			    const uint8_t *hash)
+{
+	struct pin_cache_entry *entry = pin_cache_find(user, salt, hash);
+	uint8_t digest[TEE_MAX_HASH_SIZE] = { };
+
+	if (!entry ||
+	    do_hash(user, pin, pin_size, entry->digest_salt, digest))
+		return false;
+
+	return !buf_compare_ct(entry->digest, digest, TEE_MAX_HASH_SIZE);
+}
+
+static void pin_cache_add(uint32_t user, const uint8_t *pin,
+			  size_t pin_size, uint32_t salt, const uint8_t *hash)
+{
+	struct pin_cache_entry *entry = pin_cache_find(user, salt, hash);
+
+	if (!entry) {
+		entry = pin_cache + pin_cache_next;
+		pin_cache_next = (pin_cache_next + 1) % ARRAY_SIZE(pin_cache);
+	}
+
+	entry->user = user;
+	entry->salt = salt;
+	TEE_MemMove(entry->hash, hash, TEE_MAX_HASH_SIZE);
+	TEE_GenerateRandom(&entry->digest_salt, sizeof(entry->digest_salt));
+	if (do_hash(user, pin, pin_size, entry->digest_salt, entry->digest))
+		memset(entry, 0, sizeof(*entry));
+}
+
 enum pkcs11_rc verify_pin(enum pkcs11_user_type user, const uint8_t *pin,
 			  size_t pin_size, uint32_t salt,
 			  const uint8_t hash[TEE_MAX_HASH_SIZE])
 {
+	const struct pin_hash_pbkdf2 *pbkdf2 = (const void *)hash;
 	uint8_t tmp_hash[TEE_MAX_HASH_SIZE] = { 0 };
 	enum pkcs11_rc rc = PKCS11_CKR_OK;
 
-	rc = do_hash(user, pin, pin_size, salt, tmp_hash);
+	if (pbkdf2->magic != PIN_HASH_PBKDF2_MAGIC) {
+		rc = do_hash(user, pin, pin_size, salt, tmp_hash);
+	} else {
+		if (pin_cache_match(user, pin, pin_size, salt, hash))
+			return PKCS11_CKR_OK;
+
+		rc = do_pbkdf2(user, pin, pin_size, salt, pbkdf2->iterations,
+			       tmp_hash);
+	}
 	if (rc)
 		return rc;
 
 	if (buf_compare_ct(tmp_hash, hash, TEE_MAX_HASH_SIZE))
-		rc = PKCS11_CKR_PIN_INCORRECT;
+		return PKCS11_CKR_PIN_INCORRECT;
 
-	return rc;
+	if (pbkdf2->magic == PIN_HASH_PBKDF2_MAGIC)
+		pin_cache_add(user, pin, pin_size, salt, hash);
+
+	return PKCS11_CKR_OK;
 }
 
 #if defined(CFG_PKCS11_TA_AUTH_TEE_IDENTITY)
@@ -350,13 +515,38 @@ enum pkcs11_rc get_persistent_objects_list(struct ck_token *token,
 	return PKCS11_CKR_OK;
 }
 
+/* Offset in the database file of the UUID at index @idx */
+static size_t db_uuid_offset(size_t idx)
+{
+	return sizeof(struct token_persistent_main) +
+	       sizeof(struct token_persistent_objs) + idx * sizeof(TEE_UUID);
+}
+
+/* Write @size bytes of @data at offset @offset of the database file */
+static TEE_Result write_db_at(TEE_ObjectHandle db_hdl, size_t offset,
+			      const void *data, size_t size)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = TEE_SeekObjectData(db_hdl, offset, TEE_DATA_SEEK_SET);
+	if (res)
+		return res;
+
+	return TEE_WriteObjectData(db_hdl, data, size);
+}
+
+/*
+ * The object database is updated in place rather than rewritten: the
+ * last UUID of the list is moved to the slot of the unregistered object
+ * before the count is decremented. An interruption in between leaves the
+ * moved UUID registered twice, which init_persistent_db() detects.
+ */
 enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 					    TEE_UUID *uuid)
 {
 	TEE_ObjectHandle db_hdl = TEE_HANDLE_NULL;
-	struct token_persistent_objs *ptr = NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
-	int count = 0;
+	uint32_t count = 0;
 	int idx = 0;
 
 	if (!uuid)
@@ -368,58 +558,54 @@ enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 		return PKCS11_RV_NOT_FOUND;
 	}
 
-	ptr = TEE_Malloc(sizeof(struct token_persistent_objs) +
-			 ((token->db_objs->count - 1) * sizeof(TEE_UUID)),
-			 TEE_USER_MEM_HINT_NO_FILL_ZERO);
-	if (!ptr)
-		return PKCS11_CKR_DEVICE_MEMORY;
-
 	res = open_db_file(token, &db_hdl);
 	if (res)
 		goto out;
 
-	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main),
-				 TEE_DATA_SEEK_SET);
+	count = token->db_objs->count - 1;
+
+	if ((uint32_t)idx != count) {
+		res = write_db_at(db_hdl, db_uuid_offset(idx),
+				  token->db_objs->uuids + count,
+				  sizeof(TEE_UUID));
+		if (res) {
+			DMSG("Failed to update database");
+			goto out;
+		}
+	}
+
+	res = write_db_at(db_hdl, sizeof(struct token_persistent_main),
+			  &count, sizeof(count));
 	if (res) {
-		DMSG("Failed to read database");
+		DMSG("Failed to update database");
 		goto out;
 	}
 
-	TEE_MemMove(ptr, token->db_objs,
-		    sizeof(struct token_persistent_objs) +
-		    idx * sizeof(TEE_UUID));
-
-	ptr->count--;
-	count = ptr->count - idx;
+	/* The trailing UUID is stale, failing to drop it is harmless */
+	TEE_TruncateObjectData(db_hdl, db_uuid_offset(count));
 
-	TEE_MemMove(&ptr->uuids[idx],
-		    &token->db_objs->uuids[idx + 1],
-		    count * sizeof(TEE_UUID));
-
-	res = TEE_WriteObjectData(db_hdl, ptr,
-				  sizeof(struct token_persistent_objs) +
-				  ptr->count * sizeof(TEE_UUID));
-	if (res)
-		DMSG("Failed to update database");
-	TEE_Free(token->db_objs);
-	token->db_objs = ptr;
-	ptr = NULL;
+	TEE_MemMove(token->db_objs->uuids + idx,
+		    token->db_objs->uuids + count, sizeof(TEE_UUID));
+	token->db_objs->count = count;
 
 out:
 	TEE_CloseObject(db_hdl);
-	TEE_Free(ptr);
 
 	return tee2pkcs_error(res);
 }
 
+/*
+ * The UUID is appended to the object database before the count is
+ * incremented so that an interruption in between leaves the database
+ * unchanged.
+ */
 enum pkcs11_rc register_persistent_object(struct ck_token *token,
 					  TEE_UUID *uuid)
 {
 	TEE_ObjectHandle db_hdl = TEE_HANDLE_NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t count = 0;
 	void *ptr = NULL;
-	size_t size = 0;
-	int count = 0;
 
 	if (get_persistent_obj_idx(token, uuid) >= 0)
 		TEE_Panic(0);
@@ -434,30 +620,22 @@ enum pkcs11_rc register_persistent_object(struct ck_token *token,
 	token->db_objs = ptr;
 	TEE_MemMove(token->db_objs->uuids + count, uuid, sizeof(TEE_UUID));
 
-	size = sizeof(struct token_persistent_main) +
-	       sizeof(struct token_persistent_objs) +
-	       count * sizeof(TEE_UUID);
-
 	res = open_db_file(token, &db_hdl);
 	if (res)
 		goto out;
 
-	res = TEE_TruncateObjectData(db_hdl, size + sizeof(TEE_UUID));
+	res = write_db_at(db_hdl, db_uuid_offset(count), uuid,
+			  sizeof(TEE_UUID));
 	if (res)
 		goto out;
 
-	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main),
-				 TEE_DATA_SEEK_SET);
+	count++;
+	res = write_db_at(db_hdl, sizeof(struct token_persistent_main),
+			  &count, sizeof(count));
 	if (res)
 		goto out;
 
-	token->db_objs->count++;
-
-	res = TEE_WriteObjectData(db_hdl, token->db_objs,
-				  sizeof(struct token_persistent_objs) +
-				  token->db_objs->count * sizeof(TEE_UUID));
-	if (res)
-		token->db_objs->count--;
+	token->db_objs->count = count;
 
 out:
 	TEE_CloseObject(db_hdl);
@@ -523,6 +701,7 @@ enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj)
 
 	obj->attributes = attr;
 	attr = NULL;
+	object_index_update(obj);
 
 	rc = PKCS11_CKR_OK;
 
@@ -629,6 +808,21 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 				TEE_Panic(0);
 		}
 
+		/*
+		 * Unregistering an object moves the last UUID of the list:
+		 * if interrupted, the last UUID is also found earlier in the
+		 * list and is dropped.
+		 */
+		for (idx = 0; db_objs->count > 1 &&
+			      idx < db_objs->count - 1; idx++) {
+			if (!TEE_MemCompare(db_objs->uuids + idx,
+					    db_objs->uuids + db_objs->count - 1,
+					    sizeof(TEE_UUID))) {
+				db_objs->count--;
+				break;
+			}
+		}
+
 		for (idx = 0; idx < db_objs->count; idx++) {
 			/* Create an empty object instance */
 			struct pkcs11_object *obj = NULL;
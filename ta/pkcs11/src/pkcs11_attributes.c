@@ -125,6 +125,7 @@ check_mechanism_against_processing(struct pkcs11_session *session,
 		break;
 
 	case PKCS11_FUNC_STEP_FINAL:
+	case PKCS11_FUNC_STEP_UPDATE_FINAL:
 		if (session->processing->always_authen &&
 		    !session->processing->relogged)
 			return PKCS11_CKR_USER_NOT_LOGGED_IN;
@@ -498,6 +499,9 @@ static enum pkcs11_rc create_storage_attributes(struct obj_attrs **out,
 	if (rc)
 		return rc;
 
+	/* Unbound by create_attributes_from_template() */
+	attrs_index_bind(*out);
+
 	/* Object class is mandatory */
 	class = get_class(temp);
 	if (class == PKCS11_CKO_UNDEFINED_ID) {
@@ -1296,6 +1300,9 @@ create_attributes_from_template(struct obj_attrs **out, void *template,
 		break;
 	}
 
+	/* @temp is looked up for each attribute of the new object */
+	attrs_index_bind(temp);
+
 	/*
 	 * Check if class and type in temp are consistent with the mechanism
 	 */
@@ -1501,6 +1508,8 @@ create_attributes_from_template(struct obj_attrs **out, void *template,
 #endif
 
 out:
+	attrs_index_unbind(temp);
+	attrs_index_unbind(attrs);
 	TEE_Free(temp);
 	if (rc)
 		TEE_Free(attrs);
@@ -119,6 +119,7 @@ enum processing_step {
 	PKCS11_FUNC_STEP_UPDATE,
 	PKCS11_FUNC_STEP_UPDATE_KEY,
 	PKCS11_FUNC_STEP_FINAL,
+	PKCS11_FUNC_STEP_UPDATE_FINAL,
 };
 
 /* Create an attribute list for a new object */
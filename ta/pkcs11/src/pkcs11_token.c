@@ -700,6 +700,9 @@ static void close_ck_session(struct pkcs11_session *session)
 	if (pkcs11_session_is_read_write(session))
 		session->token->rw_session_count--;
 
+	if (!session->token->session_count)
+		op_cache_purge(session->token, 0);
+
 	DMSG("Close PKCS11 session %"PRIu32, session->handle);
 
 	TEE_Free(session);
@@ -1390,6 +1393,9 @@ static void session_logout(struct pkcs11_session *session)
 		else
 			sess->state = PKCS11_CKS_RO_PUBLIC_SESSION;
 	}
+
+	/* Don't keep operations on private keys once logged out */
+	op_cache_purge(session->token, 0);
 }
 
 enum pkcs11_rc entry_ck_login(struct pkcs11_client *client,
@@ -139,6 +139,8 @@ enum pkcs11_proc_state {
  * @tee_op_handle - handle on active crypto operation or TEE_HANDLE_NULL
  * @tee_op_handle2 - second handle for specific operations or TEE_HANDLE_NULL
  * @tee_hash_algo - hash algorithm identifier.
+ * @key_serial - serial of the key object set in @tee_op_handle, 0 if the
+ *	operation is not to be cached when released
  * @extra_ctx - context for the active processing
  */
 struct active_processing {
@@ -150,6 +152,7 @@ struct active_processing {
 	TEE_OperationHandle tee_op_handle;
 	TEE_OperationHandle tee_op_handle2;
 	uint32_t tee_hash_algo;
+	uint64_t key_serial;
 	void *extra_ctx;
 };
 
@@ -50,6 +50,7 @@ static enum processing_func func_for_cmd(enum pkcs11_ta_cmd cmd)
 	case PKCS11_CMD_DIGEST_KEY:
 	case PKCS11_CMD_DIGEST_ONESHOT:
 	case PKCS11_CMD_DIGEST_FINAL:
+	case PKCS11_CMD_DIGEST_UPDATE_FINAL:
 		return PKCS11_FUNCTION_DIGEST;
 	default:
 		return PKCS11_FUNCTION_UNKNOWN;
@@ -99,6 +100,109 @@ static enum pkcs11_rc get_active_session(struct pkcs11_session *session,
 	return rc;
 }
 
+#if CFG_PKCS11_TA_OP_CACHE_SIZE
+/*
+ * Idle TEE operations, most recently used first and unused entries last.
+ * An entry is unused when @serial is 0.
+ *
+ * @token - token of the session the operation was used in
+ * @serial - serial of the key object set in the operation
+ * @algo - TEE algorithm of the operation
+ * @mode - TEE mode of the operation
+ * @handle - TEE operation, reset to its initial state
+ */
+struct op_cache_entry {
+	struct ck_token *token;
+	uint64_t serial;
+	uint32_t algo;
+	uint32_t mode;
+	TEE_OperationHandle handle;
+};
+
+static struct op_cache_entry op_cache[CFG_PKCS11_TA_OP_CACHE_SIZE];
+
+static void op_cache_remove(size_t n)
+{
+	memmove(op_cache + n, op_cache + n + 1,
+		(ARRAY_SIZE(op_cache) - n - 1) * sizeof(*op_cache));
+	op_cache[ARRAY_SIZE(op_cache) - 1] = (struct op_cache_entry){ };
+}
+
+TEE_OperationHandle op_cache_get(struct ck_token *token, uint64_t serial,
+				 uint32_t algo, uint32_t mode)
+{
+	TEE_OperationHandle op = TEE_HANDLE_NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(op_cache) && op_cache[n].serial; n++) {
+		if (op_cache[n].token == token &&
+		    op_cache[n].serial == serial &&
+		    op_cache[n].algo == algo && op_cache[n].mode == mode) {
+			op = op_cache[n].handle;
+			op_cache_remove(n);
+			break;
+		}
+	}
+
+	return op;
+}
+
+static void op_cache_put(struct ck_token *token, uint64_t serial,
+			 TEE_OperationHandle op)
+{
+	struct op_cache_entry *last = op_cache + ARRAY_SIZE(op_cache) - 1;
+	TEE_OperationInfo info = { };
+
+	TEE_GetOperationInfo(op, &info);
+	TEE_ResetOperation(op);
+
+	/* Evict the least recently used operation */
+	if (last->serial)
+		TEE_FreeOperation(last->handle);
+
+	memmove(op_cache + 1, op_cache, (last - op_cache) * sizeof(*op_cache));
+	op_cache[0] = (struct op_cache_entry){
+		.token = token,
+		.serial = serial,
+		.algo = info.algorithm,
+		.mode = info.mode,
+		.handle = op,
+	};
+}
+
+void op_cache_purge(struct ck_token *token, uint64_t serial)
+{
+	size_t n = 0;
+
+	while (n < ARRAY_SIZE(op_cache) && op_cache[n].serial) {
+		if ((!token || op_cache[n].token == token) &&
+		    (!serial || op_cache[n].serial == serial)) {
+			TEE_FreeOperation(op_cache[n].handle);
+			op_cache_remove(n);
+		} else {
+			n++;
+		}
+	}
+}
+#else
+TEE_OperationHandle op_cache_get(struct ck_token *token __unused,
+				 uint64_t serial __unused,
+				 uint32_t algo __unused, uint32_t mode __unused)
+{
+	return TEE_HANDLE_NULL;
+}
+
+static void op_cache_put(struct ck_token *token __unused,
+			 uint64_t serial __unused, TEE_OperationHandle op)
+{
+	TEE_FreeOperation(op);
+}
+
+void op_cache_purge(struct ck_token *token __unused, uint64_t serial __unused)
+{
+}
+#endif
+
 void release_active_processing(struct pkcs11_session *session)
 {
 	if (!session->processing)
@@ -113,7 +217,12 @@ void release_active_processing(struct pkcs11_session *session)
 	}
 
 	if (session->processing->tee_op_handle != TEE_HANDLE_NULL) {
-		TEE_FreeOperation(session->processing->tee_op_handle);
+		if (session->processing->key_serial)
+			op_cache_put(session->token,
+				     session->processing->key_serial,
+				     session->processing->tee_op_handle);
+		else
+			TEE_FreeOperation(session->processing->tee_op_handle);
 		session->processing->tee_op_handle = TEE_HANDLE_NULL;
 	}
 
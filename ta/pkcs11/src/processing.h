@@ -10,6 +10,7 @@
 #include <pkcs11_ta.h>
 #include <tee_internal_api.h>
 
+struct ck_token;
 struct pkcs11_client;
 struct pkcs11_session;
 struct pkcs11_object;
@@ -114,6 +115,17 @@ size_t get_object_key_bit_size(struct pkcs11_object *obj);
 
 void release_active_processing(struct pkcs11_session *session);
 
+/*
+ * Cache of TEE operations with the key of an object already set. A TEE
+ * operation is taken from the cache with op_cache_get() and given back
+ * by release_active_processing() once reset. op_cache_purge() frees the
+ * cached operations matching @token and @serial, a NULL @token or a
+ * zero @serial matching any.
+ */
+TEE_OperationHandle op_cache_get(struct ck_token *token, uint64_t serial,
+				 uint32_t algo, uint32_t mode);
+void op_cache_purge(struct ck_token *token, uint64_t serial);
+
 enum pkcs11_rc alloc_get_tee_attribute_data(TEE_ObjectHandle tee_obj,
 					    uint32_t attribute,
 					    void **data, size_t *size);
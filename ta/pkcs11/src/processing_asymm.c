@@ -269,6 +269,13 @@ allocate_tee_operation(struct pkcs11_session *session,
 		processing->tee_hash_algo = hash_algo;
 	}
 
+	processing->tee_op_handle = op_cache_get(session->token, obj->serial,
+						 algo, mode);
+	if (processing->tee_op_handle != TEE_HANDLE_NULL) {
+		processing->key_serial = obj->serial;
+		return PKCS11_CKR_OK;
+	}
+
 	res = TEE_AllocateOperation(&processing->tee_op_handle,
 				    algo, mode, size);
 	if (res)
@@ -453,9 +460,14 @@ enum pkcs11_rc init_asymm_operation(struct pkcs11_session *session,
 	if (rc)
 		return rc;
 
-	rc = load_tee_key(session, obj, function);
-	if (rc)
-		return rc;
+	/* An operation from the cache already has the key set */
+	if (!session->processing->key_serial) {
+		rc = load_tee_key(session, obj, function);
+		if (rc)
+			return rc;
+
+		session->processing->key_serial = obj->serial;
+	}
 
 	rc = init_tee_operation(session, proc_params, obj);
 	if (!rc)
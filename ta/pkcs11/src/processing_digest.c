@@ -144,6 +144,7 @@ enum pkcs11_rc step_digest_operation(struct pkcs11_session *session,
 	case PKCS11_FUNC_STEP_UPDATE:
 	case PKCS11_FUNC_STEP_UPDATE_KEY:
 	case PKCS11_FUNC_STEP_FINAL:
+	case PKCS11_FUNC_STEP_UPDATE_FINAL:
 		break;
 	default:
 		TEE_Panic(step);
@@ -201,6 +202,12 @@ enum pkcs11_rc step_digest_operation(struct pkcs11_session *session,
 
 		goto do_final;
 
+	case PKCS11_FUNC_STEP_UPDATE_FINAL:
+		if (!out_buf)
+			return PKCS11_CKR_ARGUMENTS_BAD;
+
+		goto do_final;
+
 	default:
 		TEE_Panic(step);
 		break;
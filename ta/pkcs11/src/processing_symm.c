@@ -257,6 +257,14 @@ allocate_tee_operation(struct pkcs11_session *session,
 		break;
 	}
 
+	session->processing->tee_op_handle = op_cache_get(session->token,
+							  obj->serial, algo,
+							  mode);
+	if (session->processing->tee_op_handle != TEE_HANDLE_NULL) {
+		session->processing->key_serial = obj->serial;
+		return PKCS11_CKR_OK;
+	}
+
 	res = TEE_AllocateOperation(&session->processing->tee_op_handle,
 				    algo, mode, size);
 	if (res)
@@ -642,9 +650,16 @@ enum pkcs11_rc init_symm_operation(struct pkcs11_session *session,
 	if (rc)
 		return rc;
 
-	rc = load_tee_key(session, obj, proc_params);
-	if (rc)
-		return rc;
+	/* An operation from the cache already has the key set */
+	if (!session->processing->key_serial) {
+		rc = load_tee_key(session, obj, proc_params);
+		if (rc)
+			return rc;
+
+		/* AES GCM state also lives in tee_op_handle2, not cached */
+		if (proc_params->id != PKCS11_CKM_AES_GCM)
+			session->processing->key_serial = obj->serial;
+	}
 
 	rc = init_tee_operation(session, proc_params);
 	if (!rc)
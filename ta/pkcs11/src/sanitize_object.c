@@ -245,30 +245,17 @@ out:
 	return rc;
 }
 
-enum pkcs11_rc sanitize_client_object(struct obj_attrs **dst, void *src,
-				      size_t size, uint32_t class_hint,
-				      uint32_t type_hint)
+static enum pkcs11_rc sanitize_attributes(struct obj_attrs **dst, void *src,
+					  size_t sz_from_hdr,
+					  uint32_t class_hint,
+					  uint32_t type_hint)
 {
 	struct pkcs11_attribute_head cli_ref = { };
 	struct pkcs11_object_head head = { };
 	enum pkcs11_rc rc = PKCS11_CKR_OK;
 	size_t pos = sizeof(head);
-	size_t sz_from_hdr = 0;
 	void *data = NULL;
 
-	if (size < sizeof(head))
-		return PKCS11_CKR_ARGUMENTS_BAD;
-
-	TEE_MemMove(&head, src, sizeof(head));
-
-	if (ADD_OVERFLOW(sizeof(head), head.attrs_size, &sz_from_hdr) ||
-	    size < sz_from_hdr)
-		return PKCS11_CKR_ARGUMENTS_BAD;
-
-	rc = init_attributes_head(dst);
-	if (rc)
-		return rc;
-
 	rc = sanitize_class_and_type(dst, src, sz_from_hdr, class_hint,
 				     type_hint);
 	if (rc)
@@ -309,6 +296,35 @@ enum pkcs11_rc sanitize_client_object(struct obj_attrs **dst, void *src,
 	return rc;
 }
 
+enum pkcs11_rc sanitize_client_object(struct obj_attrs **dst, void *src,
+				      size_t size, uint32_t class_hint,
+				      uint32_t type_hint)
+{
+	struct pkcs11_object_head head = { };
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+	size_t sz_from_hdr = 0;
+
+	if (size < sizeof(head))
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	TEE_MemMove(&head, src, sizeof(head));
+
+	if (ADD_OVERFLOW(sizeof(head), head.attrs_size, &sz_from_hdr) ||
+	    size < sz_from_hdr)
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	rc = init_attributes_head(dst);
+	if (rc)
+		return rc;
+
+	/* Appending to @dst doesn't reallocate for each attribute */
+	attrs_index_bind(*dst);
+	rc = sanitize_attributes(dst, src, sz_from_hdr, class_hint, type_hint);
+	attrs_index_unbind(*dst);
+
+	return rc;
+}
+
 /*
  * Debug: dump object attribute array to output trace
  */
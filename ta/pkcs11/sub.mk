@@ -21,3 +21,12 @@ CFG_PKCS11_TA_RSA_X_509 ?= n
 global-incdirs-y += include
 global-incdirs-y += src
 subdirs-y += src
+
+# Number of TEE operations kept ready for reuse with the same key object
+# once a processing completes, 0 to disable the cache
+CFG_PKCS11_TA_OP_CACHE_SIZE ?= 8
+
+# When non-zero, new PINs are hashed with PBKDF2 and this iteration count
+# instead of a single SHA-256 digest, which needs CFG_CRYPTO_PBKDF2=y in
+# the core. PINs already set keep the hash they were set with.
+CFG_PKCS11_TA_PIN_PBKDF2_ITERATIONS ?= 0
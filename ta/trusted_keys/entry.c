@@ -144,30 +144,51 @@ static TEE_Result huk_ae_decrypt(TEE_OperationHandle crypto_op, uint8_t *in,
 	return res;
 }
 
-static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, size_t in_sz,
-			    uint8_t *out, size_t *out_sz)
+/*
+ * The key derived from the HUK and the operations using it are set up on
+ * first use and kept for the lifetime of the TA instance, so loading many
+ * trusted keys only derives the key once.
+ */
+static TEE_OperationHandle huk_ops[2] = {
+	TEE_HANDLE_NULL, TEE_HANDLE_NULL
+};
+
+static void free_huk_ops(void)
 {
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(huk_ops); n++) {
+		TEE_FreeOperation(huk_ops[n]);
+		huk_ops[n] = TEE_HANDLE_NULL;
+	}
+}
+
+static TEE_Result init_huk_ops(void)
+{
+	static const TEE_OperationMode modes[] = {
+		TEE_MODE_ENCRYPT, TEE_MODE_DECRYPT
+	};
 	TEE_Result res = TEE_ERROR_GENERIC;
-	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
 	TEE_ObjectHandle hkey = TEE_HANDLE_NULL;
 	uint8_t huk_key[TA_DERIVED_KEY_MAX_SIZE] = { };
 	TEE_Attribute attr = { };
+	size_t n = 0;
 
-	res = TEE_AllocateOperation(&crypto_op, TEE_ALG_AES_GCM, mode,
-				    sizeof(huk_key) * 8);
-	if (res)
-		return res;
+	static_assert(ARRAY_SIZE(modes) == ARRAY_SIZE(huk_ops));
+
+	if (huk_ops[0])
+		return TEE_SUCCESS;
 
 	res = derive_unique_key(huk_key, sizeof(huk_key), NULL, 0);
 	if (res) {
 		EMSG("derive_unique_key failed: returned %#"PRIx32, res);
-		goto out_op;
+		return res;
 	}
 
 	res = TEE_AllocateTransientObject(TEE_TYPE_AES, sizeof(huk_key) * 8,
 					  &hkey);
 	if (res)
-		goto out_op;
+		goto out;
 
 	attr.attributeID = TEE_ATTR_SECRET_VALUE;
 	attr.content.ref.buffer = huk_key;
@@ -175,29 +196,48 @@ static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, size_t in_sz,
 
 	res = TEE_PopulateTransientObject(hkey, &attr, 1);
 	if (res)
-		goto out_key;
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(huk_ops); n++) {
+		res = TEE_AllocateOperation(huk_ops + n, TEE_ALG_AES_GCM,
+					    modes[n], sizeof(huk_key) * 8);
+		if (res)
+			goto out;
 
-	res = TEE_SetOperationKey(crypto_op, hkey);
+		res = TEE_SetOperationKey(huk_ops[n], hkey);
+		if (res)
+			goto out;
+	}
+
+out:
+	if (res)
+		free_huk_ops();
+	TEE_FreeTransientObject(hkey);
+	memzero_explicit(huk_key, sizeof(huk_key));
+	return res;
+}
+
+static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, size_t in_sz,
+			    uint8_t *out, size_t *out_sz)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = init_huk_ops();
 	if (res)
-		goto out_key;
+		return res;
 
 	if (mode == TEE_MODE_ENCRYPT) {
-		res = huk_ae_encrypt(crypto_op, in, in_sz, out, out_sz);
+		res = huk_ae_encrypt(huk_ops[0], in, in_sz, out, out_sz);
 		if (res)
 			EMSG("huk_AE_encrypt failed: returned %#"PRIx32, res);
 	} else if (mode == TEE_MODE_DECRYPT) {
-		res = huk_ae_decrypt(crypto_op, in, in_sz, out, out_sz);
+		res = huk_ae_decrypt(huk_ops[1], in, in_sz, out, out_sz);
 		if (res)
 			EMSG("huk_AE_decrypt failed: returned %#"PRIx32, res);
 	} else {
 		TEE_Panic(0);
 	}
 
-out_key:
-	TEE_FreeTransientObject(hkey);
-out_op:
-	TEE_FreeOperation(crypto_op);
-	memzero_explicit(huk_key, sizeof(huk_key));
 	return res;
 }
 
@@ -286,6 +326,97 @@ static TEE_Result unseal_trusted_key(uint32_t types,
 	return res;
 }
 
+/*
+ * Seals or unseals each of the length prefixed records of params[0] into
+ * params[1], see TA_CMD_SEAL_BATCH and TA_CMD_UNSEAL_BATCH.
+ */
+static TEE_Result crypt_batch(TEE_OperationMode mode, uint32_t types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *in = NULL;
+	size_t in_sz = 0;
+	uint8_t *out = NULL;
+	size_t out_sz = 0;
+	size_t need = 0;
+	size_t io = 0;
+	size_t oo = 0;
+	uint32_t rec_sz = 0;
+	size_t len = 0;
+
+	DMSG("Invoked TA_CMD_%sSEAL_BATCH",
+	     mode == TEE_MODE_ENCRYPT ? "" : "UN");
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				     TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	in = params[0].memref.buffer;
+	in_sz = params[0].memref.size;
+	out = params[1].memref.buffer;
+	out_sz = params[1].memref.size;
+
+	if (!in || !in_sz || (!out && out_sz))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Check all the records and compute the output size first */
+	for (io = 0; io < in_sz; io += sizeof(rec_sz) + rec_sz) {
+		if (in_sz - io < sizeof(rec_sz))
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(&rec_sz, in + io, sizeof(rec_sz));
+		if (!rec_sz || rec_sz > MAX_BUF_SIZE ||
+		    rec_sz > in_sz - io - sizeof(rec_sz))
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (mode == TEE_MODE_DECRYPT &&
+		    rec_sz <= sizeof(struct tk_blob_hdr))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		need += sizeof(rec_sz) + rec_sz;
+		if (mode == TEE_MODE_ENCRYPT)
+			need += sizeof(struct tk_blob_hdr);
+		else
+			need -= sizeof(struct tk_blob_hdr);
+	}
+
+	if (need > out_sz) {
+		params[1].memref.size = need;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	for (io = 0; io < in_sz; io += sizeof(rec_sz) + rec_sz) {
+		/* Lengths are read again, the buffer is shared with the REE */
+		memcpy(&rec_sz, in + io, sizeof(rec_sz));
+		if (!rec_sz || rec_sz > MAX_BUF_SIZE ||
+		    rec_sz > in_sz - io - sizeof(rec_sz) ||
+		    out_sz - oo < sizeof(rec_sz))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		len = out_sz - oo - sizeof(rec_sz);
+		if (mode == TEE_MODE_ENCRYPT &&
+		    rec_sz + sizeof(struct tk_blob_hdr) > len)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (mode == TEE_MODE_DECRYPT &&
+		    (rec_sz <= sizeof(struct tk_blob_hdr) ||
+		     rec_sz - sizeof(struct tk_blob_hdr) > len))
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		res = huk_crypt(mode, in + io + sizeof(rec_sz), rec_sz,
+				out + oo + sizeof(rec_sz), &len);
+		if (res)
+			return res;
+
+		rec_sz = len;
+		memcpy(out + oo, &rec_sz, sizeof(rec_sz));
+		oo += sizeof(rec_sz) + len;
+	}
+
+	params[1].memref.size = oo;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result TA_CreateEntryPoint(void)
 {
 	return TEE_SUCCESS;
@@ -293,6 +424,7 @@ TEE_Result TA_CreateEntryPoint(void)
 
 void TA_DestroyEntryPoint(void)
 {
+	free_huk_ops();
 }
 
 TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
@@ -337,6 +469,10 @@ TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
 		return seal_trusted_key(pt, params);
 	case TA_CMD_UNSEAL:
 		return unseal_trusted_key(pt, params);
+	case TA_CMD_SEAL_BATCH:
+		return crypt_batch(TEE_MODE_ENCRYPT, pt, params);
+	case TA_CMD_UNSEAL_BATCH:
+		return crypt_batch(TEE_MODE_DECRYPT, pt, params);
 	default:
 		EMSG("Command ID %#"PRIx32" is not supported", cmd);
 		return TEE_ERROR_NOT_SUPPORTED;
@@ -32,4 +32,26 @@
  */
 #define TA_CMD_UNSEAL		0x2
 
+/*
+ * Seal several trusted keys using hardware unique key
+ *
+ * [in]      memref[0]        Plain keys
+ * [out]     memref[1]        Sealed key datablobs
+ *
+ * Each key or datablob is a record made of its size as a native endian
+ * uint32_t followed by its content, records are packed back to back. The
+ * sealed datablobs are in the same order as the keys.
+ */
+#define TA_CMD_SEAL_BATCH	0x3
+
+/*
+ * Unseal several trusted keys using hardware unique key
+ *
+ * [in]      memref[0]        Sealed key datablobs
+ * [out]     memref[1]        Plain keys
+ *
+ * Same record format as TA_CMD_SEAL_BATCH.
+ */
+#define TA_CMD_UNSEAL_BATCH	0x4
+
 #endif /* TRUSTED_KEYS_H */